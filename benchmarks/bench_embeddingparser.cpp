@@ -0,0 +1,102 @@
+/**
+ * bench_embeddingparser.cpp - Embedding response parsing microbenchmarks
+ *
+ * Compares EmbeddingParser against the QJsonDocument/QJsonArray loop it
+ * replaced in RAGEngine, on single-vector and batched responses of the
+ * dimensions common embedding models produce.
+ */
+
+#include <QtTest/QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <random>
+#include "../include/EmbeddingParser.h"
+
+class EmbeddingParserBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    // Response body shaped like Ollama's: /api/embeddings for one vector, /api/embed for several
+    static QByteArray buildResponse(int vectors, int dimensions) {
+        std::mt19937 rng(42);
+        std::normal_distribution<double> dist(0.0, 0.05);
+
+        QJsonArray batch;
+        for (int v = 0; v < vectors; ++v) {
+            QJsonArray embedding;
+            for (int i = 0; i < dimensions; ++i) {
+                embedding.append(dist(rng));
+            }
+            batch.append(embedding);
+        }
+
+        QJsonObject response;
+        if (vectors == 1) {
+            response["embedding"] = batch.first();
+        } else {
+            response["model"] = "nomic-embed-text";
+            response["embeddings"] = batch;
+        }
+        return QJsonDocument(response).toJson(QJsonDocument::Compact);
+    }
+
+    static void addRows() {
+        QTest::addColumn<int>("vectors");
+        QTest::addColumn<int>("dimensions");
+
+        QTest::newRow("1x768") << 1 << 768;
+        QTest::newRow("1x4096") << 1 << 4096;
+        QTest::newRow("32x768") << 32 << 768;
+    }
+
+private slots:
+    void benchQtJson_data() {
+        addRows();
+    }
+
+    void benchQtJson() {
+        QFETCH(int, vectors);
+        QFETCH(int, dimensions);
+        const QByteArray response = buildResponse(vectors, dimensions);
+
+        QVector<QVector<float>> parsed;
+        QBENCHMARK {
+            parsed.clear();
+            QJsonObject obj = QJsonDocument::fromJson(response).object();
+            QJsonArray batch = vectors == 1 ? QJsonArray{obj["embedding"]} : obj["embeddings"].toArray();
+            for (const QJsonValue &entry : batch) {
+                QJsonArray embeddingArray = entry.toArray();
+                QVector<float> embedding;
+                embedding.reserve(embeddingArray.size());
+                for (const QJsonValue &val : embeddingArray) {
+                    embedding.append(val.toDouble());
+                }
+                parsed.append(embedding);
+            }
+        }
+        QCOMPARE(parsed.size(), vectors);
+        QCOMPARE(parsed.first().size(), dimensions);
+    }
+
+    void benchEmbeddingParser_data() {
+        addRows();
+    }
+
+    void benchEmbeddingParser() {
+        QFETCH(int, vectors);
+        QFETCH(int, dimensions);
+        const QByteArray response = buildResponse(vectors, dimensions);
+
+        QVector<QVector<float>> parsed;
+        QBENCHMARK {
+            parsed.clear();
+            EmbeddingParser::parse(response, parsed);
+        }
+        QCOMPARE(parsed.size(), vectors);
+        QCOMPARE(parsed.first().size(), dimensions);
+    }
+};
+
+QTEST_MAIN(EmbeddingParserBenchmark)
+#include "bench_embeddingparser.moc"
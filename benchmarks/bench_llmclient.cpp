@@ -0,0 +1,201 @@
+/**
+ * bench_llmclient.cpp - LLMClient streaming and context-window microbenchmarks
+ *
+ * Pushes Ollama NDJSON streams (/api/generate and /api/chat shapes) through
+ * the client's line splitting and chunk processing, and measures token
+ * estimation and history pruning on long conversations.
+ */
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "../include/LLMClient.h"
+#include "../include/Logger.h"
+
+class LLMClientBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    static QByteArray buildStream(int tokenCount, bool chat) {
+        static const char *words[] = {
+            "The", " quick", " brown", " fox", " jumps", " over", " the", " lazy",
+            " dog", ".", " Streaming", " tokens", " arrive", " one", " at", " a", " time", "\n"
+        };
+        const int wordCount = sizeof(words) / sizeof(words[0]);
+
+        QByteArray stream;
+        for (int i = 0; i < tokenCount; ++i) {
+            QJsonObject obj;
+            obj["model"] = "bench";
+            obj["created_at"] = "2024-01-01T00:00:00.000000Z";
+            if (chat) {
+                QJsonObject message;
+                message["role"] = "assistant";
+                message["content"] = QString::fromLatin1(words[i % wordCount]);
+                obj["message"] = message;
+            } else {
+                obj["response"] = QString::fromLatin1(words[i % wordCount]);
+            }
+            obj["done"] = false;
+            stream += QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n";
+        }
+
+        QJsonObject done;
+        done["model"] = "bench";
+        done["done"] = true;
+        done["total_duration"] = 1500000000.0;
+        done["prompt_eval_count"] = 42;
+        done["eval_count"] = tokenCount;
+        if (chat) {
+            QJsonObject message;
+            message["role"] = "assistant";
+            message["content"] = QString();
+            done["message"] = message;
+        } else {
+            done["response"] = QString();
+        }
+        stream += QJsonDocument(done).toJson(QJsonDocument::Compact) + "\n";
+        return stream;
+    }
+
+    // Same loop as LLMClient::handleStreamingData() over an already-received read
+    static void feed(LLMClient &client, const QByteArray &data) {
+        client.m_streamBuffer.append(QString::fromUtf8(data));
+        QStringList lines = client.m_streamBuffer.split('\n');
+        client.m_streamBuffer = lines.takeLast();
+
+        for (const QString &line : lines) {
+            if (!line.trimmed().isEmpty()) {
+                client.processStreamingChunk(line.trimmed());
+            }
+        }
+    }
+
+    static QJsonArray buildHistory(int messageCount) {
+        const QString userText = QString("Can you explain how the retrieval step picks chunks? ").repeated(4);
+        const QString assistantText = QString("Each chunk is embedded and compared against the query embedding; "
+                                              "the closest ones are added to the prompt as context. ").repeated(12);
+        QJsonArray history;
+        for (int i = 0; i < messageCount; ++i) {
+            QJsonObject msg;
+            msg["role"] = (i % 2 == 0) ? "user" : "assistant";
+            msg["content"] = (i % 2 == 0) ? userText : assistantText;
+            history.append(msg);
+        }
+        return history;
+    }
+
+    QTemporaryDir m_logDir;
+
+private slots:
+    void initTestCase() {
+        // Route debug output to a file and drop it, like a release session
+        Logger::instance().init(m_logDir.filePath("bench.log"), true);
+        Logger::instance().setLogLevel(Logger::Warning);
+    }
+
+    void benchStreamingChunks_data() {
+        QTest::addColumn<int>("tokenCount");
+        QTest::addColumn<bool>("chat");
+        QTest::addColumn<int>("readSize");
+
+        QTest::newRow("generate_1000_per_line") << 1000 << false << -1;
+        QTest::newRow("generate_1000_4k_reads") << 1000 << false << 4096;
+        QTest::newRow("chat_1000_per_line") << 1000 << true << -1;
+        QTest::newRow("chat_5000_16k_reads") << 5000 << true << 16384;
+    }
+
+    // readSize -1 delivers one NDJSON line per read, like a token-paced backend
+    void benchStreamingChunks() {
+        QFETCH(int, tokenCount);
+        QFETCH(bool, chat);
+        QFETCH(int, readSize);
+
+        const QByteArray stream = buildStream(tokenCount, chat);
+        QList<QByteArray> reads;
+        if (readSize < 0) {
+            for (const QByteArray &line : stream.split('\n')) {
+                if (!line.isEmpty()) {
+                    reads.append(line + "\n");
+                }
+            }
+        } else {
+            for (int pos = 0; pos < stream.size(); pos += readSize) {
+                reads.append(stream.mid(pos, readSize));
+            }
+        }
+
+        LLMClient client;
+        client.setModelCapabilities("prompt", QJsonObject());
+
+        int tokens = 0;
+        connect(&client, &LLMClient::tokenReceived, this, [&tokens](const QString &) { ++tokens; });
+
+        QBENCHMARK {
+            client.m_fullResponse.clear();
+            client.m_streamBuffer.clear();
+            tokens = 0;
+            for (const QByteArray &read : reads) {
+                feed(client, read);
+            }
+        }
+        QCOMPARE(tokens, tokenCount);
+    }
+
+    void benchEstimateTokens_data() {
+        QTest::addColumn<int>("chars");
+
+        QTest::newRow("1k") << 1000;
+        QTest::newRow("32k") << 32000;
+        QTest::newRow("256k") << 256000;
+    }
+
+    void benchEstimateTokens() {
+        QFETCH(int, chars);
+
+        const QString sentence("The retrieval step embeds the query and ranks chunks by distance.\n");
+        QString text = sentence.repeated(chars / sentence.size() + 1).left(chars);
+
+        LLMClient client;
+        client.setModelCapabilities("prompt", QJsonObject());
+
+        int estimate = 0;
+        QBENCHMARK {
+            estimate = client.estimateTokens(text);
+        }
+        QVERIFY(estimate > 0);
+    }
+
+    void benchPruneHistory_data() {
+        QTest::addColumn<int>("messageCount");
+        QTest::addColumn<int>("contextWindow");
+
+        QTest::newRow("20_msgs_8k") << 20 << 8192;
+        QTest::newRow("200_msgs_8k") << 200 << 8192;
+        QTest::newRow("200_msgs_128k") << 200 << 131072;
+        QTest::newRow("2000_msgs_128k") << 2000 << 131072;
+    }
+
+    void benchPruneHistory() {
+        QFETCH(int, messageCount);
+        QFETCH(int, contextWindow);
+
+        LLMClient client;
+        client.setModelCapabilities("prompt", QJsonObject());
+        client.setConversationHistory(buildHistory(messageCount));
+
+        const QString systemPrompt("You are a helpful assistant with access to tools and documents.");
+        const QString userMessage("Summarize what we discussed so far.");
+
+        QJsonArray pruned;
+        QBENCHMARK {
+            pruned = client.pruneMessageHistoryForContext(systemPrompt, userMessage, contextWindow);
+        }
+        QVERIFY(pruned.size() <= messageCount);
+    }
+};
+
+QTEST_MAIN(LLMClientBenchmark)
+#include "bench_llmclient.moc"
@@ -0,0 +1,83 @@
+/**
+ * bench_logger.cpp - Logger throughput microbenchmarks
+ *
+ * Measures the per-message cost of filtered debug messages (the common
+ * case in streaming code), messages written through the Qt message
+ * handler, and direct Logger calls. Console output goes to /dev/null so
+ * terminal speed does not skew the numbers; the log file is real.
+ */
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <fstream>
+#include <iostream>
+#include "../include/Logger.h"
+
+class LoggerBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_logDir;
+    std::ofstream m_devNull;
+    std::streambuf *m_coutBuf = nullptr;
+    std::streambuf *m_cerrBuf = nullptr;
+
+private slots:
+    void initTestCase() {
+        Logger::instance().init(m_logDir.filePath("bench.log"), true);
+
+        m_devNull.open("/dev/null");
+        m_coutBuf = std::cout.rdbuf(m_devNull.rdbuf());
+        m_cerrBuf = std::cerr.rdbuf(m_devNull.rdbuf());
+    }
+
+    void cleanupTestCase() {
+        std::cout.rdbuf(m_coutBuf);
+        std::cerr.rdbuf(m_cerrBuf);
+    }
+
+    void cleanup() {
+        Logger::instance().setLogLevel(Logger::Info);  // Logger's default
+    }
+
+    // LOG_DEBUG below the active level: formatting happens, writing does not
+    void benchFilteredDebug() {
+        Logger::instance().setLogLevel(Logger::Warning);
+
+        int i = 0;
+        QBENCHMARK {
+            LOG_DEBUG(QString("Token received: %1").arg(i++));
+        }
+    }
+
+    // LOG_INFO through Logger::messageHandler to console and file
+    void benchMessageHandlerInfo() {
+        Logger::instance().setLogLevel(Logger::Info);
+
+        int i = 0;
+        QBENCHMARK {
+            LOG_INFO(QString("Streaming complete. Total response length: %1 chars").arg(i++));
+        }
+    }
+
+    void benchDirectInfo_data() {
+        QTest::addColumn<int>("messageLength");
+
+        QTest::newRow("short") << 40;
+        QTest::newRow("long") << 2000;
+    }
+
+    // Logger::info() without the Qt message machinery
+    void benchDirectInfo() {
+        QFETCH(int, messageLength);
+        Logger::instance().setLogLevel(Logger::Info);
+
+        const QString message = QString("x").repeated(messageLength);
+        QBENCHMARK {
+            Logger::instance().info(message);
+        }
+    }
+};
+
+QTEST_MAIN(LoggerBenchmark)
+#include "bench_logger.moc"
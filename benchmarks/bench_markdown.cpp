@@ -0,0 +1,130 @@
+/**
+ * bench_markdown.cpp - MarkdownHandler::toHtml microbenchmarks
+ *
+ * Converts answers shaped like real model output (prose, code-heavy,
+ * tables and lists, long multi-section) so regressions in the regex
+ * passes show up before they reach the chat view.
+ */
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include "../include/MarkdownHandler.h"
+#include "../include/Logger.h"
+
+class MarkdownBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    static QString proseAnswer() {
+        return QStringLiteral(
+            "Sure! Here's a quick overview of **retrieval-augmented generation**.\n\n"
+            "RAG combines a *retriever* with a generator. The retriever finds relevant "
+            "passages from your documents, and the model uses them as context when "
+            "answering. This keeps answers grounded and lets you update knowledge "
+            "without retraining.\n\n"
+            "> Tip: keep chunks small enough that several fit in the context window.\n\n"
+            "See [the Ollama docs](https://ollama.com) for embedding models.\n");
+    }
+
+    static QString codeAnswer() {
+        return QStringLiteral(
+            "You can read a file line by line like this:\n\n"
+            "```cpp\n"
+            "#include <QFile>\n"
+            "#include <QTextStream>\n\n"
+            "void readLines(const QString &path) {\n"
+            "    QFile file(path);\n"
+            "    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {\n"
+            "        return;\n"
+            "    }\n"
+            "    QTextStream in(&file);\n"
+            "    while (!in.atEnd()) {\n"
+            "        QString line = in.readLine();\n"
+            "        process(line);  // <- your code here\n"
+            "    }\n"
+            "}\n"
+            "```\n\n"
+            "Call `readLines()` with an absolute path. For large files prefer "
+            "`QFile::map()` or a `QByteArray` buffer:\n\n"
+            "```python\n"
+            "with open(path) as f:\n"
+            "    for line in f:\n"
+            "        process(line)\n"
+            "```\n");
+    }
+
+    static QString structuredAnswer() {
+        return QStringLiteral(
+            "## Comparison\n\n"
+            "| Model | Context | Tools | Speed |\n"
+            "| :--- | :---: | :---: | ---: |\n"
+            "| llama3.2 | 128k | yes | fast |\n"
+            "| mistral | 32k | yes | fast |\n"
+            "| qwen2.5 | 128k | yes | medium |\n"
+            "| phi3 | 4k | no | very fast |\n\n"
+            "### Steps\n\n"
+            "1. Pull the model with `ollama pull`\n"
+            "2. Set it in **Settings**\n"
+            "3. Enable *tool calling* if supported\n\n"
+            "- Native tools use `/api/chat`\n"
+            "- Prompt-based tools use `/api/generate`\n"
+            "- ~~Legacy~~ formats are not supported\n\n"
+            "---\n\n"
+            "Done.\n");
+    }
+
+    static QString longAnswer() {
+        QString text;
+        for (int i = 0; i < 10; ++i) {
+            text += QString("# Section %1\n\n").arg(i + 1);
+            text += proseAnswer();
+            text += "\n";
+            text += codeAnswer();
+            text += "\n";
+            text += structuredAnswer();
+            text += "\n";
+        }
+        return text;
+    }
+
+    QTemporaryDir m_logDir;
+
+private slots:
+    void initTestCase() {
+        // Route debug output to a file and drop it, like a release session
+        Logger::instance().init(m_logDir.filePath("bench.log"), true);
+        Logger::instance().setLogLevel(Logger::Warning);
+    }
+
+    void benchToHtml_data() {
+        QTest::addColumn<QString>("markdown");
+
+        QTest::newRow("prose") << proseAnswer();
+        QTest::newRow("code") << codeAnswer();
+        QTest::newRow("tables_lists") << structuredAnswer();
+        QTest::newRow("long") << longAnswer();
+    }
+
+    void benchToHtml() {
+        QFETCH(QString, markdown);
+
+        QString html;
+        QBENCHMARK {
+            html = MarkdownHandler::toHtml(markdown);
+        }
+        QVERIFY(!html.isEmpty());
+    }
+
+    void benchConvertTables() {
+        const QString text = structuredAnswer();
+
+        QString html;
+        QBENCHMARK {
+            html = MarkdownHandler::convertTables(text);
+        }
+        QVERIFY(html.contains("<table"));
+    }
+};
+
+QTEST_MAIN(MarkdownBenchmark)
+#include "bench_markdown.moc"
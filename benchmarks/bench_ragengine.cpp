@@ -0,0 +1,191 @@
+/**
+ * bench_ragengine.cpp - RAGEngine chunking and similarity search microbenchmarks
+ *
+ * Measures chunkText() on document-sized inputs, by characters and by
+ * tokens, and searchSimilar() over synthetic embedding corpora of
+ * increasing size, at full width and with the index reducing vectors by
+ * truncation or PCA. reportReductionRecall() prints how many of the
+ * exact top 10 each reduction keeps.
+ */
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include "../include/RAGEngine.h"
+#include "../include/VectorIndex.h"
+#include "../include/Logger.h"
+
+class RAGEngineBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    static QString buildDocument(int chars) {
+        const QString paragraph(
+            "Retrieval-augmented generation grounds answers in your own documents. "
+            "Each file is split into overlapping chunks! Chunks are embedded with the "
+            "configured model and stored in a vector index. At query time the question "
+            "is embedded too, and the nearest chunks are added to the prompt? Keeping "
+            "chunks on sentence boundaries makes the retrieved context easier to read.\n\n");
+        return paragraph.repeated(chars / paragraph.size() + 1).left(chars);
+    }
+
+    // Variance falls off with the dimension, roughly like a Matryoshka-trained model's output
+    static QVector<float> randomVector(std::mt19937 &rng, int dimensions) {
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        QVector<float> v(dimensions);
+        for (int i = 0; i < dimensions; ++i) {
+            v[i] = dist(rng) / std::sqrt(1.0f + i / 16.0f);
+        }
+        return v;
+    }
+
+    // A corpus vector with noise added: a question close to one passage
+    static QVector<float> nearbyQuery(std::mt19937 &rng, const QVector<float> &target) {
+        std::normal_distribution<float> dist(0.0f, 0.125f);
+        QVector<float> query = target;
+        for (int i = 0; i < query.size(); ++i) {
+            query[i] += dist(rng) / std::sqrt(1.0f + i / 16.0f);
+        }
+        return query;
+    }
+
+    QTemporaryDir m_logDir;
+
+private slots:
+    void initTestCase() {
+        // Route debug output to a file and drop it, like a release session
+        Logger::instance().init(m_logDir.filePath("bench.log"), true);
+        Logger::instance().setLogLevel(Logger::Warning);
+    }
+
+    void benchChunkText_data() {
+        QTest::addColumn<int>("chars");
+        QTest::addColumn<int>("chunkSize");
+        QTest::addColumn<int>("chunkTokens");
+
+        QTest::newRow("10k_512") << 10000 << 512 << 0;
+        QTest::newRow("100k_512") << 100000 << 512 << 0;
+        QTest::newRow("1m_512") << 1000000 << 512 << 0;
+        QTest::newRow("100k_2048") << 100000 << 2048 << 0;
+        QTest::newRow("100k_128tok") << 100000 << 512 << 128;
+        QTest::newRow("1m_128tok") << 1000000 << 512 << 128;
+    }
+
+    void benchChunkText() {
+        QFETCH(int, chars);
+        QFETCH(int, chunkSize);
+        QFETCH(int, chunkTokens);
+
+        const QString document = buildDocument(chars);
+
+        RAGEngine engine;
+        engine.setChunkSize(chunkSize);
+        engine.setChunkTokens(chunkTokens);
+
+        QStringList chunks;
+        QBENCHMARK {
+            engine.m_chunks.clear();
+            chunks = engine.chunkText(document, "bench.txt");
+        }
+        QVERIFY(!chunks.isEmpty());
+    }
+
+    void benchSearchSimilar_data() {
+        QTest::addColumn<int>("corpusSize");
+        QTest::addColumn<int>("dimensions");
+        QTest::addColumn<QString>("reduction");
+        QTest::addColumn<int>("stored");
+
+        QTest::newRow("1k_768") << 1000 << 768 << "none" << 0;
+        QTest::newRow("10k_768") << 10000 << 768 << "none" << 0;
+        QTest::newRow("50k_768") << 50000 << 768 << "none" << 0;
+        QTest::newRow("10k_384") << 10000 << 384 << "none" << 0;
+        QTest::newRow("10k_768_truncate256") << 10000 << 768 << "truncate" << 256;
+        QTest::newRow("10k_768_truncate128") << 10000 << 768 << "truncate" << 128;
+        QTest::newRow("10k_768_pca256") << 10000 << 768 << "pca" << 256;
+        QTest::newRow("50k_768_truncate256") << 50000 << 768 << "truncate" << 256;
+    }
+
+    void benchSearchSimilar() {
+        QFETCH(int, corpusSize);
+        QFETCH(int, dimensions);
+        QFETCH(QString, reduction);
+        QFETCH(int, stored);
+
+        std::mt19937 rng(42);
+
+        RAGEngine engine;
+        engine.m_index.configure(VectorIndex::reductionFromString(reduction), stored);
+        engine.m_chunks.resize(corpusSize);
+        for (int i = 0; i < corpusSize; ++i) {
+            engine.m_chunks[i].chunkIndex = i;
+            engine.addEmbeddingToIndex(randomVector(rng, dimensions), i);
+        }
+        QCOMPARE(engine.m_index.dimensions(), stored > 0 ? stored : dimensions);
+
+        const QVector<float> query = randomVector(rng, dimensions);
+
+        QVector<int> results;
+        QBENCHMARK {
+            results = engine.searchSimilar(query, 5);
+        }
+        QCOMPARE(results.size(), 5);
+    }
+
+    // Not timed: recall@10 against full-width search, printed once per run
+    void reportReductionRecall() {
+        const int corpusSize = 5000;
+        const int dimensions = 768;
+        const int queries = 200;
+        const int topK = 10;
+
+        std::mt19937 rng(7);
+        QVector<QVector<float>> corpus;
+        VectorIndex full;
+        for (int i = 0; i < corpusSize; ++i) {
+            corpus.append(randomVector(rng, dimensions));
+            full.add(corpus.last());
+        }
+
+        QVector<QVector<float>> questions;
+        QVector<QVector<int>> exact;
+        for (int q = 0; q < queries; ++q) {
+            questions.append(nearbyQuery(rng, corpus[static_cast<int>(rng() % corpusSize)]));
+            exact.append(full.search(questions.last(), topK));
+        }
+
+        std::printf("\nRecall@%d of reduced indexes (%d x %d synthetic corpus, %d queries)\n",
+                    topK, corpusSize, dimensions, queries);
+        std::printf("  %-10s %6s %10s %8s\n", "reduction", "dims", "memory", "recall");
+        std::printf("  %-10s %6d %8.1fMB %8.3f\n", "none", dimensions, full.memoryBytes() / 1048576.0, 1.0);
+
+        const QList<QPair<VectorIndex::Reduction, int>> configurations = {
+            {VectorIndex::Truncate, 512}, {VectorIndex::Truncate, 256}, {VectorIndex::Truncate, 128},
+            {VectorIndex::PCA, 512}, {VectorIndex::PCA, 256}, {VectorIndex::PCA, 128}};
+        for (const auto &configuration : configurations) {
+            VectorIndex reduced;
+            reduced.configure(configuration.first, configuration.second);
+            for (const QVector<float> &vector : corpus) {
+                reduced.add(vector);
+            }
+
+            int hits = 0;
+            for (int q = 0; q < queries; ++q) {
+                for (int position : reduced.search(questions[q], topK)) {
+                    hits += exact[q].contains(position) ? 1 : 0;
+                }
+            }
+            double recall = static_cast<double>(hits) / (queries * topK);
+            std::printf("  %-10s %6d %8.1fMB %8.3f\n",
+                        qPrintable(VectorIndex::reductionName(configuration.first)),
+                        reduced.dimensions(), reduced.memoryBytes() / 1048576.0, recall);
+            QVERIFY(recall > 0.3);
+        }
+        std::fflush(stdout);
+    }
+};
+
+QTEST_MAIN(RAGEngineBenchmark)
+#include "bench_ragengine.moc"
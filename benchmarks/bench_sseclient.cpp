@@ -0,0 +1,118 @@
+/**
+ * bench_sseclient.cpp - SSE stream parsing microbenchmarks
+ *
+ * Feeds large synthetic MCP-style event streams through SSEClient's
+ * event splitting and field parser without a network connection.
+ */
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include "../include/SSEClient.h"
+#include "../include/Logger.h"
+
+class SSEClientBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    // One JSON-RPC notification per event, like an MCP server pushing results
+    static QByteArray buildStream(int eventCount) {
+        QByteArray stream;
+        for (int i = 0; i < eventCount; ++i) {
+            stream += "event: message\n";
+            stream += "id: " + QByteArray::number(i) + "\n";
+            stream += "data: {\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\","
+                      "\"params\":{\"progressToken\":\"tok-" + QByteArray::number(i) + "\","
+                      "\"progress\":" + QByteArray::number(i) + ",\"total\":" +
+                      QByteArray::number(eventCount) + "}}\n";
+            stream += "\n";
+        }
+        return stream;
+    }
+
+    // Same loop as SSEClient::handleReadyRead() over an already-received buffer
+    static void feed(SSEClient &client, const QByteArray &data) {
+        client.m_buffer.append(data);
+        while (client.m_buffer.contains("\n\n")) {
+            int eventEnd = client.m_buffer.indexOf("\n\n");
+            QByteArray eventData = client.m_buffer.left(eventEnd);
+            client.m_buffer = client.m_buffer.mid(eventEnd + 2);
+
+            client.parseSSEData(eventData);
+        }
+    }
+
+    QTemporaryDir m_logDir;
+
+private slots:
+    void initTestCase() {
+        // Route debug output to a file and drop it, like a release session
+        Logger::instance().init(m_logDir.filePath("bench.log"), true);
+        Logger::instance().setLogLevel(Logger::Warning);
+    }
+
+    void benchParseEvents_data() {
+        QTest::addColumn<int>("eventCount");
+
+        QTest::newRow("100") << 100;
+        QTest::newRow("1000") << 1000;
+        QTest::newRow("10000") << 10000;
+    }
+
+    // Parser only: one call per complete event
+    void benchParseEvents() {
+        QFETCH(int, eventCount);
+
+        const QByteArray stream = buildStream(eventCount);
+
+        QList<QByteArray> blocks;
+        int pos = 0;
+        while (true) {
+            int end = stream.indexOf("\n\n", pos);
+            if (end < 0) {
+                break;
+            }
+            blocks.append(stream.mid(pos, end - pos));
+            pos = end + 2;
+        }
+        QCOMPARE(blocks.size(), eventCount);
+
+        SSEClient client;
+        QBENCHMARK {
+            for (const QByteArray &block : blocks) {
+                client.parseSSEData(block);
+            }
+        }
+    }
+
+    void benchLargeStream_data() {
+        QTest::addColumn<int>("eventCount");
+        QTest::addColumn<int>("readSize");
+
+        QTest::newRow("1000_events_whole") << 1000 << 0;
+        QTest::newRow("1000_events_4k_reads") << 1000 << 4096;
+        QTest::newRow("10000_events_16k_reads") << 10000 << 16384;
+    }
+
+    // Buffering plus parsing, with the stream arriving in readyRead-sized pieces
+    void benchLargeStream() {
+        QFETCH(int, eventCount);
+        QFETCH(int, readSize);
+
+        const QByteArray stream = buildStream(eventCount);
+
+        SSEClient client;
+        QBENCHMARK {
+            if (readSize <= 0) {
+                feed(client, stream);
+            } else {
+                for (int pos = 0; pos < stream.size(); pos += readSize) {
+                    feed(client, stream.mid(pos, readSize));
+                }
+            }
+        }
+        QVERIFY(client.m_buffer.isEmpty());
+    }
+};
+
+QTEST_MAIN(SSEClientBenchmark)
+#include "bench_sseclient.moc"
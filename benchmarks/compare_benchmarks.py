@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""
+compare_benchmarks.py - Compare benchmark results against a stored baseline
+
+Reads two JSON files written by run_benchmarks.py and prints the change of
+every benchmark present in both. All QtTest metrics are lower-is-better;
+a benchmark regresses when it is slower than the baseline by more than
+--threshold percent.
+
+Usage:
+    compare_benchmarks.py BASELINE.json RESULTS.json [--threshold 10] [--json diff.json]
+
+Exit status: 0 no regressions, 1 regressions found, 2 unreadable input.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    try:
+        with open(path) as f:
+            report = json.load(f)
+    except FileNotFoundError:
+        print("error: %s does not exist" % path, file=sys.stderr)
+        print("Create a baseline with: cmake --build <build-dir> --target benchmarks-baseline", file=sys.stderr)
+        sys.exit(2)
+    except ValueError as e:
+        print("error: %s is not valid JSON: %s" % (path, e), file=sys.stderr)
+        sys.exit(2)
+
+    if report.get("schema") != 1:
+        print("error: %s has unsupported schema %r" % (path, report.get("schema")), file=sys.stderr)
+        sys.exit(2)
+
+    return report, {(r["id"], r["metric"]): r for r in report.get("results", [])}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare benchmark results against a baseline")
+    parser.add_argument("baseline", help="Stored baseline JSON")
+    parser.add_argument("results", help="Current results JSON")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="Allowed slowdown in percent before a result counts as a regression (default: 10)")
+    parser.add_argument("--json", dest="json_out", help="Also write the comparison as JSON to this file")
+    args = parser.parse_args()
+
+    baseline_report, baseline = load(args.baseline)
+    current_report, current = load(args.results)
+
+    for key in ("build_type", "qt_version", "host"):
+        if baseline_report.get(key) != current_report.get(key):
+            print("note: %s differs (baseline %r, current %r)"
+                  % (key, baseline_report.get(key), current_report.get(key)))
+
+    rows = []
+    regressions = 0
+    improvements = 0
+    for key in sorted(set(baseline) & set(current)):
+        old = baseline[key]["value"]
+        new = current[key]["value"]
+        change = ((new - old) / old * 100.0) if old > 0 else 0.0
+
+        status = "ok"
+        if change > args.threshold:
+            status = "REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            status = "improved"
+            improvements += 1
+
+        rows.append({"id": key[0], "metric": key[1], "baseline": old, "current": new,
+                     "change_percent": round(change, 2), "status": status})
+
+    missing = sorted(k[0] for k in set(baseline) - set(current))
+    added = sorted(k[0] for k in set(current) - set(baseline))
+
+    width = max([len(r["id"]) for r in rows] + [9])
+    print("%-*s  %14s  %14s  %8s  %s" % (width, "benchmark", "baseline", "current", "change", ""))
+    for r in rows:
+        print("%-*s  %14.6g  %14.6g  %+7.1f%%  %s"
+              % (width, r["id"], r["baseline"], r["current"], r["change_percent"],
+                 "" if r["status"] == "ok" else r["status"]))
+
+    for ident in missing:
+        print("missing from results: %s" % ident)
+    for ident in added:
+        print("not in baseline: %s" % ident)
+
+    print("\n%d compared, %d regressed, %d improved (threshold %.1f%%)"
+          % (len(rows), regressions, improvements, args.threshold))
+
+    if args.json_out:
+        with open(args.json_out, "w") as f:
+            json.dump({"threshold_percent": args.threshold, "comparisons": rows,
+                       "missing": missing, "added": added}, f, indent=2)
+            f.write("\n")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+run_benchmarks.py - Run the QBENCHMARK executables and collect JSON results
+
+Each executable is run with QtTest's XML logger; the per-iteration
+BenchmarkResult entries are merged into one machine-readable JSON file:
+
+    {
+      "schema": 1,
+      "generated": "2024-01-01T12:00:00Z",
+      "build_type": "Release",
+      "qt_version": "5.15.2",
+      "host": {"system": "Linux", "machine": "x86_64", "cpu_count": 8},
+      "results": [
+        {"id": "MarkdownBenchmark::benchToHtml/prose",
+         "suite": "MarkdownBenchmark", "function": "benchToHtml", "tag": "prose",
+         "metric": "WalltimeMilliseconds", "value": 0.0123, "iterations": 4096}
+      ],
+      "skipped": ["RAGEngineBenchmark::benchSearchSimilar"],
+      "failures": []
+    }
+
+Usage:
+    run_benchmarks.py --output results.json [--median N] EXECUTABLE...
+"""
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ET
+
+
+def parse_qtest_xml(path):
+    """Return (suite, qt_version, results, skipped, failures) from a QtTest XML log."""
+    tree = ET.parse(path)
+    root = tree.getroot()
+    suite = root.get("name", os.path.basename(path))
+    qt_version = root.findtext("Environment/QtVersion", default="")
+
+    results = []
+    skipped = []
+    failures = []
+
+    for function in root.iter("TestFunction"):
+        name = function.get("name", "")
+
+        for result in function.iter("BenchmarkResult"):
+            tag = result.get("tag", "")
+            ident = "%s::%s" % (suite, name)
+            if tag:
+                ident += "/" + tag
+            results.append({
+                "id": ident,
+                "suite": suite,
+                "function": name,
+                "tag": tag,
+                "metric": result.get("metric", ""),
+                # Qt writes the per-iteration value
+                "value": float(result.get("value", "0")),
+                "iterations": int(result.get("iterations", "0")),
+            })
+
+        for incident in function.iter("Incident"):
+            kind = incident.get("type", "")
+            ident = "%s::%s" % (suite, name)
+            tag = incident.findtext("DataTag")
+            if tag:
+                ident += "/" + tag.strip()
+            if kind in ("fail", "xpass"):
+                description = (incident.findtext("Description") or "").strip()
+                failures.append({"id": ident, "message": description})
+
+        # QSKIP is logged as a message, not an incident
+        for message in function.iter("Message"):
+            if message.get("type") == "skip":
+                ident = "%s::%s" % (suite, name)
+                tag = message.findtext("DataTag")
+                if tag:
+                    ident += "/" + tag.strip()
+                skipped.append(ident)
+
+    return suite, qt_version, results, skipped, failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run QBENCHMARK executables and write JSON results")
+    parser.add_argument("executables", nargs="+", help="Benchmark executables to run")
+    parser.add_argument("--output", required=True, help="JSON file to write")
+    parser.add_argument("--build-type", default="", help="CMAKE_BUILD_TYPE, recorded in the results")
+    parser.add_argument("--median", type=int, default=5,
+                        help="Runs per benchmark; QtTest reports the median (default: 5)")
+    args = parser.parse_args()
+
+    report = {
+        "schema": 1,
+        "generated": datetime.datetime.utcnow().replace(microsecond=0).isoformat() + "Z",
+        "build_type": args.build_type,
+        "qt_version": "",
+        "host": {
+            "system": platform.system(),
+            "machine": platform.machine(),
+            "cpu_count": os.cpu_count(),
+        },
+        "results": [],
+        "skipped": [],
+        "failures": [],
+    }
+
+    if args.build_type and args.build_type.lower() not in ("release", "relwithdebinfo"):
+        print("warning: benchmarking a %s build; numbers will not be representative" % args.build_type,
+              file=sys.stderr)
+
+    exit_code = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for executable in args.executables:
+            name = os.path.basename(executable)
+            xml_path = os.path.join(tmp, name + ".xml")
+            print("Running %s" % name, flush=True)
+
+            completed = subprocess.run([executable, "-median", str(args.median), "-o", xml_path + ",xml"])
+
+            if not os.path.exists(xml_path):
+                report["failures"].append({"id": name, "message": "no output (exit code %d)" % completed.returncode})
+                exit_code = 1
+                continue
+
+            try:
+                suite, qt_version, results, skipped, failures = parse_qtest_xml(xml_path)
+            except ET.ParseError as e:
+                report["failures"].append({"id": name, "message": "unreadable XML log: %s" % e})
+                exit_code = 1
+                continue
+
+            report["qt_version"] = report["qt_version"] or qt_version
+            report["results"].extend(results)
+            report["skipped"].extend(skipped)
+            report["failures"].extend(failures)
+
+            if completed.returncode != 0:
+                exit_code = 1
+
+    report["results"].sort(key=lambda r: r["id"])
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2)
+        f.write("\n")
+
+    print("Wrote %d results to %s (%d skipped, %d failed)"
+          % (len(report["results"]), args.output, len(report["skipped"]), len(report["failures"])))
+    for failure in report["failures"]:
+        print("FAILED %s: %s" % (failure["id"], failure["message"]), file=sys.stderr)
+
+    return exit_code
+
+
+if __name__ == "__main__":
+    sys.exit(main())
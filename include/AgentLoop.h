@@ -0,0 +1,216 @@
+/**
+ * AgentLoop.h - Multi-step tool-calling agent with a DAG step scheduler
+ *
+ * Drives an LLMClient through repeated tool rounds until the model answers
+ * or a budget runs out. Tool calls become steps in a dependency graph:
+ * steps whose dependencies are met run concurrently, starting as soon as
+ * the model requests them, while the rest of its turn is still streaming.
+ * Every model turn and step is recorded on a timeline for reporting.
+ */
+
+#ifndef AGENTLOOP_H
+#define AGENTLOOP_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QThreadPool>
+
+class LLMClient;
+class MCPHandler;
+class QTimer;
+
+/**
+ * @brief One tool invocation in the step graph
+ *
+ * String arguments may reference an earlier step's result as {{step:N}};
+ * such references are dependencies in addition to dependsOn. A value that
+ * is exactly a reference is replaced by the result (its "result" field
+ * when present), otherwise the reference is replaced by its text.
+ */
+struct AgentStep {
+    enum State {
+        Pending,
+        Running,
+        Succeeded,
+        Failed,
+        Skipped     // A dependency failed
+    };
+
+    int id;                 // 1-based, in the order steps were added
+    int iteration;          // Model turn that requested it (0 = added by the caller)
+    QString toolName;
+    QJsonObject arguments;
+    QList<int> dependsOn;
+    State state;
+    QJsonObject result;
+    QString error;
+    qint64 startMs;         // Offsets from the start of the task (-1 = not reached)
+    qint64 endMs;
+
+    AgentStep() : id(0), iteration(0), state(Pending), startMs(-1), endMs(-1) {}
+};
+
+/**
+ * @brief A model turn or a step on the task timeline
+ */
+struct AgentSpan {
+    QString kind;           // "model" or "tool"
+    QString name;           // Configured model or tool name
+    int iteration;
+    int stepId;             // -1 for model turns
+    qint64 startMs;
+    qint64 endMs;           // -1 while running
+
+    AgentSpan() : iteration(0), stepId(-1), startMs(0), endMs(-1) {}
+};
+
+/**
+ * @brief Per-task limits; 0 means unlimited
+ */
+struct AgentBudget {
+    int maxIterations;      // Model turns
+    int maxTokens;          // Prompt + completion tokens across all turns
+    int maxTimeMs;          // Wall time for the whole task
+    int maxParallelTools;   // Steps running at once
+
+    AgentBudget() : maxIterations(10), maxTokens(0), maxTimeMs(0), maxParallelTools(4) {}
+};
+
+/**
+ * @brief Runs one agent task at a time
+ *
+ * The client may live on another thread (see EngineThread): it is only
+ * called through queued invocations. The MCPHandler must live on this
+ * object's thread. Local tools run on the loop's own thread pool;
+ * networked tools go through MCPHandler and overlap on the network.
+ * Without a client, the loop runs only the steps added with addStep().
+ */
+class AgentLoop : public QObject {
+    Q_OBJECT
+
+public:
+    enum StopReason {
+        NotStopped,
+        Answered,           // The model replied without calling a tool
+        PlanCompleted,      // No client: every added step has finished
+        MaxIterations,
+        TokenBudget,
+        TimeBudget,
+        Error,
+        Cancelled
+    };
+
+    AgentLoop(LLMClient *client, MCPHandler *tools, QObject *parent = nullptr);
+    ~AgentLoop() override;
+
+    void setBudget(const AgentBudget &budget);
+    AgentBudget budget() const { return m_budget; }
+
+    /**
+     * @brief Start a task; false if one is already running
+     *
+     * Steps added before start() form a plan that runs before the first
+     * model turn; their results are sent along with the task.
+     */
+    bool start(const QString &task, const QJsonArray &tools = QJsonArray());
+
+    /**
+     * @brief Add a step; returns its ID, or -1 if a dependency doesn't exist
+     *
+     * Steps added while a task runs are scheduled immediately.
+     */
+    int addStep(const QString &toolName, const QJsonObject &arguments, const QList<int> &dependsOn = QList<int>());
+
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+    // Results of the current or last task
+    StopReason stopReason() const { return m_stopReason; }
+    QString answer() const { return m_answer; }
+    QString errorString() const { return m_error; }
+    QList<AgentStep> steps() const { return m_steps; }
+    QList<AgentSpan> timeline() const { return m_timeline; }
+    int iterations() const { return m_iteration; }
+    int tokensUsed() const { return m_tokensUsed; }
+    qint64 elapsedMs() const;
+
+    // Timeline as an aligned text table (CLI) or JSON (logs, tests)
+    QString formatTimeline() const;
+    QJsonArray timelineJson() const;
+
+    static QString stopReasonName(StopReason reason);
+
+    // Step IDs referenced as {{step:N}} in string arguments
+    static QList<int> referencedSteps(const QJsonObject &arguments);
+
+signals:
+    void iterationStarted(int iteration);
+    void stepStarted(int stepId, const QString &toolName);
+    void stepFinished(int stepId, const QString &toolName, bool ok, const QJsonObject &result, const QString &error);
+    void tokenReceived(const QString &token);
+    void finished(const QString &answer);
+
+private:
+    // LLMClient signals
+    void onToolCallRequested(const QString &toolName, const QJsonObject &arguments);
+    void onToolTurnFinished();
+    void onResponse(const QString &response);
+    void onClientError(const QString &error);
+    void onGenerationStats(int promptTokens, int completionTokens);
+
+    // MCPHandler signals (networked tools)
+    void onToolCompleted(const QString &callId, const QJsonObject &result);
+    void onToolFailed(const QString &callId, const QString &error);
+
+    void schedule();
+    void runStep(AgentStep &step);
+    void completeStep(int stepId, bool ok, const QJsonObject &result, const QString &error);
+    void continueTask();
+    void startModelTurn(const QString &prompt);
+    void endModelTurn();
+    void finish(StopReason reason, const QString &error = QString());
+    void resetResults();
+
+    QString resultsPrompt() const;
+    QJsonObject resolveArguments(const AgentStep &step) const;
+    AgentStep *findStep(int stepId);
+    bool hasOutstandingSteps() const;
+
+    LLMClient *m_client;
+    MCPHandler *m_tools;
+    QThreadPool m_pool;
+    QTimer *m_deadline;
+    AgentBudget m_budget;
+
+    // Current task
+    bool m_running;
+    quint64 m_generation;       // Tags async work so results of an old task are dropped
+    QString m_task;
+    QString m_modelName;
+    QJsonArray m_toolDefinitions;
+    QList<AgentStep> m_steps;
+    QList<AgentSpan> m_timeline;
+    QList<int> m_unreported;    // Finished steps the model hasn't seen yet
+    QHash<QString, int> m_callSteps;  // MCPHandler call ID -> step ID
+    int m_dispatchingStep;      // Step inside executeToolCall(), for synchronous completions
+    int m_runningSteps;
+    bool m_scheduling;
+    bool m_modelTurnActive;
+    int m_modelSpan;            // Index into m_timeline, -1 between turns
+    int m_iteration;
+    int m_tokensUsed;
+    int m_turnTokens;           // Tokens reported for the current turn (-1 = none yet)
+    QString m_turnText;
+    QElapsedTimer m_clock;
+    qint64 m_finishedMs;
+    StopReason m_stopReason;
+    QString m_answer;
+    QString m_error;
+};
+
+#endif // AGENTLOOP_H
@@ -0,0 +1,148 @@
+/**
+ * BatchRunner.h - JSONL batch mode for the CLI
+ *
+ * Streams prompts from a JSONL file (or stdin), runs them with bounded
+ * concurrency through short-lived LLMClients that share one capability
+ * detection, tool registry and RAG index, and appends one result record per
+ * prompt as soon as it completes.
+ */
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QSet>
+#include <QHash>
+#include <QPointer>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+class QFile;
+class QTimer;
+class QSocketNotifier;
+class LLMClient;
+class MCPHandler;
+class RAGEngine;
+
+/**
+ * @brief Batch runner options (from the command line)
+ */
+struct BatchOptions {
+    QString inputPath;       // JSONL file, or "-" for stdin
+    QString outputPath;      // JSONL results file
+    int concurrency;         // Max prompts in flight
+    int timeoutMs;           // Per-prompt timeout
+    bool useTools;           // Enable tool calling
+    bool resume;             // Append to output and skip ids already present
+    QString contextPath;     // Optional file/directory to ingest into RAG
+
+    BatchOptions()
+        : concurrency(4)
+        , timeoutMs(120000)
+        , useTools(false)
+        , resume(false) {}
+};
+
+/**
+ * @brief Runs a JSONL batch and writes one record per prompt
+ *
+ * Input lines are JSON objects with a "prompt" field and an optional "id"
+ * (defaults to the 1-based line number); a line that isn't JSON is used as
+ * the prompt itself. Output records contain:
+ * id, index, prompt, response, error, ttft_ms, latency_ms,
+ * prompt_tokens, completion_tokens, tokens_estimated.
+ */
+class BatchRunner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BatchRunner(const BatchOptions &options, QObject *parent = nullptr);
+    ~BatchRunner() override;
+
+    /**
+     * @brief Open files and start processing (returns immediately)
+     * @return false if the input or output can't be opened
+     */
+    bool start();
+
+    int completedCount() const { return m_completed; }
+    int failedCount() const { return m_failed; }
+    int skippedCount() const { return m_skipped; }
+
+signals:
+    // Emitted once every prompt has been written (or on a fatal error)
+    void finished(bool success);
+
+private:
+    struct BatchItem {
+        QString id;
+        int index;
+        QString prompt;
+        QPointer<LLMClient> client;
+        QTimer *timeoutTimer;
+        QElapsedTimer timer;
+        qint64 ttftMs;
+        int promptTokens;
+        int completionTokens;
+        int streamedChunks;
+        bool backendCounts;
+        int ragRequestId;
+
+        BatchItem()
+            : index(0), timeoutTimer(nullptr), ttftMs(-1), promptTokens(0),
+              completionTokens(0), streamedChunks(0), backendCounts(false), ragRequestId(0) {}
+    };
+
+    void loadCompletedIds();
+    void detectCapabilities();
+    void fillSlots();
+    void readStdin();
+    bool readNextLine(QByteArray &line);
+    bool readNextItem(BatchItem &item);
+    void startItem(BatchItem *item);
+    void sendItemPrompt(BatchItem *item, const QString &prompt);
+    void completeItem(BatchItem *item, const QString &response, const QString &error);
+    void writeRecord(const QJsonObject &record);
+    void checkDone();
+    void registerTools();
+
+    BatchOptions m_options;
+    QFile *m_input;
+    QFile *m_output;
+    bool m_inputExhausted;
+    int m_lineNumber;
+    bool m_done;  // finished has been emitted
+
+    // stdin is read as it becomes readable, so a slow producer never blocks the event loop
+    QSocketNotifier *m_stdinNotifier;
+    QByteArray m_stdinBuffer;  // Read but not yet taken; may end in a partial line
+    bool m_stdinEof;
+
+    // Capabilities detected once and seeded into every item's client
+    LLMClient *m_probeClient;
+    QString m_toolCallFormat;
+    QJsonObject m_modelInfo;
+    bool m_ready;
+
+    MCPHandler *m_mcpHandler;
+    RAGEngine *m_ragEngine;
+
+    QSet<QString> m_completedIds;  // From a previous run (--resume)
+    QList<BatchItem*> m_inFlight;
+    QHash<QString, BatchItem*> m_toolCallOwners;
+    BatchItem *m_dispatchingItem;
+
+    int m_completed;
+    int m_failed;
+    int m_skipped;
+    QElapsedTimer m_wallTimer;
+};
+
+/**
+ * @brief Entry point for --batch (blocks until the batch is done)
+ * @return 0 if every prompt succeeded, 1 otherwise
+ */
+int runBatch(const BatchOptions &options);
+
+#endif // BATCHRUNNER_H
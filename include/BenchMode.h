@@ -0,0 +1,24 @@
+/**
+ * BenchMode.h - Client-side LLM backend benchmark
+ *
+ * Streams synthetic responses from a bundled mock Ollama server through
+ * LLMClient and the streaming render path, reporting client CPU per token,
+ * TTFT overhead, sustainable tokens/s, and memory growth without a model.
+ */
+
+#ifndef BENCHMODE_H
+#define BENCHMODE_H
+
+#include <QCommandLineParser>
+
+/**
+ * @brief Run the --bench command
+ *
+ * Reads --bench-tokens, --bench-runs, --bench-rate, --bench-chunk,
+ * --bench-first-token-ms and --bench-tools from the parser.
+ *
+ * @return 0 if every run completed, 1 otherwise
+ */
+int runBench(const QCommandLineParser &parser);
+
+#endif // BENCHMODE_H
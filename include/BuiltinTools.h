@@ -0,0 +1,24 @@
+/**
+ * BuiltinTools.h - Built-in local MCP tools
+ *
+ * Calculator and date/time tools registered as local tools by the GUI,
+ * CLI, batch, bench and daemon modes.
+ */
+
+#ifndef BUILTINTOOLS_H
+#define BUILTINTOOLS_H
+
+#include <QJsonObject>
+
+/**
+ * @brief Basic arithmetic: {"operation": add|subtract|multiply|divide, "a": n, "b": n}
+ * @return {"result", "operation", "a", "b"} or {"error"} on division by zero
+ */
+QJsonObject exampleCalculatorTool(const QJsonObject &params);
+
+/**
+ * @brief Current date and time: {"format": short|long|iso|timestamp}
+ */
+QJsonObject exampleDateTimeTool(const QJsonObject &params);
+
+#endif // BUILTINTOOLS_H
@@ -10,9 +10,13 @@
 
 #include <QMainWindow>
 #include <QString>
+#include <QStringList>
 #include <QSet>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QElapsedTimer>
+#include "Config.h"
+#include "MemoryGovernor.h"
 
 class QTextEdit;
 class QLineEdit;
@@ -28,6 +32,11 @@ class ConversationManager;
 class MessageRenderer;
 class ToolUIManager;
 class RAGUIManager;
+class DaemonClient;
+class ConversationLibrary;
+class EngineThread;
+class AgentLoop;
+class SpeculativeRetriever;
 
 /**
  * @brief Main chat window for the application
@@ -45,7 +54,7 @@ class ChatWindow : public QMainWindow {
 
 public:
     explicit ChatWindow(QWidget *parent = nullptr);
-    ~ChatWindow() override = default;
+    ~ChatWindow() override;  // Stops the engine thread before members go away
 
 protected:
     void closeEvent(QCloseEvent *event) override;
@@ -53,6 +62,7 @@ protected:
 private slots:
     // Message handling
     void sendMessage();
+    void handleInputEdited(const QString &text);  // Speculative RAG retrieval while typing
     void handleStreamingToken(const QString &token);
     void handleLLMResponse(const QString &response);
     void handleLLMError(const QString &error);
@@ -81,6 +91,7 @@ private slots:
     void refreshMcpTools();
     void showLogViewer();
     void showToolsDialog();
+    void handleConfigChanged(Config::Sections sections);
 
     // Conversation management
     void clearConversation();
@@ -90,6 +101,7 @@ private slots:
     void saveConversation();
     void loadConversation();
     void exportConversation();
+    void showConversationLibrary();
 
     // RAG management
     void ingestDocument();
@@ -106,7 +118,14 @@ private:
     void registerTools();
     void registerLocalTools();
     void registerConfiguredServers();
+    void setupDaemonClient();
+    void ensureRagEngine();  // Creates RAGEngine/RAGUIManager on first need
+    bool ensureConversationLibrary();  // Opens the library database on first need
+    void dispatchPrompt(const QString &prompt);  // Queue a prompt (with enabled tools) to the LLM client
+    void handleAgentStepFinished(int stepId, const QString &toolName, bool ok, const QJsonObject &result, const QString &error);
+    void handleAgentFinished();
     void createMenuBar();
+    void setupMemoryGovernor();  // Transcript account, shedders and the status bar label
 
     // UI widgets
     QTextEdit *chatDisplay;
@@ -116,25 +135,42 @@ private:
     QTimer *thinkingTimer;
     int thinkingDots;
     QStatusBar *statusBar;
+    QLabel *memoryLabel;  // Permanent status bar widget: "Mem: 412 / 1024 MB"
 
-    // Core components
+    // Core components; LLMClient and RAGEngine live on engineThread and are
+    // only called through queued invocations
+    EngineThread *engineThread;
     LLMClient *llmClient;
     MCPHandler *mcpHandler;
     RAGEngine *ragEngine;
+    SpeculativeRetriever *speculativeRetriever;  // All ChatWindow retrievals go through it
+    DaemonClient *daemonClient;  // Non-null when attached to a daemon (daemon_url)
+    AgentLoop *agentLoop;        // Runs prompts as multi-step tasks in agent mode
 
     // Manager components
     ConversationManager *conversationManager;
     MessageRenderer *messageRenderer;
     ToolUIManager *toolUIManager;
     RAGUIManager *ragUIManager;
+    ConversationLibrary *conversationLibrary;
 
     // State
     bool isStreaming;
     bool streamingMessageCreated;
+    bool agentMode;              // View > Agent Mode
+    bool agentTask;              // The current prompt runs on agentLoop
+    QStringList agentCallIds;    // Model call IDs, by agent step ID - 1
     QString currentStreamingResponse;
     QString currentPrompt;
     QString lastSearchText;
     QString ragContext;
+
+    // Timings journaled with the next assistant message
+    QElapsedTimer responseTimer;
+    qint64 firstTokenMs;
+    QJsonObject responseTimings;
+
+    MemoryAccount transcriptMemory;  // Text of the chat display
 };
 
 #endif // CHATWINDOW_H
@@ -0,0 +1,50 @@
+/**
+ * CommandLine.h - Command-line options and headless mode dispatch
+ *
+ * Shared by the GUI binary (qt-chatbot-agent) and the Widgets-free
+ * qtbot-cli binary, so both accept the same options and run the same
+ * CLI, batch, bench, daemon and MCP stdio server modes.
+ */
+
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <QCommandLineParser>
+
+/**
+ * @brief Check argv for a mode that runs without a GUI
+ *
+ * Called before the application object exists, to choose between
+ * QCoreApplication and QApplication.
+ */
+bool isHeadlessInvocation(int argc, char *argv[]);
+
+/**
+ * @brief Register every option (help and version included) on the parser
+ */
+void addCommandLineOptions(QCommandLineParser &parser);
+
+/**
+ * @brief Apply --log-level, --model and stream record/replay options
+ *
+ * Must run before any LLMClient is created.
+ *
+ * @return false if an option is invalid (the error has been reported)
+ */
+bool applyCommandLineOptions(const QCommandLineParser &parser);
+
+/**
+ * @brief True when the parsed options select a headless mode
+ */
+bool hasHeadlessMode(const QCommandLineParser &parser);
+
+/**
+ * @brief Run the headless mode selected by the options
+ *
+ * Falls back to CLI mode when no mode option is set.
+ *
+ * @return Process exit code
+ */
+int runHeadlessMode(const QCommandLineParser &parser);
+
+#endif // COMMANDLINE_H
@@ -1,58 +1,195 @@
 /**
  * Config.h - Application configuration manager
- * 
+ *
  * Singleton for managing application settings (LLM, RAG, MCP), loads/saves
  * JSON configuration from ~/.qtbot/config.json, provides default values.
+ * Settings are published as immutable snapshots so readers never lock.
  */
 
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <QObject>
 #include <QString>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QMutex>
+#include <QPointer>
 #include <cmath>
+#include <functional>
+#include <memory>
+
+class QFileSystemWatcher;
+class QTimer;
+
+/**
+ * @brief Immutable view of every configuration value
+ *
+ * A snapshot is never modified after it has been published. Callers that
+ * need several values for one operation (e.g. building an LLM request)
+ * should take one snapshot and read everything from it, so the request is
+ * built from a consistent set of settings even if the config is reloaded
+ * concurrently.
+ */
+struct ConfigSnapshot {
+    QString backend;
+    QString model;
+    QString apiUrl;
+    QString openaiApiKey;
+    QString systemPrompt;
+
+    // Model routing (empty = use the main model, see ModelRouter)
+    QString fastModel;          // Default for every non-answer role
+    QString toolModel;          // Tool selection and argument extraction
+    QString summaryModel;
+    QString queryRewriteModel;
+
+    // LLM Configuration Parameters
+    int contextWindowSize;
+    double temperature;
+    double topP;
+    int topK;
+    int maxTokens;
+
+    // Override flags - if false, don't include parameter in request (use model default)
+    bool overrideContextWindowSize;
+    bool overrideTemperature;
+    bool overrideTopP;
+    bool overrideTopK;
+    bool overrideMaxTokens;
+
+    // RAG Configuration
+    bool ragEnabled;
+    QString ragEmbeddingModel;
+    QString ragEmbeddingProvider;  // "ollama", "openai" or "local" (see EmbeddingProvider)
+    QString ragEmbeddingUrl;       // Empty = the provider's default endpoint
+    int ragEmbeddingDimensions;    // Stored vector width (0 = as the model returns them)
+    QString ragDimensionReduction; // "truncate" (Matryoshka) or "pca" (see VectorIndex)
+    int ragChunkSize;
+    int ragChunkOverlap;
+    int ragChunkTokens;      // Chunk by tokens of the embedding model (0 = by ragChunkSize chars)
+    QString ragTokenizer;    // tokenizer.json or vocab.txt; empty = the model's default, else estimated
+    int ragTopK;
+    bool ragSpeculative;  // Retrieve while the user is still typing
+    int ragDeadlineMs;    // Longest wait for a query embedding (0 = no limit)
+    bool ragJournal;      // Journal ingestion so it resumes after a restart
+
+    // MCP Server Configuration
+    QJsonArray mcpServers;
+
+    // Daemon attach (empty = run engines in-process)
+    QString daemonUrl;
+
+    // Process memory budget enforced by MemoryGovernor (0 = unlimited)
+    int memoryBudgetMb;
+
+    ConfigSnapshot();
+
+    bool operator==(const ConfigSnapshot &other) const;
+    bool operator!=(const ConfigSnapshot &other) const { return !(*this == other); }
+};
+
+class Config : public QObject {
+    Q_OBJECT
 
-class Config {
 public:
+    /**
+     * @brief Configuration sections, used to tell subscribers what changed
+     */
+    enum Section {
+        NoSection = 0x0,
+        LLMSection = 0x1,         // Backend, models, API URL, API key, daemon URL
+        GenerationSection = 0x2,  // System prompt and sampling parameters
+        RAGSection = 0x4,         // RAG settings
+        MCPSection = 0x8,         // MCP server list
+        MemorySection = 0x10      // Memory budget
+    };
+    Q_DECLARE_FLAGS(Sections, Section)
+    Q_FLAG(Sections)
+
     static Config& instance();
 
     // Initialize and load configuration
     bool load(const QString &configPath = QString());
     bool save();
 
+    /**
+     * @brief Re-read the config file and publish a new snapshot if it changed
+     * @return true if the file was read successfully (changed or not)
+     */
+    bool reload();
+
+    /**
+     * @brief Watch the config file and hot-reload it when edited on disk
+     *
+     * Emits configChanged() with the affected sections after each reload
+     * that actually changes a value. Must be called after the
+     * QCoreApplication has been created.
+     */
+    void watchConfigFile();
+    void stopWatchingConfigFile();
+
+    /**
+     * @brief Current settings snapshot (lock-free for readers)
+     */
+    std::shared_ptr<const ConfigSnapshot> snapshot() const;
+
+    /**
+     * @brief Apply several changes and publish them as a single snapshot
+     * @param mutator Callback that edits a working copy of the settings
+     */
+    void update(const std::function<void(ConfigSnapshot &)> &mutator);
+
+    // Compare two snapshots and report which sections differ
+    static Sections changedSections(const ConfigSnapshot &before, const ConfigSnapshot &after);
+
     // Getters
-    QString getBackend() const { return m_backend; }
-    QString getModel() const { return m_model; }
-    QString getApiUrl() const { return m_apiUrl; }
-    QString getOpenAIApiKey() const { return m_openaiApiKey; }
-    QString getSystemPrompt() const { return m_systemPrompt; }
-    QString getConfigPath() const { return m_configPath; }
+    QString getBackend() const { return snapshot()->backend; }
+    QString getModel() const { return snapshot()->model; }
+    QString getApiUrl() const { return snapshot()->apiUrl; }
+    QString getOpenAIApiKey() const { return snapshot()->openaiApiKey; }
+    QString getSystemPrompt() const { return snapshot()->systemPrompt; }
+    QString getFastModel() const { return snapshot()->fastModel; }
+    QString getConfigPath() const;
 
     // LLM Configuration Getters
-    int getContextWindowSize() const { return m_contextWindowSize; }
-    double getTemperature() const { return m_temperature; }
-    double getTopP() const { return m_topP; }
-    int getTopK() const { return m_topK; }
-    int getMaxTokens() const { return m_maxTokens; }
+    int getContextWindowSize() const { return snapshot()->contextWindowSize; }
+    double getTemperature() const { return snapshot()->temperature; }
+    double getTopP() const { return snapshot()->topP; }
+    int getTopK() const { return snapshot()->topK; }
+    int getMaxTokens() const { return snapshot()->maxTokens; }
 
     // Check if parameter override is enabled
-    bool getOverrideContextWindowSize() const { return m_overrideContextWindowSize; }
-    bool getOverrideTemperature() const { return m_overrideTemperature; }
-    bool getOverrideTopP() const { return m_overrideTopP; }
-    bool getOverrideTopK() const { return m_overrideTopK; }
-    bool getOverrideMaxTokens() const { return m_overrideMaxTokens; }
+    bool getOverrideContextWindowSize() const { return snapshot()->overrideContextWindowSize; }
+    bool getOverrideTemperature() const { return snapshot()->overrideTemperature; }
+    bool getOverrideTopP() const { return snapshot()->overrideTopP; }
+    bool getOverrideTopK() const { return snapshot()->overrideTopK; }
+    bool getOverrideMaxTokens() const { return snapshot()->overrideMaxTokens; }
 
     // RAG Configuration Getters
-    bool getRagEnabled() const { return m_ragEnabled; }
-    QString getRagEmbeddingModel() const { return m_ragEmbeddingModel; }
-    int getRagChunkSize() const { return m_ragChunkSize; }
-    int getRagChunkOverlap() const { return m_ragChunkOverlap; }
-    int getRagTopK() const { return m_ragTopK; }
+    bool getRagEnabled() const { return snapshot()->ragEnabled; }
+    QString getRagEmbeddingModel() const { return snapshot()->ragEmbeddingModel; }
+    QString getRagEmbeddingProvider() const { return snapshot()->ragEmbeddingProvider; }
+    QString getRagEmbeddingUrl() const { return snapshot()->ragEmbeddingUrl; }
+    int getRagEmbeddingDimensions() const { return snapshot()->ragEmbeddingDimensions; }
+    QString getRagDimensionReduction() const { return snapshot()->ragDimensionReduction; }
+    int getRagChunkSize() const { return snapshot()->ragChunkSize; }
+    int getRagChunkOverlap() const { return snapshot()->ragChunkOverlap; }
+    int getRagChunkTokens() const { return snapshot()->ragChunkTokens; }
+    QString getRagTokenizer() const { return snapshot()->ragTokenizer; }
+    int getRagTopK() const { return snapshot()->ragTopK; }
+    bool getRagSpeculative() const { return snapshot()->ragSpeculative; }
+    int getRagDeadlineMs() const { return snapshot()->ragDeadlineMs; }
+    bool getRagJournal() const { return snapshot()->ragJournal; }
 
     // MCP Server Configuration Getters
-    QJsonArray getMcpServers() const { return m_mcpServers; }
+    QJsonArray getMcpServers() const { return snapshot()->mcpServers; }
+
+    // Daemon attach URL (e.g. http://127.0.0.1:8765)
+    QString getDaemonUrl() const { return snapshot()->daemonUrl; }
+
+    // Memory budget in MB (0 = unlimited)
+    int getMemoryBudgetMb() const { return snapshot()->memoryBudgetMb; }
 
     // Setters
     void setBackend(const QString &backend);
@@ -60,6 +197,7 @@ public:
     void setApiUrl(const QString &apiUrl);
     void setOpenAIApiKey(const QString &apiKey);
     void setSystemPrompt(const QString &systemPrompt);
+    void setFastModel(const QString &model);
 
     // LLM Configuration Setters
     void setContextWindowSize(int size);
@@ -78,61 +216,73 @@ public:
     // RAG Configuration Setters
     void setRagEnabled(bool enabled);
     void setRagEmbeddingModel(const QString &model);
+    void setRagEmbeddingProvider(const QString &provider);
+    void setRagEmbeddingUrl(const QString &url);
+    void setRagEmbeddingDimensions(int dimensions);
+    void setRagDimensionReduction(const QString &method);
     void setRagChunkSize(int size);
     void setRagChunkOverlap(int overlap);
+    void setRagChunkTokens(int tokens);
+    void setRagTokenizer(const QString &path);
     void setRagTopK(int topK);
+    void setRagSpeculative(bool enabled);
+    void setRagDeadlineMs(int ms);
+    void setRagJournal(bool enabled);
 
     // MCP Server Configuration Setters
     void setMcpServers(const QJsonArray &servers);
 
+    // Daemon attach setter
+    void setDaemonUrl(const QString &url);
+
+    // Memory budget setter
+    void setMemoryBudgetMb(int mb);
+
     // Reset to defaults
     void resetToDefaults();
 
     // Validate configuration
     bool isValid() const;
 
+signals:
+    /**
+     * @brief Emitted after a hot reload changed at least one value
+     * @param sections The configuration sections that changed
+     */
+    void configChanged(Config::Sections sections);
+
+private slots:
+    void handleConfigFileChanged(const QString &path);
+
 private:
     Config();
-    ~Config() = default;
+    ~Config() override = default;
     Config(const Config&) = delete;
     Config& operator=(const Config&) = delete;
 
     QString getDefaultConfigPath() const;
-    QJsonObject toJson() const;
-    void fromJson(const QJsonObject &json);
+    bool readConfigFile(const QString &path, ConfigSnapshot &data) const;
+    static QJsonObject toJson(const ConfigSnapshot &data);
+    static void fromJson(const QJsonObject &json, ConfigSnapshot &data);
+
+    // Publish m_data as the new current snapshot (m_mutex must be held)
+    void publish();
 
     QString m_configPath;
-    QString m_backend;
-    QString m_model;
-    QString m_apiUrl;
-    QString m_openaiApiKey;
-    QString m_systemPrompt;
 
-    // LLM Configuration Parameters
-    int m_contextWindowSize;
-    double m_temperature;
-    double m_topP;
-    int m_topK;
-    int m_maxTokens;
+    // Working copy of the settings, guarded by m_mutex (writers only)
+    ConfigSnapshot m_data;
 
-    // Override flags - if false, don't include parameter in request (use model default)
-    bool m_overrideContextWindowSize;
-    bool m_overrideTemperature;
-    bool m_overrideTopP;
-    bool m_overrideTopK;
-    bool m_overrideMaxTokens;
+    // Published snapshot; accessed only through std::atomic_load/atomic_store
+    std::shared_ptr<const ConfigSnapshot> m_snapshot;
 
-    // RAG Configuration
-    bool m_ragEnabled;
-    QString m_ragEmbeddingModel;
-    int m_ragChunkSize;
-    int m_ragChunkOverlap;
-    int m_ragTopK;
-
-    // MCP Server Configuration
-    QJsonArray m_mcpServers;
+    // Hot reload
+    QPointer<QFileSystemWatcher> m_watcher;
+    QPointer<QTimer> m_reloadTimer;
 
     mutable QMutex m_mutex;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Config::Sections)
+
 #endif // CONFIG_H
@@ -0,0 +1,82 @@
+/**
+ * ConversationExporter.h - Background conversation export
+ *
+ * Exports a snapshot of a conversation journal to text, Markdown or JSON
+ * on a worker thread. Records are written as they are read, a page of
+ * messages at a time, optionally gzip-compressed, into a QSaveFile that is
+ * renamed over the destination only when the export completes.
+ */
+
+#ifndef CONVERSATIONEXPORTER_H
+#define CONVERSATIONEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QJsonObject>
+#include <atomic>
+#include <functional>
+
+class QIODevice;
+class QThread;
+
+/**
+ * @brief Immutable view of a conversation to export
+ *
+ * Journals are append-only, so the first journalSize bytes of the file
+ * never change: messages added while an export runs are not included.
+ */
+struct ConversationSnapshot {
+    QString journalPath;    // Empty for a conversation with no messages
+    qint64 journalSize;
+    QString model;          // Current settings, used when the journal has no header
+    QString backend;
+
+    ConversationSnapshot() : journalSize(0) {}
+};
+
+/**
+ * @brief Runs one export at a time on a worker thread
+ */
+class ConversationExporter : public QObject {
+    Q_OBJECT
+
+public:
+    enum Format {
+        Text,
+        Markdown,
+        Json
+    };
+
+    explicit ConversationExporter(QObject *parent = nullptr);
+    ~ConversationExporter() override;  // Cancels and waits for a running export
+
+    // Start exporting; false if an export is already running
+    bool start(const ConversationSnapshot &snapshot, const QString &outputPath, Format format, bool compress);
+    void cancel();
+    bool isRunning() const;
+
+    // Format and compression from the file name (".md", ".json", otherwise text; ".gz" compresses)
+    static Format formatForPath(const QString &path, bool *compress = nullptr);
+    static bool compressionAvailable();
+
+    /**
+     * @brief Write @p snapshot to @p out (the worker body; synchronous)
+     *
+     * @p progress is called after each page with (messages written, total).
+     * Returns false on a write error or when @p cancelled becomes true.
+     */
+    static bool write(const ConversationSnapshot &snapshot, QIODevice *out, Format format, bool compress,
+                      const std::function<void(int, int)> &progress = nullptr,
+                      const std::atomic<bool> *cancelled = nullptr, QString *error = nullptr);
+
+signals:
+    void progress(int written, int total);
+    void finished(const QString &outputPath);
+    void failed(const QString &outputPath, const QString &error);
+
+private:
+    QThread *m_thread;
+    std::atomic<bool> m_cancelled;
+};
+
+#endif // CONVERSATIONEXPORTER_H
@@ -0,0 +1,183 @@
+/**
+ * ConversationJournal.h - Append-only conversation message journal
+ *
+ * Stores a conversation as JSONL: one header record, then one record per
+ * completed message (role, content, tool calls, timings). Messages are
+ * appended as they complete and fsync'd in batches, so saving costs
+ * O(new messages) and a crash loses at most the unsynced tail, which is
+ * detected and trimmed when the journal is reopened.
+ */
+
+#ifndef CONVERSATIONJOURNAL_H
+#define CONVERSATIONJOURNAL_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QFile>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QJsonArray>
+
+class QTimer;
+
+// fsync after this many appended records, or after the interval, whichever comes first
+#define JOURNAL_SYNC_BATCH 8
+#define JOURNAL_SYNC_INTERVAL_MS 2000
+
+// Messages restored per page when a journal is loaded
+#define JOURNAL_PAGE_SIZE 50
+
+/**
+ * @brief One completed conversation message
+ */
+struct ConversationMessage {
+    QString role;           // "user", "assistant" or "tool"
+    QString content;
+    QJsonArray toolCalls;   // assistant: [{"id","name","arguments"}]
+    QString toolName;       // tool: tool that produced the result
+    QString toolCallId;
+    bool isError;           // tool: content is an error message
+    QDateTime timestamp;
+    QJsonObject timings;    // assistant: prompt_tokens, completion_tokens, total_ms, ttft_ms, elapsed_ms
+
+    ConversationMessage() : isError(false), timestamp(QDateTime::currentDateTime()) {}
+
+    QJsonObject toJson() const;
+    static ConversationMessage fromJson(const QJsonObject &obj);
+};
+
+/**
+ * @brief Parsed journal file
+ */
+struct ConversationJournalContents {
+    QJsonObject header;                     // {"type":"conversation",...}
+    QList<ConversationMessage> messages;
+    QList<QJsonObject> imports;             // Legacy conversations imported as HTML
+    bool cleanlyClosed;                     // Last record is the close marker
+    int skippedRecords;                     // Unparseable lines (torn or corrupt)
+
+    ConversationJournalContents() : cleanlyClosed(false), skippedRecords(0) {}
+};
+
+/**
+ * @brief Writer for one conversation journal file
+ *
+ * Record format (one JSON object per line):
+ *   {"type":"conversation","version":2,"app":"...","created_at":"...","model":"...","backend":"..."}
+ *   {"type":"message","role":"user","content":"...","t":"..."}
+ *   {"type":"message","role":"assistant","content":"...","tool_calls":[...],"timings":{...},"t":"..."}
+ *   {"type":"message","role":"tool","tool_name":"...","tool_call_id":"...","content":"...","t":"..."}
+ *   {"type":"import","content":"...","content_html":"..."}
+ *   {"type":"close","t":"..."}
+ *
+ * A journal whose last record is not "close" was not shut down cleanly.
+ */
+class ConversationJournal : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ConversationJournal(QObject *parent = nullptr);
+    ~ConversationJournal() override;
+
+    /**
+     * @brief Open @p path for appending, creating it with @p header if new
+     *
+     * A torn trailing record left by a crash is truncated first.
+     */
+    bool open(const QString &path, const QJsonObject &header = QJsonObject());
+
+    // Sync and append the clean-close marker (writeCloseMarker = false leaves it recoverable)
+    void close(bool writeCloseMarker = true);
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString path() const { return m_path; }
+
+    bool append(const ConversationMessage &message);
+    bool appendImport(const QString &content, const QString &contentHtml);
+
+    // fsync pending records now
+    bool sync();
+    int pendingSync() const { return m_pendingSync; }
+    int syncCount() const { return m_syncCount; }
+
+    // Move the file (Save As) and keep appending at the new path
+    bool moveTo(const QString &newPath);
+
+    void setSyncBatchSize(int records) { m_syncBatchSize = qMax(1, records); }
+    void setSyncIntervalMs(int ms);
+
+    // Reading
+    static bool isJournalFile(const QString &path);
+    static bool read(const QString &path, ConversationJournalContents &contents, QString *error = nullptr);
+    static QJsonArray toLlmHistory(const QList<ConversationMessage> &messages);
+
+    // Autosave directory (~/.qtbot/conversations) and the newest unfinished journal in it
+    static QString autosaveDirectory();
+    static QString findUnfinished(const QString &directory);
+
+signals:
+    void writeFailed(const QString &error);
+
+private:
+    bool appendRecord(const QJsonObject &record);
+    bool trimTornTail();
+
+    QFile m_file;
+    QString m_path;
+    QTimer *m_syncTimer;
+    int m_pendingSync;
+    int m_syncCount;
+    int m_syncBatchSize;
+};
+
+/**
+ * @brief Random access to the messages of a journal file
+ *
+ * open() maps the file once and records where each message record starts
+ * without parsing any JSON (message records always end with
+ * "type":"message"} because compact JSON sorts keys). Messages are parsed
+ * only when a page is read, so the newest messages of a large journal are
+ * available in time independent of its length.
+ */
+class ConversationJournalIndex {
+public:
+    ConversationJournalIndex() : m_cleanlyClosed(false) {}
+
+    // A non-negative @p size indexes only the first size bytes (a snapshot of a growing journal)
+    bool open(const QString &path, QString *error = nullptr, qint64 size = -1);
+    void clear();
+
+    bool isOpen() const { return !m_path.isEmpty(); }
+    QString path() const { return m_path; }
+    QJsonObject header() const { return m_header; }
+    QList<QJsonObject> imports() const { return m_imports; }
+    bool cleanlyClosed() const { return m_cleanlyClosed; }
+    int messageCount() const { return m_messageOffsets.size(); }
+
+    // Messages [first, first + count), parsed from the file
+    QList<ConversationMessage> messages(int first, int count) const;
+
+    // Same, read from an already open handle to the file (survives a rename or delete)
+    QList<ConversationMessage> messages(QIODevice *file, int first, int count) const;
+
+    /**
+     * @brief LLM history of the newest messages within @p maxTokens
+     *
+     * Reads backwards a page at a time and stops at the budget (about 4
+     * characters per token), so the cost is bounded by the budget rather
+     * than the journal length. The history always starts at a user
+     * message. 0 restores everything.
+     */
+    QJsonArray llmHistory(int maxTokens = 0) const;
+
+private:
+    QString m_path;
+    QJsonObject m_header;
+    QList<QJsonObject> m_imports;
+    QVector<qint64> m_messageOffsets;
+    bool m_cleanlyClosed;
+};
+
+#endif // CONVERSATIONJOURNAL_H
@@ -0,0 +1,123 @@
+/**
+ * ConversationLibrary.h - Full-text index over saved conversations
+ *
+ * Keeps an SQLite database (~/.qtbot/library.db) with one row per saved
+ * conversation and an FTS5 table holding every message. Searching is a
+ * single ranked FTS query, so it never opens the conversation files.
+ * Journals are append-only, so re-indexing a saved conversation only
+ * inserts the messages added since it was last indexed.
+ */
+
+#ifndef CONVERSATIONLIBRARY_H
+#define CONVERSATIONLIBRARY_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDate>
+#include <QDateTime>
+
+class QSqlDatabase;
+
+/**
+ * @brief One indexed conversation file
+ */
+struct LibrarySession {
+    QString path;
+    QString title;          // First user message (journals) or file name (legacy)
+    QString model;
+    QString backend;
+    QDateTime createdAt;
+    int messageCount;
+
+    LibrarySession() : messageCount(0) {}
+};
+
+/**
+ * @brief Best matching message of a conversation
+ */
+struct LibraryHit {
+    LibrarySession session;
+    int messageIndex;       // Message number within the conversation
+    QString role;
+    QString snippet;        // Matched terms wrapped in [ ]
+    double rank;            // BM25, lower is better
+
+    LibraryHit() : messageIndex(0), rank(0.0) {}
+};
+
+/**
+ * @brief Search filter (empty fields match everything)
+ */
+struct LibraryFilter {
+    QString model;
+    QDate from;
+    QDate to;               // Inclusive
+};
+
+/**
+ * @brief Conversation library backed by SQLite FTS5
+ *
+ * Indexes journals (.jsonl) message by message and legacy .json files as a
+ * single transcript. Files are re-read only when their size or
+ * modification time changed.
+ */
+class ConversationLibrary : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ConversationLibrary(QObject *parent = nullptr);
+    ~ConversationLibrary() override;
+
+    // Open (creating if needed) the database; empty path = defaultDatabasePath()
+    bool open(const QString &databasePath = QString());
+    void close();
+    bool isOpen() const { return m_open; }
+    QString lastError() const { return m_lastError; }
+
+    // Index one conversation file; unchanged files are skipped
+    bool indexFile(const QString &path);
+
+    // Index every conversation file in @p directory and remember it for refresh()
+    int addFolder(const QString &directory);
+    QStringList folders() const;
+
+    // Re-index changed files, pick up new files in folders, drop deleted files
+    int refresh();
+
+    bool removeSession(const QString &path);
+
+    /**
+     * @brief Ranked full-text search, best message per conversation
+     *
+     * Words are matched as prefixes and all must occur in the same message.
+     * An empty query lists conversations newest first.
+     */
+    QList<LibraryHit> search(const QString &query, const LibraryFilter &filter = LibraryFilter(), int limit = 50) const;
+
+    QStringList models() const;
+    int sessionCount() const;
+
+    static QString defaultDatabasePath();
+
+    // Convert user input into a safe FTS5 MATCH expression
+    static QString toMatchExpression(const QString &query);
+
+signals:
+    void sessionIndexed(const QString &path);
+
+private:
+    QSqlDatabase database() const;
+    bool exec(const QString &sql);
+    bool indexJournal(const QString &path, qint64 sessionId, int indexedMessages, qint64 size, qint64 mtime);
+    bool indexLegacy(const QString &path, qint64 sessionId, qint64 size, qint64 mtime);
+    void deleteMessages(qint64 sessionId);
+    QList<LibraryHit> recentSessions(const LibraryFilter &filter, int limit) const;
+
+    QString m_connectionName;
+    QString m_lastError;
+    bool m_open;
+};
+
+#endif // CONVERSATIONLIBRARY_H
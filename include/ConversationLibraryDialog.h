@@ -0,0 +1,52 @@
+/**
+ * ConversationLibraryDialog.h - Search and open saved conversations
+ *
+ * Search-as-you-type over the ConversationLibrary index with model and
+ * date filters. Activating a result asks the window to open that file.
+ */
+
+#ifndef CONVERSATIONLIBRARYDIALOG_H
+#define CONVERSATIONLIBRARYDIALOG_H
+
+#include <QDialog>
+
+class QLineEdit;
+class QComboBox;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QLabel;
+class QPushButton;
+class QTimer;
+class ConversationLibrary;
+
+class ConversationLibraryDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit ConversationLibraryDialog(ConversationLibrary *library, QWidget *parent = nullptr);
+
+signals:
+    void conversationSelected(const QString &fileName);
+
+private slots:
+    void runSearch();
+    void refreshIndex();
+    void addFolder();
+    void openSelected();
+    void onItemActivated(QTreeWidgetItem *item);
+
+private:
+    void createUI();
+    void reloadModels();
+
+    ConversationLibrary *library;
+    QLineEdit *searchField;
+    QComboBox *modelCombo;
+    QComboBox *dateCombo;
+    QTreeWidget *resultsTree;
+    QLabel *statusLabel;
+    QPushButton *openButton;
+    QTimer *searchTimer;
+};
+
+#endif // CONVERSATIONLIBRARYDIALOG_H
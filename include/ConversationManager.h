@@ -3,6 +3,8 @@
  * 
  * Handles conversation lifecycle (new/save/load/export), tracks modification
  * state, and manages current file path. Emits signals for state changes.
+ * Messages are appended to a ConversationJournal as they complete, so
+ * saving only syncs the journal and unsaved conversations survive a crash.
  */
 
 #ifndef CONVERSATIONMANAGER_H
@@ -11,6 +13,10 @@
 #include <QObject>
 #include <QString>
 #include <QWidget>
+#include <QJsonArray>
+#include "ConversationJournal.h"
+#include "ConversationExporter.h"
+#include "MessageRenderer.h"
 
 class QTextEdit;
 
@@ -19,8 +25,10 @@ class QTextEdit;
  * 
  * Handles all conversation file operations including:
  * - Creating new conversations
- * - Saving/loading conversations in JSON format
- * - Exporting conversations to text/markdown
+ * - Journaling completed messages (JSONL, see ConversationJournal)
+ * - Saving/loading conversation journals (and legacy JSON files)
+ * - Recovering the last unsaved conversation on startup
+ * - Exporting conversations to text/markdown/JSON on a worker thread
  * - Tracking modification state
  */
 class ConversationManager : public QObject {
@@ -36,6 +44,33 @@ public:
     void loadConversation();
     void exportConversation();
 
+    // Open a specific file (conversation library), asking to save unsaved changes first
+    bool openConversationFile(const QString &fileName);
+
+    // Journaling: call as each message completes
+    void recordMessage(const ConversationMessage &message);
+    bool loadJournal(const QString &fileName);
+
+    // Paging of a loaded journal (newest page is shown first)
+    bool hasEarlierMessages() const { return loadedIndex.isOpen() && loadedFrom > 0; }
+    bool loadEarlierMessages();
+    bool recoverUnsavedConversation();
+
+    /**
+     * @brief Keep only the latest page of the transcript in the display
+     *
+     * Under memory pressure: syncs the journal and redisplays its newest
+     * JOURNAL_PAGE_SIZE messages; earlier ones page back in on scroll-up.
+     * @return false if nothing was unloaded (no journal, or one page or less)
+     */
+    bool compactTranscript();
+
+    // Stop journaling the current conversation; an unsaved autosave is discarded
+    void endConversation();
+
+    // Window is closing: keep an unsaved autosave recoverable, finish saved files
+    void shutdown();
+
     // State management
     bool isModified() const { return conversationModified; }
     void setModified(bool modified);
@@ -46,15 +81,28 @@ signals:
     void conversationChanged();
     void modificationStateChanged(bool modified);
     void messagePosted(const QString &sender, const QString &message);
+    void historyRestored(const QJsonArray &llmHistory);
+    void messagesRestored(const QList<ChatEntry> &entries, bool prepend);
+    void conversationStored(const QString &fileName);  // Saved file written or finished
+    void exportProgress(int written, int total);       // (-1, -1) when the export ended
 
 private:
     QTextEdit *chatDisplay;
     QWidget *parentWidget;
     bool conversationModified;
     QString currentConversationFile;
+    ConversationJournal *journal;
+    ConversationExporter *exporter;
+    ConversationJournalIndex loadedIndex;
+    int loadedFrom;  // First message of the loaded journal shown in the display
 
     // Helper methods
     bool promptToSaveIfModified(const QString &operation);
+    bool ensureJournalOpen();
+    bool isAutosave(const QString &fileName) const;
+    bool loadFile(const QString &fileName);
+    bool loadLegacyConversation(const QString &fileName);
+    QList<ChatEntry> toEntries(const QList<ConversationMessage> &messages, bool includeImports) const;
 };
 
 #endif // CONVERSATIONMANAGER_H
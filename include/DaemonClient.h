@@ -0,0 +1,73 @@
+/**
+ * DaemonClient.h - Client for the local daemon's OpenAI-compatible API
+ *
+ * Lets the CLI and GUI attach to a running daemon (--daemon) instead of
+ * bootstrapping their own LLM, tool, and RAG engines. Streams responses
+ * from /v1/chat/completions and keeps the conversation history locally.
+ */
+
+#ifndef DAEMONCLIENT_H
+#define DAEMONCLIENT_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QPointer>
+#include <QJsonArray>
+#include <QJsonObject>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+class DaemonClient : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DaemonClient(const QString &baseUrl, QObject *parent = nullptr);
+    ~DaemonClient() override;
+
+    void setBaseUrl(const QString &baseUrl);
+    QString getBaseUrl() const { return m_baseUrl; }
+
+    /**
+     * @brief Send a user message with the conversation so far (streamed)
+     *
+     * Tool calls and RAG retrieval are handled by the daemon.
+     */
+    void sendMessage(const QString &message);
+
+    // Cancel the request in flight (no signals are emitted for it)
+    void abort();
+    bool isBusy() const { return !m_currentReply.isNull(); }
+
+    // Query GET /health; result via healthChecked()
+    void checkHealth();
+
+    void clearConversationHistory();
+    QJsonArray getConversationHistory() const { return m_messages; }
+
+signals:
+    void tokenReceived(const QString &token);
+    void responseReceived(const QString &response);
+    void errorOccurred(const QString &errorMessage);
+    void healthChecked(bool reachable, const QJsonObject &status);
+
+private slots:
+    void handleStreamingData();
+    void handleStreamingFinished();
+
+private:
+    void processEvent(const QByteArray &data);
+
+    QNetworkAccessManager *m_networkManager;
+    QString m_baseUrl;
+    QPointer<QNetworkReply> m_currentReply;
+    QByteArray m_buffer;
+    QString m_fullResponse;
+    QString m_streamError;
+
+    // OpenAI-style message history (user/assistant)
+    QJsonArray m_messages;
+};
+
+#endif // DAEMONCLIENT_H
@@ -0,0 +1,27 @@
+/**
+ * DaemonMode.h - Headless daemon mode
+ *
+ * Runs a long-lived process that keeps the LLM, MCP tools, and RAG index warm
+ * and serves an OpenAI-compatible API to local clients.
+ */
+
+#ifndef DAEMONMODE_H
+#define DAEMONMODE_H
+
+#include <QCommandLineParser>
+
+// Default port for the local API (--port overrides)
+#define DAEMON_DEFAULT_PORT 8765
+
+/**
+ * @brief Run the application as a headless daemon
+ *
+ * Uses --host/--port for the listen address and --context to ingest a
+ * file or directory into the RAG index at startup. Runs until terminated.
+ *
+ * @param parser Parsed command-line arguments
+ * @return Exit code (0 for success, non-zero for failure)
+ */
+int runDaemon(const QCommandLineParser &parser);
+
+#endif // DAEMONMODE_H
@@ -0,0 +1,43 @@
+/**
+ * DocumentExtractor.h - In-process text extraction for office documents and PDFs
+ *
+ * DOCX and ODT files are ZIP archives of XML. Their text is read by
+ * inflating the document part block by block and feeding each block to a
+ * QXmlStreamReader, so neither the archive nor the XML is ever held whole.
+ * PDFs go through poppler-cpp when the build found it. RAGEngine falls
+ * back to the external tools when an extractor is unavailable or fails.
+ */
+
+#ifndef DOCUMENTEXTRACTOR_H
+#define DOCUMENTEXTRACTOR_H
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @brief Text extractors for DOCX, ODT and PDF files
+ *
+ * Each returns the document text, trimmed, with one line per paragraph.
+ * On failure the result is empty and @p error says why. The *Data
+ * variants parse a file already read into memory (BulkFileReader).
+ */
+class DocumentExtractor {
+public:
+    // word/document.xml of a WordprocessingML package
+    static QString extractDocx(const QString &filePath, QString *error = nullptr);
+    static QString extractDocxData(const QByteArray &data, QString *error = nullptr);
+
+    // content.xml of an OpenDocument text file
+    static QString extractOdt(const QString &filePath, QString *error = nullptr);
+    static QString extractOdtData(const QByteArray &data, QString *error = nullptr);
+
+    // Every page, in order; needs poppler-cpp
+    static QString extractPdf(const QString &filePath, QString *error = nullptr);
+    static QString extractPdfData(const QByteArray &data, QString *error = nullptr);
+
+    // Deflated ZIP entries need zlib; stored ones are always readable
+    static bool canInflate();
+    static bool canReadPdf();
+};
+
+#endif // DOCUMENTEXTRACTOR_H
@@ -0,0 +1,44 @@
+/**
+ * EmbeddingParser.h - Fast float extraction from embedding responses
+ *
+ * Embedding responses are one or more arrays of 768-4096 numbers. Building
+ * a QJsonDocument for them allocates a QJsonValue per number and converts
+ * each one back out; this parser scans the raw bytes for the vector arrays
+ * and converts the numbers straight into float storage instead.
+ */
+
+#ifndef EMBEDDINGPARSER_H
+#define EMBEDDINGPARSER_H
+
+#include <QByteArray>
+#include <QVector>
+
+/**
+ * @brief Parser for Ollama embedding response bodies
+ *
+ * Understands the single-vector /api/embeddings shape
+ * ({"embedding": [...]}) and the batched /api/embed shape
+ * ({"embeddings": [[...], [...]]}). Anything else, including vectors of
+ * differing length, is rejected rather than partly parsed.
+ */
+class EmbeddingParser {
+public:
+    /**
+     * @brief Append every vector in @p json to @p vectors
+     * @return Number of vectors parsed; 0 if the body is not an embedding response
+     */
+    static int parse(const QByteArray &json, QVector<QVector<float>> &vectors);
+
+    // Convenience for single-vector responses: the first vector, or empty
+    static QVector<float> parseFirst(const QByteArray &json);
+
+    /**
+     * @brief Parse one JSON array of numbers
+     *
+     * @p pos must point at the '['; on success it is left just past the
+     * matching ']' and the numbers are appended to @p out.
+     */
+    static bool parseArray(const char *data, int size, int &pos, QVector<float> &out);
+};
+
+#endif // EMBEDDINGPARSER_H
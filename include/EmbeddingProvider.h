@@ -0,0 +1,204 @@
+/**
+ * EmbeddingProvider.h - Pluggable embedding backends for RAGEngine
+ *
+ * RAGEngine asks a provider for vectors instead of talking to one HTTP
+ * endpoint itself. Providers: Ollama (/api/embeddings, batched /api/embed),
+ * OpenAI-compatible servers (/v1/embeddings), and an in-process hashed
+ * feature embedder that needs no server at all.
+ */
+
+#ifndef EMBEDDINGPROVIDER_H
+#define EMBEDDINGPROVIDER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QUrl>
+#include <QThreadPool>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/**
+ * @brief Asynchronous text-to-vector service
+ *
+ * embed() returns a ticket at once; the vectors arrive later through
+ * embeddingsReady() (one per text, in order) or the call fails through
+ * embeddingFailed(). Results are never delivered from inside embed(), so
+ * callers can record the ticket first. Lives on the thread of its owner.
+ */
+class EmbeddingProvider : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EmbeddingProvider(QObject *parent = nullptr);
+    ~EmbeddingProvider() override;
+
+    /**
+     * @brief Provider for a rag_embedding_provider value
+     * @param type "ollama", "openai" or "local"; anything else gets Ollama
+     */
+    static EmbeddingProvider *create(const QString &type, QObject *parent = nullptr);
+    static QStringList types();
+
+    virtual QString type() const = 0;
+
+    // True if embedding needs no server
+    virtual bool isLocal() const { return false; }
+
+    void setModel(const QString &model) { m_model = model; }
+    QString model() const { return m_model; }
+
+    // Endpoint; empty = the provider's default
+    void setUrl(const QString &url) { m_url = url; }
+    QString url() const { return m_url; }
+
+    void setApiKey(const QString &apiKey) { m_apiKey = apiKey; }
+
+    // Texts worth sending in one embed() call during ingestion
+    virtual int maxBatchSize() const = 0;
+
+    // @return Ticket (> 0) for the call
+    virtual int embed(const QStringList &texts) = 0;
+
+    // Forget a call; neither signal is emitted for it afterwards
+    virtual void cancel(int ticket) = 0;
+
+signals:
+    void embeddingsReady(int ticket, const QVector<QVector<float>> &vectors);
+    void embeddingFailed(int ticket, const QString &error);
+
+protected:
+    // Unique across all providers, so a replaced provider's tickets never collide
+    static int nextTicket();
+
+    QString m_model;
+    QString m_url;
+    QString m_apiKey;
+};
+
+/**
+ * @brief Shared HTTP plumbing for server backends
+ *
+ * Splits a call into requests of textsPerRequest() texts, parses every
+ * response with EmbeddingParser and reassembles the vectors in order.
+ * Any failed request fails the whole call.
+ */
+class HttpEmbeddingProvider : public EmbeddingProvider {
+    Q_OBJECT
+
+public:
+    explicit HttpEmbeddingProvider(QObject *parent = nullptr);
+    ~HttpEmbeddingProvider() override;
+
+    int embed(const QStringList &texts) override;
+    void cancel(int ticket) override;
+
+protected:
+    virtual int textsPerRequest() const = 0;
+    virtual QUrl endpoint(int textCount) const = 0;
+    virtual QByteArray requestBody(const QStringList &texts) const = 0;
+
+    // A request to @p url got 404; return true to resend its texts one per request
+    virtual bool batchRejected(const QUrl &url) { Q_UNUSED(url); return false; }
+
+private:
+    struct Call {
+        QVector<QVector<float>> vectors;
+        int remaining;  // Texts without a vector yet
+        QSet<QNetworkReply*> replies;
+    };
+
+    void sendRequest(int ticket, const QStringList &texts, int offset);
+    void handleReply(QNetworkReply *reply, int ticket, const QStringList &texts, int offset);
+    void failCall(int ticket, const QString &error);
+
+    QNetworkAccessManager *m_networkManager;
+    QHash<int, Call> m_calls;
+};
+
+/**
+ * @brief Ollama: /api/embeddings per text, or /api/embed for batches
+ *
+ * Batches fall back to one request per text on servers older than
+ * /api/embed. The URL may be the server root or a full endpoint URL.
+ */
+class OllamaEmbeddingProvider : public HttpEmbeddingProvider {
+    Q_OBJECT
+
+public:
+    explicit OllamaEmbeddingProvider(QObject *parent = nullptr);
+
+    QString type() const override { return "ollama"; }
+    int maxBatchSize() const override;
+
+protected:
+    int textsPerRequest() const override;
+    QUrl endpoint(int textCount) const override;
+    QByteArray requestBody(const QStringList &texts) const override;
+    bool batchRejected(const QUrl &url) override;
+
+private:
+    QString baseUrl() const;
+
+    bool m_batchSupported;
+};
+
+/**
+ * @brief OpenAI-compatible /v1/embeddings (OpenAI, llama.cpp server, vLLM, LM Studio, ...)
+ *
+ * The URL is the API base (".../v1") or the full endpoint; the API key,
+ * if set, is sent as a bearer token.
+ */
+class OpenAIEmbeddingProvider : public HttpEmbeddingProvider {
+    Q_OBJECT
+
+public:
+    explicit OpenAIEmbeddingProvider(QObject *parent = nullptr);
+
+    QString type() const override { return "openai"; }
+    int maxBatchSize() const override;
+
+protected:
+    int textsPerRequest() const override;
+    QUrl endpoint(int textCount) const override;
+    QByteArray requestBody(const QStringList &texts) const override;
+};
+
+/**
+ * @brief In-process embedder: hashed word, word-pair and trigram features
+ *
+ * Needs no model file and no server, so RAG keeps working offline, and a
+ * query embeds in microseconds. Vectors capture shared vocabulary rather
+ * than meaning, so retrieval quality is below a neural embedding model.
+ * Large batches are spread over a thread pool with one thread per core.
+ */
+class LocalEmbeddingProvider : public EmbeddingProvider {
+    Q_OBJECT
+
+public:
+    explicit LocalEmbeddingProvider(QObject *parent = nullptr);
+    ~LocalEmbeddingProvider() override;
+
+    QString type() const override { return "local"; }
+    bool isLocal() const override { return true; }
+    int maxBatchSize() const override;
+
+    int embed(const QStringList &texts) override;
+    void cancel(int ticket) override;
+
+    // L2-normalized vector of dimensions() floats; thread-safe
+    static QVector<float> embedText(const QString &text);
+    static int dimensions();
+
+private:
+    void deliver(int ticket, const QVector<QVector<float>> &vectors);
+
+    QThreadPool m_pool;
+    QSet<int> m_activeTickets;
+};
+
+#endif // EMBEDDINGPROVIDER_H
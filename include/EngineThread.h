@@ -0,0 +1,73 @@
+/**
+ * EngineThread.h - Worker thread that owns network engines
+ *
+ * Keeps LLMClient and RAGEngine (with their QNetworkAccessManagers) off the
+ * GUI thread, so response parsing, embedding parsing and logging don't
+ * compete with painting. Engines are constructed on the worker thread and
+ * destroyed there by stop(); callers talk to them only through queued
+ * signals and QMetaObject::invokeMethod().
+ */
+
+#ifndef ENGINETHREAD_H
+#define ENGINETHREAD_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QPointer>
+#include <QThread>
+#include <functional>
+
+/**
+ * @brief Owns a QThread and the engine objects living on it
+ *
+ * Lifetime: objects created with create() or passed to adopt() belong to
+ * the EngineThread. stop() deletes them on the worker thread (newest
+ * first), then quits and joins the thread; the destructor calls stop().
+ * Owners should call stop() before destroying anything the engines'
+ * queued signals are connected to.
+ */
+class EngineThread : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EngineThread(const QString &name, QObject *parent = nullptr);
+    ~EngineThread() override;
+
+    /**
+     * @brief Construct a T on the worker thread and take ownership of it
+     *
+     * Blocks until the constructor has run, so the object's children (such
+     * as a QNetworkAccessManager) are created with the right thread
+     * affinity. Returns nullptr once stopped.
+     */
+    template <typename T>
+    T *create() {
+        T *object = nullptr;
+        runBlocking([&object]() { object = new T(); });
+        if (object) {
+            m_objects.append(object);
+        }
+        return object;
+    }
+
+    // Move a parentless object to the worker thread and take ownership of it
+    bool adopt(QObject *object);
+
+    // Delete owned objects on the worker thread, then quit and join it
+    void stop();
+
+    bool isRunning() const;
+    bool isCurrentThread() const;
+    QThread *workerThread() const { return m_thread; }
+
+private:
+    // Run @p function on the worker thread and wait for it
+    void runBlocking(const std::function<void()> &function);
+
+    QThread *m_thread;
+    QObject *m_anchor;  // Lives on the worker thread; target for blocking calls
+    QList<QPointer<QObject>> m_objects;
+};
+
+#endif // ENGINETHREAD_H
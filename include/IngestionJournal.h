@@ -0,0 +1,159 @@
+/**
+ * IngestionJournal.h - Durable record of RAG ingestion progress
+ *
+ * Records the documents RAGEngine has chunked and the embeddings it has
+ * committed, so an ingestion interrupted by a crash or shutdown resumes
+ * from the last committed batch instead of re-reading and re-embedding
+ * everything.
+ */
+
+#ifndef INGESTIONJOURNAL_H
+#define INGESTIONJOURNAL_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QFile>
+#include <QJsonObject>
+#include <memory>
+
+class QLockFile;
+
+/**
+ * @brief One chunked document
+ */
+struct IngestedDocument {
+    QString path;
+    qint64 size;
+    qint64 modified;   // ms since the epoch
+    int firstChunk;    // Engine chunk index of chunks[0]
+    QStringList chunks;
+    QVector<int> tokenCounts;  // Per chunk; empty in journals written before they were recorded
+    QString tokenizer;         // Tokenizer::name() the counts are from
+    bool removed;              // Superseded by a later version, or dropped; its chunks are dead
+
+    IngestedDocument() : size(0), modified(0), firstChunk(0), removed(false) {}
+};
+
+/**
+ * @brief Embeddings committed in one batch, stored in the vector file
+ */
+struct IngestedEmbeddings {
+    QVector<int> chunks;  // Engine chunk indices, in vector order
+    qint64 offset;        // Byte offset of the first vector in the vector file
+    int dimensions;
+
+    IngestedEmbeddings() : offset(0), dimensions(0) {}
+};
+
+/**
+ * @brief Directory ingestion that was started but not finished
+ */
+struct IngestedDirectory {
+    QString path;
+    QStringList files;  // Everything discovered, finished or not
+};
+
+/**
+ * @brief Contents of a journal, as read by open()
+ */
+struct IngestionJournalContents {
+    QJsonObject header;                     // {"type":"ingestion",...}
+    QList<IngestedDocument> documents;      // In the order they were chunked, removed ones included
+    QList<IngestedEmbeddings> embeddings;   // Only batches whose vectors are on disk
+    QList<IngestedDirectory> directories;   // Unfinished only
+    int skippedRecords;                     // Unparseable lines or vectors missing from the vector file
+
+    IngestionJournalContents() : skippedRecords(0) {}
+};
+
+/**
+ * @brief Append-only ingestion journal: JSONL records plus a vector file
+ *
+ * Record format (one JSON object per line):
+ *   {"type":"ingestion","version":1,"app":"...","created_at":"...","provider":"...","model":"..."}
+ *   {"type":"directory","path":"...","files":[...]}
+ *   {"type":"document","path":"...","size":N,"modified":N,"first_chunk":N,"chunks":["...",...],
+ *    "tokenizer":"...","tokens":[N,...]}
+ *   {"type":"embedded","chunks":[N,...],"offset":N,"dimensions":N}
+ *   {"type":"removed","path":"..."}
+ *   {"type":"directory_done","path":"..."}
+ *
+ * Vectors live in "<journal>.vec" as native-endian float32 rows at full
+ * model width. An embedded record is written only after its vectors are
+ * fsync'd, so a record never refers to vectors that aren't on disk; vectors
+ * past the last committed record are truncated when the journal is
+ * reopened, as is a torn trailing record. A removed record marks the
+ * latest document record for its path as dead (the file changed and is
+ * about to be chunked again); its chunk indices stay taken so later
+ * records keep their meaning.
+ *
+ * One process at a time: open() takes "<journal>.lock".
+ */
+class IngestionJournal {
+public:
+    IngestionJournal();
+    ~IngestionJournal();
+
+    IngestionJournal(const IngestionJournal&) = delete;
+    IngestionJournal& operator=(const IngestionJournal&) = delete;
+
+    /**
+     * @brief Open @p path, creating it with @p header if new
+     *
+     * Existing records are read into @p contents. Fails if another
+     * process has the journal open.
+     */
+    bool open(const QString &path, const QJsonObject &header, IngestionJournalContents &contents,
+              QString *error = nullptr);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString path() const { return m_path; }
+    QString vectorPath() const { return m_vectors.fileName(); }
+
+    /**
+     * @brief Vectors of a batch read by open(), rows of record.dimensions
+     *
+     * Points into a read-only map of the vector file; valid until reset()
+     * or close(). nullptr if the batch isn't in the file.
+     */
+    const float *vectors(const IngestedEmbeddings &record) const;
+
+    // Discard everything and start over with @p header (settings changed)
+    bool reset(const QJsonObject &header);
+
+    bool appendDirectory(const QString &path, const QStringList &files);
+    bool finishDirectory(const QString &path);
+    bool appendDocument(const IngestedDocument &document);
+
+    // The latest document record for @p path no longer counts
+    bool appendRemoval(const QString &path);
+
+    /**
+     * @brief Commit embeddings for @p chunks
+     *
+     * The vectors are written and fsync'd before the record that refers
+     * to them. All vectors must have the same width.
+     */
+    bool appendEmbeddings(const QVector<int> &chunks, const QVector<QVector<float>> &vectors);
+
+    // ~/.qtbot/rag/<name>.jsonl
+    static QString defaultPath(const QString &name);
+
+private:
+    bool appendRecord(const QJsonObject &record);
+    bool writeHeader(const QJsonObject &header);
+    bool read(IngestionJournalContents &contents);
+    void unmapVectors();
+
+    QFile m_file;
+    QFile m_vectors;
+    QString m_path;
+    std::unique_ptr<QLockFile> m_lock;
+    const uchar *m_map;    // Vector file as it was at open()
+    qint64 m_mapSize;
+};
+
+#endif // INGESTIONJOURNAL_H
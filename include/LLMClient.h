@@ -15,6 +15,9 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <functional>
+#include "MemoryGovernor.h"
+
+struct ConfigSnapshot;
 
 class LLMClient : public QObject {
     Q_OBJECT
@@ -48,11 +51,23 @@ public:
 
     // Model capabilities detection
     void queryModelCapabilities();
+    static QString detectToolCallFormat(const QJsonObject &modelInfo);  // "native" or "prompt"
     QString getToolCallFormat() const { return m_toolCallFormat; }
     QJsonObject getModelInfo() const { return m_modelInfo; }
 
+    /**
+     * @brief Seed capabilities detected elsewhere, skipping the /api/show round trip
+     *
+     * Used by long-running hosts (daemon mode) that detect capabilities once
+     * and create a short-lived client per request.
+     */
+    void setModelCapabilities(const QString &toolCallFormat, const QJsonObject &modelInfo);
+    bool hasModelCapabilities() const { return m_capabilitiesDetected; }
+
     // Conversation history management
     void clearConversationHistory();
+    void setConversationHistory(const QJsonArray &messages);
+    QJsonArray getConversationHistory() const { return m_messageHistory; }
 
 signals:
     // Emitted when a response is received
@@ -70,9 +85,15 @@ signals:
     // Emitted when the LLM wants to call a tool
     void toolCallRequested(const QString &toolName, const QJsonObject &parameters, const QString &callId);
 
+    // Emitted when a streamed turn ended with tool calls instead of an answer
+    void toolTurnFinished();
+
     // Emitted when model capabilities have been detected
     void modelCapabilitiesDetected(const QString &toolCallFormat, const QJsonObject &modelInfo);
 
+    // Emitted with the token counts reported in the final chunk of a stream
+    void generationStats(int promptTokens, int completionTokens, qint64 totalDurationMs);
+
 private slots:
     void handleNetworkReply(QNetworkReply *reply);
     void handleStreamingData();
@@ -81,10 +102,21 @@ private slots:
     void handleModelInfoReply();
 
 private:
+    // Microbenchmarks drive the streaming and context-window internals directly
+    friend class LLMClientBenchmark;
+
     QString buildOllamaRequest(const QString &prompt, const QString &context);
     QString buildOllamaRequestWithTools(const QString &prompt, const QJsonArray &tools, const QString &context);
     QString buildNativeToolRequest(const QString &prompt, const QJsonArray &tools, const QString &context);
     void sendRequest(const QString &jsonData);
+
+    // Model routing (see ModelRouter)
+    void sendAnswerTurn();                          // Main-model answer after a routed turn called no tool
+    void queryRoutedModelCapabilities();
+    void requestModelInfo(const QString &model);    // /api/show for the main or a routed model
+
+    // Add sampling options (temperature, top_p, ...) enabled in the snapshot
+    static void applyGenerationOptions(QJsonObject &json, const ConfigSnapshot &cfg);
     void processStreamingChunk(const QString &line);
     bool processToolCalls(const QString &response);
     bool processNativeToolCalls(const QJsonObject &message);
@@ -92,11 +124,16 @@ private:
 
     // Context window management
     int estimateTokens(const QString &text) const;
-    QJsonArray pruneMessageHistoryForContext(const QString &systemPrompt, const QString &currentUserMessage) const;
+    QJsonArray pruneMessageHistoryForContext(const QString &systemPrompt, const QString &currentUserMessage,
+                                             int contextWindowSize) const;
 
     QNetworkAccessManager *m_networkManager;
     QString m_apiUrl;
     QString m_model;
+    QString m_requestModel;    // Model of the request in flight (m_model unless routed)
+    QString m_requestFormat;   // Its tool calling format
+    bool m_routedToolTurn;     // Tool selection on the routed model; its text is not streamed
+    bool m_routedUserMessage;  // That turn added the user message to m_messageHistory
     QNetworkReply *m_currentReply;
     QString m_streamBuffer;
     QString m_fullResponse;
@@ -121,6 +158,10 @@ private:
     QJsonArray m_messageHistory;
     QString m_currentPrompt;
 
+    // Report the history's text to the memory governor; once per request
+    void accountHistory();
+    MemoryAccount m_historyMemory;
+
     // Request queuing (for waiting on capabilities detection)
     struct PendingRequest {
         QString prompt;
@@ -0,0 +1,184 @@
+/**
+ * LocalApiServer.h - OpenAI-compatible local HTTP API for daemon mode
+ *
+ * Keeps MCP tools, RAG index, and detected model capabilities warm in a
+ * long-running process and serves /v1/chat/completions (with SSE streaming),
+ * /v1/models, and /health to concurrent local clients.
+ */
+
+#ifndef LOCALAPISERVER_H
+#define LOCALAPISERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QHostAddress>
+#include "Config.h"
+
+class QTcpServer;
+class QTcpSocket;
+class LLMClient;
+class MCPHandler;
+class RAGEngine;
+class LocalApiServer;
+
+/**
+ * @brief Parsed HTTP/1.1 request
+ */
+struct ApiHttpRequest {
+    QByteArray method;
+    QByteArray path;
+    QMap<QByteArray, QByteArray> headers;  // Lower-cased header names
+    QByteArray body;
+};
+
+/**
+ * @brief One /v1/chat/completions request in flight
+ *
+ * Owns a short-lived LLMClient seeded with the server's cached model
+ * capabilities and the request's message history, so no per-request
+ * capability detection or tool discovery is needed. Tool calls are executed
+ * on the server's shared MCPHandler and routed back by call ID.
+ */
+class ChatCompletionSession : public QObject {
+    Q_OBJECT
+
+public:
+    ChatCompletionSession(LocalApiServer *server, QTcpSocket *socket,
+                          const QJsonObject &request, QObject *parent = nullptr);
+    ~ChatCompletionSession() override;
+
+    void start();
+
+    // Called by the server when a tool call dispatched by this session finishes
+    void handleToolCallCompleted(const QString &toolCallId, const QString &toolName, const QJsonObject &result);
+    void handleToolCallFailed(const QString &toolCallId, const QString &toolName, const QString &error);
+
+signals:
+    void finished();
+
+private slots:
+    void handleToken(const QString &token);
+    void handleResponse(const QString &response);
+    void handleError(const QString &error);
+    void handleToolCallRequest(const QString &toolName, const QJsonObject &parameters, const QString &callId);
+    void handleContextReady(int requestId, const QStringList &contexts);
+    void handleContextFailed(int requestId, const QString &error);
+    void handleSocketDisconnected();
+
+private:
+    void sendPrompt(const QString &prompt);
+    void writeStreamHeaders();
+    void writeChunk(const QJsonObject &delta, const QString &finishReason = QString());
+    void finish();
+
+    LocalApiServer *m_server;
+    QPointer<QTcpSocket> m_socket;
+    LLMClient *m_llmClient;
+
+    QString m_completionId;
+    QString m_model;
+    QString m_userPrompt;
+    QJsonArray m_history;
+    bool m_stream;
+    bool m_useTools;
+    bool m_headersSent;
+    bool m_finished;
+    int m_ragRequestId;
+    QString m_pendingText;   // Tokens held back while they may be a prompt-based tool call
+    QString m_streamedText;  // Content already sent to the client
+    qint64 m_created;
+};
+
+/**
+ * @brief Minimal HTTP server exposing the warm engines
+ *
+ * Endpoints:
+ * - GET  /health                 Status, model, tool and chunk counts
+ * - GET  /v1/models              OpenAI-style model list (configured model)
+ * - POST /v1/chat/completions    OpenAI-style chat; "stream": true uses SSE
+ *
+ * Each connection serves one request (Connection: close). Only loopback
+ * addresses should be used; there is no authentication.
+ */
+class LocalApiServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LocalApiServer(QObject *parent = nullptr);
+    ~LocalApiServer() override;
+
+    /**
+     * @brief Register tools, discover MCP servers, and detect model capabilities
+     */
+    void warmUp();
+
+    bool listen(const QHostAddress &address, quint16 port);
+    void close();
+    quint16 serverPort() const;
+
+    MCPHandler *mcpHandler() const { return m_mcpHandler; }
+    RAGEngine *ragEngine() const { return m_ragEngine; }
+    int activeSessionCount() const { return m_sessions.size(); }
+
+    // Capability cache (per model name), filled by warm-up and by sessions
+    bool cachedCapabilities(const QString &model, QString &toolCallFormat, QJsonObject &modelInfo) const;
+    void cacheCapabilities(const QString &model, const QString &toolCallFormat, const QJsonObject &modelInfo);
+
+    /**
+     * @brief Execute a tool on the shared MCPHandler on behalf of a session
+     * @return Tool call ID assigned by MCPHandler
+     */
+    QString dispatchToolCall(ChatCompletionSession *session, const QString &toolName, const QJsonObject &parameters);
+
+    // Helpers shared with sessions
+    static void writeJsonResponse(QTcpSocket *socket, int status, const QJsonObject &body);
+    static void writeError(QTcpSocket *socket, int status, const QString &message);
+
+signals:
+    void capabilitiesReady(const QString &model, const QString &toolCallFormat);
+
+private slots:
+    void handleNewConnection();
+    void handleReadyRead();
+    void handleToolCallCompleted(const QString &toolCallId, const QString &toolName, const QJsonObject &result);
+    void handleToolCallFailed(const QString &toolCallId, const QString &toolName, const QString &error);
+    void handleConfigChanged(Config::Sections sections);
+
+private:
+    enum ParseResult { ParseIncomplete, ParseComplete, ParseTooLarge };
+    ParseResult parseRequest(const QByteArray &buffer, ApiHttpRequest &request) const;
+    void routeRequest(QTcpSocket *socket, const ApiHttpRequest &request);
+    void handleHealth(QTcpSocket *socket);
+    void handleModels(QTcpSocket *socket);
+    void handleChatCompletions(QTcpSocket *socket, const ApiHttpRequest &request);
+    void registerLocalTools();
+    void registerConfiguredServers();
+    void applyRagSettings();
+    void detectCapabilities();
+
+    QTcpServer *m_tcpServer;
+    MCPHandler *m_mcpHandler;
+    RAGEngine *m_ragEngine;
+    LLMClient *m_probeClient;  // Used only for capability detection
+
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    QList<ChatCompletionSession*> m_sessions;
+
+    // Tool call routing: MCPHandler call ID -> owning session
+    QHash<QString, QPointer<ChatCompletionSession>> m_toolCallOwners;
+    ChatCompletionSession *m_dispatchingSession;  // Set while executeToolCall() runs
+
+    struct CapabilityInfo {
+        QString toolCallFormat;
+        QJsonObject modelInfo;
+    };
+    QHash<QString, CapabilityInfo> m_capabilities;
+};
+
+#endif // LOCALAPISERVER_H
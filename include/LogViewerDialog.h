@@ -15,6 +15,7 @@
 #include <QCheckBox>
 #include <QMutex>
 #include <QtGlobal>
+#include "MemoryGovernor.h"
 
 class LogViewerDialog : public QDialog {
     Q_OBJECT
@@ -43,6 +44,7 @@ private:
     QString getLogLevelColor(QtMsgType type);
     QString getLogLevelName(QtMsgType type);
     bool shouldShowMessage(QtMsgType type);
+    void trimLogs();  // Memory governor: keep only the newest lines
 
     QTextEdit *logTextEdit;
     QPushButton *clearButton;
@@ -54,6 +56,7 @@ private:
     bool autoScroll;
     bool m_isDestroying;  // Flag to prevent addLogMessage during destruction
     QMutex mutex;
+    MemoryAccount m_memory;
 
     static LogViewerDialog* s_instance;
 };
@@ -0,0 +1,161 @@
+/**
+ * MemoryGovernor.h - Process-wide memory budget and staged cache shedding
+ *
+ * Samples the process's resident memory and the sizes subsystems report
+ * through MemoryAccount, and when usage exceeds the configured budget asks
+ * registered owners to shed memory, cheapest to rebuild first.
+ */
+
+#ifndef MEMORYGOVERNOR_H
+#define MEMORYGOVERNOR_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QJsonObject>
+#include <atomic>
+#include <functional>
+
+class QTimer;
+class MemoryAccount;
+
+/**
+ * @brief Enforces memory_budget_mb (singleton)
+ *
+ * Every sample compares the anonymous resident memory (RSS minus file-backed
+ * pages, which the kernel can drop on its own) against the budget. Above it,
+ * one shedding stage runs per sample, in ShedStage order, so each stage gets
+ * a sample interval to take effect before the next, costlier one. Stages
+ * start over after the last one, and once usage falls back below the
+ * elevated threshold. Where RSS can't be read, the accounted total stands
+ * in for it.
+ *
+ * Accounts and shedders may be registered from any thread; shedders run on
+ * their owner's thread. The governor itself lives on the main thread.
+ */
+class MemoryGovernor : public QObject {
+    Q_OBJECT
+
+public:
+    // In the order they are shed
+    enum ShedStage {
+        RenderCaches,    // Undo stacks and log viewer contents
+        TranscriptHtml,  // Chat transcript beyond the latest page (reloaded from the journal)
+        Embeddings,      // RAG vectors spilled to a memory-mapped file
+        QueryCaches,     // Cached retrieval results
+        StageCount
+    };
+    Q_ENUM(ShedStage)
+
+    enum Pressure {
+        Normal,
+        Elevated,  // Above 80% of the budget
+        Over       // Above the budget: shedding
+    };
+    Q_ENUM(Pressure)
+
+    static MemoryGovernor& instance();
+
+    // 0 = unlimited (sampled and reported, never shed)
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_budget; }
+
+    // Sample every @p ms; call from the main thread
+    void start(int ms = 0);
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * @brief Run @p shed on @p owner's thread when @p stage is reached
+     *
+     * Forgotten when @p owner is destroyed.
+     */
+    void addShedder(ShedStage stage, QObject *owner, std::function<void()> shed);
+
+    // Last sample
+    qint64 residentBytes() const { return m_residentBytes; }
+    qint64 accountedBytes() const;
+    QMap<QString, qint64> subsystems() const;  // Accounted bytes by subsystem
+    Pressure pressure() const { return m_pressure; }
+    int shedCount() const { return m_shedCount; }
+
+    // Anonymous resident bytes of this process now; -1 where unsupported
+    static qint64 sampleResidentBytes();
+
+    static QString stageName(ShedStage stage);
+    static QString pressureName(Pressure pressure);
+
+    // "412 / 1024 MB"; just the usage without a budget
+    QString summary() const;
+    QJsonObject toJson() const;
+
+public slots:
+    // Sample now (the timer calls this)
+    void sample();
+
+signals:
+    void sampled();
+    void pressureChanged(MemoryGovernor::Pressure pressure);
+    void shedding(MemoryGovernor::ShedStage stage);
+
+private:
+    friend class MemoryAccount;
+
+    struct Shedder {
+        ShedStage stage;
+        QObject *owner;
+        std::function<void()> shed;
+    };
+
+    MemoryGovernor();
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    void registerAccount(MemoryAccount *account);
+    void unregisterAccount(MemoryAccount *account);
+    void removeShedders(QObject *owner);
+    int shedStage(ShedStage stage);
+
+    mutable QMutex m_mutex;  // Guards m_accounts and m_shedders
+    QList<MemoryAccount*> m_accounts;
+    QList<Shedder> m_shedders;
+
+    QTimer *m_timer;
+    std::atomic<qint64> m_budget;
+    std::atomic<qint64> m_residentBytes;
+    Pressure m_pressure;
+    int m_nextStage;   // Stage to shed on the next sample over budget
+    bool m_exhausted;  // Every stage has run this episode (warned once)
+    bool m_trimPending;
+    int m_shedCount;   // Stages run since start, for metrics
+};
+
+/**
+ * @brief Bytes held by one subsystem instance, reported to the governor
+ *
+ * Instances with the same name add up (e.g. one "history" per LLMClient).
+ * set() is a relaxed atomic store, cheap enough to call on every change.
+ *
+ *   MemoryAccount m_account{"rag_index"};
+ *   m_account.set(m_index.memoryBytes());
+ */
+class MemoryAccount {
+public:
+    explicit MemoryAccount(const QString &subsystem);
+    ~MemoryAccount();
+
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    void set(qint64 bytes) { m_bytes.store(bytes, std::memory_order_relaxed); }
+    qint64 bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+    QString subsystem() const { return m_subsystem; }
+
+private:
+    QString m_subsystem;
+    std::atomic<qint64> m_bytes;
+};
+
+#endif // MEMORYGOVERNOR_H
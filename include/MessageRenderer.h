@@ -10,9 +10,19 @@
 
 #include <QObject>
 #include <QString>
+#include <QList>
 
 class QTextEdit;
 
+/**
+ * @brief One restored chat entry (empty sender = raw HTML block)
+ */
+struct ChatEntry {
+    QString sender;
+    QString message;
+    QString timestamp;
+};
+
 /**
  * @brief Manages chat display and message formatting
  * 
@@ -33,6 +43,11 @@ public:
     // Message operations
     void appendMessage(const QString &sender, const QString &message);
     void updateLastMessage(const QString &message, bool isStreaming = false);
+
+    // Restored history: bulk append, or insert above the current content
+    // keeping the visible position (neither emits messageAppended)
+    void appendEntries(const QList<ChatEntry> &entries);
+    void prependEntries(const QList<ChatEntry> &entries);
     void clear();
 
     // Content access
@@ -55,6 +70,7 @@ private:
 
     // Helper methods
     void autoScrollToBottom();
+    static QString formatMessage(const QString &sender, const QString &message, const QString &timestamp);
 };
 
 #endif // MESSAGERENDERER_H
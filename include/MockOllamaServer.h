@@ -0,0 +1,127 @@
+/**
+ * MockOllamaServer.h - Local stand-in for the Ollama HTTP API
+ *
+ * Serves /api/generate, /api/chat, /api/show and the embedding endpoints
+ * (/api/embeddings, batched /api/embed and OpenAI-style /v1/embeddings)
+ * with synthetic output at a configurable pace, so client-side costs
+ * (parsing, signal delivery, rendering) can be measured without a real model.
+ */
+
+#ifndef MOCKOLLAMASERVER_H
+#define MOCKOLLAMASERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHostAddress>
+#include <QElapsedTimer>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+/**
+ * @brief Behaviour of the mock backend
+ */
+struct MockOllamaOptions {
+    int responseTokens;       // Tokens per generated response
+    int tokensPerSecond;      // Pacing; 0 = as fast as possible
+    int tokensPerChunk;       // Tokens per NDJSON line
+    int firstTokenDelayMs;    // Delay before the first chunk
+    QString toolCallName;     // Call this tool when the request offers tools (empty = never)
+    QJsonObject toolCallArguments;
+    bool nativeTools;         // /api/show advertises native tool calling
+    int embeddingDimensions;
+    int embeddingDelayMs;     // Delay before answering an embedding request
+    bool batchEmbeddings;     // Serve /api/embed (false = 404, like Ollama before 0.3)
+
+    MockOllamaOptions()
+        : responseTokens(200)
+        , tokensPerSecond(0)
+        , tokensPerChunk(1)
+        , firstTokenDelayMs(0)
+        , nativeTools(false)
+        , embeddingDimensions(768)
+        , embeddingDelayMs(0)
+        , batchEmbeddings(true) {}
+};
+
+/**
+ * @brief Minimal Ollama-compatible HTTP server
+ *
+ * Streaming responses use chunked transfer encoding with one NDJSON object
+ * per chunk, ending with a "done" object carrying token counts like Ollama.
+ * A request "offers tools" when /api/chat carries a non-empty "tools" array
+ * or an /api/generate prompt mentions the configured tool name; follow-up
+ * requests carrying tool results get a normal text answer.
+ */
+class MockOllamaServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MockOllamaServer(const MockOllamaOptions &options = MockOllamaOptions(), QObject *parent = nullptr);
+    ~MockOllamaServer() override;
+
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 0);
+    void close();
+    quint16 serverPort() const;
+
+    // Base URL for LLMClient::setApiUrl (".../api/generate")
+    QString generateUrl() const;
+
+    void setOptions(const MockOllamaOptions &options) { m_options = options; }
+    MockOllamaOptions options() const { return m_options; }
+
+    int requestCount() const { return m_requestCount; }
+    qint64 tokensSent() const { return m_tokensSent; }
+    // "model" of each generation request, in arrival order
+    QStringList requestedModels() const { return m_requestedModels; }
+    // Body of each generation request, in arrival order
+    QList<QJsonObject> generationRequests() const { return m_generationRequests; }
+    // Time from each streamed request to its first chunk, as the server measured it
+    QList<qint64> firstChunkDelays() const { return m_firstChunkDelays; }
+
+private slots:
+    void handleNewConnection();
+    void handleReadyRead();
+
+private:
+    struct Stream {
+        QTcpSocket *socket;
+        QTimer *timer;
+        bool chat;            // /api/chat vs /api/generate message shape
+        int tokensRemaining;
+        int tokenIndex;       // Tokens written so far
+        qint64 startedMs;
+        qint64 firstChunkMs;  // -1 until the first chunk is written
+        QElapsedTimer sinceRequest;
+    };
+
+    void routeRequest(QTcpSocket *socket, const QByteArray &path, const QByteArray &body);
+    void handleShow(QTcpSocket *socket);
+    void handleEmbeddings(QTcpSocket *socket, const QByteArray &path, const QJsonObject &request);
+    void handleGeneration(QTcpSocket *socket, bool chat, const QJsonObject &request, const QByteArray &rawBody);
+    void writeNextChunk(QTcpSocket *socket);
+    void finishStream(QTcpSocket *socket);
+
+    static void writeJson(QTcpSocket *socket, int status, const QJsonObject &body);
+    QJsonArray mockEmbedding(const QString &text) const;
+    static void writeStreamHeaders(QTcpSocket *socket);
+    static void writeStreamChunk(QTcpSocket *socket, const QJsonObject &obj);
+
+    MockOllamaOptions m_options;
+    QTcpServer *m_tcpServer;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    QHash<QTcpSocket*, Stream> m_streams;
+    int m_requestCount;
+    qint64 m_tokensSent;
+    QStringList m_requestedModels;
+    QList<QJsonObject> m_generationRequests;
+    QList<qint64> m_firstChunkDelays;
+};
+
+#endif // MOCKOLLAMASERVER_H
@@ -0,0 +1,76 @@
+/**
+ * ModelRouter.h - Per-role model selection
+ *
+ * Maps each kind of model request to a configured model, so cheap turns
+ * (deciding whether a tool is needed, extracting its arguments,
+ * summarizing, rewriting retrieval queries) can run on a small fast model
+ * while user-facing answers stay on the main model. Also remembers the
+ * tool-calling format detected for each model, shared by all clients.
+ */
+
+#ifndef MODELROUTER_H
+#define MODELROUTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+
+struct ConfigSnapshot;
+
+/**
+ * @brief What a model request is for
+ */
+enum class ModelRole {
+    Answer,          // User-facing generation (always the main model)
+    ToolSelection,   // Pick a tool and extract its arguments
+    Summarization,
+    QueryRewrite     // Rewrite a question into a retrieval query
+};
+
+/**
+ * @brief Resolves models per role and caches tool-call formats per model
+ *
+ * Resolution: the role's own setting (tool_model, summary_model,
+ * query_rewrite_model), then fast_model, then the main model. With none
+ * of them configured every role uses the main model, as before routing.
+ */
+class ModelRouter {
+public:
+    static ModelRouter& instance();
+
+    /**
+     * @brief Model to use for @p role
+     * @param mainModel Main model; empty = the snapshot's model
+     */
+    static QString modelFor(ModelRole role, const ConfigSnapshot &cfg, const QString &mainModel = QString());
+
+    // Distinct non-main models the snapshot routes any role to
+    static QStringList routedModels(const ConfigSnapshot &cfg, const QString &mainModel = QString());
+
+    static QString roleName(ModelRole role);
+
+    // Tool-call format ("native"/"prompt") detected for a model on a backend; empty if unknown
+    QString toolCallFormat(const QString &apiUrl, const QString &model) const;
+    void setToolCallFormat(const QString &apiUrl, const QString &model, const QString &format);
+
+    // Claim the capability query for a model; false if one is already in flight or done
+    bool beginCapabilityQuery(const QString &apiUrl, const QString &model);
+    void endCapabilityQuery(const QString &apiUrl, const QString &model);
+
+    void clear();
+
+private:
+    ModelRouter() = default;
+    ModelRouter(const ModelRouter&) = delete;
+    ModelRouter& operator=(const ModelRouter&) = delete;
+
+    static QString key(const QString &apiUrl, const QString &model);
+
+    // Clients live on several threads (GUI, engine thread, batch workers)
+    mutable QMutex m_mutex;
+    QHash<QString, QString> m_formats;
+    QHash<QString, bool> m_queries;
+};
+
+#endif // MODELROUTER_H
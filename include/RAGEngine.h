@@ -1,8 +1,10 @@
 /**
  * RAGEngine.h - Document indexing and retrieval engine
  * 
- * Handles document ingestion, chunking, embedding generation via Ollama,
- * vector similarity search, and document metadata management.
+ * Handles document ingestion, chunking, embedding generation through a
+ * pluggable EmbeddingProvider, vector similarity search, and document
+ * metadata management. Ingestion can be journaled to disk so it survives
+ * a restart.
  */
 
 #ifndef RAGENGINE_H
@@ -13,21 +15,24 @@
 #include <QStringList>
 #include <QVector>
 #include <QMap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <memory>
+#include <QHash>
+#include <QElapsedTimer>
+#include <atomic>
+#include "VectorIndex.h"
+#include "MemoryGovernor.h"
+#include "IngestionJournal.h"
+#include "Tokenizer.h"
 
-// Forward declare FAISS index type to avoid header dependency
-namespace faiss {
-    struct IndexFlatL2;
-}
+class EmbeddingProvider;
+class QFileInfo;
 
 // Document chunk structure
 struct DocumentChunk {
-    QString text;
+    QString text;  // Empty once the document was re-chunked; the slot stays until the next compaction
     QString sourceFile;
     int chunkIndex;
     QString metadata;
+    int tokenCount;  // By the engine's tokenizer, without the model's special tokens
 };
 
 class RAGEngine : public QObject {
@@ -45,64 +50,245 @@ public:
     // Context retrieval
     QStringList retrieveContext(const QString &query, int topK = 3);
 
-    // Statistics
-    int getDocumentCount() const { return m_documents.size(); }
-    int getChunkCount() const { return m_chunks.size(); }
-    int getEmbeddingDimension() const { return m_embeddingDimension; }
+    /**
+     * @brief Start a retrieval whose result is tagged with a request ID
+     *
+     * Lets several callers share one engine concurrently: the result is
+     * delivered via contextReady()/contextFailed() with the returned ID
+     * instead of the untagged contextRetrieved()/queryError() signals.
+     *
+     * @return Request ID (always > 0)
+     */
+    int requestContext(const QString &query, int topK = 3);
+
+    /**
+     * @brief Abandon a requestContext() retrieval
+     *
+     * If its query embedding is still in flight it is aborted, and neither
+     * contextReady() nor contextFailed() is emitted for it.
+     */
+    void cancelRequest(int requestId);
+
+    // Statistics; safe to read from any thread while the engine runs on another
+    int getDocumentCount() const { return m_documentCount; }
+    int getChunkCount() const { return m_chunkCount; }
+    int getEmbeddingDimension() const { return m_dimensionCount; }
+    int getPendingEmbeddingCount() const { return m_pendingCount; }
 
     // Configuration
     void setEmbeddingModel(const QString &modelName);
     void setChunkSize(int size);
     void setChunkOverlap(int overlap);
+
+    /**
+     * @brief Size chunks in tokens of the embedding model instead of characters
+     *
+     * @param tokens Most tokens per chunk; 0 = setChunkSize() characters.
+     * Leave room for the special tokens the model adds to each input (two
+     * for BERT-style models). The overlap stays in characters.
+     */
+    void setChunkTokens(int tokens);
+    int chunkTokens() const { return m_chunkTokens; }
+
+    /**
+     * @brief Count tokens with the vocabulary in @p path (see Tokenizer)
+     *
+     * Empty = Tokenizer::defaultPath() of the embedding model if that file
+     * exists, otherwise an estimate. The stored counts of ingested chunks
+     * are redone; their chunking isn't.
+     */
+    void setTokenizer(const QString &path);
+    QString tokenizer() const { return m_tokenizer.name(); }
+
+    // Tokens in @p text: the stored count for an ingested chunk, otherwise counted now (engine's thread)
+    int countTokens(const QString &text) const;
+
+    // Endpoint of the current embedding provider (empty = its default)
     void setApiUrl(const QString &url);
 
+    /**
+     * @brief Choose where embeddings come from
+     *
+     * @param type "ollama", "openai" or "local" (see EmbeddingProvider)
+     * Switching to a different provider re-embeds every ingested chunk,
+     * since vectors from different models can't share an index.
+     */
+    void setEmbeddingProvider(const QString &type, const QString &url = QString(), const QString &apiKey = QString());
+    QString embeddingProvider() const;
+
+    /**
+     * @brief Store vectors narrower than the model returns them
+     *
+     * @param method "truncate" (Matryoshka models) or "pca" (see VectorIndex)
+     * @param dimensions Stored width; 0 = full width
+     * A change re-embeds every ingested chunk, since full-width vectors
+     * aren't kept.
+     */
+    void setDimensionReduction(const QString &method, int dimensions);
+
+    /**
+     * @brief Bound the wait for a query embedding
+     *
+     * When @p ms pass without an embedding, the retrieval is answered with
+     * lexical matches instead (or no context if nothing matches); the late
+     * vector result is logged and cached, not delivered. 0 = wait forever.
+     */
+    void setRetrievalDeadline(int ms);
+    int retrievalDeadline() const { return m_retrievalDeadlineMs; }
+
+    /**
+     * @brief Journal ingestion to @p path and restore what it holds
+     *
+     * Documents and committed embeddings in the journal are loaded without
+     * reading or embedding them again; chunks whose embeddings were still
+     * in flight are queued again, and an unfinished ingestDirectory()
+     * continues with the files it hadn't reached. Vectors are reused only
+     * if the journal was written with the current provider and model.
+     * An empty @p path stops journaling.
+     *
+     * @return false if the journal can't be opened (e.g. another process has it)
+     */
+    bool setIngestionJournal(const QString &path);
+    QString ingestionJournal() const { return m_journal.path(); }
+
 signals:
     void documentIngested(const QString &filePath, int chunkCount);
     void ingestionProgress(int current, int total);
     void ingestionError(const QString &filePath, const QString &error);
     void contextRetrieved(const QStringList &contexts);
+    void contextReady(int requestId, const QStringList &contexts);
+    void contextFailed(int requestId, const QString &error);
     void embeddingGenerated(int chunkIndex);
     void queryError(const QString &error);
 
+    // A retrieval was answered without vector search; @p reason says why
+    void retrievalDegraded(int requestId, const QString &reason);
+
+    // The vector search behind a degraded answer ended: its result was cached, or it was given up on
+    void lateRetrievalFinished(int requestId, bool cached);
+
+    // setIngestionJournal() restored documents; @p pendingCount chunks are being embedded again
+    void ingestionResumed(int documentCount, int chunkCount, int pendingCount);
+
 private:
-    // Document processing
-    QString readTextFile(const QString &filePath);
-    QString readMarkdownFile(const QString &filePath);
-    QString readPDFFile(const QString &filePath);
-    QString readDOCXFile(const QString &filePath);
+    // Microbenchmarks drive chunking and similarity search directly
+    friend class RAGEngineBenchmark;
+
+    // Document processing; @p data is the file's bytes when already read
+    QString readTextFile(const QString &filePath, const QByteArray *data = nullptr);
+    QString readMarkdownFile(const QString &filePath, const QByteArray *data = nullptr);
+    QString readPDFFile(const QString &filePath, const QByteArray *data = nullptr);
+    QString readDOCXFile(const QString &filePath, const QByteArray *data = nullptr);
+    QString readODTFile(const QString &filePath, const QByteArray *data = nullptr);
     QString runCommandLineExtractor(const QString &command, const QStringList &args, const QString &filePath);
     QStringList chunkText(const QString &text, const QString &sourceFile);
+    QStringList chunkTextByTokens(const QString &text, const QString &sourceFile);
+    void appendChunk(const QString &text, const QString &sourceFile, int chunkIndex, int tokenCount);
+    int ingestFiles(const QStringList &files);
+    bool ingestDocumentContent(const QString &filePath, const QByteArray *data);
+    static QPair<qint64, qint64> documentStamp(const QFileInfo &fileInfo);
+    bool isUnchanged(const QString &filePath, const QPair<qint64, qint64> &stamp) const;
+
+    // Drop a document's chunks, terms and vectors; its chunk indices stay taken until compactChunks()
+    void removeDocumentChunks(const QString &filePath);
+    void compactChunks();
+
+    // Journal: rebuild from its contents, or rewrite it from the current chunks
+    QJsonObject journalHeader() const;
+    void replayJournal(const IngestionJournalContents &contents);
+    void restartJournal();
+
+    // Resolve the configured or default tokenizer; recount stored chunks if it changed
+    void loadTokenizer();
+    void recountTokens();
+
+    // Embedding generation, in provider-sized batches of consecutive chunks
+    void installProvider(EmbeddingProvider *provider);
+    void reembedChunks();
+    void generateEmbeddings(int firstChunk, const QStringList &texts);
+    void handleEmbeddingsReady(int ticket, const QVector<QVector<float>> &vectors);
+    void handleEmbeddingFailed(int ticket, const QString &error);
+
+    // Query embedding generation (requestId 0 = untagged retrieveContext() call)
+    void generateQueryEmbedding(const QString &query, int topK, int requestId);
+    void handleQueryEmbedding(int ticket, const QVector<float> &queryEmbedding);
+    void handleQueryEmbeddingFailed(int ticket, const QString &error);
+    void handleQueryDeadline(int ticket);
+    void abandonLateQuery(int ticket);
+    void emitContext(int requestId, const QStringList &contexts);
+
+    // Answer a retrieval from the lexical index when vector search can't
+    void emitDegradedContext(int requestId, const QString &query, int topK, const QString &reason);
 
-    // Embedding generation
-    void generateEmbedding(const QString &text, int chunkIndex);
-    void handleEmbeddingResponse(QNetworkReply *reply, int chunkIndex);
+    // Recent vector results by query, so repeated questions skip the embedding
+    bool deliverCachedContext(const QString &query, int topK, int requestId);
+    void cacheContext(const QString &query, int topK, const QStringList &contexts);
+    void clearContextCache();
 
-    // Query embedding generation
-    void generateQueryEmbedding(const QString &query, int topK);
-    void handleQueryEmbeddingResponse(QNetworkReply *reply, int topK);
+    // Lexical fallback: terms of each chunk, scored by inverse document frequency
+    static QStringList lexicalTerms(const QString &text);
+    void indexChunkTerms(int chunkIndex);
+    QVector<int> searchLexical(const QString &query, int topK) const;
 
     // Vector operations
-    void addEmbeddingToIndex(const QVector<float> &embedding, int chunkIndex);
+    bool addEmbeddingToIndex(const QVector<float> &embedding, int chunkIndex);
     QVector<int> searchSimilar(const QVector<float> &queryEmbedding, int topK);
 
+    // Copy container sizes into the counters the getters read
+    void publishStatistics();
+
     // Configuration
     QString m_embeddingModel;
-    QString m_apiUrl;
     int m_chunkSize;
     int m_chunkOverlap;
-    int m_embeddingDimension;
+    int m_chunkTokens;         // 0 = chunk by characters
+    QString m_tokenizerPath;   // Empty = the model's default, if present
+    Tokenizer m_tokenizer;
+    int m_embeddingDimension;  // As the model returns them, before any reduction
 
     // Data storage
     QVector<DocumentChunk> m_chunks;
+    int m_removedChunks;             // Emptied by removeDocumentChunks(), not yet compacted
     QMap<QString, int> m_documents;  // filename -> chunk count
-    QVector<QVector<float>> m_embeddings;
+    QHash<QString, QPair<qint64, qint64>> m_documentStamps;  // filename -> (size, modified ms) when chunked
+    QHash<QString, int> m_tokenCounts;  // Chunk text -> tokens, for countTokens()
+
+    // Chunks and committed embeddings on disk, for resuming after a restart
+    IngestionJournal m_journal;
+
+    // Normalized (and possibly reduced) chunk vectors for similarity search
+    VectorIndex m_index;
+    QVector<int> m_indexChunks;  // Index position -> chunk; embeddings arrive in any order
+
+    // Embedding provider and its calls in flight
+    EmbeddingProvider *m_provider;
+    QMap<int, QString> m_pendingEmbeddings;      // chunkIndex -> text
+    QHash<int, QPair<int, int>> m_chunkTickets;  // provider ticket -> (first chunk, chunk count)
+    int m_nextRequestId;
+    QHash<int, int> m_queryTickets;              // requestContext() ID -> provider ticket
+
+    // Query embeddings in flight, by provider ticket
+    struct PendingQuery {
+        QString query;
+        int topK;
+        int requestId;
+        QElapsedTimer timer;
+        bool answered;  // Deadline passed and a fallback was delivered
+    };
+    QHash<int, PendingQuery> m_pendingQueries;
+    int m_retrievalDeadlineMs;
+
+    QHash<QString, QStringList> m_contextCache;  // normalized query + top K -> contexts
+    QStringList m_contextCacheOrder;             // Oldest first, for eviction
 
-    // FAISS index for similarity search
-    std::unique_ptr<faiss::IndexFlatL2> m_index;
+    QHash<QString, QVector<int>> m_termIndex;    // term -> chunks containing it
 
-    // Network
-    QNetworkAccessManager *m_networkManager;
-    QMap<int, QString> m_pendingEmbeddings;  // chunkIndex -> text
+    // Published by publishStatistics() on the engine's thread
+    std::atomic<int> m_documentCount;
+    std::atomic<int> m_chunkCount;
+    std::atomic<int> m_dimensionCount;
+    std::atomic<int> m_pendingCount;
+    MemoryAccount m_indexMemory;  // Heap held by m_index
 };
 
 #endif // RAGENGINE_H
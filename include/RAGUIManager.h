@@ -2,7 +2,8 @@
  * RAGUIManager.h - RAG document management UI manager
  * 
  * Handles document/directory ingestion dialogs, document list viewing,
- * and clear operations. Emits signals for ingestion events.
+ * and clear operations. Emits signals for ingestion events once the
+ * engine has finished them.
  */
 
 #ifndef RAGUIMANAGER_H
@@ -44,7 +45,11 @@ signals:
     void statusUpdated();
 
 private:
-    RAGEngine *ragEngine;
+    // Results of ingestion queued to the engine, back on this object's thread
+    void finishDocumentIngestion(const QString &fileName, bool ok);
+    void finishDirectoryIngestion(const QString &dirPath, bool ok);
+
+    RAGEngine *ragEngine;  // Owned elsewhere; may live on another thread
     QWidget *parentWidget;
 };
 
@@ -95,6 +95,9 @@ private slots:
     void handleError(QNetworkReply::NetworkError error);
 
 private:
+    // Microbenchmarks drive the event parser directly
+    friend class SSEClientBenchmark;
+
     void parseSSEData(const QByteArray &data);
     void processSSEEvent(const SSEEvent &event);
     void resetEventBuffer();
@@ -58,12 +58,14 @@ private:
     void fetchOllamaModels(bool silentMode = false);
     void fetchLemonadeModels(bool silentMode = false);
     void updateMcpServerList();
+    void syncFastModelItems();  // Offer the fetched models for the fast model too
 
     // Backend settings
     QComboBox *backendCombo;
     QLineEdit *apiUrlEdit;
     QLineEdit *apiKeyEdit;
     QComboBox *modelCombo;
+    QComboBox *fastModelCombo;
     QPushButton *refreshModelsButton;
     QTextEdit *systemPromptEdit;
 
@@ -81,11 +83,23 @@ private:
 
     // RAG settings
     QCheckBox *ragEnabledCheckbox;
+    QComboBox *ragEmbeddingProviderCombo;
+    QLineEdit *ragEmbeddingUrlEdit;
     QComboBox *ragEmbeddingModelCombo;
+    QSpinBox *ragDimensionsSpinBox;
+    QComboBox *ragReductionCombo;
     QPushButton *refreshEmbeddingModelsButton;
     QSpinBox *ragChunkSizeSpinBox;
     QSpinBox *ragChunkOverlapSpinBox;
+    QSpinBox *ragChunkTokensSpinBox;
+    QLineEdit *ragTokenizerEdit;
     QSpinBox *ragTopKSpinBox;
+    QCheckBox *ragSpeculativeCheckbox;
+    QSpinBox *ragDeadlineSpinBox;
+    QCheckBox *ragJournalCheckbox;
+
+    // Memory settings
+    QSpinBox *memoryBudgetSpinBox;
 
     // MCP server settings
     QListWidget *mcpServerList;
@@ -0,0 +1,122 @@
+/**
+ * SpeculativeRetriever.h - RAG retrieval started while the user is typing
+ *
+ * Embeds and searches the message being typed once input pauses, so the
+ * context is often ready by the time the message is sent. A send whose
+ * text matches the speculated query reuses that retrieval instead of
+ * starting a new one; stale speculations are cancelled on the engine.
+ */
+
+#ifndef SPECULATIVERETRIEVER_H
+#define SPECULATIVERETRIEVER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+
+class QTimer;
+class RAGEngine;
+
+/**
+ * @brief Debounced speculative retrieval in front of a RAGEngine
+ *
+ * Lives on the GUI thread; the engine may live on another thread and is
+ * only called through queued invocations. Every retrieval made for a send
+ * goes through retrieve(), which answers from the speculation when the
+ * final text is a close match and falls back to a fresh request otherwise.
+ */
+class SpeculativeRetriever : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SpeculativeRetriever(RAGEngine *engine, QObject *parent = nullptr);
+
+    // Pause in typing before a speculation starts
+    void setDebounceInterval(int ms);
+    int debounceInterval() const;
+
+    /**
+     * @brief The input text changed
+     *
+     * Restarts the debounce timer; when it fires, @p text is retrieved
+     * unless the current speculation already matches it.
+     */
+    void speculate(const QString &text, int topK);
+
+    /**
+     * @brief Retrieve context for a message being sent
+     *
+     * Emits contextReady() at once if a matching speculation has finished,
+     * waits for it if it is still running, and starts a new retrieval if
+     * nothing matches.
+     */
+    void retrieve(const QString &query, int topK);
+
+    // Drop speculations made against an outdated index (documents or embedding model changed)
+    void invalidate();
+
+    // Finished speculation waiting to be reused, if any
+    bool hasSpeculation() const { return m_state == Ready && !m_final; }
+    QString speculatedQuery() const { return m_query; }
+
+    int hits() const { return m_hits; }
+    int misses() const { return m_misses; }
+
+    // Lowercased words without punctuation, single-spaced
+    static QString normalize(const QString &text);
+
+    // Same words, or word sets that mostly overlap (at least 80%)
+    static bool isCloseMatch(const QString &speculated, const QString &final);
+
+signals:
+    /**
+     * @brief Context for the last retrieve() call is available
+     * @param speculative True if it came from a speculation started before the send
+     */
+    void contextReady(const QStringList &contexts, bool speculative);
+    void retrievalFailed(const QString &error);
+
+private slots:
+    void startSpeculation();
+    void handleContextReady(int requestId, const QStringList &contexts);
+    void handleContextFailed(int requestId, const QString &error);
+    void handleRetrievalDegraded(int requestId);
+
+private:
+    enum State {
+        Idle,
+        Pending,  // Sent to the engine, no result yet
+        Ready,
+        Failed
+    };
+
+    void startRequest(const QString &query, int topK, bool speculative);
+    void handleRequestStarted(int serial, int requestId);
+    void cancelCurrent();
+    void deliver();  // Hand the current result to the waiting retrieve()
+
+    RAGEngine *m_engine;
+    QTimer *m_debounceTimer;
+    QString m_typedText;  // Text to speculate on when the timer fires
+    int m_typedTopK;
+
+    // The one retrieval in flight or kept for reuse
+    State m_state;
+    QString m_query;
+    int m_topK;
+    int m_serial;         // Incremented per request; tells stale engine replies apart
+    int m_requestId;      // Engine request ID, 0 until the engine has assigned it
+    bool m_speculative;   // Started from typing rather than by retrieve()
+    bool m_final;         // retrieve() is waiting for this request
+    bool m_degraded;      // Answered without vector search (deadline or embedding error)
+    QStringList m_contexts;
+    QString m_error;
+    QElapsedTimer m_requestTimer;
+    qint64 m_requestMs;   // Duration of the finished request
+
+    int m_hits;
+    int m_misses;
+};
+
+#endif // SPECULATIVERETRIEVER_H
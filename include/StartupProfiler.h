@@ -0,0 +1,107 @@
+/**
+ * StartupProfiler.h - Wall-time profile of application startup phases
+ *
+ * Records how long each initialization phase takes from the top of main()
+ * until the window first paints and the event loop is idle (interactive).
+ * Phases are always recorded (the cost is one timer read per phase); the
+ * report is printed only with --startup-profile.
+ */
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+// Time-to-interactive budget the report is checked against
+#define STARTUP_TARGET_MS 150
+
+/**
+ * @brief Process-wide startup phase recorder (singleton)
+ */
+class StartupProfiler : public QObject {
+    Q_OBJECT
+
+public:
+    struct Phase {
+        QString name;
+        int depth;          // Nesting level (0 = top-level phase)
+        double startMs;     // Offset from start()
+        double durationMs;
+        bool deferred;      // Ran after the window became interactive
+    };
+
+    static StartupProfiler& instance();
+
+    // Start the clock; call first thing in main()
+    void start();
+
+    // Print the report (and deferred phases) to stderr
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+
+    // Phase bracketing; prefer StartupPhase for scoped phases
+    int beginPhase(const QString &name);
+    void endPhase(int index);
+
+    double elapsedMs() const;
+
+    /**
+     * @brief Finish when @p window gets its first paint and the event loop is idle
+     *
+     * Records "first paint" and "interactive", then reports.
+     */
+    void finishOnFirstPaint(QObject *window);
+
+    // Finish now (headless binaries have no window)
+    void finish(const QString &milestone);
+
+    bool isFinished() const { return m_finished; }
+    double firstPaintMs() const { return m_firstPaintMs; }
+    double timeToInteractiveMs() const { return m_interactiveMs; }
+    QList<Phase> phases() const { return m_phases; }
+
+    QString report() const;
+    QJsonObject toJson() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    StartupProfiler();
+    StartupProfiler(const StartupProfiler&) = delete;
+    StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+    QElapsedTimer m_clock;
+    QList<Phase> m_phases;
+    int m_depth;
+    bool m_enabled;
+    bool m_finished;
+    double m_interactiveMs;
+    double m_firstPaintMs;
+    QString m_milestone;
+    QObject *m_watchedWindow;
+};
+
+/**
+ * @brief Scoped phase: records from construction to destruction
+ *
+ *   { StartupPhase phase("ChatWindow: menus"); createMenuBar(); }
+ */
+class StartupPhase {
+public:
+    explicit StartupPhase(const QString &name)
+        : m_index(StartupProfiler::instance().beginPhase(name)) {}
+    ~StartupPhase() { StartupProfiler::instance().endPhase(m_index); }
+
+    StartupPhase(const StartupPhase&) = delete;
+    StartupPhase& operator=(const StartupPhase&) = delete;
+
+private:
+    int m_index;
+};
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,202 @@
+/**
+ * StreamTrace.h - Record and replay backend response streams
+ *
+ * Captures the raw bytes of every HTTP exchange made by LLMClient and
+ * SSEClient, with arrival timestamps, to a JSONL trace. A replay transport
+ * feeds a trace back at recorded or accelerated speed without a network,
+ * so the exact chunk boundaries and burstiness of real streams can be
+ * pushed through the parsers and renderer reproducibly.
+ */
+
+#ifndef STREAMTRACE_H
+#define STREAMTRACE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QUrl>
+#include <QJsonObject>
+#include <QMutex>
+#include <QFile>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+/**
+ * @brief One recorded request/response exchange
+ */
+struct StreamTraceExchange {
+    struct Chunk {
+        double timeMs;      // Arrival time relative to the request
+        QByteArray data;
+    };
+
+    QString method;
+    QString path;           // URL path, used to match replayed requests
+    int httpStatus;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    QList<Chunk> chunks;
+    double endMs;
+    int error;              // QNetworkReply::NetworkError
+    QString errorString;
+
+    StreamTraceExchange() : httpStatus(0), endMs(0.0), error(0) {}
+};
+
+/**
+ * @brief Process-wide trace recorder/replayer (singleton)
+ *
+ * Trace file format (one JSON object per line):
+ *   {"type":"trace","version":1}
+ *   {"type":"request","id":1,"method":"POST","url":"...","t_ms":0}
+ *   {"type":"response","id":1,"t_ms":3.1,"status":200,"headers":{...}}
+ *   {"type":"data","id":1,"t_ms":12.5,"data":"<base64>"}
+ *   {"type":"end","id":1,"t_ms":40.2,"error":0,"error_string":""}
+ *
+ * Replayed requests are matched by method and URL path in recorded order;
+ * once a path's exchanges are used up they are replayed again from the
+ * start, so one trace can drive any number of benchmark iterations.
+ */
+class StreamTrace {
+public:
+    enum Mode { Off, Record, Replay };
+
+    static StreamTrace& instance();
+
+    bool startRecording(const QString &path);
+    bool startReplay(const QString &path, double speed = 1.0);
+    void stop();
+
+    Mode mode() const { return m_mode; }
+    bool isRecording() const { return m_mode == Record; }
+    bool isReplaying() const { return m_mode == Replay; }
+    QString tracePath() const { return m_path; }
+
+    // 0 = as fast as possible (chunk boundaries are kept)
+    double replaySpeed() const { return m_speed; }
+
+    /**
+     * @brief Network manager for LLMClient/SSEClient honoring the current mode
+     *
+     * Returns a plain QNetworkAccessManager when tracing is off.
+     */
+    QNetworkAccessManager *createNetworkManager(QObject *parent = nullptr);
+
+    // Loading and parsing (also used by tests and perf harnesses)
+    static bool loadTrace(const QString &path, QList<StreamTraceExchange> &exchanges, QString *errorMessage = nullptr);
+
+    // Recorder side (called by RecordingNetworkReply)
+    int beginExchange(const QString &method, const QUrl &url);
+    void recordResponse(int id, double timeMs, int status, const QList<QPair<QByteArray, QByteArray>> &headers);
+    void recordData(int id, double timeMs, const QByteArray &data);
+    void recordEnd(int id, double timeMs, int error, const QString &errorString);
+
+    // Replay side: next exchange for a request (false if none recorded)
+    bool takeExchange(const QString &method, const QString &path, StreamTraceExchange &exchange);
+
+private:
+    StreamTrace();
+    StreamTrace(const StreamTrace&) = delete;
+    StreamTrace& operator=(const StreamTrace&) = delete;
+
+    void writeRecord(const QJsonObject &record);
+
+    Mode m_mode;
+    QString m_path;
+    double m_speed;
+
+    QMutex m_mutex;          // Recording may happen from several clients
+    QFile m_file;
+    int m_nextId;
+    QElapsedTimer m_clock;
+
+    QList<StreamTraceExchange> m_exchanges;
+    QHash<QString, QList<int>> m_exchangesByKey;  // "METHOD path" -> indexes
+    QHash<QString, int> m_replayCursor;
+};
+
+/**
+ * @brief Network manager that records or replays exchanges
+ */
+class TraceNetworkAccessManager : public QNetworkAccessManager {
+    Q_OBJECT
+
+public:
+    explicit TraceNetworkAccessManager(StreamTrace::Mode mode, QObject *parent = nullptr);
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData = nullptr) override;
+
+private:
+    StreamTrace::Mode m_mode;
+};
+
+/**
+ * @brief Pass-through reply that records the wrapped reply's bytes
+ */
+class RecordingNetworkReply : public QNetworkReply {
+    Q_OBJECT
+
+public:
+    RecordingNetworkReply(QNetworkReply *inner, QObject *parent = nullptr);
+    ~RecordingNetworkReply() override;
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private slots:
+    void handleMetaDataChanged();
+    void handleReadyRead();
+    void handleFinished();
+
+private:
+    QPointer<QNetworkReply> m_inner;
+    QByteArray m_buffer;
+    int m_exchangeId;
+    QElapsedTimer m_timer;
+    bool m_responseRecorded;
+};
+
+/**
+ * @brief Reply that plays back a recorded exchange on a timer
+ */
+class ReplayNetworkReply : public QNetworkReply {
+    Q_OBJECT
+
+public:
+    ReplayNetworkReply(Operation op, const QNetworkRequest &request, const StreamTraceExchange &exchange,
+                       double speed, QObject *parent = nullptr);
+
+    // Reply for a request with no recorded exchange
+    ReplayNetworkReply(Operation op, const QNetworkRequest &request, QObject *parent = nullptr);
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+    void init(Operation op, const QNetworkRequest &request);
+    void scheduleNext();
+    void deliverNext();
+    void finishReplay();
+
+    StreamTraceExchange m_exchange;
+    double m_speed;
+    int m_nextChunk;
+    QByteArray m_buffer;
+    QElapsedTimer m_timer;
+    bool m_aborted;
+};
+
+#endif // STREAMTRACE_H
@@ -0,0 +1,78 @@
+/**
+ * Tokenizer.h - Token counting for the embedding model
+ *
+ * Counts the tokens a WordPiece embedding model (BERT, nomic-embed-text,
+ * MiniLM, bge and similar) would see, from the model's own vocabulary, so
+ * RAGEngine can size chunks to the model's input limit instead of guessing
+ * from character counts. Without a vocabulary it falls back to an estimate
+ * from the same word splitting.
+ */
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <QString>
+#include <QSet>
+#include <QVector>
+
+/**
+ * @brief A word of the input: where it is and how many tokens it costs
+ *
+ * Words are what the model's pre-tokenizer produces: runs of letters and
+ * digits, single punctuation marks, and single CJK ideographs.
+ */
+struct TokenSpan {
+    int start;   // Offset in the text, in QChars
+    int length;  // In QChars
+    int tokens;
+};
+
+/**
+ * @brief WordPiece token counter with an estimating fallback
+ *
+ * load() reads a HuggingFace tokenizer.json whose model is WordPiece, or a
+ * plain vocab.txt (one token per line, uncased). Counts leave out the
+ * special tokens the model adds around each input ([CLS] and [SEP]).
+ * Without a vocabulary, a word of n characters counts as ceil(n / 4)
+ * tokens, which is slightly high for English prose.
+ */
+class Tokenizer {
+public:
+    Tokenizer();
+
+    /**
+     * @brief Read the vocabulary and normalization rules from @p path
+     *
+     * On failure the tokenizer is left as it was and @p error says why.
+     */
+    bool load(const QString &path, QString *error = nullptr);
+
+    // Back to estimating
+    void clear();
+
+    // True when counts come from a vocabulary rather than the estimate
+    bool isExact() const { return !m_vocab.isEmpty(); }
+
+    // File the vocabulary came from, or "estimate"
+    QString name() const;
+
+    int count(const QString &text) const;
+    QVector<TokenSpan> words(const QString &text) const;
+
+    // ~/.qtbot/tokenizers/<model>.json, used when no tokenizer is configured
+    static QString defaultPath(const QString &model);
+
+private:
+    bool loadTokenizerJson(const QString &path, QString *error);
+    bool loadVocabTxt(const QString &path, QString *error);
+    int wordTokens(const QString &word) const;
+
+    QSet<QString> m_vocab;
+    QString m_path;
+    QString m_subwordPrefix;
+    int m_maxWordChars;
+    bool m_lowercase;
+    bool m_stripAccents;
+};
+
+#endif // TOKENIZER_H
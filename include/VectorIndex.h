@@ -0,0 +1,140 @@
+/**
+ * VectorIndex.h - Flat cosine-similarity index with optional dimension reduction
+ *
+ * Stores RAG embeddings L2-normalized in one contiguous buffer, so cosine
+ * similarity is a plain dot product. Vectors can be shortened on insert by
+ * Matryoshka truncation or by a PCA projection learned from the index itself.
+ */
+
+#ifndef VECTORINDEX_H
+#define VECTORINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class QTemporaryFile;
+
+/**
+ * @brief Exact nearest-neighbour search over normalized embeddings
+ *
+ * The first add() fixes the input dimension. With a reduction configured,
+ * stored vectors have dimensions() floats instead, which shrinks memory and
+ * search time in proportion:
+ * - Truncate keeps the leading dimensions, for Matryoshka-trained models
+ *   such as nomic-embed-text whose leading dimensions carry the most signal.
+ * - PCA keeps full-width vectors until the index holds trainingSize() of
+ *   them, then learns the principal components from those, projects them,
+ *   and projects every later vector on insert. Until then searches compare
+ *   full-width vectors.
+ *
+ * Not thread-safe; used from RAGEngine's thread only.
+ */
+class VectorIndex {
+public:
+    enum Reduction {
+        NoReduction,
+        Truncate,
+        PCA
+    };
+
+    VectorIndex();
+    ~VectorIndex();
+
+    /**
+     * @brief Choose the stored width; clears the index
+     * @param dimensions Target width; 0 (or not below the input width) keeps vectors whole
+     */
+    void configure(Reduction reduction, int dimensions);
+    Reduction reduction() const { return m_reduction; }
+    int targetDimensions() const { return m_targetDimensions; }
+
+    // "truncate" or "pca"; anything else means no reduction
+    static Reduction reductionFromString(const QString &name);
+    static QString reductionName(Reduction reduction);
+
+    void clear();
+
+    /**
+     * @brief Normalize, reduce and store @p embedding
+     * @return Position of the vector, or -1 if its width differs from earlier ones
+     */
+    int add(const QVector<float> &embedding);
+
+    /**
+     * @brief Drop the vectors at @p positions
+     *
+     * Later vectors move down to fill the gaps, keeping their order. Spilled
+     * vectors come back to the heap; a PCA projection is kept.
+     */
+    void remove(const QVector<int> &positions);
+
+    // Positions of the @p topK vectors most similar to @p query, best first
+    QVector<int> search(const QVector<float> &query, int topK) const;
+
+    int size() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+
+    // Width of the embeddings given to add(); 0 until the first one
+    int inputDimensions() const { return m_inputDimensions; }
+
+    // Width of the stored vectors
+    int dimensions() const { return m_storedDimensions; }
+
+    // Bytes of heap held by the stored vectors and the projection
+    qint64 memoryBytes() const;
+
+    /**
+     * @brief Move the stored vectors to a memory-mapped temporary file
+     *
+     * Searches then read them through the mapping: the pages are file-backed,
+     * so under pressure the kernel drops them instead of swapping, and the
+     * heap they occupied is freed. Vectors added later stay on the heap until
+     * the next spill(); train() and clear() bring everything back.
+     * @return false if the file couldn't be written or mapped (nothing moves)
+     */
+    bool spill();
+    qint64 mappedBytes() const;
+
+    // PCA only: vectors needed before the projection is learned
+    static int trainingSize();
+    bool isTrained() const { return !m_components.isEmpty(); }
+
+    /**
+     * @brief Learn the PCA projection from the vectors stored so far
+     *
+     * Called automatically at trainingSize() vectors; benchmarks and tests
+     * call it directly. Does nothing unless PCA is configured and the
+     * target is narrower than the input.
+     */
+    void train();
+
+    // Dot product of two float arrays; the search kernel
+    static float dot(const float *a, const float *b, int n);
+
+private:
+    bool reduces() const;
+    const float *storedRow(int position) const;
+    void dropSpillFile();
+    QVector<float> transform(const QVector<float> &embedding) const;
+    static void normalize(float *v, int n);
+
+    Reduction m_reduction;
+    int m_targetDimensions;
+    int m_inputDimensions;
+    int m_storedDimensions;
+    int m_count;
+
+    // Rows of m_storedDimensions floats: the first m_mappedCount in the
+    // spill file, the rest in m_vectors
+    QVector<float> m_vectors;
+    std::unique_ptr<QTemporaryFile> m_spillFile;
+    const float *m_mapped;
+    int m_mappedCount;
+
+    // Learned by train(): the mean, and one component of m_inputDimensions floats per output dimension
+    QVector<float> m_mean;
+    QVector<float> m_components;
+};
+
+#endif // VECTORINDEX_H
@@ -0,0 +1,687 @@
+/**
+ * AgentLoop.cpp - Multi-step tool-calling agent with a DAG step scheduler
+ *
+ * A task alternates between model turns and tool steps. A model turn that
+ * requests tools ends with LLMClient::toolTurnFinished(); its steps start
+ * as they are requested, and the next turn is sent once every step has
+ * finished, carrying all results the model hasn't seen yet.
+ */
+
+#include "AgentLoop.h"
+#include "LLMClient.h"
+#include "MCPHandler.h"
+#include "Config.h"
+#include "Logger.h"
+#include <QTimer>
+#include <QThread>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+const QRegularExpression &stepReference() {
+    static const QRegularExpression pattern("\\{\\{step:(\\d+)\\}\\}");
+    return pattern;
+}
+
+void collectReferences(const QJsonValue &value, QList<int> &ids) {
+    if (value.isString()) {
+        QRegularExpressionMatchIterator it = stepReference().globalMatch(value.toString());
+        while (it.hasNext()) {
+            int id = it.next().captured(1).toInt();
+            if (!ids.contains(id)) {
+                ids.append(id);
+            }
+        }
+    } else if (value.isArray()) {
+        for (const QJsonValue &item : value.toArray()) {
+            collectReferences(item, ids);
+        }
+    } else if (value.isObject()) {
+        QJsonObject object = value.toObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            collectReferences(it.value(), ids);
+        }
+    }
+}
+
+QString valueText(const QJsonValue &value) {
+    if (value.isString()) {
+        return value.toString();
+    }
+    if (value.isDouble()) {
+        return QString::number(value.toDouble(), 'g', 15);
+    }
+    if (value.isBool()) {
+        return value.toBool() ? "true" : "false";
+    }
+    if (value.isArray()) {
+        return QString::fromUtf8(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+    }
+    if (value.isObject()) {
+        return QString::fromUtf8(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+    }
+    return QString();
+}
+
+// What a {{step:N}} reference stands for
+QJsonValue stepValue(const AgentStep &step) {
+    return step.result.contains("result") ? step.result["result"] : QJsonValue(step.result);
+}
+
+QJsonValue substitute(const QJsonValue &value, const QList<AgentStep> &steps) {
+    if (value.isString()) {
+        QString text = value.toString();
+        QRegularExpressionMatch whole = stepReference().match(text);
+        if (whole.hasMatch() && whole.capturedStart() == 0 && whole.capturedLength() == text.length()) {
+            int id = whole.captured(1).toInt();
+            return stepValue(steps[id - 1]);
+        }
+        QString resolved;
+        int last = 0;
+        QRegularExpressionMatchIterator it = stepReference().globalMatch(text);
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+            resolved += text.mid(last, match.capturedStart() - last);
+            resolved += valueText(stepValue(steps[match.captured(1).toInt() - 1]));
+            last = match.capturedEnd();
+        }
+        resolved += text.mid(last);
+        return resolved;
+    }
+    if (value.isArray()) {
+        QJsonArray array;
+        for (const QJsonValue &item : value.toArray()) {
+            array.append(substitute(item, steps));
+        }
+        return array;
+    }
+    if (value.isObject()) {
+        QJsonObject object = value.toObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            it.value() = substitute(it.value(), steps);
+        }
+        return object;
+    }
+    return value;
+}
+
+} // namespace
+
+AgentLoop::AgentLoop(LLMClient *client, MCPHandler *tools, QObject *parent)
+    : QObject(parent)
+    , m_client(client)
+    , m_tools(tools)
+    , m_deadline(new QTimer(this))
+    , m_running(false)
+    , m_generation(0)
+    , m_dispatchingStep(0)
+    , m_runningSteps(0)
+    , m_scheduling(false)
+    , m_modelTurnActive(false)
+    , m_modelSpan(-1)
+    , m_iteration(0)
+    , m_tokensUsed(0)
+    , m_turnTokens(-1)
+    , m_finishedMs(0)
+    , m_stopReason(NotStopped) {
+    m_pool.setMaxThreadCount(m_budget.maxParallelTools);
+
+    m_deadline->setSingleShot(true);
+    connect(m_deadline, &QTimer::timeout, this, [this]() {
+        finish(TimeBudget);
+    });
+
+    // The client may live on another thread; these arrive queued, in order
+    if (m_client) {
+        connect(m_client, &LLMClient::toolCallRequested, this,
+                [this](const QString &toolName, const QJsonObject &arguments, const QString &) {
+            onToolCallRequested(toolName, arguments);
+        });
+        connect(m_client, &LLMClient::toolTurnFinished, this, &AgentLoop::onToolTurnFinished);
+        connect(m_client, &LLMClient::responseReceived, this, &AgentLoop::onResponse);
+        connect(m_client, &LLMClient::errorOccurred, this, &AgentLoop::onClientError);
+        connect(m_client, &LLMClient::generationStats, this, [this](int promptTokens, int completionTokens, qint64) {
+            onGenerationStats(promptTokens, completionTokens);
+        });
+        connect(m_client, &LLMClient::tokenReceived, this, [this](const QString &token) {
+            if (m_running && m_modelTurnActive) {
+                m_turnText += token;
+                emit tokenReceived(token);
+            }
+        });
+    }
+
+    if (m_tools) {
+        connect(m_tools, &MCPHandler::toolCallCompleted, this,
+                [this](const QString &callId, const QString &, const QJsonObject &result) {
+            onToolCompleted(callId, result);
+        });
+        connect(m_tools, &MCPHandler::toolCallFailed, this,
+                [this](const QString &callId, const QString &, const QString &error) {
+            onToolFailed(callId, error);
+        });
+    }
+}
+
+AgentLoop::~AgentLoop() {
+    // Local tools still running post back to this object
+    ++m_generation;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void AgentLoop::setBudget(const AgentBudget &budget) {
+    m_budget = budget;
+    m_pool.setMaxThreadCount(budget.maxParallelTools > 0 ? budget.maxParallelTools : QThread::idealThreadCount());
+}
+
+bool AgentLoop::start(const QString &task, const QJsonArray &tools) {
+    if (m_running) {
+        LOG_WARNING("AgentLoop: a task is already running");
+        return false;
+    }
+    if (m_stopReason != NotStopped) {
+        resetResults();
+    }
+
+    m_running = true;
+    m_task = task;
+    m_toolDefinitions = tools;
+    m_modelName = Config::instance().snapshot()->model;
+    m_clock.start();
+    if (m_budget.maxTimeMs > 0) {
+        m_deadline->start(m_budget.maxTimeMs);
+    }
+
+    LOG_INFO(QString("AgentLoop: starting task (%1 planned steps, max %2 iterations, %3 tools)")
+             .arg(m_steps.size()).arg(m_budget.maxIterations).arg(tools.size()));
+
+    // A plan runs first; otherwise this goes straight to the first model turn
+    schedule();
+    continueTask();
+    return true;
+}
+
+int AgentLoop::addStep(const QString &toolName, const QJsonObject &arguments, const QList<int> &dependsOn) {
+    if (!m_running && m_stopReason != NotStopped) {
+        resetResults();
+    }
+
+    QList<int> dependencies = dependsOn;
+    for (int id : referencedSteps(arguments)) {
+        if (!dependencies.contains(id)) {
+            dependencies.append(id);
+        }
+    }
+    for (int id : dependencies) {
+        if (id < 1 || id > m_steps.size()) {
+            LOG_WARNING(QString("AgentLoop: step for %1 depends on unknown step %2").arg(toolName).arg(id));
+            return -1;
+        }
+    }
+
+    AgentStep step;
+    step.id = m_steps.size() + 1;
+    step.iteration = m_iteration;
+    step.toolName = toolName;
+    step.arguments = arguments;
+    step.dependsOn = dependencies;
+    m_steps.append(step);
+
+    if (m_running) {
+        schedule();
+    }
+    return step.id;
+}
+
+void AgentLoop::cancel() {
+    finish(Cancelled);
+}
+
+qint64 AgentLoop::elapsedMs() const {
+    if (m_running) {
+        return m_clock.elapsed();
+    }
+    return m_finishedMs;
+}
+
+void AgentLoop::onToolCallRequested(const QString &toolName, const QJsonObject &arguments) {
+    if (!m_running || !m_modelTurnActive) {
+        return;
+    }
+
+    LOG_INFO(QString("AgentLoop: iteration %1 requested %2").arg(m_iteration).arg(toolName));
+    if (addStep(toolName, arguments) < 0) {
+        // A reference the model made up: report it back instead of running
+        AgentStep step;
+        step.id = m_steps.size() + 1;
+        step.iteration = m_iteration;
+        step.toolName = toolName;
+        step.arguments = arguments;
+        step.state = AgentStep::Failed;
+        step.error = "Arguments reference a step that does not exist";
+        step.startMs = step.endMs = m_clock.elapsed();
+        m_steps.append(step);
+        m_unreported.append(step.id);
+        emit stepFinished(step.id, toolName, false, QJsonObject(), step.error);
+    }
+}
+
+void AgentLoop::onToolTurnFinished() {
+    if (!m_running || !m_modelTurnActive) {
+        return;
+    }
+    endModelTurn();
+    continueTask();
+}
+
+void AgentLoop::onResponse(const QString &response) {
+    if (!m_running || !m_modelTurnActive) {
+        return;
+    }
+    endModelTurn();
+    m_answer = response.isEmpty() ? m_turnText : response;
+    finish(Answered);
+}
+
+void AgentLoop::onClientError(const QString &error) {
+    if (!m_running || !m_modelTurnActive) {
+        return;
+    }
+    endModelTurn();
+    finish(Error, error);
+}
+
+void AgentLoop::onGenerationStats(int promptTokens, int completionTokens) {
+    if (!m_running || !m_modelTurnActive || (promptTokens < 0 && completionTokens < 0)) {
+        return;
+    }
+    m_turnTokens = qMax(m_turnTokens, 0) + qMax(promptTokens, 0) + qMax(completionTokens, 0);
+}
+
+void AgentLoop::onToolCompleted(const QString &callId, const QJsonObject &result) {
+    int stepId = m_dispatchingStep ? m_dispatchingStep : m_callSteps.take(callId);
+    if (stepId) {
+        completeStep(stepId, true, result, QString());
+    }
+}
+
+void AgentLoop::onToolFailed(const QString &callId, const QString &error) {
+    int stepId = m_dispatchingStep ? m_dispatchingStep : m_callSteps.take(callId);
+    if (stepId) {
+        completeStep(stepId, false, QJsonObject(), error);
+    }
+}
+
+void AgentLoop::schedule() {
+    // Completions can arrive synchronously from inside runStep()
+    if (m_scheduling || !m_running) {
+        return;
+    }
+    m_scheduling = true;
+
+    bool progressed = true;
+    while (progressed && m_running) {
+        progressed = false;
+        for (int i = 0; i < m_steps.size() && m_running; ++i) {
+            if (m_steps[i].state != AgentStep::Pending) {
+                continue;
+            }
+
+            bool ready = true;
+            int failedDependency = 0;
+            for (int id : m_steps[i].dependsOn) {
+                AgentStep::State state = m_steps[id - 1].state;
+                if (state == AgentStep::Failed || state == AgentStep::Skipped) {
+                    failedDependency = id;
+                    break;
+                }
+                if (state != AgentStep::Succeeded) {
+                    ready = false;
+                }
+            }
+
+            if (failedDependency) {
+                AgentStep &step = m_steps[i];
+                step.state = AgentStep::Skipped;
+                step.error = QString("Step %1 did not succeed").arg(failedDependency);
+                step.startMs = step.endMs = m_clock.elapsed();
+                m_unreported.append(step.id);
+                emit stepFinished(step.id, step.toolName, false, QJsonObject(), step.error);
+                progressed = true;
+            } else if (ready && (m_budget.maxParallelTools <= 0 || m_runningSteps < m_budget.maxParallelTools)) {
+                runStep(m_steps[i]);
+                progressed = true;
+            }
+        }
+    }
+
+    m_scheduling = false;
+}
+
+void AgentLoop::runStep(AgentStep &step) {
+    int stepId = step.id;
+    step.state = AgentStep::Running;
+    step.startMs = m_clock.elapsed();
+    m_runningSteps++;
+
+    AgentSpan span;
+    span.kind = "tool";
+    span.name = step.toolName;
+    span.iteration = step.iteration;
+    span.stepId = stepId;
+    span.startMs = step.startMs;
+    m_timeline.append(span);
+
+    emit stepStarted(stepId, step.toolName);
+    LOG_DEBUG(QString("AgentLoop: running step %1 (%2)").arg(stepId).arg(step.toolName));
+
+    QJsonObject arguments = resolveArguments(step);
+    const MCPTool *tool = m_tools ? m_tools->getTool(step.toolName) : nullptr;
+    if (!tool) {
+        completeStep(stepId, false, QJsonObject(), QString("Tool not found: %1").arg(step.toolName));
+        return;
+    }
+
+    if (tool->toolType == MCPToolType::Local && tool->function) {
+        // Local tools are plain functions: run them side by side off this thread
+        MCPToolFunction function = tool->function;
+        quint64 generation = m_generation;
+        m_pool.start([this, function, arguments, generation, stepId]() {
+            QJsonObject result;
+            QString error;
+            try {
+                result = function(arguments);
+            } catch (const std::exception &e) {
+                error = QString("Tool execution error: %1").arg(e.what());
+            } catch (...) {
+                error = "Unknown error during tool execution";
+            }
+            QMetaObject::invokeMethod(this, [this, generation, stepId, result, error]() {
+                if (generation == m_generation) {
+                    completeStep(stepId, error.isEmpty(), result, error);
+                }
+            }, Qt::QueuedConnection);
+        });
+        return;
+    }
+
+    // Networked tools are asynchronous in MCPHandler; several overlap on the network
+    m_dispatchingStep = stepId;
+    QString callId = m_tools->executeToolCall(step.toolName, arguments);
+    m_dispatchingStep = 0;
+
+    AgentStep *current = findStep(stepId);
+    if (current && current->state == AgentStep::Running) {
+        m_callSteps.insert(callId, stepId);
+    }
+}
+
+void AgentLoop::completeStep(int stepId, bool ok, const QJsonObject &result, const QString &error) {
+    AgentStep *step = findStep(stepId);
+    if (!m_running || !step || step->state != AgentStep::Running) {
+        return;
+    }
+
+    step->state = ok ? AgentStep::Succeeded : AgentStep::Failed;
+    step->result = result;
+    step->error = error;
+    step->endMs = m_clock.elapsed();
+    m_runningSteps--;
+
+    for (AgentSpan &span : m_timeline) {
+        if (span.stepId == stepId) {
+            span.endMs = step->endMs;
+        }
+    }
+
+    m_unreported.append(stepId);
+    LOG_INFO(QString("AgentLoop: step %1 (%2) %3 in %4 ms")
+             .arg(stepId).arg(step->toolName).arg(ok ? "succeeded" : "failed").arg(step->endMs - step->startMs));
+    emit stepFinished(stepId, step->toolName, ok, result, error);
+
+    schedule();
+    continueTask();
+}
+
+void AgentLoop::continueTask() {
+    if (!m_running || m_scheduling || m_modelTurnActive || hasOutstandingSteps()) {
+        return;
+    }
+
+    if (!m_client) {
+        finish(PlanCompleted);
+        return;
+    }
+
+    // A turn ended without any step to report: nothing left to ask for
+    if (m_iteration > 0 && m_unreported.isEmpty()) {
+        m_answer = m_turnText;
+        finish(Answered);
+        return;
+    }
+
+    if (m_budget.maxIterations > 0 && m_iteration >= m_budget.maxIterations) {
+        finish(MaxIterations);
+        return;
+    }
+    if (m_budget.maxTokens > 0 && m_tokensUsed >= m_budget.maxTokens) {
+        finish(TokenBudget);
+        return;
+    }
+
+    QString prompt = m_unreported.isEmpty() ? m_task : resultsPrompt();
+    m_unreported.clear();
+    startModelTurn(prompt);
+}
+
+void AgentLoop::startModelTurn(const QString &prompt) {
+    m_iteration++;
+    m_modelTurnActive = true;
+    m_turnText.clear();
+    m_turnTokens = -1;
+
+    AgentSpan span;
+    span.kind = "model";
+    span.name = m_modelName;
+    span.iteration = m_iteration;
+    span.startMs = m_clock.elapsed();
+    m_timeline.append(span);
+    m_modelSpan = m_timeline.size() - 1;
+
+    emit iterationStarted(m_iteration);
+
+    QJsonArray tools = m_toolDefinitions;
+    QMetaObject::invokeMethod(m_client, [client = m_client, prompt, tools]() {
+        if (tools.isEmpty()) {
+            client->sendPrompt(prompt);
+        } else {
+            client->sendPromptWithTools(prompt, tools);
+        }
+    });
+}
+
+void AgentLoop::endModelTurn() {
+    m_modelTurnActive = false;
+
+    // Backends that don't report counts: estimate the completion (~4 chars/token)
+    m_tokensUsed += m_turnTokens >= 0 ? m_turnTokens : m_turnText.length() / 4;
+
+    if (m_modelSpan >= 0) {
+        m_timeline[m_modelSpan].endMs = m_clock.elapsed();
+        m_modelSpan = -1;
+    }
+}
+
+void AgentLoop::finish(StopReason reason, const QString &error) {
+    if (!m_running) {
+        return;
+    }
+
+    if (m_modelTurnActive) {
+        endModelTurn();
+    }
+    m_running = false;
+    m_deadline->stop();
+    m_finishedMs = m_clock.elapsed();
+    m_stopReason = reason;
+    m_error = error;
+
+    // Drop results of anything still in flight
+    ++m_generation;
+    m_callSteps.clear();
+    m_runningSteps = 0;
+    for (AgentStep &step : m_steps) {
+        if (step.state == AgentStep::Running) {
+            step.state = AgentStep::Failed;
+            step.error = QString("Stopped: %1").arg(stopReasonName(reason));
+            step.endMs = m_finishedMs;
+        } else if (step.state == AgentStep::Pending) {
+            step.state = AgentStep::Skipped;
+            step.error = QString("Stopped: %1").arg(stopReasonName(reason));
+        }
+    }
+    for (AgentSpan &span : m_timeline) {
+        if (span.endMs < 0) {
+            span.endMs = m_finishedMs;
+        }
+    }
+
+    if (m_answer.isEmpty() && reason != Answered) {
+        m_answer = m_turnText;  // Partial text of the last turn, if any
+    }
+
+    LOG_INFO(QString("AgentLoop: finished (%1) after %2 iterations, %3 steps, %4 tokens, %5 ms")
+             .arg(stopReasonName(reason)).arg(m_iteration).arg(m_steps.size()).arg(m_tokensUsed).arg(m_finishedMs));
+    if (!error.isEmpty()) {
+        LOG_WARNING(QString("AgentLoop: %1").arg(error));
+    }
+
+    emit finished(m_answer);
+}
+
+void AgentLoop::resetResults() {
+    m_steps.clear();
+    m_timeline.clear();
+    m_unreported.clear();
+    m_callSteps.clear();
+    m_runningSteps = 0;
+    m_modelTurnActive = false;
+    m_modelSpan = -1;
+    m_iteration = 0;
+    m_tokensUsed = 0;
+    m_turnTokens = -1;
+    m_turnText.clear();
+    m_finishedMs = 0;
+    m_stopReason = NotStopped;
+    m_answer.clear();
+    m_error.clear();
+}
+
+QString AgentLoop::resultsPrompt() const {
+    QString prompt = "Here are the tool call results:\n\n";
+    for (int id : m_unreported) {
+        const AgentStep &step = m_steps[id - 1];
+        if (step.state == AgentStep::Succeeded) {
+            prompt += QString("Step %1 (%2): %3\n").arg(id).arg(step.toolName)
+                .arg(QString::fromUtf8(QJsonDocument(step.result).toJson(QJsonDocument::Compact)));
+        } else {
+            prompt += QString("Step %1 (%2) failed: %3\n").arg(id).arg(step.toolName, step.error);
+        }
+    }
+    prompt += "\nIf you still need information, call more tools; an argument can use an earlier "
+              "result as {{step:N}}. Otherwise answer the original request.\n\n";
+    prompt += "Original request: " + m_task;
+    return prompt;
+}
+
+QJsonObject AgentLoop::resolveArguments(const AgentStep &step) const {
+    if (step.dependsOn.isEmpty()) {
+        return step.arguments;
+    }
+    return substitute(step.arguments, m_steps).toObject();
+}
+
+AgentStep *AgentLoop::findStep(int stepId) {
+    if (stepId < 1 || stepId > m_steps.size()) {
+        return nullptr;
+    }
+    return &m_steps[stepId - 1];
+}
+
+bool AgentLoop::hasOutstandingSteps() const {
+    for (const AgentStep &step : m_steps) {
+        if (step.state == AgentStep::Pending || step.state == AgentStep::Running) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<int> AgentLoop::referencedSteps(const QJsonObject &arguments) {
+    QList<int> ids;
+    collectReferences(arguments, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+QString AgentLoop::stopReasonName(StopReason reason) {
+    switch (reason) {
+        case NotStopped: return "running";
+        case Answered: return "answered";
+        case PlanCompleted: return "plan completed";
+        case MaxIterations: return "iteration limit";
+        case TokenBudget: return "token budget";
+        case TimeBudget: return "time budget";
+        case Error: return "error";
+        case Cancelled: return "cancelled";
+    }
+    return QString();
+}
+
+QString AgentLoop::formatTimeline() const {
+    QStringList lines;
+    lines << QString("%1  %2  %3  %4  %5  %6")
+        .arg("step", 4).arg("kind", -5).arg("name", -24).arg("iter", 4).arg("start ms", 9).arg("duration ms", 11);
+
+    // Sorted by start time, so overlapping steps are easy to spot
+    QList<AgentSpan> spans = m_timeline;
+    std::stable_sort(spans.begin(), spans.end(), [](const AgentSpan &a, const AgentSpan &b) {
+        return a.startMs < b.startMs;
+    });
+    for (const AgentSpan &span : spans) {
+        qint64 duration = span.endMs >= 0 ? span.endMs - span.startMs : -1;
+        lines << QString("%1  %2  %3  %4  %5  %6")
+            .arg(span.stepId > 0 ? QString::number(span.stepId) : QString("-"), 4)
+            .arg(span.kind, -5)
+            .arg(span.name.left(24), -24)
+            .arg(span.iteration, 4)
+            .arg(span.startMs, 9)
+            .arg(duration >= 0 ? QString::number(duration) : QString("-"), 11);
+    }
+
+    lines << QString("%1 model turns, %2 steps, %3 tokens, %4 ms (%5)")
+        .arg(m_iteration).arg(m_steps.size()).arg(m_tokensUsed).arg(elapsedMs())
+        .arg(stopReasonName(m_stopReason));
+    return lines.join('\n');
+}
+
+QJsonArray AgentLoop::timelineJson() const {
+    QJsonArray spans;
+    for (const AgentSpan &span : m_timeline) {
+        QJsonObject entry;
+        entry["kind"] = span.kind;
+        entry["name"] = span.name;
+        entry["iteration"] = span.iteration;
+        if (span.stepId > 0) {
+            entry["step"] = span.stepId;
+        }
+        entry["start_ms"] = span.startMs;
+        entry["duration_ms"] = span.endMs >= 0 ? span.endMs - span.startMs : -1;
+        spans.append(entry);
+    }
+    return spans;
+}
@@ -0,0 +1,538 @@
+/**
+ * BatchRunner.cpp - JSONL batch mode for the CLI
+ *
+ * Reads prompts lazily (one line per free slot; stdin as it arrives), seeds every per-prompt
+ * LLMClient with capabilities detected once, and flushes each result record
+ * to disk as soon as it completes so partial runs survive interruption.
+ */
+
+#include "BatchRunner.h"
+#include "LLMClient.h"
+#include "MCPHandler.h"
+#include "RAGEngine.h"
+#include "Config.h"
+#include "Logger.h"
+#include "BuiltinTools.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+#include <cstdio>
+#include <cerrno>
+#include <memory>
+#include <unistd.h>
+
+// How long to wait for /api/show before falling back to prompt-based tool calling
+static const int CAPABILITY_TIMEOUT_MS = 10000;
+
+// Poll interval while waiting for RAG embeddings to finish
+static const int RAG_POLL_INTERVAL_MS = 200;
+
+// stdin read ahead of the free slots; reading pauses above this
+static const int STDIN_BUFFER_BYTES = 1 << 20;
+
+BatchRunner::BatchRunner(const BatchOptions &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_input(new QFile(this))
+    , m_output(new QFile(this))
+    , m_inputExhausted(false)
+    , m_lineNumber(0)
+    , m_done(false)
+    , m_stdinNotifier(nullptr)
+    , m_stdinEof(false)
+    , m_probeClient(nullptr)
+    , m_ready(false)
+    , m_mcpHandler(nullptr)
+    , m_ragEngine(nullptr)
+    , m_dispatchingItem(nullptr)
+    , m_completed(0)
+    , m_failed(0)
+    , m_skipped(0) {
+    if (m_options.concurrency < 1) {
+        m_options.concurrency = 1;
+    }
+}
+
+BatchRunner::~BatchRunner() {
+    qDeleteAll(m_inFlight);
+}
+
+bool BatchRunner::start() {
+    m_wallTimer.start();
+
+    // Input: stream from stdin or a file
+    if (m_options.inputPath == "-") {
+        m_stdinNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+        connect(m_stdinNotifier, &QSocketNotifier::activated, this, &BatchRunner::readStdin);
+    } else {
+        m_input->setFileName(m_options.inputPath);
+        if (!m_input->open(QIODevice::ReadOnly)) {
+            LOG_ERROR(QString("Batch: cannot open input %1: %2").arg(m_options.inputPath, m_input->errorString()));
+            return false;
+        }
+    }
+
+    if (m_options.resume) {
+        loadCompletedIds();
+    }
+
+    m_output->setFileName(m_options.outputPath);
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | (m_options.resume ? QIODevice::Append : QIODevice::Truncate);
+    if (!m_output->open(mode)) {
+        LOG_ERROR(QString("Batch: cannot open output %1: %2").arg(m_options.outputPath, m_output->errorString()));
+        return false;
+    }
+
+    LOG_INFO(QString("Batch: %1 -> %2 (concurrency %3, tools %4)")
+             .arg(m_options.inputPath, m_options.outputPath)
+             .arg(m_options.concurrency).arg(m_options.useTools ? "on" : "off"));
+
+    if (m_options.useTools) {
+        registerTools();
+    }
+
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    if (!m_options.contextPath.isEmpty() || cfg->ragEnabled) {
+        m_ragEngine = new RAGEngine(this);
+        m_ragEngine->setEmbeddingProvider(cfg->ragEmbeddingProvider, cfg->ragEmbeddingUrl, cfg->openaiApiKey);
+        m_ragEngine->setDimensionReduction(cfg->ragDimensionReduction, cfg->ragEmbeddingDimensions);
+        m_ragEngine->setEmbeddingModel(cfg->ragEmbeddingModel);
+        m_ragEngine->setChunkSize(cfg->ragChunkSize);
+        m_ragEngine->setChunkOverlap(cfg->ragChunkOverlap);
+        m_ragEngine->setChunkTokens(cfg->ragChunkTokens);
+        m_ragEngine->setTokenizer(cfg->ragTokenizer);
+        m_ragEngine->setRetrievalDeadline(cfg->ragDeadlineMs);
+
+        if (!m_options.contextPath.isEmpty()) {
+            QFileInfo info(m_options.contextPath);
+            bool ok = info.isDir() ? m_ragEngine->ingestDirectory(m_options.contextPath)
+                                   : m_ragEngine->ingestDocument(m_options.contextPath);
+            if (!ok) {
+                LOG_WARNING(QString("Batch: failed to ingest RAG context from %1").arg(m_options.contextPath));
+            }
+        }
+    }
+
+    detectCapabilities();
+    return true;
+}
+
+void BatchRunner::loadCompletedIds() {
+    QFile previous(m_options.outputPath);
+    if (!previous.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    while (!previous.atEnd()) {
+        QJsonObject record = QJsonDocument::fromJson(previous.readLine()).object();
+        // Only successful records count as done; failed ones are retried
+        if (record.contains("id") && record["error"].toString().isEmpty()) {
+            m_completedIds.insert(record["id"].toString());
+        }
+    }
+
+    LOG_INFO(QString("Batch: resuming, %1 prompts already completed").arg(m_completedIds.size()));
+}
+
+void BatchRunner::registerTools() {
+    m_mcpHandler = new MCPHandler(this);
+
+    MCPTool calcTool;
+    calcTool.name = "calculator";
+    calcTool.description = "Performs basic arithmetic operations (add, subtract, multiply, divide)";
+    calcTool.isLocal = true;
+    calcTool.function = exampleCalculatorTool;
+    calcTool.parameters = QJsonObject{
+        {"operation", QJsonValue("string: add, subtract, multiply, or divide")},
+        {"a", QJsonValue("number: first operand")},
+        {"b", QJsonValue("number: second operand")}
+    };
+    m_mcpHandler->registerTool(calcTool);
+
+    MCPTool datetimeTool;
+    datetimeTool.name = "datetime";
+    datetimeTool.description = "Get current date and time in various formats";
+    datetimeTool.isLocal = true;
+    datetimeTool.function = exampleDateTimeTool;
+    datetimeTool.parameters = QJsonObject{
+        {"format", QJsonValue("string: 'short', 'long', 'iso', or 'timestamp' (default: long)")}
+    };
+    m_mcpHandler->registerTool(datetimeTool);
+
+    // Route completions back to the item that requested them. Local tools
+    // complete inside executeToolCall(), before the call ID is known.
+    connect(m_mcpHandler, &MCPHandler::toolCallCompleted, this,
+            [this](const QString &callId, const QString &toolName, const QJsonObject &result) {
+        BatchItem *item = m_toolCallOwners.take(callId);
+        if (!item) {
+            item = m_dispatchingItem;
+        }
+        if (!item || !m_inFlight.contains(item) || !item->client) {
+            return;
+        }
+
+        QJsonObject toolResult;
+        toolResult["tool_name"] = toolName;
+        toolResult["call_id"] = callId;
+        toolResult["result"] = result;
+        item->client->sendToolResults(item->prompt, QJsonArray{toolResult});
+    });
+
+    connect(m_mcpHandler, &MCPHandler::toolCallFailed, this,
+            [this](const QString &callId, const QString &toolName, const QString &error) {
+        BatchItem *item = m_toolCallOwners.take(callId);
+        if (!item) {
+            item = m_dispatchingItem;
+        }
+        if (item && m_inFlight.contains(item)) {
+            completeItem(item, QString(), QString("Tool %1 failed: %2").arg(toolName, error));
+        }
+    });
+
+    // MCP servers are discovered once for the whole batch
+    QTimer::singleShot(0, this, [this]() {
+        QJsonArray mcpServers = Config::instance().getMcpServers();
+        for (const QJsonValue &serverVal : mcpServers) {
+            QJsonObject server = serverVal.toObject();
+            QString name = server["name"].toString();
+            QString url = server["url"].toString();
+            if (server["enabled"].toBool(true) && !name.isEmpty() && !url.isEmpty()) {
+                m_mcpHandler->discoverAndRegisterServerTools(name, url, server["type"].toString().toLower());
+            }
+        }
+        LOG_INFO(QString("Batch: %1 tools available").arg(m_mcpHandler->getRegisteredTools().size()));
+    });
+}
+
+void BatchRunner::detectCapabilities() {
+    m_probeClient = new LLMClient(this);
+    connect(m_probeClient, &LLMClient::modelCapabilitiesDetected, this,
+            [this](const QString &format, const QJsonObject &info) {
+        if (m_ready) {
+            return;
+        }
+        m_toolCallFormat = format;
+        m_modelInfo = info;
+        m_ready = true;
+        LOG_INFO(QString("Batch: model uses %1 tool calling").arg(format));
+        fillSlots();
+    });
+
+    QTimer::singleShot(CAPABILITY_TIMEOUT_MS, this, [this]() {
+        if (m_ready) {
+            return;
+        }
+        LOG_WARNING("Batch: model capability detection timed out, assuming prompt-based tool calling");
+        m_toolCallFormat = "prompt";
+        m_ready = true;
+        fillSlots();
+    });
+}
+
+void BatchRunner::readStdin() {
+    // Readable, so one read() returns without waiting for more
+    char buffer[65536];
+    ssize_t bytes = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (bytes < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+            return;
+        }
+        LOG_ERROR(QString("Batch: cannot read stdin: %1").arg(qt_error_string(errno)));
+    }
+    if (bytes <= 0) {
+        m_stdinEof = true;
+        m_stdinNotifier->setEnabled(false);
+    } else {
+        m_stdinBuffer.append(buffer, static_cast<int>(bytes));
+        m_stdinNotifier->setEnabled(m_stdinBuffer.size() < STDIN_BUFFER_BYTES);
+    }
+    fillSlots();
+}
+
+bool BatchRunner::readNextLine(QByteArray &line) {
+    if (!m_stdinNotifier) {
+        if (m_input->atEnd()) {
+            m_inputExhausted = true;
+            return false;
+        }
+        line = m_input->readLine();
+        return true;
+    }
+
+    // Only what stdin has delivered so far; the notifier brings more
+    int newline = m_stdinBuffer.indexOf('\n');
+    if (newline >= 0) {
+        line = m_stdinBuffer.left(newline + 1);
+        m_stdinBuffer.remove(0, newline + 1);
+    } else if (m_stdinEof && !m_stdinBuffer.isEmpty()) {
+        line = m_stdinBuffer;  // Last line without a newline
+        m_stdinBuffer.clear();
+    } else {
+        m_inputExhausted = m_stdinEof;
+        return false;
+    }
+    if (!m_stdinEof && m_stdinBuffer.size() < STDIN_BUFFER_BYTES) {
+        m_stdinNotifier->setEnabled(true);
+    }
+    return true;
+}
+
+bool BatchRunner::readNextItem(BatchItem &item) {
+    QByteArray line;
+    while (readNextLine(line)) {
+        line = line.trimmed();
+        m_lineNumber++;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        item.index = m_lineNumber;
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
+            QJsonObject obj = doc.object();
+            item.prompt = obj["prompt"].toString();
+            QJsonValue id = obj["id"];
+            item.id = id.isString() ? id.toString()
+                    : id.isDouble() ? QString::number(id.toVariant().toLongLong())
+                    : QString::number(m_lineNumber);
+        } else {
+            // Plain text line: the line is the prompt
+            item.prompt = QString::fromUtf8(line);
+            item.id = QString::number(m_lineNumber);
+        }
+        return true;
+    }
+    return false;
+}
+
+void BatchRunner::fillSlots() {
+    if (!m_ready) {
+        return;
+    }
+
+    // Let RAG embeddings finish before the first retrieval
+    if (m_ragEngine && m_ragEngine->getPendingEmbeddingCount() > 0) {
+        QTimer::singleShot(RAG_POLL_INTERVAL_MS, this, &BatchRunner::fillSlots);
+        return;
+    }
+
+    while (m_inFlight.size() < m_options.concurrency && !m_inputExhausted) {
+        BatchItem item;
+        if (!readNextItem(item)) {
+            break;
+        }
+
+        if (m_completedIds.contains(item.id)) {
+            m_skipped++;
+            continue;
+        }
+
+        BatchItem *inFlight = new BatchItem(item);
+        m_inFlight.append(inFlight);
+        startItem(inFlight);
+    }
+
+    checkDone();
+}
+
+void BatchRunner::startItem(BatchItem *item) {
+    if (item->prompt.isEmpty()) {
+        completeItem(item, QString(), "Empty prompt");
+        return;
+    }
+
+    item->timer.start();
+
+    LLMClient *client = new LLMClient(this);
+    client->setModelCapabilities(m_toolCallFormat, m_modelInfo);
+    item->client = client;
+
+    connect(client, &LLMClient::tokenReceived, this, [item](const QString &) {
+        if (item->ttftMs < 0) {
+            item->ttftMs = item->timer.elapsed();
+        }
+        item->streamedChunks++;
+    });
+    connect(client, &LLMClient::generationStats, this, [item](int promptTokens, int completionTokens, qint64) {
+        // Tool calls produce two generations; sum them
+        if (promptTokens >= 0) {
+            item->promptTokens += promptTokens;
+            item->backendCounts = true;
+        }
+        if (completionTokens >= 0) {
+            item->completionTokens += completionTokens;
+            item->backendCounts = true;
+        }
+    });
+    connect(client, &LLMClient::responseReceived, this, [this, item](const QString &response) {
+        completeItem(item, response, QString());
+    });
+    connect(client, &LLMClient::errorOccurred, this, [this, item](const QString &error) {
+        completeItem(item, QString(), error);
+    });
+    connect(client, &LLMClient::toolCallRequested, this,
+            [this, item](const QString &toolName, const QJsonObject &params, const QString &) {
+        if (!m_mcpHandler) {
+            return;
+        }
+        m_dispatchingItem = item;
+        QString callId = m_mcpHandler->executeToolCall(toolName, params);
+        m_dispatchingItem = nullptr;
+        if (m_inFlight.contains(item)) {
+            m_toolCallOwners.insert(callId, item);
+        }
+    });
+
+    item->timeoutTimer = new QTimer(client);
+    item->timeoutTimer->setSingleShot(true);
+    connect(item->timeoutTimer, &QTimer::timeout, this, [this, item]() {
+        completeItem(item, QString(), QString("Timed out after %1 ms").arg(m_options.timeoutMs));
+    });
+    item->timeoutTimer->start(m_options.timeoutMs);
+
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    if (m_ragEngine && m_ragEngine->getChunkCount() > 0) {
+        item->ragRequestId = m_ragEngine->requestContext(item->prompt, cfg->ragTopK);
+        auto ready = std::make_shared<QMetaObject::Connection>();
+        auto failed = std::make_shared<QMetaObject::Connection>();
+        *ready = connect(m_ragEngine, &RAGEngine::contextReady, client,
+                         [this, item, ready, failed](int requestId, const QStringList &contexts) {
+            if (requestId != item->ragRequestId) {
+                return;
+            }
+            disconnect(*ready);
+            disconnect(*failed);
+
+            QString ragContext;
+            if (!contexts.isEmpty()) {
+                ragContext = "CONTEXT FROM DOCUMENTS:\n\n";
+                for (int i = 0; i < contexts.size(); ++i) {
+                    ragContext += QString("--- Document Chunk %1 ---\n%2\n\n").arg(i + 1).arg(contexts[i]);
+                }
+                ragContext += "\nPlease use the above context to answer the user's question.\n\n";
+            }
+            sendItemPrompt(item, ragContext + "USER QUESTION: " + item->prompt);
+        });
+        *failed = connect(m_ragEngine, &RAGEngine::contextFailed, client,
+                          [this, item, ready, failed](int requestId, const QString &error) {
+            if (requestId != item->ragRequestId) {
+                return;
+            }
+            disconnect(*ready);
+            disconnect(*failed);
+            LOG_WARNING(QString("Batch item %1: RAG error: %2 - proceeding without context").arg(item->id, error));
+            sendItemPrompt(item, item->prompt);
+        });
+        return;
+    }
+
+    // Defer so the client's network manager is initialized first
+    QTimer::singleShot(0, client, [this, item]() { sendItemPrompt(item, item->prompt); });
+}
+
+void BatchRunner::sendItemPrompt(BatchItem *item, const QString &prompt) {
+    if (!item->client) {
+        return;
+    }
+
+    if (m_mcpHandler) {
+        item->client->sendPromptWithTools(prompt, m_mcpHandler->getToolsForLLM());
+    } else {
+        item->client->sendPrompt(prompt);
+    }
+}
+
+void BatchRunner::completeItem(BatchItem *item, const QString &response, const QString &error) {
+    if (!m_inFlight.removeOne(item)) {
+        return;  // Already completed (e.g. error after timeout)
+    }
+
+    qint64 latencyMs = item->timer.isValid() ? item->timer.elapsed() : 0;
+
+    QJsonObject record;
+    record["id"] = item->id;
+    record["index"] = item->index;
+    record["prompt"] = item->prompt;
+    record["response"] = response;
+    record["error"] = error.isEmpty() ? QJsonValue(QJsonValue::Null) : QJsonValue(error);
+    record["ttft_ms"] = item->ttftMs >= 0 ? QJsonValue(item->ttftMs) : QJsonValue(QJsonValue::Null);
+    record["latency_ms"] = latencyMs;
+    record["prompt_tokens"] = item->backendCounts ? item->promptTokens : 0;
+    // Without backend counts, one streamed chunk is roughly one token
+    record["completion_tokens"] = item->backendCounts ? item->completionTokens : item->streamedChunks;
+    record["tokens_estimated"] = !item->backendCounts;
+    writeRecord(record);
+
+    if (error.isEmpty()) {
+        m_completed++;
+        LOG_INFO(QString("Batch item %1 done in %2 ms").arg(item->id).arg(latencyMs));
+    } else {
+        m_failed++;
+        LOG_WARNING(QString("Batch item %1 failed: %2").arg(item->id, error));
+    }
+
+    // Drop any tool calls still routed to this item
+    for (auto it = m_toolCallOwners.begin(); it != m_toolCallOwners.end();) {
+        it = (it.value() == item) ? m_toolCallOwners.erase(it) : it + 1;
+    }
+
+    if (item->client) {
+        // Nothing may reach the item once it is freed
+        item->client->disconnect(this);
+        if (m_ragEngine) {
+            m_ragEngine->disconnect(item->client);
+        }
+        item->client->deleteLater();  // Also aborts a request still in flight
+    }
+    delete item;
+
+    // Refill from the event loop, not from inside the client's signal
+    QTimer::singleShot(0, this, &BatchRunner::fillSlots);
+}
+
+void BatchRunner::writeRecord(const QJsonObject &record) {
+    m_output->write(QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n");
+    // Flush every record so an interrupted run keeps everything written so far
+    m_output->flush();
+}
+
+void BatchRunner::checkDone() {
+    // Every completion queues a fillSlots(), so this is reached more than once at the end
+    if (m_done || !m_inputExhausted || !m_inFlight.isEmpty()) {
+        return;
+    }
+    m_done = true;
+
+    qint64 wallMs = m_wallTimer.elapsed();
+    LOG_INFO(QString("Batch complete: %1 succeeded, %2 failed, %3 skipped in %4 ms")
+             .arg(m_completed).arg(m_failed).arg(m_skipped).arg(wallMs));
+
+    m_output->close();
+    emit finished(m_failed == 0);
+}
+
+int runBatch(const BatchOptions &options) {
+    BatchRunner runner(options);
+
+    bool success = false;
+    QObject::connect(&runner, &BatchRunner::finished, [&success](bool ok) {
+        success = ok;
+        QCoreApplication::quit();
+    });
+
+    if (!runner.start()) {
+        return 1;
+    }
+
+    QCoreApplication::exec();
+
+    qInfo().noquote() << QString("Batch: %1 succeeded, %2 failed, %3 skipped")
+                         .arg(runner.completedCount()).arg(runner.failedCount()).arg(runner.skippedCount());
+    return success ? 0 : 1;
+}
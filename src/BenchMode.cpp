@@ -0,0 +1,365 @@
+/**
+ * BenchMode.cpp - Client-side LLM backend benchmark
+ *
+ * The mock server runs on its own thread so its CPU time can be subtracted
+ * from the process total, leaving what LLMClient (parsing, signals, network
+ * thread) and the streaming render path cost per token.
+ */
+
+#include "BenchMode.h"
+#include "MockOllamaServer.h"
+#include "LLMClient.h"
+#include "MCPHandler.h"
+#include "MarkdownHandler.h"
+#include "HTMLHandler.h"
+#include "StreamTrace.h"
+#include "Logger.h"
+#include "BuiltinTools.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <time.h>
+#endif
+
+static const int BENCH_RUN_TIMEOUT_MS = 120000;
+
+// User + system CPU time of the whole process, in microseconds (-1 if unknown)
+static qint64 processCpuUs() {
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL
+             + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+#endif
+    return -1;
+}
+
+// CPU time of the mock server's thread, in microseconds (0 if unknown)
+static qint64 serverThreadCpuUs(Qt::HANDLE threadId) {
+#ifdef Q_OS_LINUX
+    clockid_t clockId;
+    struct timespec ts;
+    if (pthread_getcpuclockid(reinterpret_cast<pthread_t>(threadId), &clockId) == 0
+        && clock_gettime(clockId, &ts) == 0) {
+        return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+    }
+#else
+    Q_UNUSED(threadId);
+#endif
+    return 0;
+}
+
+// Resident set size in KB (-1 if unknown)
+static qint64 residentKb() {
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+        }
+    }
+#endif
+    return -1;
+}
+
+static double median(QList<double> values) {
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    int mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+namespace {
+
+struct RunResult {
+    bool ok = false;
+    QString error;
+    int tokens = 0;            // tokenReceived signals
+    qint64 ttftUs = -1;        // Send -> first token
+    qint64 streamUs = 0;       // First token -> response
+    qint64 renderNs = 0;       // Streaming + final render work
+    int toolCalls = 0;
+};
+
+} // namespace
+
+// Mirrors MessageRenderer::updateLastMessage(): escaped text while
+// streaming, full markdown once the response is complete
+static qint64 renderStreaming(const QString &text, bool final) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QString processed;
+    if (final) {
+        processed = MarkdownHandler::toHtml(text);
+    } else {
+        processed = text.toHtmlEscaped();
+        processed.replace("\n", "<br>");
+    }
+    QString html = HTMLHandler::formatBotMessage(processed, QTime::currentTime().toString("hh:mm:ss"));
+    Q_UNUSED(html);
+
+    return timer.nsecsElapsed();
+}
+
+static RunResult runOnce(const QString &apiUrl, const QString &toolCallFormat, const QJsonObject &modelInfo,
+                         MCPHandler *mcpHandler) {
+    RunResult result;
+    QString prompt = "Write a long answer for the benchmark.";
+
+    LLMClient client;
+    client.setApiUrl(apiUrl);
+    client.setMaxRetries(0);
+    client.setModelCapabilities(toolCallFormat, modelInfo);
+
+    QEventLoop loop;
+    QElapsedTimer sinceSend;
+    QElapsedTimer sinceFirstToken;
+    QString streamed;
+
+    QObject::connect(&client, &LLMClient::tokenReceived, &loop, [&](const QString &token) {
+        if (result.ttftUs < 0) {
+            result.ttftUs = sinceSend.nsecsElapsed() / 1000;
+            sinceFirstToken.start();
+        }
+        result.tokens++;
+        streamed += token;
+        result.renderNs += renderStreaming(streamed, false);
+    });
+    QObject::connect(&client, &LLMClient::responseReceived, &loop, [&](const QString &response) {
+        result.streamUs = sinceFirstToken.isValid() ? sinceFirstToken.nsecsElapsed() / 1000 : 0;
+        result.renderNs += renderStreaming(response.isEmpty() ? streamed : response, true);
+        result.ok = true;
+        loop.quit();
+    });
+    QObject::connect(&client, &LLMClient::errorOccurred, &loop, [&](const QString &error) {
+        result.error = error;
+        loop.quit();
+    });
+
+    QMetaObject::Connection toolConnection;
+    if (mcpHandler) {
+        QObject::connect(&client, &LLMClient::toolCallRequested, &loop,
+                         [&](const QString &toolName, const QJsonObject &params, const QString &) {
+            result.toolCalls++;
+            mcpHandler->executeToolCall(toolName, params);
+        });
+        // Local tools complete synchronously inside executeToolCall()
+        toolConnection = QObject::connect(mcpHandler, &MCPHandler::toolCallCompleted, &loop,
+                                          [&](const QString &callId, const QString &toolName, const QJsonObject &res) {
+            QJsonObject toolResult;
+            toolResult["tool_name"] = toolName;
+            toolResult["call_id"] = callId;
+            toolResult["result"] = res;
+            client.sendToolResults(prompt, QJsonArray{toolResult});
+        });
+    }
+
+    QTimer::singleShot(BENCH_RUN_TIMEOUT_MS, &loop, [&]() {
+        result.error = "Run timed out";
+        loop.quit();
+    });
+
+    // Defer so the client's network manager is initialized first
+    QTimer::singleShot(0, &loop, [&]() {
+        sinceSend.start();
+        if (mcpHandler) {
+            client.sendPromptWithTools(prompt, mcpHandler->getToolsForLLM());
+        } else {
+            client.sendPrompt(prompt);
+        }
+    });
+
+    loop.exec();
+
+    if (toolConnection) {
+        QObject::disconnect(toolConnection);
+    }
+    return result;
+}
+
+int runBench(const QCommandLineParser &parser) {
+    MockOllamaOptions mockOptions;
+    mockOptions.responseTokens = qMax(1, parser.value("bench-tokens").toInt());
+    mockOptions.tokensPerSecond = qMax(0, parser.value("bench-rate").toInt());
+    mockOptions.tokensPerChunk = qMax(1, parser.value("bench-chunk").toInt());
+    mockOptions.firstTokenDelayMs = qMax(0, parser.value("bench-first-token-ms").toInt());
+    int runs = qMax(1, parser.value("bench-runs").toInt());
+    bool useTools = parser.isSet("bench-tools");
+
+    MCPHandler *mcpHandler = nullptr;
+    if (useTools) {
+        mockOptions.toolCallName = "calculator";
+        mockOptions.toolCallArguments = QJsonObject{{"operation", "add"}, {"a", 2}, {"b", 3}};
+
+        mcpHandler = new MCPHandler();
+        MCPTool calcTool;
+        calcTool.name = "calculator";
+        calcTool.description = "Performs basic arithmetic operations (add, subtract, multiply, divide)";
+        calcTool.isLocal = true;
+        calcTool.function = exampleCalculatorTool;
+        calcTool.parameters = QJsonObject{
+            {"operation", QJsonValue("string: add, subtract, multiply, or divide")},
+            {"a", QJsonValue("number: first operand")},
+            {"b", QJsonValue("number: second operand")}
+        };
+        mcpHandler->registerTool(calcTool);
+    }
+
+    // Mock server on its own thread so its CPU time can be separated out
+    QThread serverThread;
+    serverThread.setObjectName("MockOllamaServer");
+    serverThread.start();
+
+    MockOllamaServer *server = new MockOllamaServer(mockOptions);
+    server->moveToThread(&serverThread);
+
+    bool listening = false;
+    QString apiUrl;
+    Qt::HANDLE serverThreadId = nullptr;
+    QMetaObject::invokeMethod(server, [&]() {
+        listening = server->listen();
+        apiUrl = server->generateUrl();
+        serverThreadId = QThread::currentThreadId();
+    }, Qt::BlockingQueuedConnection);
+
+    auto shutdown = [&]() {
+        QMetaObject::invokeMethod(server, [server]() { delete server; }, Qt::BlockingQueuedConnection);
+        serverThread.quit();
+        serverThread.wait();
+        delete mcpHandler;
+    };
+
+    if (!listening) {
+        qCritical() << "Failed to start mock Ollama server";
+        shutdown();
+        return 1;
+    }
+
+    // With --replay-stream every request is answered from the trace instead
+    bool replaying = StreamTrace::instance().isReplaying();
+    if (replaying) {
+        qInfo().noquote() << QString("\n=== LLM client benchmark (replaying %1) ===").arg(StreamTrace::instance().tracePath());
+        mockOptions.firstTokenDelayMs = 0;
+    } else {
+        qInfo().noquote() << QString("\n=== LLM client benchmark (mock backend at %1) ===").arg(apiUrl);
+    }
+    if (!replaying) {
+        qInfo().noquote() << QString("Tokens/response: %1, rate: %2, chunk: %3 tokens, first-token delay: %4 ms, runs: %5%6")
+                             .arg(mockOptions.responseTokens)
+                             .arg(mockOptions.tokensPerSecond > 0 ? QString("%1 tok/s").arg(mockOptions.tokensPerSecond) : QString("unlimited"))
+                             .arg(mockOptions.tokensPerChunk).arg(mockOptions.firstTokenDelayMs).arg(runs)
+                             .arg(useTools ? ", with tool call" : "");
+    }
+
+    // Capability detection goes through the mock's /api/show
+    LLMClient probe;
+    probe.setApiUrl(apiUrl);
+    QString toolCallFormat = "prompt";
+    QJsonObject modelInfo;
+    {
+        QEventLoop loop;
+        QObject::connect(&probe, &LLMClient::modelCapabilitiesDetected, &loop,
+                         [&](const QString &format, const QJsonObject &info) {
+            toolCallFormat = format;
+            modelInfo = info;
+            loop.quit();
+        });
+        QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    // One warm-up run so one-time allocations don't count as growth
+    runOnce(apiUrl, toolCallFormat, modelInfo, mcpHandler);
+    QCoreApplication::processEvents();
+    qint64 rssBeforeKb = residentKb();
+
+    QList<double> ttftOverheadMs;
+    QList<double> tokensPerSecond;
+    qint64 totalTokens = 0;
+    qint64 totalRenderNs = 0;
+    int failures = 0;
+
+    qint64 cpuStart = processCpuUs();
+    qint64 serverCpuStart = serverThreadCpuUs(serverThreadId);
+
+    for (int i = 0; i < runs; ++i) {
+        RunResult run = runOnce(apiUrl, toolCallFormat, modelInfo, mcpHandler);
+        if (!run.ok) {
+            failures++;
+            qWarning().noquote() << QString("Run %1 failed: %2").arg(i + 1).arg(run.error);
+            continue;
+        }
+
+        // The mock's own first-token delay is not client overhead
+        ttftOverheadMs.append(run.ttftUs / 1000.0 - mockOptions.firstTokenDelayMs);
+        if (run.streamUs > 0 && run.tokens > 1) {
+            tokensPerSecond.append((run.tokens - 1) * 1000000.0 / run.streamUs);
+        }
+        totalTokens += run.tokens;
+        totalRenderNs += run.renderNs;
+
+        qInfo().noquote() << QString("Run %1: %2 tokens, TTFT %3 ms, %4 ms streaming%5")
+                             .arg(i + 1).arg(run.tokens)
+                             .arg(run.ttftUs / 1000.0, 0, 'f', 2)
+                             .arg(run.streamUs / 1000.0, 0, 'f', 1)
+                             .arg(run.toolCalls ? QString(", %1 tool call(s)").arg(run.toolCalls) : QString());
+    }
+
+    qint64 cpuUs = processCpuUs() - cpuStart;
+    qint64 serverCpuUs = serverThreadCpuUs(serverThreadId) - serverCpuStart;
+    QCoreApplication::processEvents();
+    qint64 rssAfterKb = residentKb();
+
+    qInfo() << "\n=== Results ===";
+    if (totalTokens > 0 && cpuStart >= 0) {
+        double clientCpuUs = static_cast<double>(cpuUs - serverCpuUs);
+        qInfo().noquote() << QString("Client CPU per token:   %1 us%2")
+                             .arg(clientCpuUs / totalTokens, 0, 'f', 1)
+                             .arg(serverThreadId && serverCpuUs > 0 ? "" : " (includes mock server)");
+        qInfo().noquote() << QString("  of which rendering:   %1 us")
+                             .arg(totalRenderNs / 1000.0 / totalTokens, 0, 'f', 1);
+    } else {
+        qInfo() << "Client CPU per token:   n/a";
+    }
+    qInfo().noquote() << QString("%1 %2 ms")
+                         .arg(replaying ? "TTFT (median, trace):  " : "TTFT overhead (median):")
+                         .arg(median(ttftOverheadMs), 0, 'f', 2);
+    qInfo().noquote() << QString("Tokens/s (median):      %1%2")
+                         .arg(median(tokensPerSecond), 0, 'f', 0)
+                         .arg(replaying ? QString(" (trace at --replay-speed)")
+                              : mockOptions.tokensPerSecond > 0
+                              ? QString(" (backend paced at %1)").arg(mockOptions.tokensPerSecond)
+                              : QString(" (max sustainable)"));
+    if (rssBeforeKb >= 0 && rssAfterKb >= 0) {
+        qInfo().noquote() << QString("Memory growth:          %1 KB over %2 runs (%3 KB/run)")
+                             .arg(rssAfterKb - rssBeforeKb).arg(runs)
+                             .arg(static_cast<double>(rssAfterKb - rssBeforeKb) / runs, 0, 'f', 1);
+    } else {
+        qInfo() << "Memory growth:          n/a";
+    }
+    if (failures > 0) {
+        qWarning().noquote() << QString("%1 of %2 runs failed").arg(failures).arg(runs);
+    }
+
+    shutdown();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+/**
+ * BuiltinTools.cpp - Built-in local MCP tools
+ *
+ * Implements the calculator and date/time tools shared by every mode.
+ */
+
+#include "BuiltinTools.h"
+#include <QDateTime>
+#include <QString>
+
+QJsonObject exampleCalculatorTool(const QJsonObject &params) {
+    // Simple calculator tool
+    QString operation = params["operation"].toString();
+    double a = params["a"].toDouble();
+    double b = params["b"].toDouble();
+    double result = 0.0;
+
+    if (operation == "add") {
+        result = a + b;
+    } else if (operation == "subtract") {
+        result = a - b;
+    } else if (operation == "multiply") {
+        result = a * b;
+    } else if (operation == "divide") {
+        if (b != 0) {
+            result = a / b;
+        } else {
+            QJsonObject error;
+            error["error"] = "Division by zero";
+            return error;
+        }
+    }
+
+    QJsonObject response;
+    response["result"] = result;
+    response["operation"] = operation;
+    response["a"] = a;
+    response["b"] = b;
+    return response;
+}
+
+QJsonObject exampleDateTimeTool(const QJsonObject &params) {
+    // Time and date tool
+    QString format = params["format"].toString("long");
+    QJsonObject response;
+    QDateTime now = QDateTime::currentDateTime();
+
+    if (format == "short") {
+        response["date"] = now.toString("yyyy-MM-dd");
+        response["time"] = now.toString("HH:mm:ss");
+    } else if (format == "iso") {
+        response["datetime"] = now.toString(Qt::ISODate);
+    } else if (format == "timestamp") {
+        response["timestamp"] = now.toMSecsSinceEpoch();
+    } else {
+        response["date"] = now.toString("dddd, MMMM d, yyyy");
+        response["time"] = now.toString("h:mm:ss AP");
+        response["timezone"] = now.timeZoneAbbreviation();
+    }
+
+    return response;
+}
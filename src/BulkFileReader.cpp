@@ -0,0 +1,340 @@
+/**
+ * BulkFileReader.cpp - Concurrent whole-file reads for document ingestion
+ *
+ * io_uring backend: everything runs on the caller's thread. Files are
+ * opened and sized as they enter the window, their reads queued and sent
+ * to the kernel in one submission, and completions reaped while next()
+ * waits for the file at the front. Thread-pool backend: one QFile read
+ * per pool thread, queueDepth threads, since they spend their time
+ * blocked on I/O rather than on a core.
+ */
+
+#include "BulkFileReader.h"
+#include "Logger.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+// Only ever null, but std::unique_ptr needs a complete type to delete
+struct io_uring {};
+#endif
+
+namespace {
+
+// Longest single read queued on the ring; bigger files take several
+const qint64 RING_READ_SIZE = 4 * 1024 * 1024;
+
+void adviseSequential(int fd) {
+#ifdef POSIX_FADV_SEQUENTIAL
+    // Lets the kernel read ahead aggressively (on NFS, larger and concurrent READs)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    Q_UNUSED(fd);
+#endif
+}
+
+} // namespace
+
+struct BulkFileReader::Slot {
+    QString path;
+    QByteArray data;
+    QString error;
+    int fd;          // io_uring only
+    qint64 offset;   // io_uring only: bytes read so far
+    bool done;
+
+    Slot() : fd(-1), offset(0), done(false) {}
+};
+
+BulkFileReader::BulkFileReader(int queueDepth, Backend backend)
+    : m_queueDepth(qMax(1, queueDepth))
+    , m_backend(ThreadPool)
+    , m_nextPath(0)
+    , m_ringPending(0) {
+
+#ifdef HAVE_LIBURING
+    if (backend != ThreadPool) {
+        std::unique_ptr<io_uring> ring(new io_uring);
+        int result = io_uring_queue_init(static_cast<unsigned>(m_queueDepth), ring.get(), 0);
+        if (result == 0) {
+            m_ring = std::move(ring);
+            m_backend = IoUring;
+        } else {
+            // Kernels before 5.1, or io_uring disabled by sysctl or a seccomp profile
+            LOG_DEBUG(QString("io_uring unavailable (%1), reading files on a thread pool")
+                      .arg(qt_error_string(-result)));
+        }
+    }
+#else
+    Q_UNUSED(backend);
+#endif
+
+    m_pool.setMaxThreadCount(m_queueDepth);
+}
+
+BulkFileReader::~BulkFileReader() {
+    cancelAll();
+#ifdef HAVE_LIBURING
+    if (m_ring) {
+        io_uring_queue_exit(m_ring.get());
+    }
+#endif
+}
+
+QString BulkFileReader::backendName(Backend backend) {
+    switch (backend) {
+    case IoUring:
+        return "io_uring";
+    case ThreadPool:
+        return "thread_pool";
+    default:
+        return "auto";
+    }
+}
+
+void BulkFileReader::start(const QStringList &paths) {
+    cancelAll();
+    m_paths = paths;
+    m_nextPath = 0;
+    fill();
+}
+
+bool BulkFileReader::next(BulkFileResult &result) {
+    if (m_inFlight.empty()) {
+        return false;
+    }
+
+    Slot *slot = m_inFlight.front().get();
+    if (m_backend == IoUring) {
+        waitRing(slot);
+    } else {
+        QMutexLocker locker(&m_mutex);
+        while (!slot->done) {
+            m_finished.wait(&m_mutex);
+        }
+    }
+
+    result.path = slot->path;
+    result.data = std::move(slot->data);
+    result.error = slot->error;
+    m_inFlight.pop_front();
+
+    fill();
+    return true;
+}
+
+void BulkFileReader::fill() {
+    int queued = 0;
+    while (static_cast<int>(m_inFlight.size()) < m_queueDepth && m_nextPath < m_paths.size()) {
+        std::unique_ptr<Slot> slot(new Slot);
+        slot->path = m_paths[m_nextPath++];
+        Slot *raw = slot.get();
+        m_inFlight.push_back(std::move(slot));
+        submit(raw);
+        queued++;
+    }
+
+#ifdef HAVE_LIBURING
+    // One system call for the whole window
+    if (m_ring && queued > 0) {
+        io_uring_submit(m_ring.get());
+    }
+#else
+    Q_UNUSED(queued);
+#endif
+}
+
+void BulkFileReader::submit(Slot *slot) {
+    if (m_backend == ThreadPool) {
+        m_pool.start([this, slot]() {
+            QFile file(slot->path);
+            QByteArray data;
+            QString error;
+            if (!file.open(QIODevice::ReadOnly)) {
+                error = file.errorString();
+            } else {
+                adviseSequential(file.handle());
+                data = file.readAll();
+                if (file.error() != QFileDevice::NoError) {
+                    error = file.errorString();
+                    data.clear();
+                }
+            }
+
+            QMutexLocker locker(&m_mutex);
+            slot->data = std::move(data);
+            slot->error = error;
+            slot->done = true;
+            m_finished.wakeAll();
+        });
+        return;
+    }
+
+#ifdef HAVE_LIBURING
+    auto fail = [slot](const QString &error) {
+        if (slot->fd >= 0) {
+            ::close(slot->fd);
+            slot->fd = -1;
+        }
+        slot->error = error;
+        slot->done = true;
+    };
+
+    slot->fd = ::open(QFile::encodeName(slot->path).constData(), O_RDONLY | O_CLOEXEC);
+    if (slot->fd < 0) {
+        fail(qt_error_string(errno));
+        return;
+    }
+    struct stat info;
+    if (::fstat(slot->fd, &info) != 0) {
+        fail(qt_error_string(errno));
+        return;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        fail("Not a regular file");
+        return;
+    }
+    if (info.st_size > std::numeric_limits<int>::max() / 2) {
+        fail("File too large");
+        return;
+    }
+
+    adviseSequential(slot->fd);
+    slot->data.resize(static_cast<int>(info.st_size));
+    if (slot->data.isEmpty()) {
+        fail(QString());
+        return;
+    }
+    submitRingRead(slot);
+#endif
+}
+
+void BulkFileReader::submitRingRead(Slot *slot) {
+#ifdef HAVE_LIBURING
+    // The ring has queueDepth entries and each file has at most one read queued
+    io_uring_sqe *sqe = io_uring_get_sqe(m_ring.get());
+    if (!sqe) {
+        io_uring_submit(m_ring.get());
+        sqe = io_uring_get_sqe(m_ring.get());
+    }
+    if (!sqe) {
+        ::close(slot->fd);
+        slot->fd = -1;
+        slot->error = "io_uring submission queue full";
+        slot->data.clear();
+        slot->done = true;
+        return;
+    }
+
+    unsigned length = static_cast<unsigned>(qMin<qint64>(slot->data.size() - slot->offset, RING_READ_SIZE));
+    io_uring_prep_read(sqe, slot->fd, slot->data.data() + slot->offset, length,
+                       static_cast<__u64>(slot->offset));
+    io_uring_sqe_set_data(sqe, slot);
+    m_ringPending++;
+#else
+    Q_UNUSED(slot);
+#endif
+}
+
+void BulkFileReader::waitRing(Slot *slot) {
+#ifdef HAVE_LIBURING
+    while (!slot->done) {
+        // Also sends reads queued again by completeRing()
+        int result = io_uring_submit_and_wait(m_ring.get(), 1);
+        if (result < 0 && result != -EINTR) {
+            LOG_ERROR(QString("io_uring wait failed: %1").arg(qt_error_string(-result)));
+            slot->error = qt_error_string(-result);
+            slot->data.clear();
+            slot->done = true;
+            return;
+        }
+
+        io_uring_cqe *cqe = nullptr;
+        while (io_uring_peek_cqe(m_ring.get(), &cqe) == 0) {
+            Slot *completed = static_cast<Slot*>(io_uring_cqe_get_data(cqe));
+            int read = cqe->res;
+            io_uring_cqe_seen(m_ring.get(), cqe);
+            m_ringPending--;
+            completeRing(completed, read);
+        }
+    }
+#else
+    Q_UNUSED(slot);
+#endif
+}
+
+void BulkFileReader::completeRing(Slot *slot, int result) {
+#ifdef HAVE_LIBURING
+    if (result == -EINTR || result == -EAGAIN) {
+        submitRingRead(slot);
+        return;
+    }
+    if (result < 0) {
+        slot->error = qt_error_string(-result);
+        slot->data.clear();
+    } else if (result == 0) {
+        slot->data.resize(static_cast<int>(slot->offset));  // Shorter than when it was sized
+    } else {
+        slot->offset += result;
+        if (slot->offset < slot->data.size()) {
+            submitRingRead(slot);  // Short read, or longer than one ring read
+            return;
+        }
+    }
+
+    ::close(slot->fd);
+    slot->fd = -1;
+    slot->done = true;
+#else
+    Q_UNUSED(slot);
+    Q_UNUSED(result);
+#endif
+}
+
+void BulkFileReader::cancelAll() {
+    // Reads in flight write into the slots' buffers: wait for them before freeing
+    m_pool.clear();
+    m_pool.waitForDone();
+
+#ifdef HAVE_LIBURING
+    if (m_ring && m_ringPending > 0) {
+        io_uring_submit(m_ring.get());
+        while (m_ringPending > 0) {
+            io_uring_cqe *cqe = nullptr;
+            int result = io_uring_wait_cqe(m_ring.get(), &cqe);
+            if (result == -EINTR) {
+                continue;
+            }
+            if (result < 0) {
+                // The kernel may still write into them: leak rather than free
+                LOG_ERROR(QString("io_uring drain failed: %1").arg(qt_error_string(-result)));
+                for (std::unique_ptr<Slot> &slot : m_inFlight) {
+                    slot.release();
+                }
+                m_inFlight.clear();
+                m_ringPending = 0;
+                return;
+            }
+            io_uring_cqe_seen(m_ring.get(), cqe);
+            m_ringPending--;
+        }
+    }
+    for (const std::unique_ptr<Slot> &slot : m_inFlight) {
+        if (slot->fd >= 0) {
+            ::close(slot->fd);
+        }
+    }
+#endif
+
+    m_inFlight.clear();
+}
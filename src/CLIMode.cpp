@@ -11,16 +11,111 @@
 #include "MCPHandler.h"
 #include "Logger.h"
 #include "DiagnosticTests.h"
+#include "DaemonClient.h"
 #include "version.h"
+#include "BuiltinTools.h"
+#include "AgentLoop.h"
 #include <QCoreApplication>
 #include <QTimer>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 
-// Forward declare example tool functions from main.cpp
-extern QJsonObject exampleCalculatorTool(const QJsonObject &params);
-extern QJsonObject exampleDateTimeTool(const QJsonObject &params);
+// Send the prompt to a running daemon; it owns the LLM, tools, and RAG index
+static int runAttachedPrompt(const QString &daemonUrl, const QString &prompt) {
+    qInfo() << "\n=== CLI Mode - Attached to daemon ===";
+    qInfo().noquote() << "Daemon:" << daemonUrl;
+    qInfo() << "Prompt:" << prompt;
+
+    DaemonClient client(daemonUrl);
+    bool responseReceived = false;
+
+    QObject::connect(&client, &DaemonClient::responseReceived, [&](const QString &response) {
+        qInfo() << "\n=== Final Response ===";
+        qInfo().noquote() << response;
+        responseReceived = true;
+        QCoreApplication::quit();
+    });
+
+    QObject::connect(&client, &DaemonClient::errorOccurred, [](const QString &error) {
+        qCritical() << "Error:" << error;
+        QCoreApplication::quit();
+    });
+
+    client.sendMessage(prompt);
+
+    QTimer::singleShot(90000, []() {
+        qWarning() << "Timeout: No response received within 90 seconds";
+        QCoreApplication::quit();
+    });
+
+    QCoreApplication::exec();
+    return responseReceived ? 0 : 1;
+}
+
+// Run the prompt as an agent task; the loop executes tools and sends results back itself
+static int runAgentPrompt(const QCommandLineParser &parser, const QString &prompt,
+                          LLMClient *llmClient, MCPHandler *mcpHandler) {
+    AgentBudget budget;
+    budget.maxIterations = parser.value("agent-steps").toInt();
+    budget.maxTokens = parser.value("agent-tokens").toInt();
+    budget.maxTimeMs = parser.value("agent-time").toInt();
+    budget.maxParallelTools = qMax(1, parser.value("agent-parallel").toInt());
+
+    AgentLoop agent(llmClient, mcpHandler);
+    agent.setBudget(budget);
+
+    QObject::connect(&agent, &AgentLoop::iterationStarted, [](int iteration) {
+        qInfo() << "\n--- Model turn" << iteration << "---";
+    });
+
+    QObject::connect(&agent, &AgentLoop::stepStarted, [](int stepId, const QString &toolName) {
+        qInfo() << "🔧 Step" << stepId << "started:" << toolName;
+    });
+
+    QObject::connect(&agent, &AgentLoop::stepFinished,
+                     [](int stepId, const QString &toolName, bool ok, const QJsonObject &result, const QString &error) {
+        if (ok) {
+            qInfo() << "✓ Step" << stepId << "completed:" << toolName;
+            qInfo() << "   Result:" << QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+        } else {
+            qWarning() << "✗ Step" << stepId << "failed:" << toolName;
+            qWarning() << "   Error:" << error;
+        }
+    });
+
+    QObject::connect(&agent, &AgentLoop::finished, [&](const QString &answer) {
+        if (agent.stopReason() == AgentLoop::Error) {
+            qCritical() << "Error:" << agent.errorString();
+        } else if (agent.stopReason() != AgentLoop::Answered) {
+            qWarning() << "Agent stopped:" << AgentLoop::stopReasonName(agent.stopReason());
+        }
+
+        qInfo() << "\n=== Final Response ===";
+        qInfo().noquote() << answer;
+        qInfo() << "\n=== Agent Timeline ===";
+        qInfo().noquote() << agent.formatTimeline();
+
+        QTimer::singleShot(100, []() {
+            QCoreApplication::quit();
+        });
+    });
+
+    // Start after MCP discovery completes, like the single-turn path
+    QTimer::singleShot(200, [&]() {
+        qInfo() << "\nStarting agent task with" << mcpHandler->getRegisteredTools().size() << "tools...";
+        agent.start(prompt, mcpHandler->getToolsForLLM());
+    });
+
+    // The agent enforces its own budgets; this only guards against a hung backend
+    QTimer::singleShot(300000, []() {
+        qWarning() << "Timeout: Agent task did not finish within 300 seconds";
+        QCoreApplication::quit();
+    });
+
+    QCoreApplication::exec();
+    return agent.stopReason() == AgentLoop::Answered ? 0 : 1;
+}
 
 int runCLI(const QCommandLineParser &parser) {
     QString prompt = parser.value("prompt");
@@ -45,6 +140,10 @@ int runCLI(const QCommandLineParser &parser) {
         return 0;
     }
 
+    if (!prompt.isEmpty() && parser.isSet("attach")) {
+        return runAttachedPrompt(parser.value("attach"), prompt);
+    }
+
     if (!prompt.isEmpty()) {
         qInfo() << "\n=== CLI Mode - Tool Calling Test ===";
         qInfo() << "Prompt:" << prompt;
@@ -105,6 +204,15 @@ int runCLI(const QCommandLineParser &parser) {
             }
         });
 
+        if (parser.isSet("agent")) {
+            qInfo() << "Agent mode: max" << parser.value("agent-steps") << "model turns,"
+                    << parser.value("agent-parallel") << "parallel tool steps";
+            int exitCode = runAgentPrompt(parser, prompt, llmClient, mcpHandler);
+            delete llmClient;
+            delete mcpHandler;
+            return exitCode;
+        }
+
         // Track response state
         bool responseReceived = false;
         QString finalResponse;
@@ -19,7 +19,17 @@
 #include "MessageRenderer.h"
 #include "ToolUIManager.h"
 #include "RAGUIManager.h"
+#include "SpeculativeRetriever.h"
 #include "HTMLHandler.h"
+#include "DaemonClient.h"
+#include "BuiltinTools.h"
+#include "StartupProfiler.h"
+#include "ConversationJournal.h"
+#include "IngestionJournal.h"
+#include "ConversationLibrary.h"
+#include "ConversationLibraryDialog.h"
+#include "EngineThread.h"
+#include "AgentLoop.h"
 
 #include <QApplication>
 #include <QTextEdit>
@@ -39,6 +49,7 @@
 #include <QInputDialog>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <QScrollBar>
 #include <QClipboard>
 #include <QCloseEvent>
 #include <QUrl>
@@ -46,21 +57,37 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
-
-// Forward declare external tool functions
-extern QJsonObject exampleCalculatorTool(const QJsonObject &params);
-extern QJsonObject exampleDateTimeTool(const QJsonObject &params);
+#include <QJsonDocument>
 
 ChatWindow::ChatWindow(QWidget *parent)
     : QMainWindow(parent)
+    , statusBar(nullptr)
+    , memoryLabel(nullptr)
+    , engineThread(nullptr)
+    , llmClient(nullptr)
+    , ragEngine(nullptr)
+    , speculativeRetriever(nullptr)
+    , daemonClient(nullptr)
+    , agentLoop(nullptr)
+    , ragUIManager(nullptr)
+    , conversationLibrary(nullptr)
     , isStreaming(false)
     , streamingMessageCreated(false)
-    , lastSearchText("") {
+    , agentMode(false)
+    , agentTask(false)
+    , lastSearchText("")
+    , firstTokenMs(-1)
+    , transcriptMemory("transcript") {
     setWindowTitle(QString("%1 v%2").arg(APP_NAME, APP_VERSION));
     setMinimumSize(800, 600);
 
     // Create menu bar
-    createMenuBar();
+    {
+        StartupPhase phase("ChatWindow: menus");
+        createMenuBar();
+    }
+
+    int viewPhase = StartupProfiler::instance().beginPhase("ChatWindow: chat view");
 
     // Create central widget
     QWidget *centralWidget = new QWidget(this);
@@ -90,7 +117,8 @@ ChatWindow::ChatWindow(QWidget *parent)
     messageRenderer = new MessageRenderer(chatDisplay, this);
     connect(messageRenderer, &MessageRenderer::messageAppended, this, [this](const QString &sender, const QString &) {
         // Mark conversation as modified (except for system initialization messages)
-        if (sender != "System" || conversationManager->isModified()) {
+        // Messages of a saved conversation are journaled to its file as they complete
+        if (sender != "System" && conversationManager->currentFile().isEmpty()) {
             conversationManager->setModified(true);
         }
     });
@@ -100,6 +128,48 @@ ChatWindow::ChatWindow(QWidget *parent)
     connect(conversationManager, &ConversationManager::modificationStateChanged, this, &ChatWindow::updateWindowTitle);
     connect(conversationManager, &ConversationManager::conversationChanged, this, &ChatWindow::updateWindowTitle);
     connect(conversationManager, &ConversationManager::messagePosted, messageRenderer, &MessageRenderer::appendMessage);
+    connect(conversationManager, &ConversationManager::messagesRestored, this, [this](const QList<ChatEntry> &entries, bool prepend) {
+        if (prepend) {
+            messageRenderer->prependEntries(entries);
+        } else {
+            messageRenderer->appendEntries(entries);
+        }
+    });
+    connect(conversationManager, &ConversationManager::conversationStored, this, [this](const QString &fileName) {
+        // Journals are append-only, so this indexes only the new messages
+        if (ensureConversationLibrary()) {
+            conversationLibrary->indexFile(fileName);
+        }
+    });
+    connect(conversationManager, &ConversationManager::exportProgress, this, [this](int written, int total) {
+        if (total < 0) {
+            updateStatusBar();
+        } else if (statusBar) {
+            statusBar->showMessage(tr("Exporting conversation: %1 of %2 messages").arg(written).arg(total));
+        }
+    });
+    connect(conversationManager, &ConversationManager::historyRestored, this, [this](const QJsonArray &history) {
+        // When attached, the daemon keeps its own history
+        if (!daemonClient) {
+            QMetaObject::invokeMethod(llmClient, [client = llmClient, history]() {
+                client->setConversationHistory(history);
+            });
+        }
+    });
+
+    // Page in earlier messages of a loaded conversation when scrolled to the top
+    connect(chatDisplay->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+        QScrollBar *scrollBar = chatDisplay->verticalScrollBar();
+        if (value != scrollBar->minimum() || !conversationManager->hasEarlierMessages()) {
+            return;
+        }
+        // Outside the scroll handler, and only once per arrival at the top
+        QTimer::singleShot(0, this, [this, scrollBar]() {
+            if (scrollBar->value() == scrollBar->minimum()) {
+                conversationManager->loadEarlierMessages();
+            }
+        });
+    });
 
     // Thinking indicator
     thinkingLabel = new QLabel(this);
@@ -162,16 +232,35 @@ ChatWindow::ChatWindow(QWidget *parent)
     // Connect signals
     connect(sendButton, &QPushButton::clicked, this, &ChatWindow::sendMessage);
     connect(inputField, &QLineEdit::returnPressed, this, &ChatWindow::sendMessage);
+    connect(inputField, &QLineEdit::textEdited, this, &ChatWindow::handleInputEdited);
+    StartupProfiler::instance().endPhase(viewPhase);
 
     // Initialize LLM client
-    llmClient = new LLMClient(this);
+    int llmPhase = StartupProfiler::instance().beginPhase("ChatWindow: LLM client");
+    // Network engines run on their own thread; the GUI thread only renders
+    engineThread = new EngineThread("Engines", this);
+    llmClient = engineThread->create<LLMClient>();
     connect(llmClient, &LLMClient::responseReceived, this, &ChatWindow::handleLLMResponse);
     connect(llmClient, &LLMClient::errorOccurred, this, &ChatWindow::handleLLMError);
     connect(llmClient, &LLMClient::tokenReceived, this, &ChatWindow::handleStreamingToken);
     connect(llmClient, &LLMClient::retryAttempt, this, &ChatWindow::handleRetryAttempt);
     connect(llmClient, &LLMClient::toolCallRequested, this, &ChatWindow::handleToolCallRequest);
+    connect(llmClient, &LLMClient::generationStats, this, [this](int promptTokens, int completionTokens, qint64 totalDurationMs) {
+        if (promptTokens >= 0) {
+            responseTimings["prompt_tokens"] = promptTokens;
+        }
+        if (completionTokens >= 0) {
+            responseTimings["completion_tokens"] = completionTokens;
+        }
+        responseTimings["total_ms"] = totalDurationMs;
+    });
+
+    // Attach to a running daemon if configured
+    setupDaemonClient();
+    StartupProfiler::instance().endPhase(llmPhase);
 
     // Initialize MCP handler and register tools
+    int mcpPhase = StartupProfiler::instance().beginPhase("ChatWindow: MCP tools");
     mcpHandler = new MCPHandler(this);
     registerLocalTools();  // Register local tools immediately (no network needed)
     connect(mcpHandler, &MCPHandler::toolCallCompleted, this, &ChatWindow::handleToolCallCompleted);
@@ -179,10 +268,29 @@ ChatWindow::ChatWindow(QWidget *parent)
     
     // Initialize tool UI manager
     toolUIManager = new ToolUIManager(mcpHandler, this);
+
+    // Agent mode: the loop executes tools and sends results back itself
+    agentLoop = new AgentLoop(llmClient, mcpHandler, this);
+    connect(agentLoop, &AgentLoop::iterationStarted, this, [this](int iteration) {
+        if (iteration > 1) {
+            // A new model turn streams into a new message
+            currentStreamingResponse.clear();
+            streamingMessageCreated = false;
+            isStreaming = true;
+        }
+    });
+    connect(agentLoop, &AgentLoop::stepFinished, this, &ChatWindow::handleAgentStepFinished);
+    connect(agentLoop, &AgentLoop::finished, this, &ChatWindow::handleAgentFinished);
+    StartupProfiler::instance().endPhase(mcpPhase);
     
     // Defer MCP server discovery until event loop is running (network manager needs to be ready)
     QTimer::singleShot(100, this, [this]() {
-        registerConfiguredServers();
+        StartupPhase phase("MCP server discovery");
+
+        // When attached, the daemon owns the MCP servers
+        if (!daemonClient) {
+            registerConfiguredServers();
+        }
         updateStatusBar();  // Update status bar with discovered tools
         
         // Show registered tools in chat
@@ -197,45 +305,180 @@ ChatWindow::ChatWindow(QWidget *parent)
         }
     });
 
-    // Initialize RAG engine
-    ragEngine = new RAGEngine(this);
-    ragEngine->setEmbeddingModel(Config::instance().getRagEmbeddingModel());
-    ragEngine->setChunkSize(Config::instance().getRagChunkSize());
-    ragEngine->setChunkOverlap(Config::instance().getRagChunkOverlap());
-    connect(ragEngine, &RAGEngine::contextRetrieved, this, &ChatWindow::handleRAGContextRetrieved);
-    connect(ragEngine, &RAGEngine::queryError, this, &ChatWindow::handleRAGError);
+    // Apply settings hot-reloaded from the config file
+    connect(&Config::instance(), &Config::configChanged, this, &ChatWindow::handleConfigChanged);
+
+    // The RAG engine is not needed for the first frame: build it alongside
+    // MCP discovery once the window is up when RAG is enabled, otherwise on
+    // first use (document menu actions or enabling RAG in settings)
+    if (Config::instance().getRagEnabled()) {
+        QTimer::singleShot(100, this, &ChatWindow::ensureRagEngine);
+    }
+
+    // Create status bar
+    {
+        StartupPhase phase("ChatWindow: status bar");
+        statusBar = new QStatusBar(this);
+        setStatusBar(statusBar);
+        updateStatusBar();
+    }
+
+    setupMemoryGovernor();
+
+    // Add welcome message
+    StartupPhase welcomePhase("ChatWindow: welcome");
+    messageRenderer->appendMessage("System", tr("Welcome to %1!").arg(APP_NAME));
+    messageRenderer->appendMessage("System", tr("This is a Qt5 chatbot application with MCP and RAG integration."));
+    QString backend = Config::instance().getBackend();
+    QString model = Config::instance().getModel();
+    messageRenderer->appendMessage("System", tr("Backend: %1 | Model: %2").arg(backend, model));
+    
+    // Tool list will be shown after MCP server discovery completes
+
+    // Restore a conversation left unsaved by a crash or by closing the window
+    QTimer::singleShot(0, this, [this]() {
+        StartupPhase phase("Conversation recovery");
+        conversationManager->recoverUnsavedConversation();
+    });
+}
+
+ChatWindow::~ChatWindow() {
+    // Engines deliver results through queued signals to this window and its
+    // managers, so they must be gone before any of those are destroyed
+    engineThread->stop();
+}
+
+void ChatWindow::setupMemoryGovernor() {
+    MemoryGovernor &governor = MemoryGovernor::instance();
+
+    QTextDocument *document = chatDisplay->document();
+    connect(document, &QTextDocument::contentsChanged, this, [this, document]() {
+        transcriptMemory.set(static_cast<qint64>(document->characterCount()) * sizeof(QChar));
+    });
+
+    // The display is deleted in closeEvent(), before this window: it owns the shedders
+    governor.addShedder(MemoryGovernor::RenderCaches, chatDisplay, [document]() {
+        document->clearUndoRedoStacks();  // Every streamed update is recorded, though the view is read-only
+    });
+    governor.addShedder(MemoryGovernor::TranscriptHtml, chatDisplay, [this]() {
+        // The streaming response isn't journaled yet and would be lost
+        if (!isStreaming) {
+            conversationManager->compactTranscript();
+        }
+    });
+
+    memoryLabel = new QLabel(statusBar);
+    statusBar->addPermanentWidget(memoryLabel);
+    connect(&governor, &MemoryGovernor::sampled, memoryLabel, [this]() {
+        MemoryGovernor &governor = MemoryGovernor::instance();
+        memoryLabel->setText(tr("Mem: %1").arg(governor.summary()));
+
+        QStringList lines;
+        const QMap<QString, qint64> subsystems = governor.subsystems();
+        for (auto it = subsystems.constBegin(); it != subsystems.constEnd(); ++it) {
+            lines << QString("%1: %2 KB").arg(it.key()).arg(it.value() / 1024);
+        }
+        lines << tr("Pressure: %1").arg(MemoryGovernor::pressureName(governor.pressure()));
+        memoryLabel->setToolTip(lines.join("\n"));
+
+        switch (governor.pressure()) {
+        case MemoryGovernor::Over:
+            memoryLabel->setStyleSheet("color: #c62828; font-weight: bold;");
+            break;
+        case MemoryGovernor::Elevated:
+            memoryLabel->setStyleSheet("color: #ef6c00;");
+            break;
+        default:
+            memoryLabel->setStyleSheet(QString());
+            break;
+        }
+    });
+}
+
+bool ChatWindow::ensureConversationLibrary() {
+    if (conversationLibrary) {
+        return conversationLibrary->isOpen();
+    }
+
+    conversationLibrary = new ConversationLibrary(this);
+    if (!conversationLibrary->open()) {
+        LOG_WARNING(QString("Conversation library unavailable: %1").arg(conversationLibrary->lastError()));
+        return false;
+    }
+    return true;
+}
+
+void ChatWindow::ensureRagEngine() {
+    if (ragEngine) {
+        return;
+    }
+
+    StartupPhase phase("RAG engine");
+
+    // Initialize RAG engine on the engine thread; it isn't shared yet, so
+    // configure it before anything else can queue work to it
+    ragEngine = engineThread->create<RAGEngine>();
+    if (!ragEngine) {
+        return;
+    }
+    // Before the journal is opened below, which may emit it
+    connect(ragEngine, &RAGEngine::ingestionResumed, this, [this](int documentCount, int /*chunkCount*/, int pendingCount) {
+        statusBar->showMessage(pendingCount > 0
+            ? tr("RAG: restored %1 documents, embedding %2 remaining chunks").arg(documentCount).arg(pendingCount)
+            : tr("RAG: restored %1 documents").arg(documentCount), 5000);
+        updateStatusBar();
+    });
+
+    // The journal goes last: restored vectors are kept only if they match the settings above
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    QMetaObject::invokeMethod(ragEngine, [engine = ragEngine, cfg]() {
+        engine->setEmbeddingProvider(cfg->ragEmbeddingProvider, cfg->ragEmbeddingUrl, cfg->openaiApiKey);
+        engine->setDimensionReduction(cfg->ragDimensionReduction, cfg->ragEmbeddingDimensions);
+        engine->setEmbeddingModel(cfg->ragEmbeddingModel);
+        engine->setChunkSize(cfg->ragChunkSize);
+        engine->setChunkOverlap(cfg->ragChunkOverlap);
+        engine->setChunkTokens(cfg->ragChunkTokens);
+        engine->setTokenizer(cfg->ragTokenizer);
+        engine->setRetrievalDeadline(cfg->ragDeadlineMs);
+        engine->setIngestionJournal(cfg->ragJournal ? IngestionJournal::defaultPath("ingestion") : QString());
+    });
+
+    // Retrieval starts while the message is typed; sends reuse it when the text matches
+    speculativeRetriever = new SpeculativeRetriever(ragEngine, this);
+    connect(speculativeRetriever, &SpeculativeRetriever::contextReady, this,
+            [this](const QStringList &contexts, bool speculative) {
+        responseTimings["retrieval_ms"] = responseTimer.elapsed();
+        responseTimings["retrieval_speculative"] = speculative;
+        handleRAGContextRetrieved(contexts);
+    });
+    connect(speculativeRetriever, &SpeculativeRetriever::retrievalFailed, this, &ChatWindow::handleRAGError);
+    connect(ragEngine, &RAGEngine::retrievalDegraded, this, [this](int /*requestId*/, const QString &reason) {
+        statusBar->showMessage(tr("RAG: vector search unavailable (%1), using keyword matches").arg(reason), 5000);
+    });
+
     LOG_INFO(QString("RAG Engine initialized (enabled: %1)").arg(Config::instance().getRagEnabled() ? "yes" : "no"));
     
     // Initialize RAG UI manager
     ragUIManager = new RAGUIManager(ragEngine, this);
     connect(ragUIManager, &RAGUIManager::documentIngested, this, [this](const QString &filename, int chunkCount) {
+        speculativeRetriever->invalidate();
         messageRenderer->appendMessage("System", tr("Document ingested successfully: %1 (total chunks: %2)")
             .arg(filename).arg(chunkCount));
     });
     connect(ragUIManager, &RAGUIManager::directoryIngested, this, [this](const QString & /*path*/, int chunkCount) {
+        speculativeRetriever->invalidate();
         messageRenderer->appendMessage("System", tr("Directory ingested successfully. Total chunks: %1").arg(chunkCount));
     });
     connect(ragUIManager, &RAGUIManager::ingestionFailed, this, [this](const QString &error) {
         messageRenderer->appendMessage("System", error);
     });
     connect(ragUIManager, &RAGUIManager::documentsCleared, this, [this]() {
+        speculativeRetriever->invalidate();
         messageRenderer->appendMessage("System", tr("All RAG documents cleared."));
     });
     connect(ragUIManager, &RAGUIManager::statusUpdated, this, &ChatWindow::updateStatusBar);
 
-    // Create status bar
-    statusBar = new QStatusBar(this);
-    setStatusBar(statusBar);
     updateStatusBar();
-
-    // Add welcome message
-    messageRenderer->appendMessage("System", tr("Welcome to %1!").arg(APP_NAME));
-    messageRenderer->appendMessage("System", tr("This is a Qt5 chatbot application with MCP and RAG integration."));
-    QString backend = Config::instance().getBackend();
-    QString model = Config::instance().getModel();
-    messageRenderer->appendMessage("System", tr("Backend: %1 | Model: %2").arg(backend, model));
-    
-    // Tool list will be shown after MCP server discovery completes
 }
 
 void ChatWindow::sendMessage() {
@@ -247,6 +490,15 @@ void ChatWindow::sendMessage() {
     // Display user message
     messageRenderer->appendMessage("You", message);
 
+    ConversationMessage userMessage;
+    userMessage.role = "user";
+    userMessage.content = message;
+    conversationManager->recordMessage(userMessage);
+
+    responseTimer.start();
+    firstTokenMs = -1;
+    responseTimings = QJsonObject();
+
     // Clear input and disable while waiting
     inputField->clear();
     inputField->setEnabled(false);
@@ -257,25 +509,57 @@ void ChatWindow::sendMessage() {
     streamingMessageCreated = false;
     currentStreamingResponse.clear();
     currentPrompt = message; // Store for potential tool result follow-up
+    agentTask = agentMode;
+    agentCallIds.clear();
     ragContext.clear();
 
     // Show thinking indicator
     showThinkingIndicator();
 
+    // Attached to a daemon: it handles RAG and tool calls
+    if (daemonClient) {
+        daemonClient->sendMessage(message);
+        return;
+    }
+
     // Check if RAG is enabled and has documents
     if (Config::instance().getRagEnabled() && ragEngine && ragEngine->getChunkCount() > 0) {
         LOG_INFO("RAG enabled - retrieving context");
-        // Retrieve context asynchronously - will trigger handleRAGContextRetrieved
-        int topK = Config::instance().getRagTopK();
-        ragEngine->retrieveContext(message, topK);
+        // Reuses the retrieval started while typing if it matches; either way
+        // the context arrives through handleRAGContextRetrieved
+        speculativeRetriever->retrieve(message, Config::instance().getRagTopK());
     } else {
         // No RAG - send directly to LLM
-        if (toolUIManager && mcpHandler) {
-            QJsonArray tools = toolUIManager->getEnabledTools();
-            llmClient->sendPromptWithTools(message, tools);
-        } else {
-            llmClient->sendPrompt(message);
-        }
+        dispatchPrompt(message);
+    }
+}
+
+void ChatWindow::handleInputEdited(const QString &text) {
+    // Daemon-attached sessions retrieve on the daemon
+    if (!speculativeRetriever || daemonClient) {
+        return;
+    }
+
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    if (!cfg->ragEnabled || !cfg->ragSpeculative || ragEngine->getChunkCount() == 0) {
+        return;
+    }
+    speculativeRetriever->speculate(text.trimmed(), cfg->ragTopK);
+}
+
+void ChatWindow::dispatchPrompt(const QString &prompt) {
+    // Tools are read here, on the GUI thread, where MCPHandler lives
+    if (agentTask) {
+        agentLoop->start(prompt, toolUIManager->getEnabledTools());
+    } else if (toolUIManager && mcpHandler) {
+        QJsonArray tools = toolUIManager->getEnabledTools();
+        QMetaObject::invokeMethod(llmClient, [client = llmClient, prompt, tools]() {
+            client->sendPromptWithTools(prompt, tools);
+        });
+    } else {
+        QMetaObject::invokeMethod(llmClient, [client = llmClient, prompt]() {
+            client->sendPrompt(prompt);
+        });
     }
 }
 
@@ -284,6 +568,10 @@ void ChatWindow::handleStreamingToken(const QString &token) {
         return;
     }
 
+    if (firstTokenMs < 0 && responseTimer.isValid()) {
+        firstTokenMs = responseTimer.elapsed();
+    }
+
     // Hide thinking indicator and create initial message on first token
     if (currentStreamingResponse.isEmpty() && !streamingMessageCreated) {
         hideThinkingIndicator();
@@ -333,6 +621,19 @@ void ChatWindow::handleLLMResponse(const QString &response) {
             // Create new bot message
             messageRenderer->appendMessage("Bot", finalResponse);
         }
+
+        ConversationMessage assistantMessage;
+        assistantMessage.role = "assistant";
+        assistantMessage.content = finalResponse;
+        assistantMessage.timings = responseTimings;
+        if (firstTokenMs >= 0) {
+            assistantMessage.timings["ttft_ms"] = firstTokenMs;
+        }
+        if (responseTimer.isValid()) {
+            assistantMessage.timings["elapsed_ms"] = responseTimer.elapsed();
+        }
+        conversationManager->recordMessage(assistantMessage);
+        responseTimings = QJsonObject();
     }
 
     // Clear for next response
@@ -422,6 +723,21 @@ void ChatWindow::handleToolCallRequest(const QString &toolName, const QJsonObjec
 
     LOG_INFO(QString("Tool call requested: %1 (ID: %2)").arg(toolName, callId));
 
+    QJsonObject call;
+    call["id"] = callId;
+    call["name"] = toolName;
+    call["arguments"] = parameters;
+    ConversationMessage toolCallMessage;
+    toolCallMessage.role = "assistant";
+    toolCallMessage.toolCalls.append(call);
+    conversationManager->recordMessage(toolCallMessage);
+
+    // In agent mode the loop executes the call as a step
+    if (agentTask) {
+        agentCallIds.append(callId);
+        return;
+    }
+
     // Execute the tool via MCP handler
     if (mcpHandler) {
         mcpHandler->executeToolCall(toolName, parameters);
@@ -429,8 +745,19 @@ void ChatWindow::handleToolCallRequest(const QString &toolName, const QJsonObjec
 }
 
 void ChatWindow::handleToolCallCompleted(const QString &toolCallId, const QString &toolName, const QJsonObject &result) {
+    if (agentTask) {
+        return;  // Reported through handleAgentStepFinished()
+    }
+
     LOG_INFO(QString("Tool call completed: %1 (ID: %2)").arg(toolName, toolCallId));
 
+    ConversationMessage toolMessage;
+    toolMessage.role = "tool";
+    toolMessage.toolName = toolName;
+    toolMessage.toolCallId = toolCallId;
+    toolMessage.content = QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+    conversationManager->recordMessage(toolMessage);
+
     // Don't show success widget - we'll show the natural response directly
     // Send result to be formatted as natural language
     QJsonArray toolResults;
@@ -447,12 +774,26 @@ void ChatWindow::handleToolCallCompleted(const QString &toolCallId, const QStrin
     LOG_INFO("Reset streaming state for tool result response");
 
     // sendToolResults will emit responseReceived with formatted natural language
-    llmClient->sendToolResults(currentPrompt, toolResults);
+    QMetaObject::invokeMethod(llmClient, [client = llmClient, prompt = currentPrompt, toolResults]() {
+        client->sendToolResults(prompt, toolResults);
+    });
 }
 
 void ChatWindow::handleToolCallFailed(const QString &toolCallId, const QString &toolName, const QString &error) {
+    if (agentTask) {
+        return;  // Reported through handleAgentStepFinished()
+    }
+
     LOG_ERROR(QString("Tool call failed: %1 (ID: %2) - %3").arg(toolName, toolCallId, error));
 
+    ConversationMessage toolMessage;
+    toolMessage.role = "tool";
+    toolMessage.toolName = toolName;
+    toolMessage.toolCallId = toolCallId;
+    toolMessage.content = error;
+    toolMessage.isError = true;
+    conversationManager->recordMessage(toolMessage);
+
     // Tool error widget
     QString errorWidget = HTMLHandler::createToolErrorWidget(toolName, error);
     chatDisplay->append(errorWidget);
@@ -463,6 +804,55 @@ void ChatWindow::handleToolCallFailed(const QString &toolCallId, const QString &
     inputField->setFocus();
 }
 
+void ChatWindow::handleAgentStepFinished(int stepId, const QString &toolName, bool ok, const QJsonObject &result, const QString &error) {
+    if (!agentTask) {
+        return;
+    }
+
+    QString callId = stepId <= agentCallIds.size() ? agentCallIds[stepId - 1] : QString("step-%1").arg(stepId);
+    LOG_INFO(QString("Agent step %1 %2: %3 (ID: %4)").arg(stepId).arg(ok ? "completed" : "failed").arg(toolName, callId));
+
+    ConversationMessage toolMessage;
+    toolMessage.role = "tool";
+    toolMessage.toolName = toolName;
+    toolMessage.toolCallId = callId;
+    toolMessage.content = ok ? QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact)) : error;
+    toolMessage.isError = !ok;
+    conversationManager->recordMessage(toolMessage);
+
+    // Failures are shown; the model sees them in its next turn and carries on
+    if (!ok) {
+        chatDisplay->append(HTMLHandler::createToolErrorWidget(toolName, error));
+        messageRenderer->clearLastMessageSender();
+    }
+}
+
+void ChatWindow::handleAgentFinished() {
+    if (!agentTask) {
+        return;
+    }
+    agentTask = false;
+
+    LOG_INFO(QString("Agent timeline:\n%1").arg(agentLoop->formatTimeline()));
+
+    // Answers and client errors were already handled by handleLLMResponse()/handleLLMError()
+    AgentLoop::StopReason reason = agentLoop->stopReason();
+    if (reason != AgentLoop::Answered && reason != AgentLoop::Error) {
+        isStreaming = false;
+        hideThinkingIndicator();
+        messageRenderer->appendMessage("System", tr("Agent stopped: %1").arg(AgentLoop::stopReasonName(reason)));
+        inputField->setEnabled(true);
+        sendButton->setEnabled(true);
+        inputField->setFocus();
+    }
+
+    if (!agentLoop->steps().isEmpty()) {
+        messageRenderer->appendMessage("System", tr("Agent: %1 steps in %2 model turns, %3 ms")
+                                       .arg(agentLoop->steps().size()).arg(agentLoop->iterations())
+                                       .arg(agentLoop->elapsedMs()));
+    }
+}
+
 void ChatWindow::handleRAGContextRetrieved(const QStringList &contexts) {
     LOG_INFO(QString("RAG retrieved %1 context chunks").arg(contexts.size()));
 
@@ -480,24 +870,14 @@ void ChatWindow::handleRAGContextRetrieved(const QStringList &contexts) {
     QString enhancedPrompt = ragContext + "USER QUESTION: " + currentPrompt;
 
     // Send to LLM with tools if enabled
-    if (toolUIManager && mcpHandler) {
-        QJsonArray tools = toolUIManager->getEnabledTools();
-        llmClient->sendPromptWithTools(enhancedPrompt, tools);
-    } else {
-        llmClient->sendPrompt(enhancedPrompt);
-    }
+    dispatchPrompt(enhancedPrompt);
 }
 
 void ChatWindow::handleRAGError(const QString &error) {
     LOG_WARNING(QString("RAG error: %1 - proceeding without RAG context").arg(error));
 
     // Proceed with original prompt without RAG context
-    if (toolUIManager && mcpHandler) {
-        QJsonArray tools = toolUIManager->getEnabledTools();
-        llmClient->sendPromptWithTools(currentPrompt, tools);
-    } else {
-        llmClient->sendPrompt(currentPrompt);
-    }
+    dispatchPrompt(currentPrompt);
 }
 
 void ChatWindow::toggleLightTheme() {
@@ -524,8 +904,12 @@ void ChatWindow::openSettings() {
 
     if (dialog.exec() == QDialog::Accepted) {
         // Settings were saved, update LLM client if needed
-        llmClient->setModel(Config::instance().getModel());
-        llmClient->setApiUrl(Config::instance().getApiUrl());
+        std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+        QMetaObject::invokeMethod(llmClient, [client = llmClient, cfg]() {
+            client->setModel(cfg->model);
+            client->setApiUrl(cfg->apiUrl);
+        });
+        MemoryGovernor::instance().setBudget(static_cast<qint64>(cfg->memoryBudgetMb) * 1024 * 1024);
         LOG_INFO("Settings updated from dialog");
 
         // Update status bar
@@ -533,6 +917,58 @@ void ChatWindow::openSettings() {
     }
 }
 
+void ChatWindow::handleConfigChanged(Config::Sections sections) {
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    QStringList changed;
+
+    if (sections & Config::LLMSection) {
+        setupDaemonClient();
+        QMetaObject::invokeMethod(llmClient, [client = llmClient, cfg]() {
+            client->setModel(cfg->model);
+            client->setApiUrl(cfg->apiUrl);
+            client->queryModelCapabilities();
+        });
+        changed << tr("model");
+    }
+
+    if (sections & Config::GenerationSection) {
+        // Picked up by the next request, which reads a fresh snapshot
+        changed << tr("generation parameters");
+    }
+
+    if (sections & Config::RAGSection) {
+        if (speculativeRetriever) {
+            speculativeRetriever->invalidate();  // Embedding model or top K may have changed
+        }
+        if (ragEngine) {
+            QMetaObject::invokeMethod(ragEngine, [engine = ragEngine, cfg]() {
+                engine->setEmbeddingProvider(cfg->ragEmbeddingProvider, cfg->ragEmbeddingUrl, cfg->openaiApiKey);
+                engine->setDimensionReduction(cfg->ragDimensionReduction, cfg->ragEmbeddingDimensions);
+                engine->setEmbeddingModel(cfg->ragEmbeddingModel);
+                engine->setChunkSize(cfg->ragChunkSize);
+                engine->setChunkOverlap(cfg->ragChunkOverlap);
+                engine->setChunkTokens(cfg->ragChunkTokens);
+                engine->setTokenizer(cfg->ragTokenizer);
+                engine->setRetrievalDeadline(cfg->ragDeadlineMs);
+                engine->setIngestionJournal(cfg->ragJournal ? IngestionJournal::defaultPath("ingestion") : QString());
+            });
+        } else if (cfg->ragEnabled) {
+            ensureRagEngine();  // Reads the new settings from Config
+        }
+        changed << tr("RAG");
+    }
+
+    if (sections & Config::MCPSection) {
+        refreshMcpTools();
+        changed << tr("MCP servers");
+    }
+
+    updateStatusBar();
+
+    LOG_INFO(QString("Applied reloaded configuration: %1").arg(changed.join(", ")));
+    messageRenderer->appendMessage("System", tr("Configuration reloaded (%1)").arg(changed.join(", ")));
+}
+
 void ChatWindow::refreshMcpTools() {
     if (!mcpHandler) {
         return;
@@ -582,6 +1018,10 @@ void ChatWindow::clearConversation() {
 
     if (reply == QMessageBox::Yes) {
         messageRenderer->clear();
+        if (daemonClient) {
+            daemonClient->clearConversationHistory();
+        }
+        conversationManager->endConversation();
         conversationManager->setModified(false);
         conversationManager->clearCurrentFile();
         LOG_INFO("Conversation cleared");
@@ -654,25 +1094,42 @@ void ChatWindow::exportConversation() {
     conversationManager->exportConversation();
 }
 
+void ChatWindow::showConversationLibrary() {
+    if (!ensureConversationLibrary()) {
+        QMessageBox::warning(this, tr("Conversation Library"),
+            tr("The conversation library could not be opened:\n%1").arg(conversationLibrary->lastError()));
+        return;
+    }
+
+    ConversationLibraryDialog dialog(conversationLibrary, this);
+    connect(&dialog, &ConversationLibraryDialog::conversationSelected,
+            conversationManager, &ConversationManager::openConversationFile);
+    dialog.exec();
+}
+
 void ChatWindow::ingestDocument() {
+    ensureRagEngine();
     if (ragUIManager) {
         ragUIManager->ingestDocument();
     }
 }
 
 void ChatWindow::ingestDirectory() {
+    ensureRagEngine();
     if (ragUIManager) {
         ragUIManager->ingestDirectory();
     }
 }
 
 void ChatWindow::viewDocuments() {
+    ensureRagEngine();
     if (ragUIManager) {
         ragUIManager->viewDocuments();
     }
 }
 
 void ChatWindow::clearDocuments() {
+    ensureRagEngine();
     if (ragUIManager) {
         ragUIManager->clearDocuments();
     }
@@ -699,7 +1156,9 @@ void ChatWindow::updateStatusBar() {
     QString apiUrl = Config::instance().getApiUrl();
 
     QString statusText;
-    if (backend == "ollama") {
+    if (daemonClient) {
+        statusText = QString("Daemon: %1 | Model: %2").arg(daemonClient->getBaseUrl(), model);
+    } else if (backend == "ollama") {
         // Extract host and port from URL
         QUrl url(apiUrl);
         QString host = url.host();
@@ -738,6 +1197,12 @@ void ChatWindow::closeEvent(QCloseEvent *event) {
     fprintf(stderr, "[DEBUG] closeEvent: Start\n");
     fflush(stderr);
 
+    // Sync the conversation journal; std::exit below skips destructors
+    conversationManager->shutdown();
+
+    // Tear down the network engines on their own thread
+    engineThread->stop();
+
     // Close log viewer BEFORE ChatWindow starts destroying to prevent X11 conflicts
     LogViewerDialog* viewer = LogViewerDialog::instance();
     if (viewer) {
@@ -817,7 +1282,10 @@ void ChatWindow::registerTools() {
 
     // Register tools from configured MCP servers (deferred to event loop)
     QTimer::singleShot(100, this, [this]() {
-        registerConfiguredServers();
+        // When attached, the daemon owns the MCP servers
+        if (!daemonClient) {
+            registerConfiguredServers();
+        }
         LOG_INFO(QString("Registered %1 MCP tools total").arg(mcpHandler->getRegisteredTools().size()));
     });
 }
@@ -856,6 +1324,36 @@ void ChatWindow::registerLocalTools() {
     LOG_DEBUG(QString("Registered %1 built-in local tools").arg(2));
 }
 
+void ChatWindow::setupDaemonClient() {
+    QString daemonUrl = Config::instance().getDaemonUrl();
+
+    if (daemonUrl.isEmpty()) {
+        if (daemonClient) {
+            LOG_INFO("Detaching from daemon, using in-process engines");
+            daemonClient->deleteLater();
+            daemonClient = nullptr;
+            registerConfiguredServers();
+        }
+        return;
+    }
+
+    if (daemonClient) {
+        daemonClient->setBaseUrl(daemonUrl);
+        return;
+    }
+
+    daemonClient = new DaemonClient(daemonUrl, this);
+    connect(daemonClient, &DaemonClient::responseReceived, this, &ChatWindow::handleLLMResponse);
+    connect(daemonClient, &DaemonClient::errorOccurred, this, &ChatWindow::handleLLMError);
+    connect(daemonClient, &DaemonClient::tokenReceived, this, &ChatWindow::handleStreamingToken);
+    connect(daemonClient, &DaemonClient::healthChecked, this, [this, daemonUrl](bool reachable, const QJsonObject &) {
+        if (!reachable) {
+            messageRenderer->appendMessage("System", tr("Daemon at %1 is not reachable.").arg(daemonUrl));
+        }
+    });
+    daemonClient->checkHealth();
+}
+
 void ChatWindow::registerConfiguredServers() {
     if (!mcpHandler) {
         return;
@@ -920,6 +1418,11 @@ void ChatWindow::createMenuBar() {
     connect(loadAction, &QAction::triggered, this, &ChatWindow::loadConversation);
     fileMenu->addAction(loadAction);
 
+    QAction *libraryAction = new QAction(tr("Conversation &Library..."), this);
+    libraryAction->setShortcut(QKeySequence("Ctrl+Shift+O"));
+    connect(libraryAction, &QAction::triggered, this, &ChatWindow::showConversationLibrary);
+    fileMenu->addAction(libraryAction);
+
     fileMenu->addSeparator();
 
     QAction *exportAction = new QAction(tr("&Export Conversation..."), this);
@@ -984,6 +1487,15 @@ void ChatWindow::createMenuBar() {
     connect(manageToolsAction, &QAction::triggered, this, &ChatWindow::showToolsDialog);
     viewMenu->addAction(manageToolsAction);
 
+    QAction *agentModeAction = new QAction(tr("&Agent Mode"), this);
+    agentModeAction->setCheckable(true);
+    agentModeAction->setStatusTip(tr("Let the model chain tool calls over several turns; independent calls run in parallel"));
+    connect(agentModeAction, &QAction::toggled, this, [this](bool checked) {
+        agentMode = checked;
+        LOG_INFO(QString("Agent mode %1").arg(checked ? "enabled" : "disabled"));
+    });
+    viewMenu->addAction(agentModeAction);
+
     QAction *viewLogsAction = new QAction(tr("&Log Viewer..."), this);
     viewLogsAction->setShortcut(QKeySequence("Ctrl+Shift+L"));
     connect(viewLogsAction, &QAction::triggered, this, &ChatWindow::showLogViewer);
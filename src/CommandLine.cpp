@@ -0,0 +1,204 @@
+/**
+ * CommandLine.cpp - Command-line options and headless mode dispatch
+ *
+ * Defines the options understood by both binaries, applies the global
+ * ones (logging, model override, stream tracing) and routes to the
+ * headless modes.
+ */
+
+#include "CommandLine.h"
+#include "version.h"
+#include "Logger.h"
+#include "Config.h"
+#include "StreamTrace.h"
+#include "StartupProfiler.h"
+#include "TestMCPStdioServer.h"
+#include "CLIMode.h"
+#include "DaemonMode.h"
+#include "BatchRunner.h"
+#include "BenchMode.h"
+#include <QCommandLineOption>
+#include <QDebug>
+
+bool isHeadlessInvocation(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        QString arg = QString(argv[i]);
+        if (arg == "--cli" || arg == "--batch" || arg == "--bench") {
+            return true;
+        }
+        if (arg == "--test-mcp-stdio" || arg == "--daemon") {
+            return true;
+        }
+        if (arg == "--mcp-test" || arg == "--rag-test" || arg == "--unit-tests") {
+            return true;
+        }
+    }
+    return false;
+}
+
+void addCommandLineOptions(QCommandLineParser &parser) {
+    parser.setApplicationDescription(APP_DESCRIPTION);
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    // CLI options
+    parser.addOption(QCommandLineOption("cli", "Run in CLI-only mode"));
+    parser.addOption(QCommandLineOption("prompt", "Text prompt for the model", "text"));
+    parser.addOption(QCommandLineOption("context", "Load file or folder into RAG", "path"));
+    parser.addOption(QCommandLineOption("model", "Override default model", "name"));
+    parser.addOption(QCommandLineOption("log-level",
+        "Set verbosity (debug|info|warn|error)", "level", "info"));
+    parser.addOption(QCommandLineOption("mcp-test", "Run Model Context Protocol diagnostic"));
+    parser.addOption(QCommandLineOption("rag-test", "Test retrieval pipeline"));
+    parser.addOption(QCommandLineOption("unit-tests", "Execute unit test suite"));
+    parser.addOption(QCommandLineOption("test-mcp-stdio",
+        "Run test MCP server in stdio mode (for testing MCP integration)"));
+
+    // Daemon options
+    parser.addOption(QCommandLineOption("daemon",
+        "Run headless daemon serving an OpenAI-compatible API (/v1/chat/completions)"));
+    parser.addOption(QCommandLineOption("host", "Daemon listen address", "address", "127.0.0.1"));
+    parser.addOption(QCommandLineOption("port",
+        QString("Daemon listen port (default: %1)").arg(DAEMON_DEFAULT_PORT), "port"));
+    parser.addOption(QCommandLineOption("attach",
+        "Send the CLI prompt to a running daemon instead of starting local engines", "url"));
+
+    // Batch options
+    parser.addOption(QCommandLineOption("batch",
+        "Run prompts from a JSONL file (or - for stdin) and write results as JSONL", "path"));
+    parser.addOption(QCommandLineOption("out", "Batch results file (JSONL)", "path"));
+    parser.addOption(QCommandLineOption("concurrency", "Max batch prompts in flight", "n", "4"));
+    parser.addOption(QCommandLineOption("timeout", "Per-prompt batch timeout", "ms", "120000"));
+    parser.addOption(QCommandLineOption("tools", "Enable tool calling in batch mode"));
+    parser.addOption(QCommandLineOption("resume",
+        "Append to the batch results file and skip prompts that already succeeded"));
+
+    // Agent options
+    parser.addOption(QCommandLineOption("agent",
+        "Run the CLI prompt as a multi-step agent task (independent tool steps run concurrently)"));
+    parser.addOption(QCommandLineOption("agent-steps", "Max model turns per agent task (0 = unlimited)", "n", "10"));
+    parser.addOption(QCommandLineOption("agent-tokens", "Token budget per agent task (0 = unlimited)", "n", "0"));
+    parser.addOption(QCommandLineOption("agent-time", "Wall-time budget per agent task (0 = unlimited)", "ms", "0"));
+    parser.addOption(QCommandLineOption("agent-parallel", "Max agent tool steps running at once", "n", "4"));
+
+    // Benchmark options
+    parser.addOption(QCommandLineOption("bench",
+        "Benchmark client-side streaming overhead against a built-in mock Ollama server"));
+    parser.addOption(QCommandLineOption("bench-tokens", "Tokens per mock response", "n", "1000"));
+    parser.addOption(QCommandLineOption("bench-runs", "Number of measured runs", "n", "5"));
+    parser.addOption(QCommandLineOption("bench-rate", "Mock token rate in tokens/s (0 = unlimited)", "n", "0"));
+    parser.addOption(QCommandLineOption("bench-chunk", "Tokens per streamed chunk", "n", "1"));
+    parser.addOption(QCommandLineOption("bench-first-token-ms", "Mock delay before the first token", "ms", "50"));
+    parser.addOption(QCommandLineOption("bench-tools", "Have the mock answer with a tool call"));
+
+    // Stream record/replay options
+    parser.addOption(QCommandLineOption("record-stream",
+        "Record raw backend responses with arrival times to a trace file", "path"));
+    parser.addOption(QCommandLineOption("replay-stream",
+        "Answer backend requests from a recorded trace instead of the network", "path"));
+    parser.addOption(QCommandLineOption("replay-speed",
+        "Replay speed factor (1 = recorded timing, 0 = as fast as possible)", "factor", "1"));
+
+    // Startup profiling
+    parser.addOption(QCommandLineOption("startup-profile",
+        "Print wall time per startup phase until the window is interactive"));
+}
+
+bool applyCommandLineOptions(const QCommandLineParser &parser) {
+    StartupProfiler::instance().setEnabled(parser.isSet("startup-profile"));
+
+    // Set log level
+    QString logLevel = parser.value("log-level").toLower();
+    if (logLevel == "debug") {
+        Logger::instance().setLogLevel(Logger::Debug);
+    } else if (logLevel == "warn") {
+        Logger::instance().setLogLevel(Logger::Warning);
+    } else if (logLevel == "error") {
+        Logger::instance().setLogLevel(Logger::Error);
+    } else {
+        Logger::instance().setLogLevel(Logger::Info);
+    }
+
+    // Override config with command line options if provided
+    if (parser.isSet("model")) {
+        QString modelName = parser.value("model");
+        Config::instance().setModel(modelName);
+        LOG_INFO(QString("Model overridden from command line: %1").arg(modelName));
+    }
+
+    // Must be set up before any LLMClient creates its network manager
+    if (parser.isSet("record-stream") && parser.isSet("replay-stream")) {
+        qCritical() << "--record-stream and --replay-stream cannot be combined";
+        return false;
+    }
+    if (parser.isSet("record-stream") && !StreamTrace::instance().startRecording(parser.value("record-stream"))) {
+        qCritical() << "Cannot write stream trace:" << parser.value("record-stream");
+        return false;
+    }
+    if (parser.isSet("replay-stream")) {
+        bool speedOk = false;
+        double speed = parser.value("replay-speed").toDouble(&speedOk);
+        if (!speedOk || speed < 0.0) {
+            qCritical() << "Invalid replay speed:" << parser.value("replay-speed");
+            return false;
+        }
+        if (!StreamTrace::instance().startReplay(parser.value("replay-stream"), speed)) {
+            qCritical() << "Cannot load stream trace:" << parser.value("replay-stream");
+            return false;
+        }
+    }
+
+    // Log current configuration
+    LOG_DEBUG(QString("Backend: %1").arg(Config::instance().getBackend()));
+    LOG_DEBUG(QString("Model: %1").arg(Config::instance().getModel()));
+    LOG_DEBUG(QString("API URL: %1").arg(Config::instance().getApiUrl()));
+
+    return true;
+}
+
+bool hasHeadlessMode(const QCommandLineParser &parser) {
+    return parser.isSet("test-mcp-stdio") || parser.isSet("daemon") || parser.isSet("bench") ||
+           parser.isSet("batch") || parser.isSet("cli") || parser.isSet("mcp-test") ||
+           parser.isSet("rag-test") || parser.isSet("unit-tests");
+}
+
+int runHeadlessMode(const QCommandLineParser &parser) {
+    // Check if test MCP stdio server mode
+    if (parser.isSet("test-mcp-stdio")) {
+        LOG_INFO("Starting test MCP stdio server");
+        return runTestMCPStdioServer();
+    }
+
+    // Check if daemon mode
+    if (parser.isSet("daemon")) {
+        return runDaemon(parser);
+    }
+
+    // Check if benchmark mode
+    if (parser.isSet("bench")) {
+        return runBench(parser);
+    }
+
+    // Check if batch mode
+    if (parser.isSet("batch")) {
+        if (!parser.isSet("out")) {
+            qCritical() << "--batch requires --out <path>";
+            return 1;
+        }
+
+        BatchOptions options;
+        options.inputPath = parser.value("batch");
+        options.outputPath = parser.value("out");
+        options.concurrency = parser.value("concurrency").toInt();
+        options.timeoutMs = parser.value("timeout").toInt();
+        options.useTools = parser.isSet("tools");
+        options.resume = parser.isSet("resume");
+        options.contextPath = parser.value("context");
+
+        return runBatch(options);
+    }
+
+    // CLI mode and diagnostic test modes
+    LOG_INFO("Entering CLI mode");
+    return runCLI(parser);
+}
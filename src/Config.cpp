@@ -1,19 +1,66 @@
 /**
  * Config.cpp - Application configuration management
- * 
+ *
  * Loads/saves configuration from JSON file (~/.qtbot/config.json),
  * provides default values, and manages LLM, RAG, and MCP settings.
+ * Every change publishes a new immutable ConfigSnapshot; the config file
+ * can optionally be watched and hot-reloaded.
  */
 
 #include "Config.h"
 #include "Logger.h"
 #include <QStandardPaths>
+#include <QCoreApplication>
 #include <QFile>
+#include <QSaveFile>
 #include <QDir>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMutexLocker>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <atomic>
+
+// Debounce for file watcher events (editors often write a file in several steps)
+static const int CONFIG_RELOAD_DEBOUNCE_MS = 250;
+
+ConfigSnapshot::ConfigSnapshot()
+    : backend("ollama")
+    , model("gpt-oss:20b")
+    , apiUrl("http://localhost:11434/api/generate")
+    , openaiApiKey("")
+    , systemPrompt("You are a helpful AI assistant with access to tools. Use the available tools when appropriate to provide accurate and helpful responses.")
+    , contextWindowSize(4096)
+    , temperature(0.7)
+    , topP(0.9)
+    , topK(40)
+    , maxTokens(2048)
+    , overrideContextWindowSize(false)  // Default: use model defaults
+    , overrideTemperature(false)
+    , overrideTopP(false)
+    , overrideTopK(false)
+    , overrideMaxTokens(false)
+    , ragEnabled(false)  // RAG disabled by default
+    , ragEmbeddingModel("nomic-embed-text")
+    , ragEmbeddingProvider("ollama")
+    , ragEmbeddingUrl("")
+    , ragEmbeddingDimensions(0)  // Full width
+    , ragDimensionReduction("truncate")
+    , ragChunkSize(512)
+    , ragChunkOverlap(50)
+    , ragChunkTokens(0)  // Chunk by characters
+    , ragTokenizer("")
+    , ragTopK(3)
+    , ragSpeculative(true)
+    , ragDeadlineMs(2000)
+    , ragJournal(true)
+    , memoryBudgetMb(0) {  // Unlimited
+}
+
+bool ConfigSnapshot::operator==(const ConfigSnapshot &other) const {
+    return Config::changedSections(*this, other) == Config::NoSection;
+}
 
 Config& Config::instance() {
     static Config instance;
@@ -21,32 +68,62 @@ Config& Config::instance() {
 }
 
 Config::Config()
-    : m_backend("ollama")
-    , m_model("gpt-oss:20b")
-    , m_apiUrl("http://localhost:11434/api/generate")
-    , m_openaiApiKey("")
-    , m_systemPrompt("You are a helpful AI assistant with access to tools. Use the available tools when appropriate to provide accurate and helpful responses.")
-    , m_contextWindowSize(4096)
-    , m_temperature(0.7)
-    , m_topP(0.9)
-    , m_topK(40)
-    , m_maxTokens(2048)
-    , m_overrideContextWindowSize(false)  // Default: use model defaults
-    , m_overrideTemperature(false)
-    , m_overrideTopP(false)
-    , m_overrideTopK(false)
-    , m_overrideMaxTokens(false)
-    , m_ragEnabled(false)  // RAG disabled by default
-    , m_ragEmbeddingModel("nomic-embed-text")
-    , m_ragChunkSize(512)
-    , m_ragChunkOverlap(50)
-    , m_ragTopK(3) {
+    : QObject(nullptr)
+    , m_snapshot(std::make_shared<const ConfigSnapshot>()) {
+    // Allow configChanged() to be delivered across threads
+    qRegisterMetaType<Config::Sections>("Config::Sections");
+}
+
+std::shared_ptr<const ConfigSnapshot> Config::snapshot() const {
+    return std::atomic_load(&m_snapshot);
+}
+
+void Config::publish() {
+    std::atomic_store(&m_snapshot, std::shared_ptr<const ConfigSnapshot>(std::make_shared<const ConfigSnapshot>(m_data)));
+}
+
+void Config::update(const std::function<void(ConfigSnapshot &)> &mutator) {
+    QMutexLocker locker(&m_mutex);
+    mutator(m_data);
+    publish();
+}
+
+QString Config::getConfigPath() const {
+    QMutexLocker locker(&m_mutex);
+    return m_configPath;
 }
 
 QString Config::getDefaultConfigPath() const {
     return QDir::homePath() + "/.qtbot/config.json";
 }
 
+bool Config::readConfigFile(const QString &path, ConfigSnapshot &data) const {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        LOG_ERROR(QString("Failed to open config file: %1").arg(path));
+        return false;
+    }
+
+    QByteArray jsonData = file.readAll();
+    file.close();
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(jsonData, &parseError);
+
+    if (parseError.error != QJsonParseError::NoError) {
+        LOG_ERROR(QString("Failed to parse config JSON: %1").arg(parseError.errorString()));
+        return false;
+    }
+
+    if (!doc.isObject()) {
+        LOG_ERROR("Config file is not a JSON object");
+        return false;
+    }
+
+    fromJson(doc.object(), data);
+    return true;
+}
+
 bool Config::load(const QString &configPath) {
     QMutexLocker locker(&m_mutex);
 
@@ -68,34 +145,157 @@ bool Config::load(const QString &configPath) {
         return save();
     }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        LOG_ERROR(QString("Failed to open config file: %1").arg(m_configPath));
+    ConfigSnapshot data = m_data;
+    if (!readConfigFile(m_configPath, data)) {
         return false;
     }
 
-    QByteArray jsonData = file.readAll();
-    file.close();
+    m_data = data;
+    publish();
 
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData, &parseError);
+    LOG_INFO(QString("Configuration loaded from %1").arg(m_configPath));
+    LOG_DEBUG(QString("Backend: %1, Model: %2, API URL: %3").arg(m_data.backend, m_data.model, m_data.apiUrl));
 
-    if (parseError.error != QJsonParseError::NoError) {
-        LOG_ERROR(QString("Failed to parse config JSON: %1").arg(parseError.errorString()));
+    return true;
+}
+
+bool Config::reload() {
+    QMutexLocker locker(&m_mutex);
+
+    if (m_configPath.isEmpty() || !QFile::exists(m_configPath)) {
         return false;
     }
 
-    if (!doc.isObject()) {
-        LOG_ERROR("Config file is not a JSON object");
+    // From the defaults, not the current values: a key deleted from the file goes back to its default
+    ConfigSnapshot data;
+    if (!readConfigFile(m_configPath, data)) {
+        LOG_WARNING("Config reload failed, keeping current settings");
         return false;
     }
 
-    fromJson(doc.object());
-    LOG_INFO(QString("Configuration loaded from %1").arg(m_configPath));
-    LOG_DEBUG(QString("Backend: %1, Model: %2, API URL: %3").arg(m_backend, m_model, m_apiUrl));
+    Sections sections = changedSections(m_data, data);
+    if (sections == NoSection) {
+        LOG_DEBUG("Config file changed on disk but no values differ");
+        return true;
+    }
+
+    m_data = data;
+    publish();
+    locker.unlock();
 
+    LOG_INFO(QString("Configuration reloaded from %1 (changed sections: 0x%2)")
+             .arg(m_configPath).arg(static_cast<int>(sections), 0, 16));
+    emit configChanged(sections);
     return true;
 }
 
+void Config::watchConfigFile() {
+    if (m_watcher) {
+        return;
+    }
+
+    QString path = getConfigPath();
+    if (path.isEmpty()) {
+        path = getDefaultConfigPath();
+    }
+
+    // Parent to the application so the watcher is torn down with the event loop,
+    // not during static destruction of this singleton
+    m_watcher = new QFileSystemWatcher(QCoreApplication::instance());
+    m_reloadTimer = new QTimer(m_watcher);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(CONFIG_RELOAD_DEBOUNCE_MS);
+    connect(m_reloadTimer, &QTimer::timeout, this, [this]() { reload(); });
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &Config::handleConfigFileChanged);
+
+    // The directory too: a save by delete-then-write or rename can leave the file
+    // missing when its signal arrives, and the file watch is then gone
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, [this, path]() {
+        if (m_watcher && !m_watcher->files().contains(path) && QFile::exists(path)) {
+            handleConfigFileChanged(path);
+        }
+    });
+    m_watcher->addPath(QFileInfo(path).absolutePath());
+
+    if (!m_watcher->addPath(path)) {
+        LOG_WARNING(QString("Unable to watch config file: %1").arg(path));
+        return;
+    }
+
+    LOG_INFO(QString("Watching config file for changes: %1").arg(path));
+}
+
+void Config::stopWatchingConfigFile() {
+    if (m_watcher) {
+        delete m_watcher;
+        LOG_DEBUG("Stopped watching config file");
+    }
+}
+
+void Config::handleConfigFileChanged(const QString &path) {
+    // Editors that save via rename replace the inode, which drops the watch
+    if (m_watcher && !m_watcher->files().contains(path) && QFile::exists(path)) {
+        m_watcher->addPath(path);
+    }
+
+    if (m_reloadTimer) {
+        m_reloadTimer->start();
+    }
+}
+
+Config::Sections Config::changedSections(const ConfigSnapshot &before, const ConfigSnapshot &after) {
+    Sections sections = NoSection;
+
+    if (before.backend != after.backend || before.model != after.model ||
+        before.fastModel != after.fastModel || before.toolModel != after.toolModel ||
+        before.summaryModel != after.summaryModel || before.queryRewriteModel != after.queryRewriteModel ||
+        before.apiUrl != after.apiUrl || before.openaiApiKey != after.openaiApiKey ||
+        before.daemonUrl != after.daemonUrl) {
+        sections |= LLMSection;
+    }
+
+    if (before.systemPrompt != after.systemPrompt ||
+        before.contextWindowSize != after.contextWindowSize ||
+        before.temperature != after.temperature ||
+        before.topP != after.topP ||
+        before.topK != after.topK ||
+        before.maxTokens != after.maxTokens ||
+        before.overrideContextWindowSize != after.overrideContextWindowSize ||
+        before.overrideTemperature != after.overrideTemperature ||
+        before.overrideTopP != after.overrideTopP ||
+        before.overrideTopK != after.overrideTopK ||
+        before.overrideMaxTokens != after.overrideMaxTokens) {
+        sections |= GenerationSection;
+    }
+
+    if (before.ragEnabled != after.ragEnabled ||
+        before.ragEmbeddingModel != after.ragEmbeddingModel ||
+        before.ragEmbeddingProvider != after.ragEmbeddingProvider ||
+        before.ragEmbeddingUrl != after.ragEmbeddingUrl ||
+        before.ragEmbeddingDimensions != after.ragEmbeddingDimensions ||
+        before.ragDimensionReduction != after.ragDimensionReduction ||
+        before.ragChunkSize != after.ragChunkSize ||
+        before.ragChunkOverlap != after.ragChunkOverlap ||
+        before.ragChunkTokens != after.ragChunkTokens ||
+        before.ragTokenizer != after.ragTokenizer ||
+        before.ragTopK != after.ragTopK ||
+        before.ragSpeculative != after.ragSpeculative ||
+        before.ragDeadlineMs != after.ragDeadlineMs ||
+        before.ragJournal != after.ragJournal) {
+        sections |= RAGSection;
+    }
+
+    if (before.mcpServers != after.mcpServers) {
+        sections |= MCPSection;
+    }
+
+    if (before.memoryBudgetMb != after.memoryBudgetMb) {
+        sections |= MemorySection;
+    }
+
+    return sections;
+}
+
 bool Config::save() {
     QMutexLocker locker(&m_mutex);
 
@@ -113,20 +313,18 @@ bool Config::save() {
         }
     }
 
-    QFile file(m_configPath);
+    // Written beside the file and renamed over it, so the watcher never reads a half-written one
+    QSaveFile file(m_configPath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         LOG_ERROR(QString("Failed to open config file for writing: %1").arg(m_configPath));
         return false;
     }
 
-    QJsonDocument doc(toJson());
-    QByteArray jsonData = doc.toJson(QJsonDocument::Indented);
-
-    qint64 bytesWritten = file.write(jsonData);
-    file.close();
+    QJsonDocument doc(toJson(m_data));
+    file.write(doc.toJson(QJsonDocument::Indented));
 
-    if (bytesWritten == -1) {
-        LOG_ERROR("Failed to write config file");
+    if (!file.commit()) {
+        LOG_ERROR(QString("Failed to write config file %1: %2").arg(m_configPath, file.errorString()));
         return false;
     }
 
@@ -135,268 +333,350 @@ bool Config::save() {
 }
 
 void Config::setBackend(const QString &backend) {
-    QMutexLocker locker(&m_mutex);
-    m_backend = backend;
+    update([&](ConfigSnapshot &c) { c.backend = backend; });
 }
 
 void Config::setModel(const QString &model) {
-    QMutexLocker locker(&m_mutex);
-    m_model = model;
+    update([&](ConfigSnapshot &c) { c.model = model; });
 }
 
 void Config::setApiUrl(const QString &apiUrl) {
-    QMutexLocker locker(&m_mutex);
-    m_apiUrl = apiUrl;
+    update([&](ConfigSnapshot &c) { c.apiUrl = apiUrl; });
 }
 
 void Config::setOpenAIApiKey(const QString &apiKey) {
-    QMutexLocker locker(&m_mutex);
-    m_openaiApiKey = apiKey;
+    update([&](ConfigSnapshot &c) { c.openaiApiKey = apiKey; });
 }
 
 void Config::setSystemPrompt(const QString &systemPrompt) {
-    QMutexLocker locker(&m_mutex);
-    m_systemPrompt = systemPrompt;
+    update([&](ConfigSnapshot &c) { c.systemPrompt = systemPrompt; });
+}
+
+void Config::setFastModel(const QString &model) {
+    update([&](ConfigSnapshot &c) { c.fastModel = model; });
 }
 
 void Config::setContextWindowSize(int size) {
-    QMutexLocker locker(&m_mutex);
-    m_contextWindowSize = size;
+    update([&](ConfigSnapshot &c) { c.contextWindowSize = size; });
 }
 
 void Config::setTemperature(double temp) {
-    QMutexLocker locker(&m_mutex);
-    m_temperature = temp;
+    update([&](ConfigSnapshot &c) { c.temperature = temp; });
 }
 
 void Config::setTopP(double topP) {
-    QMutexLocker locker(&m_mutex);
-    m_topP = topP;
+    update([&](ConfigSnapshot &c) { c.topP = topP; });
 }
 
 void Config::setTopK(int topK) {
-    QMutexLocker locker(&m_mutex);
-    m_topK = topK;
+    update([&](ConfigSnapshot &c) { c.topK = topK; });
 }
 
 void Config::setMaxTokens(int maxTokens) {
-    QMutexLocker locker(&m_mutex);
-    m_maxTokens = maxTokens;
+    update([&](ConfigSnapshot &c) { c.maxTokens = maxTokens; });
 }
 
 void Config::setOverrideContextWindowSize(bool override) {
-    QMutexLocker locker(&m_mutex);
-    m_overrideContextWindowSize = override;
+    update([&](ConfigSnapshot &c) { c.overrideContextWindowSize = override; });
 }
 
 void Config::setOverrideTemperature(bool override) {
-    QMutexLocker locker(&m_mutex);
-    m_overrideTemperature = override;
+    update([&](ConfigSnapshot &c) { c.overrideTemperature = override; });
 }
 
 void Config::setOverrideTopP(bool override) {
-    QMutexLocker locker(&m_mutex);
-    m_overrideTopP = override;
+    update([&](ConfigSnapshot &c) { c.overrideTopP = override; });
 }
 
 void Config::setOverrideTopK(bool override) {
-    QMutexLocker locker(&m_mutex);
-    m_overrideTopK = override;
+    update([&](ConfigSnapshot &c) { c.overrideTopK = override; });
 }
 
 void Config::setOverrideMaxTokens(bool override) {
-    QMutexLocker locker(&m_mutex);
-    m_overrideMaxTokens = override;
+    update([&](ConfigSnapshot &c) { c.overrideMaxTokens = override; });
 }
 
 void Config::setRagEnabled(bool enabled) {
-    QMutexLocker locker(&m_mutex);
-    m_ragEnabled = enabled;
+    update([&](ConfigSnapshot &c) { c.ragEnabled = enabled; });
 }
 
 void Config::setRagEmbeddingModel(const QString &model) {
-    QMutexLocker locker(&m_mutex);
-    m_ragEmbeddingModel = model;
+    update([&](ConfigSnapshot &c) { c.ragEmbeddingModel = model; });
+}
+
+void Config::setRagEmbeddingProvider(const QString &provider) {
+    update([&](ConfigSnapshot &c) { c.ragEmbeddingProvider = provider; });
+}
+
+void Config::setRagEmbeddingUrl(const QString &url) {
+    update([&](ConfigSnapshot &c) { c.ragEmbeddingUrl = url; });
+}
+
+void Config::setRagEmbeddingDimensions(int dimensions) {
+    update([&](ConfigSnapshot &c) { c.ragEmbeddingDimensions = dimensions; });
+}
+
+void Config::setRagDimensionReduction(const QString &method) {
+    update([&](ConfigSnapshot &c) { c.ragDimensionReduction = method; });
 }
 
 void Config::setRagChunkSize(int size) {
-    QMutexLocker locker(&m_mutex);
-    m_ragChunkSize = size;
+    update([&](ConfigSnapshot &c) { c.ragChunkSize = size; });
 }
 
 void Config::setRagChunkOverlap(int overlap) {
-    QMutexLocker locker(&m_mutex);
-    m_ragChunkOverlap = overlap;
+    update([&](ConfigSnapshot &c) { c.ragChunkOverlap = overlap; });
+}
+
+void Config::setRagChunkTokens(int tokens) {
+    update([&](ConfigSnapshot &c) { c.ragChunkTokens = tokens; });
+}
+
+void Config::setRagTokenizer(const QString &path) {
+    update([&](ConfigSnapshot &c) { c.ragTokenizer = path; });
 }
 
 void Config::setRagTopK(int topK) {
-    QMutexLocker locker(&m_mutex);
-    m_ragTopK = topK;
+    update([&](ConfigSnapshot &c) { c.ragTopK = topK; });
+}
+
+void Config::setRagSpeculative(bool enabled) {
+    update([&](ConfigSnapshot &c) { c.ragSpeculative = enabled; });
+}
+
+void Config::setRagDeadlineMs(int ms) {
+    update([&](ConfigSnapshot &c) { c.ragDeadlineMs = ms; });
+}
+
+void Config::setRagJournal(bool enabled) {
+    update([&](ConfigSnapshot &c) { c.ragJournal = enabled; });
 }
 
 void Config::setMcpServers(const QJsonArray &servers) {
-    QMutexLocker locker(&m_mutex);
-    m_mcpServers = servers;
+    update([&](ConfigSnapshot &c) { c.mcpServers = servers; });
+}
+
+void Config::setDaemonUrl(const QString &url) {
+    update([&](ConfigSnapshot &c) { c.daemonUrl = url; });
+}
+
+void Config::setMemoryBudgetMb(int mb) {
+    update([&](ConfigSnapshot &c) { c.memoryBudgetMb = mb; });
 }
 
 void Config::resetToDefaults() {
-    QMutexLocker locker(&m_mutex);
-    m_backend = "ollama";
-    m_model = "gpt-oss:20b";
-    m_apiUrl = "http://localhost:11434/api/generate";
-    m_openaiApiKey = "";
-    m_systemPrompt = "You are a helpful AI assistant with access to tools. Use the available tools when appropriate to provide accurate and helpful responses.";
-    // Set reasonable values but don't override by default
-    m_contextWindowSize = 4096;
-    m_temperature = 0.7;
-    m_topP = 0.9;
-    m_topK = 40;
-    m_maxTokens = 2048;
-    m_overrideContextWindowSize = false;
-    m_overrideTemperature = false;
-    m_overrideTopP = false;
-    m_overrideTopK = false;
-    m_overrideMaxTokens = false;
-    m_ragEnabled = false;
-    m_ragEmbeddingModel = "nomic-embed-text";
-    m_ragChunkSize = 512;
-    m_ragChunkOverlap = 50;
-    m_ragTopK = 3;
-    m_mcpServers = QJsonArray();  // Empty array - no MCP servers by default
+    // A default-constructed snapshot holds the default values; MCP servers are
+    // cleared and LLM parameter overrides are disabled
+    update([](ConfigSnapshot &c) { c = ConfigSnapshot(); });
     LOG_INFO("Configuration reset to defaults (LLM parameter overrides, RAG, and MCP servers cleared)");
 }
 
 bool Config::isValid() const {
-    QMutexLocker locker(&m_mutex);
+    std::shared_ptr<const ConfigSnapshot> cfg = snapshot();
 
-    if (m_backend.isEmpty()) {
+    if (cfg->backend.isEmpty()) {
         return false;
     }
 
-    if (m_model.isEmpty()) {
+    if (cfg->model.isEmpty()) {
         return false;
     }
 
-    if (m_apiUrl.isEmpty()) {
+    if (cfg->apiUrl.isEmpty()) {
         return false;
     }
 
     // If backend is OpenAI, API key should be provided
-    if (m_backend.toLower() == "openai" && m_openaiApiKey.isEmpty()) {
+    if (cfg->backend.toLower() == "openai" && cfg->openaiApiKey.isEmpty()) {
         LOG_WARNING("OpenAI backend selected but API key is empty");
     }
 
     return true;
 }
 
-QJsonObject Config::toJson() const {
+QJsonObject Config::toJson(const ConfigSnapshot &data) {
     QJsonObject obj;
-    obj["backend"] = m_backend;
-    obj["model"] = m_model;
-    obj["api_url"] = m_apiUrl;
-    obj["openai_api_key"] = m_openaiApiKey;
-    obj["system_prompt"] = m_systemPrompt;
-    obj["context_window_size"] = m_contextWindowSize;
-    obj["temperature"] = m_temperature;
-    obj["top_p"] = m_topP;
-    obj["top_k"] = m_topK;
-    obj["max_tokens"] = m_maxTokens;
-    obj["override_context_window_size"] = m_overrideContextWindowSize;
-    obj["override_temperature"] = m_overrideTemperature;
-    obj["override_top_p"] = m_overrideTopP;
-    obj["override_top_k"] = m_overrideTopK;
-    obj["override_max_tokens"] = m_overrideMaxTokens;
-    obj["rag_enabled"] = m_ragEnabled;
-    obj["rag_embedding_model"] = m_ragEmbeddingModel;
-    obj["rag_chunk_size"] = m_ragChunkSize;
-    obj["rag_chunk_overlap"] = m_ragChunkOverlap;
-    obj["rag_top_k"] = m_ragTopK;
-    obj["mcp_servers"] = m_mcpServers;
+    obj["backend"] = data.backend;
+    obj["model"] = data.model;
+    obj["api_url"] = data.apiUrl;
+    obj["openai_api_key"] = data.openaiApiKey;
+    obj["system_prompt"] = data.systemPrompt;
+    obj["fast_model"] = data.fastModel;
+    obj["tool_model"] = data.toolModel;
+    obj["summary_model"] = data.summaryModel;
+    obj["query_rewrite_model"] = data.queryRewriteModel;
+    obj["context_window_size"] = data.contextWindowSize;
+    obj["temperature"] = data.temperature;
+    obj["top_p"] = data.topP;
+    obj["top_k"] = data.topK;
+    obj["max_tokens"] = data.maxTokens;
+    obj["override_context_window_size"] = data.overrideContextWindowSize;
+    obj["override_temperature"] = data.overrideTemperature;
+    obj["override_top_p"] = data.overrideTopP;
+    obj["override_top_k"] = data.overrideTopK;
+    obj["override_max_tokens"] = data.overrideMaxTokens;
+    obj["rag_enabled"] = data.ragEnabled;
+    obj["rag_embedding_model"] = data.ragEmbeddingModel;
+    obj["rag_embedding_provider"] = data.ragEmbeddingProvider;
+    obj["rag_embedding_url"] = data.ragEmbeddingUrl;
+    obj["rag_embedding_dimensions"] = data.ragEmbeddingDimensions;
+    obj["rag_dimension_reduction"] = data.ragDimensionReduction;
+    obj["rag_chunk_size"] = data.ragChunkSize;
+    obj["rag_chunk_overlap"] = data.ragChunkOverlap;
+    obj["rag_chunk_tokens"] = data.ragChunkTokens;
+    obj["rag_tokenizer"] = data.ragTokenizer;
+    obj["rag_top_k"] = data.ragTopK;
+    obj["rag_speculative"] = data.ragSpeculative;
+    obj["rag_deadline_ms"] = data.ragDeadlineMs;
+    obj["rag_journal"] = data.ragJournal;
+    obj["mcp_servers"] = data.mcpServers;
+    obj["daemon_url"] = data.daemonUrl;
+    obj["memory_budget_mb"] = data.memoryBudgetMb;
     return obj;
 }
 
-void Config::fromJson(const QJsonObject &json) {
+void Config::fromJson(const QJsonObject &json, ConfigSnapshot &data) {
     if (json.contains("backend") && json["backend"].isString()) {
-        m_backend = json["backend"].toString();
+        data.backend = json["backend"].toString();
     }
 
     if (json.contains("model") && json["model"].isString()) {
-        m_model = json["model"].toString();
+        data.model = json["model"].toString();
     }
 
     if (json.contains("api_url") && json["api_url"].isString()) {
-        m_apiUrl = json["api_url"].toString();
+        data.apiUrl = json["api_url"].toString();
     }
 
     if (json.contains("openai_api_key") && json["openai_api_key"].isString()) {
-        m_openaiApiKey = json["openai_api_key"].toString();
+        data.openaiApiKey = json["openai_api_key"].toString();
     }
 
     if (json.contains("system_prompt") && json["system_prompt"].isString()) {
-        m_systemPrompt = json["system_prompt"].toString();
+        data.systemPrompt = json["system_prompt"].toString();
+    }
+
+    if (json.contains("fast_model") && json["fast_model"].isString()) {
+        data.fastModel = json["fast_model"].toString();
+    }
+
+    if (json.contains("tool_model") && json["tool_model"].isString()) {
+        data.toolModel = json["tool_model"].toString();
+    }
+
+    if (json.contains("summary_model") && json["summary_model"].isString()) {
+        data.summaryModel = json["summary_model"].toString();
+    }
+
+    if (json.contains("query_rewrite_model") && json["query_rewrite_model"].isString()) {
+        data.queryRewriteModel = json["query_rewrite_model"].toString();
     }
 
     if (json.contains("context_window_size") && json["context_window_size"].isDouble()) {
-        m_contextWindowSize = json["context_window_size"].toInt();
+        data.contextWindowSize = json["context_window_size"].toInt();
     }
 
     if (json.contains("temperature") && json["temperature"].isDouble()) {
-        m_temperature = json["temperature"].toDouble();
+        data.temperature = json["temperature"].toDouble();
     }
 
     if (json.contains("top_p") && json["top_p"].isDouble()) {
-        m_topP = json["top_p"].toDouble();
+        data.topP = json["top_p"].toDouble();
     }
 
     if (json.contains("top_k") && json["top_k"].isDouble()) {
-        m_topK = json["top_k"].toInt();
+        data.topK = json["top_k"].toInt();
     }
 
     if (json.contains("max_tokens") && json["max_tokens"].isDouble()) {
-        m_maxTokens = json["max_tokens"].toInt();
+        data.maxTokens = json["max_tokens"].toInt();
     }
 
     if (json.contains("override_context_window_size") && json["override_context_window_size"].isBool()) {
-        m_overrideContextWindowSize = json["override_context_window_size"].toBool();
+        data.overrideContextWindowSize = json["override_context_window_size"].toBool();
     }
 
     if (json.contains("override_temperature") && json["override_temperature"].isBool()) {
-        m_overrideTemperature = json["override_temperature"].toBool();
+        data.overrideTemperature = json["override_temperature"].toBool();
     }
 
     if (json.contains("override_top_p") && json["override_top_p"].isBool()) {
-        m_overrideTopP = json["override_top_p"].toBool();
+        data.overrideTopP = json["override_top_p"].toBool();
     }
 
     if (json.contains("override_top_k") && json["override_top_k"].isBool()) {
-        m_overrideTopK = json["override_top_k"].toBool();
+        data.overrideTopK = json["override_top_k"].toBool();
     }
 
     if (json.contains("override_max_tokens") && json["override_max_tokens"].isBool()) {
-        m_overrideMaxTokens = json["override_max_tokens"].toBool();
+        data.overrideMaxTokens = json["override_max_tokens"].toBool();
     }
 
     if (json.contains("rag_enabled") && json["rag_enabled"].isBool()) {
-        m_ragEnabled = json["rag_enabled"].toBool();
+        data.ragEnabled = json["rag_enabled"].toBool();
     }
 
     if (json.contains("rag_embedding_model") && json["rag_embedding_model"].isString()) {
-        m_ragEmbeddingModel = json["rag_embedding_model"].toString();
+        data.ragEmbeddingModel = json["rag_embedding_model"].toString();
+    }
+
+    if (json.contains("rag_embedding_provider") && json["rag_embedding_provider"].isString()) {
+        data.ragEmbeddingProvider = json["rag_embedding_provider"].toString();
+    }
+
+    if (json.contains("rag_embedding_url") && json["rag_embedding_url"].isString()) {
+        data.ragEmbeddingUrl = json["rag_embedding_url"].toString();
+    }
+
+    if (json.contains("rag_embedding_dimensions") && json["rag_embedding_dimensions"].isDouble()) {
+        data.ragEmbeddingDimensions = json["rag_embedding_dimensions"].toInt();
+    }
+
+    if (json.contains("rag_dimension_reduction") && json["rag_dimension_reduction"].isString()) {
+        data.ragDimensionReduction = json["rag_dimension_reduction"].toString();
     }
 
     if (json.contains("rag_chunk_size") && json["rag_chunk_size"].isDouble()) {
-        m_ragChunkSize = json["rag_chunk_size"].toInt();
+        data.ragChunkSize = json["rag_chunk_size"].toInt();
     }
 
     if (json.contains("rag_chunk_overlap") && json["rag_chunk_overlap"].isDouble()) {
-        m_ragChunkOverlap = json["rag_chunk_overlap"].toInt();
+        data.ragChunkOverlap = json["rag_chunk_overlap"].toInt();
+    }
+
+    if (json.contains("rag_chunk_tokens") && json["rag_chunk_tokens"].isDouble()) {
+        data.ragChunkTokens = json["rag_chunk_tokens"].toInt();
+    }
+
+    if (json.contains("rag_tokenizer") && json["rag_tokenizer"].isString()) {
+        data.ragTokenizer = json["rag_tokenizer"].toString();
     }
 
     if (json.contains("rag_top_k") && json["rag_top_k"].isDouble()) {
-        m_ragTopK = json["rag_top_k"].toInt();
+        data.ragTopK = json["rag_top_k"].toInt();
+    }
+
+    if (json.contains("rag_speculative") && json["rag_speculative"].isBool()) {
+        data.ragSpeculative = json["rag_speculative"].toBool();
+    }
+
+    if (json.contains("rag_deadline_ms") && json["rag_deadline_ms"].isDouble()) {
+        data.ragDeadlineMs = json["rag_deadline_ms"].toInt();
+    }
+
+    if (json.contains("rag_journal") && json["rag_journal"].isBool()) {
+        data.ragJournal = json["rag_journal"].toBool();
     }
 
     if (json.contains("mcp_servers") && json["mcp_servers"].isArray()) {
-        m_mcpServers = json["mcp_servers"].toArray();
+        data.mcpServers = json["mcp_servers"].toArray();
+    }
+
+    if (json.contains("daemon_url") && json["daemon_url"].isString()) {
+        data.daemonUrl = json["daemon_url"].toString();
+    }
+
+    if (json.contains("memory_budget_mb") && json["memory_budget_mb"].isDouble()) {
+        data.memoryBudgetMb = json["memory_budget_mb"].toInt();
     }
 }
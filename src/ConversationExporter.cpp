@@ -0,0 +1,394 @@
+/**
+ * ConversationExporter.cpp - Background conversation export
+ *
+ * The worker reads the journal snapshot a page at a time and hands each
+ * formatted record to a buffered sink (optionally deflating it as gzip),
+ * so memory use does not grow with the conversation.
+ */
+
+#include "ConversationExporter.h"
+#include "ConversationJournal.h"
+#include "Logger.h"
+#include "version.h"
+#include <QThread>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <cstring>
+#include <memory>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+// Messages formatted per progress update
+const int EXPORT_PAGE_SIZE = 200;
+
+// Bytes collected before writing (or deflating) a block
+const int SINK_BUFFER_SIZE = 64 * 1024;
+
+/**
+ * Buffered output, gzip-compressed when requested
+ */
+class ExportSink {
+public:
+    ExportSink(QIODevice *out, bool compress)
+        : m_out(out)
+        , m_compress(compress)
+        , m_ok(true) {
+        m_buffer.reserve(SINK_BUFFER_SIZE);
+#ifdef HAVE_ZLIB
+        if (m_compress) {
+            std::memset(&m_stream, 0, sizeof(m_stream));
+            m_chunk.resize(SINK_BUFFER_SIZE);
+            // windowBits 15 + 16 selects the gzip container
+            m_ok = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            if (!m_ok) {
+                m_error = "Failed to initialize gzip compression";
+            }
+        }
+#else
+        if (m_compress) {
+            m_ok = false;
+            m_error = "Built without zlib: compressed export is unavailable";
+        }
+#endif
+    }
+
+    ~ExportSink() {
+#ifdef HAVE_ZLIB
+        if (m_compress) {
+            deflateEnd(&m_stream);
+        }
+#endif
+    }
+
+    bool write(const QString &text) {
+        if (!m_ok) {
+            return false;
+        }
+        m_buffer += text.toUtf8();
+        return m_buffer.size() < SINK_BUFFER_SIZE || flush(false);
+    }
+
+    bool finish() {
+        return m_ok && flush(true);
+    }
+
+    QString errorString() const { return m_error; }
+
+private:
+    bool flush(bool final) {
+#ifdef HAVE_ZLIB
+        if (m_compress) {
+            m_stream.next_in = reinterpret_cast<Bytef *>(m_buffer.data());
+            m_stream.avail_in = static_cast<uInt>(m_buffer.size());
+            do {
+                m_stream.next_out = reinterpret_cast<Bytef *>(m_chunk.data());
+                m_stream.avail_out = static_cast<uInt>(m_chunk.size());
+                if (deflate(&m_stream, final ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+                    m_error = "gzip compression failed";
+                    m_ok = false;
+                    return false;
+                }
+                qint64 produced = m_chunk.size() - m_stream.avail_out;
+                if (produced > 0 && !writeOut(m_chunk.constData(), produced)) {
+                    return false;
+                }
+            } while (m_stream.avail_out == 0);
+            m_buffer.clear();
+            return true;
+        }
+#else
+        Q_UNUSED(final);
+#endif
+        bool written = m_buffer.isEmpty() || writeOut(m_buffer.constData(), m_buffer.size());
+        m_buffer.clear();
+        return written;
+    }
+
+    bool writeOut(const char *data, qint64 size) {
+        if (m_out->write(data, size) != size) {
+            m_error = m_out->errorString();
+            m_ok = false;
+            return false;
+        }
+        return true;
+    }
+
+    QIODevice *m_out;
+    bool m_compress;
+    bool m_ok;
+    QString m_error;
+    QByteArray m_buffer;
+#ifdef HAVE_ZLIB
+    z_stream m_stream;
+    QByteArray m_chunk;
+#endif
+};
+
+QString timeString(const QDateTime &time) {
+    return time.toString("yyyy-MM-dd hh:mm:ss");
+}
+
+QString toolCallText(const QJsonObject &call) {
+    QString arguments = QString::fromUtf8(QJsonDocument(call["arguments"].toObject()).toJson(QJsonDocument::Compact));
+    return QString("%1(%2)").arg(call["name"].toString(), arguments);
+}
+
+QString formatHeader(ConversationExporter::Format format, const QJsonObject &header,
+                     const ConversationSnapshot &snapshot, const QList<QJsonObject> &imports, int total) {
+    QString model = header.contains("model") ? header["model"].toString() : snapshot.model;
+    QString backend = header.contains("backend") ? header["backend"].toString() : snapshot.backend;
+    QString exportedAt = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+
+    if (format == ConversationExporter::Json) {
+        QJsonObject meta;
+        meta["format"] = QString("%1-export").arg(APP_NAME);
+        meta["version"] = 1;
+        meta["exported_at"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        meta["created_at"] = header["created_at"];
+        meta["model"] = model;
+        meta["backend"] = backend;
+        meta["message_count"] = total;
+        QJsonArray importArray;
+        for (const QJsonObject &import : imports) {
+            importArray.append(import["content"]);
+        }
+        meta["imports"] = importArray;
+
+        // Open the object and leave it unterminated for the streamed message array
+        QByteArray json = QJsonDocument(meta).toJson(QJsonDocument::Compact);
+        json.chop(1);
+        return QString::fromUtf8(json) + ",\"messages\":[\n";
+    }
+
+    QString text;
+    if (format == ConversationExporter::Markdown) {
+        text += QString("# %1 Conversation Export\n\n").arg(APP_NAME);
+        text += QString("- **Exported:** %1\n").arg(exportedAt);
+        text += QString("- **Model:** %1\n").arg(model);
+        text += QString("- **Backend:** %1\n").arg(backend);
+        text += QString("- **Messages:** %1\n\n---\n\n").arg(total);
+        for (const QJsonObject &import : imports) {
+            text += QString("## Imported conversation\n\n```\n%1\n```\n\n").arg(import["content"].toString());
+        }
+    } else {
+        text += "========================================\n";
+        text += QString("%1 Conversation Export\n").arg(APP_NAME);
+        text += QString("Date: %1\n").arg(exportedAt);
+        text += QString("Model: %1\n").arg(model);
+        text += QString("Backend: %1\n").arg(backend);
+        text += QString("Messages: %1\n").arg(total);
+        text += "========================================\n\n";
+        for (const QJsonObject &import : imports) {
+            text += QString("--- Imported conversation ---\n%1\n---\n\n").arg(import["content"].toString());
+        }
+    }
+    return text;
+}
+
+QString formatMessage(ConversationExporter::Format format, const ConversationMessage &message, bool first) {
+    if (format == ConversationExporter::Json) {
+        QByteArray record = QJsonDocument(message.toJson()).toJson(QJsonDocument::Compact);
+        return (first ? QString() : QString(",\n")) + QString::fromUtf8(record);
+    }
+
+    QString time = timeString(message.timestamp);
+    QString text;
+
+    if (format == ConversationExporter::Markdown) {
+        if (message.role == "user") {
+            text += QString("**You** · %1\n\n%2\n\n").arg(time, message.content);
+        } else if (message.role == "assistant") {
+            for (const QJsonValue &call : message.toolCalls) {
+                text += QString("> 🔧 Tool call `%1` · %2\n\n").arg(toolCallText(call.toObject()), time);
+            }
+            if (!message.content.isEmpty()) {
+                text += QString("**Bot** · %1\n\n%2\n\n").arg(time, message.content);
+            }
+        } else if (message.role == "tool") {
+            text += QString("**Tool %1%2** · %3\n\n```\n%4\n```\n\n")
+                .arg(message.toolName, message.isError ? " (error)" : "", time, message.content);
+        }
+        return text;
+    }
+
+    if (message.role == "user") {
+        text += QString("[%1] You: %2\n\n").arg(time, message.content);
+    } else if (message.role == "assistant") {
+        for (const QJsonValue &call : message.toolCalls) {
+            text += QString("[%1] Tool Call: %2\n").arg(time, toolCallText(call.toObject()));
+        }
+        if (!message.content.isEmpty()) {
+            text += QString("[%1] Bot: %2\n\n").arg(time, message.content);
+        }
+    } else if (message.role == "tool") {
+        text += QString("[%1] Tool %2%3: %4\n\n")
+            .arg(time, message.toolName, message.isError ? " (error)" : "", message.content);
+    }
+    return text;
+}
+
+} // namespace
+
+ConversationExporter::ConversationExporter(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_cancelled(false) {
+}
+
+ConversationExporter::~ConversationExporter() {
+    if (m_thread) {
+        cancel();
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+bool ConversationExporter::isRunning() const {
+    return m_thread && m_thread->isRunning();
+}
+
+void ConversationExporter::cancel() {
+    m_cancelled = true;
+}
+
+bool ConversationExporter::compressionAvailable() {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+ConversationExporter::Format ConversationExporter::formatForPath(const QString &path, bool *compress) {
+    QString name = path.toLower();
+    bool gzip = name.endsWith(".gz");
+    if (gzip) {
+        name.chop(3);
+    }
+    if (compress) {
+        *compress = gzip;
+    }
+
+    if (name.endsWith(".md") || name.endsWith(".markdown")) {
+        return Markdown;
+    }
+    if (name.endsWith(".json")) {
+        return Json;
+    }
+    return Text;
+}
+
+bool ConversationExporter::start(const ConversationSnapshot &snapshot, const QString &outputPath,
+                                 Format format, bool compress) {
+    if (isRunning()) {
+        return false;
+    }
+    if (m_thread) {
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_cancelled = false;
+
+    // Result is handed back when the thread has finished, so isRunning() is false in the slots
+    auto result = std::make_shared<QString>();
+    auto succeeded = std::make_shared<bool>(false);
+
+    m_thread = QThread::create([this, snapshot, outputPath, format, compress, result, succeeded]() {
+        QSaveFile file(outputPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            *result = file.errorString();
+            return;
+        }
+
+        QString error;
+        auto reportProgress = [this](int written, int total) {
+            emit progress(written, total);
+        };
+        if (!write(snapshot, &file, format, compress, reportProgress, &m_cancelled, &error)) {
+            // Nothing is left behind at outputPath
+            file.cancelWriting();
+            *result = error;
+            return;
+        }
+
+        // Atomic rename over the destination
+        if (!file.commit()) {
+            *result = file.errorString();
+            return;
+        }
+        *succeeded = true;
+    });
+    m_thread->setObjectName("ConversationExporter");
+
+    connect(m_thread, &QThread::finished, this, [this, outputPath, result, succeeded]() {
+        if (*succeeded) {
+            LOG_INFO(QString("Conversation exported to: %1").arg(outputPath));
+            emit finished(outputPath);
+        } else {
+            LOG_ERROR(QString("Conversation export to %1 failed: %2").arg(outputPath, *result));
+            emit failed(outputPath, *result);
+        }
+    });
+
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+bool ConversationExporter::write(const ConversationSnapshot &snapshot, QIODevice *out, Format format, bool compress,
+                                 const std::function<void(int, int)> &progress,
+                                 const std::atomic<bool> *cancelled, QString *error) {
+    ConversationJournalIndex index;
+    QFile journalFile;
+    if (!snapshot.journalPath.isEmpty()) {
+        // Hold the file open so a Save As rename or a discarded autosave doesn't interrupt the export
+        journalFile.setFileName(snapshot.journalPath);
+        if (!journalFile.open(QIODevice::ReadOnly) || !index.open(snapshot.journalPath, error, snapshot.journalSize)) {
+            if (error && error->isEmpty()) {
+                *error = journalFile.errorString();
+            }
+            return false;
+        }
+    }
+
+    int total = index.messageCount();
+    ExportSink sink(out, compress);
+    bool ok = sink.write(formatHeader(format, index.header(), snapshot, index.imports(), total));
+
+    for (int first = 0; ok && first < total; first += EXPORT_PAGE_SIZE) {
+        if (cancelled && *cancelled) {
+            if (error) {
+                *error = "Export cancelled";
+            }
+            return false;
+        }
+
+        QList<ConversationMessage> page = index.messages(&journalFile, first, EXPORT_PAGE_SIZE);
+        for (int i = 0; ok && i < page.size(); ++i) {
+            ok = sink.write(formatMessage(format, page[i], first + i == 0));
+        }
+
+        if (progress) {
+            progress(qMin(first + EXPORT_PAGE_SIZE, total), total);
+        }
+    }
+
+    if (ok && format == Json) {
+        ok = sink.write(QString("\n]}\n"));
+    }
+    if (ok) {
+        ok = sink.finish();
+    }
+
+    if (!ok && error) {
+        *error = sink.errorString();
+    }
+    return ok;
+}
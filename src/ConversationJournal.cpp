@@ -0,0 +1,550 @@
+/**
+ * ConversationJournal.cpp - Append-only conversation message journal
+ *
+ * Appends one compact JSON record per completed message, flushes each
+ * record to the OS immediately (survives an application crash) and
+ * fsyncs in batches (survives a power loss up to the last batch).
+ */
+
+#include "ConversationJournal.h"
+#include "Logger.h"
+#include "version.h"
+#include <QTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+const int TAIL_READ_CHUNK = 64 * 1024;
+
+// Last complete record of a journal, read from the end of the file
+QJsonObject readLastRecord(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+
+    qint64 size = file.size();
+    qint64 start = qMax<qint64>(0, size - TAIL_READ_CHUNK);
+    file.seek(start);
+    QByteArray tail = file.read(size - start);
+
+    QList<QByteArray> lines = tail.split('\n');
+    for (int i = lines.size() - 1; i >= 0; --i) {
+        QJsonDocument doc = QJsonDocument::fromJson(lines[i]);
+        if (doc.isObject()) {
+            return doc.object();
+        }
+    }
+    return QJsonObject();
+}
+
+// Compact JSON sorts keys, so "type" is the last key of these records
+const char MESSAGE_SUFFIX[] = "\"type\":\"message\"}";
+const char IMPORT_SUFFIX[] = "\"type\":\"import\"}";
+const char CLOSE_SUFFIX[] = "\"type\":\"close\"}";
+
+bool lineEndsWith(const char *line, qint64 length, const char *suffix) {
+    qint64 suffixLength = static_cast<qint64>(std::strlen(suffix));
+    return length >= suffixLength && std::memcmp(line + length - suffixLength, suffix, suffixLength) == 0;
+}
+
+int estimateMessageTokens(const ConversationMessage &message) {
+    int chars = message.content.length();
+    if (!message.toolCalls.isEmpty()) {
+        chars += QJsonDocument(message.toolCalls).toJson(QJsonDocument::Compact).size();
+    }
+    return chars / 4 + 1;
+}
+
+QString timestampString(const QDateTime &time) {
+    return time.toString(Qt::ISODateWithMs);
+}
+
+} // namespace
+
+QJsonObject ConversationMessage::toJson() const {
+    QJsonObject obj;
+    obj["type"] = "message";
+    obj["role"] = role;
+    obj["content"] = content;
+    if (!toolCalls.isEmpty()) {
+        obj["tool_calls"] = toolCalls;
+    }
+    if (!toolName.isEmpty()) {
+        obj["tool_name"] = toolName;
+    }
+    if (!toolCallId.isEmpty()) {
+        obj["tool_call_id"] = toolCallId;
+    }
+    if (isError) {
+        obj["error"] = true;
+    }
+    if (!timings.isEmpty()) {
+        obj["timings"] = timings;
+    }
+    obj["t"] = timestampString(timestamp);
+    return obj;
+}
+
+ConversationMessage ConversationMessage::fromJson(const QJsonObject &obj) {
+    ConversationMessage message;
+    message.role = obj["role"].toString();
+    message.content = obj["content"].toString();
+    message.toolCalls = obj["tool_calls"].toArray();
+    message.toolName = obj["tool_name"].toString();
+    message.toolCallId = obj["tool_call_id"].toString();
+    message.isError = obj["error"].toBool(false);
+    message.timings = obj["timings"].toObject();
+    message.timestamp = QDateTime::fromString(obj["t"].toString(), Qt::ISODateWithMs);
+    return message;
+}
+
+ConversationJournal::ConversationJournal(QObject *parent)
+    : QObject(parent)
+    , m_syncTimer(new QTimer(this))
+    , m_pendingSync(0)
+    , m_syncCount(0)
+    , m_syncBatchSize(JOURNAL_SYNC_BATCH) {
+    m_syncTimer->setSingleShot(true);
+    m_syncTimer->setInterval(JOURNAL_SYNC_INTERVAL_MS);
+    connect(m_syncTimer, &QTimer::timeout, this, [this]() {
+        sync();
+    });
+}
+
+ConversationJournal::~ConversationJournal() {
+    // Leave the journal recoverable: only an explicit close() marks it finished
+    close(false);
+}
+
+void ConversationJournal::setSyncIntervalMs(int ms) {
+    m_syncTimer->setInterval(qMax(0, ms));
+}
+
+bool ConversationJournal::open(const QString &path, const QJsonObject &header) {
+    close(false);
+
+    QFileInfo info(path);
+    if (!info.dir().exists() && !info.dir().mkpath(".")) {
+        LOG_ERROR(QString("Failed to create journal directory: %1").arg(info.dir().path()));
+        return false;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        LOG_ERROR(QString("Failed to open conversation journal: %1").arg(path));
+        return false;
+    }
+    m_path = path;
+    m_pendingSync = 0;
+
+    if (m_file.size() > 0 && !trimTornTail()) {
+        m_file.close();
+        return false;
+    }
+    if (m_file.size() > 0) {
+        m_file.seek(m_file.size());
+        LOG_INFO(QString("Continuing conversation journal: %1").arg(path));
+        return true;
+    }
+
+    QJsonObject record = header;
+    record["type"] = "conversation";
+    record["version"] = 2;
+    record["app"] = APP_NAME;
+    record["app_version"] = APP_VERSION;
+    record["created_at"] = timestampString(QDateTime::currentDateTime());
+
+    LOG_INFO(QString("Started conversation journal: %1").arg(path));
+    return appendRecord(record);
+}
+
+bool ConversationJournal::trimTornTail() {
+    qint64 size = m_file.size();
+    qint64 end = size;
+
+    // Find the last newline; anything after it is a partially written record
+    while (end > 0) {
+        qint64 start = qMax<qint64>(0, end - TAIL_READ_CHUNK);
+        m_file.seek(start);
+        QByteArray chunk = m_file.read(end - start);
+        int newline = chunk.lastIndexOf('\n');
+        if (newline >= 0) {
+            end = start + newline + 1;
+            break;
+        }
+        end = start;
+    }
+
+    if (end == size) {
+        return true;
+    }
+
+    LOG_WARNING(QString("Conversation journal %1 ends with a torn record, dropping %2 bytes")
+                .arg(m_path).arg(size - end));
+    if (!m_file.resize(end)) {
+        LOG_ERROR(QString("Failed to truncate conversation journal: %1").arg(m_file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+void ConversationJournal::close(bool writeCloseMarker) {
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    if (writeCloseMarker) {
+        QJsonObject record;
+        record["type"] = "close";
+        record["t"] = timestampString(QDateTime::currentDateTime());
+        appendRecord(record);
+    }
+
+    sync();
+    m_file.close();
+    m_syncTimer->stop();
+}
+
+bool ConversationJournal::append(const ConversationMessage &message) {
+    return appendRecord(message.toJson());
+}
+
+bool ConversationJournal::appendImport(const QString &content, const QString &contentHtml) {
+    QJsonObject record;
+    record["type"] = "import";
+    record["content"] = content;
+    record["content_html"] = contentHtml;
+    return appendRecord(record);
+}
+
+bool ConversationJournal::appendRecord(const QJsonObject &record) {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    // Flush to the OS right away so an application crash loses nothing
+    if (m_file.write(line) != line.size() || !m_file.flush()) {
+        QString error = QString("Failed to write conversation journal %1: %2").arg(m_path, m_file.errorString());
+        LOG_ERROR(error);
+        emit writeFailed(error);
+        return false;
+    }
+
+    // fsync in batches
+    m_pendingSync++;
+    if (m_pendingSync >= m_syncBatchSize) {
+        sync();
+    } else if (!m_syncTimer->isActive()) {
+        m_syncTimer->start();
+    }
+    return true;
+}
+
+bool ConversationJournal::sync() {
+    m_syncTimer->stop();
+    if (!m_file.isOpen() || m_pendingSync == 0) {
+        return m_file.isOpen();
+    }
+
+    m_file.flush();
+#ifdef Q_OS_UNIX
+    if (::fsync(m_file.handle()) != 0) {
+        QString error = QString("Failed to sync conversation journal: %1").arg(m_path);
+        LOG_ERROR(error);
+        emit writeFailed(error);
+        return false;
+    }
+#endif
+
+    LOG_DEBUG(QString("Conversation journal synced (%1 records)").arg(m_pendingSync));
+    m_pendingSync = 0;
+    m_syncCount++;
+    return true;
+}
+
+bool ConversationJournal::moveTo(const QString &newPath) {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (QFileInfo(newPath).absoluteFilePath() == QFileInfo(m_path).absoluteFilePath()) {
+        return sync();
+    }
+
+    QString oldPath = m_path;
+    close(false);
+
+    if (QFile::exists(newPath)) {
+        QFile::remove(newPath);
+    }
+    // QFile::rename falls back to copy + remove across filesystems
+    if (!QFile::rename(oldPath, newPath)) {
+        LOG_ERROR(QString("Failed to move conversation journal %1 to %2").arg(oldPath, newPath));
+        open(oldPath);
+        return false;
+    }
+
+    LOG_INFO(QString("Conversation journal moved to: %1").arg(newPath));
+    return open(newPath);
+}
+
+bool ConversationJournal::isJournalFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonDocument doc = QJsonDocument::fromJson(file.readLine(TAIL_READ_CHUNK));
+    return doc.isObject() && doc.object()["type"].toString() == "conversation";
+}
+
+bool ConversationJournal::read(const QString &path, ConversationJournalContents &contents, QString *error) {
+    contents = ConversationJournalContents();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QString lastType;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            contents.skippedRecords++;
+            continue;
+        }
+
+        QJsonObject record = doc.object();
+        QString type = record["type"].toString();
+        if (type == "conversation") {
+            contents.header = record;
+        } else if (type == "message") {
+            contents.messages.append(ConversationMessage::fromJson(record));
+        } else if (type == "import") {
+            contents.imports.append(record);
+        }
+        lastType = type;
+    }
+
+    if (contents.header.isEmpty()) {
+        if (error) {
+            *error = QString("Not a conversation journal (missing header record)");
+        }
+        return false;
+    }
+
+    if (contents.skippedRecords > 0) {
+        LOG_WARNING(QString("Skipped %1 unreadable records in %2").arg(contents.skippedRecords).arg(path));
+    }
+
+    contents.cleanlyClosed = (lastType == "close");
+    return true;
+}
+
+QJsonArray ConversationJournal::toLlmHistory(const QList<ConversationMessage> &messages) {
+    QJsonArray history;
+    for (const ConversationMessage &message : messages) {
+        QJsonObject msg;
+        if (message.role == "tool") {
+            // LLMClient keeps tool results as user messages (Ollama may not support "tool")
+            msg["role"] = "user";
+            msg["content"] = QString("Tool: %1\nResult: %2").arg(message.toolName, message.content);
+        } else {
+            msg["role"] = message.role;
+            msg["content"] = message.content;
+            if (!message.toolCalls.isEmpty()) {
+                // Native format: [{"function":{"name","arguments"}}]
+                QJsonArray toolCalls;
+                for (const QJsonValue &callValue : message.toolCalls) {
+                    QJsonObject call = callValue.toObject();
+                    QJsonObject function;
+                    function["name"] = call["name"];
+                    function["arguments"] = call["arguments"];
+                    QJsonObject nativeCall;
+                    nativeCall["function"] = function;
+                    toolCalls.append(nativeCall);
+                }
+                msg["tool_calls"] = toolCalls;
+            }
+        }
+        history.append(msg);
+    }
+    return history;
+}
+
+QString ConversationJournal::autosaveDirectory() {
+    return QDir::homePath() + "/.qtbot/conversations";
+}
+
+QString ConversationJournal::findUnfinished(const QString &directory) {
+    QDir dir(directory);
+    QFileInfoList files = dir.entryInfoList(QStringList() << "*.jsonl", QDir::Files, QDir::Time);
+
+    for (const QFileInfo &info : files) {
+        QString type = readLastRecord(info.absoluteFilePath())["type"].toString();
+        if (type == "message" || type == "import") {
+            return info.absoluteFilePath();
+        }
+    }
+    return QString();
+}
+
+bool ConversationJournalIndex::open(const QString &path, QString *error, qint64 snapshotSize) {
+    clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    qint64 size = file.size();
+    if (snapshotSize >= 0) {
+        size = qMin(size, snapshotSize);
+    }
+    QByteArray buffer;
+    const char *data = nullptr;
+    uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (mapped) {
+        data = reinterpret_cast<const char *>(mapped);
+    } else {
+        buffer = file.read(size);
+        data = buffer.constData();
+        size = buffer.size();
+    }
+
+    // One pass over the record boundaries; a torn last line (no newline) is ignored
+    const char *end = data + size;
+    const char *line = data;
+    bool firstLine = true;
+    while (line < end) {
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        if (!newline) {
+            break;
+        }
+        qint64 length = newline - line;
+
+        if (firstLine) {
+            QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(line, static_cast<int>(length)));
+            m_header = doc.object();
+            firstLine = false;
+        } else if (lineEndsWith(line, length, MESSAGE_SUFFIX)) {
+            m_messageOffsets.append(line - data);
+        } else if (lineEndsWith(line, length, IMPORT_SUFFIX)) {
+            QJsonDocument doc = QJsonDocument::fromJson(QByteArray(line, static_cast<int>(length)));
+            if (doc.isObject()) {
+                m_imports.append(doc.object());
+            }
+        }
+        m_cleanlyClosed = lineEndsWith(line, length, CLOSE_SUFFIX);
+        line = newline + 1;
+    }
+
+    if (mapped) {
+        file.unmap(mapped);
+    }
+
+    if (m_header["type"].toString() != "conversation") {
+        if (error) {
+            *error = QString("Not a conversation journal (missing header record)");
+        }
+        clear();
+        return false;
+    }
+
+    m_path = path;
+    LOG_DEBUG(QString("Indexed conversation journal %1: %2 messages").arg(path).arg(m_messageOffsets.size()));
+    return true;
+}
+
+void ConversationJournalIndex::clear() {
+    m_path.clear();
+    m_header = QJsonObject();
+    m_imports.clear();
+    m_messageOffsets.clear();
+    m_cleanlyClosed = false;
+}
+
+QList<ConversationMessage> ConversationJournalIndex::messages(int first, int count) const {
+    if (first >= m_messageOffsets.size() || count <= 0) {
+        return QList<ConversationMessage>();
+    }
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        LOG_ERROR(QString("Failed to read conversation journal: %1").arg(m_path));
+        return QList<ConversationMessage>();
+    }
+    return messages(&file, first, count);
+}
+
+QList<ConversationMessage> ConversationJournalIndex::messages(QIODevice *file, int first, int count) const {
+    QList<ConversationMessage> result;
+    first = qMax(0, first);
+    int last = qMin(m_messageOffsets.size(), first + count);
+    if (first >= last) {
+        return result;
+    }
+
+    for (int i = first; i < last; ++i) {
+        file->seek(m_messageOffsets[i]);
+        QJsonDocument doc = QJsonDocument::fromJson(file->readLine());
+        if (doc.isObject()) {
+            result.append(ConversationMessage::fromJson(doc.object()));
+        }
+    }
+    return result;
+}
+
+QJsonArray ConversationJournalIndex::llmHistory(int maxTokens) const {
+    QList<ConversationMessage> kept;
+    int tokens = 0;
+    bool budgetReached = false;
+
+    int end = m_messageOffsets.size();
+    while (end > 0 && !budgetReached) {
+        int first = qMax(0, end - JOURNAL_PAGE_SIZE);
+        QList<ConversationMessage> page = messages(first, end - first);
+        for (int i = page.size() - 1; i >= 0; --i) {
+            int messageTokens = estimateMessageTokens(page[i]);
+            if (maxTokens > 0 && tokens + messageTokens > maxTokens && !kept.isEmpty()) {
+                budgetReached = true;
+                break;
+            }
+            tokens += messageTokens;
+            kept.prepend(page[i]);
+        }
+        end = first;
+    }
+
+    // Don't start with a tool call or result whose question was dropped
+    while (!kept.isEmpty() && kept.first().role != "user") {
+        kept.removeFirst();
+    }
+
+    if (budgetReached) {
+        LOG_INFO(QString("Restored the newest %1 of %2 messages into the model history (~%3 tokens)")
+                 .arg(kept.size()).arg(m_messageOffsets.size()).arg(tokens));
+    }
+    return ConversationJournal::toLlmHistory(kept);
+}
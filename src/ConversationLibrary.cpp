@@ -0,0 +1,565 @@
+/**
+ * ConversationLibrary.cpp - Full-text index over saved conversations
+ *
+ * Messages live in an FTS5 table whose rowid encodes (session, message):
+ * a conversation's messages are one contiguous rowid range, so replacing
+ * them is a range delete and a hit maps back to its session without a
+ * lookup table.
+ */
+
+#include "ConversationLibrary.h"
+#include "ConversationJournal.h"
+#include "Logger.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+
+namespace {
+
+// rowid = (session id << SESSION_ROWID_SHIFT) | message index
+const int SESSION_ROWID_SHIFT = 20;
+const int MAX_INDEXED_MESSAGES = 1 << SESSION_ROWID_SHIFT;
+
+// Messages parsed per read while indexing a journal
+const int INDEX_PAGE_SIZE = 200;
+
+const int TITLE_LENGTH = 80;
+
+qint64 messageRowId(qint64 sessionId, int index) {
+    return (sessionId << SESSION_ROWID_SHIFT) | index;
+}
+
+QString makeTitle(const QString &text) {
+    QString title = text.simplified();
+    if (title.length() > TITLE_LENGTH) {
+        title = title.left(TITLE_LENGTH - 1) + QChar(0x2026);
+    }
+    return title;
+}
+
+// Bind the filter clauses appended by filterClause()
+void bindFilter(QSqlQuery &query, const LibraryFilter &filter) {
+    if (!filter.model.isEmpty()) {
+        query.bindValue(":model", filter.model);
+    }
+    if (filter.from.isValid()) {
+        query.bindValue(":from", filter.from.toString(Qt::ISODate));
+    }
+    if (filter.to.isValid()) {
+        query.bindValue(":to", filter.to.addDays(1).toString(Qt::ISODate));
+    }
+}
+
+// created_at is ISO 8601 text, so date bounds compare as strings
+QString filterClause(const LibraryFilter &filter) {
+    QString clause;
+    if (!filter.model.isEmpty()) {
+        clause += " AND s.model = :model";
+    }
+    if (filter.from.isValid()) {
+        clause += " AND s.created_at >= :from";
+    }
+    if (filter.to.isValid()) {
+        clause += " AND s.created_at < :to";
+    }
+    return clause;
+}
+
+LibrarySession sessionFromQuery(const QSqlQuery &query) {
+    LibrarySession session;
+    session.path = query.value(0).toString();
+    session.title = query.value(1).toString();
+    session.model = query.value(2).toString();
+    session.backend = query.value(3).toString();
+    session.createdAt = QDateTime::fromString(query.value(4).toString(), Qt::ISODate);
+    session.messageCount = query.value(5).toInt();
+    return session;
+}
+
+} // namespace
+
+ConversationLibrary::ConversationLibrary(QObject *parent)
+    : QObject(parent)
+    , m_connectionName(QString("conversation-library-%1").arg(reinterpret_cast<quintptr>(this), 0, 16))
+    , m_open(false) {
+}
+
+ConversationLibrary::~ConversationLibrary() {
+    close();
+}
+
+QString ConversationLibrary::defaultDatabasePath() {
+    return QDir::homePath() + "/.qtbot/library.db";
+}
+
+bool ConversationLibrary::open(const QString &databasePath) {
+    close();
+
+    QString path = databasePath.isEmpty() ? defaultDatabasePath() : databasePath;
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            m_lastError = db.lastError().text();
+            LOG_ERROR(QString("Failed to open conversation library %1: %2").arg(path, m_lastError));
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(m_connectionName);
+            return false;
+        }
+    }
+    m_open = true;
+
+    // Readers never block the indexer; NORMAL is durable enough for a rebuildable index
+    exec("PRAGMA journal_mode=WAL");
+    exec("PRAGMA synchronous=NORMAL");
+
+    bool created = exec("CREATE TABLE IF NOT EXISTS sessions ("
+                        "id INTEGER PRIMARY KEY, "
+                        "path TEXT UNIQUE NOT NULL, "
+                        "title TEXT NOT NULL DEFAULT '', "
+                        "model TEXT NOT NULL DEFAULT '', "
+                        "backend TEXT NOT NULL DEFAULT '', "
+                        "created_at TEXT NOT NULL DEFAULT '', "
+                        "message_count INTEGER NOT NULL DEFAULT 0, "
+                        "file_size INTEGER NOT NULL DEFAULT 0, "
+                        "file_mtime INTEGER NOT NULL DEFAULT 0)")
+        && exec("CREATE INDEX IF NOT EXISTS sessions_created_at ON sessions(created_at)")
+        && exec("CREATE TABLE IF NOT EXISTS folders (path TEXT PRIMARY KEY)");
+
+    if (created && !exec("CREATE VIRTUAL TABLE IF NOT EXISTS messages USING fts5("
+                         "content, role UNINDEXED, tokenize = 'unicode61 remove_diacritics 2')")) {
+        m_lastError = tr("SQLite was built without FTS5: %1").arg(m_lastError);
+        created = false;
+    }
+
+    if (!created) {
+        LOG_ERROR(QString("Failed to initialize conversation library: %1").arg(m_lastError));
+        close();
+        return false;
+    }
+
+    LOG_INFO(QString("Conversation library opened: %1 (%2 conversations)").arg(path).arg(sessionCount()));
+    return true;
+}
+
+void ConversationLibrary::close() {
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+    {
+        QSqlDatabase db = database();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+    m_open = false;
+}
+
+QSqlDatabase ConversationLibrary::database() const {
+    return QSqlDatabase::database(m_connectionName, false);
+}
+
+bool ConversationLibrary::exec(const QString &sql) {
+    QSqlQuery query(database());
+    if (!query.exec(sql)) {
+        m_lastError = query.lastError().text();
+        LOG_DEBUG(QString("Conversation library query failed: %1 (%2)").arg(m_lastError, sql));
+        return false;
+    }
+    return true;
+}
+
+bool ConversationLibrary::indexFile(const QString &path) {
+    if (!m_open) {
+        return false;
+    }
+
+    QFileInfo info(path);
+    QString filePath = info.absoluteFilePath();
+    if (!info.isFile()) {
+        removeSession(filePath);
+        return false;
+    }
+
+    qint64 size = info.size();
+    qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+    qint64 sessionId = -1;
+    int indexedMessages = 0;
+    qint64 indexedSize = 0;
+    {
+        QSqlQuery query(database());
+        query.prepare("SELECT id, message_count, file_size, file_mtime FROM sessions WHERE path = ?");
+        query.addBindValue(filePath);
+        if (query.exec() && query.next()) {
+            sessionId = query.value(0).toLongLong();
+            indexedMessages = query.value(1).toInt();
+            indexedSize = query.value(2).toLongLong();
+            if (indexedSize == size && query.value(3).toLongLong() == mtime) {
+                return true;
+            }
+        }
+    }
+
+    bool isJournal = ConversationJournal::isJournalFile(filePath);
+    if (!isJournal && !filePath.endsWith(".json", Qt::CaseInsensitive)) {
+        return false;
+    }
+
+    QSqlDatabase db = database();
+    db.transaction();
+
+    if (sessionId < 0) {
+        QSqlQuery insert(db);
+        insert.prepare("INSERT INTO sessions (path) VALUES (?)");
+        insert.addBindValue(filePath);
+        if (!insert.exec()) {
+            m_lastError = insert.lastError().text();
+            db.rollback();
+            return false;
+        }
+        sessionId = insert.lastInsertId().toLongLong();
+    }
+
+    // Journals only grow; a smaller file was rewritten and is indexed from scratch
+    int firstMessage = size >= indexedSize ? indexedMessages : 0;
+
+    bool indexed = isJournal
+        ? indexJournal(filePath, sessionId, firstMessage, size, mtime)
+        : indexLegacy(filePath, sessionId, size, mtime);
+
+    if (!indexed) {
+        db.rollback();
+        LOG_DEBUG(QString("Not indexed in conversation library: %1 (%2)").arg(filePath, m_lastError));
+        return false;
+    }
+
+    if (!db.commit()) {
+        m_lastError = db.lastError().text();
+        LOG_ERROR(QString("Failed to update conversation library: %1").arg(m_lastError));
+        return false;
+    }
+
+    emit sessionIndexed(filePath);
+    return true;
+}
+
+bool ConversationLibrary::indexJournal(const QString &path, qint64 sessionId, int indexedMessages,
+                                       qint64 size, qint64 mtime) {
+    ConversationJournalIndex index;
+    if (!index.open(path, &m_lastError)) {
+        return false;
+    }
+
+    int total = qMin(index.messageCount(), MAX_INDEXED_MESSAGES);
+    int first = indexedMessages <= total ? indexedMessages : 0;
+    if (first == 0) {
+        deleteMessages(sessionId);
+    }
+
+    QSqlQuery insert(database());
+    insert.prepare("INSERT INTO messages (rowid, content, role) VALUES (?, ?, ?)");
+
+    QString title;
+    for (int pageStart = first; pageStart < total; pageStart += INDEX_PAGE_SIZE) {
+        QList<ConversationMessage> page = index.messages(pageStart, qMin(INDEX_PAGE_SIZE, total - pageStart));
+        for (int i = 0; i < page.size(); ++i) {
+            const ConversationMessage &message = page[i];
+
+            QString content = message.content;
+            for (const QJsonValue &call : message.toolCalls) {
+                content += " " + call.toObject()["name"].toString();
+            }
+            if (content.trimmed().isEmpty()) {
+                continue;
+            }
+            if (title.isEmpty() && message.role == "user") {
+                title = makeTitle(message.content);
+            }
+
+            insert.addBindValue(messageRowId(sessionId, pageStart + i));
+            insert.addBindValue(content);
+            insert.addBindValue(message.role);
+            if (!insert.exec()) {
+                m_lastError = insert.lastError().text();
+                return false;
+            }
+        }
+    }
+
+    QJsonObject header = index.header();
+    QSqlQuery update(database());
+    // The title is the first user message; appended messages keep an existing one
+    QString titleColumn = first == 0 ? QString(":title") : QString("CASE WHEN title = '' THEN :title ELSE title END");
+    update.prepare("UPDATE sessions SET title = " + titleColumn + ", "
+                   "model = :model, backend = :backend, created_at = :created_at, "
+                   "message_count = :count, file_size = :size, file_mtime = :mtime "
+                   "WHERE id = :id");
+    update.bindValue(":title", title);
+    update.bindValue(":model", header["model"].toString());
+    update.bindValue(":backend", header["backend"].toString());
+    update.bindValue(":created_at", header["created_at"].toString());
+    update.bindValue(":count", total);
+    update.bindValue(":size", size);
+    update.bindValue(":mtime", mtime);
+    update.bindValue(":id", sessionId);
+    if (!update.exec()) {
+        m_lastError = update.lastError().text();
+        return false;
+    }
+
+    LOG_DEBUG(QString("Indexed %1 new messages of %2").arg(total - first).arg(path));
+    return true;
+}
+
+bool ConversationLibrary::indexLegacy(const QString &path, qint64 sessionId, qint64 size, qint64 mtime) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_lastError = file.errorString();
+        return false;
+    }
+
+    QJsonObject conversation = QJsonDocument::fromJson(file.readAll()).object();
+    if (!conversation.contains("content")) {
+        m_lastError = tr("Not a conversation file");
+        return false;
+    }
+
+    // Legacy files hold the rendered transcript only: index it as one document
+    deleteMessages(sessionId);
+
+    QSqlQuery insert(database());
+    insert.prepare("INSERT INTO messages (rowid, content, role) VALUES (?, ?, 'transcript')");
+    insert.addBindValue(messageRowId(sessionId, 0));
+    insert.addBindValue(conversation["content"].toString());
+    if (!insert.exec()) {
+        m_lastError = insert.lastError().text();
+        return false;
+    }
+
+    QSqlQuery update(database());
+    update.prepare("UPDATE sessions SET title = ?, model = ?, backend = ?, created_at = ?, "
+                   "message_count = 1, file_size = ?, file_mtime = ? WHERE id = ?");
+    update.addBindValue(QFileInfo(path).completeBaseName());
+    update.addBindValue(conversation["model"].toString());
+    update.addBindValue(conversation["backend"].toString());
+    update.addBindValue(conversation["saved_at"].toString());
+    update.addBindValue(size);
+    update.addBindValue(mtime);
+    update.addBindValue(sessionId);
+    if (!update.exec()) {
+        m_lastError = update.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void ConversationLibrary::deleteMessages(qint64 sessionId) {
+    QSqlQuery remove(database());
+    remove.prepare("DELETE FROM messages WHERE rowid >= ? AND rowid < ?");
+    remove.addBindValue(messageRowId(sessionId, 0));
+    remove.addBindValue(messageRowId(sessionId + 1, 0));
+    remove.exec();
+}
+
+bool ConversationLibrary::removeSession(const QString &path) {
+    if (!m_open) {
+        return false;
+    }
+
+    QString filePath = QFileInfo(path).absoluteFilePath();
+    QSqlQuery query(database());
+    query.prepare("SELECT id FROM sessions WHERE path = ?");
+    query.addBindValue(filePath);
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+    qint64 sessionId = query.value(0).toLongLong();
+
+    QSqlDatabase db = database();
+    db.transaction();
+    deleteMessages(sessionId);
+    QSqlQuery remove(db);
+    remove.prepare("DELETE FROM sessions WHERE id = ?");
+    remove.addBindValue(sessionId);
+    remove.exec();
+    db.commit();
+
+    LOG_DEBUG(QString("Removed from conversation library: %1").arg(filePath));
+    return true;
+}
+
+int ConversationLibrary::addFolder(const QString &directory) {
+    if (!m_open) {
+        return 0;
+    }
+
+    QString folderPath = QDir(directory).absolutePath();
+    QSqlQuery insert(database());
+    insert.prepare("INSERT OR IGNORE INTO folders (path) VALUES (?)");
+    insert.addBindValue(folderPath);
+    insert.exec();
+
+    int indexed = 0;
+    QFileInfoList files = QDir(folderPath).entryInfoList(QStringList() << "*.jsonl" << "*.json", QDir::Files);
+    for (const QFileInfo &info : files) {
+        if (indexFile(info.absoluteFilePath())) {
+            ++indexed;
+        }
+    }
+
+    LOG_INFO(QString("Conversation library folder %1: %2 conversations").arg(folderPath).arg(indexed));
+    return indexed;
+}
+
+QStringList ConversationLibrary::folders() const {
+    QStringList result;
+    QSqlQuery query(database());
+    if (query.exec("SELECT path FROM folders ORDER BY path")) {
+        while (query.next()) {
+            result.append(query.value(0).toString());
+        }
+    }
+    return result;
+}
+
+int ConversationLibrary::refresh() {
+    if (!m_open) {
+        return 0;
+    }
+
+    QStringList paths;
+    {
+        QSqlQuery query(database());
+        if (query.exec("SELECT path FROM sessions")) {
+            while (query.next()) {
+                paths.append(query.value(0).toString());
+            }
+        }
+    }
+
+    // Known files first (missing ones are dropped), then anything new in folders
+    QSet<QString> known;
+    for (const QString &path : paths) {
+        if (indexFile(path)) {
+            known.insert(path);
+        }
+    }
+
+    for (const QString &folder : folders()) {
+        QFileInfoList files = QDir(folder).entryInfoList(QStringList() << "*.jsonl" << "*.json", QDir::Files);
+        for (const QFileInfo &info : files) {
+            if (!known.contains(info.absoluteFilePath()) && indexFile(info.absoluteFilePath())) {
+                known.insert(info.absoluteFilePath());
+            }
+        }
+    }
+
+    return known.size();
+}
+
+QString ConversationLibrary::toMatchExpression(const QString &query) {
+    // Every word is a quoted prefix term, so FTS5 operators typed by the user are literal text
+    QStringList terms;
+    const QStringList words = query.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    for (QString word : words) {
+        word.replace('"', "\"\"");
+        terms.append(QString("\"%1\"*").arg(word));
+    }
+    return terms.join(' ');
+}
+
+QList<LibraryHit> ConversationLibrary::search(const QString &text, const LibraryFilter &filter, int limit) const {
+    if (!m_open) {
+        return QList<LibraryHit>();
+    }
+
+    QString match = toMatchExpression(text);
+    if (match.isEmpty()) {
+        return recentSessions(filter, limit);
+    }
+
+    // Over-fetch messages, then keep the best one per conversation
+    QSqlQuery query(database());
+    query.prepare("SELECT s.path, s.title, s.model, s.backend, s.created_at, s.message_count, "
+                  "messages.rowid, messages.role, "
+                  "snippet(messages, 0, '[', ']', '…', 12), bm25(messages) AS rank "
+                  "FROM messages JOIN sessions s ON s.id = (messages.rowid >> " + QString::number(SESSION_ROWID_SHIFT) + ") "
+                  "WHERE messages MATCH :match" + filterClause(filter) + " "
+                  "ORDER BY rank LIMIT :fetch");
+    query.bindValue(":match", match);
+    query.bindValue(":fetch", limit * 4);
+    bindFilter(query, filter);
+
+    QList<LibraryHit> hits;
+    if (!query.exec()) {
+        LOG_WARNING(QString("Conversation library search failed: %1").arg(query.lastError().text()));
+        return hits;
+    }
+
+    QSet<QString> seen;
+    while (query.next() && hits.size() < limit) {
+        LibraryHit hit;
+        hit.session = sessionFromQuery(query);
+        if (seen.contains(hit.session.path)) {
+            continue;
+        }
+        seen.insert(hit.session.path);
+
+        hit.messageIndex = static_cast<int>(query.value(6).toLongLong() & (MAX_INDEXED_MESSAGES - 1));
+        hit.role = query.value(7).toString();
+        hit.snippet = query.value(8).toString();
+        hit.rank = query.value(9).toDouble();
+        hits.append(hit);
+    }
+    return hits;
+}
+
+QList<LibraryHit> ConversationLibrary::recentSessions(const LibraryFilter &filter, int limit) const {
+    QSqlQuery query(database());
+    query.prepare("SELECT s.path, s.title, s.model, s.backend, s.created_at, s.message_count "
+                  "FROM sessions s WHERE 1 = 1" + filterClause(filter) + " "
+                  "ORDER BY s.created_at DESC LIMIT :limit");
+    query.bindValue(":limit", limit);
+    bindFilter(query, filter);
+
+    QList<LibraryHit> hits;
+    if (!query.exec()) {
+        LOG_WARNING(QString("Conversation library listing failed: %1").arg(query.lastError().text()));
+        return hits;
+    }
+    while (query.next()) {
+        LibraryHit hit;
+        hit.session = sessionFromQuery(query);
+        hits.append(hit);
+    }
+    return hits;
+}
+
+QStringList ConversationLibrary::models() const {
+    QStringList result;
+    QSqlQuery query(database());
+    if (query.exec("SELECT DISTINCT model FROM sessions WHERE model <> '' ORDER BY model")) {
+        while (query.next()) {
+            result.append(query.value(0).toString());
+        }
+    }
+    return result;
+}
+
+int ConversationLibrary::sessionCount() const {
+    QSqlQuery query(database());
+    if (query.exec("SELECT COUNT(*) FROM sessions") && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * ConversationLibraryDialog.cpp - Search and open saved conversations
+ *
+ * Queries run on every keystroke after a short debounce; each one is a
+ * single FTS query, so results update while typing.
+ */
+
+#include "ConversationLibraryDialog.h"
+#include "ConversationLibrary.h"
+#include "Logger.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+
+namespace {
+
+// Wait this long after the last keystroke before searching
+const int SEARCH_DEBOUNCE_MS = 150;
+const int MAX_RESULTS = 200;
+
+enum DateRange { AnyTime, Today, PastWeek, PastMonth, PastYear };
+
+} // namespace
+
+ConversationLibraryDialog::ConversationLibraryDialog(ConversationLibrary *library, QWidget *parent)
+    : QDialog(parent)
+    , library(library)
+    , searchTimer(new QTimer(this)) {
+    setWindowTitle(tr("Conversation Library"));
+    setMinimumSize(800, 500);
+
+    searchTimer->setSingleShot(true);
+    searchTimer->setInterval(SEARCH_DEBOUNCE_MS);
+    connect(searchTimer, &QTimer::timeout, this, &ConversationLibraryDialog::runSearch);
+
+    createUI();
+    reloadModels();
+    runSearch();
+
+    // Pick up files changed since the last visit once the dialog is visible
+    QTimer::singleShot(0, this, &ConversationLibraryDialog::refreshIndex);
+}
+
+void ConversationLibraryDialog::createUI() {
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Search and filters
+    QHBoxLayout *searchLayout = new QHBoxLayout();
+
+    searchField = new QLineEdit(this);
+    searchField->setPlaceholderText(tr("Search all saved conversations..."));
+    searchField->setClearButtonEnabled(true);
+    connect(searchField, &QLineEdit::textChanged, searchTimer, QOverload<>::of(&QTimer::start));
+    connect(searchField, &QLineEdit::returnPressed, this, &ConversationLibraryDialog::openSelected);
+    searchLayout->addWidget(searchField, 1);
+
+    modelCombo = new QComboBox(this);
+    connect(modelCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &ConversationLibraryDialog::runSearch);
+    searchLayout->addWidget(modelCombo);
+
+    dateCombo = new QComboBox(this);
+    dateCombo->addItem(tr("Any time"), AnyTime);
+    dateCombo->addItem(tr("Today"), Today);
+    dateCombo->addItem(tr("Past week"), PastWeek);
+    dateCombo->addItem(tr("Past month"), PastMonth);
+    dateCombo->addItem(tr("Past year"), PastYear);
+    connect(dateCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &ConversationLibraryDialog::runSearch);
+    searchLayout->addWidget(dateCombo);
+
+    mainLayout->addLayout(searchLayout);
+
+    // Results
+    resultsTree = new QTreeWidget(this);
+    resultsTree->setColumnCount(4);
+    resultsTree->setHeaderLabels(QStringList() << tr("Conversation") << tr("Model") << tr("Date") << tr("Match"));
+    resultsTree->setRootIsDecorated(false);
+    resultsTree->setUniformRowHeights(true);
+    resultsTree->header()->setSectionResizeMode(0, QHeaderView::Interactive);
+    resultsTree->header()->setStretchLastSection(true);
+    resultsTree->setColumnWidth(0, 260);
+    resultsTree->setColumnWidth(1, 110);
+    resultsTree->setColumnWidth(2, 130);
+    connect(resultsTree, &QTreeWidget::itemActivated, this, &ConversationLibraryDialog::onItemActivated);
+    connect(resultsTree, &QTreeWidget::itemSelectionChanged, this, [this]() {
+        openButton->setEnabled(!resultsTree->selectedItems().isEmpty());
+    });
+    mainLayout->addWidget(resultsTree);
+
+    // Status and buttons
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    statusLabel = new QLabel(this);
+    statusLabel->setStyleSheet("color: #888;");
+    buttonLayout->addWidget(statusLabel, 1);
+
+    QPushButton *addFolderButton = new QPushButton(tr("Add Folder..."), this);
+    connect(addFolderButton, &QPushButton::clicked, this, &ConversationLibraryDialog::addFolder);
+    buttonLayout->addWidget(addFolderButton);
+
+    openButton = new QPushButton(tr("Open"), this);
+    openButton->setEnabled(false);
+    openButton->setDefault(true);
+    connect(openButton, &QPushButton::clicked, this, &ConversationLibraryDialog::openSelected);
+    buttonLayout->addWidget(openButton);
+
+    QPushButton *closeButton = new QPushButton(tr("Close"), this);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+    buttonLayout->addWidget(closeButton);
+
+    mainLayout->addLayout(buttonLayout);
+    setLayout(mainLayout);
+}
+
+void ConversationLibraryDialog::reloadModels() {
+    QString current = modelCombo->currentData().toString();
+
+    modelCombo->blockSignals(true);
+    modelCombo->clear();
+    modelCombo->addItem(tr("All models"), QString());
+    for (const QString &model : library->models()) {
+        modelCombo->addItem(model, model);
+    }
+    int index = modelCombo->findData(current);
+    modelCombo->setCurrentIndex(index >= 0 ? index : 0);
+    modelCombo->blockSignals(false);
+}
+
+void ConversationLibraryDialog::runSearch() {
+    LibraryFilter filter;
+    filter.model = modelCombo->currentData().toString();
+
+    QDate today = QDate::currentDate();
+    switch (dateCombo->currentData().toInt()) {
+        case Today:
+            filter.from = today;
+            break;
+        case PastWeek:
+            filter.from = today.addDays(-7);
+            break;
+        case PastMonth:
+            filter.from = today.addMonths(-1);
+            break;
+        case PastYear:
+            filter.from = today.addYears(-1);
+            break;
+        default:
+            break;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<LibraryHit> hits = library->search(searchField->text(), filter, MAX_RESULTS);
+    qint64 elapsedMs = timer.elapsed();
+
+    resultsTree->clear();
+    QList<QTreeWidgetItem *> items;
+    for (const LibraryHit &hit : hits) {
+        QTreeWidgetItem *item = new QTreeWidgetItem();
+        QString title = hit.session.title.isEmpty() ? QFileInfo(hit.session.path).fileName() : hit.session.title;
+        item->setText(0, title);
+        item->setText(1, hit.session.model);
+        item->setText(2, hit.session.createdAt.toString("yyyy-MM-dd hh:mm"));
+        item->setText(3, hit.snippet.simplified());
+        item->setToolTip(0, hit.session.path);
+        item->setToolTip(3, hit.snippet);
+        item->setData(0, Qt::UserRole, hit.session.path);
+        items.append(item);
+    }
+    resultsTree->addTopLevelItems(items);
+    if (!items.isEmpty()) {
+        resultsTree->setCurrentItem(items.first());
+    }
+
+    statusLabel->setText(tr("%1 of %2 conversations (%3 ms)")
+        .arg(hits.size()).arg(library->sessionCount()).arg(elapsedMs));
+}
+
+void ConversationLibraryDialog::refreshIndex() {
+    statusLabel->setText(tr("Updating index..."));
+    library->refresh();
+    reloadModels();
+    runSearch();
+}
+
+void ConversationLibraryDialog::addFolder() {
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Add Conversation Folder"), QDir::homePath());
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    statusLabel->setText(tr("Indexing %1...").arg(directory));
+    int indexed = library->addFolder(directory);
+    LOG_INFO(QString("Added conversation folder %1 (%2 conversations)").arg(directory).arg(indexed));
+
+    reloadModels();
+    runSearch();
+}
+
+void ConversationLibraryDialog::openSelected() {
+    QTreeWidgetItem *item = resultsTree->currentItem();
+    if (item) {
+        onItemActivated(item);
+    }
+}
+
+void ConversationLibraryDialog::onItemActivated(QTreeWidgetItem *item) {
+    QString fileName = item->data(0, Qt::UserRole).toString();
+    if (fileName.isEmpty()) {
+        return;
+    }
+    emit conversationSelected(fileName);
+    accept();
+}
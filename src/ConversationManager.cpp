@@ -2,30 +2,56 @@
  * ConversationManager.cpp - Conversation persistence and lifecycle management
  * 
  * Handles new/save/load/export operations for conversations, tracks
- * modification state, and manages current file path.
+ * modification state, and manages current file path. Completed messages
+ * go to a ConversationJournal: unsaved conversations are journaled in the
+ * autosave directory, and saving moves that journal to the chosen file.
  */
 
 #include "ConversationManager.h"
 #include "Logger.h"
 #include "Config.h"
-#include "version.h"
 #include <QTextEdit>
 #include <QFileDialog>
 #include <QFile>
-#include <QTextStream>
 #include <QMessageBox>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QRegularExpression>
+
+namespace {
+
+// Header fields for a new journal
+QJsonObject journalHeader() {
+    QJsonObject header;
+    header["model"] = Config::instance().getModel();
+    header["backend"] = Config::instance().getBackend();
+    return header;
+}
+
+} // namespace
 
 ConversationManager::ConversationManager(QTextEdit *chatDisplay, QWidget *parent)
     : QObject(parent)
     , chatDisplay(chatDisplay)
     , parentWidget(parent)
     , conversationModified(false)
-    , currentConversationFile() {
+    , currentConversationFile()
+    , journal(new ConversationJournal(this))
+    , exporter(new ConversationExporter(this))
+    , loadedFrom(0) {
+    connect(exporter, &ConversationExporter::progress, this, &ConversationManager::exportProgress);
+    connect(exporter, &ConversationExporter::finished, this, [this](const QString &fileName) {
+        emit exportProgress(-1, -1);
+        emit messagePosted("System", tr("Conversation exported to: %1").arg(fileName));
+    });
+    connect(exporter, &ConversationExporter::failed, this, [this](const QString &fileName, const QString &error) {
+        emit exportProgress(-1, -1);
+        QMessageBox::warning(parentWidget, tr("Export Failed"),
+            tr("Could not export the conversation to %1:\n%2").arg(fileName, error));
+    });
 }
 
 void ConversationManager::newConversation() {
@@ -33,10 +59,12 @@ void ConversationManager::newConversation() {
         return; // User cancelled
     }
 
+    endConversation();
     chatDisplay->clear();
     conversationModified = false;
     currentConversationFile.clear();
     
+    emit historyRestored(QJsonArray());
     emit conversationChanged();
     emit modificationStateChanged(false);
     emit messagePosted("System", tr("New conversation started."));
@@ -50,46 +78,36 @@ void ConversationManager::saveConversation() {
     if (fileName.isEmpty()) {
         fileName = QFileDialog::getSaveFileName(parentWidget,
             tr("Save Conversation"),
-            QDir::homePath() + "/conversation.json",
-            tr("Conversation Files (*.json);;All Files (*)"));
+            QDir::homePath() + "/conversation.jsonl",
+            tr("Conversation Journals (*.jsonl);;All Files (*)"));
     }
 
     if (fileName.isEmpty()) {
         return;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    // Messages are already journaled: saving moves the autosave journal to
+    // the chosen file (or just syncs it), so cost does not grow with length
+    bool saved;
+    if (journal->isOpen()) {
+        saved = journal->moveTo(fileName) && journal->sync();
+    } else {
+        saved = journal->open(fileName, journalHeader()) && journal->sync();
+    }
+
+    if (!saved) {
         QMessageBox::warning(parentWidget, tr("Save Failed"),
             tr("Could not open file for writing: %1").arg(fileName));
         LOG_ERROR(QString("Failed to save conversation: %1").arg(fileName));
         return;
     }
 
-    // Create JSON structure
-    QJsonObject conversation;
-    conversation["version"] = "1.0";
-    conversation["app"] = APP_NAME;
-    conversation["app_version"] = APP_VERSION;
-    conversation["saved_at"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-    conversation["model"] = Config::instance().getModel();
-    conversation["backend"] = Config::instance().getBackend();
-
-    // Save plain text
-    conversation["content"] = chatDisplay->toPlainText();
-
-    // Save as HTML for formatting preservation
-    conversation["content_html"] = chatDisplay->toHtml();
-
-    QJsonDocument doc(conversation);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
-
     currentConversationFile = fileName;
     conversationModified = false;
     
     emit conversationChanged();
     emit modificationStateChanged(false);
+    emit conversationStored(fileName);
     emit messagePosted("System", tr("Conversation saved to: %1").arg(fileName));
     
     LOG_INFO(QString("Conversation saved to: %1").arg(fileName));
@@ -103,18 +121,182 @@ void ConversationManager::loadConversation() {
     QString fileName = QFileDialog::getOpenFileName(parentWidget,
         tr("Load Conversation"),
         QDir::homePath(),
-        tr("Conversation Files (*.json);;All Files (*)"));
+        tr("Conversation Files (*.jsonl *.json);;All Files (*)"));
 
     if (fileName.isEmpty()) {
         return;
     }
 
+    loadFile(fileName);
+}
+
+bool ConversationManager::openConversationFile(const QString &fileName) {
+    if (fileName == currentConversationFile) {
+        return true;
+    }
+    if (!promptToSaveIfModified("Open Conversation")) {
+        return false; // User cancelled
+    }
+    return loadFile(fileName);
+}
+
+bool ConversationManager::loadFile(const QString &fileName) {
+    if (ConversationJournal::isJournalFile(fileName)) {
+        return loadJournal(fileName);
+    }
+    return loadLegacyConversation(fileName);
+}
+
+bool ConversationManager::loadJournal(const QString &fileName) {
+    // Index record boundaries only; messages are parsed a page at a time
+    ConversationJournalIndex index;
+    QString error;
+    if (!index.open(fileName, &error)) {
+        QMessageBox::warning(parentWidget, tr("Load Failed"),
+            tr("Invalid conversation file format: %1").arg(error));
+        LOG_ERROR(QString("Failed to read conversation journal %1: %2").arg(fileName, error));
+        return false;
+    }
+
+    if (journal->isOpen() && QFileInfo(journal->path()) == QFileInfo(fileName)) {
+        journal->close(false);  // Reloading the file being journaled
+    } else {
+        endConversation();
+    }
+    chatDisplay->clear();
+
+    // Newest page first; older pages are prepended on demand
+    loadedIndex = index;
+    int total = loadedIndex.messageCount();
+    loadedFrom = qMax(0, total - JOURNAL_PAGE_SIZE);
+    emit messagesRestored(toEntries(loadedIndex.messages(loadedFrom, total - loadedFrom), loadedFrom == 0), false);
+
+    // Rebuild the model's history, compacted to the context input budget
+    // (the same 80% LLMClient prunes to before each request)
+    int historyBudget = Config::instance().getContextWindowSize() * 8 / 10;
+    emit historyRestored(loadedIndex.llmHistory(historyBudget));
+
+    // Keep appending where the file left off
+    journal->open(fileName);
+
+    // A journal in the autosave directory was never saved by the user
+    bool recovered = isAutosave(fileName);
+    currentConversationFile = recovered ? QString() : fileName;
+    conversationModified = recovered;
+    
+    emit conversationChanged();
+    emit modificationStateChanged(conversationModified);
+
+    // Show metadata
+    QJsonObject header = loadedIndex.header();
+    QString metadata;
+    if (recovered) {
+        metadata = tr("Recovered unsaved conversation (%1 messages)\nModel: %2 | Backend: %3 | Started: %4")
+            .arg(total)
+            .arg(header["model"].toString())
+            .arg(header["backend"].toString())
+            .arg(header["created_at"].toString());
+    } else {
+        metadata = tr("Loaded conversation from %1 (%2 messages)\nModel: %3 | Backend: %4 | Started: %5")
+            .arg(QFileInfo(fileName).fileName())
+            .arg(total)
+            .arg(header["model"].toString())
+            .arg(header["backend"].toString())
+            .arg(header["created_at"].toString());
+    }
+    if (loadedFrom > 0) {
+        metadata += tr("\nShowing the latest %1 messages. Scroll up to load earlier ones.").arg(total - loadedFrom);
+    }
+
+    emit messagePosted("System", metadata);
+    
+    LOG_INFO(QString("Conversation loaded from: %1 (%2 messages)").arg(fileName).arg(total));
+    return true;
+}
+
+bool ConversationManager::loadEarlierMessages() {
+    if (!hasEarlierMessages()) {
+        return false;
+    }
+
+    int first = qMax(0, loadedFrom - JOURNAL_PAGE_SIZE);
+    QList<ChatEntry> entries = toEntries(loadedIndex.messages(first, loadedFrom - first), first == 0);
+    LOG_DEBUG(QString("Loading earlier messages %1-%2").arg(first).arg(loadedFrom - 1));
+    loadedFrom = first;
+
+    emit messagesRestored(entries, true);
+    return true;
+}
+
+bool ConversationManager::compactTranscript() {
+    if (!journal->isOpen() || !journal->sync()) {
+        return false;
+    }
+
+    // Everything displayed from the journal can be read back from it
+    ConversationJournalIndex index;
+    QString error;
+    if (!index.open(journal->path(), &error)) {
+        LOG_WARNING(QString("Cannot compact transcript: %1").arg(error));
+        return false;
+    }
+
+    int total = index.messageCount();
+    int first = qMax(0, total - JOURNAL_PAGE_SIZE);
+    if (first == 0) {
+        return false;
+    }
+
+    chatDisplay->clear();
+    loadedIndex = index;
+    loadedFrom = first;
+    emit messagesRestored(toEntries(loadedIndex.messages(first, total - first), false), false);
+    emit messagePosted("System", tr("Earlier messages were unloaded to save memory. Scroll up to load them."));
+
+    LOG_INFO(QString("Transcript compacted to the latest %1 of %2 messages").arg(total - first).arg(total));
+    return true;
+}
+
+QList<ChatEntry> ConversationManager::toEntries(const QList<ConversationMessage> &messages, bool includeImports) const {
+    QList<ChatEntry> entries;
+
+    // Imported legacy transcripts precede the journaled messages
+    if (includeImports) {
+        for (const QJsonObject &import : loadedIndex.imports()) {
+            entries.append(ChatEntry{QString(), import["content_html"].toString(), QString()});
+        }
+    }
+
+    QDate today = QDate::currentDate();
+    for (const ConversationMessage &message : messages) {
+        QString timestamp = message.timestamp.date() == today
+            ? message.timestamp.toString("hh:mm:ss")
+            : message.timestamp.toString("yyyy-MM-dd hh:mm");
+
+        if (message.role == "user") {
+            entries.append(ChatEntry{"You", message.content, timestamp});
+        } else if (message.role == "assistant") {
+            for (const QJsonValue &call : message.toolCalls) {
+                entries.append(ChatEntry{"System", tr("🔧 Tool Call: %1").arg(call.toObject()["name"].toString()), timestamp});
+            }
+            if (!message.content.isEmpty()) {
+                entries.append(ChatEntry{"Bot", message.content, timestamp});
+            }
+        } else if (message.role == "tool" && message.isError) {
+            // Successful tool results are only shown through the assistant's answer
+            entries.append(ChatEntry{"System", tr("Tool %1 failed: %2").arg(message.toolName, message.content), timestamp});
+        }
+    }
+    return entries;
+}
+
+bool ConversationManager::loadLegacyConversation(const QString &fileName) {
     QFile file(fileName);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QMessageBox::warning(parentWidget, tr("Load Failed"),
             tr("Could not open file for reading: %1").arg(fileName));
         LOG_ERROR(QString("Failed to load conversation: %1").arg(fileName));
-        return;
+        return false;
     }
 
     QByteArray data = file.readAll();
@@ -127,7 +309,7 @@ void ConversationManager::loadConversation() {
         QMessageBox::warning(parentWidget, tr("Load Failed"),
             tr("Invalid conversation file format: %1").arg(parseError.errorString()));
         LOG_ERROR(QString("Failed to parse conversation file: %1").arg(parseError.errorString()));
-        return;
+        return false;
     }
 
     QJsonObject conversation = doc.object();
@@ -143,14 +325,22 @@ void ConversationManager::loadConversation() {
         chatDisplay->setPlainText(conversation["content"].toString());
     }
 
-    currentConversationFile = fileName;
-    conversationModified = false;
+    // Continue in a new journal; the legacy file itself is left untouched
+    endConversation();
+    if (ensureJournalOpen()) {
+        journal->appendImport(chatDisplay->toPlainText(), chatDisplay->toHtml());
+    }
+
+    // Unsaved until written out as a journal
+    currentConversationFile.clear();
+    conversationModified = true;
     
     emit conversationChanged();
-    emit modificationStateChanged(false);
+    emit modificationStateChanged(true);
 
     // Show metadata
-    QString metadata = tr("Loaded conversation from %1\nModel: %2 | Backend: %3 | Saved: %4")
+    QString metadata = tr("Loaded conversation from %1\nModel: %2 | Backend: %3 | Saved: %4\n"
+                          "Save it to convert it to a conversation journal (.jsonl).")
         .arg(QFileInfo(fileName).fileName())
         .arg(conversation["model"].toString())
         .arg(conversation["backend"].toString())
@@ -158,45 +348,55 @@ void ConversationManager::loadConversation() {
 
     emit messagePosted("System", metadata);
     
-    LOG_INFO(QString("Conversation loaded from: %1").arg(fileName));
+    LOG_INFO(QString("Legacy conversation loaded from: %1").arg(fileName));
+    return true;
 }
 
 void ConversationManager::exportConversation() {
+    if (exporter->isRunning()) {
+        emit messagePosted("System", tr("An export is already running."));
+        return;
+    }
+
+    QString filters = tr("Text Files (*.txt);;Markdown Files (*.md);;JSON Files (*.json)");
+    if (ConversationExporter::compressionAvailable()) {
+        filters += tr(";;Compressed Text (*.txt.gz);;Compressed Markdown (*.md.gz);;Compressed JSON (*.json.gz)");
+    }
+
+    QString selectedFilter;
     QString fileName = QFileDialog::getSaveFileName(parentWidget,
         tr("Export Conversation"),
         QDir::homePath() + "/conversation.txt",
-        tr("Text Files (*.txt);;Markdown Files (*.md);;All Files (*)"));
+        filters, &selectedFilter);
 
     if (fileName.isEmpty()) {
         return;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(parentWidget, tr("Export Failed"),
-            tr("Could not open file for writing: %1").arg(fileName));
-        LOG_ERROR(QString("Failed to open file for export: %1").arg(fileName));
-        return;
+    // Take the extension from the chosen filter when none was typed
+    QRegularExpressionMatch match = QRegularExpression("\\(\\*(\\.[^)]+)\\)").match(selectedFilter);
+    if (match.hasMatch() && QFileInfo(fileName).suffix().isEmpty()) {
+        fileName += match.captured(1);
     }
 
-    QTextStream out(&file);
-
-    // Write header
-    out << "========================================\n";
-    out << tr("%1 Conversation Export\n").arg(APP_NAME);
-    out << tr("Date: %1\n").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
-    out << tr("Model: %1\n").arg(Config::instance().getModel());
-    out << tr("Backend: %1\n").arg(Config::instance().getBackend());
-    out << "========================================\n\n";
+    bool compress = false;
+    ConversationExporter::Format format = ConversationExporter::formatForPath(fileName, &compress);
 
-    // Write conversation
-    out << chatDisplay->toPlainText();
+    // Snapshot: the journal's current length (records are flushed as they are appended)
+    ConversationSnapshot snapshot;
+    snapshot.model = Config::instance().getModel();
+    snapshot.backend = Config::instance().getBackend();
+    if (journal->isOpen()) {
+        snapshot.journalPath = journal->path();
+        snapshot.journalSize = QFileInfo(journal->path()).size();
+    }
 
-    file.close();
+    if (!exporter->start(snapshot, fileName, format, compress)) {
+        emit messagePosted("System", tr("An export is already running."));
+        return;
+    }
 
-    emit messagePosted("System", tr("Conversation exported to: %1").arg(fileName));
-    
-    LOG_INFO(QString("Conversation exported to: %1").arg(fileName));
+    LOG_INFO(QString("Exporting conversation to: %1").arg(fileName));
 }
 
 void ConversationManager::setModified(bool modified) {
@@ -229,3 +429,69 @@ bool ConversationManager::promptToSaveIfModified(const QString &operation) {
 
     return true; // Proceed with operation
 }
+
+void ConversationManager::recordMessage(const ConversationMessage &message) {
+    if (!ensureJournalOpen()) {
+        return;
+    }
+    journal->append(message);
+}
+
+bool ConversationManager::recoverUnsavedConversation() {
+    QString fileName = ConversationJournal::findUnfinished(ConversationJournal::autosaveDirectory());
+    if (fileName.isEmpty()) {
+        return false;
+    }
+
+    LOG_INFO(QString("Recovering unsaved conversation: %1").arg(fileName));
+    return loadJournal(fileName);
+}
+
+void ConversationManager::endConversation() {
+    loadedIndex.clear();
+    loadedFrom = 0;
+
+    if (!journal->isOpen()) {
+        return;
+    }
+
+    QString fileName = journal->path();
+    if (isAutosave(fileName)) {
+        // Never saved by the user (who was asked first where it matters)
+        journal->close(false);
+        QFile::remove(fileName);
+        LOG_DEBUG(QString("Discarded autosave journal: %1").arg(fileName));
+    } else {
+        journal->close();
+        emit conversationStored(fileName);
+    }
+}
+
+void ConversationManager::shutdown() {
+    if (!journal->isOpen()) {
+        return;
+    }
+
+    // An unsaved conversation stays unfinished so the next start recovers it
+    QString fileName = journal->path();
+    bool saved = !isAutosave(fileName);
+    journal->close(saved);
+    if (saved) {
+        emit conversationStored(fileName);
+    }
+}
+
+bool ConversationManager::ensureJournalOpen() {
+    if (journal->isOpen()) {
+        return true;
+    }
+
+    QString fileName = QString("%1/%2.jsonl")
+        .arg(ConversationJournal::autosaveDirectory())
+        .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz"));
+    return journal->open(fileName, journalHeader());
+}
+
+bool ConversationManager::isAutosave(const QString &fileName) const {
+    return QFileInfo(fileName).absoluteDir() == QDir(ConversationJournal::autosaveDirectory());
+}
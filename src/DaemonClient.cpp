@@ -0,0 +1,186 @@
+/**
+ * DaemonClient.cpp - Client for the local daemon's OpenAI-compatible API
+ *
+ * Posts chat requests to /v1/chat/completions with "stream": true and parses
+ * the SSE chunks into token/response signals matching LLMClient's.
+ */
+
+#include "DaemonClient.h"
+#include "Logger.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QJsonDocument>
+#include <QUrl>
+
+DaemonClient::DaemonClient(const QString &baseUrl, QObject *parent)
+    : QObject(parent)
+    , m_networkManager(new QNetworkAccessManager(this)) {
+    setBaseUrl(baseUrl);
+    LOG_INFO(QString("DaemonClient attached to %1").arg(m_baseUrl));
+}
+
+DaemonClient::~DaemonClient() {
+    abort();
+}
+
+void DaemonClient::setBaseUrl(const QString &baseUrl) {
+    m_baseUrl = baseUrl.trimmed();
+    while (m_baseUrl.endsWith('/')) {
+        m_baseUrl.chop(1);
+    }
+}
+
+void DaemonClient::sendMessage(const QString &message) {
+    if (m_currentReply) {
+        LOG_WARNING("DaemonClient: request already in progress");
+        emit errorOccurred("A request is already in progress");
+        return;
+    }
+
+    QJsonObject userMsg;
+    userMsg["role"] = "user";
+    userMsg["content"] = message;
+    m_messages.append(userMsg);
+
+    QJsonObject body;
+    body["messages"] = m_messages;
+    body["stream"] = true;
+
+    QNetworkRequest request(QUrl(m_baseUrl + "/v1/chat/completions"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("Accept", "text/event-stream");
+
+    m_buffer.clear();
+    m_fullResponse.clear();
+    m_streamError.clear();
+
+    m_currentReply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+    connect(m_currentReply, &QNetworkReply::readyRead, this, &DaemonClient::handleStreamingData);
+    connect(m_currentReply, &QNetworkReply::finished, this, &DaemonClient::handleStreamingFinished);
+
+    LOG_DEBUG(QString("DaemonClient: sent message (%1 messages in history)").arg(m_messages.size()));
+}
+
+void DaemonClient::abort() {
+    if (!m_currentReply) {
+        return;
+    }
+
+    QNetworkReply *reply = m_currentReply;
+    m_currentReply = nullptr;
+    reply->disconnect(this);
+    reply->abort();
+    reply->deleteLater();
+
+    // Drop the unanswered user message
+    if (!m_messages.isEmpty()) {
+        m_messages.removeLast();
+    }
+}
+
+void DaemonClient::checkHealth() {
+    QNetworkReply *reply = m_networkManager->get(QNetworkRequest(QUrl(m_baseUrl + "/health")));
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            LOG_WARNING(QString("Daemon health check failed: %1").arg(reply->errorString()));
+            emit healthChecked(false, QJsonObject());
+            return;
+        }
+        emit healthChecked(true, QJsonDocument::fromJson(reply->readAll()).object());
+    });
+}
+
+void DaemonClient::clearConversationHistory() {
+    m_messages = QJsonArray();
+    LOG_INFO("Daemon conversation history cleared");
+}
+
+void DaemonClient::handleStreamingData() {
+    if (!m_currentReply) {
+        return;
+    }
+
+    m_buffer += m_currentReply->readAll();
+
+    // SSE events are separated by blank lines
+    int pos;
+    while ((pos = m_buffer.indexOf("\n\n")) >= 0) {
+        QByteArray event = m_buffer.left(pos);
+        m_buffer.remove(0, pos + 2);
+        processEvent(event);
+    }
+}
+
+void DaemonClient::processEvent(const QByteArray &event) {
+    for (const QByteArray &line : event.split('\n')) {
+        if (!line.startsWith("data:")) {
+            continue;
+        }
+
+        QByteArray data = line.mid(5).trimmed();
+        if (data == "[DONE]" || data.isEmpty()) {
+            continue;
+        }
+
+        QJsonObject obj = QJsonDocument::fromJson(data).object();
+        if (obj.contains("error")) {
+            m_streamError = obj["error"].toObject()["message"].toString();
+            continue;
+        }
+
+        QJsonArray choices = obj["choices"].toArray();
+        if (choices.isEmpty()) {
+            continue;
+        }
+
+        QString token = choices[0].toObject()["delta"].toObject()["content"].toString();
+        if (!token.isEmpty()) {
+            m_fullResponse += token;
+            emit tokenReceived(token);
+        }
+    }
+}
+
+void DaemonClient::handleStreamingFinished() {
+    QNetworkReply *reply = m_currentReply;
+    if (!reply) {
+        return;
+    }
+    m_currentReply = nullptr;
+    reply->deleteLater();
+
+    m_buffer += reply->readAll();
+
+    QString error;
+    if (reply->error() != QNetworkReply::NoError) {
+        // Error responses carry an OpenAI-style {"error": {...}} body
+        QString detail = QJsonDocument::fromJson(m_buffer).object()["error"].toObject()["message"].toString();
+        error = detail.isEmpty() ? QString("Daemon request failed: %1").arg(reply->errorString()) : detail;
+    } else {
+        // Process a trailing event without the final blank line
+        if (!m_buffer.trimmed().isEmpty()) {
+            processEvent(m_buffer);
+        }
+        error = m_streamError;
+    }
+    m_buffer.clear();
+
+    if (!error.isEmpty()) {
+        LOG_ERROR(QString("DaemonClient: %1").arg(error));
+        if (!m_messages.isEmpty()) {
+            m_messages.removeLast();
+        }
+        emit errorOccurred(error);
+        return;
+    }
+
+    QJsonObject assistantMsg;
+    assistantMsg["role"] = "assistant";
+    assistantMsg["content"] = m_fullResponse;
+    m_messages.append(assistantMsg);
+
+    LOG_INFO(QString("DaemonClient: response complete (%1 chars)").arg(m_fullResponse.length()));
+    emit responseReceived(m_fullResponse);
+}
@@ -0,0 +1,67 @@
+/**
+ * DaemonMode.cpp - Headless daemon mode
+ *
+ * Warms up the shared engines, optionally ingests RAG context, and serves
+ * the local API until the process is terminated.
+ */
+
+#include "DaemonMode.h"
+#include "LocalApiServer.h"
+#include "RAGEngine.h"
+#include "Config.h"
+#include "Logger.h"
+#include "MemoryGovernor.h"
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QFileInfo>
+
+int runDaemon(const QCommandLineParser &parser) {
+    QString host = parser.value("host");
+    bool portOk = true;
+    int port = parser.isSet("port") ? parser.value("port").toInt(&portOk) : DAEMON_DEFAULT_PORT;
+    if (!portOk || port <= 0 || port > 65535) {
+        qCritical() << "Invalid port:" << parser.value("port");
+        return 1;
+    }
+
+    QHostAddress address(host);
+    if (address.isNull()) {
+        qCritical() << "Invalid host address:" << host;
+        return 1;
+    }
+
+    LOG_INFO("Running in daemon mode");
+
+    LocalApiServer server;
+    server.warmUp();
+
+    // Build the RAG index once for the lifetime of the daemon
+    QString contextPath = parser.value("context");
+    if (!contextPath.isEmpty()) {
+        QFileInfo info(contextPath);
+        bool ok = info.isDir() ? server.ragEngine()->ingestDirectory(contextPath)
+                               : server.ragEngine()->ingestDocument(contextPath);
+        if (!ok) {
+            LOG_WARNING(QString("Daemon: failed to ingest RAG context from %1").arg(contextPath));
+        }
+    }
+
+    if (!server.listen(address, static_cast<quint16>(port))) {
+        qCritical() << "Failed to start local API server on" << host << port;
+        return 1;
+    }
+
+    // Pick up config.json edits without restarting the daemon
+    Config::instance().watchConfigFile();
+
+    // Long-lived: keep the process inside memory_budget_mb
+    MemoryGovernor::instance().start();
+
+    qInfo().noquote() << QString("Daemon listening on http://%1:%2 (Ctrl+C to stop)")
+                         .arg(address.toString()).arg(server.serverPort());
+
+    int result = QCoreApplication::exec();
+
+    Config::instance().stopWatchingConfigFile();
+    return result;
+}
@@ -10,16 +10,13 @@
 #include "Logger.h"
 #include "RAGEngine.h"
 #include "MCPHandler.h"
+#include "BuiltinTools.h"
 #include <QEventLoop>
 #include <QTimer>
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <iostream>
 
-// Forward declarations of example tools (defined in main.cpp)
-extern QJsonObject exampleCalculatorTool(const QJsonObject &params);
-extern QJsonObject exampleDateTimeTool(const QJsonObject &params);
-
 int runRAGTest() {
     std::cout << "\n========================================" << std::endl;
     std::cout << "  RAG Pipeline Test" << std::endl;
@@ -30,13 +27,22 @@ int runRAGTest() {
 
     // Test 1: Show configuration
     qInfo() << "[Test 1] RAG Engine Configuration...";
+    qInfo() << "   Embedding Provider:" << Config::instance().getRagEmbeddingProvider();
     qInfo() << "   Embedding Model:" << Config::instance().getRagEmbeddingModel();
+    qInfo() << "   Embedding Dimensions:" << (Config::instance().getRagEmbeddingDimensions() > 0
+        ? QString("%1 (%2)").arg(Config::instance().getRagEmbeddingDimensions()).arg(Config::instance().getRagDimensionReduction())
+        : QString("full width"));
     qInfo() << "   Chunk Size:" << Config::instance().getRagChunkSize();
     qInfo() << "   Chunk Overlap:" << Config::instance().getRagChunkOverlap();
     qInfo() << "   Top K:" << Config::instance().getRagTopK();
     qInfo() << "   RAG Enabled:" << (Config::instance().getRagEnabled() ? "yes" : "no");
 
     // Configure RAG engine
+    ragEngine->setEmbeddingProvider(Config::instance().getRagEmbeddingProvider(),
+                                    Config::instance().getRagEmbeddingUrl(),
+                                    Config::instance().getOpenAIApiKey());
+    ragEngine->setDimensionReduction(Config::instance().getRagDimensionReduction(),
+                                     Config::instance().getRagEmbeddingDimensions());
     ragEngine->setEmbeddingModel(Config::instance().getRagEmbeddingModel());
     ragEngine->setChunkSize(Config::instance().getRagChunkSize());
     ragEngine->setChunkOverlap(Config::instance().getRagChunkOverlap());
@@ -0,0 +1,530 @@
+/**
+ * DocumentExtractor.cpp - In-process text extraction for office documents and PDFs
+ *
+ * The ZIP reader only understands what office packages use: stored and
+ * deflated entries in a single-volume, non-ZIP64 archive. Entries are
+ * copied or inflated in blocks straight into the XML reader, and checked
+ * against the size and CRC-32 in the central directory.
+ */
+
+#include "DocumentExtractor.h"
+#include <QFile>
+#include <QBuffer>
+#include <QHash>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QtEndian>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_POPPLER_CPP
+#include <poppler-document.h>
+#include <poppler-page.h>
+#endif
+
+namespace {
+
+// Bytes read, inflated and parsed per step
+const int BLOCK_SIZE = 64 * 1024;
+
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const quint32 END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+const int LOCAL_HEADER_SIZE = 30;
+const int CENTRAL_HEADER_SIZE = 46;
+const int END_OF_DIRECTORY_SIZE = 22;  // Followed by a comment of up to 64 KB
+
+const quint16 METHOD_STORED = 0;
+const quint16 METHOD_DEFLATED = 8;
+const quint16 FLAG_ENCRYPTED = 0x0001;
+
+const char ODF_TEXT_NS[] = "urn:oasis:names:tc:opendocument:xmlns:text:1.0";
+
+quint16 readU16(const char *data) {
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data));
+}
+
+quint32 readU32(const char *data) {
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data));
+}
+
+quint32 updateCrc(quint32 crc, const char *data, int size) {
+#ifdef HAVE_ZLIB
+    return static_cast<quint32>(crc32(crc, reinterpret_cast<const Bytef *>(data), static_cast<uInt>(size)));
+#else
+    static const QVector<quint32> table = [] {
+        QVector<quint32> t(256);
+        for (quint32 n = 0; n < 256; ++n) {
+            quint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (int i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uchar>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+#endif
+}
+
+void setError(QString *error, const QString &message) {
+    if (error) {
+        *error = message;
+    }
+}
+
+/**
+ * Read-only access to the entries of a ZIP archive
+ */
+class ZipArchive {
+public:
+    // Receives an entry's bytes a block at a time; false stops reading
+    using Sink = std::function<bool(const char *data, int size)>;
+
+    // @p device must be open for reading and outlive the archive
+    bool open(QIODevice *device) {
+        m_device = device;
+
+        // The end of central directory record is the last thing in the file, before its comment
+        qint64 fileSize = m_device->size();
+        qint64 tailSize = qMin<qint64>(fileSize, END_OF_DIRECTORY_SIZE + 0xFFFF);
+        m_device->seek(fileSize - tailSize);
+        QByteArray tail = m_device->read(tailSize);
+        int end = -1;
+        for (int i = tail.size() - END_OF_DIRECTORY_SIZE; i >= 0; --i) {
+            if (readU32(tail.constData() + i) == END_OF_DIRECTORY_SIGNATURE) {
+                end = i;
+                break;
+            }
+        }
+        if (end < 0) {
+            return fail("Not a ZIP archive");
+        }
+
+        const char *record = tail.constData() + end;
+        quint16 entryCount = readU16(record + 10);
+        quint32 directorySize = readU32(record + 12);
+        quint32 directoryOffset = readU32(record + 16);
+        if (entryCount == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) {
+            return fail("ZIP64 archives are not supported");
+        }
+        if (static_cast<qint64>(directoryOffset) + directorySize > fileSize) {
+            return fail("Damaged ZIP archive: central directory out of range");
+        }
+
+        m_device->seek(directoryOffset);
+        QByteArray directory = m_device->read(directorySize);
+        if (directory.size() != static_cast<int>(directorySize)) {
+            return fail(QString("Failed to read the central directory: %1").arg(m_device->errorString()));
+        }
+
+        int pos = 0;
+        for (int i = 0; i < entryCount; ++i) {
+            const char *header = directory.constData() + pos;
+            if (pos + CENTRAL_HEADER_SIZE > directory.size() || readU32(header) != CENTRAL_HEADER_SIGNATURE) {
+                return fail("Damaged ZIP archive: bad central directory entry");
+            }
+            int nameLength = readU16(header + 28);
+            int extraLength = readU16(header + 30);
+            int commentLength = readU16(header + 32);
+            if (pos + CENTRAL_HEADER_SIZE + nameLength > directory.size()) {
+                return fail("Damaged ZIP archive: bad central directory entry");
+            }
+
+            Entry entry;
+            entry.flags = readU16(header + 8);
+            entry.method = readU16(header + 10);
+            entry.crc = readU32(header + 16);
+            entry.compressedSize = readU32(header + 20);
+            entry.size = readU32(header + 24);
+            entry.localOffset = readU32(header + 42);
+            m_entries.insert(QString::fromUtf8(header + CENTRAL_HEADER_SIZE, nameLength), entry);
+
+            pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        }
+        return true;
+    }
+
+    /**
+     * Pass entry @p name to @p sink, verifying its size and CRC-32 on the way
+     */
+    bool read(const QString &name, const Sink &sink) {
+        auto it = m_entries.constFind(name);
+        if (it == m_entries.constEnd()) {
+            return fail(QString("%1 not found in the archive").arg(name));
+        }
+        const Entry &entry = it.value();
+        if (entry.flags & FLAG_ENCRYPTED) {
+            return fail("Encrypted ZIP entries are not supported");
+        }
+
+        m_device->seek(entry.localOffset);
+        QByteArray local = m_device->read(LOCAL_HEADER_SIZE);
+        if (local.size() != LOCAL_HEADER_SIZE || readU32(local.constData()) != LOCAL_HEADER_SIGNATURE) {
+            return fail(QString("Damaged ZIP archive: bad local header for %1").arg(name));
+        }
+        qint64 dataOffset = entry.localOffset + LOCAL_HEADER_SIZE
+                            + readU16(local.constData() + 26) + readU16(local.constData() + 28);
+        if (dataOffset + entry.compressedSize > m_device->size()) {
+            return fail(QString("Damaged ZIP archive: %1 is truncated").arg(name));
+        }
+        m_device->seek(dataOffset);
+
+        quint32 crc = 0;
+        qint64 written = 0;
+        auto deliver = [&](const char *data, int size) {
+            written += size;
+            if (written > entry.size) {
+                return fail(QString("Damaged ZIP archive: %1 is larger than recorded").arg(name));
+            }
+            crc = updateCrc(crc, data, size);
+            return sink(data, size);
+        };
+
+        bool ok;
+        if (entry.method == METHOD_STORED) {
+            ok = copyStored(name, entry, deliver);
+        } else if (entry.method == METHOD_DEFLATED) {
+            ok = inflateEntry(name, entry, deliver);
+        } else {
+            return fail(QString("Unsupported ZIP compression method %1 for %2").arg(entry.method).arg(name));
+        }
+        if (!ok) {
+            return false;
+        }
+
+        if (written != entry.size || crc != entry.crc) {
+            return fail(QString("Damaged ZIP archive: %1 fails its checksum").arg(name));
+        }
+        return true;
+    }
+
+    QString error() const { return m_error; }
+
+private:
+    struct Entry {
+        quint16 flags;
+        quint16 method;
+        quint32 crc;
+        qint64 compressedSize;
+        qint64 size;
+        qint64 localOffset;
+    };
+
+    bool fail(const QString &message) {
+        m_error = message;
+        return false;
+    }
+
+    bool copyStored(const QString &name, const Entry &entry, const Sink &deliver) {
+        QByteArray block(BLOCK_SIZE, Qt::Uninitialized);
+        qint64 remaining = entry.compressedSize;
+        while (remaining > 0) {
+            qint64 n = m_device->read(block.data(), qMin<qint64>(BLOCK_SIZE, remaining));
+            if (n <= 0) {
+                return fail(QString("Failed to read %1: %2").arg(name, m_device->errorString()));
+            }
+            remaining -= n;
+            if (!deliver(block.constData(), static_cast<int>(n))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool inflateEntry(const QString &name, const Entry &entry, const Sink &deliver) {
+#ifdef HAVE_ZLIB
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        // Negative window bits: raw deflate data, no zlib header
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return fail("Failed to initialize decompression");
+        }
+        std::unique_ptr<z_stream, int (*)(z_streamp)> cleanup(&stream, inflateEnd);
+
+        QByteArray input(BLOCK_SIZE, Qt::Uninitialized);
+        QByteArray output(BLOCK_SIZE, Qt::Uninitialized);
+        qint64 remaining = entry.compressedSize;
+        int result = Z_OK;
+        bool outputFull = false;  // zlib may still hold output with no input left, e.g. the end of a long match
+        while (result != Z_STREAM_END) {
+            if (stream.avail_in == 0 && !outputFull) {
+                if (remaining == 0) {
+                    return fail(QString("Damaged ZIP archive: %1 is truncated").arg(name));
+                }
+                qint64 n = m_device->read(input.data(), qMin<qint64>(BLOCK_SIZE, remaining));
+                if (n <= 0) {
+                    return fail(QString("Failed to read %1: %2").arg(name, m_device->errorString()));
+                }
+                remaining -= n;
+                stream.next_in = reinterpret_cast<Bytef *>(input.data());
+                stream.avail_in = static_cast<uInt>(n);
+            }
+
+            stream.next_out = reinterpret_cast<Bytef *>(output.data());
+            stream.avail_out = BLOCK_SIZE;
+            result = inflate(&stream, Z_NO_FLUSH);
+            if (result == Z_BUF_ERROR && outputFull) {
+                // Nothing was pending after all; more input is needed
+                outputFull = false;
+                continue;
+            }
+            if (result != Z_OK && result != Z_STREAM_END) {
+                return fail(QString("Damaged ZIP archive: %1 (%2)")
+                            .arg(name, stream.msg ? QString(stream.msg) : QString("inflate failed")));
+            }
+
+            outputFull = stream.avail_out == 0;
+            int produced = BLOCK_SIZE - static_cast<int>(stream.avail_out);
+            if (produced > 0 && !deliver(output.constData(), produced)) {
+                return false;
+            }
+        }
+        return true;
+#else
+        Q_UNUSED(entry);
+        Q_UNUSED(deliver);
+        return fail(QString("Built without zlib: cannot decompress %1").arg(name));
+#endif
+    }
+
+    QIODevice *m_device = nullptr;
+    QHash<QString, Entry> m_entries;
+    QString m_error;
+};
+
+using XmlVisitor = std::function<void(QXmlStreamReader &xml, QString &text)>;
+
+/**
+ * Stream XML part @p part of the package in @p device through @p visit
+ *
+ * @p visit sees every token as the part is inflated and appends the text
+ * it wants kept.
+ */
+QString extractPackageText(QIODevice &device, const QString &part, const XmlVisitor &visit, QString *error) {
+    ZipArchive zip;
+    if (!zip.open(&device)) {
+        setError(error, zip.error());
+        return QString();
+    }
+
+    QXmlStreamReader xml;
+    QString text;
+    QString xmlError;
+    bool finished = false;
+    bool ok = zip.read(part, [&](const char *data, int size) {
+        xml.addData(QByteArray(data, size));
+        while (!finished) {
+            QXmlStreamReader::TokenType token = xml.readNext();
+            if (token == QXmlStreamReader::Invalid) {
+                if (xml.error() == QXmlStreamReader::PrematureDocumentEnded) {
+                    return true;  // Continues with the next block
+                }
+                xmlError = QString("Malformed %1: %2").arg(part, xml.errorString());
+                return false;
+            }
+            visit(xml, text);
+            finished = token == QXmlStreamReader::EndDocument;
+        }
+        return true;
+    });
+
+    if (!ok) {
+        setError(error, xmlError.isEmpty() ? zip.error() : xmlError);
+        return QString();
+    }
+    if (!finished) {
+        setError(error, QString("Malformed %1: document ends early").arg(part));
+        return QString();
+    }
+    return text.trimmed();
+}
+
+QString docxText(QIODevice &device, QString *error) {
+    // Elements are matched by local name, so Strict OOXML's namespace works too
+    bool inRun = false;
+    bool inText = false;
+    return extractPackageText(device, "word/document.xml", [&](QXmlStreamReader &xml, QString &text) {
+        switch (xml.tokenType()) {
+        case QXmlStreamReader::StartElement: {
+            const QStringRef name = xml.name();
+            if (name == QLatin1String("r")) {
+                inRun = true;
+            } else if (name == QLatin1String("t")) {
+                inText = true;
+            } else if (inRun && name == QLatin1String("tab")) {
+                text += '\t';  // Tab stops in paragraph properties are also <w:tab>, but outside a run
+            } else if (inRun && (name == QLatin1String("br") || name == QLatin1String("cr"))) {
+                text += '\n';
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement: {
+            const QStringRef name = xml.name();
+            if (name == QLatin1String("r")) {
+                inRun = false;
+            } else if (name == QLatin1String("t")) {
+                inText = false;
+            } else if (name == QLatin1String("p")) {
+                text += '\n';
+            }
+            break;
+        }
+        case QXmlStreamReader::Characters:
+            if (inText) {
+                text += xml.text();
+            }
+            break;
+        default:
+            break;
+        }
+    }, error);
+}
+
+QString odtText(QIODevice &device, QString *error) {
+    const QString textNs = QLatin1String(ODF_TEXT_NS);
+    int paragraphDepth = 0;  // Paragraphs nest inside notes and frames
+    return extractPackageText(device, "content.xml", [&](QXmlStreamReader &xml, QString &text) {
+        switch (xml.tokenType()) {
+        case QXmlStreamReader::StartElement: {
+            if (xml.namespaceUri() != textNs) {
+                break;
+            }
+            const QStringRef name = xml.name();
+            if (name == QLatin1String("p") || name == QLatin1String("h")) {
+                paragraphDepth++;
+            } else if (paragraphDepth > 0 && name == QLatin1String("s")) {
+                // <text:s text:c="N"/> stands for N spaces
+                int count = xml.attributes().value(textNs, QLatin1String("c")).toInt();
+                text += QString(qBound(1, count, 1024), ' ');
+            } else if (paragraphDepth > 0 && name == QLatin1String("tab")) {
+                text += '\t';
+            } else if (paragraphDepth > 0 && name == QLatin1String("line-break")) {
+                text += '\n';
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement:
+            if (paragraphDepth > 0 && xml.namespaceUri() == textNs
+                && (xml.name() == QLatin1String("p") || xml.name() == QLatin1String("h"))) {
+                paragraphDepth--;
+                text += '\n';
+            }
+            break;
+        case QXmlStreamReader::Characters:
+            if (paragraphDepth > 0) {
+                text += xml.text();
+            }
+            break;
+        default:
+            break;
+        }
+    }, error);
+}
+
+// Runs @p extract over @p data, already in memory
+QString fromBytes(const QByteArray &data, QString (*extract)(QIODevice &, QString *), QString *error) {
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    return extract(buffer, error);
+}
+
+QString fromFile(const QString &filePath, QString (*extract)(QIODevice &, QString *), QString *error) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(error, file.errorString());
+        return QString();
+    }
+    return extract(file, error);
+}
+
+#ifdef HAVE_POPPLER_CPP
+QString pdfText(poppler::document *loaded, QString *error) {
+    std::unique_ptr<poppler::document> document(loaded);
+    if (!document) {
+        setError(error, "Not a PDF, or damaged");
+        return QString();
+    }
+    if (document->is_locked()) {
+        setError(error, "PDF is password protected");
+        return QString();
+    }
+
+    QString text;
+    for (int i = 0; i < document->pages(); ++i) {
+        std::unique_ptr<poppler::page> page(document->create_page(i));
+        if (!page) {
+            continue;
+        }
+        poppler::byte_array utf8 = page->text().to_utf8();
+        text += QString::fromUtf8(utf8.data(), static_cast<int>(utf8.size()));
+        text += '\n';
+    }
+    return text.trimmed();
+}
+#endif
+
+} // namespace
+
+QString DocumentExtractor::extractDocx(const QString &filePath, QString *error) {
+    return fromFile(filePath, docxText, error);
+}
+
+QString DocumentExtractor::extractDocxData(const QByteArray &data, QString *error) {
+    return fromBytes(data, docxText, error);
+}
+
+QString DocumentExtractor::extractOdt(const QString &filePath, QString *error) {
+    return fromFile(filePath, odtText, error);
+}
+
+QString DocumentExtractor::extractOdtData(const QByteArray &data, QString *error) {
+    return fromBytes(data, odtText, error);
+}
+
+QString DocumentExtractor::extractPdf(const QString &filePath, QString *error) {
+#ifdef HAVE_POPPLER_CPP
+    return pdfText(poppler::document::load_from_file(QFile::encodeName(filePath).toStdString()), error);
+#else
+    Q_UNUSED(filePath);
+    setError(error, "Built without poppler-cpp");
+    return QString();
+#endif
+}
+
+QString DocumentExtractor::extractPdfData(const QByteArray &data, QString *error) {
+#ifdef HAVE_POPPLER_CPP
+    // poppler reads from the buffer for as long as the document lives, which is this call
+    return pdfText(poppler::document::load_from_raw_data(data.constData(), data.size()), error);
+#else
+    Q_UNUSED(data);
+    setError(error, "Built without poppler-cpp");
+    return QString();
+#endif
+}
+
+bool DocumentExtractor::canInflate() {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DocumentExtractor::canReadPdf() {
+#ifdef HAVE_POPPLER_CPP
+    return true;
+#else
+    return false;
+#endif
+}
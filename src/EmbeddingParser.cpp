@@ -0,0 +1,241 @@
+/**
+ * EmbeddingParser.cpp - Fast float extraction from embedding responses
+ */
+
+#include "EmbeddingParser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Powers of ten that are exact in a double; scaling by them rounds once
+static const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POW10 = 22;
+
+// Digits past this no longer fit the mantissa and are far below float precision
+static const int MAX_MANTISSA_DIGITS = 19;
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline void skipSpace(const char *data, int size, int &pos) {
+    while (pos < size && isSpace(data[pos])) {
+        ++pos;
+    }
+}
+
+// JSON number at data[pos]; leaves pos after it
+static bool parseNumber(const char *data, int size, int &pos, float &value) {
+    bool negative = false;
+    if (pos < size && data[pos] == '-') {
+        negative = true;
+        ++pos;
+    }
+    if (pos >= size || !isDigit(data[pos])) {
+        return false;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    while (pos < size && isDigit(data[pos])) {
+        if (digits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (data[pos] - '0');
+            if (mantissa != 0) {
+                ++digits;
+            }
+        } else {
+            ++exponent;
+        }
+        ++pos;
+    }
+
+    if (pos < size && data[pos] == '.') {
+        ++pos;
+        if (pos >= size || !isDigit(data[pos])) {
+            return false;
+        }
+        while (pos < size && isDigit(data[pos])) {
+            if (digits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (data[pos] - '0');
+                if (mantissa != 0) {
+                    ++digits;
+                }
+                --exponent;
+            }
+            ++pos;
+        }
+    }
+
+    if (pos < size && (data[pos] == 'e' || data[pos] == 'E')) {
+        ++pos;
+        bool negativeExponent = false;
+        if (pos < size && (data[pos] == '+' || data[pos] == '-')) {
+            negativeExponent = data[pos] == '-';
+            ++pos;
+        }
+        if (pos >= size || !isDigit(data[pos])) {
+            return false;
+        }
+        int written = 0;
+        while (pos < size && isDigit(data[pos])) {
+            if (written < 1000) {
+                written = written * 10 + (data[pos] - '0');
+            }
+            ++pos;
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa == 0) {
+        result = 0.0;
+    } else if (exponent >= 0 && exponent <= MAX_EXACT_POW10) {
+        result *= POW10[exponent];
+    } else if (exponent < 0 && exponent >= -MAX_EXACT_POW10) {
+        result /= POW10[-exponent];
+    } else {
+        result *= std::pow(10.0, exponent);
+    }
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
+
+bool EmbeddingParser::parseArray(const char *data, int size, int &pos, QVector<float> &out) {
+    skipSpace(data, size, pos);
+    if (pos >= size || data[pos] != '[') {
+        return false;
+    }
+    ++pos;
+
+    // One pass over the array's bytes to size the vector exactly
+    const char *close = static_cast<const char *>(std::memchr(data + pos, ']', size - pos));
+    if (!close) {
+        return false;
+    }
+    out.reserve(out.size() + static_cast<int>(std::count(data + pos, close, ',')) + 1);
+
+    skipSpace(data, size, pos);
+    if (pos < size && data[pos] == ']') {
+        ++pos;
+        return true;
+    }
+
+    while (true) {
+        float value;
+        if (!parseNumber(data, size, pos, value)) {
+            return false;
+        }
+        out.append(value);
+
+        skipSpace(data, size, pos);
+        if (pos >= size) {
+            return false;
+        }
+        if (data[pos] == ']') {
+            ++pos;
+            return true;
+        }
+        if (data[pos] != ',') {
+            return false;
+        }
+        ++pos;
+        skipSpace(data, size, pos);
+    }
+}
+
+// Position of the value of "key" at or after pos, or -1
+static int findValue(const QByteArray &json, const QByteArray &quotedKey, int from) {
+    int pos = json.indexOf(quotedKey, from);
+    while (pos >= 0) {
+        int valuePos = pos + quotedKey.size();
+        skipSpace(json.constData(), json.size(), valuePos);
+        if (valuePos < json.size() && json.at(valuePos) == ':') {
+            ++valuePos;
+            skipSpace(json.constData(), json.size(), valuePos);
+            return valuePos;
+        }
+        // The text appeared as a value, not a key
+        pos = json.indexOf(quotedKey, pos + quotedKey.size());
+    }
+    return -1;
+}
+
+int EmbeddingParser::parse(const QByteArray &json, QVector<QVector<float>> &vectors) {
+    static const QByteArray batchKey("\"embeddings\"");
+    static const QByteArray singleKey("\"embedding\"");
+
+    const char *data = json.constData();
+    const int size = json.size();
+    const int start = vectors.size();
+    bool ok = true;
+
+    int pos = findValue(json, batchKey, 0);
+    if (pos >= 0) {
+        // /api/embed: {"embeddings": [[...], [...]]}
+        if (pos >= size || data[pos] != '[') {
+            ok = false;
+        } else {
+            ++pos;
+            skipSpace(data, size, pos);
+            if (pos < size && data[pos] == ']') {
+                ++pos;
+            } else {
+                while (ok) {
+                    QVector<float> vector;
+                    ok = parseArray(data, size, pos, vector);
+                    if (!ok) {
+                        break;
+                    }
+                    vectors.append(vector);
+                    skipSpace(data, size, pos);
+                    if (pos < size && data[pos] == ']') {
+                        break;
+                    }
+                    ok = pos < size && data[pos] == ',';
+                    ++pos;
+                }
+            }
+        }
+    } else {
+        // /api/embeddings, or one "embedding" per item in OpenAI-style "data" lists
+        pos = findValue(json, singleKey, 0);
+        while (ok && pos >= 0) {
+            QVector<float> vector;
+            ok = parseArray(data, size, pos, vector);
+            if (ok) {
+                vectors.append(vector);
+                pos = findValue(json, singleKey, pos);
+            }
+        }
+    }
+
+    // All vectors of one response share the model's dimension
+    int dimension = vectors.size() > start ? vectors.at(start).size() : 0;
+    for (int i = start; ok && i < vectors.size(); ++i) {
+        ok = vectors.at(i).size() == dimension && dimension > 0;
+    }
+
+    if (!ok) {
+        vectors.resize(start);
+        return 0;
+    }
+    return vectors.size() - start;
+}
+
+QVector<float> EmbeddingParser::parseFirst(const QByteArray &json) {
+    QVector<QVector<float>> vectors;
+    if (parse(json, vectors) == 0) {
+        return QVector<float>();
+    }
+    return vectors.first();
+}
@@ -0,0 +1,441 @@
+/**
+ * EmbeddingProvider.cpp - Pluggable embedding backends for RAGEngine
+ */
+
+#include "EmbeddingProvider.h"
+#include "EmbeddingParser.h"
+#include "Logger.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QRunnable>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Texts per /api/embed request; larger batches gain little and delay the first results
+static const int OLLAMA_BATCH_SIZE = 32;
+
+// Texts per /v1/embeddings request (servers commonly cap inputs per call)
+static const int OPENAI_BATCH_SIZE = 64;
+
+static const char *DEFAULT_OLLAMA_URL = "http://localhost:11434";
+static const char *DEFAULT_OPENAI_URL = "https://api.openai.com/v1";
+
+// Local embedder: vector size, batch size per call, and calls small enough to embed inline
+static const int LOCAL_DIMENSIONS = 384;
+static const int LOCAL_BATCH_SIZE = 256;
+static const int LOCAL_INLINE_TEXTS = 16;
+
+// Local feature weights: whole words dominate, pairs add word order, trigrams catch inflections
+static const float WORD_WEIGHT = 1.0f;
+static const float PAIR_WEIGHT = 0.5f;
+static const float TRIGRAM_WEIGHT = 0.25f;
+
+EmbeddingProvider::EmbeddingProvider(QObject *parent)
+    : QObject(parent) {
+}
+
+EmbeddingProvider::~EmbeddingProvider() {
+}
+
+int EmbeddingProvider::nextTicket() {
+    static std::atomic<int> next(1);
+    return next++;
+}
+
+EmbeddingProvider *EmbeddingProvider::create(const QString &type, QObject *parent) {
+    if (type == "openai") {
+        return new OpenAIEmbeddingProvider(parent);
+    }
+    if (type == "local") {
+        return new LocalEmbeddingProvider(parent);
+    }
+    if (type != "ollama") {
+        LOG_WARNING(QString("Unknown embedding provider \"%1\", using Ollama").arg(type));
+    }
+    return new OllamaEmbeddingProvider(parent);
+}
+
+QStringList EmbeddingProvider::types() {
+    return {"ollama", "openai", "local"};
+}
+
+// HttpEmbeddingProvider
+
+HttpEmbeddingProvider::HttpEmbeddingProvider(QObject *parent)
+    : EmbeddingProvider(parent)
+    , m_networkManager(new QNetworkAccessManager(this)) {
+}
+
+HttpEmbeddingProvider::~HttpEmbeddingProvider() {
+    // Replies die with the manager; nobody is waiting for them any more
+    m_calls.clear();
+}
+
+int HttpEmbeddingProvider::embed(const QStringList &texts) {
+    int ticket = nextTicket();
+
+    Call call;
+    call.vectors.resize(texts.size());
+    call.remaining = texts.size();
+    m_calls.insert(ticket, call);
+
+    if (texts.isEmpty()) {
+        QTimer::singleShot(0, this, [this, ticket]() {
+            if (m_calls.remove(ticket) > 0) {
+                emit embeddingsReady(ticket, QVector<QVector<float>>());
+            }
+        });
+        return ticket;
+    }
+
+    int perRequest = qMax(1, textsPerRequest());
+    for (int offset = 0; offset < texts.size(); offset += perRequest) {
+        sendRequest(ticket, texts.mid(offset, perRequest), offset);
+    }
+    return ticket;
+}
+
+void HttpEmbeddingProvider::cancel(int ticket) {
+    auto it = m_calls.find(ticket);
+    if (it == m_calls.end()) {
+        return;
+    }
+    QSet<QNetworkReply*> replies = it->replies;
+    m_calls.erase(it);
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+}
+
+void HttpEmbeddingProvider::sendRequest(int ticket, const QStringList &texts, int offset) {
+    QNetworkRequest request(endpoint(texts.size()));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if (!m_apiKey.isEmpty()) {
+        request.setRawHeader("Authorization", "Bearer " + m_apiKey.toUtf8());
+    }
+
+    QNetworkReply *reply = m_networkManager->post(request, requestBody(texts));
+    m_calls[ticket].replies.insert(reply);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, ticket, texts, offset]() {
+        handleReply(reply, ticket, texts, offset);
+    });
+}
+
+void HttpEmbeddingProvider::handleReply(QNetworkReply *reply, int ticket, const QStringList &texts, int offset) {
+    reply->deleteLater();
+
+    // Cancelled, or another request of the call already failed it
+    auto it = m_calls.find(ticket);
+    if (it == m_calls.end()) {
+        return;
+    }
+    it->replies.remove(reply);
+
+    if (reply->error() != QNetworkReply::NoError) {
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status == 404 && batchRejected(reply->url())) {
+            for (int i = 0; i < texts.size(); ++i) {
+                sendRequest(ticket, QStringList{texts[i]}, offset + i);
+            }
+            return;
+        }
+        failCall(ticket, reply->errorString());
+        return;
+    }
+
+    QVector<QVector<float>> vectors;
+    int count = EmbeddingParser::parse(reply->readAll(), vectors);
+    if (count != texts.size()) {
+        failCall(ticket, QString("Invalid embedding response: expected %1 vectors, got %2")
+                         .arg(texts.size()).arg(count));
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        it->vectors[offset + i] = vectors[i];
+    }
+    it->remaining -= count;
+    if (it->remaining > 0) {
+        return;
+    }
+
+    QVector<QVector<float>> result = it->vectors;
+    m_calls.erase(it);
+    emit embeddingsReady(ticket, result);
+}
+
+void HttpEmbeddingProvider::failCall(int ticket, const QString &error) {
+    Call call = m_calls.take(ticket);
+    for (QNetworkReply *reply : call.replies) {
+        reply->abort();
+    }
+    emit embeddingFailed(ticket, error);
+}
+
+// OllamaEmbeddingProvider
+
+OllamaEmbeddingProvider::OllamaEmbeddingProvider(QObject *parent)
+    : HttpEmbeddingProvider(parent)
+    , m_batchSupported(true) {
+}
+
+int OllamaEmbeddingProvider::maxBatchSize() const {
+    return OLLAMA_BATCH_SIZE;
+}
+
+int OllamaEmbeddingProvider::textsPerRequest() const {
+    return m_batchSupported ? OLLAMA_BATCH_SIZE : 1;
+}
+
+QString OllamaEmbeddingProvider::baseUrl() const {
+    // Accept the server root as well as the endpoint URLs older configs used
+    QString base = m_url.isEmpty() ? QString(DEFAULT_OLLAMA_URL) : m_url;
+    for (const QString &suffix : {QString("/api/embeddings"), QString("/api/embed"), QString("/")}) {
+        if (base.endsWith(suffix)) {
+            base.chop(suffix.size());
+        }
+    }
+    return base;
+}
+
+QUrl OllamaEmbeddingProvider::endpoint(int /*textCount*/) const {
+    // /api/embed for everything while available: its vectors are normalized,
+    // and one index must not mix them with raw /api/embeddings vectors
+    return QUrl(baseUrl() + (m_batchSupported ? "/api/embed" : "/api/embeddings"));
+}
+
+QByteArray OllamaEmbeddingProvider::requestBody(const QStringList &texts) const {
+    QJsonObject body;
+    body["model"] = m_model;
+    if (m_batchSupported) {
+        body["input"] = QJsonArray::fromStringList(texts);
+    } else {
+        body["prompt"] = texts.value(0);
+    }
+    return QJsonDocument(body).toJson(QJsonDocument::Compact);
+}
+
+bool OllamaEmbeddingProvider::batchRejected(const QUrl &url) {
+    if (!url.path().endsWith("/api/embed")) {
+        return false;
+    }
+    if (m_batchSupported) {
+        LOG_WARNING("Ollama server has no /api/embed; embedding one text per /api/embeddings request");
+        m_batchSupported = false;
+    }
+    return true;
+}
+
+// OpenAIEmbeddingProvider
+
+OpenAIEmbeddingProvider::OpenAIEmbeddingProvider(QObject *parent)
+    : HttpEmbeddingProvider(parent) {
+}
+
+int OpenAIEmbeddingProvider::maxBatchSize() const {
+    return OPENAI_BATCH_SIZE;
+}
+
+int OpenAIEmbeddingProvider::textsPerRequest() const {
+    return OPENAI_BATCH_SIZE;
+}
+
+QUrl OpenAIEmbeddingProvider::endpoint(int /*textCount*/) const {
+    QString url = m_url.isEmpty() ? QString(DEFAULT_OPENAI_URL) : m_url;
+    if (url.endsWith('/')) {
+        url.chop(1);
+    }
+    if (!url.endsWith("/embeddings")) {
+        url += "/embeddings";
+    }
+    return QUrl(url);
+}
+
+QByteArray OpenAIEmbeddingProvider::requestBody(const QStringList &texts) const {
+    QJsonObject body;
+    body["model"] = m_model;
+    body["input"] = QJsonArray::fromStringList(texts);
+    body["encoding_format"] = "float";
+    return QJsonDocument(body).toJson(QJsonDocument::Compact);
+}
+
+// LocalEmbeddingProvider
+
+namespace {
+
+// Texts of one parallel call, filled in place by the slices
+struct LocalBatch {
+    QStringList texts;
+    std::vector<QVector<float>> vectors;
+    std::atomic<int> remaining;
+    std::function<void()> finished;  // Run by whichever slice ends last
+};
+
+class LocalEmbeddingTask : public QRunnable {
+public:
+    LocalEmbeddingTask(std::shared_ptr<LocalBatch> batch, int begin, int end)
+        : m_batch(std::move(batch)), m_begin(begin), m_end(end) {}
+
+    void run() override {
+        for (int i = m_begin; i < m_end; ++i) {
+            m_batch->vectors[i] = LocalEmbeddingProvider::embedText(m_batch->texts[i]);
+        }
+        if (--m_batch->remaining == 0) {
+            m_batch->finished();
+        }
+    }
+
+private:
+    std::shared_ptr<LocalBatch> m_batch;
+    int m_begin;
+    int m_end;
+};
+
+// FNV-1a over the UTF-16 code units, seeded per feature kind
+inline quint64 featureHash(const QChar *data, int size, quint64 seed) {
+    quint64 hash = 14695981039346656037ULL ^ seed;
+    for (int i = 0; i < size; ++i) {
+        hash ^= data[i].unicode();
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Signed feature hashing: the top bit picks the sign so collisions tend to cancel
+inline void addFeature(QVector<float> &vector, quint64 hash, float weight) {
+    int slot = static_cast<int>((hash >> 1) % static_cast<quint64>(vector.size()));
+    vector[slot] += (hash >> 63) ? -weight : weight;
+}
+
+} // namespace
+
+LocalEmbeddingProvider::LocalEmbeddingProvider(QObject *parent)
+    : EmbeddingProvider(parent) {
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+LocalEmbeddingProvider::~LocalEmbeddingProvider() {
+    // Slices capture this provider; let them finish before it goes
+    m_pool.waitForDone();
+}
+
+int LocalEmbeddingProvider::maxBatchSize() const {
+    return LOCAL_BATCH_SIZE;
+}
+
+int LocalEmbeddingProvider::dimensions() {
+    return LOCAL_DIMENSIONS;
+}
+
+QVector<float> LocalEmbeddingProvider::embedText(const QString &text) {
+    QVector<float> vector(LOCAL_DIMENSIONS, 0.0f);
+
+    // Lowercase letters and digits; everything else separates words
+    QString normalized = text.toLower();
+    QVector<QStringRef> words;
+    int start = -1;
+    for (int i = 0; i <= normalized.size(); ++i) {
+        bool wordChar = i < normalized.size() && normalized[i].isLetterOrNumber();
+        if (wordChar && start < 0) {
+            start = i;
+        } else if (!wordChar && start >= 0) {
+            words.append(normalized.midRef(start, i - start));
+            start = -1;
+        }
+    }
+
+    QString padded;
+    for (int w = 0; w < words.size(); ++w) {
+        const QStringRef &word = words[w];
+        addFeature(vector, featureHash(word.constData(), word.size(), 1), WORD_WEIGHT);
+
+        if (w > 0) {
+            QString pair = words[w - 1].toString() + ' ' + word.toString();
+            addFeature(vector, featureHash(pair.constData(), pair.size(), 2), PAIR_WEIGHT);
+        }
+
+        // Trigrams of " word " so prefixes and suffixes count too
+        padded = ' ' + word.toString() + ' ';
+        for (int i = 0; i + 3 <= padded.size(); ++i) {
+            addFeature(vector, featureHash(padded.constData() + i, 3, 3), TRIGRAM_WEIGHT);
+        }
+    }
+
+    double norm = 0.0;
+    for (float value : vector) {
+        norm += static_cast<double>(value) * value;
+    }
+    if (norm > 0.0) {
+        float scale = static_cast<float>(1.0 / std::sqrt(norm));
+        for (float &value : vector) {
+            value *= scale;
+        }
+    }
+    return vector;
+}
+
+int LocalEmbeddingProvider::embed(const QStringList &texts) {
+    int ticket = nextTicket();
+    m_activeTickets.insert(ticket);
+
+    // Queries and small batches: cheaper than handing work to the pool
+    if (texts.size() <= LOCAL_INLINE_TEXTS) {
+        QVector<QVector<float>> vectors;
+        vectors.reserve(texts.size());
+        for (const QString &text : texts) {
+            vectors.append(embedText(text));
+        }
+        QTimer::singleShot(0, this, [this, ticket, vectors]() {
+            deliver(ticket, vectors);
+        });
+        return ticket;
+    }
+
+    auto batch = std::make_shared<LocalBatch>();
+    batch->texts = texts;
+    batch->vectors.resize(texts.size());
+
+    int slices = qMin(m_pool.maxThreadCount(), (texts.size() + LOCAL_INLINE_TEXTS - 1) / LOCAL_INLINE_TEXTS);
+    int perSlice = (texts.size() + slices - 1) / slices;
+    slices = (texts.size() + perSlice - 1) / perSlice;
+    batch->remaining = slices;
+
+    LocalBatch *rawBatch = batch.get();
+    batch->finished = [this, ticket, rawBatch]() {
+        QVector<QVector<float>> vectors;
+        vectors.reserve(static_cast<int>(rawBatch->vectors.size()));
+        for (QVector<float> &vector : rawBatch->vectors) {
+            vectors.append(std::move(vector));
+        }
+        QMetaObject::invokeMethod(this, [this, ticket, vectors]() {
+            deliver(ticket, vectors);
+        }, Qt::QueuedConnection);
+    };
+
+    for (int begin = 0; begin < texts.size(); begin += perSlice) {
+        m_pool.start(new LocalEmbeddingTask(batch, begin, qMin(begin + perSlice, texts.size())));
+    }
+    LOG_DEBUG(QString("Embedding %1 texts locally on %2 threads").arg(texts.size()).arg(slices));
+    return ticket;
+}
+
+void LocalEmbeddingProvider::cancel(int ticket) {
+    // Work already queued still runs; its result is dropped in deliver()
+    m_activeTickets.remove(ticket);
+}
+
+void LocalEmbeddingProvider::deliver(int ticket, const QVector<QVector<float>> &vectors) {
+    if (!m_activeTickets.remove(ticket)) {
+        return;
+    }
+    emit embeddingsReady(ticket, vectors);
+}
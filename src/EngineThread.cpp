@@ -0,0 +1,75 @@
+/**
+ * EngineThread.cpp - Worker thread that owns network engines
+ *
+ * The thread runs a plain event loop; engines on it are driven by queued
+ * calls and deliver their results through queued signals.
+ */
+
+#include "EngineThread.h"
+#include "Logger.h"
+
+EngineThread::EngineThread(const QString &name, QObject *parent)
+    : QObject(parent)
+    , m_thread(new QThread())
+    , m_anchor(new QObject()) {
+    m_thread->setObjectName(name);
+    m_anchor->moveToThread(m_thread);
+    m_thread->start();
+    LOG_DEBUG(QString("Engine thread '%1' started").arg(name));
+}
+
+EngineThread::~EngineThread() {
+    stop();
+    delete m_anchor;
+    delete m_thread;
+}
+
+bool EngineThread::adopt(QObject *object) {
+    if (!object || object->parent() || !isRunning()) {
+        LOG_WARNING(QString("Engine thread '%1' cannot adopt object").arg(m_thread->objectName()));
+        return false;
+    }
+
+    object->moveToThread(m_thread);
+    m_objects.append(object);
+    return true;
+}
+
+void EngineThread::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    // Engines are deleted where they live, so pending replies and timers
+    // are torn down on the right thread
+    QList<QPointer<QObject>> objects = m_objects;
+    m_objects.clear();
+    runBlocking([objects]() {
+        for (int i = objects.size() - 1; i >= 0; --i) {
+            delete objects[i].data();
+        }
+    });
+
+    m_thread->quit();
+    m_thread->wait();
+    LOG_DEBUG(QString("Engine thread '%1' stopped").arg(m_thread->objectName()));
+}
+
+bool EngineThread::isRunning() const {
+    return m_thread->isRunning();
+}
+
+bool EngineThread::isCurrentThread() const {
+    return QThread::currentThread() == m_thread;
+}
+
+void EngineThread::runBlocking(const std::function<void()> &function) {
+    if (!isRunning()) {
+        return;
+    }
+    if (isCurrentThread()) {
+        function();
+        return;
+    }
+    QMetaObject::invokeMethod(m_anchor, function, Qt::BlockingQueuedConnection);
+}
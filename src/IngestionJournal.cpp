@@ -0,0 +1,370 @@
+/**
+ * IngestionJournal.cpp - Durable record of RAG ingestion progress
+ *
+ * Every record is a commit point (a document chunked, a batch of embeddings
+ * stored), so each is flushed and fsync'd as it is written. That is one
+ * sync per document or embedding batch, small next to the extraction or
+ * the embedding call that produced it.
+ */
+
+#include "IngestionJournal.h"
+#include "Logger.h"
+#include "version.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QMap>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool syncFile(QFile &file) {
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_UNIX
+    if (::fsync(file.handle()) != 0) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+QJsonArray toJsonArray(const QVector<int> &values) {
+    QJsonArray array;
+    for (int value : values) {
+        array.append(value);
+    }
+    return array;
+}
+
+} // namespace
+
+IngestionJournal::IngestionJournal()
+    : m_map(nullptr)
+    , m_mapSize(0) {
+}
+
+IngestionJournal::~IngestionJournal() {
+    close();
+}
+
+QString IngestionJournal::defaultPath(const QString &name) {
+    return QDir::homePath() + "/.qtbot/rag/" + name + ".jsonl";
+}
+
+bool IngestionJournal::open(const QString &path, const QJsonObject &header, IngestionJournalContents &contents,
+                            QString *error) {
+    close();
+    contents = IngestionJournalContents();
+
+    auto fail = [this, error](const QString &message) {
+        LOG_ERROR(message);
+        if (error) {
+            *error = message;
+        }
+        close();
+        return false;
+    };
+
+    QFileInfo info(path);
+    if (!info.dir().exists() && !info.dir().mkpath(".")) {
+        return fail(QString("Failed to create ingestion journal directory: %1").arg(info.dir().path()));
+    }
+
+    // A lock left by a crashed process is stale and taken over
+    m_lock.reset(new QLockFile(path + ".lock"));
+    if (!m_lock->tryLock(0)) {
+        m_lock.reset();
+        return fail(QString("Ingestion journal %1 is in use by another process").arg(path));
+    }
+
+    m_file.setFileName(path);
+    m_vectors.setFileName(path + ".vec");
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Append)
+        || !m_vectors.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        return fail(QString("Failed to open ingestion journal %1: %2")
+                    .arg(path, m_file.isOpen() ? m_vectors.errorString() : m_file.errorString()));
+    }
+    m_path = path;
+
+    if (m_file.size() == 0) {
+        m_vectors.resize(0);
+        if (!writeHeader(header)) {
+            return fail(QString("Failed to write ingestion journal %1: %2").arg(path, m_file.errorString()));
+        }
+        contents.header = header;
+        LOG_INFO(QString("Started ingestion journal: %1").arg(path));
+        return true;
+    }
+
+    if (!read(contents)) {
+        return fail(QString("Not an ingestion journal: %1").arg(path));
+    }
+
+    LOG_INFO(QString("Opened ingestion journal %1: %2 documents, %3 embedding batches, %4 unfinished directories")
+             .arg(path).arg(contents.documents.size()).arg(contents.embeddings.size())
+             .arg(contents.directories.size()));
+    return true;
+}
+
+bool IngestionJournal::read(IngestionJournalContents &contents) {
+    m_file.seek(0);
+    qint64 vectorSize = m_vectors.size();
+    qint64 committedEnd = 0;   // Journal bytes up to the last complete line
+    qint64 vectorEnd = 0;      // Vector bytes referred to by a record
+    QMap<QString, IngestedDirectory> directories;
+    QStringList directoryOrder;
+
+    while (!m_file.atEnd()) {
+        QByteArray line = m_file.readLine();
+        if (!line.endsWith('\n')) {
+            break;  // Torn by a crash mid-write
+        }
+        committedEnd += line.size();
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            contents.skippedRecords++;
+            continue;
+        }
+        QJsonObject record = doc.object();
+        QString type = record["type"].toString();
+
+        if (contents.header.isEmpty()) {
+            if (type != "ingestion") {
+                return false;
+            }
+            contents.header = record;
+        } else if (type == "document") {
+            IngestedDocument document;
+            document.path = record["path"].toString();
+            document.size = static_cast<qint64>(record["size"].toDouble());
+            document.modified = static_cast<qint64>(record["modified"].toDouble());
+            document.firstChunk = record["first_chunk"].toInt();
+            for (const QJsonValue &chunk : record["chunks"].toArray()) {
+                document.chunks.append(chunk.toString());
+            }
+            for (const QJsonValue &tokens : record["tokens"].toArray()) {
+                document.tokenCounts.append(tokens.toInt());
+            }
+            document.tokenizer = record["tokenizer"].toString();
+            contents.documents.append(document);
+        } else if (type == "embedded") {
+            IngestedEmbeddings embeddings;
+            for (const QJsonValue &chunk : record["chunks"].toArray()) {
+                embeddings.chunks.append(chunk.toInt());
+            }
+            embeddings.offset = static_cast<qint64>(record["offset"].toDouble());
+            embeddings.dimensions = record["dimensions"].toInt();
+
+            qint64 end = embeddings.offset
+                         + static_cast<qint64>(embeddings.chunks.size()) * embeddings.dimensions * sizeof(float);
+            if (embeddings.dimensions <= 0 || embeddings.offset < 0 || end > vectorSize) {
+                contents.skippedRecords++;  // Those chunks are embedded again
+                continue;
+            }
+            vectorEnd = qMax(vectorEnd, end);
+            contents.embeddings.append(embeddings);
+        } else if (type == "directory") {
+            IngestedDirectory directory;
+            directory.path = record["path"].toString();
+            for (const QJsonValue &file : record["files"].toArray()) {
+                directory.files.append(file.toString());
+            }
+            if (!directories.contains(directory.path)) {
+                directoryOrder.append(directory.path);
+            }
+            directories.insert(directory.path, directory);
+        } else if (type == "removed") {
+            QString path = record["path"].toString();
+            for (int i = contents.documents.size() - 1; i >= 0; --i) {
+                if (contents.documents[i].path == path && !contents.documents[i].removed) {
+                    contents.documents[i].removed = true;
+                    break;
+                }
+            }
+        } else if (type == "directory_done") {
+            directories.remove(record["path"].toString());
+            directoryOrder.removeAll(record["path"].toString());
+        } else {
+            contents.skippedRecords++;
+        }
+    }
+
+    if (contents.header.isEmpty()) {
+        return false;
+    }
+
+    if (committedEnd < m_file.size()) {
+        LOG_WARNING(QString("Ingestion journal %1 ends with a torn record, dropping %2 bytes")
+                    .arg(m_path).arg(m_file.size() - committedEnd));
+        m_file.resize(committedEnd);
+    }
+    if (vectorEnd < vectorSize) {
+        // Written before a crash, never committed by a record
+        LOG_WARNING(QString("Ingestion journal %1: dropping %2 bytes of uncommitted vectors")
+                    .arg(m_path).arg(vectorSize - vectorEnd));
+        m_vectors.resize(vectorEnd);
+    }
+    m_file.seek(m_file.size());
+
+    for (const QString &path : directoryOrder) {
+        contents.directories.append(directories.value(path));
+    }
+
+    if (vectorEnd > 0) {
+        m_map = m_vectors.map(0, vectorEnd);
+        if (!m_map) {
+            LOG_WARNING(QString("Cannot map %1: %2").arg(m_vectors.fileName(), m_vectors.errorString()));
+            contents.skippedRecords += contents.embeddings.size();
+            contents.embeddings.clear();
+        } else {
+            m_mapSize = vectorEnd;
+        }
+    }
+    return true;
+}
+
+void IngestionJournal::close() {
+    unmapVectors();
+    if (m_file.isOpen()) {
+        syncFile(m_file);
+        m_file.close();
+    }
+    if (m_vectors.isOpen()) {
+        m_vectors.close();
+    }
+    m_path.clear();
+    m_lock.reset();  // Unlocks
+}
+
+void IngestionJournal::unmapVectors() {
+    if (m_map) {
+        m_vectors.unmap(const_cast<uchar*>(m_map));
+    }
+    m_map = nullptr;
+    m_mapSize = 0;
+}
+
+const float *IngestionJournal::vectors(const IngestedEmbeddings &record) const {
+    qint64 bytes = static_cast<qint64>(record.chunks.size()) * record.dimensions * sizeof(float);
+    if (!m_map || record.offset < 0 || record.offset + bytes > m_mapSize) {
+        return nullptr;
+    }
+    return reinterpret_cast<const float*>(m_map + record.offset);
+}
+
+bool IngestionJournal::reset(const QJsonObject &header) {
+    if (!isOpen()) {
+        return false;
+    }
+
+    unmapVectors();
+    if (!m_file.resize(0) || !m_vectors.resize(0)) {
+        LOG_ERROR(QString("Failed to reset ingestion journal %1: %2").arg(m_path, m_file.errorString()));
+        return false;
+    }
+    LOG_INFO(QString("Ingestion journal reset: %1").arg(m_path));
+    return writeHeader(header);
+}
+
+bool IngestionJournal::writeHeader(const QJsonObject &header) {
+    QJsonObject record = header;
+    record["type"] = "ingestion";
+    record["version"] = 1;
+    record["app"] = APP_NAME;
+    record["app_version"] = APP_VERSION;
+    record["created_at"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    return appendRecord(record);
+}
+
+bool IngestionJournal::appendDirectory(const QString &path, const QStringList &files) {
+    QJsonObject record;
+    record["type"] = "directory";
+    record["path"] = path;
+    record["files"] = QJsonArray::fromStringList(files);
+    return appendRecord(record);
+}
+
+bool IngestionJournal::finishDirectory(const QString &path) {
+    QJsonObject record;
+    record["type"] = "directory_done";
+    record["path"] = path;
+    return appendRecord(record);
+}
+
+bool IngestionJournal::appendDocument(const IngestedDocument &document) {
+    QJsonObject record;
+    record["type"] = "document";
+    record["path"] = document.path;
+    record["size"] = document.size;
+    record["modified"] = document.modified;
+    record["first_chunk"] = document.firstChunk;
+    record["chunks"] = QJsonArray::fromStringList(document.chunks);
+    if (!document.tokenCounts.isEmpty()) {
+        record["tokenizer"] = document.tokenizer;
+        record["tokens"] = toJsonArray(document.tokenCounts);
+    }
+    return appendRecord(record);
+}
+
+bool IngestionJournal::appendRemoval(const QString &path) {
+    QJsonObject record;
+    record["type"] = "removed";
+    record["path"] = path;
+    return appendRecord(record);
+}
+
+bool IngestionJournal::appendEmbeddings(const QVector<int> &chunks, const QVector<QVector<float>> &vectors) {
+    if (!isOpen() || chunks.isEmpty() || chunks.size() != vectors.size()) {
+        return false;
+    }
+
+    int dimensions = vectors.first().size();
+    qint64 offset = m_vectors.size();
+    for (const QVector<float> &vector : vectors) {
+        qint64 bytes = static_cast<qint64>(vector.size()) * sizeof(float);
+        if (vector.size() != dimensions
+            || m_vectors.write(reinterpret_cast<const char*>(vector.constData()), bytes) != bytes) {
+            LOG_ERROR(QString("Failed to write ingestion vectors %1: %2").arg(m_vectors.fileName(), m_vectors.errorString()));
+            m_vectors.resize(offset);
+            return false;
+        }
+    }
+
+    // The vectors must be durable before a record refers to them
+    if (!syncFile(m_vectors)) {
+        LOG_ERROR(QString("Failed to sync ingestion vectors: %1").arg(m_vectors.fileName()));
+        m_vectors.resize(offset);
+        return false;
+    }
+
+    QJsonObject record;
+    record["type"] = "embedded";
+    record["chunks"] = toJsonArray(chunks);
+    record["offset"] = offset;
+    record["dimensions"] = dimensions;
+    return appendRecord(record);
+}
+
+bool IngestionJournal::appendRecord(const QJsonObject &record) {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    if (m_file.write(line) != line.size() || !syncFile(m_file)) {
+        LOG_ERROR(QString("Failed to write ingestion journal %1: %2").arg(m_path, m_file.errorString()));
+        return false;
+    }
+    return true;
+}
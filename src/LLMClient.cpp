@@ -8,6 +8,8 @@
 #include "LLMClient.h"
 #include "Config.h"
 #include "Logger.h"
+#include "StreamTrace.h"
+#include "ModelRouter.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -18,6 +20,8 @@
 LLMClient::LLMClient(QObject *parent)
     : QObject(parent)
     , m_networkManager(nullptr)
+    , m_routedToolTurn(false)
+    , m_routedUserMessage(false)
     , m_currentReply(nullptr)
     , m_maxRetries(3)
     , m_retryDelay(1000)
@@ -25,22 +29,31 @@ LLMClient::LLMClient(QObject *parent)
     , m_toolsEnabled(false)
     , m_nativeToolCallEmitted(false)
     , m_toolCallFormat("unknown")
-    , m_capabilitiesDetected(false) {
+    , m_capabilitiesDetected(false)
+    , m_historyMemory("history") {
 
     // Load settings from Config
-    m_apiUrl = Config::instance().getApiUrl();
-    m_model = Config::instance().getModel();
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    m_apiUrl = cfg->apiUrl;
+    m_model = cfg->model;
+    m_requestModel = m_model;
 
     // Defer network manager creation until event loop is running
     QTimer::singleShot(0, this, [this]() {
-        m_networkManager = new QNetworkAccessManager(this);
+        // Plain manager unless --record-stream/--replay-stream is active
+        m_networkManager = StreamTrace::instance().createNetworkManager(this);
         // Connect network manager signals
         connect(m_networkManager, &QNetworkAccessManager::finished,
                 this, &LLMClient::handleNetworkReply);
         LOG_DEBUG("LLMClient: QNetworkAccessManager initialized");
 
-        // Query model capabilities after initialization
-        queryModelCapabilities();
+        // Query model capabilities after initialization (unless seeded by the owner)
+        if (!m_capabilitiesDetected) {
+            queryModelCapabilities();
+        }
+
+        // Formats of routed models are shared, so only the first client asks
+        queryRoutedModelCapabilities();
     });
 
     LOG_INFO(QString("LLMClient initialized with model: %1, API: %2 (max retries: %3)")
@@ -59,6 +72,7 @@ void LLMClient::setApiUrl(const QString &url) {
 
 void LLMClient::setModel(const QString &model) {
     m_model = model;
+    m_requestModel = model;
     LOG_DEBUG(QString("Model set to: %1").arg(model));
 }
 
@@ -94,6 +108,9 @@ void LLMClient::sendPrompt(const QString &prompt, const QString &context) {
     m_currentRetryCount = 0;
     m_toolsEnabled = false;
     m_currentTools = QJsonArray();
+    m_requestModel = m_model;
+    m_requestFormat = m_toolCallFormat;
+    m_routedToolTurn = false;
 
     QString jsonRequest = buildOllamaRequest(fullPrompt, context);
     sendRequest(jsonRequest);
@@ -134,25 +151,49 @@ void LLMClient::sendPromptWithTools(const QString &prompt, const QJsonArray &too
     m_currentTools = tools;
     m_currentPrompt = fullPrompt;
 
+    // Deciding on a tool can run on a faster model; if it calls none, the
+    // main model answers (see handleStreamingFinished)
+    m_requestModel = m_model;
+    m_requestFormat = m_toolCallFormat;
+    m_routedToolTurn = false;
+    m_routedUserMessage = false;
+    QString toolModel = ModelRouter::modelFor(ModelRole::ToolSelection, *Config::instance().snapshot(), m_model);
+    if (toolModel != m_model && !tools.isEmpty()) {
+        QString toolModelFormat = ModelRouter::instance().toolCallFormat(m_apiUrl, toolModel);
+        if (toolModelFormat.isEmpty()) {
+            LOG_INFO(QString("Tool calling format of %1 not known yet, using %2 for this turn").arg(toolModel, m_model));
+            requestModelInfo(toolModel);
+        } else {
+            LOG_INFO(QString("Routing tool selection to %1 (%2 tool calling)").arg(toolModel, toolModelFormat));
+            m_requestModel = toolModel;
+            m_requestFormat = toolModelFormat;
+            m_routedToolTurn = true;
+        }
+    }
+
     // Do NOT clear message history - we need to maintain conversation context
     // m_messageHistory = QJsonArray();
 
     // Choose request format based on detected model capabilities
     QString jsonRequest;
-    if (m_toolCallFormat == "native") {
+    if (m_requestFormat == "native") {
         LOG_INFO("Using NATIVE tool calling format (/api/chat)");
         jsonRequest = buildNativeToolRequest(fullPrompt, tools, context);
+    } else {
+        LOG_INFO("Using PROMPT-BASED tool calling format (/api/generate)");
+        jsonRequest = buildOllamaRequestWithTools(fullPrompt, tools, context);
+    }
 
-        // Save the user message to history AFTER building the request
-        // so it's available for tool result processing
+    // Save the user message to history AFTER building the request so it's available
+    // for tool result processing; the main model needs it even when a prompt-based
+    // model chose the tool
+    if (m_requestFormat == "native" || m_toolCallFormat == "native") {
         QJsonObject userMsg;
         userMsg["role"] = "user";
         userMsg["content"] = fullPrompt;
         m_messageHistory.append(userMsg);
+        m_routedUserMessage = m_routedToolTurn;
         LOG_DEBUG("Saved user message to message history for conversation continuity");
-    } else {
-        LOG_INFO("Using PROMPT-BASED tool calling format (/api/generate)");
-        jsonRequest = buildOllamaRequestWithTools(fullPrompt, tools, context);
     }
 
     sendRequest(jsonRequest);
@@ -179,11 +220,14 @@ void LLMClient::sendToolResults(const QString &originalPrompt, const QJsonArray
     if (hasComplexTools && m_toolCallFormat == "native") {
         LOG_INFO("Complex tool results detected, sending back to LLM for processing");
 
+        // Read all settings for this request from one consistent snapshot
+        std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+
         // Build message array with tool results for native format
         QJsonArray messages;
 
         // Add system message if configured (must be first)
-        QString systemPrompt = Config::instance().getSystemPrompt();
+        QString systemPrompt = cfg->systemPrompt;
         if (!systemPrompt.isEmpty()) {
             QJsonObject systemMsg;
             systemMsg["role"] = "system";
@@ -205,10 +249,11 @@ void LLMClient::sendToolResults(const QString &originalPrompt, const QJsonArray
 
         // Add pruned message history (context-aware)
         // Note: m_messageHistory should already contain the user message and assistant's tool call
-        QJsonArray prunedHistory = pruneMessageHistoryForContext(systemPrompt, toolResultContent);
+        QJsonArray prunedHistory = pruneMessageHistoryForContext(systemPrompt, toolResultContent, cfg->contextWindowSize);
         for (const QJsonValue &msg : prunedHistory) {
             messages.append(msg);
         }
+        accountHistory();
 
         // Add tool result as user message (Ollama may not support "tool" role)
         QJsonObject toolResultMsg;
@@ -226,26 +271,8 @@ void LLMClient::sendToolResults(const QString &originalPrompt, const QJsonArray
         json["stream"] = true;
         json["messages"] = messages;
 
-        // Add options
-        QJsonObject options;
-        if (Config::instance().getOverrideTemperature()) {
-            options["temperature"] = Config::instance().getTemperature();
-        }
-        if (Config::instance().getOverrideTopP()) {
-            options["top_p"] = Config::instance().getTopP();
-        }
-        if (Config::instance().getOverrideTopK()) {
-            options["top_k"] = Config::instance().getTopK();
-        }
-        if (Config::instance().getOverrideContextWindowSize()) {
-            options["num_ctx"] = Config::instance().getContextWindowSize();
-        }
-        if (!options.isEmpty()) {
-            json["options"] = options;
-        }
-        if (Config::instance().getOverrideMaxTokens()) {
-            json["num_predict"] = Config::instance().getMaxTokens();
-        }
+        // Add LLM configuration parameters (only those with override enabled)
+        applyGenerationOptions(json, *cfg);
 
         QString jsonRequest = QString::fromUtf8(QJsonDocument(json).toJson(QJsonDocument::Compact));
         LOG_DEBUG("Sending tool results back to LLM for natural language response");
@@ -276,6 +303,8 @@ void LLMClient::sendToolResults(const QString &originalPrompt, const QJsonArray
         m_streamBuffer.clear();
         m_fullResponse.clear();
         m_nativeToolCallEmitted = false;
+        m_requestModel = m_model;
+        m_requestFormat = m_toolCallFormat;
 
         m_currentReply = m_networkManager->post(request, jsonRequest.toUtf8());
 
@@ -351,53 +380,60 @@ void LLMClient::sendToolResults(const QString &originalPrompt, const QJsonArray
     emit responseReceived(naturalResponse);
 }
 
+void LLMClient::applyGenerationOptions(QJsonObject &json, const ConfigSnapshot &cfg) {
+    QJsonObject options;
+    if (cfg.overrideTemperature) {
+        options["temperature"] = cfg.temperature;
+    }
+    if (cfg.overrideTopP) {
+        options["top_p"] = cfg.topP;
+    }
+    if (cfg.overrideTopK) {
+        options["top_k"] = cfg.topK;
+    }
+    if (cfg.overrideContextWindowSize) {
+        options["num_ctx"] = cfg.contextWindowSize;
+    }
+
+    if (!options.isEmpty()) {
+        json["options"] = options;
+    }
+
+    // Set max tokens (num_predict in Ollama) only if override is enabled
+    if (cfg.overrideMaxTokens) {
+        json["num_predict"] = cfg.maxTokens;
+    }
+}
+
 QString LLMClient::buildOllamaRequest(const QString &prompt, const QString &context) {
     Q_UNUSED(context);
 
+    // Read all settings for this request from one consistent snapshot
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+
     QJsonObject json;
-    json["model"] = m_model;
+    json["model"] = m_requestModel;
     json["prompt"] = prompt;
     json["stream"] = true; // Enable streaming for real-time token display
 
     // Add system prompt from Config
-    QString systemPrompt = Config::instance().getSystemPrompt();
+    QString systemPrompt = cfg->systemPrompt;
     if (!systemPrompt.isEmpty()) {
         json["system"] = systemPrompt;
         LOG_DEBUG(QString("Including system prompt (length: %1 chars)").arg(systemPrompt.length()));
     }
 
-    // Add LLM configuration parameters from Config (only if override is enabled)
-    QJsonObject options;
-    if (Config::instance().getOverrideTemperature()) {
-        options["temperature"] = Config::instance().getTemperature();
-    }
-    if (Config::instance().getOverrideTopP()) {
-        options["top_p"] = Config::instance().getTopP();
-    }
-    if (Config::instance().getOverrideTopK()) {
-        options["top_k"] = Config::instance().getTopK();
-    }
-    if (Config::instance().getOverrideContextWindowSize()) {
-        options["num_ctx"] = Config::instance().getContextWindowSize();
-    }
-
-    if (!options.isEmpty()) {
-        json["options"] = options;
-    }
-
-    // Set max tokens (num_predict in Ollama) only if override is enabled
-    if (Config::instance().getOverrideMaxTokens()) {
-        json["num_predict"] = Config::instance().getMaxTokens();
-    }
+    // Add LLM configuration parameters (only those with override enabled)
+    applyGenerationOptions(json, *cfg);
 
     QJsonDocument doc(json);
     QString jsonString = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
     LOG_DEBUG(QString("Request options - Temp: %1, TopP: %2, TopK: %3, CtxSize: %4, MaxTokens: %5")
-              .arg(Config::instance().getTemperature())
-              .arg(Config::instance().getTopP())
-              .arg(Config::instance().getTopK())
-              .arg(Config::instance().getContextWindowSize())
-              .arg(Config::instance().getMaxTokens()));
+              .arg(cfg->temperature)
+              .arg(cfg->topP)
+              .arg(cfg->topK)
+              .arg(cfg->contextWindowSize)
+              .arg(cfg->maxTokens));
 
     return jsonString;
 }
@@ -405,8 +441,11 @@ QString LLMClient::buildOllamaRequest(const QString &prompt, const QString &cont
 QString LLMClient::buildOllamaRequestWithTools(const QString &prompt, const QJsonArray &tools, const QString &context) {
     Q_UNUSED(context);
 
+    // Read all settings for this request from one consistent snapshot
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+
     // Build enhanced system prompt with tool instructions
-    QString baseSystemPrompt = Config::instance().getSystemPrompt();
+    QString baseSystemPrompt = cfg->systemPrompt;
     QString toolInstructions = "\n\nAVAILABLE TOOLS:\n";
     toolInstructions += "You have access to the following tools to help answer questions:\n\n";
 
@@ -430,33 +469,13 @@ QString LLMClient::buildOllamaRequestWithTools(const QString &prompt, const QJso
     QString enhancedSystemPrompt = baseSystemPrompt + toolInstructions;
 
     QJsonObject json;
-    json["model"] = m_model;
+    json["model"] = m_requestModel;
     json["prompt"] = prompt;
     json["system"] = enhancedSystemPrompt;
     json["stream"] = true;
 
-    // Add LLM configuration parameters from Config (only if override is enabled)
-    QJsonObject options;
-    if (Config::instance().getOverrideTemperature()) {
-        options["temperature"] = Config::instance().getTemperature();
-    }
-    if (Config::instance().getOverrideTopP()) {
-        options["top_p"] = Config::instance().getTopP();
-    }
-    if (Config::instance().getOverrideTopK()) {
-        options["top_k"] = Config::instance().getTopK();
-    }
-    if (Config::instance().getOverrideContextWindowSize()) {
-        options["num_ctx"] = Config::instance().getContextWindowSize();
-    }
-
-    if (!options.isEmpty()) {
-        json["options"] = options;
-    }
-
-    if (Config::instance().getOverrideMaxTokens()) {
-        json["num_predict"] = Config::instance().getMaxTokens();
-    }
+    // Add LLM configuration parameters (only those with override enabled)
+    applyGenerationOptions(json, *cfg);
 
     QJsonDocument doc(json);
     QString jsonString = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
@@ -469,15 +488,18 @@ QString LLMClient::buildOllamaRequestWithTools(const QString &prompt, const QJso
 QString LLMClient::buildNativeToolRequest(const QString &prompt, const QJsonArray &tools, const QString &context) {
     Q_UNUSED(context);
 
+    // Read all settings for this request from one consistent snapshot
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+
     QJsonObject json;
-    json["model"] = m_model;
+    json["model"] = m_requestModel;
     json["stream"] = true;
 
     // Build messages array (chat format)
     QJsonArray messages;
 
     // Add system message if configured
-    QString systemPrompt = Config::instance().getSystemPrompt();
+    QString systemPrompt = cfg->systemPrompt;
     if (!systemPrompt.isEmpty()) {
         QJsonObject systemMsg;
         systemMsg["role"] = "system";
@@ -487,10 +509,11 @@ QString LLMClient::buildNativeToolRequest(const QString &prompt, const QJsonArra
     }
 
     // Add pruned message history (context-aware)
-    QJsonArray prunedHistory = pruneMessageHistoryForContext(systemPrompt, prompt);
+    QJsonArray prunedHistory = pruneMessageHistoryForContext(systemPrompt, prompt, cfg->contextWindowSize);
     for (const QJsonValue &msg : prunedHistory) {
         messages.append(msg);
     }
+    accountHistory();
 
     // Add current user message
     QJsonObject userMsg;
@@ -576,28 +599,8 @@ QString LLMClient::buildNativeToolRequest(const QString &prompt, const QJsonArra
         LOG_DEBUG(QString("Including %1 tools in OpenAI-compatible format").arg(nativeTools.size()));
     }
 
-    // Add LLM configuration parameters from Config (only if override is enabled)
-    QJsonObject options;
-    if (Config::instance().getOverrideTemperature()) {
-        options["temperature"] = Config::instance().getTemperature();
-    }
-    if (Config::instance().getOverrideTopP()) {
-        options["top_p"] = Config::instance().getTopP();
-    }
-    if (Config::instance().getOverrideTopK()) {
-        options["top_k"] = Config::instance().getTopK();
-    }
-    if (Config::instance().getOverrideContextWindowSize()) {
-        options["num_ctx"] = Config::instance().getContextWindowSize();
-    }
-
-    if (!options.isEmpty()) {
-        json["options"] = options;
-    }
-
-    if (Config::instance().getOverrideMaxTokens()) {
-        json["num_predict"] = Config::instance().getMaxTokens();
-    }
+    // Add LLM configuration parameters (only those with override enabled)
+    applyGenerationOptions(json, *cfg);
 
     QJsonDocument doc(json);
     QString jsonString = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
@@ -619,7 +622,7 @@ void LLMClient::sendRequest(const QString &jsonData) {
 
     // Determine the endpoint based on tool format
     QString apiUrl = m_apiUrl;
-    if (m_toolsEnabled && m_toolCallFormat == "native") {
+    if (m_toolsEnabled && m_requestFormat == "native") {
         // For native tool calling, use /api/chat endpoint
         QUrl baseUrl(m_apiUrl);
         QString base = QString("%1://%2").arg(baseUrl.scheme(), baseUrl.host());
@@ -841,7 +844,10 @@ void LLMClient::processStreamingChunk(const QString &line) {
             QString token = message["content"].toString();
             if (!token.isEmpty()) {
                 m_fullResponse.append(token);
-                emit tokenReceived(token);
+                // Text from a routed tool turn is never shown: the main model answers instead
+                if (!m_routedToolTurn) {
+                    emit tokenReceived(token);
+                }
                 LOG_DEBUG(QString("Native message token: %1").arg(token));
             }
         }
@@ -851,7 +857,9 @@ void LLMClient::processStreamingChunk(const QString &line) {
         QString token = obj["response"].toString();
         if (!token.isEmpty()) {
             m_fullResponse.append(token);
-            emit tokenReceived(token);
+            if (!m_routedToolTurn) {
+                emit tokenReceived(token);
+            }
             LOG_DEBUG(QString("Token received: %1").arg(token));
         } else {
             // Empty response token - might be the start or end marker
@@ -877,6 +885,10 @@ void LLMClient::processStreamingChunk(const QString &line) {
         if (obj.contains("eval_count")) {
             LOG_DEBUG(QString("Response tokens: %1").arg(obj["eval_count"].toInt()));
         }
+
+        // -1 when the backend didn't report a count
+        emit generationStats(obj["prompt_eval_count"].toInt(-1), obj["eval_count"].toInt(-1),
+                             static_cast<qint64>(obj["total_duration"].toDouble() / 1000000.0));
     }
 }
 
@@ -922,6 +934,9 @@ void LLMClient::handleStreamingFinished() {
         processStreamingChunk(m_streamBuffer.trimmed());
     }
 
+    // A routed tool turn that called no tool is answered again by the main model
+    bool answerWithMainModel = false;
+
     // Emit the complete response
     if (!m_fullResponse.isEmpty() || m_nativeToolCallEmitted) {
         LOG_INFO(QString("Streaming finished. Full response: %1 chars").arg(m_fullResponse.length()));
@@ -931,18 +946,21 @@ void LLMClient::handleStreamingFinished() {
         // Skip prompt-based tool call processing if native tool calls were already emitted
         if (m_nativeToolCallEmitted) {
             LOG_DEBUG("Native tool call already handled, skipping prompt-based processing");
+            emit toolTurnFinished();
         } else {
             // Check for tool calls before emitting response (prompt-based format only)
             bool toolCallDetected = processToolCalls(m_fullResponse);
 
             // Only emit the raw response if no tool call was detected
             // (tool calls emit their own formatted responses)
-            if (!toolCallDetected) {
+            if (!toolCallDetected && m_routedToolTurn) {
+                answerWithMainModel = true;
+            } else if (!toolCallDetected) {
                 LOG_DEBUG("No tool call detected, emitting raw response");
 
                 // Save assistant response to message history for conversation continuity
                 // (only for native format, which maintains history)
-                if (m_toolCallFormat == "native" && !m_fullResponse.isEmpty()) {
+                if (m_requestFormat == "native" && !m_fullResponse.isEmpty()) {
                     QJsonObject assistantMsg;
                     assistantMsg["role"] = "assistant";
                     assistantMsg["content"] = m_fullResponse;
@@ -953,8 +971,20 @@ void LLMClient::handleStreamingFinished() {
                 emit responseReceived(m_fullResponse);
             } else {
                 LOG_DEBUG("Tool call detected and handled, not emitting raw response");
+
+                // A prompt-based tool model answered for a native main model: keep its call in
+                // history, as processNativeToolCalls() does, so the results follow it
+                if (m_toolCallFormat == "native" && m_requestFormat != "native") {
+                    QJsonObject assistantMsg;
+                    assistantMsg["role"] = "assistant";
+                    assistantMsg["content"] = m_fullResponse;
+                    m_messageHistory.append(assistantMsg);
+                }
+                emit toolTurnFinished();
             }
         }
+    } else if (m_routedToolTurn) {
+        answerWithMainModel = true;
     } else {
         LOG_WARNING("Streaming finished but no response received");
         emit errorOccurred("No response received from LLM");
@@ -962,6 +992,45 @@ void LLMClient::handleStreamingFinished() {
 
     m_currentReply->deleteLater();
     m_currentReply = nullptr;
+    m_routedToolTurn = false;
+
+    if (answerWithMainModel) {
+        sendAnswerTurn();
+    }
+}
+
+void LLMClient::sendAnswerTurn() {
+    // The tool model decided no tool is needed; trust that and let the main
+    // model answer without tool definitions
+    LOG_INFO(QString("%1 called no tool, answering with %2").arg(m_requestModel, m_model));
+
+    // The routed turn's user message is added again with the answer request
+    if (m_routedUserMessage && !m_messageHistory.isEmpty()) {
+        m_messageHistory.removeAt(m_messageHistory.size() - 1);
+    }
+    m_routedUserMessage = false;
+
+    m_currentRetryCount = 0;
+    m_currentTools = QJsonArray();
+    m_requestModel = m_model;
+    m_requestFormat = m_toolCallFormat;
+
+    QString jsonRequest;
+    if (m_requestFormat == "native") {
+        // Stay on /api/chat so the conversation history is kept
+        m_toolsEnabled = true;
+        jsonRequest = buildNativeToolRequest(m_currentPrompt, QJsonArray(), QString());
+
+        QJsonObject userMsg;
+        userMsg["role"] = "user";
+        userMsg["content"] = m_currentPrompt;
+        m_messageHistory.append(userMsg);
+    } else {
+        m_toolsEnabled = false;
+        jsonRequest = buildOllamaRequest(m_currentPrompt, QString());
+    }
+
+    sendRequest(jsonRequest);
 }
 
 bool LLMClient::shouldRetry(QNetworkReply::NetworkError error) {
@@ -1195,6 +1264,16 @@ void LLMClient::retryRequest() {
 }
 
 void LLMClient::queryModelCapabilities() {
+    requestModelInfo(m_model);
+}
+
+void LLMClient::queryRoutedModelCapabilities() {
+    for (const QString &model : ModelRouter::routedModels(*Config::instance().snapshot(), m_model)) {
+        requestModelInfo(model);
+    }
+}
+
+void LLMClient::requestModelInfo(const QString &model) {
     if (!m_networkManager) {
         LOG_WARNING("Cannot query model capabilities: network manager not initialized");
         return;
@@ -1214,11 +1293,11 @@ void LLMClient::queryModelCapabilities() {
     }
     QString showUrl = baseUrl + "/api/show";
 
-    LOG_INFO(QString("Querying model capabilities from: %1 for model: %2").arg(showUrl, m_model));
+    LOG_INFO(QString("Querying model capabilities from: %1 for model: %2").arg(showUrl, model));
 
     // Build request body
     QJsonObject requestBody;
-    requestBody["name"] = m_model;
+    requestBody["name"] = model;
 
     QJsonDocument doc(requestBody);
     QString jsonData = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
@@ -1228,8 +1307,14 @@ void LLMClient::queryModelCapabilities() {
     QNetworkRequest request(requestUrl);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
+    // Routed models: one query per backend and model across all clients
+    if (model != m_model && !ModelRouter::instance().beginCapabilityQuery(m_apiUrl, model)) {
+        return;
+    }
+
     // Send POST request
     QNetworkReply *reply = m_networkManager->post(request, jsonData.toUtf8());
+    reply->setProperty("routedModel", model != m_model ? model : QString());
 
     // Connect to dedicated handler (not the general handler)
     connect(reply, &QNetworkReply::finished, this, &LLMClient::handleModelInfoReply);
@@ -1246,6 +1331,21 @@ void LLMClient::handleModelInfoReply() {
 
     reply->deleteLater();
 
+    // A routed model's format only goes to the shared cache
+    QString routedModel = reply->property("routedModel").toString();
+    if (!routedModel.isEmpty()) {
+        ModelRouter::instance().endCapabilityQuery(m_apiUrl, routedModel);
+        QJsonObject info = QJsonDocument::fromJson(reply->readAll()).object();
+        if (reply->error() != QNetworkReply::NoError || info.isEmpty()) {
+            LOG_WARNING(QString("Failed to query capabilities of %1; tool selection stays on %2").arg(routedModel, m_model));
+            return;
+        }
+        QString format = detectToolCallFormat(info);
+        ModelRouter::instance().setToolCallFormat(m_apiUrl, routedModel, format);
+        LOG_INFO(QString("Routed model %1 uses %2 tool calling").arg(routedModel, format));
+        return;
+    }
+
     if (reply->error() != QNetworkReply::NoError) {
         LOG_WARNING(QString("Failed to query model capabilities: %1").arg(reply->errorString()));
         m_toolCallFormat = "unknown";
@@ -1290,33 +1390,13 @@ void LLMClient::handleModelInfoReply() {
         LOG_DEBUG(QString("Template: %1").arg(template_str.left(200))); // First 200 chars
     }
 
-    // Detect tool calling format
-    // Check for native tool calling support indicators
-    QString modelfile = m_modelInfo.value("modelfile").toString().toLower();
-    QString template_str = m_modelInfo.value("template").toString().toLower();
-    QString details = QString::fromUtf8(QJsonDocument(m_modelInfo.value("details").toObject()).toJson());
-
-    // Look for indicators of native tool calling support
-    bool hasToolSupport = false;
-
-    // Check for "tools" or "function" keywords in modelfile or template
-    if (modelfile.contains("tool") || modelfile.contains("function_call") ||
-        template_str.contains("tool") || template_str.contains("function")) {
-        hasToolSupport = true;
-    }
-
-    // Check model details for tool-related capabilities
-    if (details.contains("tool") || details.contains("function")) {
-        hasToolSupport = true;
-    }
-
-    if (hasToolSupport) {
-        m_toolCallFormat = "native";
+    m_toolCallFormat = detectToolCallFormat(m_modelInfo);
+    if (m_toolCallFormat == "native") {
         LOG_INFO("Model supports NATIVE tool calling format");
     } else {
-        m_toolCallFormat = "prompt";
         LOG_INFO("Model uses PROMPT-BASED tool calling format (system prompt injection)");
     }
+    ModelRouter::instance().setToolCallFormat(m_apiUrl, m_model, m_toolCallFormat);
 
     // Mark capabilities as detected
     m_capabilitiesDetected = true;
@@ -1331,6 +1411,29 @@ void LLMClient::handleModelInfoReply() {
     processPendingRequests();
 }
 
+QString LLMClient::detectToolCallFormat(const QJsonObject &modelInfo) {
+    // Check for native tool calling support indicators
+    QString modelfile = modelInfo.value("modelfile").toString().toLower();
+    QString template_str = modelInfo.value("template").toString().toLower();
+    QString details = QString::fromUtf8(QJsonDocument(modelInfo.value("details").toObject()).toJson());
+
+    // Look for indicators of native tool calling support
+    bool hasToolSupport = false;
+
+    // Check for "tools" or "function" keywords in modelfile or template
+    if (modelfile.contains("tool") || modelfile.contains("function_call") ||
+        template_str.contains("tool") || template_str.contains("function")) {
+        hasToolSupport = true;
+    }
+
+    // Check model details for tool-related capabilities
+    if (details.contains("tool") || details.contains("function")) {
+        hasToolSupport = true;
+    }
+
+    return hasToolSupport ? "native" : "prompt";
+}
+
 void LLMClient::processPendingRequests() {
     if (m_pendingRequests.isEmpty()) {
         LOG_DEBUG("No pending requests to process");
@@ -1360,9 +1463,35 @@ void LLMClient::processPendingRequests() {
 // Conversation history management
 void LLMClient::clearConversationHistory() {
     m_messageHistory = QJsonArray();
+    accountHistory();
     LOG_INFO("Conversation history cleared");
 }
 
+void LLMClient::setConversationHistory(const QJsonArray &messages) {
+    m_messageHistory = messages;
+    accountHistory();
+    LOG_DEBUG(QString("Conversation history set (%1 messages)").arg(messages.size()));
+}
+
+void LLMClient::accountHistory() {
+    // Message text dominates; JSON structure is a small constant per message
+    qint64 bytes = 0;
+    for (const QJsonValue &msg : m_messageHistory) {
+        bytes += msg.toObject()["content"].toString().size() * static_cast<qint64>(sizeof(QChar)) + 64;
+    }
+    m_historyMemory.set(bytes);
+}
+
+void LLMClient::setModelCapabilities(const QString &toolCallFormat, const QJsonObject &modelInfo) {
+    m_toolCallFormat = toolCallFormat;
+    m_modelInfo = modelInfo;
+    m_capabilitiesDetected = true;
+    LOG_DEBUG(QString("Model capabilities seeded: %1 tool calling").arg(toolCallFormat));
+    ModelRouter::instance().setToolCallFormat(m_apiUrl, m_model, toolCallFormat);
+
+    processPendingRequests();
+}
+
 // Context window management implementation
 int LLMClient::estimateTokens(const QString &text) const {
     if (text.isEmpty()) {
@@ -1383,12 +1512,10 @@ int LLMClient::estimateTokens(const QString &text) const {
     return (charCount / 4) + (spaceCount / 10);
 }
 
-QJsonArray LLMClient::pruneMessageHistoryForContext(const QString &systemPrompt, const QString &currentUserMessage) const {
+QJsonArray LLMClient::pruneMessageHistoryForContext(const QString &systemPrompt, const QString &currentUserMessage,
+                                                     int contextWindowSize) const {
     QJsonArray prunedMessages;
 
-    // Get context window size from config
-    int contextWindowSize = Config::instance().getContextWindowSize();
-
     // Reserve 20% for model response, use 80% for input
     int maxInputTokens = static_cast<int>(contextWindowSize * 0.8);
 
@@ -0,0 +1,777 @@
+/**
+ * LocalApiServer.cpp - OpenAI-compatible local HTTP API for daemon mode
+ *
+ * Minimal HTTP/1.1 server on QTcpServer. Chat completions run in per-request
+ * sessions that share the warm MCPHandler, RAGEngine, and capability cache.
+ */
+
+#include "LocalApiServer.h"
+#include "LLMClient.h"
+#include "MCPHandler.h"
+#include "RAGEngine.h"
+#include "Logger.h"
+#include "version.h"
+#include "BuiltinTools.h"
+#include "MemoryGovernor.h"
+#include "IngestionJournal.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUuid>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonValue>
+
+// Request limits (local clients only, but guard against runaway input)
+static const int MAX_HEADER_BYTES = 64 * 1024;
+static const int MAX_BODY_BYTES = 8 * 1024 * 1024;
+
+static QByteArray statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        default: return "Internal Server Error";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ChatCompletionSession
+// ---------------------------------------------------------------------------
+
+ChatCompletionSession::ChatCompletionSession(LocalApiServer *server, QTcpSocket *socket,
+                                             const QJsonObject &request, QObject *parent)
+    : QObject(parent)
+    , m_server(server)
+    , m_socket(socket)
+    , m_llmClient(nullptr)
+    , m_stream(request["stream"].toBool(false))
+    , m_useTools(request["tool_choice"].toString() != "none")
+    , m_headersSent(false)
+    , m_finished(false)
+    , m_ragRequestId(0)
+    , m_created(QDateTime::currentSecsSinceEpoch()) {
+
+    m_completionId = "chatcmpl-" + QUuid::createUuid().toString(QUuid::WithoutBraces).remove('-');
+
+    // Last message is the prompt, everything before it is history
+    QJsonArray messages = request["messages"].toArray();
+    for (int i = 0; i < messages.size(); ++i) {
+        QJsonObject msg = messages[i].toObject();
+        if (i == messages.size() - 1) {
+            m_userPrompt = msg["content"].toString();
+        } else {
+            QJsonObject historyMsg;
+            historyMsg["role"] = msg["role"].toString();
+            historyMsg["content"] = msg["content"].toString();
+            m_history.append(historyMsg);
+        }
+    }
+
+    m_llmClient = new LLMClient(this);
+    if (request.contains("model") && !request["model"].toString().isEmpty()) {
+        m_llmClient->setModel(request["model"].toString());
+    }
+    m_model = m_llmClient->getModel();
+
+    // Reuse capabilities detected by the daemon instead of querying /api/show again
+    QString toolCallFormat;
+    QJsonObject modelInfo;
+    if (m_server->cachedCapabilities(m_model, toolCallFormat, modelInfo)) {
+        m_llmClient->setModelCapabilities(toolCallFormat, modelInfo);
+    } else {
+        connect(m_llmClient, &LLMClient::modelCapabilitiesDetected, this,
+                [this](const QString &format, const QJsonObject &info) {
+            m_server->cacheCapabilities(m_model, format, info);
+        });
+    }
+    m_llmClient->setConversationHistory(m_history);
+
+    connect(m_llmClient, &LLMClient::tokenReceived, this, &ChatCompletionSession::handleToken);
+    connect(m_llmClient, &LLMClient::responseReceived, this, &ChatCompletionSession::handleResponse);
+    connect(m_llmClient, &LLMClient::errorOccurred, this, &ChatCompletionSession::handleError);
+    connect(m_llmClient, &LLMClient::toolCallRequested, this, &ChatCompletionSession::handleToolCallRequest);
+
+    if (m_socket) {
+        connect(m_socket, &QTcpSocket::disconnected, this, &ChatCompletionSession::handleSocketDisconnected);
+    }
+}
+
+ChatCompletionSession::~ChatCompletionSession() {
+    LOG_DEBUG(QString("Chat session %1 destroyed").arg(m_completionId));
+}
+
+void ChatCompletionSession::start() {
+    LOG_INFO(QString("Chat session %1: model %2, %3 history messages, stream=%4")
+             .arg(m_completionId, m_model).arg(m_history.size()).arg(m_stream));
+
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    RAGEngine *ragEngine = m_server->ragEngine();
+    if (cfg->ragEnabled && ragEngine && ragEngine->getChunkCount() > 0) {
+        connect(ragEngine, &RAGEngine::contextReady, this, &ChatCompletionSession::handleContextReady);
+        connect(ragEngine, &RAGEngine::contextFailed, this, &ChatCompletionSession::handleContextFailed);
+        m_ragRequestId = ragEngine->requestContext(m_userPrompt, cfg->ragTopK);
+        return;
+    }
+
+    // Defer so the LLM client's network manager is initialized first
+    QTimer::singleShot(0, this, [this]() { sendPrompt(m_userPrompt); });
+}
+
+void ChatCompletionSession::sendPrompt(const QString &prompt) {
+    QString fullPrompt = prompt;
+
+    // Prompt-based models don't use the chat history, so inline it
+    QString format = m_llmClient->getToolCallFormat();
+    if (format != "native" && format != "unknown" && !m_history.isEmpty()) {
+        QString transcript = "PREVIOUS CONVERSATION:\n";
+        for (const QJsonValue &val : m_history) {
+            QJsonObject msg = val.toObject();
+            transcript += QString("%1: %2\n").arg(msg["role"].toString(), msg["content"].toString());
+        }
+        fullPrompt = transcript + "\n" + prompt;
+    }
+
+    if (m_useTools) {
+        m_llmClient->sendPromptWithTools(fullPrompt, m_server->mcpHandler()->getToolsForLLM());
+    } else {
+        m_llmClient->sendPrompt(fullPrompt);
+    }
+}
+
+void ChatCompletionSession::handleContextReady(int requestId, const QStringList &contexts) {
+    if (requestId != m_ragRequestId) {
+        return;
+    }
+
+    LOG_DEBUG(QString("Chat session %1: RAG retrieved %2 chunks").arg(m_completionId).arg(contexts.size()));
+
+    // Same prompt layout as the GUI
+    QString ragContext;
+    if (!contexts.isEmpty()) {
+        ragContext = "CONTEXT FROM DOCUMENTS:\n\n";
+        for (int i = 0; i < contexts.size(); ++i) {
+            ragContext += QString("--- Document Chunk %1 ---\n%2\n\n").arg(i + 1).arg(contexts[i]);
+        }
+        ragContext += "\nPlease use the above context to answer the user's question.\n\n";
+    }
+
+    sendPrompt(ragContext + "USER QUESTION: " + m_userPrompt);
+}
+
+void ChatCompletionSession::handleContextFailed(int requestId, const QString &error) {
+    if (requestId != m_ragRequestId) {
+        return;
+    }
+
+    LOG_WARNING(QString("Chat session %1: RAG error: %2 - proceeding without context").arg(m_completionId, error));
+    sendPrompt(m_userPrompt);
+}
+
+void ChatCompletionSession::handleToolCallRequest(const QString &toolName, const QJsonObject &parameters, const QString &callId) {
+    Q_UNUSED(callId);  // MCPHandler generates its own call ID
+
+    // Held-back text was the tool call itself, not content for the client
+    m_pendingText.clear();
+    m_server->dispatchToolCall(this, toolName, parameters);
+}
+
+void ChatCompletionSession::handleToolCallCompleted(const QString &toolCallId, const QString &toolName, const QJsonObject &result) {
+    QJsonArray toolResults;
+    QJsonObject toolResult;
+    toolResult["tool_name"] = toolName;
+    toolResult["call_id"] = toolCallId;
+    toolResult["result"] = result;
+    toolResults.append(toolResult);
+
+    m_llmClient->sendToolResults(m_userPrompt, toolResults);
+}
+
+void ChatCompletionSession::handleToolCallFailed(const QString &toolCallId, const QString &toolName, const QString &error) {
+    QJsonObject result;
+    result["error"] = error;
+    handleToolCallCompleted(toolCallId, toolName, result);
+}
+
+void ChatCompletionSession::writeStreamHeaders() {
+    if (m_headersSent || !m_socket) {
+        return;
+    }
+
+    QByteArray headers;
+    headers += "HTTP/1.1 200 OK\r\n";
+    headers += "Content-Type: text/event-stream\r\n";
+    headers += "Cache-Control: no-cache\r\n";
+    headers += "Connection: close\r\n\r\n";
+    m_socket->write(headers);
+    m_headersSent = true;
+
+    QJsonObject delta;
+    delta["role"] = "assistant";
+    writeChunk(delta);
+}
+
+void ChatCompletionSession::writeChunk(const QJsonObject &delta, const QString &finishReason) {
+    if (!m_socket) {
+        return;
+    }
+
+    QJsonObject choice;
+    choice["index"] = 0;
+    choice["delta"] = delta;
+    choice["finish_reason"] = finishReason.isEmpty() ? QJsonValue(QJsonValue::Null) : QJsonValue(finishReason);
+
+    QJsonObject chunk;
+    chunk["id"] = m_completionId;
+    chunk["object"] = "chat.completion.chunk";
+    chunk["created"] = m_created;
+    chunk["model"] = m_model;
+    chunk["choices"] = QJsonArray{choice};
+
+    m_socket->write("data: " + QJsonDocument(chunk).toJson(QJsonDocument::Compact) + "\n\n");
+}
+
+void ChatCompletionSession::handleToken(const QString &token) {
+    if (!m_stream) {
+        return;
+    }
+
+    m_pendingText += token;
+
+    // A prompt-based tool call arrives as a JSON object in the token stream;
+    // hold the start of the response back until it's clearly not one
+    if (m_useTools && m_streamedText.isEmpty()) {
+        QString trimmed = m_pendingText.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('{') || trimmed.startsWith("```")) {
+            return;
+        }
+    }
+
+    writeStreamHeaders();
+    QJsonObject delta;
+    delta["content"] = m_pendingText;
+    writeChunk(delta);
+    m_streamedText += m_pendingText;
+    m_pendingText.clear();
+}
+
+void ChatCompletionSession::handleResponse(const QString &response) {
+    if (m_finished) {
+        return;
+    }
+
+    if (m_stream) {
+        writeStreamHeaders();
+
+        // Send whatever the client hasn't seen yet: held-back tokens, or the
+        // whole response when tool results were formatted without streaming
+        QString remainder;
+        if (m_streamedText.isEmpty()) {
+            remainder = response;
+        } else if (response.startsWith(m_streamedText)) {
+            remainder = response.mid(m_streamedText.length());
+        }
+        if (!remainder.isEmpty()) {
+            QJsonObject delta;
+            delta["content"] = remainder;
+            writeChunk(delta);
+        }
+
+        writeChunk(QJsonObject(), "stop");
+        if (m_socket) {
+            m_socket->write("data: [DONE]\n\n");
+            m_socket->disconnectFromHost();
+        }
+    } else {
+        QJsonObject message;
+        message["role"] = "assistant";
+        message["content"] = response;
+
+        QJsonObject choice;
+        choice["index"] = 0;
+        choice["message"] = message;
+        choice["finish_reason"] = "stop";
+
+        QJsonObject body;
+        body["id"] = m_completionId;
+        body["object"] = "chat.completion";
+        body["created"] = m_created;
+        body["model"] = m_model;
+        body["choices"] = QJsonArray{choice};
+
+        LocalApiServer::writeJsonResponse(m_socket, 200, body);
+    }
+
+    finish();
+}
+
+void ChatCompletionSession::handleError(const QString &error) {
+    if (m_finished) {
+        return;
+    }
+
+    LOG_WARNING(QString("Chat session %1 failed: %2").arg(m_completionId, error));
+
+    if (m_headersSent) {
+        QJsonObject errorObj;
+        errorObj["message"] = error;
+        errorObj["type"] = "upstream_error";
+        QJsonObject body;
+        body["error"] = errorObj;
+        if (m_socket) {
+            m_socket->write("data: " + QJsonDocument(body).toJson(QJsonDocument::Compact) + "\n\n");
+            m_socket->write("data: [DONE]\n\n");
+            m_socket->disconnectFromHost();
+        }
+    } else {
+        LocalApiServer::writeError(m_socket, 502, error);
+    }
+
+    finish();
+}
+
+void ChatCompletionSession::handleSocketDisconnected() {
+    if (!m_finished) {
+        LOG_INFO(QString("Chat session %1: client disconnected, cancelling").arg(m_completionId));
+    }
+    finish();
+}
+
+void ChatCompletionSession::finish() {
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    emit finished();
+}
+
+// ---------------------------------------------------------------------------
+// LocalApiServer
+// ---------------------------------------------------------------------------
+
+LocalApiServer::LocalApiServer(QObject *parent)
+    : QObject(parent)
+    , m_tcpServer(new QTcpServer(this))
+    , m_mcpHandler(nullptr)
+    , m_ragEngine(nullptr)
+    , m_probeClient(nullptr)
+    , m_dispatchingSession(nullptr) {
+    connect(m_tcpServer, &QTcpServer::newConnection, this, &LocalApiServer::handleNewConnection);
+    connect(&Config::instance(), &Config::configChanged, this, &LocalApiServer::handleConfigChanged);
+}
+
+LocalApiServer::~LocalApiServer() {
+    close();
+}
+
+void LocalApiServer::warmUp() {
+    LOG_INFO("Warming up daemon engines");
+
+    // Tools: local tools now, MCP servers once the event loop is running
+    m_mcpHandler = new MCPHandler(this);
+    connect(m_mcpHandler, &MCPHandler::toolCallCompleted, this, &LocalApiServer::handleToolCallCompleted);
+    connect(m_mcpHandler, &MCPHandler::toolCallFailed, this, &LocalApiServer::handleToolCallFailed);
+    registerLocalTools();
+    QTimer::singleShot(100, this, &LocalApiServer::registerConfiguredServers);
+
+    // RAG index lives for the lifetime of the daemon
+    m_ragEngine = new RAGEngine(this);
+    applyRagSettings();
+
+    // Capability detection runs once and is shared by all sessions
+    detectCapabilities();
+}
+
+bool LocalApiServer::listen(const QHostAddress &address, quint16 port) {
+    if (!m_tcpServer->listen(address, port)) {
+        LOG_ERROR(QString("Failed to listen on %1:%2: %3")
+                  .arg(address.toString()).arg(port).arg(m_tcpServer->errorString()));
+        return false;
+    }
+
+    if (!address.isLoopback()) {
+        LOG_WARNING(QString("Local API listening on non-loopback address %1 without authentication")
+                    .arg(address.toString()));
+    }
+
+    LOG_INFO(QString("Local API listening on http://%1:%2")
+             .arg(address.toString()).arg(m_tcpServer->serverPort()));
+    return true;
+}
+
+void LocalApiServer::close() {
+    if (m_tcpServer->isListening()) {
+        m_tcpServer->close();
+        LOG_INFO("Local API server stopped");
+    }
+}
+
+quint16 LocalApiServer::serverPort() const {
+    return m_tcpServer->serverPort();
+}
+
+bool LocalApiServer::cachedCapabilities(const QString &model, QString &toolCallFormat, QJsonObject &modelInfo) const {
+    auto it = m_capabilities.constFind(model);
+    if (it == m_capabilities.constEnd()) {
+        return false;
+    }
+    toolCallFormat = it->toolCallFormat;
+    modelInfo = it->modelInfo;
+    return true;
+}
+
+void LocalApiServer::cacheCapabilities(const QString &model, const QString &toolCallFormat, const QJsonObject &modelInfo) {
+    CapabilityInfo info;
+    info.toolCallFormat = toolCallFormat;
+    info.modelInfo = modelInfo;
+    m_capabilities.insert(model, info);
+    LOG_INFO(QString("Cached capabilities for model %1: %2 tool calling").arg(model, toolCallFormat));
+    emit capabilitiesReady(model, toolCallFormat);
+}
+
+QString LocalApiServer::dispatchToolCall(ChatCompletionSession *session, const QString &toolName, const QJsonObject &parameters) {
+    // Local tools complete synchronously inside executeToolCall(), before the
+    // call ID is returned, so remember which session is dispatching
+    m_dispatchingSession = session;
+    QString callId = m_mcpHandler->executeToolCall(toolName, parameters);
+    m_dispatchingSession = nullptr;
+
+    if (!callId.isEmpty()) {
+        m_toolCallOwners.insert(callId, session);
+    }
+    return callId;
+}
+
+void LocalApiServer::handleToolCallCompleted(const QString &toolCallId, const QString &toolName, const QJsonObject &result) {
+    QPointer<ChatCompletionSession> owner = m_toolCallOwners.take(toolCallId);
+    if (!owner) {
+        owner = m_dispatchingSession;
+    }
+
+    if (owner) {
+        owner->handleToolCallCompleted(toolCallId, toolName, result);
+    } else {
+        LOG_DEBUG(QString("Tool call %1 completed after its session ended").arg(toolCallId));
+    }
+}
+
+void LocalApiServer::handleToolCallFailed(const QString &toolCallId, const QString &toolName, const QString &error) {
+    QPointer<ChatCompletionSession> owner = m_toolCallOwners.take(toolCallId);
+    if (!owner) {
+        owner = m_dispatchingSession;
+    }
+
+    if (owner) {
+        owner->handleToolCallFailed(toolCallId, toolName, error);
+    } else {
+        LOG_DEBUG(QString("Tool call %1 failed after its session ended").arg(toolCallId));
+    }
+}
+
+void LocalApiServer::handleConfigChanged(Config::Sections sections) {
+    if (sections & Config::LLMSection) {
+        // New model or endpoint: cached capabilities may no longer apply
+        m_capabilities.clear();
+        detectCapabilities();
+    }
+
+    if ((sections & Config::RAGSection) && m_ragEngine) {
+        applyRagSettings();
+    }
+
+    if ((sections & Config::MCPSection) && m_mcpHandler) {
+        int removedCount = m_mcpHandler->clearNetworkedTools();
+        LOG_DEBUG(QString("Cleared %1 networked tools").arg(removedCount));
+        registerConfiguredServers();
+    }
+}
+
+void LocalApiServer::registerLocalTools() {
+    MCPTool calcTool;
+    calcTool.name = "calculator";
+    calcTool.description = "Performs basic arithmetic operations (add, subtract, multiply, divide)";
+    calcTool.isLocal = true;
+    calcTool.function = exampleCalculatorTool;
+    calcTool.parameters = QJsonObject{
+        {"operation", QJsonValue("string: add, subtract, multiply, or divide")},
+        {"a", QJsonValue("number: first operand")},
+        {"b", QJsonValue("number: second operand")}
+    };
+    m_mcpHandler->registerTool(calcTool);
+
+    MCPTool datetimeTool;
+    datetimeTool.name = "datetime";
+    datetimeTool.description = "Get current date and time in various formats";
+    datetimeTool.isLocal = true;
+    datetimeTool.function = exampleDateTimeTool;
+    datetimeTool.parameters = QJsonObject{
+        {"format", QJsonValue("string: 'short', 'long', 'iso', or 'timestamp' (default: long)")}
+    };
+    m_mcpHandler->registerTool(datetimeTool);
+}
+
+void LocalApiServer::registerConfiguredServers() {
+    QJsonArray mcpServers = Config::instance().getMcpServers();
+    if (mcpServers.isEmpty()) {
+        LOG_DEBUG("No MCP servers configured");
+        return;
+    }
+
+    for (const QJsonValue &serverVal : mcpServers) {
+        if (!serverVal.isObject()) {
+            continue;
+        }
+
+        QJsonObject server = serverVal.toObject();
+        QString name = server["name"].toString();
+        QString url = server["url"].toString();
+        QString type = server["type"].toString().toLower();
+        bool enabled = server["enabled"].toBool(true);
+
+        if (!enabled || name.isEmpty() || url.isEmpty()) {
+            continue;
+        }
+
+        int toolCount = m_mcpHandler->discoverAndRegisterServerTools(name, url, type);
+        if (toolCount < 0) {
+            LOG_WARNING(QString("Daemon: Failed to discover tools from MCP server: %1").arg(name));
+        }
+    }
+
+    LOG_INFO(QString("Daemon tools registered: %1").arg(m_mcpHandler->getRegisteredTools().size()));
+}
+
+void LocalApiServer::applyRagSettings() {
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    m_ragEngine->setEmbeddingProvider(cfg->ragEmbeddingProvider, cfg->ragEmbeddingUrl, cfg->openaiApiKey);
+    m_ragEngine->setDimensionReduction(cfg->ragDimensionReduction, cfg->ragEmbeddingDimensions);
+    m_ragEngine->setEmbeddingModel(cfg->ragEmbeddingModel);
+    m_ragEngine->setChunkSize(cfg->ragChunkSize);
+    m_ragEngine->setChunkOverlap(cfg->ragChunkOverlap);
+    m_ragEngine->setChunkTokens(cfg->ragChunkTokens);
+    m_ragEngine->setTokenizer(cfg->ragTokenizer);
+    m_ragEngine->setRetrievalDeadline(cfg->ragDeadlineMs);
+    m_ragEngine->setIngestionJournal(cfg->ragJournal ? IngestionJournal::defaultPath("daemon") : QString());
+}
+
+void LocalApiServer::detectCapabilities() {
+    if (!m_probeClient) {
+        // The client queries capabilities on its own once its network manager exists
+        m_probeClient = new LLMClient(this);
+        connect(m_probeClient, &LLMClient::modelCapabilitiesDetected, this,
+                [this](const QString &format, const QJsonObject &info) {
+            cacheCapabilities(m_probeClient->getModel(), format, info);
+        });
+        return;
+    }
+
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+    m_probeClient->setModel(cfg->model);
+    m_probeClient->setApiUrl(cfg->apiUrl);
+    m_probeClient->queryModelCapabilities();
+}
+
+void LocalApiServer::handleNewConnection() {
+    while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, &LocalApiServer::handleReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+        m_buffers.insert(socket, QByteArray());
+    }
+}
+
+void LocalApiServer::handleReadyRead() {
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_buffers.contains(socket)) {
+        return;
+    }
+
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    ApiHttpRequest request;
+    ParseResult result = parseRequest(buffer, request);
+    if (result == ParseTooLarge) {
+        m_buffers.remove(socket);
+        disconnect(socket, &QTcpSocket::readyRead, this, &LocalApiServer::handleReadyRead);
+        writeError(socket, 413, "Request too large");
+        return;
+    }
+    if (result == ParseIncomplete) {
+        return;
+    }
+
+    // One request per connection
+    m_buffers.remove(socket);
+    disconnect(socket, &QTcpSocket::readyRead, this, &LocalApiServer::handleReadyRead);
+    routeRequest(socket, request);
+}
+
+LocalApiServer::ParseResult LocalApiServer::parseRequest(const QByteArray &buffer, ApiHttpRequest &request) const {
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return buffer.size() > MAX_HEADER_BYTES ? ParseTooLarge : ParseIncomplete;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        // Not HTTP; routing an empty path yields a 404
+        request.method = "GET";
+        return ParseComplete;
+    }
+    request.method = requestLine[0].toUpper();
+    request.path = requestLine[1];
+
+    // Strip query string
+    int queryPos = request.path.indexOf('?');
+    if (queryPos >= 0) {
+        request.path.truncate(queryPos);
+    }
+
+    for (int i = 1; i < lines.size(); ++i) {
+        int colon = lines[i].indexOf(':');
+        if (colon > 0) {
+            request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+        }
+    }
+
+    int contentLength = request.headers.value("content-length", "0").toInt();
+    if (contentLength < 0 || contentLength > MAX_BODY_BYTES) {
+        return ParseTooLarge;
+    }
+
+    int bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < contentLength) {
+        return ParseIncomplete;
+    }
+
+    request.body = buffer.mid(bodyStart, contentLength);
+    return ParseComplete;
+}
+
+void LocalApiServer::routeRequest(QTcpSocket *socket, const ApiHttpRequest &request) {
+    LOG_DEBUG(QString("Local API: %1 %2").arg(QString::fromLatin1(request.method), QString::fromLatin1(request.path)));
+
+    if (request.path == "/health") {
+        handleHealth(socket);
+    } else if (request.path == "/v1/models") {
+        handleModels(socket);
+    } else if (request.path == "/v1/chat/completions") {
+        if (request.method != "POST") {
+            writeError(socket, 405, "Use POST for /v1/chat/completions");
+            return;
+        }
+        handleChatCompletions(socket, request);
+    } else {
+        writeError(socket, 404, QString("Unknown endpoint: %1").arg(QString::fromLatin1(request.path)));
+    }
+}
+
+void LocalApiServer::handleHealth(QTcpSocket *socket) {
+    std::shared_ptr<const ConfigSnapshot> cfg = Config::instance().snapshot();
+
+    QJsonObject body;
+    body["status"] = "ok";
+    body["version"] = APP_VERSION;
+    body["model"] = cfg->model;
+    body["tool_call_format"] = m_capabilities.contains(cfg->model)
+        ? m_capabilities.value(cfg->model).toolCallFormat : QString("unknown");
+    body["tools"] = m_mcpHandler ? m_mcpHandler->getRegisteredTools().size() : 0;
+    body["rag_documents"] = m_ragEngine ? m_ragEngine->getDocumentCount() : 0;
+    body["rag_chunks"] = m_ragEngine ? m_ragEngine->getChunkCount() : 0;
+    body["active_requests"] = m_sessions.size();
+    body["memory"] = MemoryGovernor::instance().toJson();
+    writeJsonResponse(socket, 200, body);
+}
+
+void LocalApiServer::handleModels(QTcpSocket *socket) {
+    QStringList models = m_capabilities.keys();
+    QString configured = Config::instance().getModel();
+    if (!models.contains(configured)) {
+        models.prepend(configured);
+    }
+
+    QJsonArray data;
+    for (const QString &model : models) {
+        QJsonObject entry;
+        entry["id"] = model;
+        entry["object"] = "model";
+        entry["owned_by"] = "local";
+        data.append(entry);
+    }
+
+    QJsonObject body;
+    body["object"] = "list";
+    body["data"] = data;
+    writeJsonResponse(socket, 200, body);
+}
+
+void LocalApiServer::handleChatCompletions(QTcpSocket *socket, const ApiHttpRequest &request) {
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(request.body, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        writeError(socket, 400, QString("Invalid JSON body: %1").arg(parseError.errorString()));
+        return;
+    }
+
+    QJsonObject body = doc.object();
+    QJsonArray messages = body["messages"].toArray();
+    if (messages.isEmpty()) {
+        writeError(socket, 400, "'messages' must be a non-empty array");
+        return;
+    }
+
+    QJsonObject last = messages.last().toObject();
+    if (last["role"].toString() != "user" || last["content"].toString().isEmpty()) {
+        writeError(socket, 400, "The last message must be a non-empty user message");
+        return;
+    }
+
+    if (!m_mcpHandler) {
+        writeError(socket, 503, "Daemon is not warmed up");
+        return;
+    }
+
+    ChatCompletionSession *session = new ChatCompletionSession(this, socket, body, this);
+    m_sessions.append(session);
+    connect(session, &ChatCompletionSession::finished, this, [this, session]() {
+        m_sessions.removeOne(session);
+        session->deleteLater();
+    });
+    session->start();
+}
+
+void LocalApiServer::writeJsonResponse(QTcpSocket *socket, int status, const QJsonObject &body) {
+    if (!socket) {
+        return;
+    }
+
+    QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+
+    QByteArray response;
+    response += "HTTP/1.1 " + QByteArray::number(status) + " " + statusText(status) + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + QByteArray::number(payload.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += payload;
+
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+void LocalApiServer::writeError(QTcpSocket *socket, int status, const QString &message) {
+    QJsonObject error;
+    error["message"] = message;
+    error["type"] = status >= 500 ? "server_error" : "invalid_request_error";
+
+    QJsonObject body;
+    body["error"] = error;
+    writeJsonResponse(socket, status, body);
+}
@@ -18,6 +18,12 @@
 #include <QScrollBar>
 #include <QStandardPaths>
 #include <QRegularExpression>
+#include <QThread>
+#include <QTextDocument>
+#include <QTextCursor>
+
+// Lines kept when the memory governor sheds render caches
+static const int LOG_LINES_KEPT_UNDER_PRESSURE = 200;
 
 // Static instance
 LogViewerDialog* LogViewerDialog::s_instance = nullptr;
@@ -26,12 +32,22 @@ LogViewerDialog::LogViewerDialog(QWidget *parent)
     : QDialog(parent)
     , currentFilter(QtDebugMsg)  // Show all messages by default
     , autoScroll(true)
-    , m_isDestroying(false) {
+    , m_isDestroying(false)
+    , m_memory("log_viewer") {
     setWindowTitle(tr("Log Viewer"));
     setMinimumSize(800, 600);
 
     createUI();
     loadExistingLogs();
+
+    // The full log stays on disk; what is shown can be cut back under pressure
+    connect(logTextEdit->document(), &QTextDocument::contentsChanged, this, [this]() {
+        m_memory.set(static_cast<qint64>(logTextEdit->document()->characterCount()) * sizeof(QChar));
+    });
+    m_memory.set(static_cast<qint64>(logTextEdit->document()->characterCount()) * sizeof(QChar));
+    MemoryGovernor::instance().addShedder(MemoryGovernor::RenderCaches, this, [this]() {
+        trimLogs();
+    });
 }
 
 LogViewerDialog::~LogViewerDialog() {
@@ -131,6 +147,14 @@ void LogViewerDialog::addLogMessage(QtMsgType type, const QString &message) {
         return;
     }
 
+    // Engines log from their own threads; widgets may only be touched here
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, type, message]() {
+            addLogMessage(type, message);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
     QString formattedMessage = formatLogMessage(type, message);
 
     // Append to log display
@@ -197,6 +221,18 @@ bool LogViewerDialog::shouldShowMessage(QtMsgType type) {
     return type >= currentFilter;
 }
 
+void LogViewerDialog::trimLogs() {
+    QMutexLocker locker(&mutex);
+    QTextDocument *document = logTextEdit->document();
+    int excess = document->blockCount() - LOG_LINES_KEPT_UNDER_PRESSURE;
+    if (excess > 0) {
+        QTextCursor cursor(document);
+        cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, excess);
+        cursor.removeSelectedText();
+    }
+    document->clearUndoRedoStacks();
+}
+
 void LogViewerDialog::clearLogs() {
     QMutexLocker locker(&mutex);
     logTextEdit->clear();
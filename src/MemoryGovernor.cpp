@@ -0,0 +1,313 @@
+/**
+ * MemoryGovernor.cpp - Process-wide memory budget and staged cache shedding
+ *
+ * Reads the anonymous resident memory from the OS on a timer, sums the
+ * per-subsystem accounts, and walks the shedding stages while the process
+ * stays over its budget.
+ */
+
+#include "MemoryGovernor.h"
+#include "Config.h"
+#include "Logger.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+#ifdef Q_OS_MACOS
+#include <mach/mach.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+static const int SAMPLE_INTERVAL_MS = 5000;
+
+// Usage above this share of the budget is reported as elevated
+static const int ELEVATED_PERCENT = 80;
+
+static const qint64 MB = 1024 * 1024;
+
+MemoryGovernor& MemoryGovernor::instance() {
+    static MemoryGovernor instance;
+    return instance;
+}
+
+MemoryGovernor::MemoryGovernor()
+    : QObject(nullptr)
+    , m_timer(nullptr)
+    , m_budget(0)
+    , m_residentBytes(-1)
+    , m_pressure(Normal)
+    , m_nextStage(0)
+    , m_exhausted(false)
+    , m_trimPending(false)
+    , m_shedCount(0) {
+    // The first caller may be an engine thread registering an account;
+    // sampling and the signals belong to the main thread
+    if (QCoreApplication::instance() && thread() != QCoreApplication::instance()->thread()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+void MemoryGovernor::setBudget(qint64 bytes) {
+    bytes = qMax<qint64>(0, bytes);
+    if (bytes == m_budget) {
+        return;
+    }
+    m_budget = bytes;
+    if (bytes > 0) {
+        LOG_INFO(QString("Memory budget: %1 MB").arg(bytes / MB));
+    } else {
+        LOG_INFO("Memory budget: unlimited");
+    }
+}
+
+void MemoryGovernor::start(int ms) {
+    if (!m_timer) {
+        m_timer = new QTimer(this);
+        connect(m_timer, &QTimer::timeout, this, &MemoryGovernor::sample);
+
+        // Budget changes in the config file apply without a restart
+        connect(&Config::instance(), &Config::configChanged, this, [this](Config::Sections sections) {
+            if (sections & Config::MemorySection) {
+                setBudget(Config::instance().getMemoryBudgetMb() * MB);
+                sample();
+            }
+        });
+        setBudget(Config::instance().getMemoryBudgetMb() * MB);
+    }
+
+    m_timer->start(ms > 0 ? ms : SAMPLE_INTERVAL_MS);
+    sample();
+}
+
+void MemoryGovernor::stop() {
+    if (m_timer) {
+        m_timer->stop();
+    }
+}
+
+bool MemoryGovernor::isRunning() const {
+    return m_timer && m_timer->isActive();
+}
+
+void MemoryGovernor::addShedder(ShedStage stage, QObject *owner, std::function<void()> shed) {
+    if (!owner || stage < 0 || stage >= StageCount) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shedders.append(Shedder{stage, owner, std::move(shed)});
+    }
+
+    // Direct: runs on the owner's thread before it is gone, while shedStage() can't hold it
+    connect(owner, &QObject::destroyed, this, [this, owner]() {
+        removeShedders(owner);
+    }, Qt::DirectConnection);
+}
+
+void MemoryGovernor::removeShedders(QObject *owner) {
+    QMutexLocker locker(&m_mutex);
+    for (int i = m_shedders.size() - 1; i >= 0; --i) {
+        if (m_shedders[i].owner == owner) {
+            m_shedders.removeAt(i);
+        }
+    }
+}
+
+void MemoryGovernor::registerAccount(MemoryAccount *account) {
+    QMutexLocker locker(&m_mutex);
+    m_accounts.append(account);
+}
+
+void MemoryGovernor::unregisterAccount(MemoryAccount *account) {
+    QMutexLocker locker(&m_mutex);
+    m_accounts.removeOne(account);
+}
+
+qint64 MemoryGovernor::accountedBytes() const {
+    QMutexLocker locker(&m_mutex);
+    qint64 total = 0;
+    for (const MemoryAccount *account : m_accounts) {
+        total += account->bytes();
+    }
+    return total;
+}
+
+QMap<QString, qint64> MemoryGovernor::subsystems() const {
+    QMutexLocker locker(&m_mutex);
+    QMap<QString, qint64> totals;
+    for (const MemoryAccount *account : m_accounts) {
+        totals[account->subsystem()] += account->bytes();
+    }
+    return totals;
+}
+
+qint64 MemoryGovernor::sampleResidentBytes() {
+#if defined(Q_OS_LINUX)
+    // statm: size resident shared ... in pages; shared counts file-backed pages,
+    // including mapped embeddings, which the kernel can evict without swap
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 2) {
+            qint64 pages = fields[1].toLongLong() - fields[2].toLongLong();
+            return qMax<qint64>(0, pages) * sysconf(_SC_PAGESIZE);
+        }
+    }
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return static_cast<qint64>(info.resident_size);
+    }
+#endif
+    return -1;
+}
+
+void MemoryGovernor::sample() {
+#ifdef __GLIBC__
+    // Freed caches stay in the heap's free lists until returned to the OS
+    if (m_trimPending) {
+        malloc_trim(0);
+    }
+#endif
+    m_trimPending = false;
+
+    qint64 used = sampleResidentBytes();
+    if (used < 0) {
+        used = accountedBytes();
+    }
+    m_residentBytes = used;
+
+    qint64 budget = m_budget;
+    Pressure pressure = Normal;
+    if (budget > 0 && used > budget) {
+        pressure = Over;
+    } else if (budget > 0 && used > budget * ELEVATED_PERCENT / 100) {
+        pressure = Elevated;
+    }
+
+    if (pressure != m_pressure) {
+        m_pressure = pressure;
+        if (pressure == Over) {
+            LOG_WARNING(QString("Memory over budget: %1").arg(summary()));
+        } else {
+            LOG_INFO(QString("Memory pressure %1: %2").arg(pressureName(pressure), summary()));
+        }
+        emit pressureChanged(pressure);
+    }
+
+    if (pressure == Normal) {
+        m_nextStage = 0;
+        m_exhausted = false;
+    } else if (pressure == Over) {
+        // Caches refill while over budget: after the last stage, start over
+        if (m_nextStage >= StageCount) {
+            if (!m_exhausted) {
+                m_exhausted = true;
+                LOG_WARNING(QString("Memory still over budget after shedding every cache: %1").arg(summary()));
+            }
+            m_nextStage = 0;
+        }
+
+        // One stage per sample; stages nobody registered for are skipped
+        bool shed = false;
+        while (!shed && m_nextStage < StageCount) {
+            shed = shedStage(static_cast<ShedStage>(m_nextStage++)) > 0;
+        }
+        m_trimPending = shed;
+    }
+
+    emit sampled();
+}
+
+int MemoryGovernor::shedStage(ShedStage stage) {
+    int count = 0;
+    {
+        // Queued even for main-thread owners: shedding must not re-enter the caller,
+        // and an owner being destroyed waits on the lock until its events are posted
+        QMutexLocker locker(&m_mutex);
+        for (const Shedder &shedder : m_shedders) {
+            if (shedder.stage == stage) {
+                QMetaObject::invokeMethod(shedder.owner, shedder.shed, Qt::QueuedConnection);
+                count++;
+            }
+        }
+    }
+
+    if (count > 0) {
+        m_shedCount++;
+        LOG_INFO(QString("Memory over budget, shedding %1 (%2 owners)").arg(stageName(stage)).arg(count));
+        emit shedding(stage);
+    }
+    return count;
+}
+
+QString MemoryGovernor::stageName(ShedStage stage) {
+    switch (stage) {
+    case RenderCaches:
+        return "render_caches";
+    case TranscriptHtml:
+        return "transcript_html";
+    case Embeddings:
+        return "embeddings";
+    case QueryCaches:
+        return "query_caches";
+    default:
+        return "none";
+    }
+}
+
+QString MemoryGovernor::pressureName(Pressure pressure) {
+    switch (pressure) {
+    case Elevated:
+        return "elevated";
+    case Over:
+        return "over";
+    default:
+        return "normal";
+    }
+}
+
+QString MemoryGovernor::summary() const {
+    qint64 used = qMax<qint64>(0, m_residentBytes);
+    qint64 budget = m_budget;
+    if (budget > 0) {
+        return QString("%1 / %2 MB").arg(used / MB).arg(budget / MB);
+    }
+    return QString("%1 MB").arg(used / MB);
+}
+
+QJsonObject MemoryGovernor::toJson() const {
+    QJsonObject json;
+    json["resident_bytes"] = m_residentBytes.load();
+    json["budget_bytes"] = m_budget.load();
+    json["pressure"] = pressureName(m_pressure);
+    json["accounted_bytes"] = accountedBytes();
+
+    QJsonObject subsystemBytes;
+    const QMap<QString, qint64> totals = subsystems();
+    for (auto it = totals.constBegin(); it != totals.constEnd(); ++it) {
+        subsystemBytes[it.key()] = it.value();
+    }
+    json["subsystems"] = subsystemBytes;
+
+    json["shed_count"] = m_shedCount;
+    return json;
+}
+
+MemoryAccount::MemoryAccount(const QString &subsystem)
+    : m_subsystem(subsystem)
+    , m_bytes(0) {
+    MemoryGovernor::instance().registerAccount(this);
+}
+
+MemoryAccount::~MemoryAccount() {
+    MemoryGovernor::instance().unregisterAccount(this);
+}
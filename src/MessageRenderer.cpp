@@ -22,18 +22,20 @@ MessageRenderer::MessageRenderer(QTextEdit *display, QObject *parent)
     , m_lastBotMessageStartPos(-1) {
 }
 
-void MessageRenderer::appendMessage(const QString &sender, const QString &message) {
-    QString timestamp = QTime::currentTime().toString("hh:mm:ss");
+QString MessageRenderer::formatMessage(const QString &sender, const QString &message, const QString &timestamp) {
     QString formattedMessage = MarkdownHandler::toHtml(message);
-    QString formatted;
 
     if (sender == "You") {
-        formatted = HTMLHandler::formatUserMessage(formattedMessage, timestamp);
+        return HTMLHandler::formatUserMessage(formattedMessage, timestamp);
     } else if (sender == "Bot") {
-        formatted = HTMLHandler::formatBotMessage(formattedMessage, timestamp);
-    } else {
-        formatted = HTMLHandler::formatSystemMessage(formattedMessage, timestamp);
+        return HTMLHandler::formatBotMessage(formattedMessage, timestamp);
     }
+    return HTMLHandler::formatSystemMessage(formattedMessage, timestamp);
+}
+
+void MessageRenderer::appendMessage(const QString &sender, const QString &message) {
+    QString timestamp = QTime::currentTime().toString("hh:mm:ss");
+    QString formatted = formatMessage(sender, message, timestamp);
 
     // Store position BEFORE appending (for Bot messages)
     if (sender == "Bot") {
@@ -104,6 +106,53 @@ void MessageRenderer::updateLastMessage(const QString &message, bool isStreaming
     autoScrollToBottom();
 }
 
+void MessageRenderer::appendEntries(const QList<ChatEntry> &entries) {
+    for (const ChatEntry &entry : entries) {
+        if (entry.sender.isEmpty()) {
+            chatDisplay->append(entry.message);
+        } else {
+            chatDisplay->append(formatMessage(entry.sender, entry.message, entry.timestamp));
+        }
+    }
+
+    // Restored messages are final: the next response starts a new message
+    m_lastMessageSender.clear();
+    m_lastBotMessageStartPos = -1;
+
+    autoScrollToBottom();
+}
+
+void MessageRenderer::prependEntries(const QList<ChatEntry> &entries) {
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    QScrollBar *scrollBar = chatDisplay->verticalScrollBar();
+    int distanceFromBottom = scrollBar->maximum() - scrollBar->value();
+
+    QTextDocument *doc = chatDisplay->document();
+    QTextCursor cursor(doc);
+    cursor.movePosition(QTextCursor::Start);
+    cursor.beginEditBlock();
+    for (const ChatEntry &entry : entries) {
+        if (entry.sender.isEmpty()) {
+            cursor.insertHtml(entry.message);
+        } else {
+            cursor.insertHtml(formatMessage(entry.sender, entry.message, entry.timestamp));
+        }
+        cursor.insertBlock();
+    }
+    cursor.endEditBlock();
+
+    // Everything after the insertion point moved by the inserted length
+    if (m_lastBotMessageStartPos >= 0) {
+        m_lastBotMessageStartPos += cursor.position();
+    }
+
+    // Keep the previously visible messages in place
+    scrollBar->setValue(scrollBar->maximum() - distanceFromBottom);
+}
+
 void MessageRenderer::clear() {
     chatDisplay->clear();
     m_lastMessageSender.clear();
@@ -0,0 +1,361 @@
+/**
+ * MockOllamaServer.cpp - Local stand-in for the Ollama HTTP API
+ *
+ * One request per connection. Generation endpoints stream paced NDJSON
+ * chunks from a timer; /api/show answers immediately and the embedding
+ * endpoints after embeddingDelayMs.
+ */
+
+#include "MockOllamaServer.h"
+#include "Logger.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QList>
+
+// Stop writing while this much output is still queued (client can't keep up)
+static const qint64 MAX_PENDING_WRITE_BYTES = 64 * 1024;
+static const int MAX_REQUEST_BYTES = 8 * 1024 * 1024;
+
+// Synthetic output; includes markdown so rendering does real work
+static const char *const MOCK_WORDS[] = {
+    "The ", "quick ", "brown ", "fox ", "jumps ", "over ", "the ", "lazy ", "dog", ". ",
+    "**Note:** ", "use ", "`code` ", "spans ", "and ", "lists", ":\n\n", "- item ", "one\n", "- item ",
+    "two\n\n", "Streaming ", "keeps ", "going ", "with ", "more ", "words ", "and ", "*emphasis*", ".\n\n"
+};
+static const int MOCK_WORD_COUNT = sizeof(MOCK_WORDS) / sizeof(MOCK_WORDS[0]);
+
+MockOllamaServer::MockOllamaServer(const MockOllamaOptions &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_tcpServer(new QTcpServer(this))
+    , m_requestCount(0)
+    , m_tokensSent(0) {
+    connect(m_tcpServer, &QTcpServer::newConnection, this, &MockOllamaServer::handleNewConnection);
+}
+
+MockOllamaServer::~MockOllamaServer() {
+    close();
+}
+
+bool MockOllamaServer::listen(const QHostAddress &address, quint16 port) {
+    if (!m_tcpServer->listen(address, port)) {
+        LOG_ERROR(QString("Mock Ollama server failed to listen: %1").arg(m_tcpServer->errorString()));
+        return false;
+    }
+    LOG_INFO(QString("Mock Ollama server listening on port %1").arg(m_tcpServer->serverPort()));
+    return true;
+}
+
+void MockOllamaServer::close() {
+    m_tcpServer->close();
+    for (auto it = m_streams.begin(); it != m_streams.end(); ++it) {
+        it->timer->deleteLater();
+    }
+    m_streams.clear();
+}
+
+quint16 MockOllamaServer::serverPort() const {
+    return m_tcpServer->serverPort();
+}
+
+QString MockOllamaServer::generateUrl() const {
+    return QString("http://127.0.0.1:%1/api/generate").arg(serverPort());
+}
+
+void MockOllamaServer::handleNewConnection() {
+    while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, &MockOllamaServer::handleReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_buffers.remove(socket);
+            if (m_streams.contains(socket)) {
+                m_streams.take(socket).timer->deleteLater();
+            }
+            socket->deleteLater();
+        });
+        m_buffers.insert(socket, QByteArray());
+    }
+}
+
+void MockOllamaServer::handleReadyRead() {
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !m_buffers.contains(socket)) {
+        return;
+    }
+
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buffer.size() > MAX_REQUEST_BYTES) {
+            socket->abort();
+        }
+        return;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    int contentLength = 0;
+    for (int i = 1; i < lines.size(); ++i) {
+        int colon = lines[i].indexOf(':');
+        if (colon > 0 && lines[i].left(colon).trimmed().toLower() == "content-length") {
+            contentLength = lines[i].mid(colon + 1).trimmed().toInt();
+        }
+    }
+    if (contentLength < 0 || contentLength > MAX_REQUEST_BYTES) {
+        socket->abort();
+        return;
+    }
+    if (buffer.size() - (headerEnd + 4) < contentLength) {
+        return;
+    }
+
+    QByteArray path = requestLine.size() >= 2 ? requestLine[1] : QByteArray();
+    QByteArray body = buffer.mid(headerEnd + 4, contentLength);
+
+    // One request per connection
+    m_buffers.remove(socket);
+    disconnect(socket, &QTcpSocket::readyRead, this, &MockOllamaServer::handleReadyRead);
+    m_requestCount++;
+    routeRequest(socket, path, body);
+}
+
+void MockOllamaServer::routeRequest(QTcpSocket *socket, const QByteArray &path, const QByteArray &body) {
+    QJsonObject request = QJsonDocument::fromJson(body).object();
+
+    if (path == "/api/generate") {
+        handleGeneration(socket, false, request, body);
+    } else if (path == "/api/chat") {
+        handleGeneration(socket, true, request, body);
+    } else if (path == "/api/show") {
+        handleShow(socket);
+    } else if (path == "/api/embeddings" || path == "/v1/embeddings"
+               || (path == "/api/embed" && m_options.batchEmbeddings)) {
+        handleEmbeddings(socket, path, request);
+    } else {
+        writeJson(socket, 404, QJsonObject{{"error", QString("unknown endpoint %1").arg(QString::fromLatin1(path))}});
+    }
+}
+
+void MockOllamaServer::handleShow(QTcpSocket *socket) {
+    // LLMClient looks for "tool" in the template to pick native tool calling
+    QJsonObject info;
+    info["modelfile"] = "FROM mock";
+    info["parameters"] = "num_ctx 4096";
+    info["template"] = m_options.nativeTools
+        ? "{{ if .Tools }}{{ .Tools }}{{ end }}{{ .Prompt }}"
+        : "{{ .Prompt }}";
+    info["details"] = QJsonObject{{"family", "mock"}, {"parameter_size", "0B"}};
+    writeJson(socket, 200, info);
+}
+
+QJsonArray MockOllamaServer::mockEmbedding(const QString &text) const {
+    // Deterministic per text, so identical text embeds identically
+    uint seed = qHash(text);
+    QJsonArray embedding;
+    for (int i = 0; i < m_options.embeddingDimensions; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        embedding.append(static_cast<double>((seed >> 8) & 0xFFFF) / 65535.0 - 0.5);
+    }
+    return embedding;
+}
+
+void MockOllamaServer::handleEmbeddings(QTcpSocket *socket, const QByteArray &path, const QJsonObject &request) {
+    QJsonObject response;
+    if (path == "/api/embeddings") {
+        response["embedding"] = mockEmbedding(request["prompt"].toString());
+    } else {
+        // Batched endpoints take one string or an array of them as "input"
+        QJsonArray inputs = request["input"].isArray() ? request["input"].toArray()
+                                                       : QJsonArray{request["input"]};
+        QJsonArray vectors;
+        for (const QJsonValue &input : inputs) {
+            if (path == "/api/embed") {
+                vectors.append(mockEmbedding(input.toString()));
+            } else {
+                vectors.append(QJsonObject{{"object", "embedding"},
+                                           {"index", vectors.size()},
+                                           {"embedding", mockEmbedding(input.toString())}});
+            }
+        }
+        response["model"] = request["model"];
+        if (path == "/api/embed") {
+            response["embeddings"] = vectors;
+        } else {
+            response["object"] = "list";
+            response["data"] = vectors;
+        }
+    }
+
+    if (m_options.embeddingDelayMs > 0) {
+        // Tied to the socket, so an aborted request is simply dropped
+        QTimer::singleShot(m_options.embeddingDelayMs, socket, [socket, response]() {
+            writeJson(socket, 200, response);
+        });
+        return;
+    }
+    writeJson(socket, 200, response);
+}
+
+void MockOllamaServer::handleGeneration(QTcpSocket *socket, bool chat, const QJsonObject &request, const QByteArray &rawBody) {
+    writeStreamHeaders(socket);
+    m_requestedModels.append(request["model"].toString());
+    m_generationRequests.append(request);
+
+    // Tool results come back as a user message, see LLMClient::sendToolResults()
+    QJsonArray messages = request["messages"].toArray();
+    bool isToolFollowUp = !messages.isEmpty()
+        && messages.last().toObject()["content"].toString().contains("tool call results");
+    bool offersTools = chat ? !request["tools"].toArray().isEmpty()
+                            : rawBody.contains(m_options.toolCallName.toUtf8());
+
+    if (!m_options.toolCallName.isEmpty() && offersTools && !isToolFollowUp) {
+        QJsonObject chunk;
+        chunk["model"] = request["model"];
+        if (chat) {
+            QJsonObject function{{"name", m_options.toolCallName}, {"arguments", m_options.toolCallArguments}};
+            chunk["message"] = QJsonObject{
+                {"role", "assistant"}, {"content", ""},
+                {"tool_calls", QJsonArray{QJsonObject{{"function", function}}}}
+            };
+        } else {
+            QJsonObject call{{"name", m_options.toolCallName}, {"parameters", m_options.toolCallArguments}};
+            chunk["response"] = QString::fromUtf8(
+                QJsonDocument(QJsonObject{{"tool_call", call}}).toJson(QJsonDocument::Compact));
+        }
+        chunk["done"] = false;
+
+        QTimer::singleShot(m_options.firstTokenDelayMs, socket, [this, socket, chunk]() {
+            writeStreamChunk(socket, chunk);
+            m_tokensSent++;
+            writeStreamChunk(socket, QJsonObject{{"done", true}, {"prompt_eval_count", 1}, {"eval_count", 1}});
+            socket->write("0\r\n\r\n");
+            socket->disconnectFromHost();
+        });
+        return;
+    }
+
+    Stream stream;
+    stream.socket = socket;
+    stream.timer = new QTimer(this);
+    stream.chat = chat;
+    stream.tokensRemaining = m_options.responseTokens;
+    stream.tokenIndex = 0;
+    stream.firstChunkMs = -1;
+    stream.startedMs = QDateTime::currentMSecsSinceEpoch();
+    stream.sinceRequest.start();
+    // Precise, so the first chunk never goes out before firstTokenDelayMs
+    stream.timer->setTimerType(Qt::PreciseTimer);
+    m_streams.insert(socket, stream);
+
+    int interval = m_options.tokensPerSecond > 0
+        ? qMax(1, 1000 * qMax(1, m_options.tokensPerChunk) / m_options.tokensPerSecond)
+        : 0;
+    connect(stream.timer, &QTimer::timeout, this, [this, socket, interval]() {
+        if (m_streams.contains(socket)) {
+            m_streams[socket].timer->setInterval(interval);
+        }
+        writeNextChunk(socket);
+    });
+    stream.timer->start(m_options.firstTokenDelayMs);
+}
+
+void MockOllamaServer::writeNextChunk(QTcpSocket *socket) {
+    if (!m_streams.contains(socket)) {
+        return;
+    }
+    Stream &stream = m_streams[socket];
+
+    // Back-pressure: wait for the client to drain what is already queued
+    if (socket->bytesToWrite() > MAX_PENDING_WRITE_BYTES) {
+        return;
+    }
+
+    if (stream.tokensRemaining <= 0) {
+        finishStream(socket);
+        return;
+    }
+
+    if (stream.firstChunkMs < 0) {
+        stream.firstChunkMs = QDateTime::currentMSecsSinceEpoch();
+        m_firstChunkDelays.append(stream.sinceRequest.elapsed());
+    }
+
+    // Paced streams catch up on tokens that are due, so rates above the
+    // timer's 1 ms resolution still come out right
+    qint64 dueTokens = m_options.tokensPerSecond > 0
+        ? (QDateTime::currentMSecsSinceEpoch() - stream.firstChunkMs) * m_options.tokensPerSecond / 1000 + 1
+        : 0;
+
+    do {
+        int count = qMin(qMax(1, m_options.tokensPerChunk), stream.tokensRemaining);
+        QString text;
+        for (int i = 0; i < count; ++i) {
+            text += QLatin1String(MOCK_WORDS[stream.tokenIndex++ % MOCK_WORD_COUNT]);
+        }
+        stream.tokensRemaining -= count;
+        m_tokensSent += count;
+
+        QJsonObject chunk;
+        chunk["model"] = "mock";
+        if (stream.chat) {
+            chunk["message"] = QJsonObject{{"role", "assistant"}, {"content", text}};
+        } else {
+            chunk["response"] = text;
+        }
+        chunk["done"] = false;
+        writeStreamChunk(socket, chunk);
+    } while (stream.tokensRemaining > 0 && stream.tokenIndex < dueTokens
+             && socket->bytesToWrite() <= MAX_PENDING_WRITE_BYTES);
+}
+
+void MockOllamaServer::finishStream(QTcpSocket *socket) {
+    Stream stream = m_streams.take(socket);
+    stream.timer->deleteLater();
+
+    QJsonObject done;
+    done["model"] = "mock";
+    done["done"] = true;
+    if (stream.chat) {
+        done["message"] = QJsonObject{{"role", "assistant"}, {"content", ""}};
+    } else {
+        done["response"] = "";
+    }
+    done["prompt_eval_count"] = 1;
+    done["eval_count"] = stream.tokenIndex;
+    done["total_duration"] = static_cast<double>(QDateTime::currentMSecsSinceEpoch() - stream.startedMs) * 1000000.0;
+    writeStreamChunk(socket, done);
+
+    socket->write("0\r\n\r\n");
+    socket->disconnectFromHost();
+}
+
+void MockOllamaServer::writeJson(QTcpSocket *socket, int status, const QJsonObject &body) {
+    QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+
+    QByteArray response;
+    response += "HTTP/1.1 " + QByteArray::number(status) + (status == 200 ? " OK" : " Not Found") + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + QByteArray::number(payload.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += payload;
+
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+void MockOllamaServer::writeStreamHeaders(QTcpSocket *socket) {
+    socket->write("HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/x-ndjson\r\n"
+                  "Transfer-Encoding: chunked\r\n"
+                  "Connection: close\r\n\r\n");
+}
+
+void MockOllamaServer::writeStreamChunk(QTcpSocket *socket, const QJsonObject &obj) {
+    QByteArray line = QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n";
+    socket->write(QByteArray::number(line.size(), 16) + "\r\n" + line + "\r\n");
+}
@@ -0,0 +1,97 @@
+/**
+ * ModelRouter.cpp - Per-role model selection
+ */
+
+#include "ModelRouter.h"
+#include "Config.h"
+#include <QMutexLocker>
+
+ModelRouter& ModelRouter::instance() {
+    static ModelRouter instance;
+    return instance;
+}
+
+QString ModelRouter::modelFor(ModelRole role, const ConfigSnapshot &cfg, const QString &mainModel) {
+    QString main = mainModel.isEmpty() ? cfg.model : mainModel;
+
+    QString roleModel;
+    switch (role) {
+        case ModelRole::Answer:
+            return main;
+        case ModelRole::ToolSelection:
+            roleModel = cfg.toolModel;
+            break;
+        case ModelRole::Summarization:
+            roleModel = cfg.summaryModel;
+            break;
+        case ModelRole::QueryRewrite:
+            roleModel = cfg.queryRewriteModel;
+            break;
+    }
+
+    if (!roleModel.isEmpty()) {
+        return roleModel;
+    }
+    if (!cfg.fastModel.isEmpty()) {
+        return cfg.fastModel;
+    }
+    return main;
+}
+
+QStringList ModelRouter::routedModels(const ConfigSnapshot &cfg, const QString &mainModel) {
+    QString main = mainModel.isEmpty() ? cfg.model : mainModel;
+
+    QStringList models;
+    for (ModelRole role : {ModelRole::ToolSelection, ModelRole::Summarization, ModelRole::QueryRewrite}) {
+        QString model = modelFor(role, cfg, main);
+        if (model != main && !models.contains(model)) {
+            models.append(model);
+        }
+    }
+    return models;
+}
+
+QString ModelRouter::roleName(ModelRole role) {
+    switch (role) {
+        case ModelRole::Answer: return "answer";
+        case ModelRole::ToolSelection: return "tool selection";
+        case ModelRole::Summarization: return "summarization";
+        case ModelRole::QueryRewrite: return "query rewrite";
+    }
+    return QString();
+}
+
+QString ModelRouter::toolCallFormat(const QString &apiUrl, const QString &model) const {
+    QMutexLocker locker(&m_mutex);
+    return m_formats.value(key(apiUrl, model));
+}
+
+void ModelRouter::setToolCallFormat(const QString &apiUrl, const QString &model, const QString &format) {
+    QMutexLocker locker(&m_mutex);
+    m_formats.insert(key(apiUrl, model), format);
+}
+
+bool ModelRouter::beginCapabilityQuery(const QString &apiUrl, const QString &model) {
+    QMutexLocker locker(&m_mutex);
+    QString k = key(apiUrl, model);
+    if (m_formats.contains(k) || m_queries.contains(k)) {
+        return false;
+    }
+    m_queries.insert(k, true);
+    return true;
+}
+
+void ModelRouter::endCapabilityQuery(const QString &apiUrl, const QString &model) {
+    QMutexLocker locker(&m_mutex);
+    m_queries.remove(key(apiUrl, model));
+}
+
+void ModelRouter::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_formats.clear();
+    m_queries.clear();
+}
+
+QString ModelRouter::key(const QString &apiUrl, const QString &model) {
+    return apiUrl + '\n' + model;
+}
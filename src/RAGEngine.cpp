@@ -1,52 +1,77 @@
 /**
  * RAGEngine.cpp - Document indexing and retrieval engine
  * 
- * Handles document ingestion and chunking, embedding generation via Ollama,
- * vector similarity search, and document metadata management.
+ * Handles document ingestion and chunking, embedding generation through
+ * the configured EmbeddingProvider, vector similarity search, and document
+ * metadata management, optionally journaled so ingestion resumes after a
+ * restart.
  */
 
 #include "RAGEngine.h"
 #include "Logger.h"
 #include "Config.h"
+#include "EmbeddingProvider.h"
+#include "DocumentExtractor.h"
+#include "BulkFileReader.h"
 #include <QFile>
+#include <QBuffer>
 #include <QTextStream>
 #include <QDir>
 #include <QFileInfo>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QNetworkRequest>
-#include <QUrl>
 #include <QProcess>
+#include <QTimer>
+#include <QSet>
+#include <QDateTime>
+#include <algorithm>
 #include <cmath>
 
-// Conditionally include FAISS if available
-#ifdef HAVE_FAISS
-#include <faiss/IndexFlatL2.h>
-#else
-// Stub for when FAISS is not available
-namespace faiss {
-    struct IndexFlatL2 {
-        IndexFlatL2(int) {}
-        void add(int, const float*) {}
-        void search(int, const float*, int, float*, long*) {}
-    };
+// Distinct queries whose vector results are kept for reuse
+static const int CONTEXT_CACHE_SIZE = 64;
+
+// Files read concurrently ahead of the one being chunked
+static const int INGEST_READ_AHEAD = 16;
+
+// A query embedding past its deadline is still awaited for this many deadlines, then cancelled
+static const int LATE_QUERY_DEADLINES = 5;
+
+static QString chunkMetadata(const QString &text, int tokenCount) {
+    return QString("Length: %1 chars, %2 tokens").arg(text.length()).arg(tokenCount);
 }
-#endif
 
 RAGEngine::RAGEngine(QObject *parent)
     : QObject(parent)
     , m_embeddingModel("nomic-embed-text")  // Default Ollama embedding model
-    , m_apiUrl("http://localhost:11434/api/embeddings")
     , m_chunkSize(512)  // Characters per chunk
     , m_chunkOverlap(50)  // Overlap between chunks
+    , m_chunkTokens(0)  // Size by characters
     , m_embeddingDimension(768)  // Default for nomic-embed-text
-    , m_index(nullptr)
-    , m_networkManager(new QNetworkAccessManager(this)) {
+    , m_removedChunks(0)
+    , m_provider(nullptr)
+    , m_nextRequestId(1)
+    , m_retrievalDeadlineMs(0)
+    , m_documentCount(0)
+    , m_chunkCount(0)
+    , m_dimensionCount(768)
+    , m_pendingCount(0)
+    , m_indexMemory("rag_index") {
+
+    installProvider(EmbeddingProvider::create("ollama", this));
+    loadTokenizer();
+
+    // Under memory pressure the vectors move to a mapped file, then cached results go
+    MemoryGovernor &governor = MemoryGovernor::instance();
+    governor.addShedder(MemoryGovernor::Embeddings, this, [this]() {
+        m_index.spill();
+        publishStatistics();
+    });
+    governor.addShedder(MemoryGovernor::QueryCaches, this, [this]() {
+        clearContextCache();
+    });
 
     LOG_INFO("RAGEngine initialized");
     LOG_INFO(QString("Embedding model: %1").arg(m_embeddingModel));
     LOG_INFO(QString("Chunk size: %1 characters").arg(m_chunkSize));
+    LOG_INFO(QString("Tokenizer: %1").arg(m_tokenizer.name()));
 }
 
 RAGEngine::~RAGEngine() {
@@ -54,7 +79,16 @@ RAGEngine::~RAGEngine() {
 }
 
 void RAGEngine::setEmbeddingModel(const QString &modelName) {
+    bool changed = modelName != m_embeddingModel;
     m_embeddingModel = modelName;
+    m_provider->setModel(modelName);
+    if (changed) {
+        if (m_tokenizerPath.isEmpty()) {
+            loadTokenizer();
+        }
+        // Vectors from the previous model can't be compared with the new model's queries
+        reembedChunks();
+    }
     LOG_INFO(QString("Embedding model set to: %1").arg(modelName));
 }
 
@@ -68,12 +102,343 @@ void RAGEngine::setChunkOverlap(int overlap) {
     LOG_INFO(QString("Chunk overlap set to: %1").arg(overlap));
 }
 
+void RAGEngine::setChunkTokens(int tokens) {
+    m_chunkTokens = qMax(0, tokens);
+    LOG_INFO(QString("Chunk tokens set to: %1").arg(m_chunkTokens > 0 ? QString::number(m_chunkTokens)
+                                                                      : QString("off (chunk by characters)")));
+}
+
+void RAGEngine::setTokenizer(const QString &path) {
+    m_tokenizerPath = path;
+    loadTokenizer();
+}
+
+void RAGEngine::loadTokenizer() {
+    QString path = m_tokenizerPath.isEmpty() ? Tokenizer::defaultPath(m_embeddingModel) : m_tokenizerPath;
+    if (m_tokenizer.isExact() && m_tokenizer.name() == path) {
+        return;
+    }
+
+    QString previous = m_tokenizer.name();
+    if (m_tokenizerPath.isEmpty() && !QFileInfo::exists(path)) {
+        m_tokenizer.clear();
+    } else {
+        QString error;
+        if (!m_tokenizer.load(path, &error)) {
+            LOG_WARNING(QString("Token counts are estimated: %1").arg(error));
+            m_tokenizer.clear();
+        }
+    }
+
+    if (m_tokenizer.name() != previous) {
+        recountTokens();
+    }
+}
+
+void RAGEngine::recountTokens() {
+    m_tokenCounts.clear();
+    for (DocumentChunk &chunk : m_chunks) {
+        if (chunk.text.isEmpty()) {
+            continue;  // Removed
+        }
+        chunk.tokenCount = m_tokenizer.count(chunk.text);
+        chunk.metadata = chunkMetadata(chunk.text, chunk.tokenCount);
+        m_tokenCounts.insert(chunk.text, chunk.tokenCount);
+    }
+    if (!m_chunks.isEmpty()) {
+        LOG_INFO(QString("Recounted the tokens of %1 chunks with %2").arg(m_chunks.size()).arg(m_tokenizer.name()));
+    }
+}
+
+int RAGEngine::countTokens(const QString &text) const {
+    auto it = m_tokenCounts.constFind(text);
+    return it != m_tokenCounts.constEnd() ? it.value() : m_tokenizer.count(text);
+}
+
 void RAGEngine::setApiUrl(const QString &url) {
-    m_apiUrl = url;
+    m_provider->setUrl(url);
     LOG_INFO(QString("API URL set to: %1").arg(url));
 }
 
+QString RAGEngine::embeddingProvider() const {
+    return m_provider->type();
+}
+
+void RAGEngine::setEmbeddingProvider(const QString &type, const QString &url, const QString &apiKey) {
+    if (type == m_provider->type()) {
+        m_provider->setUrl(url);
+        m_provider->setApiKey(apiKey);
+        return;
+    }
+
+    EmbeddingProvider *provider = EmbeddingProvider::create(type, this);
+    provider->setModel(m_embeddingModel);
+    provider->setUrl(url);
+    provider->setApiKey(apiKey);
+    LOG_INFO(QString("Embedding provider set to: %1").arg(provider->type()));
+
+    // Calls in flight die with the old provider; waiting retrievals fall back now
+    QList<int> tickets = m_pendingQueries.keys();
+    for (int ticket : tickets) {
+        PendingQuery pending = m_pendingQueries.take(ticket);
+        if (pending.requestId > 0) {
+            m_queryTickets.remove(pending.requestId);
+        }
+        if (!pending.answered) {
+            emitDegradedContext(pending.requestId, pending.query, pending.topK, "embedding provider changed");
+        }
+    }
+    m_chunkTickets.clear();
+    m_pendingEmbeddings.clear();
+    delete m_provider;
+    installProvider(provider);
+
+    // Vectors from another model can't be compared with the new ones
+    reembedChunks();
+}
+
+void RAGEngine::setDimensionReduction(const QString &method, int dimensions) {
+    VectorIndex::Reduction reduction = dimensions > 0 ? VectorIndex::reductionFromString(method)
+                                                      : VectorIndex::NoReduction;
+    if (reduction == VectorIndex::NoReduction) {
+        dimensions = 0;
+    }
+    if (reduction == m_index.reduction() && dimensions == m_index.targetDimensions()) {
+        return;
+    }
+
+    LOG_INFO(QString("Embedding dimensions set to: %1")
+             .arg(dimensions > 0 ? QString("%1 (%2)").arg(dimensions).arg(VectorIndex::reductionName(reduction))
+                                 : QString("full width")));
+    m_index.configure(reduction, dimensions);
+
+    // Only reduced vectors are kept, so the index is rebuilt from the text
+    reembedChunks();
+}
+
+void RAGEngine::reembedChunks() {
+    for (auto it = m_chunkTickets.constBegin(); it != m_chunkTickets.constEnd(); ++it) {
+        m_provider->cancel(it.key());
+    }
+    m_chunkTickets.clear();
+    m_pendingEmbeddings.clear();
+    m_index.clear();
+    m_indexChunks.clear();
+    compactChunks();  // Nothing refers to chunk indices any more
+    clearContextCache();
+    restartJournal();
+
+    if (!m_chunks.isEmpty()) {
+        LOG_INFO(QString("Re-embedding %1 chunks with the %2 provider").arg(m_chunks.size()).arg(m_provider->type()));
+        QStringList texts;
+        texts.reserve(m_chunks.size());
+        for (const DocumentChunk &chunk : m_chunks) {
+            texts.append(chunk.text);
+        }
+        generateEmbeddings(0, texts);
+    }
+    publishStatistics();
+}
+
+void RAGEngine::installProvider(EmbeddingProvider *provider) {
+    m_provider = provider;
+    m_provider->setModel(m_embeddingModel);
+    connect(m_provider, &EmbeddingProvider::embeddingsReady, this, &RAGEngine::handleEmbeddingsReady);
+    connect(m_provider, &EmbeddingProvider::embeddingFailed, this, &RAGEngine::handleEmbeddingFailed);
+}
+
+void RAGEngine::setRetrievalDeadline(int ms) {
+    m_retrievalDeadlineMs = qMax(0, ms);
+    LOG_INFO(QString("Retrieval deadline set to: %1").arg(ms > 0 ? QString("%1 ms").arg(ms) : QString("none")));
+}
+
+bool RAGEngine::setIngestionJournal(const QString &path) {
+    if (path == m_journal.path()) {
+        return path.isEmpty() || m_journal.isOpen();
+    }
+
+    m_journal.close();
+    if (path.isEmpty()) {
+        LOG_INFO("Ingestion journal closed");
+        return true;
+    }
+
+    IngestionJournalContents contents;
+    QString error;
+    if (!m_journal.open(path, journalHeader(), contents, &error)) {
+        LOG_WARNING(QString("Ingestion is not journaled: %1").arg(error));
+        return false;
+    }
+
+    if (!m_chunks.isEmpty()) {
+        // Chunk indices of the journal would collide with the ones in memory; what is loaded wins
+        LOG_INFO(QString("Documents already loaded; ingestion journal %1 starts over from them").arg(path));
+        restartJournal();
+        return true;
+    }
+
+    replayJournal(contents);
+    return true;
+}
+
+QJsonObject RAGEngine::journalHeader() const {
+    QJsonObject header;
+    header["provider"] = m_provider->type();
+    header["model"] = m_embeddingModel;
+    return header;
+}
+
+void RAGEngine::replayJournal(const IngestionJournalContents &contents) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Documents come back in the order they were chunked, so the recorded chunk indices hold;
+    // a record that doesn't continue where the previous one ended is a duplicate or out of place
+    int skipped = contents.skippedRecords;
+    for (const IngestedDocument &document : contents.documents) {
+        if (document.firstChunk != m_chunks.size() || document.chunks.isEmpty()) {
+            skipped++;
+            continue;
+        }
+        // A version since re-chunked only holds its chunk indices
+        if (document.removed) {
+            for (int i = 0; i < document.chunks.size(); ++i) {
+                appendChunk(QString(), document.path, i, 0);
+            }
+            m_removedChunks += document.chunks.size();
+            continue;
+        }
+        // Counts from another tokenizer (or none recorded) are redone; the chunks themselves stand
+        bool counted = document.tokenizer == m_tokenizer.name()
+                       && document.tokenCounts.size() == document.chunks.size();
+        for (int i = 0; i < document.chunks.size(); ++i) {
+            const QString &text = document.chunks[i];
+            appendChunk(text, document.path, i, counted ? document.tokenCounts[i] : m_tokenizer.count(text));
+        }
+        m_documents[document.path] = document.chunks.size();
+        m_documentStamps[document.path] = qMakePair(document.size, document.modified);
+    }
+
+    // Committed vectors are reused only if the same provider and model would produce them again
+    QVector<bool> embedded(m_chunks.size(), false);
+    for (int i = 0; i < m_chunks.size(); ++i) {
+        embedded[i] = m_chunks[i].text.isEmpty();  // Removed chunks have nothing to embed
+    }
+    bool sameModel = contents.header["provider"].toString() == m_provider->type()
+                     && contents.header["model"].toString() == m_embeddingModel;
+    if (sameModel) {
+        for (const IngestedEmbeddings &record : contents.embeddings) {
+            const float *rows = m_journal.vectors(record);
+            if (!rows) {
+                skipped++;
+                continue;
+            }
+            QVector<float> vector(record.dimensions);
+            for (int i = 0; i < record.chunks.size(); ++i) {
+                int chunkIndex = record.chunks[i];
+                if (chunkIndex < 0 || chunkIndex >= m_chunks.size() || embedded[chunkIndex]) {
+                    continue;
+                }
+                const float *row = rows + static_cast<qint64>(i) * record.dimensions;
+                std::copy(row, row + record.dimensions, vector.begin());
+                embedded[chunkIndex] = addEmbeddingToIndex(vector, chunkIndex);
+            }
+        }
+    } else {
+        LOG_INFO(QString("Ingestion journal was written with %1/%2, now %3/%4; its chunks are embedded again")
+                 .arg(contents.header["provider"].toString(), contents.header["model"].toString(),
+                      m_provider->type(), m_embeddingModel));
+        restartJournal();
+    }
+
+    // Chunks whose embeddings never committed go out again, in runs of consecutive chunks
+    int pending = 0;
+    for (int first = 0; first < m_chunks.size(); ++first) {
+        if (embedded[first]) {
+            continue;
+        }
+        int end = first;
+        QStringList texts;
+        while (end < m_chunks.size() && !embedded[end]) {
+            texts.append(m_chunks[end++].text);
+        }
+        generateEmbeddings(first, texts);
+        pending += texts.size();
+        first = end;
+    }
+    publishStatistics();
+
+    if (skipped > 0) {
+        LOG_WARNING(QString("Ingestion journal %1: %2 records skipped").arg(m_journal.path()).arg(skipped));
+    }
+    int chunkCount = m_chunks.size() - m_removedChunks;
+    LOG_INFO(QString("Restored %1 documents, %2 chunks (%3 to embed) from the ingestion journal in %4 ms")
+             .arg(m_documents.size()).arg(chunkCount).arg(pending).arg(timer.elapsed()));
+    if (chunkCount > 0) {
+        emit ingestionResumed(m_documents.size(), chunkCount, pending);
+    }
+
+    // Directories interrupted mid-way continue once the caller has its result; finished files are skipped
+    QList<IngestedDirectory> directories = contents.directories;
+    if (!directories.isEmpty()) {
+        QTimer::singleShot(0, this, [this, directories]() {
+            for (const IngestedDirectory &directory : directories) {
+                LOG_INFO(QString("Resuming ingestion of %1").arg(directory.path));
+                int successCount = ingestFiles(directory.files);
+                m_journal.finishDirectory(directory.path);
+                LOG_INFO(QString("Resumed directory %1: %2/%3 files ingested")
+                         .arg(directory.path).arg(successCount).arg(directory.files.size()));
+            }
+        });
+    }
+}
+
+void RAGEngine::restartJournal() {
+    if (!m_journal.isOpen() || !m_journal.reset(journalHeader())) {
+        return;
+    }
+
+    // The chunks stay valid; only their vectors don't
+    IngestedDocument document;
+    for (int i = 0; i <= m_chunks.size(); ++i) {
+        bool boundary = i == m_chunks.size() || m_chunks[i].chunkIndex == 0
+                        || m_chunks[i].sourceFile != document.path;
+        if (boundary && !document.chunks.isEmpty()) {
+            QPair<qint64, qint64> stamp = m_documentStamps.value(document.path);
+            document.size = stamp.first;
+            document.modified = stamp.second;
+            m_journal.appendDocument(document);
+            if (document.chunks.first().isEmpty()) {
+                m_journal.appendRemoval(document.path);  // Keeps its chunk indices taken
+            }
+        }
+        if (i == m_chunks.size()) {
+            break;
+        }
+        if (boundary) {
+            document = IngestedDocument();
+            document.path = m_chunks[i].sourceFile;
+            document.firstChunk = i;
+            document.tokenizer = m_tokenizer.name();
+        }
+        document.chunks.append(m_chunks[i].text);
+        document.tokenCounts.append(m_chunks[i].tokenCount);
+    }
+}
+
 bool RAGEngine::ingestDocument(const QString &filePath) {
+    return ingestDocumentContent(filePath, nullptr);
+}
+
+QPair<qint64, qint64> RAGEngine::documentStamp(const QFileInfo &fileInfo) {
+    return QPair<qint64, qint64>(fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch());
+}
+
+bool RAGEngine::isUnchanged(const QString &filePath, const QPair<qint64, qint64> &stamp) const {
+    return m_documents.contains(filePath) && m_documentStamps.value(filePath) == stamp;
+}
+
+bool RAGEngine::ingestDocumentContent(const QString &filePath, const QByteArray *data) {
     QFileInfo fileInfo(filePath);
     if (!fileInfo.exists()) {
         QString error = QString("File does not exist: %1").arg(filePath);
@@ -82,19 +447,29 @@ bool RAGEngine::ingestDocument(const QString &filePath) {
         return false;
     }
 
+    // Already chunked and unchanged since: nothing to redo (a resumed directory, or ingesting it again)
+    QPair<qint64, qint64> stamp = documentStamp(fileInfo);
+    if (isUnchanged(filePath, stamp)) {
+        LOG_INFO(QString("Document unchanged since it was ingested, skipping: %1").arg(filePath));
+        emit documentIngested(filePath, m_documents.value(filePath));
+        return true;
+    }
+
     LOG_INFO(QString("Ingesting document: %1").arg(filePath));
 
     QString content;
     QString suffix = fileInfo.suffix().toLower();
 
     if (suffix == "txt") {
-        content = readTextFile(filePath);
+        content = readTextFile(filePath, data);
     } else if (suffix == "md" || suffix == "markdown") {
-        content = readMarkdownFile(filePath);
+        content = readMarkdownFile(filePath, data);
     } else if (suffix == "pdf") {
-        content = readPDFFile(filePath);
+        content = readPDFFile(filePath, data);
     } else if (suffix == "docx" || suffix == "doc") {
-        content = readDOCXFile(filePath);
+        content = readDOCXFile(filePath, data);
+    } else if (suffix == "odt") {
+        content = readODTFile(filePath, data);
     } else {
         QString error = QString("Unsupported file type: %1").arg(suffix);
         LOG_ERROR(error);
@@ -109,23 +484,115 @@ bool RAGEngine::ingestDocument(const QString &filePath) {
         return false;
     }
 
+    // A changed document replaces its previous chunks
+    if (m_documents.contains(filePath)) {
+        removeDocumentChunks(filePath);
+    }
+
     // Chunk the document
     QStringList chunks = chunkText(content, filePath);
     LOG_INFO(QString("Created %1 chunks from %2").arg(chunks.size()).arg(fileInfo.fileName()));
 
     // Store document metadata
     m_documents[filePath] = chunks.size();
+    m_documentStamps[filePath] = stamp;
+
+    // Committed before any embedding of its chunks can be
+    if (m_journal.isOpen()) {
+        IngestedDocument document;
+        document.path = filePath;
+        document.size = stamp.first;
+        document.modified = stamp.second;
+        document.firstChunk = m_chunks.size() - chunks.size();
+        document.chunks = chunks;
+        document.tokenizer = m_tokenizer.name();
+        for (int i = document.firstChunk; i < m_chunks.size(); ++i) {
+            document.tokenCounts.append(m_chunks[i].tokenCount);
+        }
+        m_journal.appendDocument(document);
+    }
 
-    // Generate embeddings for each chunk
+    // chunkText() has already appended the chunks
     for (int i = 0; i < chunks.size(); ++i) {
         emit ingestionProgress(i + 1, chunks.size());
-        generateEmbedding(chunks[i], m_chunks.size() + i);
     }
+    generateEmbeddings(m_chunks.size() - chunks.size(), chunks);
+    publishStatistics();
 
     emit documentIngested(filePath, chunks.size());
     return true;
 }
 
+void RAGEngine::removeDocumentChunks(const QString &filePath) {
+    QVector<bool> removed(m_chunks.size(), false);
+    int count = 0;
+    for (int i = 0; i < m_chunks.size(); ++i) {
+        DocumentChunk &chunk = m_chunks[i];
+        if (chunk.sourceFile != filePath || chunk.text.isEmpty()) {
+            continue;
+        }
+        for (const QString &term : lexicalTerms(chunk.text)) {
+            auto it = m_termIndex.find(term);
+            if (it != m_termIndex.end()) {
+                it.value().removeAll(i);
+                if (it.value().isEmpty()) {
+                    m_termIndex.erase(it);
+                }
+            }
+        }
+        // An embedding still in flight is dropped when it arrives
+        m_pendingEmbeddings.remove(i);
+        chunk.text.clear();
+        chunk.metadata.clear();
+        chunk.tokenCount = 0;
+        removed[i] = true;
+        count++;
+    }
+
+    QVector<int> positions;
+    QVector<int> indexChunks;
+    indexChunks.reserve(m_indexChunks.size());
+    for (int position = 0; position < m_indexChunks.size(); ++position) {
+        if (removed[m_indexChunks[position]]) {
+            positions.append(position);
+        } else {
+            indexChunks.append(m_indexChunks[position]);
+        }
+    }
+    m_index.remove(positions);
+    m_indexChunks = indexChunks;
+
+    m_removedChunks += count;
+    m_documents.remove(filePath);
+    m_documentStamps.remove(filePath);
+    clearContextCache();
+    if (m_journal.isOpen()) {
+        m_journal.appendRemoval(filePath);
+    }
+    LOG_INFO(QString("Removed %1 chunks and %2 vectors of the previous version of %3")
+             .arg(count).arg(positions.size()).arg(filePath));
+}
+
+void RAGEngine::compactChunks() {
+    if (m_removedChunks == 0) {
+        return;
+    }
+    QVector<DocumentChunk> live;
+    live.reserve(m_chunks.size() - m_removedChunks);
+    for (const DocumentChunk &chunk : m_chunks) {
+        if (!chunk.text.isEmpty()) {
+            live.append(chunk);
+        }
+    }
+    m_chunks = live;
+    m_removedChunks = 0;
+
+    m_termIndex.clear();
+    for (int i = 0; i < m_chunks.size(); ++i) {
+        indexChunkTerms(i);
+    }
+}
+
 bool RAGEngine::ingestDirectory(const QString &dirPath) {
     QDir dir(dirPath);
     if (!dir.exists()) {
@@ -134,65 +601,145 @@ bool RAGEngine::ingestDirectory(const QString &dirPath) {
     }
 
     QStringList filters;
-    filters << "*.txt" << "*.md" << "*.markdown" << "*.pdf" << "*.docx" << "*.doc";
+    filters << "*.txt" << "*.md" << "*.markdown" << "*.pdf" << "*.docx" << "*.doc" << "*.odt";
     QFileInfoList files = dir.entryInfoList(filters, QDir::Files);
 
     LOG_INFO(QString("Ingesting %1 files from directory: %2").arg(files.size()).arg(dirPath));
 
-    int successCount = 0;
+    QStringList paths;
     for (const QFileInfo &fileInfo : files) {
-        if (ingestDocument(fileInfo.absoluteFilePath())) {
-            successCount++;
-        }
+        paths.append(fileInfo.absoluteFilePath());
+    }
+
+    // Recorded up front, so a restart knows which files were still to come
+    if (m_journal.isOpen()) {
+        m_journal.appendDirectory(dirPath, paths);
+    }
+    int successCount = ingestFiles(paths);
+    if (m_journal.isOpen()) {
+        m_journal.finishDirectory(dirPath);
     }
 
     LOG_INFO(QString("Successfully ingested %1/%2 files").arg(successCount).arg(files.size()));
     return successCount > 0;
 }
 
+int RAGEngine::ingestFiles(const QStringList &files) {
+    // Unchanged files are skipped without being read
+    QStringList toRead;
+    for (const QString &file : files) {
+        if (!isUnchanged(file, documentStamp(QFileInfo(file)))) {
+            toRead.append(file);
+        }
+    }
+
+    // The next files are read while this one is chunked; on NFS or a slow
+    // disk that overlaps their latency instead of paying it file by file
+    BulkFileReader reader(INGEST_READ_AHEAD);
+    reader.start(toRead);
+    LOG_DEBUG(QString("Reading %1 files ahead with %2").arg(toRead.size())
+              .arg(BulkFileReader::backendName(reader.backend())));
+
+    int successCount = 0;
+    int readIndex = 0;
+    for (const QString &file : files) {
+        bool ok;
+        BulkFileResult read;
+        if (readIndex < toRead.size() && toRead[readIndex] == file && reader.next(read)) {
+            readIndex++;
+            // A failed read goes the usual way, which reports the error
+            ok = ingestDocumentContent(file, read.ok() ? &read.data : nullptr);
+        } else {
+            ok = ingestDocument(file);
+        }
+        if (ok) {
+            successCount++;
+        }
+    }
+    return successCount;
+}
+
 void RAGEngine::clearDocuments() {
     LOG_INFO("Clearing all documents and embeddings");
     m_chunks.clear();
-    m_embeddings.clear();
+    m_removedChunks = 0;
+    m_index.clear();
+    m_indexChunks.clear();
     m_documents.clear();
+    m_documentStamps.clear();
+    m_tokenCounts.clear();
     m_pendingEmbeddings.clear();
 
-    // Reset FAISS index
-    if (m_index) {
-        m_index.reset(new faiss::IndexFlatL2(m_embeddingDimension));
+    // Their chunk indices are about to be reused by the next document
+    for (auto it = m_chunkTickets.constBegin(); it != m_chunkTickets.constEnd(); ++it) {
+        m_provider->cancel(it.key());
     }
+    m_chunkTickets.clear();
+    m_termIndex.clear();
+    clearContextCache();
+    if (m_journal.isOpen()) {
+        m_journal.reset(journalHeader());
+    }
+    publishStatistics();
 }
 
-QString RAGEngine::readTextFile(const QString &filePath) {
+void RAGEngine::publishStatistics() {
+    m_documentCount = m_documents.size();
+    m_chunkCount = m_chunks.size() - m_removedChunks;
+    m_dimensionCount = m_embeddingDimension;
+    m_pendingCount = m_pendingEmbeddings.size();
+    m_indexMemory.set(m_index.memoryBytes());
+}
+
+QString RAGEngine::readTextFile(const QString &filePath, const QByteArray *data) {
+    // Decoded the same way whether read here or by BulkFileReader
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QBuffer buffer;
+    QIODevice *device = &file;
+    if (data) {
+        buffer.setData(*data);
+        device = &buffer;
+    }
+    if (!device->open(QIODevice::ReadOnly | QIODevice::Text)) {
         LOG_ERROR(QString("Failed to open file: %1").arg(filePath));
         return QString();
     }
 
-    QTextStream in(&file);
+    QTextStream in(device);
     in.setCodec("UTF-8");
     QString content = in.readAll();
-    file.close();
+    device->close();
 
     LOG_DEBUG(QString("Read %1 characters from %2").arg(content.length()).arg(filePath));
     return content;
 }
 
-QString RAGEngine::readMarkdownFile(const QString &filePath) {
+QString RAGEngine::readMarkdownFile(const QString &filePath, const QByteArray *data) {
     // For now, treat markdown files as plain text
     // TODO: Strip markdown formatting if desired
-    return readTextFile(filePath);
+    return readTextFile(filePath, data);
 }
 
-QString RAGEngine::readPDFFile(const QString &filePath) {
+QString RAGEngine::readPDFFile(const QString &filePath, const QByteArray *data) {
     LOG_INFO(QString("Extracting text from PDF: %1").arg(filePath));
 
-    // Use pdftotext command-line tool to extract text
-    QStringList args;
-    args << filePath << "-";  // "-" means output to stdout
+    QString content;
+    if (DocumentExtractor::canReadPdf()) {
+        QString error;
+        content = data ? DocumentExtractor::extractPdfData(*data, &error)
+                       : DocumentExtractor::extractPdf(filePath, &error);
+        if (content.isEmpty()) {
+            LOG_WARNING(QString("In-process PDF extraction failed for %1 (%2), trying pdftotext")
+                        .arg(filePath, error.isEmpty() ? QString("no text") : error));
+        }
+    }
 
-    QString content = runCommandLineExtractor("pdftotext", args, filePath);
+    if (content.isEmpty()) {
+        // Use pdftotext command-line tool to extract text
+        QStringList args;
+        args << filePath << "-";  // "-" means output to stdout
+        content = runCommandLineExtractor("pdftotext", args, filePath);
+    }
 
     if (!content.isEmpty()) {
         LOG_DEBUG(QString("Extracted %1 characters from PDF").arg(content.length()));
@@ -203,14 +750,27 @@ QString RAGEngine::readPDFFile(const QString &filePath) {
     return content;
 }
 
-QString RAGEngine::readDOCXFile(const QString &filePath) {
+QString RAGEngine::readDOCXFile(const QString &filePath, const QByteArray *data) {
     LOG_INFO(QString("Extracting text from DOCX: %1").arg(filePath));
 
-    // Use docx2txt command-line tool to extract text (outputs to stdout by default)
-    QStringList args;
-    args << filePath;
+    // Legacy binary .doc files aren't ZIP packages: straight to the tool
+    QString content;
+    if (QFileInfo(filePath).suffix().compare("doc", Qt::CaseInsensitive) != 0) {
+        QString error;
+        content = data ? DocumentExtractor::extractDocxData(*data, &error)
+                       : DocumentExtractor::extractDocx(filePath, &error);
+        if (content.isEmpty()) {
+            LOG_WARNING(QString("In-process DOCX extraction failed for %1 (%2), trying docx2txt")
+                        .arg(filePath, error.isEmpty() ? QString("no text") : error));
+        }
+    }
 
-    QString content = runCommandLineExtractor("docx2txt", args, filePath);
+    if (content.isEmpty()) {
+        // Use docx2txt command-line tool to extract text (outputs to stdout by default)
+        QStringList args;
+        args << filePath;
+        content = runCommandLineExtractor("docx2txt", args, filePath);
+    }
 
     if (!content.isEmpty()) {
         LOG_DEBUG(QString("Extracted %1 characters from DOCX").arg(content.length()));
@@ -221,6 +781,29 @@ QString RAGEngine::readDOCXFile(const QString &filePath) {
     return content;
 }
 
+QString RAGEngine::readODTFile(const QString &filePath, const QByteArray *data) {
+    LOG_INFO(QString("Extracting text from ODT: %1").arg(filePath));
+
+    QString error;
+    QString content = data ? DocumentExtractor::extractOdtData(*data, &error)
+                           : DocumentExtractor::extractOdt(filePath, &error);
+    if (content.isEmpty()) {
+        LOG_WARNING(QString("In-process ODT extraction failed for %1 (%2), trying odt2txt")
+                    .arg(filePath, error.isEmpty() ? QString("no text") : error));
+        QStringList args;
+        args << filePath;
+        content = runCommandLineExtractor("odt2txt", args, filePath);
+    }
+
+    if (!content.isEmpty()) {
+        LOG_DEBUG(QString("Extracted %1 characters from ODT").arg(content.length()));
+    } else {
+        LOG_WARNING(QString("No content extracted from ODT: %1").arg(filePath));
+    }
+
+    return content;
+}
+
 QString RAGEngine::runCommandLineExtractor(const QString &command, const QStringList &args, const QString &filePath) {
     QProcess process;
     process.start(command, args);
@@ -249,7 +832,26 @@ QString RAGEngine::runCommandLineExtractor(const QString &command, const QString
     return content.trimmed();
 }
 
+void RAGEngine::appendChunk(const QString &text, const QString &sourceFile, int chunkIndex, int tokenCount) {
+    DocumentChunk chunk;
+    chunk.text = text;
+    chunk.sourceFile = sourceFile;
+    chunk.chunkIndex = chunkIndex;
+    chunk.metadata = chunkMetadata(text, tokenCount);
+    chunk.tokenCount = tokenCount;
+
+    m_chunks.append(chunk);
+    if (!text.isEmpty()) {
+        m_tokenCounts.insert(text, tokenCount);
+    }
+    indexChunkTerms(m_chunks.size() - 1);
+}
+
 QStringList RAGEngine::chunkText(const QString &text, const QString &sourceFile) {
+    if (m_chunkTokens > 0) {
+        return chunkTextByTokens(text, sourceFile);
+    }
+
     QStringList chunks;
 
     int textLength = text.length();
@@ -279,14 +881,7 @@ QStringList RAGEngine::chunkText(const QString &text, const QString &sourceFile)
         QString chunk = text.mid(position, chunkEnd - position).trimmed();
 
         if (!chunk.isEmpty()) {
-            // Create document chunk structure
-            DocumentChunk docChunk;
-            docChunk.text = chunk;
-            docChunk.sourceFile = sourceFile;
-            docChunk.chunkIndex = chunkIndex++;
-            docChunk.metadata = QString("Length: %1 chars").arg(chunk.length());
-
-            m_chunks.append(docChunk);
+            appendChunk(chunk, sourceFile, chunkIndex++, m_tokenizer.count(chunk));
             chunks.append(chunk);
         }
 
@@ -295,97 +890,189 @@ QStringList RAGEngine::chunkText(const QString &text, const QString &sourceFile)
         if (position < 0) position = chunkEnd;
     }
 
+    publishStatistics();
     LOG_DEBUG(QString("Chunked text into %1 chunks").arg(chunks.size()));
     return chunks;
 }
 
-void RAGEngine::generateEmbedding(const QString &text, int chunkIndex) {
-    // Build request body
-    QJsonObject requestBody;
-    requestBody["model"] = m_embeddingModel;
-    requestBody["prompt"] = text;
+QStringList RAGEngine::chunkTextByTokens(const QString &text, const QString &sourceFile) {
+    // Words no chunk could hold (URLs, encoded blobs, unspaced tables) are cut into pieces that fit:
+    // a piece of n characters is at most n tokens. Side by side, pieces are one word again and may
+    // tokenize to more than their counts added up, so two pieces of a word never share a chunk.
+    QVector<TokenSpan> words;
+    QVector<bool> continuesWord;  // Per entry of words: a piece after the first of a split word
+    for (const TokenSpan &word : m_tokenizer.words(text)) {
+        if (word.tokens <= m_chunkTokens) {
+            words.append(word);
+            continuesWord.append(false);
+            continue;
+        }
+        int wordEnd = word.start + word.length;
+        for (int start = word.start; start < wordEnd;) {
+            int length = qMin(m_chunkTokens, wordEnd - start);
+            if (length > 1 && text[start + length - 1].isHighSurrogate()) {
+                length--;
+            }
+            continuesWord.append(start > word.start);
+            words.append(TokenSpan{start, length, m_tokenizer.count(text.mid(start, length))});
+            start += length;
+        }
+    }
 
-    QJsonDocument doc(requestBody);
-    QByteArray data = doc.toJson();
+    auto endsSentence = [&text](const TokenSpan &word) {
+        int after = word.start + 1;
+        return word.length == 1 && QString(".!?").contains(text[word.start])
+               && (after == text.length() || text[after].isSpace());
+    };
 
-    // Create network request (use temporary QUrl to avoid vexing parse)
-    QUrl url(m_apiUrl);
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QStringList chunks;
+    int chunkIndex = 0;
+    int first = 0;
+    while (first < words.size()) {
+        // As many words as the budget holds, remembering the last sentence end
+        int end = first;
+        int tokens = 0;
+        int sentenceEnd = -1;
+        int sentenceTokens = 0;
+        while (end < words.size() && tokens + words[end].tokens <= m_chunkTokens
+               && !(end > first && continuesWord[end])) {
+            tokens += words[end++].tokens;
+            if (endsSentence(words[end - 1])) {
+                sentenceEnd = end;
+                sentenceTokens = tokens;
+            }
+        }
+        if (end == first) {
+            end = first + 1;  // Can't happen after the split above, but never stall
+        }
 
-    // Store pending embedding
-    m_pendingEmbeddings[chunkIndex] = text;
+        // Prefer ending on a sentence when that gives up at most a quarter of the budget
+        if (end < words.size() && sentenceEnd > first && sentenceTokens >= m_chunkTokens - m_chunkTokens / 4) {
+            end = sentenceEnd;
+        }
 
-    // Send request
-    QNetworkReply *reply = m_networkManager->post(request, data);
+        int start = words[first].start;
+        QString chunk = text.mid(start, words[end - 1].start + words[end - 1].length - start);
+        appendChunk(chunk, sourceFile, chunkIndex++, m_tokenizer.count(chunk));
+        chunks.append(chunk);
 
-    // Connect reply to handler
-    connect(reply, &QNetworkReply::finished, this, [this, reply, chunkIndex]() {
-        handleEmbeddingResponse(reply, chunkIndex);
-    });
+        if (end == words.size()) {
+            break;
+        }
 
-    LOG_DEBUG(QString("Generating embedding for chunk %1").arg(chunkIndex));
+        // Carry whole words totalling at most the overlap in characters, always moving forward;
+        // nothing when the chunk ended inside a split word, whose next piece must start alone
+        int next = end;
+        int chunkEnd = words[end - 1].start + words[end - 1].length;
+        while (!continuesWord[end] && next - 1 > first && chunkEnd - words[next - 1].start <= m_chunkOverlap) {
+            next--;
+        }
+        first = next;
+    }
+
+    publishStatistics();
+    LOG_DEBUG(QString("Chunked text into %1 chunks of at most %2 tokens").arg(chunks.size()).arg(m_chunkTokens));
+    return chunks;
 }
 
-void RAGEngine::handleEmbeddingResponse(QNetworkReply *reply, int chunkIndex) {
-    reply->deleteLater();
+void RAGEngine::generateEmbeddings(int firstChunk, const QStringList &texts) {
+    int batchSize = qMax(1, m_provider->maxBatchSize());
+    for (int offset = 0; offset < texts.size(); offset += batchSize) {
+        QStringList batch = texts.mid(offset, batchSize);
+        for (int i = 0; i < batch.size(); ++i) {
+            m_pendingEmbeddings[firstChunk + offset + i] = batch[i];
+        }
+        int ticket = m_provider->embed(batch);
+        m_chunkTickets.insert(ticket, qMakePair(firstChunk + offset, batch.size()));
+        LOG_DEBUG(QString("Generating embeddings for chunks %1-%2")
+                  .arg(firstChunk + offset).arg(firstChunk + offset + batch.size() - 1));
+    }
+}
 
-    if (reply->error() != QNetworkReply::NoError) {
-        LOG_ERROR(QString("Embedding generation failed for chunk %1: %2")
-                  .arg(chunkIndex).arg(reply->errorString()));
-        m_pendingEmbeddings.remove(chunkIndex);
+void RAGEngine::handleEmbeddingsReady(int ticket, const QVector<QVector<float>> &vectors) {
+    if (m_pendingQueries.contains(ticket)) {
+        QVector<float> queryEmbedding = vectors.value(0);
+        if (!m_index.isEmpty() && queryEmbedding.size() != m_embeddingDimension) {
+            handleQueryEmbeddingFailed(ticket, QString("query embedding has %1 dimensions, the index has %2")
+                                               .arg(queryEmbedding.size()).arg(m_embeddingDimension));
+        } else {
+            handleQueryEmbedding(ticket, queryEmbedding);
+        }
         return;
     }
 
-    // Parse response
-    QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject obj = doc.object();
+    auto it = m_chunkTickets.find(ticket);
+    if (it == m_chunkTickets.end()) {
+        return;
+    }
+    int firstChunk = it.value().first;
+    m_chunkTickets.erase(it);
+
+    QVector<int> committed;
+    QVector<QVector<float>> committedVectors;
+    for (int i = 0; i < vectors.size(); ++i) {
+        int chunkIndex = firstChunk + i;
+        if (!m_pendingEmbeddings.contains(chunkIndex)) {
+            continue;
+        }
 
-    if (!obj.contains("embedding")) {
-        LOG_ERROR(QString("Invalid embedding response for chunk %1").arg(chunkIndex));
+        if (addEmbeddingToIndex(vectors[i], chunkIndex) && m_journal.isOpen()) {
+            committed.append(chunkIndex);
+            committedVectors.append(vectors[i]);
+        }
         m_pendingEmbeddings.remove(chunkIndex);
-        return;
+        emit embeddingGenerated(chunkIndex);
+    }
+    if (!committed.isEmpty()) {
+        m_journal.appendEmbeddings(committed, committedVectors);
     }
+    publishStatistics();
 
-    // Extract embedding vector
-    QJsonArray embeddingArray = obj["embedding"].toArray();
-    QVector<float> embedding;
-    embedding.reserve(embeddingArray.size());
+    LOG_DEBUG(QString("Generated %1 embeddings from chunk %2 (dim: %3)")
+              .arg(vectors.size()).arg(firstChunk).arg(vectors.value(0).size()));
+}
 
-    for (const QJsonValue &val : embeddingArray) {
-        embedding.append(val.toDouble());
+void RAGEngine::handleEmbeddingFailed(int ticket, const QString &error) {
+    if (m_pendingQueries.contains(ticket)) {
+        handleQueryEmbeddingFailed(ticket, error);
+        return;
     }
 
-    // Initialize FAISS index if needed
-    if (!m_index) {
-        m_embeddingDimension = embedding.size();
-        m_index.reset(new faiss::IndexFlatL2(m_embeddingDimension));
-        LOG_INFO(QString("Initialized FAISS index with dimension %1").arg(m_embeddingDimension));
+    auto it = m_chunkTickets.find(ticket);
+    if (it == m_chunkTickets.end()) {
+        return;
     }
+    int firstChunk = it.value().first;
+    int count = it.value().second;
+    m_chunkTickets.erase(it);
 
-    // Store embedding and add to index
-    addEmbeddingToIndex(embedding, chunkIndex);
-    m_pendingEmbeddings.remove(chunkIndex);
-
-    emit embeddingGenerated(chunkIndex);
-    LOG_DEBUG(QString("Generated embedding for chunk %1 (dim: %2)")
-              .arg(chunkIndex).arg(embedding.size()));
+    // The batch's chunks stay searchable lexically, just not by vector
+    for (int chunkIndex = firstChunk; chunkIndex < firstChunk + count; ++chunkIndex) {
+        m_pendingEmbeddings.remove(chunkIndex);
+    }
+    LOG_ERROR(QString("Embedding generation failed for chunks %1-%2: %3")
+              .arg(firstChunk).arg(firstChunk + count - 1).arg(error));
+    publishStatistics();
 }
 
-void RAGEngine::addEmbeddingToIndex(const QVector<float> &embedding, int chunkIndex) {
-    // Ensure we have enough space in embeddings vector
-    if (chunkIndex >= m_embeddings.size()) {
-        m_embeddings.resize(chunkIndex + 1);
+bool RAGEngine::addEmbeddingToIndex(const QVector<float> &embedding, int chunkIndex) {
+    bool first = m_index.isEmpty();
+    if (m_index.add(embedding) < 0) {
+        LOG_ERROR(QString("Embedding for chunk %1 has %2 dimensions, the index has %3; not indexed")
+                  .arg(chunkIndex).arg(embedding.size()).arg(m_index.inputDimensions()));
+        return false;
     }
+    m_indexChunks.append(chunkIndex);
 
-    // Store embedding
-    m_embeddings[chunkIndex] = embedding;
-
-    // Add to FAISS index
-    if (m_index) {
-        m_index->add(1, embedding.constData());
+    if (first) {
+        m_embeddingDimension = m_index.inputDimensions();
+        LOG_INFO(QString("Initialized vector index: %1 dimensions, %2 stored")
+                 .arg(m_embeddingDimension).arg(m_index.dimensions()));
     }
+
+    // Earlier results may no longer be the nearest chunks
+    clearContextCache();
+    return true;
 }
 
 QStringList RAGEngine::retrieveContext(const QString &query, int topK) {
@@ -395,7 +1082,7 @@ QStringList RAGEngine::retrieveContext(const QString &query, int topK) {
         return QStringList();
     }
 
-    if (m_embeddings.isEmpty()) {
+    if (m_index.isEmpty()) {
         LOG_WARNING("No embeddings available yet - documents may still be processing");
         emit queryError("Embeddings not ready yet");
         return QStringList();
@@ -404,92 +1091,248 @@ QStringList RAGEngine::retrieveContext(const QString &query, int topK) {
     LOG_INFO(QString("Retrieving top %1 contexts for query").arg(topK));
 
     // Generate embedding for query asynchronously
-    generateQueryEmbedding(query, topK);
+    if (!deliverCachedContext(query, topK, 0)) {
+        generateQueryEmbedding(query, topK, 0);
+    }
 
     // Return empty list immediately - results will come via contextRetrieved signal
     return QStringList();
 }
 
-QVector<int> RAGEngine::searchSimilar(const QVector<float> &queryEmbedding, int topK) {
-    QVector<int> results;
+int RAGEngine::requestContext(const QString &query, int topK) {
+    int requestId = m_nextRequestId++;
+
+    if (m_chunks.isEmpty() || m_index.isEmpty()) {
+        QString error = m_chunks.isEmpty() ? "No documents ingested yet" : "Embeddings not ready yet";
+        LOG_WARNING(QString("Retrieval request %1: %2").arg(requestId).arg(error));
+        // Deliver asynchronously so the caller can record the ID first
+        QTimer::singleShot(0, this, [this, requestId, error]() {
+            emit contextFailed(requestId, error);
+        });
+        return requestId;
+    }
+
+    LOG_INFO(QString("Retrieval request %1: top %2 contexts").arg(requestId).arg(topK));
+    if (!deliverCachedContext(query, topK, requestId)) {
+        generateQueryEmbedding(query, topK, requestId);
+    }
+    return requestId;
+}
+
+void RAGEngine::cancelRequest(int requestId) {
+    int ticket = m_queryTickets.take(requestId);
+    if (ticket > 0) {
+        LOG_DEBUG(QString("Retrieval request %1 cancelled").arg(requestId));
+        m_pendingQueries.remove(ticket);
+        m_provider->cancel(ticket);
+    }
+}
 
-    if (!m_index || m_embeddings.isEmpty()) {
-        return results;
+void RAGEngine::emitContext(int requestId, const QStringList &contexts) {
+    if (requestId > 0) {
+        emit contextReady(requestId, contexts);
+    } else {
+        emit contextRetrieved(contexts);
+    }
+}
+
+void RAGEngine::emitDegradedContext(int requestId, const QString &query, int topK, const QString &reason) {
+    QStringList contexts;
+    for (int idx : searchLexical(query, topK)) {
+        contexts.append(m_chunks[idx].text);
     }
 
-    // Prepare result buffers
-    QVector<float> distances(topK);
-    QVector<long> indices(topK);
+    LOG_WARNING(QString("Retrieval %1: %2 - using %3")
+                .arg(requestId).arg(reason)
+                .arg(contexts.isEmpty() ? QString("no context") : QString("%1 lexical matches").arg(contexts.size())));
+    emit retrievalDegraded(requestId, reason);
+    emitContext(requestId, contexts);
+}
+
+bool RAGEngine::deliverCachedContext(const QString &query, int topK, int requestId) {
+    QString key = QString("%1\n%2").arg(topK).arg(query.simplified().toLower());
+    auto it = m_contextCache.constFind(key);
+    if (it == m_contextCache.constEnd()) {
+        return false;
+    }
 
-    // Perform FAISS search
-    m_index->search(1, queryEmbedding.constData(), topK,
-                    distances.data(), indices.data());
+    LOG_INFO(QString("Retrieval %1: reusing cached result").arg(requestId));
+    QStringList contexts = it.value();
+    // Asynchronous like a network result, so the caller can record the ID first
+    QTimer::singleShot(0, this, [this, requestId, contexts]() {
+        emitContext(requestId, contexts);
+    });
+    return true;
+}
 
-    // Convert indices to QVector<int>
-    for (int i = 0; i < topK; ++i) {
-        if (indices[i] >= 0 && indices[i] < m_chunks.size()) {
-            results.append(static_cast<int>(indices[i]));
+void RAGEngine::cacheContext(const QString &query, int topK, const QStringList &contexts) {
+    QString key = QString("%1\n%2").arg(topK).arg(query.simplified().toLower());
+    if (!m_contextCache.contains(key)) {
+        m_contextCacheOrder.append(key);
+        if (m_contextCacheOrder.size() > CONTEXT_CACHE_SIZE) {
+            m_contextCache.remove(m_contextCacheOrder.takeFirst());
         }
     }
+    m_contextCache.insert(key, contexts);
+}
 
-    return results;
+void RAGEngine::clearContextCache() {
+    m_contextCache.clear();
+    m_contextCacheOrder.clear();
 }
 
-void RAGEngine::generateQueryEmbedding(const QString &query, int topK) {
-    // Build request body
-    QJsonObject requestBody;
-    requestBody["model"] = m_embeddingModel;
-    requestBody["prompt"] = query;
+QStringList RAGEngine::lexicalTerms(const QString &text) {
+    // Too common to say anything about a chunk
+    static const QSet<QString> stopWords{
+        "the", "and", "for", "are", "was", "were", "with", "that", "this", "from",
+        "what", "which", "who", "how", "why", "when", "where", "does", "can", "you",
+        "your", "about", "into", "have", "has", "had", "not", "but", "all", "any"
+    };
 
-    QJsonDocument doc(requestBody);
-    QByteArray data = doc.toJson();
+    QStringList terms;
+    QString word;
+    for (int i = 0; i <= text.size(); ++i) {
+        QChar c = i < text.size() ? text[i] : QChar(' ');
+        if (c.isLetterOrNumber()) {
+            word += c.toLower();
+        } else if (!word.isEmpty()) {
+            if (word.size() >= 3 && !stopWords.contains(word) && !terms.contains(word)) {
+                terms.append(word);
+            }
+            word.clear();
+        }
+    }
+    return terms;
+}
 
-    // Create network request
-    QUrl url(m_apiUrl);
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+void RAGEngine::indexChunkTerms(int chunkIndex) {
+    for (const QString &term : lexicalTerms(m_chunks[chunkIndex].text)) {
+        m_termIndex[term].append(chunkIndex);
+    }
+}
 
-    // Send request
-    QNetworkReply *reply = m_networkManager->post(request, data);
+QVector<int> RAGEngine::searchLexical(const QString &query, int topK) const {
+    // Sum of inverse document frequencies of the query terms each chunk contains
+    QHash<int, double> scores;
+    double chunkCount = m_chunks.size() - m_removedChunks;
+    for (const QString &term : lexicalTerms(query)) {
+        auto it = m_termIndex.constFind(term);
+        if (it == m_termIndex.constEnd()) {
+            continue;
+        }
+        double idf = std::log(1.0 + chunkCount / it.value().size());
+        for (int chunk : it.value()) {
+            scores[chunk] += idf;
+        }
+    }
 
-    // Connect reply to handler
-    connect(reply, &QNetworkReply::finished, this, [this, reply, topK]() {
-        handleQueryEmbeddingResponse(reply, topK);
+    QVector<int> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        ranked.append(it.key());
+    }
+    std::sort(ranked.begin(), ranked.end(), [&scores](int a, int b) {
+        double scoreA = scores.value(a);
+        double scoreB = scores.value(b);
+        return scoreA != scoreB ? scoreA > scoreB : a < b;
     });
+    if (ranked.size() > topK) {
+        ranked.resize(topK);
+    }
+    return ranked;
+}
 
-    LOG_DEBUG(QString("Generating query embedding with topK=%1").arg(topK));
+QVector<int> RAGEngine::searchSimilar(const QVector<float> &queryEmbedding, int topK) {
+    QVector<int> results;
+
+    // Index positions follow arrival order, not chunk order
+    for (int position : m_index.search(queryEmbedding, topK)) {
+        results.append(m_indexChunks[position]);
+    }
+
+    return results;
 }
 
-void RAGEngine::handleQueryEmbeddingResponse(QNetworkReply *reply, int topK) {
-    reply->deleteLater();
+void RAGEngine::generateQueryEmbedding(const QString &query, int topK, int requestId) {
+    int ticket = m_provider->embed(QStringList{query});
+    if (requestId > 0) {
+        m_queryTickets.insert(requestId, ticket);
+    }
 
-    if (reply->error() != QNetworkReply::NoError) {
-        QString errorMsg = QString("Query embedding generation failed: %1").arg(reply->errorString());
-        LOG_ERROR(errorMsg);
-        emit queryError(errorMsg);
+    PendingQuery pending;
+    pending.query = query;
+    pending.topK = topK;
+    pending.requestId = requestId;
+    pending.timer.start();
+    pending.answered = false;
+    m_pendingQueries.insert(ticket, pending);
+
+    // Bound the wait; a no-op if the embedding has arrived by then
+    if (m_retrievalDeadlineMs > 0) {
+        QTimer::singleShot(m_retrievalDeadlineMs, this, [this, ticket]() {
+            handleQueryDeadline(ticket);
+        });
+    }
+
+    LOG_DEBUG(QString("Generating query embedding with topK=%1").arg(topK));
+}
+
+void RAGEngine::handleQueryDeadline(int ticket) {
+    auto it = m_pendingQueries.find(ticket);
+    if (it == m_pendingQueries.end() || it->answered) {
         return;
     }
 
-    // Parse response
-    QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject obj = doc.object();
+    // The embedding is left running: its result is logged and cached when it lands
+    it->answered = true;
+    emitDegradedContext(it->requestId, it->query, it->topK,
+                        QString("no query embedding within the %1 ms deadline").arg(m_retrievalDeadlineMs));
 
-    if (!obj.contains("embedding")) {
-        QString errorMsg = "Invalid query embedding response";
-        LOG_ERROR(errorMsg);
-        emit queryError(errorMsg);
+    // ...but not forever: a hung server would otherwise keep one call and its entry per turn
+    QTimer::singleShot(LATE_QUERY_DEADLINES * m_retrievalDeadlineMs, this, [this, ticket]() {
+        abandonLateQuery(ticket);
+    });
+}
+
+void RAGEngine::abandonLateQuery(int ticket) {
+    auto it = m_pendingQueries.find(ticket);
+    if (it == m_pendingQueries.end() || !it->answered) {
         return;
     }
+    LOG_WARNING(QString("Retrieval %1: no query embedding after %2 ms; cancelled")
+                .arg(it->requestId).arg(it->timer.elapsed()));
+    int requestId = it->requestId;
+    if (requestId > 0) {
+        m_queryTickets.remove(requestId);
+    }
+    m_pendingQueries.erase(it);
+    m_provider->cancel(ticket);
+    emit lateRetrievalFinished(requestId, false);
+}
 
-    // Extract embedding vector
-    QJsonArray embeddingArray = obj["embedding"].toArray();
-    QVector<float> queryEmbedding;
-    queryEmbedding.reserve(embeddingArray.size());
+void RAGEngine::handleQueryEmbeddingFailed(int ticket, const QString &error) {
+    PendingQuery pending = m_pendingQueries.take(ticket);
+    if (pending.requestId > 0) {
+        m_queryTickets.remove(pending.requestId);
+    }
+
+    QString errorMsg = QString("Query embedding generation failed: %1").arg(error);
+    LOG_ERROR(errorMsg);
+    if (!pending.answered) {
+        emitDegradedContext(pending.requestId, pending.query, pending.topK, errorMsg);
+    } else {
+        emit lateRetrievalFinished(pending.requestId, false);
+    }
+}
 
-    for (const QJsonValue &val : embeddingArray) {
-        queryEmbedding.append(val.toDouble());
+void RAGEngine::handleQueryEmbedding(int ticket, const QVector<float> &queryEmbedding) {
+    PendingQuery pending = m_pendingQueries.take(ticket);
+    if (pending.requestId > 0) {
+        m_queryTickets.remove(pending.requestId);
     }
+    int requestId = pending.requestId;
+    int topK = pending.topK;
+    qint64 elapsedMs = pending.timer.elapsed();
 
     LOG_DEBUG(QString("Query embedding generated (dim: %1)").arg(queryEmbedding.size()));
 
@@ -506,7 +1349,16 @@ void RAGEngine::handleQueryEmbeddingResponse(QNetworkReply *reply, int topK) {
                       .arg(m_chunks[idx].sourceFile));
         }
     }
+    cacheContext(pending.query, topK, contexts);
+
+    if (pending.answered) {
+        // Worth knowing when tuning the deadline; the asker has moved on
+        LOG_INFO(QString("Retrieval %1: vector result arrived after %2 ms, past the %3 ms deadline; cached, not delivered")
+                 .arg(requestId).arg(elapsedMs).arg(m_retrievalDeadlineMs));
+        emit lateRetrievalFinished(requestId, true);
+        return;
+    }
 
-    LOG_INFO(QString("Retrieved %1 relevant contexts").arg(contexts.size()));
-    emit contextRetrieved(contexts);
+    LOG_INFO(QString("Retrieved %1 relevant contexts in %2 ms").arg(contexts.size()).arg(elapsedMs));
+    emitContext(requestId, contexts);
 }
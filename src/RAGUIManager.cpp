@@ -2,7 +2,8 @@
  * RAGUIManager.cpp - RAG document management UI
  * 
  * Handles document and directory ingestion dialogs, document list viewer,
- * and clear documents confirmation.
+ * and clear documents confirmation. The engine may live on another thread:
+ * ingestion is queued to it and the result is posted back to this object.
  */
 
 #include "RAGUIManager.h"
@@ -32,7 +33,7 @@ void RAGUIManager::ingestDocument() {
     QString fileName = QFileDialog::getOpenFileName(parentWidget,
         tr("Ingest Document for RAG"),
         QDir::homePath(),
-        tr("Documents (*.txt *.md *.markdown *.pdf *.docx *.doc);;All Files (*)"));
+        tr("Documents (*.txt *.md *.markdown *.pdf *.docx *.doc *.odt);;All Files (*)"));
 
     if (fileName.isEmpty()) {
         return;
@@ -41,8 +42,22 @@ void RAGUIManager::ingestDocument() {
     LOG_INFO(QString("Ingesting document: %1").arg(fileName));
     emit statusUpdated();
 
-    // Ingest asynchronously
-    if (ragEngine && ragEngine->ingestDocument(fileName)) {
+    if (!ragEngine) {
+        finishDocumentIngestion(fileName, false);
+        return;
+    }
+
+    // Ingest on the engine's thread; reading and chunking stay off the GUI thread
+    QMetaObject::invokeMethod(ragEngine, [this, engine = ragEngine, fileName]() {
+        bool ok = engine->ingestDocument(fileName);
+        QMetaObject::invokeMethod(this, [this, fileName, ok]() {
+            finishDocumentIngestion(fileName, ok);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void RAGUIManager::finishDocumentIngestion(const QString &fileName, bool ok) {
+    if (ok) {
         int chunkCount = ragEngine->getChunkCount();
         emit documentIngested(QFileInfo(fileName).fileName(), chunkCount);
         emit statusUpdated();
@@ -68,8 +83,21 @@ void RAGUIManager::ingestDirectory() {
     LOG_INFO(QString("Ingesting directory: %1").arg(dirPath));
     emit statusUpdated();
 
-    // Ingest asynchronously
-    if (ragEngine && ragEngine->ingestDirectory(dirPath)) {
+    if (!ragEngine) {
+        finishDirectoryIngestion(dirPath, false);
+        return;
+    }
+
+    QMetaObject::invokeMethod(ragEngine, [this, engine = ragEngine, dirPath]() {
+        bool ok = engine->ingestDirectory(dirPath);
+        QMetaObject::invokeMethod(this, [this, dirPath, ok]() {
+            finishDirectoryIngestion(dirPath, ok);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void RAGUIManager::finishDirectoryIngestion(const QString &dirPath, bool ok) {
+    if (ok) {
         int chunkCount = ragEngine->getChunkCount();
         emit directoryIngested(dirPath, chunkCount);
         emit statusUpdated();
@@ -168,9 +196,13 @@ void RAGUIManager::clearDocuments() {
         QMessageBox::Yes | QMessageBox::No);
 
     if (reply == QMessageBox::Yes) {
-        ragEngine->clearDocuments();
-        emit documentsCleared();
-        emit statusUpdated();
-        LOG_INFO("All RAG documents cleared");
+        QMetaObject::invokeMethod(ragEngine, [this, engine = ragEngine]() {
+            engine->clearDocuments();
+            QMetaObject::invokeMethod(this, [this]() {
+                emit documentsCleared();
+                emit statusUpdated();
+                LOG_INFO("All RAG documents cleared");
+            }, Qt::QueuedConnection);
+        });
     }
 }
@@ -7,6 +7,7 @@
 
 #include "SSEClient.h"
 #include "Logger.h"
+#include "StreamTrace.h"
 #include <QTimer>
 #include <QUrl>
 
@@ -18,7 +19,8 @@ SSEClient::SSEClient(QObject *parent)
 
     // Defer network manager creation
     QTimer::singleShot(0, this, [this]() {
-        m_networkManager = new QNetworkAccessManager(this);
+        // Plain manager unless --record-stream/--replay-stream is active
+        m_networkManager = StreamTrace::instance().createNetworkManager(this);
         LOG_DEBUG("SSEClient: QNetworkAccessManager initialized");
     });
 }
@@ -88,6 +88,13 @@ void SettingsDialog::createUI() {
 
     backendLayout->addRow(tr("Model:"), modelLayout);
 
+    fastModelCombo = new QComboBox(this);
+    fastModelCombo->setEditable(true);
+    fastModelCombo->setPlaceholderText(tr("None (use the main model)"));
+    fastModelCombo->setToolTip(tr("Smaller, faster model for deciding on tool calls and their arguments; "
+                                  "answers still come from the main model"));
+    backendLayout->addRow(tr("Fast Model:"), fastModelCombo);
+
     apiUrlEdit = new QLineEdit(this);
     apiUrlEdit->setPlaceholderText("http://localhost:11434/api/generate");
     backendLayout->addRow(tr("API URL:"), apiUrlEdit);
@@ -213,6 +220,27 @@ void SettingsDialog::createUI() {
     QFormLayout *ragLayout = new QFormLayout();
     ragGroupLayout->addLayout(ragLayout);
 
+    ragEmbeddingProviderCombo = new QComboBox(this);
+    ragEmbeddingProviderCombo->addItem(tr("Ollama"), "ollama");
+    ragEmbeddingProviderCombo->addItem(tr("OpenAI-compatible"), "openai");
+    ragEmbeddingProviderCombo->addItem(tr("Local (offline)"), "local");
+    ragEmbeddingProviderCombo->setToolTip(tr("Where document and query embeddings are computed. "
+                                             "Local needs no server but matches words rather than meaning."));
+    ragLayout->addRow(tr("Embedding Provider:"), ragEmbeddingProviderCombo);
+
+    ragEmbeddingUrlEdit = new QLineEdit(this);
+    ragEmbeddingUrlEdit->setPlaceholderText(tr("Default (Ollama: http://localhost:11434, OpenAI: https://api.openai.com/v1)"));
+    ragEmbeddingUrlEdit->setToolTip(tr("Embedding server URL; the OpenAI-compatible provider uses the API key above"));
+    ragLayout->addRow(tr("Embedding URL:"), ragEmbeddingUrlEdit);
+
+    // The local provider has neither a server nor model choices
+    connect(ragEmbeddingProviderCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        bool server = ragEmbeddingProviderCombo->currentData().toString() != "local";
+        ragEmbeddingUrlEdit->setEnabled(server);
+        ragEmbeddingModelCombo->setEnabled(server);
+        refreshEmbeddingModelsButton->setEnabled(server);
+    });
+
     // Embedding model selection with refresh button
     QHBoxLayout *embeddingModelLayout = new QHBoxLayout();
     ragEmbeddingModelCombo = new QComboBox(this);
@@ -228,6 +256,28 @@ void SettingsDialog::createUI() {
 
     ragLayout->addRow(tr("Embedding Model:"), embeddingModelLayout);
 
+    // Stored vector width and how it is reached
+    QHBoxLayout *dimensionsLayout = new QHBoxLayout();
+    ragDimensionsSpinBox = new QSpinBox(this);
+    ragDimensionsSpinBox->setRange(0, 4096);
+    ragDimensionsSpinBox->setSingleStep(64);
+    ragDimensionsSpinBox->setSpecialValueText(tr("Full width"));
+    ragDimensionsSpinBox->setToolTip(tr("Keep only this many dimensions per vector; smaller indexes "
+                                        "search faster at some cost in recall. Changing it re-embeds documents"));
+    dimensionsLayout->addWidget(ragDimensionsSpinBox, 1);
+
+    ragReductionCombo = new QComboBox(this);
+    ragReductionCombo->addItem(tr("Truncate (Matryoshka)"), "truncate");
+    ragReductionCombo->addItem(tr("PCA"), "pca");
+    ragReductionCombo->setToolTip(tr("Truncate suits Matryoshka models such as nomic-embed-text; "
+                                     "PCA learns a projection from the indexed documents"));
+    dimensionsLayout->addWidget(ragReductionCombo);
+    connect(ragDimensionsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        ragReductionCombo->setEnabled(value > 0);
+    });
+
+    ragLayout->addRow(tr("Embedding Dimensions:"), dimensionsLayout);
+
     ragChunkSizeSpinBox = new QSpinBox(this);
     ragChunkSizeSpinBox->setRange(128, 2048);
     ragChunkSizeSpinBox->setSingleStep(128);
@@ -242,14 +292,67 @@ void SettingsDialog::createUI() {
     ragChunkOverlapSpinBox->setToolTip(tr("Overlap between consecutive chunks for better context"));
     ragLayout->addRow(tr("Chunk Overlap:"), ragChunkOverlapSpinBox);
 
+    // Token budgets replace the character size when set
+    ragChunkTokensSpinBox = new QSpinBox(this);
+    ragChunkTokensSpinBox->setRange(0, 8192);
+    ragChunkTokensSpinBox->setSingleStep(64);
+    ragChunkTokensSpinBox->setSuffix(" tokens");
+    ragChunkTokensSpinBox->setSpecialValueText(tr("Off (use chunk size)"));
+    ragChunkTokensSpinBox->setToolTip(tr("Most tokens of the embedding model per chunk; keep it a little under "
+                                         "the model's input limit (e.g. 510 for a 512-token model)"));
+    ragLayout->addRow(tr("Chunk Tokens:"), ragChunkTokensSpinBox);
+    connect(ragChunkTokensSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        ragChunkSizeSpinBox->setEnabled(value == 0);
+    });
+
+    ragTokenizerEdit = new QLineEdit(this);
+    ragTokenizerEdit->setPlaceholderText(tr("Default (~/.qtbot/tokenizers/<model>.json, else estimated)"));
+    ragTokenizerEdit->setToolTip(tr("The embedding model's tokenizer.json (WordPiece) or vocab.txt, "
+                                    "for exact token counts"));
+    ragLayout->addRow(tr("Tokenizer:"), ragTokenizerEdit);
+
     ragTopKSpinBox = new QSpinBox(this);
     ragTopKSpinBox->setRange(1, 10);
     ragTopKSpinBox->setSingleStep(1);
     ragTopKSpinBox->setToolTip(tr("Number of most relevant chunks to retrieve for context"));
     ragLayout->addRow(tr("Top K Results:"), ragTopKSpinBox);
 
+    ragSpeculativeCheckbox = new QCheckBox(tr("Retrieve while typing"), this);
+    ragSpeculativeCheckbox->setToolTip(tr("Search the documents for the message as it is typed, so the context "
+                                          "is usually ready when it is sent"));
+    ragLayout->addRow(QString(), ragSpeculativeCheckbox);
+
+    ragDeadlineSpinBox = new QSpinBox(this);
+    ragDeadlineSpinBox->setRange(0, 30000);
+    ragDeadlineSpinBox->setSingleStep(250);
+    ragDeadlineSpinBox->setSuffix(" ms");
+    ragDeadlineSpinBox->setSpecialValueText(tr("No limit"));
+    ragDeadlineSpinBox->setToolTip(tr("Longest wait for the embedding server; after it, keyword matches "
+                                      "(or no context) are used so the reply isn't held up"));
+    ragLayout->addRow(tr("Retrieval Deadline:"), ragDeadlineSpinBox);
+
+    ragJournalCheckbox = new QCheckBox(tr("Keep ingested documents between sessions"), this);
+    ragJournalCheckbox->setToolTip(tr("Record chunks and embeddings on disk as they are produced, so documents "
+                                      "are restored at startup and an interrupted ingestion resumes where it stopped"));
+    ragLayout->addRow(QString(), ragJournalCheckbox);
+
     mainLayout->addWidget(ragGroup);
 
+    // Memory Group
+    QGroupBox *memoryGroup = new QGroupBox(tr("Memory"), this);
+    QFormLayout *memoryLayout = new QFormLayout(memoryGroup);
+
+    memoryBudgetSpinBox = new QSpinBox(this);
+    memoryBudgetSpinBox->setRange(0, 1024 * 1024);
+    memoryBudgetSpinBox->setSingleStep(256);
+    memoryBudgetSpinBox->setSuffix(" MB");
+    memoryBudgetSpinBox->setSpecialValueText(tr("Unlimited"));
+    memoryBudgetSpinBox->setToolTip(tr("Above this, caches are dropped, older messages are unloaded from the "
+                                       "transcript and RAG vectors move to a memory-mapped file"));
+    memoryLayout->addRow(tr("Memory Budget:"), memoryBudgetSpinBox);
+
+    mainLayout->addWidget(memoryGroup);
+
     // MCP Servers Group
     QGroupBox *mcpGroup = new QGroupBox(tr("MCP (Model Context Protocol) Servers"), this);
     QVBoxLayout *mcpGroupLayout = new QVBoxLayout(mcpGroup);
@@ -328,6 +431,7 @@ void SettingsDialog::loadCurrentSettings() {
     backendCombo->setCurrentText(backend == "ollama" ? "Ollama" : "OpenAI");
 
     modelCombo->setEditText(Config::instance().getModel());
+    fastModelCombo->setEditText(Config::instance().getFastModel());
     apiUrlEdit->setText(Config::instance().getApiUrl());
     apiKeyEdit->setText(Config::instance().getOpenAIApiKey());
     systemPromptEdit->setPlainText(Config::instance().getSystemPrompt());
@@ -348,10 +452,26 @@ void SettingsDialog::loadCurrentSettings() {
 
     // Load RAG settings
     ragEnabledCheckbox->setChecked(Config::instance().getRagEnabled());
+    int providerIndex = ragEmbeddingProviderCombo->findData(Config::instance().getRagEmbeddingProvider());
+    ragEmbeddingProviderCombo->setCurrentIndex(providerIndex >= 0 ? providerIndex : 0);
+    ragEmbeddingUrlEdit->setText(Config::instance().getRagEmbeddingUrl());
     ragEmbeddingModelCombo->setEditText(Config::instance().getRagEmbeddingModel());
+    ragDimensionsSpinBox->setValue(Config::instance().getRagEmbeddingDimensions());
+    int reductionIndex = ragReductionCombo->findData(Config::instance().getRagDimensionReduction());
+    ragReductionCombo->setCurrentIndex(reductionIndex >= 0 ? reductionIndex : 0);
+    ragReductionCombo->setEnabled(ragDimensionsSpinBox->value() > 0);
     ragChunkSizeSpinBox->setValue(Config::instance().getRagChunkSize());
     ragChunkOverlapSpinBox->setValue(Config::instance().getRagChunkOverlap());
+    ragChunkTokensSpinBox->setValue(Config::instance().getRagChunkTokens());
+    ragChunkSizeSpinBox->setEnabled(ragChunkTokensSpinBox->value() == 0);
+    ragTokenizerEdit->setText(Config::instance().getRagTokenizer());
     ragTopKSpinBox->setValue(Config::instance().getRagTopK());
+    ragSpeculativeCheckbox->setChecked(Config::instance().getRagSpeculative());
+    ragDeadlineSpinBox->setValue(Config::instance().getRagDeadlineMs());
+    ragJournalCheckbox->setChecked(Config::instance().getRagJournal());
+
+    // Load memory settings
+    memoryBudgetSpinBox->setValue(Config::instance().getMemoryBudgetMb());
 
     // Load MCP servers
     mcpServers = Config::instance().getMcpServers();
@@ -364,37 +484,53 @@ void SettingsDialog::loadCurrentSettings() {
 }
 
 void SettingsDialog::saveSettings() {
-    // Save backend settings
-    QString backend = backendCombo->currentText().toLower();
-    Config::instance().setBackend(backend);
-    Config::instance().setModel(modelCombo->currentText());
-    Config::instance().setApiUrl(apiUrlEdit->text());
-    Config::instance().setOpenAIApiKey(apiKeyEdit->text());
-    Config::instance().setSystemPrompt(systemPromptEdit->toPlainText());
-
-    // Save LLM parameters
-    Config::instance().setContextWindowSize(contextWindowSpinBox->value());
-    Config::instance().setTemperature(temperatureSpinBox->value());
-    Config::instance().setTopP(topPSpinBox->value());
-    Config::instance().setTopK(topKSpinBox->value());
-    Config::instance().setMaxTokens(maxTokensSpinBox->value());
-
-    // Save override flags
-    Config::instance().setOverrideContextWindowSize(overrideContextWindowCheckbox->isChecked());
-    Config::instance().setOverrideTemperature(overrideTemperatureCheckbox->isChecked());
-    Config::instance().setOverrideTopP(overrideTopPCheckbox->isChecked());
-    Config::instance().setOverrideTopK(overrideTopKCheckbox->isChecked());
-    Config::instance().setOverrideMaxTokens(overrideMaxTokensCheckbox->isChecked());
-
-    // Save RAG settings
-    Config::instance().setRagEnabled(ragEnabledCheckbox->isChecked());
-    Config::instance().setRagEmbeddingModel(ragEmbeddingModelCombo->currentText());
-    Config::instance().setRagChunkSize(ragChunkSizeSpinBox->value());
-    Config::instance().setRagChunkOverlap(ragChunkOverlapSpinBox->value());
-    Config::instance().setRagTopK(ragTopKSpinBox->value());
-
-    // Save MCP servers
-    Config::instance().setMcpServers(mcpServers);
+    // Apply every field in one update so readers never observe a half-saved
+    // mix of old and new settings
+    Config::instance().update([this](ConfigSnapshot &cfg) {
+        // Backend settings
+        cfg.backend = backendCombo->currentText().toLower();
+        cfg.model = modelCombo->currentText();
+        cfg.fastModel = fastModelCombo->currentText().trimmed();
+        cfg.apiUrl = apiUrlEdit->text();
+        cfg.openaiApiKey = apiKeyEdit->text();
+        cfg.systemPrompt = systemPromptEdit->toPlainText();
+
+        // LLM parameters
+        cfg.contextWindowSize = contextWindowSpinBox->value();
+        cfg.temperature = temperatureSpinBox->value();
+        cfg.topP = topPSpinBox->value();
+        cfg.topK = topKSpinBox->value();
+        cfg.maxTokens = maxTokensSpinBox->value();
+
+        // Override flags
+        cfg.overrideContextWindowSize = overrideContextWindowCheckbox->isChecked();
+        cfg.overrideTemperature = overrideTemperatureCheckbox->isChecked();
+        cfg.overrideTopP = overrideTopPCheckbox->isChecked();
+        cfg.overrideTopK = overrideTopKCheckbox->isChecked();
+        cfg.overrideMaxTokens = overrideMaxTokensCheckbox->isChecked();
+
+        // RAG settings
+        cfg.ragEnabled = ragEnabledCheckbox->isChecked();
+        cfg.ragEmbeddingProvider = ragEmbeddingProviderCombo->currentData().toString();
+        cfg.ragEmbeddingUrl = ragEmbeddingUrlEdit->text().trimmed();
+        cfg.ragEmbeddingModel = ragEmbeddingModelCombo->currentText();
+        cfg.ragEmbeddingDimensions = ragDimensionsSpinBox->value();
+        cfg.ragDimensionReduction = ragReductionCombo->currentData().toString();
+        cfg.ragChunkSize = ragChunkSizeSpinBox->value();
+        cfg.ragChunkOverlap = ragChunkOverlapSpinBox->value();
+        cfg.ragChunkTokens = ragChunkTokensSpinBox->value();
+        cfg.ragTokenizer = ragTokenizerEdit->text().trimmed();
+        cfg.ragTopK = ragTopKSpinBox->value();
+        cfg.ragSpeculative = ragSpeculativeCheckbox->isChecked();
+        cfg.ragDeadlineMs = ragDeadlineSpinBox->value();
+        cfg.ragJournal = ragJournalCheckbox->isChecked();
+
+        // Memory settings
+        cfg.memoryBudgetMb = memoryBudgetSpinBox->value();
+
+        // MCP servers
+        cfg.mcpServers = mcpServers;
+    });
 
     // Persist to file
     if (Config::instance().save()) {
@@ -426,6 +562,18 @@ void SettingsDialog::resetToDefaults() {
     }
 }
 
+void SettingsDialog::syncFastModelItems() {
+    QString currentFastModel = fastModelCombo->currentText();
+
+    fastModelCombo->clear();
+    for (int i = 0; i < modelCombo->count(); ++i) {
+        fastModelCombo->addItem(modelCombo->itemText(i));
+    }
+
+    // Keep "none" unless a fast model was chosen
+    fastModelCombo->setEditText(currentFastModel);
+}
+
 void SettingsDialog::refreshModels() {
     if (!networkManager) {
         LOG_WARNING("Network manager not initialized yet");
@@ -607,6 +755,7 @@ void SettingsDialog::handleModelsResponse(QNetworkReply *reply) {
         modelCombo->setEditText(currentModel);
     }
 
+    syncFastModelItems();
     LOG_INFO(QString("Loaded %1 models from Ollama").arg(modelsArray.size()));
 
     // Only show success popup for manual refresh
@@ -693,6 +842,7 @@ void SettingsDialog::handleLemonadeModelsResponse(QNetworkReply *reply) {
         modelCombo->setEditText(currentModel);
     }
 
+    syncFastModelItems();
     LOG_INFO(QString("Loaded %1 models from Lemonade").arg(modelsArray.size()));
 
     // Only show success popup for manual refresh
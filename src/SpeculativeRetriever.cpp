@@ -0,0 +1,258 @@
+/**
+ * SpeculativeRetriever.cpp - RAG retrieval started while the user is typing
+ */
+
+#include "SpeculativeRetriever.h"
+#include "RAGEngine.h"
+#include "Logger.h"
+#include <QTimer>
+#include <QSet>
+
+// Typing pause before speculating; short enough to finish before most sends
+static const int DEFAULT_DEBOUNCE_MS = 300;
+
+// Shorter text rarely resembles the final question
+static const int MIN_SPECULATION_LENGTH = 8;
+
+// Share of distinct words two queries must have in common to reuse a retrieval
+static const double CLOSE_MATCH_RATIO = 0.8;
+
+SpeculativeRetriever::SpeculativeRetriever(RAGEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_debounceTimer(new QTimer(this))
+    , m_typedTopK(0)
+    , m_state(Idle)
+    , m_topK(0)
+    , m_serial(0)
+    , m_requestId(0)
+    , m_speculative(false)
+    , m_final(false)
+    , m_degraded(false)
+    , m_requestMs(0)
+    , m_hits(0)
+    , m_misses(0) {
+
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(DEFAULT_DEBOUNCE_MS);
+    connect(m_debounceTimer, &QTimer::timeout, this, &SpeculativeRetriever::startSpeculation);
+
+    connect(m_engine, &RAGEngine::contextReady, this, &SpeculativeRetriever::handleContextReady);
+    connect(m_engine, &RAGEngine::contextFailed, this, &SpeculativeRetriever::handleContextFailed);
+    connect(m_engine, &RAGEngine::retrievalDegraded, this, &SpeculativeRetriever::handleRetrievalDegraded);
+}
+
+void SpeculativeRetriever::setDebounceInterval(int ms) {
+    m_debounceTimer->setInterval(ms);
+}
+
+int SpeculativeRetriever::debounceInterval() const {
+    return m_debounceTimer->interval();
+}
+
+void SpeculativeRetriever::speculate(const QString &text, int topK) {
+    // A send is waiting for its context; typing no longer matters
+    if (m_final) {
+        return;
+    }
+
+    m_typedText = text;
+    m_typedTopK = topK;
+    if (normalize(text).size() < MIN_SPECULATION_LENGTH) {
+        m_debounceTimer->stop();
+        return;
+    }
+    m_debounceTimer->start();
+}
+
+void SpeculativeRetriever::startSpeculation() {
+    if (m_final) {
+        return;
+    }
+
+    // Already retrieving (or retrieved) exactly this text
+    bool current = (m_state == Pending || m_state == Ready)
+        && m_topK == m_typedTopK && normalize(m_query) == normalize(m_typedText);
+    if (current) {
+        return;
+    }
+
+    startRequest(m_typedText, m_typedTopK, true);
+}
+
+void SpeculativeRetriever::retrieve(const QString &query, int topK) {
+    m_debounceTimer->stop();
+
+    // A speculation that fell back to lexical matches is retried: by now the
+    // engine may have the late vector result cached
+    bool matches = (m_state == Pending || m_state == Ready) && !m_degraded
+        && m_topK == topK && isCloseMatch(m_query, query);
+    if (matches) {
+        ++m_hits;
+        m_final = true;
+        if (m_state == Ready) {
+            LOG_INFO(QString("Speculative retrieval hit: context was ready, saved %1 ms").arg(m_requestMs));
+            deliver();
+        } else {
+            LOG_INFO(QString("Speculative retrieval hit: joining the retrieval started %1 ms ago")
+                     .arg(m_requestTimer.elapsed()));
+        }
+        return;
+    }
+
+    ++m_misses;
+    if (m_state != Idle) {
+        LOG_DEBUG(QString("Speculative retrieval miss: \"%1\" does not match the message").arg(m_query));
+    }
+    startRequest(query, topK, false);
+    m_final = true;
+}
+
+void SpeculativeRetriever::invalidate() {
+    m_debounceTimer->stop();
+
+    // A send already waiting keeps its retrieval
+    if (m_final || m_state == Idle) {
+        return;
+    }
+    LOG_DEBUG("Index changed, dropping speculative retrieval");
+    cancelCurrent();
+}
+
+void SpeculativeRetriever::startRequest(const QString &query, int topK, bool speculative) {
+    cancelCurrent();
+
+    m_state = Pending;
+    m_query = query;
+    m_topK = topK;
+    m_speculative = speculative;
+    m_requestTimer.start();
+    int serial = m_serial;
+
+    LOG_DEBUG(QString("%1 retrieval for \"%2\"").arg(speculative ? "Speculative" : "Send-time", query));
+
+    QMetaObject::invokeMethod(m_engine, [this, engine = m_engine, serial, query, topK]() {
+        int requestId = engine->requestContext(query, topK);
+        // Direct call when the engine shares this thread, queued otherwise;
+        // either way the ID arrives before the engine can report a result
+        QMetaObject::invokeMethod(this, [this, serial, requestId]() {
+            handleRequestStarted(serial, requestId);
+        });
+    });
+}
+
+void SpeculativeRetriever::handleRequestStarted(int serial, int requestId) {
+    if (serial != m_serial || m_state != Pending) {
+        // Superseded before the engine assigned an ID
+        QMetaObject::invokeMethod(m_engine, [engine = m_engine, requestId]() {
+            engine->cancelRequest(requestId);
+        });
+        return;
+    }
+    m_requestId = requestId;
+}
+
+void SpeculativeRetriever::handleContextReady(int requestId, const QStringList &contexts) {
+    if (m_state != Pending || requestId != m_requestId) {
+        return;
+    }
+
+    m_state = Ready;
+    m_contexts = contexts;
+    m_requestMs = m_requestTimer.elapsed();
+    LOG_DEBUG(QString("Retrieval for \"%1\" finished in %2 ms").arg(m_query).arg(m_requestMs));
+
+    if (m_final) {
+        deliver();
+    }
+}
+
+void SpeculativeRetriever::handleContextFailed(int requestId, const QString &error) {
+    if (m_state != Pending || requestId != m_requestId) {
+        return;
+    }
+
+    m_state = Failed;
+    m_error = error;
+    if (m_final) {
+        deliver();
+    }
+}
+
+void SpeculativeRetriever::handleRetrievalDegraded(int requestId) {
+    if (m_state == Pending && requestId == m_requestId) {
+        m_degraded = true;
+    }
+}
+
+void SpeculativeRetriever::cancelCurrent() {
+    if (m_state == Pending && m_requestId > 0) {
+        QMetaObject::invokeMethod(m_engine, [engine = m_engine, requestId = m_requestId]() {
+            engine->cancelRequest(requestId);
+        });
+    }
+
+    // Any ID still on its way for the old request is now stale
+    ++m_serial;
+    m_state = Idle;
+    m_requestId = 0;
+    m_final = false;
+    m_degraded = false;
+    m_contexts.clear();
+    m_error.clear();
+}
+
+void SpeculativeRetriever::deliver() {
+    State state = m_state;
+    QStringList contexts = m_contexts;
+    QString error = m_error;
+    bool speculative = m_speculative;
+
+    // Used once: the next message starts from scratch
+    cancelCurrent();
+    m_query.clear();
+
+    if (state == Ready) {
+        emit contextReady(contexts, speculative);
+    } else {
+        emit retrievalFailed(error);
+    }
+}
+
+QString SpeculativeRetriever::normalize(const QString &text) {
+    QString normalized;
+    normalized.reserve(text.size());
+    for (const QChar &c : text) {
+        normalized += c.isLetterOrNumber() ? c.toLower() : QChar(' ');
+    }
+    return normalized.simplified();
+}
+
+bool SpeculativeRetriever::isCloseMatch(const QString &speculated, const QString &final) {
+    QString a = normalize(speculated);
+    QString b = normalize(final);
+    if (a.isEmpty() || b.isEmpty()) {
+        return false;
+    }
+    if (a == b) {
+        return true;
+    }
+
+    QSet<QString> wordsA;
+    for (const QString &word : a.split(' ')) {
+        wordsA.insert(word);
+    }
+    QSet<QString> wordsB;
+    for (const QString &word : b.split(' ')) {
+        wordsB.insert(word);
+    }
+
+    int common = 0;
+    for (const QString &word : wordsA) {
+        if (wordsB.contains(word)) {
+            ++common;
+        }
+    }
+    int total = wordsA.size() + wordsB.size() - common;
+    return common >= CLOSE_MATCH_RATIO * total;
+}
@@ -0,0 +1,160 @@
+/**
+ * StartupProfiler.cpp - Wall-time profile of application startup phases
+ *
+ * Keeps a flat list of (possibly nested) phases timed against one clock
+ * started in main(), detects the first paint of the main window and the
+ * following idle event loop, and formats the report.
+ */
+
+#include "StartupProfiler.h"
+#include "Logger.h"
+#include <QEvent>
+#include <QTimer>
+#include <QJsonArray>
+#include <iostream>
+
+StartupProfiler& StartupProfiler::instance() {
+    static StartupProfiler instance;
+    return instance;
+}
+
+StartupProfiler::StartupProfiler()
+    : QObject(nullptr)
+    , m_depth(0)
+    , m_enabled(false)
+    , m_finished(false)
+    , m_interactiveMs(-1.0)
+    , m_firstPaintMs(-1.0)
+    , m_watchedWindow(nullptr) {
+}
+
+void StartupProfiler::start() {
+    m_clock.start();
+}
+
+double StartupProfiler::elapsedMs() const {
+    return m_clock.isValid() ? m_clock.nsecsElapsed() / 1000000.0 : 0.0;
+}
+
+int StartupProfiler::beginPhase(const QString &name) {
+    if (!m_clock.isValid()) {
+        m_clock.start();
+    }
+
+    Phase phase;
+    phase.name = name;
+    phase.depth = m_depth++;
+    phase.startMs = elapsedMs();
+    phase.durationMs = -1.0;
+    phase.deferred = m_finished;
+    m_phases.append(phase);
+    return m_phases.size() - 1;
+}
+
+void StartupProfiler::endPhase(int index) {
+    if (index < 0 || index >= m_phases.size()) {
+        return;
+    }
+
+    Phase &phase = m_phases[index];
+    phase.durationMs = elapsedMs() - phase.startMs;
+    m_depth = qMax(0, m_depth - 1);
+
+    // Work pushed past the first frame is reported as it completes
+    if (phase.deferred && m_enabled) {
+        std::cerr << QString("[startup-profile] deferred at %1 ms: %2 (%3 ms)")
+                         .arg(phase.startMs, 0, 'f', 1)
+                         .arg(phase.name)
+                         .arg(phase.durationMs, 0, 'f', 1)
+                         .toStdString() << std::endl;
+    }
+}
+
+void StartupProfiler::finishOnFirstPaint(QObject *window) {
+    if (!window || m_finished) {
+        return;
+    }
+    m_watchedWindow = window;
+    window->installEventFilter(this);
+}
+
+bool StartupProfiler::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == m_watchedWindow && event->type() == QEvent::Paint) {
+        m_watchedWindow->removeEventFilter(this);
+        m_watchedWindow = nullptr;
+        m_firstPaintMs = elapsedMs();
+
+        // Interactive once everything queued behind the first frame has run
+        QTimer::singleShot(0, this, [this]() {
+            finish("interactive");
+        });
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void StartupProfiler::finish(const QString &milestone) {
+    if (m_finished) {
+        return;
+    }
+
+    m_finished = true;
+    m_milestone = milestone;
+    m_interactiveMs = elapsedMs();
+
+    LOG_INFO(QString("Startup: %1 after %2 ms").arg(milestone).arg(m_interactiveMs, 0, 'f', 1));
+
+    if (m_enabled) {
+        std::cerr << report().toStdString() << std::flush;
+    }
+}
+
+QString StartupProfiler::report() const {
+    QString out;
+    out += "Startup profile (wall time since main())\n";
+    out += QString("%1  %2  %3\n").arg("start ms", 9).arg("took ms", 9).arg("phase");
+
+    for (const Phase &phase : m_phases) {
+        if (phase.deferred) {
+            continue;
+        }
+        QString took = phase.durationMs < 0 ? QString("running") : QString::number(phase.durationMs, 'f', 1);
+        out += QString("%1  %2  %3%4\n")
+                   .arg(phase.startMs, 9, 'f', 1)
+                   .arg(took, 9)
+                   .arg(QString(phase.depth * 2, ' '))
+                   .arg(phase.name);
+    }
+
+    if (m_firstPaintMs >= 0) {
+        out += QString("First paint: %1 ms\n").arg(m_firstPaintMs, 0, 'f', 1);
+    }
+    if (m_finished) {
+        out += QString("%1: %2 ms (target %3 ms) %4\n")
+                   .arg(m_milestone.left(1).toUpper() + m_milestone.mid(1))
+                   .arg(m_interactiveMs, 0, 'f', 1)
+                   .arg(STARTUP_TARGET_MS)
+                   .arg(m_interactiveMs <= STARTUP_TARGET_MS ? "OK" : "OVER BUDGET");
+    }
+    return out;
+}
+
+QJsonObject StartupProfiler::toJson() const {
+    QJsonArray phases;
+    for (const Phase &phase : m_phases) {
+        QJsonObject obj;
+        obj["name"] = phase.name;
+        obj["depth"] = phase.depth;
+        obj["start_ms"] = phase.startMs;
+        obj["duration_ms"] = phase.durationMs;
+        obj["deferred"] = phase.deferred;
+        phases.append(obj);
+    }
+
+    QJsonObject json;
+    json["phases"] = phases;
+    json["first_paint_ms"] = m_firstPaintMs;
+    json["interactive_ms"] = m_interactiveMs;
+    json["milestone"] = m_milestone;
+    json["target_ms"] = STARTUP_TARGET_MS;
+    return json;
+}
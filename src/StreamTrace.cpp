@@ -0,0 +1,469 @@
+/**
+ * StreamTrace.cpp - Record and replay backend response streams
+ *
+ * Recording wraps each real reply in a pass-through reply that logs bytes
+ * as they arrive. Replay builds replies from the trace and delivers each
+ * recorded chunk on a timer scaled by the replay speed.
+ */
+
+#include "StreamTrace.h"
+#include "Logger.h"
+#include <QMutexLocker>
+#include <QTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// StreamTrace
+// ---------------------------------------------------------------------------
+
+StreamTrace& StreamTrace::instance() {
+    static StreamTrace instance;
+    return instance;
+}
+
+StreamTrace::StreamTrace()
+    : m_mode(Off)
+    , m_speed(1.0)
+    , m_nextId(1) {
+}
+
+bool StreamTrace::startRecording(const QString &path) {
+    stop();
+
+    QMutexLocker locker(&m_mutex);
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        LOG_ERROR(QString("Stream trace: cannot open %1: %2").arg(path, m_file.errorString()));
+        return false;
+    }
+
+    m_mode = Record;
+    m_path = path;
+    m_nextId = 1;
+    m_clock.start();
+    writeRecord(QJsonObject{{"type", "trace"}, {"version", 1}});
+
+    LOG_INFO(QString("Recording backend streams to %1").arg(path));
+    return true;
+}
+
+bool StreamTrace::startReplay(const QString &path, double speed) {
+    stop();
+
+    QString errorMessage;
+    QList<StreamTraceExchange> exchanges;
+    if (!loadTrace(path, exchanges, &errorMessage)) {
+        LOG_ERROR(QString("Stream trace: cannot load %1: %2").arg(path, errorMessage));
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_exchanges = exchanges;
+    m_exchangesByKey.clear();
+    m_replayCursor.clear();
+    for (int i = 0; i < m_exchanges.size(); ++i) {
+        m_exchangesByKey[m_exchanges[i].method + " " + m_exchanges[i].path].append(i);
+    }
+
+    m_mode = Replay;
+    m_path = path;
+    m_speed = qMax(0.0, speed);
+
+    LOG_INFO(QString("Replaying %1 recorded exchanges from %2 at %3")
+             .arg(m_exchanges.size()).arg(path)
+             .arg(m_speed > 0.0 ? QString("%1x speed").arg(m_speed) : QString("full speed")));
+    return true;
+}
+
+void StreamTrace::stop() {
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_exchanges.clear();
+    m_exchangesByKey.clear();
+    m_replayCursor.clear();
+    m_mode = Off;
+    m_path.clear();
+}
+
+QNetworkAccessManager *StreamTrace::createNetworkManager(QObject *parent) {
+    if (m_mode == Off) {
+        return new QNetworkAccessManager(parent);
+    }
+    return new TraceNetworkAccessManager(m_mode, parent);
+}
+
+bool StreamTrace::loadTrace(const QString &path, QList<StreamTraceExchange> &exchanges, QString *errorMessage) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    QHash<int, int> indexById;
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError parseError;
+        QJsonObject record = QJsonDocument::fromJson(line, &parseError).object();
+        if (parseError.error != QJsonParseError::NoError) {
+            if (errorMessage) {
+                *errorMessage = QString("line %1: %2").arg(lineNumber).arg(parseError.errorString());
+            }
+            return false;
+        }
+
+        QString type = record["type"].toString();
+        int id = record["id"].toInt();
+        double timeMs = record["t_ms"].toDouble();
+
+        if (type == "request") {
+            StreamTraceExchange exchange;
+            exchange.method = record["method"].toString();
+            exchange.path = QUrl(record["url"].toString()).path();
+            indexById.insert(id, exchanges.size());
+            exchanges.append(exchange);
+            continue;
+        }
+
+        if (!indexById.contains(id)) {
+            continue;  // Trace header, or an exchange cut off by a crash
+        }
+        StreamTraceExchange &exchange = exchanges[indexById.value(id)];
+
+        if (type == "response") {
+            exchange.httpStatus = record["status"].toInt();
+            QJsonObject headers = record["headers"].toObject();
+            for (auto it = headers.begin(); it != headers.end(); ++it) {
+                exchange.headers.append(qMakePair(it.key().toUtf8(), it.value().toString().toUtf8()));
+            }
+        } else if (type == "data") {
+            StreamTraceExchange::Chunk chunk;
+            chunk.timeMs = timeMs;
+            chunk.data = QByteArray::fromBase64(record["data"].toString().toLatin1());
+            exchange.chunks.append(chunk);
+        } else if (type == "end") {
+            exchange.endMs = timeMs;
+            exchange.error = record["error"].toInt();
+            exchange.errorString = record["error_string"].toString();
+        }
+    }
+
+    return true;
+}
+
+int StreamTrace::beginExchange(const QString &method, const QUrl &url) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen()) {
+        return 0;
+    }
+
+    int id = m_nextId++;
+    writeRecord(QJsonObject{
+        {"type", "request"}, {"id", id}, {"method", method},
+        {"url", url.toString(QUrl::RemoveUserInfo)}, {"t_ms", 0},
+        {"wall_ms", static_cast<double>(m_clock.elapsed())}
+    });
+    return id;
+}
+
+void StreamTrace::recordResponse(int id, double timeMs, int status, const QList<QPair<QByteArray, QByteArray>> &headers) {
+    QJsonObject headerObj;
+    for (const auto &header : headers) {
+        headerObj[QString::fromLatin1(header.first)] = QString::fromLatin1(header.second);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen() && id > 0) {
+        writeRecord(QJsonObject{{"type", "response"}, {"id", id}, {"t_ms", timeMs},
+                                {"status", status}, {"headers", headerObj}});
+    }
+}
+
+void StreamTrace::recordData(int id, double timeMs, const QByteArray &data) {
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen() && id > 0) {
+        writeRecord(QJsonObject{{"type", "data"}, {"id", id}, {"t_ms", timeMs},
+                                {"data", QString::fromLatin1(data.toBase64())}});
+    }
+}
+
+void StreamTrace::recordEnd(int id, double timeMs, int error, const QString &errorString) {
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen() && id > 0) {
+        writeRecord(QJsonObject{{"type", "end"}, {"id", id}, {"t_ms", timeMs},
+                                {"error", error}, {"error_string", errorString}});
+        // Keep completed exchanges on disk if the process dies later
+        m_file.flush();
+    }
+}
+
+bool StreamTrace::takeExchange(const QString &method, const QString &path, StreamTraceExchange &exchange) {
+    QMutexLocker locker(&m_mutex);
+    QString key = method + " " + path;
+    const QList<int> indexes = m_exchangesByKey.value(key);
+    if (indexes.isEmpty()) {
+        return false;
+    }
+
+    int &cursor = m_replayCursor[key];
+    exchange = m_exchanges[indexes[cursor % indexes.size()]];
+    cursor++;
+    return true;
+}
+
+void StreamTrace::writeRecord(const QJsonObject &record) {
+    m_file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n");
+}
+
+// ---------------------------------------------------------------------------
+// TraceNetworkAccessManager
+// ---------------------------------------------------------------------------
+
+static QString operationName(QNetworkAccessManager::Operation op, const QNetworkRequest &request) {
+    switch (op) {
+        case QNetworkAccessManager::HeadOperation: return "HEAD";
+        case QNetworkAccessManager::GetOperation: return "GET";
+        case QNetworkAccessManager::PutOperation: return "PUT";
+        case QNetworkAccessManager::PostOperation: return "POST";
+        case QNetworkAccessManager::DeleteOperation: return "DELETE";
+        default:
+            return QString::fromLatin1(request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray());
+    }
+}
+
+TraceNetworkAccessManager::TraceNetworkAccessManager(StreamTrace::Mode mode, QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_mode(mode) {
+}
+
+QNetworkReply *TraceNetworkAccessManager::createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData) {
+    if (m_mode == StreamTrace::Replay) {
+        StreamTraceExchange exchange;
+        StreamTrace &trace = StreamTrace::instance();
+        if (trace.takeExchange(operationName(op, request), request.url().path(), exchange)) {
+            return new ReplayNetworkReply(op, request, exchange, trace.replaySpeed(), this);
+        }
+        LOG_WARNING(QString("Stream trace: no recorded exchange for %1 %2")
+                    .arg(operationName(op, request), request.url().path()));
+        return new ReplayNetworkReply(op, request, this);
+    }
+
+    QNetworkReply *inner = QNetworkAccessManager::createRequest(op, request, outgoingData);
+    if (m_mode == StreamTrace::Record) {
+        return new RecordingNetworkReply(inner, this);
+    }
+    return inner;
+}
+
+// ---------------------------------------------------------------------------
+// RecordingNetworkReply
+// ---------------------------------------------------------------------------
+
+RecordingNetworkReply::RecordingNetworkReply(QNetworkReply *inner, QObject *parent)
+    : QNetworkReply(parent)
+    , m_inner(inner)
+    , m_responseRecorded(false) {
+    m_timer.start();
+    inner->setParent(this);
+
+    setRequest(inner->request());
+    setUrl(inner->url());
+    setOperation(inner->operation());
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    m_exchangeId = StreamTrace::instance().beginExchange(operationName(inner->operation(), inner->request()), inner->url());
+
+    connect(inner, &QNetworkReply::metaDataChanged, this, &RecordingNetworkReply::handleMetaDataChanged);
+    connect(inner, &QNetworkReply::readyRead, this, &RecordingNetworkReply::handleReadyRead);
+    connect(inner, &QNetworkReply::finished, this, &RecordingNetworkReply::handleFinished);
+    connect(inner, &QNetworkReply::downloadProgress, this, &QNetworkReply::downloadProgress);
+    connect(inner, &QNetworkReply::uploadProgress, this, &QNetworkReply::uploadProgress);
+}
+
+RecordingNetworkReply::~RecordingNetworkReply() {
+    if (m_inner && m_inner->isRunning()) {
+        m_inner->disconnect(this);
+        m_inner->abort();
+    }
+}
+
+void RecordingNetworkReply::abort() {
+    if (m_inner) {
+        m_inner->abort();
+    }
+}
+
+qint64 RecordingNetworkReply::bytesAvailable() const {
+    return m_buffer.size() + QNetworkReply::bytesAvailable();
+}
+
+qint64 RecordingNetworkReply::readData(char *data, qint64 maxSize) {
+    qint64 count = qMin(maxSize, static_cast<qint64>(m_buffer.size()));
+    memcpy(data, m_buffer.constData(), static_cast<size_t>(count));
+    m_buffer.remove(0, static_cast<int>(count));
+    return count;
+}
+
+void RecordingNetworkReply::handleMetaDataChanged() {
+    for (const auto &header : m_inner->rawHeaderPairs()) {
+        setRawHeader(header.first, header.second);
+    }
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, m_inner->attribute(QNetworkRequest::HttpStatusCodeAttribute));
+    setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, m_inner->attribute(QNetworkRequest::HttpReasonPhraseAttribute));
+
+    if (!m_responseRecorded) {
+        m_responseRecorded = true;
+        StreamTrace::instance().recordResponse(m_exchangeId, m_timer.nsecsElapsed() / 1000000.0,
+                                               m_inner->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(),
+                                               m_inner->rawHeaderPairs());
+    }
+    emit metaDataChanged();
+}
+
+void RecordingNetworkReply::handleReadyRead() {
+    QByteArray data = m_inner->readAll();
+    if (data.isEmpty()) {
+        return;
+    }
+
+    StreamTrace::instance().recordData(m_exchangeId, m_timer.nsecsElapsed() / 1000000.0, data);
+    m_buffer += data;
+    emit readyRead();
+}
+
+void RecordingNetworkReply::handleFinished() {
+    // Drain anything that arrived together with the finish
+    if (m_inner->bytesAvailable() > 0) {
+        handleReadyRead();
+    }
+
+    StreamTrace::instance().recordEnd(m_exchangeId, m_timer.nsecsElapsed() / 1000000.0,
+                                      m_inner->error(), m_inner->error() != NoError ? m_inner->errorString() : QString());
+
+    if (m_inner->error() != NoError) {
+        setError(m_inner->error(), m_inner->errorString());
+        emit errorOccurred(m_inner->error());
+    }
+    setFinished(true);
+    emit finished();
+}
+
+// ---------------------------------------------------------------------------
+// ReplayNetworkReply
+// ---------------------------------------------------------------------------
+
+ReplayNetworkReply::ReplayNetworkReply(Operation op, const QNetworkRequest &request, const StreamTraceExchange &exchange,
+                                       double speed, QObject *parent)
+    : QNetworkReply(parent)
+    , m_exchange(exchange)
+    , m_speed(speed)
+    , m_nextChunk(0)
+    , m_aborted(false) {
+    init(op, request);
+}
+
+ReplayNetworkReply::ReplayNetworkReply(Operation op, const QNetworkRequest &request, QObject *parent)
+    : QNetworkReply(parent)
+    , m_speed(0.0)
+    , m_nextChunk(0)
+    , m_aborted(false) {
+    m_exchange.httpStatus = 404;
+    m_exchange.error = ContentNotFoundError;
+    m_exchange.errorString = QString("No recorded response for %1").arg(request.url().path());
+    init(op, request);
+}
+
+void ReplayNetworkReply::init(Operation op, const QNetworkRequest &request) {
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    m_timer.start();
+
+    // Headers are available before the first byte, as with a real reply
+    QTimer::singleShot(0, this, [this]() {
+        if (m_aborted) {
+            return;
+        }
+        for (const auto &header : m_exchange.headers) {
+            setRawHeader(header.first, header.second);
+        }
+        if (m_exchange.httpStatus > 0) {
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, m_exchange.httpStatus);
+        }
+        emit metaDataChanged();
+        scheduleNext();
+    });
+}
+
+void ReplayNetworkReply::scheduleNext() {
+    double dueMs = m_nextChunk < m_exchange.chunks.size()
+        ? m_exchange.chunks[m_nextChunk].timeMs
+        : m_exchange.endMs;
+
+    int delayMs = 0;
+    if (m_speed > 0.0) {
+        delayMs = qMax(0, static_cast<int>(dueMs / m_speed - m_timer.nsecsElapsed() / 1000000.0));
+    }
+
+    // Zero delay still yields to the event loop, so each chunk is its own readyRead
+    QTimer::singleShot(delayMs, this, &ReplayNetworkReply::deliverNext);
+}
+
+void ReplayNetworkReply::deliverNext() {
+    if (m_aborted) {
+        return;
+    }
+
+    if (m_nextChunk >= m_exchange.chunks.size()) {
+        finishReplay();
+        return;
+    }
+
+    m_buffer += m_exchange.chunks[m_nextChunk++].data;
+    emit readyRead();
+    scheduleNext();
+}
+
+void ReplayNetworkReply::finishReplay() {
+    if (m_exchange.error != NoError) {
+        NetworkError code = static_cast<NetworkError>(m_exchange.error);
+        setError(code, m_exchange.errorString);
+        emit errorOccurred(code);
+    }
+    setFinished(true);
+    emit finished();
+}
+
+void ReplayNetworkReply::abort() {
+    if (m_aborted || isFinished()) {
+        return;
+    }
+    m_aborted = true;
+    setError(OperationCanceledError, "Operation canceled");
+    emit errorOccurred(OperationCanceledError);
+    setFinished(true);
+    emit finished();
+}
+
+qint64 ReplayNetworkReply::bytesAvailable() const {
+    return m_buffer.size() + QNetworkReply::bytesAvailable();
+}
+
+qint64 ReplayNetworkReply::readData(char *data, qint64 maxSize) {
+    qint64 count = qMin(maxSize, static_cast<qint64>(m_buffer.size()));
+    memcpy(data, m_buffer.constData(), static_cast<size_t>(count));
+    m_buffer.remove(0, static_cast<int>(count));
+    return count;
+}
@@ -0,0 +1,276 @@
+/**
+ * Tokenizer.cpp - Token counting for the embedding model
+ *
+ * Follows the BERT tokenizer: text is split into words on whitespace,
+ * around punctuation and around CJK ideographs, each word is normalized
+ * (lowercased, accents stripped) as the model was trained, then matched
+ * greedily against the vocabulary, longest piece first. Only the count is
+ * kept; token IDs are never needed.
+ */
+
+#include "Tokenizer.h"
+#include "Logger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+
+namespace {
+
+// Characters per token when there is no vocabulary; English prose averages a little over four
+const int ESTIMATED_CHARS_PER_TOKEN = 4;
+
+bool isPunctuation(uint ucs) {
+    // BERT also treats every non-alphanumeric ASCII character as punctuation ($, +, ^, ...)
+    if ((ucs >= 33 && ucs <= 47) || (ucs >= 58 && ucs <= 64) || (ucs >= 91 && ucs <= 96)
+        || (ucs >= 123 && ucs <= 126)) {
+        return true;
+    }
+    return QChar::isPunct(ucs);
+}
+
+bool isCjk(uint ucs) {
+    return (ucs >= 0x4E00 && ucs <= 0x9FFF) || (ucs >= 0x3400 && ucs <= 0x4DBF)
+           || (ucs >= 0x20000 && ucs <= 0x2A6DF) || (ucs >= 0x2A700 && ucs <= 0x2B73F)
+           || (ucs >= 0x2B740 && ucs <= 0x2B81F) || (ucs >= 0x2B820 && ucs <= 0x2CEAF)
+           || (ucs >= 0xF900 && ucs <= 0xFAFF) || (ucs >= 0x2F800 && ucs <= 0x2FA1F);
+}
+
+// Removed by the normalizer without splitting the word (zero-width joiners, stray controls)
+bool isIgnored(uint ucs) {
+    if (ucs == 0 || ucs == 0xFFFD) {
+        return true;
+    }
+    QChar::Category category = QChar::category(ucs);
+    return category == QChar::Other_Control || category == QChar::Other_Format;
+}
+
+// Normalizers can be nested in a Sequence
+void readNormalizer(const QJsonObject &normalizer, bool &lowercase, bool &stripAccents) {
+    QString type = normalizer["type"].toString();
+    if (type == "BertNormalizer") {
+        lowercase = normalizer["lowercase"].toBool(true);
+        // null = follow lowercase, as in the original BERT
+        stripAccents = normalizer["strip_accents"].isBool() ? normalizer["strip_accents"].toBool() : lowercase;
+    } else if (type == "Lowercase") {
+        lowercase = true;
+    } else if (type == "StripAccents") {
+        stripAccents = true;
+    } else if (type == "Sequence") {
+        for (const QJsonValue &child : normalizer["normalizers"].toArray()) {
+            readNormalizer(child.toObject(), lowercase, stripAccents);
+        }
+    }
+}
+
+} // namespace
+
+Tokenizer::Tokenizer()
+    : m_subwordPrefix("##")
+    , m_maxWordChars(100)
+    , m_lowercase(false)
+    , m_stripAccents(false) {
+}
+
+QString Tokenizer::defaultPath(const QString &model) {
+    // Every tag of a model shares its tokenizer: "nomic-embed-text:v1.5" -> nomic-embed-text.json
+    QString name = model.section(':', 0, 0);
+    name.replace('/', '_');
+    return QDir::homePath() + "/.qtbot/tokenizers/" + name + ".json";
+}
+
+QString Tokenizer::name() const {
+    return m_path.isEmpty() ? QString("estimate") : m_path;
+}
+
+void Tokenizer::clear() {
+    m_vocab.clear();
+    m_path.clear();
+    m_subwordPrefix = "##";
+    m_maxWordChars = 100;
+    m_lowercase = false;
+    m_stripAccents = false;
+}
+
+bool Tokenizer::load(const QString &path, QString *error) {
+    bool ok = QFileInfo(path).suffix().toLower() == "txt" ? loadVocabTxt(path, error)
+                                                          : loadTokenizerJson(path, error);
+    if (ok) {
+        LOG_INFO(QString("Tokenizer loaded from %1: %2 vocabulary entries%3")
+                 .arg(path).arg(m_vocab.size()).arg(m_lowercase ? ", uncased" : ""));
+    }
+    return ok;
+}
+
+bool Tokenizer::loadTokenizerJson(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("Cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error) *error = QString("%1 is not a tokenizer.json: %2").arg(path, parseError.errorString());
+        return false;
+    }
+
+    QJsonObject root = doc.object();
+    const QJsonObject model = root["model"].toObject();
+    QString type = model["type"].toString();
+    if (type != "WordPiece") {
+        // BPE and Unigram merge by rank or probability, which a vocabulary lookup can't reproduce
+        if (error) *error = QString("%1: only WordPiece tokenizers are supported, not %2")
+                                .arg(path, type.isEmpty() ? QString("an unknown model") : type);
+        return false;
+    }
+
+    QJsonObject vocab = model["vocab"].toObject();
+    if (vocab.isEmpty()) {
+        if (error) *error = QString("%1 has an empty vocabulary").arg(path);
+        return false;
+    }
+
+    bool lowercase = false;
+    bool stripAccents = false;
+    readNormalizer(root["normalizer"].toObject(), lowercase, stripAccents);
+
+    m_vocab.clear();
+    m_vocab.reserve(vocab.size());
+    for (auto it = vocab.constBegin(); it != vocab.constEnd(); ++it) {
+        m_vocab.insert(it.key());
+    }
+    m_path = path;
+    m_subwordPrefix = model["continuing_subword_prefix"].toString("##");
+    m_maxWordChars = model["max_input_chars_per_word"].toInt(100);
+    m_lowercase = lowercase;
+    m_stripAccents = stripAccents;
+    return true;
+}
+
+bool Tokenizer::loadVocabTxt(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = QString("Cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    QSet<QString> vocab;
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while (!in.atEnd()) {
+        QString token = in.readLine().trimmed();
+        if (!token.isEmpty()) {
+            vocab.insert(token);
+        }
+    }
+    if (vocab.isEmpty()) {
+        if (error) *error = QString("%1 has an empty vocabulary").arg(path);
+        return false;
+    }
+
+    // A bare vocabulary says nothing about casing; uncased models are by far the common case
+    m_vocab = vocab;
+    m_path = path;
+    m_subwordPrefix = "##";
+    m_maxWordChars = 100;
+    m_lowercase = true;
+    m_stripAccents = true;
+    return true;
+}
+
+QVector<TokenSpan> Tokenizer::words(const QString &text) const {
+    QVector<TokenSpan> spans;
+    const int length = text.length();
+    int wordStart = -1;
+
+    auto endWord = [&](int end) {
+        if (wordStart >= 0) {
+            spans.append(TokenSpan{wordStart, end - wordStart, wordTokens(text.mid(wordStart, end - wordStart))});
+            wordStart = -1;
+        }
+    };
+
+    int i = 0;
+    while (i < length) {
+        uint ucs = text[i].unicode();
+        int width = 1;
+        if (text[i].isHighSurrogate() && i + 1 < length && text[i + 1].isLowSurrogate()) {
+            ucs = QChar::surrogateToUcs4(text[i], text[i + 1]);
+            width = 2;
+        }
+
+        if (QChar::isSpace(ucs)) {
+            endWord(i);
+        } else if (isIgnored(ucs)) {
+            // Dropped by normalization; the word continues
+        } else if (isPunctuation(ucs) || isCjk(ucs)) {
+            endWord(i);
+            spans.append(TokenSpan{i, width, 1});
+        } else if (wordStart < 0) {
+            wordStart = i;
+        }
+        i += width;
+    }
+    endWord(length);
+    return spans;
+}
+
+int Tokenizer::count(const QString &text) const {
+    int tokens = 0;
+    for (const TokenSpan &span : words(text)) {
+        tokens += span.tokens;
+    }
+    return tokens;
+}
+
+int Tokenizer::wordTokens(const QString &word) const {
+    if (!isExact()) {
+        return (word.length() + ESTIMATED_CHARS_PER_TOKEN - 1) / ESTIMATED_CHARS_PER_TOKEN;
+    }
+
+    QString normalized;
+    normalized.reserve(word.length());
+    for (QChar c : m_stripAccents ? word.normalized(QString::NormalizationForm_D) : word) {
+        if (isIgnored(c.unicode()) || (m_stripAccents && c.category() == QChar::Mark_NonSpacing)) {
+            continue;
+        }
+        normalized.append(c);
+    }
+    if (m_lowercase) {
+        normalized = normalized.toLower();
+    }
+    if (normalized.isEmpty()) {
+        return 0;
+    }
+    if (normalized.toUcs4().size() > m_maxWordChars) {
+        return 1;  // [UNK]
+    }
+
+    // Greedy longest match; if any part of the word has no piece, the whole word is one [UNK]
+    int tokens = 0;
+    int start = 0;
+    const int length = normalized.length();
+    while (start < length) {
+        int end = length;
+        for (; end > start; --end) {
+            QString piece = normalized.mid(start, end - start);
+            if (start > 0) {
+                piece.prepend(m_subwordPrefix);
+            }
+            if (m_vocab.contains(piece)) {
+                break;
+            }
+        }
+        if (end == start) {
+            return 1;
+        }
+        tokens++;
+        start = end;
+    }
+    return tokens;
+}
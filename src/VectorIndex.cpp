@@ -0,0 +1,398 @@
+/**
+ * VectorIndex.cpp - Flat cosine-similarity index with optional dimension reduction
+ */
+
+#include "VectorIndex.h"
+#include "Logger.h"
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QDir>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#ifdef HAVE_FAISS
+#include <faiss/utils/distances.h>
+#endif
+
+// Vectors stored at full width before the PCA projection is learned from them
+static const int PCA_TRAINING_SIZE = 1024;
+
+// Subspace iterations; recall stops improving after a few
+static const int PCA_ITERATIONS = 4;
+
+VectorIndex::VectorIndex()
+    : m_reduction(NoReduction)
+    , m_targetDimensions(0)
+    , m_inputDimensions(0)
+    , m_storedDimensions(0)
+    , m_count(0)
+    , m_mapped(nullptr)
+    , m_mappedCount(0) {
+}
+
+VectorIndex::~VectorIndex() = default;  // QTemporaryFile is complete here
+
+VectorIndex::Reduction VectorIndex::reductionFromString(const QString &name) {
+    QString lower = name.trimmed().toLower();
+    if (lower == "truncate") {
+        return Truncate;
+    }
+    if (lower == "pca") {
+        return PCA;
+    }
+    return NoReduction;
+}
+
+QString VectorIndex::reductionName(Reduction reduction) {
+    switch (reduction) {
+    case Truncate:
+        return "truncate";
+    case PCA:
+        return "pca";
+    default:
+        return "none";
+    }
+}
+
+int VectorIndex::trainingSize() {
+    return PCA_TRAINING_SIZE;
+}
+
+void VectorIndex::configure(Reduction reduction, int dimensions) {
+    m_reduction = reduction;
+    m_targetDimensions = qMax(0, dimensions);
+    clear();
+}
+
+void VectorIndex::clear() {
+    m_inputDimensions = 0;
+    m_storedDimensions = 0;
+    m_count = 0;
+    m_vectors.clear();
+    m_mean.clear();
+    m_components.clear();
+    dropSpillFile();
+}
+
+void VectorIndex::dropSpillFile() {
+    m_spillFile.reset();  // Closing unmaps; the temporary file is removed
+    m_mapped = nullptr;
+    m_mappedCount = 0;
+}
+
+const float *VectorIndex::storedRow(int position) const {
+    if (position < m_mappedCount) {
+        return m_mapped + static_cast<qint64>(position) * m_storedDimensions;
+    }
+    return m_vectors.constData() + static_cast<qint64>(position - m_mappedCount) * m_storedDimensions;
+}
+
+bool VectorIndex::reduces() const {
+    return m_reduction != NoReduction && m_targetDimensions > 0
+           && (m_inputDimensions == 0 || m_targetDimensions < m_inputDimensions);
+}
+
+qint64 VectorIndex::memoryBytes() const {
+    return static_cast<qint64>(m_vectors.size() + m_mean.size() + m_components.size()) * sizeof(float);
+}
+
+qint64 VectorIndex::mappedBytes() const {
+    return static_cast<qint64>(m_mappedCount) * m_storedDimensions * sizeof(float);
+}
+
+bool VectorIndex::spill() {
+    if (m_vectors.isEmpty()) {
+        return true;
+    }
+
+    if (!m_spillFile) {
+        m_spillFile.reset(new QTemporaryFile(QDir::tempPath() + "/qtbot-vectors-XXXXXX"));
+        if (!m_spillFile->open()) {
+            LOG_WARNING(QString("Cannot spill vectors: %1").arg(m_spillFile->errorString()));
+            m_spillFile.reset();
+            return false;
+        }
+    }
+
+    // Append the heap rows after those already in the file, then map the whole file again
+    qint64 offset = mappedBytes();
+    qint64 bytes = static_cast<qint64>(m_vectors.size()) * sizeof(float);
+    if (!m_spillFile->seek(offset)
+        || m_spillFile->write(reinterpret_cast<const char*>(m_vectors.constData()), bytes) != bytes
+        || !m_spillFile->flush()) {
+        LOG_WARNING(QString("Cannot spill vectors to %1: %2").arg(m_spillFile->fileName(), m_spillFile->errorString()));
+        return false;
+    }
+
+    uchar *map = m_spillFile->map(0, offset + bytes);
+    if (!map) {
+        LOG_WARNING(QString("Cannot map %1: %2").arg(m_spillFile->fileName(), m_spillFile->errorString()));
+        return false;
+    }
+    if (m_mapped) {
+        m_spillFile->unmap(reinterpret_cast<uchar*>(const_cast<float*>(m_mapped)));
+    }
+
+    m_mapped = reinterpret_cast<const float*>(map);
+    m_mappedCount = m_count;
+    m_vectors.clear();
+    m_vectors.squeeze();
+
+    LOG_INFO(QString("Spilled %1 vectors (%2 KB) to %3")
+             .arg(m_count).arg((offset + bytes) / 1024).arg(m_spillFile->fileName()));
+    return true;
+}
+
+float VectorIndex::dot(const float *a, const float *b, int n) {
+#ifdef HAVE_FAISS
+    return faiss::fvec_inner_product(a, b, n);
+#else
+    // Independent accumulators, so the compiler can keep them in vector registers
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0, s5 = 0, s6 = 0, s7 = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+        s4 += a[i + 4] * b[i + 4];
+        s5 += a[i + 5] * b[i + 5];
+        s6 += a[i + 6] * b[i + 6];
+        s7 += a[i + 7] * b[i + 7];
+    }
+    for (; i < n; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return ((s0 + s1) + (s2 + s3)) + ((s4 + s5) + (s6 + s7));
+#endif
+}
+
+void VectorIndex::normalize(float *v, int n) {
+    float norm = std::sqrt(dot(v, v, n));
+    if (norm > 0.0f) {
+        float scale = 1.0f / norm;
+        for (int i = 0; i < n; ++i) {
+            v[i] *= scale;
+        }
+    }
+}
+
+QVector<float> VectorIndex::transform(const QVector<float> &embedding) const {
+    QVector<float> v = embedding;
+
+    if (reduces() && m_reduction == Truncate) {
+        v.resize(m_targetDimensions);
+    } else if (reduces() && isTrained()) {
+        normalize(v.data(), v.size());
+        for (int i = 0; i < v.size(); ++i) {
+            v[i] -= m_mean[i];
+        }
+        QVector<float> projected(m_targetDimensions);
+        for (int j = 0; j < m_targetDimensions; ++j) {
+            projected[j] = dot(m_components.constData() + j * m_inputDimensions, v.constData(), m_inputDimensions);
+        }
+        v = projected;
+    }
+
+    normalize(v.data(), v.size());
+    return v;
+}
+
+int VectorIndex::add(const QVector<float> &embedding) {
+    if (embedding.isEmpty()) {
+        return -1;
+    }
+
+    if (m_inputDimensions == 0) {
+        m_inputDimensions = embedding.size();
+        m_storedDimensions = (reduces() && m_reduction == Truncate) ? m_targetDimensions : m_inputDimensions;
+        if (m_reduction != NoReduction && m_targetDimensions >= m_inputDimensions) {
+            LOG_WARNING(QString("Embeddings have %1 dimensions, not more than the %2 requested; keeping them whole")
+                        .arg(m_inputDimensions).arg(m_targetDimensions));
+        }
+    } else if (embedding.size() != m_inputDimensions) {
+        return -1;
+    }
+
+    m_vectors += transform(embedding);
+    int position = m_count++;
+
+    if (m_reduction == PCA && reduces() && !isTrained() && m_count >= PCA_TRAINING_SIZE) {
+        train();
+    }
+    return position;
+}
+
+void VectorIndex::remove(const QVector<int> &positions) {
+    QVector<bool> removed(m_count, false);
+    int removedCount = 0;
+    for (int position : positions) {
+        if (position >= 0 && position < m_count && !removed[position]) {
+            removed[position] = true;
+            removedCount++;
+        }
+    }
+    if (removedCount == 0) {
+        return;
+    }
+
+    QVector<float> kept((m_count - removedCount) * m_storedDimensions);
+    float *out = kept.data();
+    for (int i = 0; i < m_count; ++i) {
+        if (!removed[i]) {
+            const float *row = storedRow(i);
+            out = std::copy(row, row + m_storedDimensions, out);
+        }
+    }
+
+    dropSpillFile();
+    m_vectors = kept;
+    m_count -= removedCount;
+}
+
+QVector<int> VectorIndex::search(const QVector<float> &query, int topK) const {
+    QVector<int> positions;
+    if (m_count == 0 || topK <= 0 || query.size() != m_inputDimensions) {
+        return positions;
+    }
+
+    const QVector<float> q = transform(query);
+    const float *row = m_mapped;
+
+    // Best topK so far, in descending score order; a new score only goes in if it beats the last
+    QVector<float> scores;
+    positions.reserve(topK + 1);
+    scores.reserve(topK + 1);
+    for (int i = 0; i < m_count; ++i, row += m_storedDimensions) {
+        if (i == m_mappedCount) {
+            row = m_vectors.constData();  // Past the spilled rows
+        }
+        float score = dot(q.constData(), row, m_storedDimensions);
+        if (scores.size() == topK && score <= scores.last()) {
+            continue;
+        }
+        int slot = scores.size();
+        while (slot > 0 && scores[slot - 1] < score) {
+            --slot;
+        }
+        scores.insert(slot, score);
+        positions.insert(slot, i);
+        if (scores.size() > topK) {
+            scores.removeLast();
+            positions.removeLast();
+        }
+    }
+    return positions;
+}
+
+void VectorIndex::train() {
+    if (m_reduction != PCA || !reduces() || isTrained() || m_count < 2) {
+        return;
+    }
+
+    const int n = m_count;
+    const int d = m_inputDimensions;
+    const int k = m_targetDimensions;
+    QElapsedTimer timer;
+    timer.start();
+
+    // Stored rows are still full width and normalized
+    m_mean.fill(0.0f, d);
+    for (int r = 0; r < n; ++r) {
+        const float *x = storedRow(r);
+        for (int i = 0; i < d; ++i) {
+            m_mean[i] += x[i];
+        }
+    }
+    for (int i = 0; i < d; ++i) {
+        m_mean[i] /= n;
+    }
+
+    // Covariance, upper triangle first, then mirrored
+    QVector<float> covariance(d * d, 0.0f);
+    QVector<float> centered(d);
+    for (int r = 0; r < n; ++r) {
+        const float *x = storedRow(r);
+        for (int i = 0; i < d; ++i) {
+            centered[i] = x[i] - m_mean[i];
+        }
+        for (int i = 0; i < d; ++i) {
+            float ci = centered[i];
+            float *out = covariance.data() + i * d;
+            for (int j = i; j < d; ++j) {
+                out[j] += ci * centered[j];
+            }
+        }
+    }
+    for (int i = 0; i < d; ++i) {
+        for (int j = 0; j < i; ++j) {
+            covariance[i * d + j] = covariance[j * d + i];
+        }
+    }
+
+    // Orthonormalize the rows of basis (k rows of d); a row that collapses is replaced by a unit vector
+    auto orthonormalize = [d, k](QVector<float> &basis) {
+        int fallback = 0;
+        for (int j = 0; j < k; ++j) {
+            float *v = basis.data() + j * d;
+            for (int attempt = 0; attempt <= d; ++attempt) {
+                for (int p = 0; p < j; ++p) {
+                    const float *u = basis.constData() + p * d;
+                    float projection = dot(v, u, d);
+                    for (int i = 0; i < d; ++i) {
+                        v[i] -= projection * u[i];
+                    }
+                }
+                float norm = std::sqrt(dot(v, v, d));
+                if (norm > 1e-6f) {
+                    for (int i = 0; i < d; ++i) {
+                        v[i] /= norm;
+                    }
+                    break;
+                }
+                std::fill(v, v + d, 0.0f);
+                v[fallback++ % d] = 1.0f;
+            }
+        }
+    };
+
+    // Subspace iteration converges on the span of the k leading eigenvectors
+    std::mt19937 rng(1);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    QVector<float> basis(k * d);
+    for (float &value : basis) {
+        value = dist(rng);
+    }
+    orthonormalize(basis);
+
+    QVector<float> next(k * d);
+    for (int iteration = 0; iteration < PCA_ITERATIONS; ++iteration) {
+        for (int j = 0; j < k; ++j) {
+            const float *v = basis.constData() + j * d;
+            float *out = next.data() + j * d;
+            for (int i = 0; i < d; ++i) {
+                out[i] = dot(covariance.constData() + i * d, v, d);
+            }
+        }
+        orthonormalize(next);
+        basis.swap(next);
+    }
+    m_components = basis;
+
+    // Reproject what is stored, spilled rows included; transform() renormalizes,
+    // which the rows already are
+    QVector<float> projected;
+    projected.reserve(n * k);
+    QVector<float> full(d);
+    for (int r = 0; r < n; ++r) {
+        std::copy(storedRow(r), storedRow(r) + d, full.begin());
+        projected += transform(full);
+    }
+    m_vectors = projected;
+    dropSpillFile();
+    m_storedDimensions = k;
+
+    LOG_INFO(QString("Learned PCA projection %1 -> %2 dimensions from %3 vectors in %4 ms")
+             .arg(d).arg(k).arg(n).arg(timer.elapsed()));
+}
@@ -1,8 +1,9 @@
 /**
- * main.cpp - Application entry point and built-in tool definitions
+ * main.cpp - Application entry point
  * 
- * Handles application initialization, command-line parsing, mode selection
- * (GUI/CLI/test/server), and defines built-in MCP tools (calculator, datetime).
+ * Handles application initialization, command-line parsing and mode selection
+ * (GUI/CLI/test/server). Headless modes are shared with qtbot-cli through
+ * CommandLine.h; built-in MCP tools live in BuiltinTools.cpp.
  */
 
 #include <QApplication>
@@ -57,71 +58,18 @@
 #include "SettingsDialog.h"
 #include "LogViewerDialog.h"
 #include "MCPHandler.h"
-#include "TestMCPStdioServer.h"
 #include "RAGEngine.h"
 #include "MarkdownHandler.h"
 #include "HTMLHandler.h"
 #include "DiagnosticTests.h"
-#include "CLIMode.h"
 #include "ConversationManager.h"
 #include "MessageRenderer.h"
 #include "ToolUIManager.h"
 #include "RAGUIManager.h"
 #include "ChatWindow.h"
-
-// Example MCP Tools (must be defined before ChatWindow)
-QJsonObject exampleCalculatorTool(const QJsonObject &params) {
-    // Simple calculator tool
-    QString operation = params["operation"].toString();
-    double a = params["a"].toDouble();
-    double b = params["b"].toDouble();
-    double result = 0.0;
-
-    if (operation == "add") {
-        result = a + b;
-    } else if (operation == "subtract") {
-        result = a - b;
-    } else if (operation == "multiply") {
-        result = a * b;
-    } else if (operation == "divide") {
-        if (b != 0) {
-            result = a / b;
-        } else {
-            QJsonObject error;
-            error["error"] = "Division by zero";
-            return error;
-        }
-    }
-
-    QJsonObject response;
-    response["result"] = result;
-    response["operation"] = operation;
-    response["a"] = a;
-    response["b"] = b;
-    return response;
-}
-
-QJsonObject exampleDateTimeTool(const QJsonObject &params) {
-    // Time and date tool
-    QString format = params["format"].toString("long");
-    QJsonObject response;
-    QDateTime now = QDateTime::currentDateTime();
-
-    if (format == "short") {
-        response["date"] = now.toString("yyyy-MM-dd");
-        response["time"] = now.toString("HH:mm:ss");
-    } else if (format == "iso") {
-        response["datetime"] = now.toString(Qt::ISODate);
-    } else if (format == "timestamp") {
-        response["timestamp"] = now.toMSecsSinceEpoch();
-    } else {
-        response["date"] = now.toString("dddd, MMMM d, yyyy");
-        response["time"] = now.toString("h:mm:ss AP");
-        response["timezone"] = now.timeZoneAbbreviation();
-    }
-
-    return response;
-}
+#include "CommandLine.h"
+#include "StartupProfiler.h"
+#include "MemoryGovernor.h"
 
 // Custom message handler for log viewer
 void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
@@ -136,36 +84,22 @@ void customMessageHandler(QtMsgType type, const QMessageLogContext &context, con
 }
 
 int main(int argc, char *argv[]) {
+    // Time every phase from here until the window is interactive
+    StartupProfiler::instance().start();
+
     // Disable X11 MIT-SHM extension to work around Qt/X11 buffer overflow bug
     // in xcb_shm_detach_checked during widget backing store cleanup
     qputenv("QT_X11_NO_MITSHM", "1");
 
-    // Check if CLI/server/test mode is requested (before creating QApplication)
-    bool cliMode = false;
-    bool serverMode = false;
-    bool testMode = false;
-    for (int i = 1; i < argc; ++i) {
-        QString arg = QString(argv[i]);
-        if (arg == "--cli") {
-            cliMode = true;
-            break;
-        }
-        if (arg == "--test-mcp-stdio") {
-            serverMode = true;
-            break;
-        }
-        if (arg == "--mcp-test" || arg == "--rag-test" || arg == "--unit-tests") {
-            testMode = true;
-            break;
-        }
-    }
-
     // Use QCoreApplication for CLI/server/test mode, QApplication for GUI mode
     QCoreApplication *app;
-    if (cliMode || serverMode || testMode) {
-        app = new QCoreApplication(argc, argv);
-    } else {
-        app = new QApplication(argc, argv);
+    {
+        StartupPhase phase("Application object");
+        if (isHeadlessInvocation(argc, argv)) {
+            app = new QCoreApplication(argc, argv);
+        } else {
+            app = new QApplication(argc, argv);
+        }
     }
 
     QCoreApplication::setApplicationName(APP_NAME);
@@ -173,92 +107,40 @@ int main(int argc, char *argv[]) {
 
     // Initialize Logger FIRST (creates log file and directory if needed)
     // Install Logger's message handler so all qDebug/qInfo/qWarning/qCritical go to log file
-    Logger::instance().init("", true);
+    {
+        StartupPhase phase("Logger");
+        Logger::instance().init("", true);
+    }
 
     // Now we can start logging
     LOG_INFO(QString("Starting %1 v%2").arg(APP_NAME, APP_VERSION));
 
     // Load configuration
-    if (!Config::instance().load()) {
-        LOG_WARNING("Failed to load configuration, using defaults");
+    {
+        StartupPhase phase("Config load");
+        if (!Config::instance().load()) {
+            LOG_WARNING("Failed to load configuration, using defaults");
+        }
     }
 
-    // Setup command line parser
+    // Setup command line parser (options are shared with qtbot-cli)
     QCommandLineParser parser;
-    parser.setApplicationDescription(APP_DESCRIPTION);
-    parser.addHelpOption();
-    parser.addVersionOption();
-
-    // CLI options
-    QCommandLineOption cliOption("cli", "Run in CLI-only mode");
-    parser.addOption(cliOption);
-
-    QCommandLineOption promptOption("prompt", "Text prompt for the model", "text");
-    parser.addOption(promptOption);
-
-    QCommandLineOption contextOption("context", "Load file or folder into RAG", "path");
-    parser.addOption(contextOption);
-
-    QCommandLineOption modelOption("model", "Override default model", "name");
-    parser.addOption(modelOption);
-
-    QCommandLineOption logLevelOption("log-level",
-        "Set verbosity (debug|info|warn|error)", "level", "info");
-    parser.addOption(logLevelOption);
-
-    QCommandLineOption mcpTestOption("mcp-test",
-        "Run Model Context Protocol diagnostic");
-    parser.addOption(mcpTestOption);
-
-    QCommandLineOption ragTestOption("rag-test", "Test retrieval pipeline");
-    parser.addOption(ragTestOption);
-
-    QCommandLineOption unitTestsOption("unit-tests", "Execute unit test suite");
-    parser.addOption(unitTestsOption);
-
-    QCommandLineOption testMCPStdioOption("test-mcp-stdio",
-        "Run test MCP server in stdio mode (for testing MCP integration)");
-    parser.addOption(testMCPStdioOption);
+    int parsePhase = StartupProfiler::instance().beginPhase("Command line");
+    addCommandLineOptions(parser);
 
     // Process arguments
     parser.process(*app);
 
-    // Set log level
-    QString logLevel = parser.value(logLevelOption).toLower();
-    if (logLevel == "debug") {
-        Logger::instance().setLogLevel(Logger::Debug);
-    } else if (logLevel == "warn") {
-        Logger::instance().setLogLevel(Logger::Warning);
-    } else if (logLevel == "error") {
-        Logger::instance().setLogLevel(Logger::Error);
-    } else {
-        Logger::instance().setLogLevel(Logger::Info);
-    }
-
-    // Override config with command line options if provided
-    if (parser.isSet(modelOption)) {
-        QString modelName = parser.value(modelOption);
-        Config::instance().setModel(modelName);
-        LOG_INFO(QString("Model overridden from command line: %1").arg(modelName));
-    }
-
-    // Log current configuration
-    LOG_DEBUG(QString("Backend: %1").arg(Config::instance().getBackend()));
-    LOG_DEBUG(QString("Model: %1").arg(Config::instance().getModel()));
-    LOG_DEBUG(QString("API URL: %1").arg(Config::instance().getApiUrl()));
-
-    // Check if test MCP stdio server mode
-    if (parser.isSet(testMCPStdioOption)) {
-        LOG_INFO("Starting test MCP stdio server");
-        int result = runTestMCPStdioServer();
+    if (!applyCommandLineOptions(parser)) {
         delete app;
-        return result;
+        return 1;
     }
+    StartupProfiler::instance().endPhase(parsePhase);
 
-    // Check if CLI mode or test modes
-    if (parser.isSet(cliOption) || parser.isSet(mcpTestOption) || parser.isSet(ragTestOption) || parser.isSet(unitTestsOption)) {
-        LOG_INFO("Entering CLI mode");
-        int result = runCLI(parser);
+    // CLI, batch, bench, daemon, MCP stdio server and diagnostic modes
+    if (hasHeadlessMode(parser)) {
+        StartupProfiler::instance().finish("ready");
+        int result = runHeadlessMode(parser);
         delete app;
         return result;
     }
@@ -273,17 +155,37 @@ int main(int argc, char *argv[]) {
     }
 
     // Apply default theme
-    ThemeManager::instance().setTheme(ThemeManager::Light);
-    ThemeManager::instance().applyTheme(guiApp);
+    {
+        StartupPhase phase("Theme");
+        ThemeManager::instance().setTheme(ThemeManager::Light);
+        ThemeManager::instance().applyTheme(guiApp);
+    }
 
     // Install custom message handler for log viewer
     qInstallMessageHandler(customMessageHandler);
 
+    int windowPhase = StartupProfiler::instance().beginPhase("ChatWindow");
     ChatWindow window;
-    window.show();
+    StartupProfiler::instance().endPhase(windowPhase);
+
+    {
+        StartupPhase phase("Show window");
+        window.show();
+    }
+
+    // Report once the first frame is painted and the event loop is idle
+    StartupProfiler::instance().finishOnFirstPaint(&window);
+
+    // Hot-reload settings when config.json is edited outside the app
+    Config::instance().watchConfigFile();
+
+    // Enforce memory_budget_mb for the lifetime of the window
+    MemoryGovernor::instance().start();
 
     int result = app->exec();
 
+    Config::instance().stopWatchingConfigFile();
+
     // Uninstall custom message handler before destruction to prevent
     // logging during Qt widget cleanup (which can cause X11/XCB crashes)
     qInstallMessageHandler(nullptr);
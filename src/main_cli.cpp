@@ -0,0 +1,54 @@
+/**
+ * main_cli.cpp - Entry point of the headless qtbot-cli binary
+ *
+ * Links only qtbot-core and the headless modes (QtCore/QtNetwork), so
+ * scripted runs skip loading the Widgets/Gui stack. Accepts the same
+ * options as qt-chatbot-agent and defaults to CLI mode.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "version.h"
+#include "Logger.h"
+#include "Config.h"
+#include "CommandLine.h"
+#include "StartupProfiler.h"
+
+int main(int argc, char *argv[]) {
+    StartupProfiler::instance().start();
+
+    int appPhase = StartupProfiler::instance().beginPhase("Application object");
+    QCoreApplication app(argc, argv);
+    StartupProfiler::instance().endPhase(appPhase);
+    QCoreApplication::setApplicationName(APP_NAME);
+    QCoreApplication::setApplicationVersion(APP_VERSION);
+
+    // Install Logger's message handler so all qDebug/qInfo/qWarning/qCritical go to log file
+    {
+        StartupPhase phase("Logger");
+        Logger::instance().init("", true);
+    }
+    LOG_INFO(QString("Starting %1 v%2 (qtbot-cli)").arg(APP_NAME, APP_VERSION));
+
+    // Load configuration
+    {
+        StartupPhase phase("Config load");
+        if (!Config::instance().load()) {
+            LOG_WARNING("Failed to load configuration, using defaults");
+        }
+    }
+
+    QCommandLineParser parser;
+    int parsePhase = StartupProfiler::instance().beginPhase("Command line");
+    addCommandLineOptions(parser);
+    parser.process(app);
+
+    if (!applyCommandLineOptions(parser)) {
+        return 1;
+    }
+    StartupProfiler::instance().endPhase(parsePhase);
+    StartupProfiler::instance().finish("ready");
+
+    // No mode option means --cli
+    return runHeadlessMode(parser);
+}
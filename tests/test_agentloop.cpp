@@ -0,0 +1,251 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QThread>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <stdexcept>
+#include "../include/AgentLoop.h"
+#include "../include/MCPHandler.h"
+#include "../include/MockOllamaServer.h"
+#include "../include/LLMClient.h"
+#include "../include/Config.h"
+
+// A tool slow enough that running steps one after another is measurable
+static QJsonObject slowAddTool(const QJsonObject &params) {
+    QThread::msleep(200);
+    return QJsonObject{{"result", params["a"].toDouble() + params["b"].toDouble()}};
+}
+
+static QJsonObject failingTool(const QJsonObject &) {
+    throw std::runtime_error("backend unavailable");
+}
+
+class TestAgentLoop : public QObject {
+    Q_OBJECT
+
+private:
+    void registerTools(MCPHandler &handler) {
+        MCPTool addTool;
+        addTool.name = "add";
+        addTool.description = "Adds two numbers";
+        addTool.isLocal = true;
+        addTool.function = slowAddTool;
+        addTool.parameters = QJsonObject{{"a", "number"}, {"b", "number"}};
+        handler.registerTool(addTool);
+
+        MCPTool failTool;
+        failTool.name = "fail";
+        failTool.description = "Always fails";
+        failTool.isLocal = true;
+        failTool.function = failingTool;
+        handler.registerTool(failTool);
+    }
+
+    // Client pointed at the mock, with capabilities taken from its /api/show
+    LLMClient *createClient(MockOllamaServer &server) {
+        LLMClient *client = new LLMClient(this);
+        client->setApiUrl(server.generateUrl());
+        client->setMaxRetries(0);
+
+        QSignalSpy capabilitiesSpy(client, &LLMClient::modelCapabilitiesDetected);
+        if (!capabilitiesSpy.wait(5000)) {
+            delete client;
+            return nullptr;
+        }
+        return client;
+    }
+
+private slots:
+    void initTestCase() {
+        Config::instance().resetToDefaults();
+    }
+
+    void testReferencedSteps() {
+        QJsonObject arguments{
+            {"a", "{{step:3}}"},
+            {"text", "sum of {{step:1}} and {{step:3}}"},
+            {"nested", QJsonArray{QJsonObject{{"x", "{{step:2}}"}}}},
+            {"plain", 5}
+        };
+        QCOMPARE(AgentLoop::referencedSteps(arguments), (QList<int>{1, 2, 3}));
+        QVERIFY(AgentLoop::referencedSteps(QJsonObject{{"a", "{{step:x}}"}}).isEmpty());
+    }
+
+    void testIndependentStepsRunConcurrently() {
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(nullptr, &handler);
+
+        for (int i = 0; i < 3; ++i) {
+            QCOMPARE(agent.addStep("add", QJsonObject{{"a", i}, {"b", 1}}), i + 1);
+        }
+
+        QSignalSpy finishedSpy(&agent, &AgentLoop::finished);
+        QVERIFY(agent.start("three independent additions"));
+        QVERIFY(finishedSpy.wait(5000));
+
+        QCOMPARE(agent.stopReason(), AgentLoop::PlanCompleted);
+        for (const AgentStep &step : agent.steps()) {
+            QCOMPARE(step.state, AgentStep::Succeeded);
+        }
+        QCOMPARE(agent.steps()[2].result["result"].toDouble(), 3.0);
+
+        // Three 200 ms steps side by side, not one after another: every step starts before any ends
+        QList<AgentSpan> timeline = agent.timeline();
+        QCOMPARE(timeline.size(), 3);
+        for (const AgentSpan &span : timeline) {
+            QCOMPARE(span.kind, QString("tool"));
+            for (const AgentSpan &other : timeline) {
+                QVERIFY(span.startMs < other.endMs);
+            }
+        }
+        QCOMPARE(agent.timelineJson().size(), 3);
+        QVERIFY(agent.formatTimeline().contains("add"));
+    }
+
+    void testDependentStepWaitsForResults() {
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(nullptr, &handler);
+
+        int first = agent.addStep("add", QJsonObject{{"a", 1}, {"b", 2}});
+        int second = agent.addStep("add", QJsonObject{{"a", 10}, {"b", 20}});
+        int sum = agent.addStep("add", QJsonObject{{"a", "{{step:1}}"}, {"b", "{{step:2}}"}});
+        QCOMPARE(agent.steps()[sum - 1].dependsOn, (QList<int>{first, second}));
+
+        QSignalSpy finishedSpy(&agent, &AgentLoop::finished);
+        QVERIFY(agent.start("add in two rounds"));
+        QVERIFY(finishedSpy.wait(5000));
+
+        QList<AgentStep> steps = agent.steps();
+        QCOMPARE(steps[sum - 1].state, AgentStep::Succeeded);
+        QCOMPARE(steps[sum - 1].result["result"].toDouble(), 33.0);
+        QVERIFY(steps[sum - 1].startMs >= qMax(steps[first - 1].endMs, steps[second - 1].endMs));
+    }
+
+    void testFailedDependencySkipsStep() {
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(nullptr, &handler);
+
+        int failed = agent.addStep("fail", QJsonObject());
+        int dependent = agent.addStep("add", QJsonObject{{"a", "{{step:1}}"}, {"b", 1}});
+        int independent = agent.addStep("add", QJsonObject{{"a", 1}, {"b", 1}});
+
+        QSignalSpy stepSpy(&agent, &AgentLoop::stepFinished);
+        QSignalSpy finishedSpy(&agent, &AgentLoop::finished);
+        QVERIFY(agent.start("one failure"));
+        QVERIFY(finishedSpy.wait(5000));
+
+        QList<AgentStep> steps = agent.steps();
+        QCOMPARE(steps[failed - 1].state, AgentStep::Failed);
+        QVERIFY(steps[failed - 1].error.contains("backend unavailable"));
+        QCOMPARE(steps[dependent - 1].state, AgentStep::Skipped);
+        QCOMPARE(steps[independent - 1].state, AgentStep::Succeeded);
+        QCOMPARE(stepSpy.count(), 3);
+    }
+
+    void testUnknownDependencyRejected() {
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(nullptr, &handler);
+
+        QCOMPARE(agent.addStep("add", QJsonObject{{"a", "{{step:1}}"}, {"b", 1}}), -1);
+        QCOMPARE(agent.addStep("add", QJsonObject{{"a", 1}, {"b", 1}}, QList<int>{2}), -1);
+        QVERIFY(agent.steps().isEmpty());
+    }
+
+    void testTimeBudgetStopsTask() {
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(nullptr, &handler);
+
+        AgentBudget budget;
+        budget.maxTimeMs = 50;
+        agent.setBudget(budget);
+        agent.addStep("add", QJsonObject{{"a", 1}, {"b", 1}});
+        agent.addStep("add", QJsonObject{{"a", "{{step:1}}"}, {"b", 1}});
+
+        QSignalSpy finishedSpy(&agent, &AgentLoop::finished);
+        QVERIFY(agent.start("too slow"));
+        QVERIFY(finishedSpy.wait(5000));
+
+        QCOMPARE(agent.stopReason(), AgentLoop::TimeBudget);
+        QCOMPARE(agent.steps()[0].state, AgentStep::Failed);
+        QCOMPARE(agent.steps()[1].state, AgentStep::Skipped);
+
+        // The late result of the stopped step is dropped
+        QTest::qWait(300);
+        QCOMPARE(agent.steps()[0].state, AgentStep::Failed);
+        QVERIFY(!agent.isRunning());
+    }
+
+    void testModelAnswersAfterToolTurn() {
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        options.toolCallName = "add";
+        options.toolCallArguments = QJsonObject{{"a", 2}, {"b", 3}};
+        options.responseTokens = 5;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(client, &handler);
+
+        QSignalSpy finishedSpy(&agent, &AgentLoop::finished);
+        QVERIFY(agent.start("what is 2 + 3?", handler.getToolsForLLMNative()));
+        QVERIFY(finishedSpy.wait(10000));
+
+        // Turn 1 calls the tool; turn 2 sees its result and answers
+        QCOMPARE(agent.stopReason(), AgentLoop::Answered);
+        QCOMPARE(agent.iterations(), 2);
+        QCOMPARE(agent.steps().size(), 1);
+        QCOMPARE(agent.steps()[0].result["result"].toDouble(), 5.0);
+        QCOMPARE(agent.steps()[0].iteration, 1);
+        QVERIFY(!agent.answer().isEmpty());
+        QVERIFY(agent.tokensUsed() > 0);
+
+        int modelSpans = 0;
+        for (const AgentSpan &span : agent.timeline()) {
+            if (span.kind == "model") {
+                ++modelSpans;
+            }
+        }
+        QCOMPARE(modelSpans, 2);
+        delete client;
+    }
+
+    void testIterationCap() {
+        // Prompt format: the mock calls the tool on every turn
+        MockOllamaOptions options;
+        options.toolCallName = "add";
+        options.toolCallArguments = QJsonObject{{"a", 1}, {"b", 1}};
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+        MCPHandler handler;
+        registerTools(handler);
+        AgentLoop agent(client, &handler);
+
+        AgentBudget budget;
+        budget.maxIterations = 2;
+        agent.setBudget(budget);
+
+        QSignalSpy finishedSpy(&agent, &AgentLoop::finished);
+        QVERIFY(agent.start("keep adding", handler.getToolsForLLM()));
+        QVERIFY(finishedSpy.wait(10000));
+
+        QCOMPARE(agent.stopReason(), AgentLoop::MaxIterations);
+        QCOMPARE(agent.iterations(), 2);
+        QCOMPARE(agent.steps().size(), 2);
+        delete client;
+    }
+};
+
+QTEST_MAIN(TestAgentLoop)
+#include "test_agentloop.moc"
@@ -0,0 +1,143 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "../include/BatchRunner.h"
+#include "../include/Config.h"
+#include <unistd.h>
+
+class TestBatchRunner : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    static bool writeLines(const QString &path, const QList<QByteArray> &lines) {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        for (const QByteArray &line : lines) {
+            file.write(line + "\n");
+        }
+        return true;
+    }
+
+    static QList<QJsonObject> readRecords(const QString &path) {
+        QList<QJsonObject> records;
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly)) {
+            while (!file.atEnd()) {
+                QByteArray line = file.readLine().trimmed();
+                if (!line.isEmpty()) {
+                    records.append(QJsonDocument::fromJson(line).object());
+                }
+            }
+        }
+        return records;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        Config::instance().resetToDefaults();
+        Config::instance().setRagEnabled(false);
+    }
+
+    void testMissingInputFails() {
+        BatchOptions options;
+        options.inputPath = m_dir.filePath("does-not-exist.jsonl");
+        options.outputPath = m_dir.filePath("missing-out.jsonl");
+
+        BatchRunner runner(options);
+        QVERIFY(!runner.start());
+    }
+
+    void testResumeSkipsCompletedPrompts() {
+        QString input = m_dir.filePath("in.jsonl");
+        QString output = m_dir.filePath("out.jsonl");
+
+        // "a" (explicit id) and line 2 (plain text, id = line number) already succeeded
+        QVERIFY(writeLines(input, {
+            R"({"id": "a", "prompt": "first"})",
+            "second prompt as plain text",
+            ""
+        }));
+        QVERIFY(writeLines(output, {
+            R"({"id": "a", "response": "done", "error": null})",
+            R"({"id": "2", "response": "done", "error": null})"
+        }));
+
+        BatchOptions options;
+        options.inputPath = input;
+        options.outputPath = output;
+        options.resume = true;
+
+        BatchRunner runner(options);
+        QSignalSpy finishedSpy(&runner, &BatchRunner::finished);
+        QVERIFY(runner.start());
+
+        // Slots are filled once capability detection completes or times out
+        QVERIFY(finishedSpy.wait(20000));
+        QVERIFY(finishedSpy.at(0).at(0).toBool());
+        QCOMPARE(runner.skippedCount(), 2);
+        QCOMPARE(runner.completedCount(), 0);
+        QCOMPARE(runner.failedCount(), 0);
+
+        // Existing records are kept, nothing new is appended
+        QList<QJsonObject> records = readRecords(output);
+        QCOMPARE(records.size(), 2);
+        QCOMPARE(records[0]["id"].toString(), QString("a"));
+    }
+
+    void testStdinIsReadAsItArrives() {
+        QString output = m_dir.filePath("stdin-out.jsonl");
+
+        // stdin becomes a pipe the test writes to, a line at a time
+        int fds[2];
+        QVERIFY(::pipe(fds) == 0);
+        int savedStdin = ::dup(STDIN_FILENO);
+        QVERIFY(::dup2(fds[0], STDIN_FILENO) >= 0);
+        ::close(fds[0]);
+
+        BatchOptions options;
+        options.inputPath = "-";
+        options.outputPath = output;
+
+        {
+            BatchRunner runner(options);
+            QSignalSpy finishedSpy(&runner, &BatchRunner::finished);
+            QVERIFY(runner.start());
+
+            // Empty prompts fail without a model, so records appear as soon as lines do
+            QByteArray first = R"({"id": "first", "prompt": ""})" "\n";
+            QCOMPARE(::write(fds[1], first.constData(), first.size()), ssize_t(first.size()));
+            QTRY_COMPARE_WITH_TIMEOUT(readRecords(output).size(), 1, 20000);
+            QCOMPARE(finishedSpy.count(), 0);
+
+            // The last line has no newline; it still counts once the pipe closes
+            QByteArray second = R"({"id": "second", "prompt": ""})";
+            QCOMPARE(::write(fds[1], second.constData(), second.size()), ssize_t(second.size()));
+            ::close(fds[1]);
+            QVERIFY(finishedSpy.wait(5000));
+            QCOMPARE(runner.failedCount(), 2);
+
+            // Both completions queued a refill; the batch still finishes once
+            QTest::qWait(100);
+            QCOMPARE(finishedSpy.count(), 1);
+        }
+
+        ::dup2(savedStdin, STDIN_FILENO);
+        ::close(savedStdin);
+
+        QList<QJsonObject> records = readRecords(output);
+        QCOMPARE(records.size(), 2);
+        QCOMPARE(records[1]["id"].toString(), QString("second"));
+        QCOMPARE(records[1]["error"].toString(), QString("Empty prompt"));
+    }
+};
+
+QTEST_MAIN(TestBatchRunner)
+#include "test_batchrunner.moc"
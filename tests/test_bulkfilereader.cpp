@@ -0,0 +1,116 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../include/BulkFileReader.h"
+
+class TestBulkFileReader : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QStringList m_paths;
+    QList<QByteArray> m_contents;
+
+    static QByteArray content(int index, int size) {
+        QByteArray data(size, Qt::Uninitialized);
+        for (int i = 0; i < size; ++i) {
+            data[i] = static_cast<char>('a' + (i * 7 + index) % 26);
+        }
+        return data;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+
+        // Empty, small, and larger than one 4 MB ring read
+        const int sizes[] = {0, 1, 100, 4096, 65537, 300000, 5 * 1024 * 1024 + 3};
+        for (int i = 0; i < 30; ++i) {
+            QString path = m_dir.filePath(QString("file%1.txt").arg(i, 2, 10, QChar('0')));
+            QByteArray data = content(i, sizes[i % 7]);
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(data), qint64(data.size()));
+            m_paths.append(path);
+            m_contents.append(data);
+        }
+    }
+
+    void testReadsInOrder_data() {
+        QTest::addColumn<int>("backend");
+        QTest::addColumn<int>("depth");
+
+        QTest::newRow("auto_16") << int(BulkFileReader::Auto) << 16;
+        QTest::newRow("auto_1") << int(BulkFileReader::Auto) << 1;
+        QTest::newRow("thread_pool_16") << int(BulkFileReader::ThreadPool) << 16;
+        QTest::newRow("thread_pool_3") << int(BulkFileReader::ThreadPool) << 3;
+    }
+
+    void testReadsInOrder() {
+        QFETCH(int, backend);
+        QFETCH(int, depth);
+
+        BulkFileReader reader(depth, static_cast<BulkFileReader::Backend>(backend));
+        if (backend == BulkFileReader::ThreadPool) {
+            QCOMPARE(reader.backend(), BulkFileReader::ThreadPool);
+        }
+        QVERIFY(reader.backend() != BulkFileReader::Auto);
+
+        reader.start(m_paths);
+        BulkFileResult result;
+        for (int i = 0; i < m_paths.size(); ++i) {
+            QVERIFY(reader.next(result));
+            QCOMPARE(result.path, m_paths[i]);
+            QVERIFY2(result.ok(), qPrintable(result.error));
+            QCOMPARE(result.data.size(), m_contents[i].size());
+            QVERIFY(result.data == m_contents[i]);
+        }
+        QVERIFY(!reader.next(result));
+    }
+
+    void testMissingFile() {
+        QStringList paths = {m_paths[1], m_dir.filePath("missing.txt"), m_paths[2]};
+        BulkFileReader reader(4);
+        reader.start(paths);
+
+        BulkFileResult result;
+        QVERIFY(reader.next(result));
+        QVERIFY(result.ok());
+        QVERIFY(reader.next(result));
+        QCOMPARE(result.path, paths[1]);
+        QVERIFY(!result.ok());
+        QVERIFY(result.data.isEmpty());
+        QVERIFY(reader.next(result));
+        QVERIFY(result.data == m_contents[2]);
+        QVERIFY(!reader.next(result));
+    }
+
+    void testRestartAndAbandon() {
+        BulkFileReader reader(8);
+        reader.start(m_paths);
+        BulkFileResult result;
+        QVERIFY(reader.next(result));
+
+        // A new list replaces the reads still in flight
+        reader.start({m_paths[5]});
+        QVERIFY(reader.next(result));
+        QCOMPARE(result.path, m_paths[5]);
+        QVERIFY(!reader.next(result));
+
+        // Destroyed with reads in flight
+        BulkFileReader abandoned(8);
+        abandoned.start(m_paths);
+        QVERIFY(abandoned.next(result));
+
+        reader.start(QStringList());
+        QVERIFY(!reader.next(result));
+    }
+
+    void testBackendNames() {
+        QCOMPARE(BulkFileReader::backendName(BulkFileReader::IoUring), QString("io_uring"));
+        QCOMPARE(BulkFileReader::backendName(BulkFileReader::ThreadPool), QString("thread_pool"));
+    }
+};
+
+QTEST_MAIN(TestBulkFileReader)
+#include "test_bulkfilereader.moc"
@@ -1,5 +1,9 @@
 #include <QtTest/QtTest>
 #include "../include/Config.h"
+#include <QTemporaryDir>
+#include <QSignalSpy>
+#include <QFile>
+#include <QJsonDocument>
 
 class TestConfig : public QObject {
     Q_OBJECT
@@ -93,6 +97,147 @@ private slots:
         // This is a basic smoke test
         QVERIFY(Config::instance().isValid());
     }
+
+    void testSnapshotIsImmutable() {
+        Config::instance().resetToDefaults();
+        std::shared_ptr<const ConfigSnapshot> before = Config::instance().snapshot();
+
+        Config::instance().setModel("snapshot-model");
+
+        // Previously taken snapshots keep their values
+        QCOMPARE(before->model, QString("gpt-oss:20b"));
+        QCOMPARE(Config::instance().snapshot()->model, QString("snapshot-model"));
+        QVERIFY(before != Config::instance().snapshot());
+
+        Config::instance().resetToDefaults();
+    }
+
+    void testUpdatePublishesOnce() {
+        Config::instance().resetToDefaults();
+        std::shared_ptr<const ConfigSnapshot> before = Config::instance().snapshot();
+
+        Config::instance().update([](ConfigSnapshot &cfg) {
+            cfg.model = "batched-model";
+            cfg.temperature = 0.3;
+            cfg.overrideTemperature = true;
+        });
+
+        std::shared_ptr<const ConfigSnapshot> after = Config::instance().snapshot();
+        QCOMPARE(after->model, QString("batched-model"));
+        QCOMPARE(after->temperature, 0.3);
+        QVERIFY(after->overrideTemperature);
+        QCOMPARE(Config::changedSections(*before, *after),
+                 Config::Sections(Config::LLMSection | Config::GenerationSection));
+
+        Config::instance().resetToDefaults();
+    }
+
+    void testChangedSections() {
+        ConfigSnapshot a;
+        ConfigSnapshot b;
+        QVERIFY(a == b);
+        QCOMPARE(Config::changedSections(a, b), Config::Sections(Config::NoSection));
+
+        b.ragTopK = 7;
+        QCOMPARE(Config::changedSections(a, b), Config::Sections(Config::RAGSection));
+
+        b = a;
+        b.ragJournal = false;
+        QCOMPARE(Config::changedSections(a, b), Config::Sections(Config::RAGSection));
+
+        b = a;
+        b.ragChunkTokens = 256;
+        QCOMPARE(Config::changedSections(a, b), Config::Sections(Config::RAGSection));
+
+        b = a;
+        QJsonObject server;
+        server["name"] = "test";
+        b.mcpServers.append(server);
+        QCOMPARE(Config::changedSections(a, b), Config::Sections(Config::MCPSection));
+        QVERIFY(a != b);
+
+        b = a;
+        b.memoryBudgetMb = 512;
+        QCOMPARE(Config::changedSections(a, b), Config::Sections(Config::MemorySection));
+    }
+
+    void testReloadEmitsChangedSections() {
+        qRegisterMetaType<Config::Sections>("Config::Sections");
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("config.json");
+
+        Config::instance().resetToDefaults();
+        QVERIFY(Config::instance().load(path));  // Creates the file with defaults
+
+        QSignalSpy spy(&Config::instance(), &Config::configChanged);
+
+        // Reloading an unchanged file must not notify subscribers
+        QVERIFY(Config::instance().reload());
+        QCOMPARE(spy.count(), 0);
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+
+        json["rag_top_k"] = 9;
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(QJsonDocument(json).toJson());
+        file.close();
+
+        QVERIFY(Config::instance().reload());
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).value<Config::Sections>(), Config::Sections(Config::RAGSection));
+        QCOMPARE(Config::instance().getRagTopK(), 9);
+
+        // Deleting the key restores the default rather than keeping the last value
+        json.remove("rag_top_k");
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(QJsonDocument(json).toJson());
+        file.close();
+
+        QVERIFY(Config::instance().reload());
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(Config::instance().getRagTopK(), ConfigSnapshot().ragTopK);
+
+        Config::instance().resetToDefaults();
+    }
+
+    void testWatchSurvivesDeleteThenWrite() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("config.json");
+
+        Config::instance().resetToDefaults();
+        QVERIFY(Config::instance().load(path));
+        Config::instance().watchConfigFile();
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+
+        // The file is gone when the change is noticed; it comes back a moment later
+        QVERIFY(QFile::remove(path));
+        QTest::qWait(50);
+        json["rag_top_k"] = 7;
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument(json).toJson());
+        file.close();
+        QTRY_COMPARE(Config::instance().getRagTopK(), 7);
+
+        // And the watch is back for later edits
+        json["rag_top_k"] = 8;
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(QJsonDocument(json).toJson());
+        file.close();
+        QTRY_COMPARE(Config::instance().getRagTopK(), 8);
+
+        Config::instance().stopWatchingConfigFile();
+        Config::instance().resetToDefaults();
+    }
 };
 
 QTEST_MAIN(TestConfig)
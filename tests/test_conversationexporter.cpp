@@ -0,0 +1,191 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QBuffer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "../include/ConversationExporter.h"
+#include "../include/ConversationJournal.h"
+
+class TestConversationExporter : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    ConversationSnapshot writeJournal(const QString &name, int messages) {
+        QString path = m_dir.filePath(name);
+        QJsonObject header;
+        header["model"] = "llama3";
+        header["backend"] = "ollama";
+
+        ConversationJournal journal;
+        journal.open(path, header);
+        for (int i = 0; i < messages; ++i) {
+            ConversationMessage message;
+            message.role = i % 2 == 0 ? "user" : "assistant";
+            message.content = QString("message %1").arg(i);
+            journal.append(message);
+        }
+        journal.close(false);
+
+        ConversationSnapshot snapshot;
+        snapshot.journalPath = path;
+        snapshot.journalSize = QFileInfo(path).size();
+        return snapshot;
+    }
+
+    QString exportToString(const ConversationSnapshot &snapshot, ConversationExporter::Format format) {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QString error;
+        bool ok = ConversationExporter::write(snapshot, &buffer, format, false, nullptr, nullptr, &error);
+        if (!ok) {
+            qWarning() << "Export failed:" << error;
+        }
+        return QString::fromUtf8(buffer.data());
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void testFormatForPath() {
+        bool compress = true;
+        QCOMPARE(ConversationExporter::formatForPath("a.txt", &compress), ConversationExporter::Text);
+        QVERIFY(!compress);
+        QCOMPARE(ConversationExporter::formatForPath("a.MD", &compress), ConversationExporter::Markdown);
+        QCOMPARE(ConversationExporter::formatForPath("a.json.gz", &compress), ConversationExporter::Json);
+        QVERIFY(compress);
+        QCOMPARE(ConversationExporter::formatForPath("noext", &compress), ConversationExporter::Text);
+    }
+
+    void testTextAndMarkdown() {
+        ConversationSnapshot snapshot = writeJournal("text.jsonl", 4);
+
+        QString text = exportToString(snapshot, ConversationExporter::Text);
+        QVERIFY(text.contains("Model: llama3"));
+        QVERIFY(text.contains("Messages: 4"));
+        QVERIFY(text.contains("You: message 0"));
+        QVERIFY(text.contains("Bot: message 3"));
+        QVERIFY(text.indexOf("message 0") < text.indexOf("message 1"));
+
+        QString markdown = exportToString(snapshot, ConversationExporter::Markdown);
+        QVERIFY(markdown.startsWith("# "));
+        QVERIFY(markdown.contains("**You**"));
+        QVERIFY(markdown.contains("message 2"));
+    }
+
+    void testJsonIsValidAndComplete() {
+        // More messages than one page
+        ConversationSnapshot snapshot = writeJournal("json.jsonl", 450);
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(exportToString(snapshot, ConversationExporter::Json).toUtf8(), &parseError);
+        QCOMPARE(parseError.error, QJsonParseError::NoError);
+
+        QJsonObject root = doc.object();
+        QCOMPARE(root["model"].toString(), QString("llama3"));
+        QCOMPARE(root["message_count"].toInt(), 450);
+        QJsonArray messages = root["messages"].toArray();
+        QCOMPARE(messages.size(), 450);
+        QCOMPARE(messages.last().toObject()["content"].toString(), QString("message 449"));
+    }
+
+    void testEmptyConversation() {
+        ConversationSnapshot snapshot;
+        snapshot.model = "mistral";
+
+        QJsonDocument doc = QJsonDocument::fromJson(exportToString(snapshot, ConversationExporter::Json).toUtf8());
+        QVERIFY(doc.isObject());
+        QCOMPARE(doc.object()["model"].toString(), QString("mistral"));
+        QVERIFY(doc.object()["messages"].toArray().isEmpty());
+    }
+
+    void testSnapshotExcludesLaterMessages() {
+        ConversationSnapshot snapshot = writeJournal("snapshot.jsonl", 2);
+
+        ConversationJournal journal;
+        QVERIFY(journal.open(snapshot.journalPath));
+        ConversationMessage late;
+        late.role = "user";
+        late.content = "added after the snapshot";
+        journal.append(late);
+        journal.close();
+
+        QString text = exportToString(snapshot, ConversationExporter::Text);
+        QVERIFY(text.contains("message 1"));
+        QVERIFY(!text.contains("added after the snapshot"));
+    }
+
+    void testCompression() {
+        ConversationSnapshot snapshot = writeJournal("gzip.jsonl", 10);
+
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QString error;
+        bool ok = ConversationExporter::write(snapshot, &buffer, ConversationExporter::Text, true, nullptr, nullptr, &error);
+
+        if (!ConversationExporter::compressionAvailable()) {
+            QVERIFY(!ok);
+            QVERIFY(!error.isEmpty());
+            return;
+        }
+
+        QVERIFY(ok);
+        QByteArray data = buffer.data();
+        QVERIFY(data.size() > 10);
+        // gzip magic
+        QCOMPARE(static_cast<unsigned char>(data[0]), static_cast<unsigned char>(0x1f));
+        QCOMPARE(static_cast<unsigned char>(data[1]), static_cast<unsigned char>(0x8b));
+    }
+
+    void testBackgroundExport() {
+        ConversationSnapshot snapshot = writeJournal("background.jsonl", 600);
+        QString output = m_dir.filePath("export.md");
+
+        ConversationExporter exporter;
+        QSignalSpy progress(&exporter, &ConversationExporter::progress);
+        QSignalSpy finished(&exporter, &ConversationExporter::finished);
+
+        QVERIFY(exporter.start(snapshot, output, ConversationExporter::Markdown, false));
+        QVERIFY(finished.wait(10000));
+
+        QCOMPARE(finished.first().first().toString(), output);
+        QVERIFY(progress.count() >= 3);
+        QCOMPARE(progress.last().at(0).toInt(), 600);
+        QCOMPARE(progress.last().at(1).toInt(), 600);
+
+        QFile file(output);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll().contains("message 599"));
+    }
+
+    void testCancelLeavesDestinationUntouched() {
+        ConversationSnapshot snapshot = writeJournal("cancel.jsonl", 2000);
+        QString output = m_dir.filePath("existing.txt");
+        {
+            QFile file(output);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write("previous export");
+        }
+
+        ConversationExporter exporter;
+        QSignalSpy failed(&exporter, &ConversationExporter::failed);
+        QSignalSpy finished(&exporter, &ConversationExporter::finished);
+
+        // Cancel from the first progress report
+        connect(&exporter, &ConversationExporter::progress, &exporter, &ConversationExporter::cancel, Qt::DirectConnection);
+        QVERIFY(exporter.start(snapshot, output, ConversationExporter::Text, false));
+        QTRY_VERIFY_WITH_TIMEOUT(failed.count() + finished.count() > 0, 10000);
+
+        QCOMPARE(failed.count(), 1);
+        QFile file(output);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), QByteArray("previous export"));
+    }
+};
+
+QTEST_MAIN(TestConversationExporter)
+#include "test_conversationexporter.moc"
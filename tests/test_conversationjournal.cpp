@@ -0,0 +1,368 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../include/ConversationJournal.h"
+
+class TestConversationJournal : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    ConversationMessage makeMessage(const QString &role, const QString &content) {
+        ConversationMessage message;
+        message.role = role;
+        message.content = content;
+        return message;
+    }
+
+    int lineCount(const QString &path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return -1;
+        }
+        return file.readAll().count('\n');
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void testRoundTrip() {
+        QString path = m_dir.filePath("roundtrip.jsonl");
+        QJsonObject header;
+        header["model"] = "llama3";
+
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path, header));
+
+            ConversationMessage user = makeMessage("user", "What is 2+2?");
+            QVERIFY(journal.append(user));
+
+            QJsonObject call;
+            call["id"] = "call_1";
+            call["name"] = "calculator";
+            call["arguments"] = QJsonObject{{"expression", "2+2"}};
+            ConversationMessage toolCall = makeMessage("assistant", "");
+            toolCall.toolCalls.append(call);
+            QVERIFY(journal.append(toolCall));
+
+            ConversationMessage tool = makeMessage("tool", "{\"result\":4}");
+            tool.toolName = "calculator";
+            tool.toolCallId = "call_1";
+            QVERIFY(journal.append(tool));
+
+            ConversationMessage answer = makeMessage("assistant", "It is 4.");
+            answer.timings["ttft_ms"] = 120;
+            answer.timings["completion_tokens"] = 4;
+            QVERIFY(journal.append(answer));
+
+            journal.close();
+        }
+
+        ConversationJournalContents contents;
+        QVERIFY(ConversationJournal::read(path, contents));
+        QCOMPARE(contents.header["model"].toString(), QString("llama3"));
+        QCOMPARE(contents.header["version"].toInt(), 2);
+        QVERIFY(contents.cleanlyClosed);
+        QCOMPARE(contents.skippedRecords, 0);
+        QCOMPARE(contents.messages.size(), 4);
+
+        QCOMPARE(contents.messages[0].role, QString("user"));
+        QCOMPARE(contents.messages[0].content, QString("What is 2+2?"));
+        QCOMPARE(contents.messages[1].toolCalls.size(), 1);
+        QCOMPARE(contents.messages[1].toolCalls[0].toObject()["name"].toString(), QString("calculator"));
+        QCOMPARE(contents.messages[2].toolName, QString("calculator"));
+        QCOMPARE(contents.messages[2].toolCallId, QString("call_1"));
+        QCOMPARE(contents.messages[3].timings["ttft_ms"].toInt(), 120);
+        QVERIFY(contents.messages[3].timestamp.isValid());
+    }
+
+    void testAppendOnly() {
+        QString path = m_dir.filePath("append.jsonl");
+        ConversationJournal journal;
+        QVERIFY(journal.open(path));
+        QVERIFY(journal.append(makeMessage("user", "one")));
+        journal.close();
+
+        QByteArray before;
+        {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            before = file.readAll();
+        }
+
+        // Reopening continues the file without rewriting earlier records
+        QVERIFY(journal.open(path));
+        QVERIFY(journal.append(makeMessage("assistant", "two")));
+        journal.close();
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll().startsWith(before));
+
+        ConversationJournalContents contents;
+        QVERIFY(ConversationJournal::read(path, contents));
+        QCOMPARE(contents.messages.size(), 2);
+        QVERIFY(contents.cleanlyClosed);
+    }
+
+    void testBatchedSync() {
+        QString path = m_dir.filePath("batched.jsonl");
+        ConversationJournal journal;
+        journal.setSyncBatchSize(3);
+        journal.setSyncIntervalMs(60000);
+        QVERIFY(journal.open(path));
+        QVERIFY(journal.sync());  // Header record
+        int syncsAfterOpen = journal.syncCount();
+
+        QVERIFY(journal.append(makeMessage("user", "a")));
+        QVERIFY(journal.append(makeMessage("assistant", "b")));
+        QCOMPARE(journal.pendingSync(), 2);
+        QCOMPARE(journal.syncCount(), syncsAfterOpen);
+
+        // Unsynced records are already visible to readers (flushed to the OS)
+        QCOMPARE(lineCount(path), 3);
+
+        // The third record completes the batch
+        QVERIFY(journal.append(makeMessage("user", "c")));
+        QCOMPARE(journal.pendingSync(), 0);
+        QCOMPARE(journal.syncCount(), syncsAfterOpen + 1);
+
+        QVERIFY(journal.append(makeMessage("assistant", "d")));
+        QVERIFY(journal.sync());
+        QCOMPARE(journal.pendingSync(), 0);
+        QCOMPARE(journal.syncCount(), syncsAfterOpen + 2);
+    }
+
+    void testSyncTimer() {
+        QString path = m_dir.filePath("timer.jsonl");
+        ConversationJournal journal;
+        journal.setSyncBatchSize(100);
+        journal.setSyncIntervalMs(10);
+        QVERIFY(journal.open(path));
+        QVERIFY(journal.append(makeMessage("user", "a")));
+        QVERIFY(journal.pendingSync() > 0);
+        QTRY_COMPARE_WITH_TIMEOUT(journal.pendingSync(), 0, 2000);
+    }
+
+    void testTornTailRecovery() {
+        QString path = m_dir.filePath("torn.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path));
+            QVERIFY(journal.append(makeMessage("user", "kept")));
+            journal.close(false);  // Simulate a crash: no close marker
+        }
+
+        // A crash mid-write leaves a partial record
+        {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::Append));
+            file.write("{\"type\":\"message\",\"role\":\"assistant\",\"cont");
+        }
+
+        ConversationJournalContents contents;
+        QVERIFY(ConversationJournal::read(path, contents));
+        QCOMPARE(contents.messages.size(), 1);
+        QCOMPARE(contents.skippedRecords, 1);
+        QVERIFY(!contents.cleanlyClosed);
+
+        // Reopening trims the torn record before appending
+        ConversationJournal journal;
+        QVERIFY(journal.open(path));
+        QVERIFY(journal.append(makeMessage("assistant", "after recovery")));
+        journal.close();
+
+        QVERIFY(ConversationJournal::read(path, contents));
+        QCOMPARE(contents.skippedRecords, 0);
+        QCOMPARE(contents.messages.size(), 2);
+        QCOMPARE(contents.messages[1].content, QString("after recovery"));
+    }
+
+    void testFindUnfinished() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QCOMPARE(ConversationJournal::findUnfinished(dir.path()), QString());
+
+        QString finished = dir.filePath("finished.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(finished));
+            QVERIFY(journal.append(makeMessage("user", "done")));
+            journal.close();
+        }
+        QCOMPARE(ConversationJournal::findUnfinished(dir.path()), QString());
+
+        QString unfinished = dir.filePath("unfinished.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(unfinished));
+            QVERIFY(journal.append(makeMessage("user", "in progress")));
+            // Destroyed without close(): stays recoverable
+        }
+        QCOMPARE(QFileInfo(ConversationJournal::findUnfinished(dir.path())).fileName(),
+                 QString("unfinished.jsonl"));
+    }
+
+    void testMoveTo() {
+        QString from = m_dir.filePath("autosave.jsonl");
+        QString to = m_dir.filePath("saved.jsonl");
+
+        ConversationJournal journal;
+        QVERIFY(journal.open(from));
+        QVERIFY(journal.append(makeMessage("user", "before save")));
+        QVERIFY(journal.moveTo(to));
+        QCOMPARE(journal.path(), to);
+        QVERIFY(!QFile::exists(from));
+
+        QVERIFY(journal.append(makeMessage("assistant", "after save")));
+        journal.close();
+
+        ConversationJournalContents contents;
+        QVERIFY(ConversationJournal::read(to, contents));
+        QCOMPARE(contents.messages.size(), 2);
+        QVERIFY(ConversationJournal::isJournalFile(to));
+    }
+
+    void testLegacyFileIsNotJournal() {
+        QString path = m_dir.filePath("legacy.json");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("{\n    \"version\": \"1.0\",\n    \"content\": \"hello\"\n}\n");
+        file.close();
+
+        QVERIFY(!ConversationJournal::isJournalFile(path));
+        ConversationJournalContents contents;
+        QString error;
+        QVERIFY(!ConversationJournal::read(path, contents, &error));
+        QVERIFY(!error.isEmpty());
+    }
+
+    void testLlmHistory() {
+        QList<ConversationMessage> messages;
+        messages << makeMessage("user", "time?");
+
+        ConversationMessage toolCall = makeMessage("assistant", "");
+        QJsonObject call;
+        call["id"] = "c1";
+        call["name"] = "datetime";
+        call["arguments"] = QJsonObject();
+        toolCall.toolCalls.append(call);
+        messages << toolCall;
+
+        ConversationMessage tool = makeMessage("tool", "{\"time\":\"12:00\"}");
+        tool.toolName = "datetime";
+        messages << tool;
+        messages << makeMessage("assistant", "It is noon.");
+
+        QJsonArray history = ConversationJournal::toLlmHistory(messages);
+        QCOMPARE(history.size(), 4);
+        QCOMPARE(history[0].toObject()["role"].toString(), QString("user"));
+        QCOMPARE(history[1].toObject()["tool_calls"].toArray()[0].toObject()["function"].toObject()["name"].toString(),
+                 QString("datetime"));
+        QCOMPARE(history[2].toObject()["role"].toString(), QString("user"));
+        QVERIFY(history[2].toObject()["content"].toString().contains("datetime"));
+        QCOMPARE(history[3].toObject()["content"].toString(), QString("It is noon."));
+    }
+
+    void testIndexPaging() {
+        QString path = m_dir.filePath("paging.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path));
+            QVERIFY(journal.appendImport("legacy", "<p>legacy</p>"));
+            for (int i = 0; i < 120; ++i) {
+                QVERIFY(journal.append(makeMessage(i % 2 == 0 ? "user" : "assistant", QString("message %1").arg(i))));
+            }
+            journal.close(false);
+        }
+
+        // A torn record at the end is not indexed
+        {
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::Append));
+            file.write("{\"content\":\"torn");
+        }
+
+        ConversationJournalIndex index;
+        QVERIFY(index.open(path));
+        QCOMPARE(index.messageCount(), 120);
+        QCOMPARE(index.imports().size(), 1);
+        QVERIFY(!index.cleanlyClosed());
+        QCOMPARE(index.header()["type"].toString(), QString("conversation"));
+
+        // Newest page
+        QList<ConversationMessage> page = index.messages(120 - JOURNAL_PAGE_SIZE, JOURNAL_PAGE_SIZE);
+        QCOMPARE(page.size(), JOURNAL_PAGE_SIZE);
+        QCOMPARE(page.first().content, QString("message %1").arg(120 - JOURNAL_PAGE_SIZE));
+        QCOMPARE(page.last().content, QString("message 119"));
+
+        // Ranges are clamped
+        QCOMPARE(index.messages(110, 50).size(), 10);
+        QCOMPARE(index.messages(-5, 10).size(), 10);
+        QVERIFY(index.messages(200, 10).isEmpty());
+    }
+
+    void testIndexContentCannotFakeRecordType() {
+        QString path = m_dir.filePath("escaped.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path));
+            QVERIFY(journal.append(makeMessage("user", "ends with \"type\":\"close\"}")));
+            QVERIFY(journal.append(makeMessage("assistant", "{\"type\":\"message\"}")));
+            journal.close(false);
+        }
+
+        ConversationJournalIndex index;
+        QVERIFY(index.open(path));
+        QCOMPARE(index.messageCount(), 2);
+        QVERIFY(!index.cleanlyClosed());
+        QCOMPARE(index.messages(1, 1).first().content, QString("{\"type\":\"message\"}"));
+    }
+
+    void testIndexRejectsNonJournal() {
+        QString path = m_dir.filePath("notjournal.jsonl");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("{\"type\":\"trace\",\"version\":1}\n");
+        file.close();
+
+        ConversationJournalIndex index;
+        QString error;
+        QVERIFY(!index.open(path, &error));
+        QVERIFY(!error.isEmpty());
+        QVERIFY(!index.isOpen());
+    }
+
+    void testCompactedLlmHistory() {
+        QString path = m_dir.filePath("history.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path));
+            for (int i = 0; i < 100; ++i) {
+                // ~100 tokens per message
+                QString content = QString("%1 ").arg(i) + QString(400, 'x');
+                QVERIFY(journal.append(makeMessage(i % 2 == 0 ? "user" : "assistant", content)));
+            }
+            journal.close();
+        }
+
+        ConversationJournalIndex index;
+        QVERIFY(index.open(path));
+
+        QJsonArray full = index.llmHistory(0);
+        QCOMPARE(full.size(), 100);
+
+        QJsonArray compacted = index.llmHistory(1000);
+        QVERIFY(compacted.size() > 0);
+        QVERIFY(compacted.size() <= 10);
+        QCOMPARE(compacted.first().toObject()["role"].toString(), QString("user"));
+        QVERIFY(compacted.last().toObject()["content"].toString().startsWith("99 "));
+    }
+};
+
+QTEST_MAIN(TestConversationJournal)
+#include "test_conversationjournal.moc"
@@ -0,0 +1,208 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "../include/ConversationLibrary.h"
+#include "../include/ConversationJournal.h"
+
+class TestConversationLibrary : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    ConversationLibrary *m_library;
+
+    QString writeJournal(const QString &name, const QString &model, const QStringList &contents) {
+        QString path = m_dir.filePath(name);
+        QJsonObject header;
+        header["model"] = model;
+        header["backend"] = "ollama";
+
+        ConversationJournal journal;
+        journal.open(path, header);
+        for (int i = 0; i < contents.size(); ++i) {
+            ConversationMessage message;
+            message.role = i % 2 == 0 ? "user" : "assistant";
+            message.content = contents[i];
+            journal.append(message);
+        }
+        journal.close();
+        return path;
+    }
+
+    QStringList hitPaths(const QList<LibraryHit> &hits) {
+        QStringList paths;
+        for (const LibraryHit &hit : hits) {
+            paths.append(QFileInfo(hit.session.path).fileName());
+        }
+        return paths;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        m_library = new ConversationLibrary(this);
+        if (!m_library->open(m_dir.filePath("library.db"))) {
+            QSKIP("SQLite FTS5 is not available");
+        }
+    }
+
+    void cleanupTestCase() {
+        m_library->close();
+    }
+
+    void testIndexAndSearch() {
+        writeJournal("rust.jsonl", "llama3", QStringList()
+            << "How do I borrow a vector in Rust?"
+            << "Use a reference: &Vec<T> or a slice &[T].");
+        writeJournal("cooking.jsonl", "mistral", QStringList()
+            << "What temperature for sourdough bread?"
+            << "Bake at 230 C with steam for the first 20 minutes.");
+
+        QVERIFY(m_library->indexFile(m_dir.filePath("rust.jsonl")));
+        QVERIFY(m_library->indexFile(m_dir.filePath("cooking.jsonl")));
+        QCOMPARE(m_library->sessionCount(), 2);
+
+        QList<LibraryHit> hits = m_library->search("sourdough");
+        QCOMPARE(hits.size(), 1);
+        QCOMPARE(QFileInfo(hits.first().session.path).fileName(), QString("cooking.jsonl"));
+        QCOMPARE(hits.first().session.title, QString("What temperature for sourdough bread?"));
+        QCOMPARE(hits.first().session.model, QString("mistral"));
+        QCOMPARE(hits.first().messageIndex, 0);
+        QVERIFY(hits.first().snippet.contains("[sourdough]"));
+
+        // Prefix matching while typing
+        QCOMPARE(hitPaths(m_library->search("borr")), QStringList() << "rust.jsonl");
+
+        // All words must match
+        QVERIFY(m_library->search("sourdough rust").isEmpty());
+    }
+
+    void testIncrementalAppend() {
+        QString path = m_dir.filePath("rust.jsonl");
+        QVERIFY(m_library->search("lifetimes").isEmpty());
+
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path));
+            ConversationMessage message;
+            message.role = "user";
+            message.content = "And what about lifetimes?";
+            journal.append(message);
+            journal.close();
+        }
+
+        QSignalSpy indexed(m_library, &ConversationLibrary::sessionIndexed);
+        QVERIFY(m_library->indexFile(path));
+        QCOMPARE(indexed.count(), 1);
+
+        QList<LibraryHit> hits = m_library->search("lifetimes");
+        QCOMPARE(hits.size(), 1);
+        QCOMPARE(hits.first().messageIndex, 2);
+        QCOMPARE(hits.first().session.messageCount, 3);
+
+        // Earlier messages were not indexed twice
+        QCOMPARE(m_library->search("borrow").size(), 1);
+        QCOMPARE(hits.first().session.title, QString("How do I borrow a vector in Rust?"));
+
+        // Unchanged files are skipped
+        QVERIFY(m_library->indexFile(path));
+        QCOMPARE(indexed.count(), 1);
+    }
+
+    void testFilters() {
+        LibraryFilter filter;
+        filter.model = "llama3";
+        QVERIFY(m_library->search("sourdough", filter).isEmpty());
+        QCOMPARE(m_library->search("borrow", filter).size(), 1);
+
+        QCOMPARE(m_library->models(), QStringList() << "llama3" << "mistral");
+
+        LibraryFilter future;
+        future.from = QDate::currentDate().addDays(1);
+        QVERIFY(m_library->search("borrow", future).isEmpty());
+
+        LibraryFilter today;
+        today.from = QDate::currentDate();
+        today.to = QDate::currentDate();
+        QCOMPARE(m_library->search("borrow", today).size(), 1);
+
+        // An empty query lists conversations
+        QCOMPARE(m_library->search(QString()).size(), 2);
+        QCOMPARE(m_library->search(QString(), filter).size(), 1);
+    }
+
+    void testQuerySyntaxIsLiteral() {
+        QCOMPARE(ConversationLibrary::toMatchExpression("  foo   bar "), QString("\"foo\"* \"bar\"*"));
+        QCOMPARE(ConversationLibrary::toMatchExpression("say \"hi\""), QString("\"say\"* \"\"\"hi\"\"\"*"));
+        QVERIFY(ConversationLibrary::toMatchExpression("   ").isEmpty());
+
+        // FTS5 operators and unbalanced quotes don't cause query errors
+        m_library->search("NOT OR (");
+        m_library->search("\"unterminated");
+        m_library->search("col:value*");
+    }
+
+    void testLegacyJson() {
+        QString path = m_dir.filePath("old.json");
+        QJsonObject conversation;
+        conversation["content"] = "You: tell me about kangaroos\nBot: They hop.";
+        conversation["model"] = "llama2";
+        conversation["saved_at"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument(conversation).toJson());
+        file.close();
+
+        QVERIFY(m_library->indexFile(path));
+        QList<LibraryHit> hits = m_library->search("kangaroos");
+        QCOMPARE(hits.size(), 1);
+        QCOMPARE(hits.first().session.title, QString("old"));
+        QCOMPARE(hits.first().role, QString("transcript"));
+    }
+
+    void testRefreshAndFolders() {
+        QTemporaryDir folder;
+        QVERIFY(folder.isValid());
+
+        QCOMPARE(m_library->addFolder(folder.path()), 0);
+        QVERIFY(m_library->folders().contains(QDir(folder.path()).absolutePath()));
+
+        // New files in a folder are picked up by refresh()
+        QString path = folder.filePath("new.jsonl");
+        {
+            ConversationJournal journal;
+            QVERIFY(journal.open(path));
+            ConversationMessage message;
+            message.role = "user";
+            message.content = "Explain quaternions";
+            journal.append(message);
+            journal.close();
+        }
+        m_library->refresh();
+        QCOMPARE(m_library->search("quaternions").size(), 1);
+
+        // Deleted files are dropped
+        int before = m_library->sessionCount();
+        QVERIFY(QFile::remove(path));
+        m_library->refresh();
+        QCOMPARE(m_library->sessionCount(), before - 1);
+        QVERIFY(m_library->search("quaternions").isEmpty());
+    }
+
+    void testRewrittenFileIsReindexed() {
+        QString path = writeJournal("rewrite.jsonl", "llama3", QStringList()
+            << "first version about octopus anatomy" << "Eight arms.");
+        QVERIFY(m_library->indexFile(path));
+        QCOMPARE(m_library->search("octopus").size(), 1);
+
+        QVERIFY(QFile::remove(path));
+        writeJournal("rewrite.jsonl", "llama3", QStringList() << "short");
+        QVERIFY(m_library->indexFile(path));
+        QVERIFY(m_library->search("octopus").isEmpty());
+        QCOMPARE(m_library->search("short").size(), 1);
+    }
+};
+
+QTEST_MAIN(TestConversationLibrary)
+#include "test_conversationlibrary.moc"
@@ -0,0 +1,296 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QtEndian>
+#include "../include/DocumentExtractor.h"
+
+class TestDocumentExtractor : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    static quint32 crc32(const QByteArray &data) {
+        quint32 crc = 0xFFFFFFFFu;
+        for (char byte : data) {
+            crc ^= static_cast<uchar>(byte);
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+        }
+        return ~crc;
+    }
+
+    static void put16(QByteArray &out, quint16 value) {
+        uchar bytes[2];
+        qToLittleEndian(value, bytes);
+        out.append(reinterpret_cast<const char *>(bytes), 2);
+    }
+
+    static void put32(QByteArray &out, quint32 value) {
+        uchar bytes[4];
+        qToLittleEndian(value, bytes);
+        out.append(reinterpret_cast<const char *>(bytes), 4);
+    }
+
+    // A ZIP archive as office suites write it: local headers, data, central directory
+    static QByteArray buildZip(const QList<QPair<QString, QByteArray>> &entries, bool deflate) {
+        QByteArray zip;
+        QByteArray directory;
+        for (const auto &entry : entries) {
+            QByteArray name = entry.first.toUtf8();
+            QByteArray data = entry.second;
+            if (deflate) {
+                // qCompress: 4-byte length, 2-byte zlib header, raw deflate, 4-byte Adler-32
+                QByteArray compressed = qCompress(data);
+                data = compressed.mid(6, compressed.size() - 10);
+            }
+            quint32 offset = zip.size();
+
+            put32(zip, 0x04034b50);
+            put16(zip, 20);
+            put16(zip, 0);
+            put16(zip, deflate ? 8 : 0);
+            put32(zip, 0);  // Time and date
+            put32(zip, crc32(entry.second));
+            put32(zip, data.size());
+            put32(zip, entry.second.size());
+            put16(zip, name.size());
+            put16(zip, 0);
+            zip.append(name);
+            zip.append(data);
+
+            put32(directory, 0x02014b50);
+            put16(directory, 20);
+            put16(directory, 20);
+            put16(directory, 0);
+            put16(directory, deflate ? 8 : 0);
+            put32(directory, 0);
+            put32(directory, crc32(entry.second));
+            put32(directory, data.size());
+            put32(directory, entry.second.size());
+            put16(directory, name.size());
+            put16(directory, 0);
+            put16(directory, 0);
+            put16(directory, 0);
+            put16(directory, 0);
+            put32(directory, 0);
+            put32(directory, offset);
+            directory.append(name);
+        }
+
+        quint32 directoryOffset = zip.size();
+        zip.append(directory);
+        put32(zip, 0x06054b50);
+        put16(zip, 0);
+        put16(zip, 0);
+        put16(zip, entries.size());
+        put16(zip, entries.size());
+        put32(zip, directory.size());
+        put32(zip, directoryOffset);
+        put16(zip, 0);
+        return zip;
+    }
+
+    QString writeFile(const QString &name, const QByteArray &bytes) {
+        QString path = m_dir.filePath(name);
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return QString();
+        }
+        file.write(bytes);
+        return path;
+    }
+
+    static QByteArray docxXml(const QByteArray &body) {
+        return "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+               "<w:document xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"><w:body>"
+               + body + "</w:body></w:document>";
+    }
+
+    static QByteArray odtXml(const QByteArray &body) {
+        return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<office:document-content xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" "
+               "xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\"><office:body><office:text>"
+               + body + "</office:text></office:body></office:document-content>";
+    }
+
+    // Two pages of Helvetica text, with a correct cross-reference table
+    static QByteArray buildPdf() {
+        QList<QByteArray> objects;
+        objects << "<< /Type /Catalog /Pages 2 0 R >>"
+                << "<< /Type /Pages /Kids [3 0 R 5 0 R] /Count 2 >>";
+        const QByteArray pages[] = {"First page text", "Second page text"};
+        for (int i = 0; i < 2; ++i) {
+            QByteArray content = "BT /F1 24 Tf 72 700 Td (" + pages[i] + ") Tj ET";
+            objects << QByteArray("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] "
+                                  "/Resources << /Font << /F1 7 0 R >> >> /Contents %1 0 R >>")
+                           .replace("%1", QByteArray::number(objects.size() + 2))
+                    << "<< /Length " + QByteArray::number(content.size()) + " >>\nstream\n" + content
+                           + "\nendstream";
+        }
+        objects << "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>";
+
+        QByteArray pdf = "%PDF-1.4\n";
+        QList<int> offsets;
+        for (int i = 0; i < objects.size(); ++i) {
+            offsets << pdf.size();
+            pdf += QByteArray::number(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+        }
+        int xref = pdf.size();
+        pdf += "xref\n0 " + QByteArray::number(objects.size() + 1) + "\n0000000000 65535 f \n";
+        for (int offset : offsets) {
+            pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+        }
+        pdf += "trailer\n<< /Size " + QByteArray::number(objects.size() + 1) + " /Root 1 0 R >>\n"
+               "startxref\n" + QByteArray::number(xref) + "\n%%EOF\n";
+        return pdf;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void testDocxText() {
+        QByteArray xml = docxXml(
+            "<w:p><w:pPr><w:tabs><w:tab w:val=\"left\" w:pos=\"720\"/></w:tabs></w:pPr>"
+            "<w:r><w:t>Quarterly</w:t></w:r><w:r><w:t xml:space=\"preserve\"> report</w:t></w:r></w:p>"
+            "<w:p><w:r><w:t>Name</w:t><w:tab/><w:t>Value &amp; unit</w:t><w:br/><w:t>Next line</w:t></w:r></w:p>"
+            "<w:p><w:r><w:delText>Deleted</w:delText><w:t>Caf\xC3\xA9</w:t></w:r></w:p>");
+        QString path = writeFile("stored.docx", buildZip({{"[Content_Types].xml", "<Types/>"},
+                                                          {"word/document.xml", xml}}, false));
+
+        QString error;
+        QString text = DocumentExtractor::extractDocx(path, &error);
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QCOMPARE(text, QString("Quarterly report\nName\tValue & unit\nNext line\nCafé"));
+
+        // Same from bytes already in memory
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(DocumentExtractor::extractDocxData(file.readAll(), &error), text);
+    }
+
+    void testOdtText() {
+        QByteArray xml = odtXml(
+            "<text:h text:outline-level=\"1\">Title</text:h>"
+            "<text:p>One<text:s text:c=\"3\"/>two<text:tab/>three</text:p>"
+            "<text:p>Line<text:line-break/>break <text:span>and span</text:span></text:p>");
+        QString path = writeFile("stored.odt", buildZip({{"mimetype", "application/vnd.oasis.opendocument.text"},
+                                                         {"content.xml", xml}}, false));
+
+        QString error;
+        QString text = DocumentExtractor::extractOdt(path, &error);
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QCOMPARE(text, QString("Title\nOne   two\tthree\nLine\nbreak and span"));
+    }
+
+    void testLargeDeflatedDocument() {
+        if (!DocumentExtractor::canInflate()) {
+            QSKIP("Built without zlib");
+        }
+
+        // Several inflate blocks, so XML tokens are split across addData() calls
+        QByteArray body;
+        for (int i = 0; i < 5000; ++i) {
+            body += "<w:p><w:r><w:t>Paragraph " + QByteArray::number(i) + " of the handbook.</w:t></w:r></w:p>";
+        }
+        QVERIFY(body.size() > 4 * 64 * 1024);
+        QString path = writeFile("deflated.docx", buildZip({{"word/document.xml", docxXml(body)}}, true));
+
+        QString error;
+        QStringList lines = DocumentExtractor::extractDocx(path, &error).split('\n');
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QCOMPARE(lines.size(), 5000);
+        QCOMPARE(lines.first(), QString("Paragraph 0 of the handbook."));
+        QCOMPARE(lines.last(), QString("Paragraph 4999 of the handbook."));
+    }
+
+    void testCompressibleDocumentEndingOnABlock() {
+        if (!DocumentExtractor::canInflate()) {
+            QSKIP("Built without zlib");
+        }
+
+        // A few hundred bytes of input expand to whole 64 KB output blocks: the input runs out while
+        // zlib still holds output (and the end of the stream)
+        const QByteArray empty = docxXml("<w:p><w:r><w:t></w:t></w:r></w:p>");
+        for (int blocks = 1; blocks <= 3; ++blocks) {
+            for (int extra : {0, 1, 100, 258}) {
+                int letters = blocks * 64 * 1024 + extra - empty.size();
+                QByteArray xml = docxXml("<w:p><w:r><w:t>" + QByteArray(letters, 'a') + "</w:t></w:r></w:p>");
+                QString path = writeFile("repetitive.docx", buildZip({{"word/document.xml", xml}}, true));
+
+                QString error;
+                QString text = DocumentExtractor::extractDocx(path, &error);
+                QVERIFY2(error.isEmpty(), qPrintable(QString("%1 blocks + %2: %3").arg(blocks).arg(extra).arg(error)));
+                QCOMPARE(text.size(), letters);
+            }
+        }
+    }
+
+    void testLargeStoredDocument() {
+        QByteArray body;
+        for (int i = 0; i < 3000; ++i) {
+            body += "<text:p>Entry " + QByteArray::number(i) + "</text:p>";
+        }
+        QString path = writeFile("large.odt", buildZip({{"content.xml", odtXml(body)}}, false));
+
+        QString error;
+        QStringList lines = DocumentExtractor::extractOdt(path, &error).split('\n');
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QCOMPARE(lines.size(), 3000);
+        QCOMPARE(lines.last(), QString("Entry 2999"));
+    }
+
+    void testDamagedArchives() {
+        QString error;
+
+        QString notZip = writeFile("plain.docx", "This is not an archive");
+        QVERIFY(DocumentExtractor::extractDocx(notZip, &error).isEmpty());
+        QVERIFY(error.contains("Not a ZIP archive"));
+
+        // A valid archive without the document part
+        QString missing = writeFile("missing.docx", buildZip({{"word/styles.xml", "<styles/>"}}, false));
+        QVERIFY(DocumentExtractor::extractDocx(missing, &error).isEmpty());
+        QVERIFY(error.contains("word/document.xml"));
+
+        // One byte changed in the entry data
+        QByteArray zip = buildZip({{"word/document.xml", docxXml("<w:p><w:r><w:t>Intact</w:t></w:r></w:p>")}}, false);
+        int at = zip.indexOf("Intact");
+        zip[at] = 'X';
+        QString corrupt = writeFile("corrupt.docx", zip);
+        QVERIFY(DocumentExtractor::extractDocx(corrupt, &error).isEmpty());
+        QVERIFY(error.contains("checksum"));
+
+        // Well-formed archive, malformed XML
+        QString badXml = writeFile("badxml.odt", buildZip({{"content.xml", "<office:document-content><unclosed>"}}, false));
+        QVERIFY(DocumentExtractor::extractOdt(badXml, &error).isEmpty());
+        QVERIFY(error.contains("content.xml"));
+
+        QVERIFY(DocumentExtractor::extractDocx(m_dir.filePath("absent.docx"), &error).isEmpty());
+        QVERIFY(!error.isEmpty());
+    }
+
+    void testPdfPages() {
+        if (!DocumentExtractor::canReadPdf()) {
+            QString error;
+            QVERIFY(DocumentExtractor::extractPdf(writeFile("unused.pdf", buildPdf()), &error).isEmpty());
+            QVERIFY(error.contains("poppler"));
+            QSKIP("Built without poppler-cpp");
+        }
+
+        QString error;
+        QString text = DocumentExtractor::extractPdf(writeFile("pages.pdf", buildPdf()), &error);
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QVERIFY(text.contains("First page text"));
+        QVERIFY(text.contains("Second page text"));
+        QVERIFY(text.indexOf("First") < text.indexOf("Second"));
+
+        QVERIFY(DocumentExtractor::extractPdf(writeFile("notpdf.pdf", "plain text"), &error).isEmpty());
+        QVERIFY(!error.isEmpty());
+    }
+};
+
+QTEST_MAIN(TestDocumentExtractor)
+#include "test_documentextractor.moc"
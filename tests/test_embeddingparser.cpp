@@ -0,0 +1,78 @@
+#include <QtTest/QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <random>
+#include "../include/EmbeddingParser.h"
+
+class TestEmbeddingParser : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testSingleVector() {
+        QVector<float> v = EmbeddingParser::parseFirst(
+            "{\"embedding\": [0.5, -1.25e-3, 3, 0.000123456789, 1E+2, -0.0]}");
+        QCOMPARE(v.size(), 6);
+        QCOMPARE(v[0], 0.5f);
+        QCOMPARE(v[1], -1.25e-3f);
+        QCOMPARE(v[2], 3.0f);
+        QCOMPARE(v[3], 0.000123456789f);
+        QCOMPARE(v[4], 100.0f);
+        QCOMPARE(v[5], 0.0f);
+    }
+
+    void testBatchedVectors() {
+        QVector<QVector<float>> vectors;
+        int count = EmbeddingParser::parse(
+            "{\"model\":\"nomic-embed-text\",\"embeddings\":[[1,2,3],\n [4, 5.5, -6]],\"total_duration\":1200}",
+            vectors);
+        QCOMPARE(count, 2);
+        QCOMPARE(vectors[1], QVector<float>({4.0f, 5.5f, -6.0f}));
+
+        // OpenAI-style lists carry one "embedding" per item
+        vectors.clear();
+        count = EmbeddingParser::parse(
+            "{\"data\":[{\"index\":0,\"embedding\":[1,2]},{\"index\":1,\"embedding\":[3,4]}]}", vectors);
+        QCOMPARE(count, 2);
+        QCOMPARE(vectors[0], QVector<float>({1.0f, 2.0f}));
+
+        // Appends after what is already there
+        count = EmbeddingParser::parse("{\"embedding\":[9,9]}", vectors);
+        QCOMPARE(count, 1);
+        QCOMPARE(vectors.size(), 3);
+    }
+
+    void testMalformedRejected() {
+        QVector<QVector<float>> vectors;
+        QCOMPARE(EmbeddingParser::parse("{\"error\":\"model not found\"}", vectors), 0);
+        QCOMPARE(EmbeddingParser::parse("{\"embedding\":[1,,2]}", vectors), 0);
+        QCOMPARE(EmbeddingParser::parse("{\"embedding\":[1, 2", vectors), 0);
+        QCOMPARE(EmbeddingParser::parse("{\"embedding\":[]}", vectors), 0);
+        QCOMPARE(EmbeddingParser::parse("{\"embedding\":[1, null]}", vectors), 0);
+        QCOMPARE(EmbeddingParser::parse("{\"embeddings\":[[1,2],[3]]}", vectors), 0);
+        QCOMPARE(EmbeddingParser::parse("{\"model\":\"embedding\",\"note\":\"\\\"embedding\\\"\"}", vectors), 0);
+        QVERIFY(vectors.isEmpty());
+    }
+
+    void testMatchesQtJson() {
+        // Whatever the server's number formatting, results match the QJsonDocument path
+        std::mt19937 rng(7);
+        std::normal_distribution<double> dist(0.0, 0.05);
+        QJsonArray array;
+        for (int i = 0; i < 4096; ++i) {
+            array.append(dist(rng));
+        }
+        array.append(1e-30);
+        array.append(-12345.678);
+        QByteArray json = QJsonDocument(QJsonObject{{"embedding", array}}).toJson(QJsonDocument::Compact);
+
+        QVector<float> parsed = EmbeddingParser::parseFirst(json);
+        QCOMPARE(parsed.size(), array.size());
+        for (int i = 0; i < array.size(); ++i) {
+            QCOMPARE(parsed[i], static_cast<float>(array[i].toDouble()));
+        }
+    }
+};
+
+QTEST_MAIN(TestEmbeddingParser)
+#include "test_embeddingparser.moc"
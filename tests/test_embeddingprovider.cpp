@@ -0,0 +1,224 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <cmath>
+#include "../include/EmbeddingProvider.h"
+#include "../include/RAGEngine.h"
+#include "../include/MockOllamaServer.h"
+
+class TestEmbeddingProvider : public QObject {
+    Q_OBJECT
+
+private:
+    struct Result {
+        int ticket = 0;
+        QVector<QVector<float>> vectors;
+        QString error;
+        int calls = 0;
+    };
+
+    // Collects the provider's answers (the vector type has no metatype for QSignalSpy)
+    static void collect(EmbeddingProvider *provider, Result &result) {
+        connect(provider, &EmbeddingProvider::embeddingsReady, provider,
+                [&result](int ticket, const QVector<QVector<float>> &vectors) {
+            result.ticket = ticket;
+            result.vectors = vectors;
+            result.calls++;
+        });
+        connect(provider, &EmbeddingProvider::embeddingFailed, provider,
+                [&result](int ticket, const QString &error) {
+            result.ticket = ticket;
+            result.error = error;
+            result.calls++;
+        });
+    }
+
+    static QStringList sampleTexts(int count) {
+        QStringList texts;
+        for (int i = 0; i < count; ++i) {
+            texts << QString("Sample passage number %1 about topic %2").arg(i).arg(i % 7);
+        }
+        return texts;
+    }
+
+    static double dot(const QVector<float> &a, const QVector<float> &b) {
+        double sum = 0.0;
+        for (int i = 0; i < a.size(); ++i) {
+            sum += static_cast<double>(a[i]) * b[i];
+        }
+        return sum;
+    }
+
+private slots:
+    void testLocalVectors() {
+        QVector<float> refund = LocalEmbeddingProvider::embedText("Refunds are issued within 30 days");
+        QCOMPARE(refund.size(), LocalEmbeddingProvider::dimensions());
+        QVERIFY(std::abs(dot(refund, refund) - 1.0) < 1e-4);
+        QCOMPARE(LocalEmbeddingProvider::embedText("Refunds are issued within 30 days"), refund);
+
+        // Shared words score above unrelated text
+        QVector<float> question = LocalEmbeddingProvider::embedText("when are refunds issued?");
+        QVector<float> shipping = LocalEmbeddingProvider::embedText("Shipping is free for orders over 50 euros");
+        QVERIFY(dot(question, refund) > dot(question, shipping));
+
+        // No words: a zero vector rather than NaNs
+        QVector<float> empty = LocalEmbeddingProvider::embedText("  ?! ");
+        QCOMPARE(dot(empty, empty), 0.0);
+    }
+
+    void testLocalBatchAcrossThreads() {
+        LocalEmbeddingProvider provider;
+        Result result;
+        collect(&provider, result);
+
+        QStringList texts = sampleTexts(200);
+        int ticket = provider.embed(texts);
+        QCOMPARE(result.calls, 0);  // Never from inside embed()
+        QTRY_COMPARE(result.calls, 1);
+
+        QCOMPARE(result.ticket, ticket);
+        QCOMPARE(result.vectors.size(), texts.size());
+        for (int i = 0; i < texts.size(); i += 37) {
+            QCOMPARE(result.vectors[i], LocalEmbeddingProvider::embedText(texts[i]));
+        }
+    }
+
+    void testLocalCancel() {
+        LocalEmbeddingProvider provider;
+        Result result;
+        collect(&provider, result);
+
+        provider.cancel(provider.embed(QStringList{"a query"}));
+        provider.cancel(provider.embed(sampleTexts(100)));
+        QTest::qWait(200);
+        QCOMPARE(result.calls, 0);
+    }
+
+    void testOllamaBatches() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        OllamaEmbeddingProvider provider;
+        provider.setUrl(QString("http://127.0.0.1:%1").arg(server.serverPort()));
+        Result result;
+        collect(&provider, result);
+
+        // 40 texts: one /api/embed request of 32 and one of 8
+        provider.embed(sampleTexts(40));
+        QTRY_COMPARE(result.calls, 1);
+        QVERIFY(result.error.isEmpty());
+        QCOMPARE(result.vectors.size(), 40);
+        QCOMPARE(result.vectors.first().size(), 768);
+        QCOMPARE(server.requestCount(), 2);
+        QVERIFY(result.vectors[0] != result.vectors[1]);
+    }
+
+    void testOllamaWithoutBatchEndpoint() {
+        MockOllamaOptions options;
+        options.batchEmbeddings = false;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+        OllamaEmbeddingProvider provider;
+        provider.setUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+        Result result;
+        collect(&provider, result);
+
+        // One refused /api/embed, then one /api/embeddings request per text
+        provider.embed(sampleTexts(5));
+        QTRY_COMPARE(result.calls, 1);
+        QVERIFY(result.error.isEmpty());
+        QCOMPARE(result.vectors.size(), 5);
+        QCOMPARE(server.requestCount(), 6);
+
+        provider.embed(QStringList{"a query"});
+        QTRY_COMPARE(result.calls, 2);
+        QCOMPARE(server.requestCount(), 7);
+    }
+
+    void testOpenAICompatible() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        OpenAIEmbeddingProvider provider;
+        provider.setUrl(QString("http://127.0.0.1:%1/v1").arg(server.serverPort()));
+        provider.setApiKey("sk-test");
+        Result result;
+        collect(&provider, result);
+
+        provider.embed(sampleTexts(40));
+        QTRY_COMPARE(result.calls, 1);
+        QVERIFY(result.error.isEmpty());
+        QCOMPARE(result.vectors.size(), 40);
+        QCOMPARE(server.requestCount(), 1);
+    }
+
+    void testServerDown() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        quint16 port = server.serverPort();
+        server.close();
+
+        OllamaEmbeddingProvider provider;
+        provider.setUrl(QString("http://127.0.0.1:%1").arg(port));
+        Result result;
+        collect(&provider, result);
+
+        int ticket = provider.embed(sampleTexts(3));
+        QTRY_COMPARE(result.calls, 1);
+        QCOMPARE(result.ticket, ticket);
+        QVERIFY(!result.error.isEmpty());
+        QVERIFY(result.vectors.isEmpty());
+    }
+
+    void testRagEngineOffline() {
+        QTemporaryDir dir;
+        QString path = dir.filePath("policy.txt");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("Refunds are issued within 30 days of purchase.\n"
+                   "Shipping is free for orders over 50 euros.\n");
+        file.close();
+
+        // No server anywhere: the URL points at a closed port
+        RAGEngine engine;
+        engine.setApiUrl("http://127.0.0.1:1");
+        engine.setEmbeddingProvider("local");
+        QCOMPARE(engine.embeddingProvider(), QString("local"));
+        QVERIFY(engine.ingestDocument(path));
+        QTRY_COMPARE(engine.getPendingEmbeddingCount(), 0);
+        QCOMPARE(engine.getEmbeddingDimension(), LocalEmbeddingProvider::dimensions());
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+        engine.requestContext("when are refunds issued", 1);
+        QVERIFY(readySpy.wait(1000));
+        QCOMPARE(degradedSpy.count(), 0);
+        QCOMPARE(readySpy.first()[1].toStringList().size(), 1);
+    }
+
+    void testProviderSwitchReembeds() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        QTemporaryDir dir;
+        QString path = dir.filePath("notes.txt");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("Backups run every night at two.\n");
+        file.close();
+
+        RAGEngine engine;
+        engine.setApiUrl(QString("http://127.0.0.1:%1").arg(server.serverPort()));
+        QVERIFY(engine.ingestDocument(path));
+        QTRY_COMPARE(engine.getPendingEmbeddingCount(), 0);
+        QCOMPARE(engine.getEmbeddingDimension(), 768);
+
+        // The server's 768-dimension vectors can't mix with local ones
+        QSignalSpy generatedSpy(&engine, &RAGEngine::embeddingGenerated);
+        engine.setEmbeddingProvider("local");
+        QTRY_COMPARE(generatedSpy.count(), engine.getChunkCount());
+        QCOMPARE(engine.getEmbeddingDimension(), LocalEmbeddingProvider::dimensions());
+        QCOMPARE(engine.getDocumentCount(), 1);
+    }
+};
+
+QTEST_MAIN(TestEmbeddingProvider)
+#include "test_embeddingprovider.moc"
@@ -0,0 +1,156 @@
+#include <QtTest/QtTest>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QJsonObject>
+#include <atomic>
+#include "../include/EngineThread.h"
+#include "../include/MockOllamaServer.h"
+#include "../include/LLMClient.h"
+#include "../include/Config.h"
+
+class TestEngineThread : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        Config::instance().resetToDefaults();
+    }
+
+    void testCreateRunsOnWorkerThread() {
+        EngineThread engines("Test engines");
+        QVERIFY(engines.isRunning());
+
+        QObject *object = engines.create<QObject>();
+        QVERIFY(object);
+        QCOMPARE(object->thread(), engines.workerThread());
+
+        QThread *ranOn = nullptr;
+        QMetaObject::invokeMethod(object, [&ranOn]() {
+            ranOn = QThread::currentThread();
+        }, Qt::BlockingQueuedConnection);
+        QCOMPARE(ranOn, engines.workerThread());
+    }
+
+    void testStopDeletesOnWorkerThread() {
+        EngineThread engines("Test engines");
+        QPointer<QObject> created = engines.create<QObject>();
+
+        QObject *adopted = new QObject();
+        QVERIFY(engines.adopt(adopted));
+        QCOMPARE(adopted->thread(), engines.workerThread());
+
+        // Objects with a parent are owned elsewhere
+        QObject parent;
+        QVERIFY(!engines.adopt(new QObject(&parent)));
+
+        QThread *worker = engines.workerThread();
+        QThread *destroyedOn = nullptr;
+        connect(adopted, &QObject::destroyed, adopted, [&destroyedOn]() {
+            destroyedOn = QThread::currentThread();
+        }, Qt::DirectConnection);
+
+        engines.stop();
+        QVERIFY(created.isNull());
+        QCOMPARE(destroyedOn, worker);
+        QVERIFY(!engines.isRunning());
+
+        // Stopped: nothing more can be created, and stopping again is harmless
+        QVERIFY(!engines.create<QObject>());
+        engines.stop();
+    }
+
+    void testGuiThreadStaysResponsiveWhileStreaming() {
+        const int tokens = 20000;
+
+        // Mock backend on its own thread, streaming as fast as it can
+        MockOllamaOptions options;
+        options.responseTokens = tokens;
+        options.tokensPerChunk = 1;
+        QThread serverThread;
+        serverThread.start();
+        MockOllamaServer *server = new MockOllamaServer(options);
+        server->moveToThread(&serverThread);
+        QString apiUrl;
+        QMetaObject::invokeMethod(server, [&]() {
+            if (server->listen()) {
+                apiUrl = server->generateUrl();
+            }
+        }, Qt::BlockingQueuedConnection);
+        QVERIFY(!apiUrl.isEmpty());
+
+        EngineThread engines("Test engines");
+        LLMClient *client = engines.create<LLMClient>();
+        QVERIFY(client);
+        QMetaObject::invokeMethod(client, [client, apiUrl]() {
+            client->setApiUrl(apiUrl);
+            client->setMaxRetries(0);
+            client->setModelCapabilities("prompt", QJsonObject());
+        }, Qt::BlockingQueuedConnection);
+
+        // Parsing happens where the client lives; the GUI thread only
+        // receives the queued results
+        int tokensReceived = 0;
+        bool responded = false;
+        std::atomic<bool> emittedOffGuiThread(true);
+        connect(client, &LLMClient::tokenReceived, this, [&](const QString &) {
+            ++tokensReceived;
+        });
+        connect(client, &LLMClient::tokenReceived, client, [&](const QString &) {
+            if (QThread::currentThread() == QCoreApplication::instance()->thread()) {
+                emittedOffGuiThread = false;
+            }
+        }, Qt::DirectConnection);
+        connect(client, &LLMClient::responseReceived, this, [&](const QString &) {
+            responded = true;  // Queued after every token
+        });
+
+        // A "frame" timer on the GUI thread, counting events it handles
+        std::atomic<int> frames(0);
+        QTimer frameTimer;
+        frameTimer.setInterval(0);
+        connect(&frameTimer, &QTimer::timeout, this, [&]() {
+            ++frames;
+        });
+        frameTimer.start();
+
+        // Hold the client mid-stream until the GUI thread has drawn more
+        // frames. Had parsing run on the GUI thread, no frame could be drawn
+        // and the hold would only end at its safety limit.
+        const int framesWhileHeld = 20;
+        bool held = false;
+        std::atomic<bool> framesDrawnWhileHeld(false);
+        connect(client, &LLMClient::tokenReceived, client, [&](const QString &) {
+            if (held) {
+                return;
+            }
+            held = true;
+            int target = frames + framesWhileHeld;
+            QElapsedTimer safety;
+            safety.start();
+            while (frames < target && safety.elapsed() < 10000) {
+                QThread::msleep(1);
+            }
+            framesDrawnWhileHeld = frames >= target;
+        }, Qt::DirectConnection);
+
+        QMetaObject::invokeMethod(client, [client]() {
+            client->sendPrompt("stream");
+        });
+        QTRY_VERIFY_WITH_TIMEOUT(responded, 30000);
+        frameTimer.stop();
+
+        QCOMPARE(tokensReceived, tokens);
+        QVERIFY(emittedOffGuiThread);
+        QVERIFY2(framesDrawnWhileHeld, "GUI thread stopped handling events while the engine was busy");
+
+        engines.stop();
+        QMetaObject::invokeMethod(server, [server]() { delete server; }, Qt::BlockingQueuedConnection);
+        serverThread.quit();
+        serverThread.wait();
+    }
+};
+
+QTEST_MAIN(TestEngineThread)
+#include "test_enginethread.moc"
@@ -0,0 +1,200 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../include/IngestionJournal.h"
+
+class TestIngestionJournal : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    QJsonObject header(const QString &model = "nomic-embed-text") {
+        QJsonObject h;
+        h["provider"] = "ollama";
+        h["model"] = model;
+        return h;
+    }
+
+    IngestedDocument makeDocument(const QString &path, int firstChunk, const QStringList &chunks) {
+        IngestedDocument document;
+        document.path = path;
+        document.size = 1234;
+        document.modified = 1700000000000;
+        document.firstChunk = firstChunk;
+        document.chunks = chunks;
+        return document;
+    }
+
+    // One document of two chunks, both embedded, inside an unfinished directory
+    void writeSample(const QString &path) {
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(journal.open(path, header(), contents));
+        QVERIFY(journal.appendDirectory("/docs", {"/docs/a.txt", "/docs/b.txt"}));
+        IngestedDocument document = makeDocument("/docs/a.txt", 0, {"First chunk.", "Second chunk."});
+        document.tokenCounts = {3, 3};
+        document.tokenizer = "estimate";
+        QVERIFY(journal.appendDocument(document));
+        QVERIFY(journal.appendEmbeddings({0, 1}, {{1.0f, 2.0f, 3.0f, 4.0f}, {5.0f, 6.0f, 7.0f, 8.0f}}));
+    }
+
+    void appendBytes(const QString &path, const QByteArray &bytes) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::Append));
+        file.write(bytes);
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void testRoundTrip() {
+        QString path = m_dir.filePath("roundtrip.jsonl");
+        writeSample(path);
+
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(journal.open(path, header(), contents));
+        QCOMPARE(contents.header["model"].toString(), QString("nomic-embed-text"));
+        QCOMPARE(contents.header["version"].toInt(), 1);
+        QCOMPARE(contents.skippedRecords, 0);
+
+        QCOMPARE(contents.documents.size(), 1);
+        QCOMPARE(contents.documents[0].path, QString("/docs/a.txt"));
+        QCOMPARE(contents.documents[0].size, qint64(1234));
+        QCOMPARE(contents.documents[0].modified, qint64(1700000000000));
+        QCOMPARE(contents.documents[0].chunks, QStringList({"First chunk.", "Second chunk."}));
+        QCOMPARE(contents.documents[0].tokenCounts, QVector<int>({3, 3}));
+        QCOMPARE(contents.documents[0].tokenizer, QString("estimate"));
+
+        QCOMPARE(contents.embeddings.size(), 1);
+        QCOMPARE(contents.embeddings[0].chunks, QVector<int>({0, 1}));
+        QCOMPARE(contents.embeddings[0].dimensions, 4);
+        const float *vectors = journal.vectors(contents.embeddings[0]);
+        QVERIFY(vectors);
+        QCOMPARE(vectors[0], 1.0f);
+        QCOMPARE(vectors[7], 8.0f);
+
+        // Started, never finished
+        QCOMPARE(contents.directories.size(), 1);
+        QCOMPARE(contents.directories[0].files.size(), 2);
+
+        // Appending continues after what was read
+        QVERIFY(journal.finishDirectory("/docs"));
+        QVERIFY(journal.appendEmbeddings({2}, {{9.0f, 9.0f, 9.0f, 9.0f}}));
+        journal.close();
+
+        QVERIFY(journal.open(path, header(), contents));
+        QVERIFY(contents.directories.isEmpty());
+        QCOMPARE(contents.embeddings.size(), 2);
+        QCOMPARE(contents.embeddings[1].offset, qint64(8 * sizeof(float)));
+        QCOMPARE(journal.vectors(contents.embeddings[1])[0], 9.0f);
+    }
+
+    void testCrashLeftovers() {
+        QString path = m_dir.filePath("crash.jsonl");
+        writeSample(path);
+        qint64 journalSize = QFileInfo(path).size();
+        qint64 vectorSize = QFileInfo(path + ".vec").size();
+
+        // Killed mid-record, and after writing vectors but before their record
+        appendBytes(path, "{\"chunks\":[\"Third");
+        appendBytes(path + ".vec", QByteArray(4 * sizeof(float), '\x01'));
+
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(journal.open(path, header(), contents));
+        QCOMPARE(contents.skippedRecords, 0);
+        QCOMPARE(contents.documents.size(), 1);
+        QCOMPARE(contents.embeddings.size(), 1);
+        QCOMPARE(QFileInfo(path).size(), journalSize);
+        QCOMPARE(QFileInfo(path + ".vec").size(), vectorSize);
+    }
+
+    void testRecordWithoutVectors() {
+        QString path = m_dir.filePath("novectors.jsonl");
+        writeSample(path);
+
+        // The vector file lost its tail (e.g. restored from an older copy)
+        QFile vectors(path + ".vec");
+        QVERIFY(vectors.resize(4 * sizeof(float)));
+
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(journal.open(path, header(), contents));
+        QCOMPARE(contents.skippedRecords, 1);
+        QCOMPARE(contents.documents.size(), 1);
+        QVERIFY(contents.embeddings.isEmpty());
+    }
+
+    void testRemovedDocument() {
+        QString path = m_dir.filePath("removed.jsonl");
+        writeSample(path);
+
+        // a.txt changed and was chunked again
+        {
+            IngestionJournal journal;
+            IngestionJournalContents contents;
+            QVERIFY(journal.open(path, header(), contents));
+            QVERIFY(journal.appendRemoval("/docs/a.txt"));
+            QVERIFY(journal.appendDocument(makeDocument("/docs/a.txt", 2, {"Only chunk."})));
+        }
+
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(journal.open(path, header(), contents));
+        QCOMPARE(contents.skippedRecords, 0);
+        QCOMPARE(contents.documents.size(), 2);
+        QVERIFY(contents.documents[0].removed);
+        QVERIFY(!contents.documents[1].removed);
+        QCOMPARE(contents.documents[1].firstChunk, 2);
+    }
+
+    void testOneProcessAtATime() {
+        QString path = m_dir.filePath("locked.jsonl");
+        IngestionJournal first;
+        IngestionJournal second;
+        IngestionJournalContents contents;
+        QVERIFY(first.open(path, header(), contents));
+
+        QString error;
+        QVERIFY(!second.open(path, header(), contents, &error));
+        QVERIFY(error.contains("in use"));
+
+        first.close();
+        QVERIFY(second.open(path, header(), contents));
+    }
+
+    void testReset() {
+        QString path = m_dir.filePath("reset.jsonl");
+        writeSample(path);
+
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(journal.open(path, header(), contents));
+        QVERIFY(journal.reset(header("mxbai-embed-large")));
+        QCOMPARE(QFileInfo(path + ".vec").size(), qint64(0));
+        journal.close();
+
+        QVERIFY(journal.open(path, header(), contents));
+        QCOMPARE(contents.header["model"].toString(), QString("mxbai-embed-large"));
+        QVERIFY(contents.documents.isEmpty());
+        QVERIFY(contents.embeddings.isEmpty());
+        QVERIFY(contents.directories.isEmpty());
+    }
+
+    void testNotAJournal() {
+        QString path = m_dir.filePath("conversation.jsonl");
+        appendBytes(path, "{\"type\":\"conversation\",\"version\":2}\n");
+
+        IngestionJournal journal;
+        IngestionJournalContents contents;
+        QVERIFY(!journal.open(path, header(), contents));
+        QVERIFY(!journal.isOpen());
+    }
+};
+
+QTEST_MAIN(TestIngestionJournal)
+#include "test_ingestionjournal.moc"
@@ -0,0 +1,131 @@
+#include <QtTest/QtTest>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSignalSpy>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "../include/LocalApiServer.h"
+#include "../include/DaemonClient.h"
+#include "../include/Config.h"
+
+class TestLocalApiServer : public QObject {
+    Q_OBJECT
+
+private:
+    LocalApiServer *m_server;
+    QNetworkAccessManager *m_nam;
+
+    QString baseUrl() const {
+        return QString("http://127.0.0.1:%1").arg(m_server->serverPort());
+    }
+
+    // Issue a request and wait for it; returns the HTTP status code
+    int request(const QByteArray &method, const QString &path, const QByteArray &body, QJsonObject &response) {
+        QNetworkRequest req(QUrl(baseUrl() + path));
+        req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+        QNetworkReply *reply = m_nam->sendCustomRequest(req, method, body);
+        QSignalSpy finishedSpy(reply, &QNetworkReply::finished);
+        if (!reply->isFinished() && !finishedSpy.wait(5000)) {
+            reply->deleteLater();
+            return -1;
+        }
+
+        response = QJsonDocument::fromJson(reply->readAll()).object();
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        reply->deleteLater();
+        return status;
+    }
+
+private slots:
+    void initTestCase() {
+        Config::instance().resetToDefaults();
+        m_server = new LocalApiServer(this);
+        m_nam = new QNetworkAccessManager(this);
+        QVERIFY(m_server->listen(QHostAddress::LocalHost, 0));
+        QVERIFY(m_server->serverPort() > 0);
+    }
+
+    void cleanupTestCase() {
+        m_server->close();
+    }
+
+    void testHealthEndpoint() {
+        QJsonObject response;
+        QCOMPARE(request("GET", "/health", QByteArray(), response), 200);
+        QCOMPARE(response["status"].toString(), QString("ok"));
+        QCOMPARE(response["model"].toString(), Config::instance().getModel());
+        QCOMPARE(response["active_requests"].toInt(), 0);
+        QCOMPARE(response["memory"].toObject()["pressure"].toString(), QString("normal"));
+    }
+
+    void testModelsEndpoint() {
+        QJsonObject response;
+        QCOMPARE(request("GET", "/v1/models", QByteArray(), response), 200);
+        QCOMPARE(response["object"].toString(), QString("list"));
+
+        QJsonArray data = response["data"].toArray();
+        QVERIFY(!data.isEmpty());
+        QCOMPARE(data[0].toObject()["id"].toString(), Config::instance().getModel());
+    }
+
+    void testUnknownEndpoint() {
+        QJsonObject response;
+        QCOMPARE(request("GET", "/v1/unknown", QByteArray(), response), 404);
+        QVERIFY(response.contains("error"));
+    }
+
+    void testChatCompletionsRequiresPost() {
+        QJsonObject response;
+        QCOMPARE(request("GET", "/v1/chat/completions", QByteArray(), response), 405);
+    }
+
+    void testChatCompletionsRejectsInvalidJson() {
+        QJsonObject response;
+        QCOMPARE(request("POST", "/v1/chat/completions", "{not json", response), 400);
+        QCOMPARE(response["error"].toObject()["type"].toString(), QString("invalid_request_error"));
+    }
+
+    void testChatCompletionsRequiresUserMessage() {
+        QJsonObject body;
+        body["messages"] = QJsonArray{QJsonObject{{"role", "assistant"}, {"content", "hi"}}};
+
+        QJsonObject response;
+        QCOMPARE(request("POST", "/v1/chat/completions", QJsonDocument(body).toJson(), response), 400);
+    }
+
+    void testDaemonClientSurfacesErrors() {
+        // Not warmed up, so the daemon answers 503 with an error body
+        DaemonClient client(baseUrl() + "/");
+        QCOMPARE(client.getBaseUrl(), baseUrl());
+
+        QSignalSpy errorSpy(&client, &DaemonClient::errorOccurred);
+        QSignalSpy responseSpy(&client, &DaemonClient::responseReceived);
+
+        client.sendMessage("Hello");
+        QVERIFY(client.isBusy());
+        QVERIFY(errorSpy.wait(5000));
+
+        QCOMPARE(responseSpy.count(), 0);
+        QCOMPARE(errorSpy.at(0).at(0).toString(), QString("Daemon is not warmed up"));
+        QVERIFY(!client.isBusy());
+
+        // The failed exchange is not kept in the history
+        QVERIFY(client.getConversationHistory().isEmpty());
+    }
+
+    void testDaemonClientHealthCheck() {
+        DaemonClient client(baseUrl());
+        QSignalSpy healthSpy(&client, &DaemonClient::healthChecked);
+
+        client.checkHealth();
+        QVERIFY(healthSpy.wait(5000));
+        QVERIFY(healthSpy.at(0).at(0).toBool());
+        QCOMPARE(healthSpy.at(0).at(1).toJsonObject()["status"].toString(), QString("ok"));
+    }
+};
+
+QTEST_MAIN(TestLocalApiServer)
+#include "test_localapiserver.moc"
@@ -0,0 +1,168 @@
+#include <QtTest/QtTest>
+#include <QThread>
+#include <atomic>
+#include "../include/MemoryGovernor.h"
+
+class TestMemoryGovernor : public QObject {
+    Q_OBJECT
+
+private:
+    // Shed stages in the order they ran
+    struct Recorder {
+        QList<MemoryGovernor::ShedStage> stages;
+    };
+
+    static void addRecordingShedders(QObject *owner, Recorder &recorder) {
+        for (int stage = 0; stage < MemoryGovernor::StageCount; ++stage) {
+            MemoryGovernor::instance().addShedder(static_cast<MemoryGovernor::ShedStage>(stage), owner,
+                                                  [&recorder, stage]() {
+                recorder.stages.append(static_cast<MemoryGovernor::ShedStage>(stage));
+            });
+        }
+    }
+
+private slots:
+    void cleanup() {
+        MemoryGovernor::instance().setBudget(0);
+        MemoryGovernor::instance().sample();
+    }
+
+    void testAccounts() {
+        MemoryGovernor &governor = MemoryGovernor::instance();
+        qint64 before = governor.accountedBytes();
+        {
+            MemoryAccount first("test_cache");
+            MemoryAccount second("test_cache");
+            MemoryAccount other("test_other");
+            first.set(1000);
+            second.set(500);
+            other.set(24);
+
+            // Same-name accounts add up
+            QCOMPARE(governor.subsystems().value("test_cache"), qint64(1500));
+            QCOMPARE(governor.subsystems().value("test_other"), qint64(24));
+            QCOMPARE(governor.accountedBytes(), before + 1524);
+
+            QJsonObject json = governor.toJson();
+            QCOMPARE(json["subsystems"].toObject()["test_cache"].toDouble(), 1500.0);
+            QCOMPARE(json["pressure"].toString(), QString("normal"));
+        }
+        QVERIFY(!governor.subsystems().contains("test_cache"));
+        QCOMPARE(governor.accountedBytes(), before);
+    }
+
+    void testResidentSample() {
+#ifdef Q_OS_LINUX
+        QVERIFY(MemoryGovernor::sampleResidentBytes() > 0);
+#endif
+        MemoryGovernor::instance().sample();
+        QVERIFY(MemoryGovernor::instance().residentBytes() >= 0);
+    }
+
+    void testStagesInOrder() {
+        if (MemoryGovernor::sampleResidentBytes() < 0) {
+            QSKIP("Resident memory is not readable on this platform");
+        }
+        MemoryGovernor &governor = MemoryGovernor::instance();
+        QObject owner;
+        Recorder recorder;
+        addRecordingShedders(&owner, recorder);
+
+        // Unlimited: never sheds
+        governor.sample();
+        QCoreApplication::processEvents();
+        QVERIFY(recorder.stages.isEmpty());
+
+        // Any process is over a one-byte budget: one stage per sample, cheapest first
+        QSignalSpy pressureSpy(&governor, &MemoryGovernor::pressureChanged);
+        governor.setBudget(1);
+        int shedsBefore = governor.shedCount();
+        for (int stage = 0; stage < MemoryGovernor::StageCount; ++stage) {
+            governor.sample();
+            QCOMPARE(recorder.stages.size(), stage);  // Queued, never run inside sample()
+            QCoreApplication::processEvents();
+            QCOMPARE(recorder.stages.size(), stage + 1);
+            QCOMPARE(recorder.stages.last(), static_cast<MemoryGovernor::ShedStage>(stage));
+        }
+        QCOMPARE(governor.pressure(), MemoryGovernor::Over);
+        QCOMPARE(pressureSpy.count(), 1);
+        QCOMPARE(governor.shedCount() - shedsBefore, int(MemoryGovernor::StageCount));
+
+        // Still over after the last stage: start over
+        governor.sample();
+        QCoreApplication::processEvents();
+        QCOMPARE(recorder.stages.last(), MemoryGovernor::RenderCaches);
+
+        // Back under budget, then over again: from the first stage
+        governor.setBudget(0);
+        governor.sample();
+        QCOMPARE(governor.pressure(), MemoryGovernor::Normal);
+        governor.setBudget(1);
+        governor.sample();
+        governor.sample();
+        QCoreApplication::processEvents();
+        QCOMPARE(recorder.stages.mid(recorder.stages.size() - 2),
+                 QList<MemoryGovernor::ShedStage>({MemoryGovernor::RenderCaches, MemoryGovernor::TranscriptHtml}));
+    }
+
+    void testElevated() {
+        if (MemoryGovernor::sampleResidentBytes() < 0) {
+            QSKIP("Resident memory is not readable on this platform");
+        }
+        MemoryGovernor &governor = MemoryGovernor::instance();
+        QObject owner;
+        Recorder recorder;
+        addRecordingShedders(&owner, recorder);
+
+        // Usage between 80% and 100% of the budget is reported, not shed
+        governor.sample();
+        qint64 used = governor.residentBytes();
+        QVERIFY(used > 0);
+        governor.setBudget(used + used / 10);
+        governor.sample();
+        QCoreApplication::processEvents();
+        QCOMPARE(governor.pressure(), MemoryGovernor::Elevated);
+        QVERIFY(recorder.stages.isEmpty());
+        QVERIFY(governor.summary().contains(" / "));
+    }
+
+    void testDestroyedOwnerForgotten() {
+        MemoryGovernor &governor = MemoryGovernor::instance();
+        Recorder recorder;
+        QObject *owner = new QObject;
+        addRecordingShedders(owner, recorder);
+        delete owner;
+
+        governor.setBudget(1);
+        governor.sample();
+        QCoreApplication::processEvents();
+        QVERIFY(recorder.stages.isEmpty());
+    }
+
+    void testShedsOnOwnerThread() {
+        if (MemoryGovernor::sampleResidentBytes() < 0) {
+            QSKIP("Resident memory is not readable on this platform");
+        }
+        MemoryGovernor &governor = MemoryGovernor::instance();
+        QThread worker;
+        worker.start();
+        QObject *owner = new QObject;
+        owner->moveToThread(&worker);
+        connect(&worker, &QThread::finished, owner, &QObject::deleteLater);
+
+        std::atomic<QThread*> ranOn(nullptr);
+        governor.addShedder(MemoryGovernor::RenderCaches, owner, [&ranOn]() {
+            ranOn = QThread::currentThread();
+        });
+
+        governor.setBudget(1);
+        governor.sample();
+        QTRY_COMPARE(ranOn.load(), &worker);
+
+        worker.quit();
+        worker.wait();
+    }
+};
+
+QTEST_MAIN(TestMemoryGovernor)
+#include "test_memorygovernor.moc"
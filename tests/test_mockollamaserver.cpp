@@ -0,0 +1,148 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include "../include/MockOllamaServer.h"
+#include "../include/LLMClient.h"
+#include "../include/Config.h"
+
+class TestMockOllamaServer : public QObject {
+    Q_OBJECT
+
+private:
+    // Client pointed at the mock, with capabilities taken from its /api/show
+    LLMClient *createClient(MockOllamaServer &server, QString *format = nullptr) {
+        LLMClient *client = new LLMClient(this);
+        client->setApiUrl(server.generateUrl());
+        client->setMaxRetries(0);
+
+        QSignalSpy capabilitiesSpy(client, &LLMClient::modelCapabilitiesDetected);
+        if (!capabilitiesSpy.wait(5000)) {
+            return nullptr;
+        }
+        if (format) {
+            *format = capabilitiesSpy.at(0).at(0).toString();
+        }
+        return client;
+    }
+
+private slots:
+    void initTestCase() {
+        Config::instance().resetToDefaults();
+    }
+
+    void testCapabilityDetection() {
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        QString format;
+        LLMClient *client = createClient(server, &format);
+        QVERIFY(client);
+        QCOMPARE(format, QString("native"));
+        QCOMPARE(server.requestCount(), 1);
+        delete client;
+    }
+
+    void testStreamsConfiguredTokens() {
+        MockOllamaOptions options;
+        options.responseTokens = 25;
+        options.tokensPerChunk = 5;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+
+        QSignalSpy tokenSpy(client, &LLMClient::tokenReceived);
+        QSignalSpy statsSpy(client, &LLMClient::generationStats);
+        QSignalSpy responseSpy(client, &LLMClient::responseReceived);
+
+        client->sendPrompt("hello");
+        QVERIFY(responseSpy.wait(5000));
+
+        // 25 tokens in chunks of 5
+        QCOMPARE(tokenSpy.count(), 5);
+        QCOMPARE(statsSpy.count(), 1);
+        QCOMPARE(statsSpy.at(0).at(1).toInt(), 25);
+        QVERIFY(!responseSpy.at(0).at(0).toString().isEmpty());
+        QCOMPARE(server.tokensSent(), qint64(25));
+        delete client;
+    }
+
+    void testFirstTokenDelay() {
+        MockOllamaOptions options;
+        options.responseTokens = 3;
+        options.firstTokenDelayMs = 200;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+
+        QSignalSpy tokenSpy(client, &LLMClient::tokenReceived);
+        client->sendPrompt("hello");
+        QVERIFY(tokenSpy.wait(5000));
+
+        // Held back by the server itself, not by the time it took to get here
+        QCOMPARE(server.firstChunkDelays().size(), 1);
+        QVERIFY(server.firstChunkDelays().first() >= options.firstTokenDelayMs);
+        delete client;
+    }
+
+    void testNativeToolCall() {
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        options.toolCallName = "calculator";
+        options.toolCallArguments = QJsonObject{{"operation", "add"}, {"a", 2}, {"b", 3}};
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+
+        QSignalSpy toolSpy(client, &LLMClient::toolCallRequested);
+        QJsonArray tools{QJsonObject{
+            {"name", "calculator"},
+            {"description", "Performs basic arithmetic"},
+            {"parameters", QJsonObject{{"a", "number"}, {"b", "number"}}}
+        }};
+        client->sendPromptWithTools("What is 2 + 3?", tools);
+        QVERIFY(toolSpy.wait(5000));
+        QCOMPARE(toolSpy.at(0).at(0).toString(), QString("calculator"));
+        QCOMPARE(toolSpy.at(0).at(1).toJsonObject()["a"].toInt(), 2);
+        delete client;
+    }
+
+    void testEmbeddingsAreDeterministic() {
+        MockOllamaOptions options;
+        options.embeddingDimensions = 16;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        QNetworkAccessManager nam;
+        auto embed = [&](const QString &text) {
+            QNetworkRequest request(QUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort())));
+            request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+            QNetworkReply *reply = nam.post(request, QJsonDocument(QJsonObject{{"prompt", text}}).toJson());
+            QSignalSpy finishedSpy(reply, &QNetworkReply::finished);
+            finishedSpy.wait(5000);
+            QJsonArray embedding = QJsonDocument::fromJson(reply->readAll()).object()["embedding"].toArray();
+            reply->deleteLater();
+            return embedding;
+        };
+
+        QJsonArray first = embed("same text");
+        QCOMPARE(first.size(), 16);
+        QCOMPARE(embed("same text"), first);
+        QVERIFY(embed("other text") != first);
+    }
+};
+
+QTEST_MAIN(TestMockOllamaServer)
+#include "test_mockollamaserver.moc"
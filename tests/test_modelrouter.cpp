@@ -0,0 +1,208 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "../include/ModelRouter.h"
+#include "../include/MockOllamaServer.h"
+#include "../include/LLMClient.h"
+#include "../include/Config.h"
+
+class TestModelRouter : public QObject {
+    Q_OBJECT
+
+private:
+    // Client on the main model "big", with capabilities taken from the mock's /api/show
+    LLMClient *createClient(MockOllamaServer &server) {
+        LLMClient *client = new LLMClient(this);
+        client->setApiUrl(server.generateUrl());
+        client->setModel("big");
+        client->setMaxRetries(0);
+
+        QSignalSpy capabilitiesSpy(client, &LLMClient::modelCapabilitiesDetected);
+        if (!capabilitiesSpy.wait(5000)) {
+            delete client;
+            return nullptr;
+        }
+        return client;
+    }
+
+    QJsonArray calculatorTools() {
+        QJsonObject function{
+            {"name", "calculator"},
+            {"description", "Adds two numbers"},
+            {"parameters", QJsonObject{{"type", "object"}, {"properties", QJsonObject()}}}
+        };
+        return QJsonArray{QJsonObject{{"type", "function"}, {"function", function}}};
+    }
+
+private slots:
+    void init() {
+        Config::instance().resetToDefaults();
+        ModelRouter::instance().clear();
+    }
+
+    void cleanupTestCase() {
+        Config::instance().resetToDefaults();
+    }
+
+    void testModelForResolution() {
+        ConfigSnapshot cfg;
+        cfg.model = "big";
+
+        // Nothing configured: every role stays on the main model
+        QCOMPARE(ModelRouter::modelFor(ModelRole::ToolSelection, cfg), QString("big"));
+        QVERIFY(ModelRouter::routedModels(cfg).isEmpty());
+
+        cfg.fastModel = "small";
+        QCOMPARE(ModelRouter::modelFor(ModelRole::Answer, cfg), QString("big"));
+        QCOMPARE(ModelRouter::modelFor(ModelRole::ToolSelection, cfg), QString("small"));
+        QCOMPARE(ModelRouter::modelFor(ModelRole::Summarization, cfg), QString("small"));
+
+        // A role's own setting wins over fast_model
+        cfg.queryRewriteModel = "rewriter";
+        QCOMPARE(ModelRouter::modelFor(ModelRole::QueryRewrite, cfg), QString("rewriter"));
+        QCOMPARE(ModelRouter::routedModels(cfg), (QStringList{"small", "rewriter"}));
+
+        // The client's own model overrides the snapshot's, and is never routed to itself
+        QCOMPARE(ModelRouter::modelFor(ModelRole::Answer, cfg, "other"), QString("other"));
+        QCOMPARE(ModelRouter::routedModels(cfg, "small"), QStringList{"rewriter"});
+    }
+
+    void testFormatCache() {
+        ModelRouter &router = ModelRouter::instance();
+        QVERIFY(router.toolCallFormat("http://a", "small").isEmpty());
+
+        QVERIFY(router.beginCapabilityQuery("http://a", "small"));
+        QVERIFY(!router.beginCapabilityQuery("http://a", "small"));
+        router.endCapabilityQuery("http://a", "small");
+        router.setToolCallFormat("http://a", "small", "native");
+
+        QCOMPARE(router.toolCallFormat("http://a", "small"), QString("native"));
+        QVERIFY(router.toolCallFormat("http://b", "small").isEmpty());
+        QVERIFY(!router.beginCapabilityQuery("http://a", "small"));
+    }
+
+    void testToolTurnRoutedToFastModel() {
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        options.toolCallName = "calculator";
+        options.toolCallArguments = QJsonObject{{"a", 2}, {"b", 3}};
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        Config::instance().setFastModel("small");
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+
+        // The fast model's format is queried once at startup and shared
+        QTRY_COMPARE(ModelRouter::instance().toolCallFormat(server.generateUrl(), "small"), QString("native"));
+
+        QSignalSpy toolSpy(client, &LLMClient::toolCallRequested);
+        client->sendPromptWithTools("what is 2 + 3?", calculatorTools());
+        QVERIFY(toolSpy.wait(5000));
+
+        QCOMPARE(toolSpy.first()[0].toString(), QString("calculator"));
+        QCOMPARE(toolSpy.first()[1].toJsonObject()["b"].toInt(), 3);
+        QCOMPARE(server.requestedModels(), QStringList{"small"});
+        delete client;
+    }
+
+    void testMainModelAnswersWhenNoToolCalled() {
+        // No tool name: the mock answers every turn with text
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        options.responseTokens = 5;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        Config::instance().setFastModel("small");
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+        QTRY_COMPARE(ModelRouter::instance().toolCallFormat(server.generateUrl(), "small"), QString("native"));
+
+        QSignalSpy tokenSpy(client, &LLMClient::tokenReceived);
+        QSignalSpy responseSpy(client, &LLMClient::responseReceived);
+        client->sendPromptWithTools("hello", calculatorTools());
+        QVERIFY(responseSpy.wait(5000));
+        QTest::qWait(200);
+
+        // The fast model's text is discarded; only the main model's answer is shown
+        QCOMPARE(server.requestedModels(), (QStringList{"small", "big"}));
+        QCOMPARE(responseSpy.count(), 1);
+        QCOMPARE(server.tokensSent(), qint64(10));
+        QString streamed;
+        for (const QList<QVariant> &args : tokenSpy) {
+            streamed += args[0].toString();
+        }
+        QCOMPARE(streamed, responseSpy.first()[0].toString());
+        delete client;
+    }
+
+    void testPromptToolModelKeepsQuestionForNativeMainModel() {
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        options.toolCallName = "lookup";
+        options.responseTokens = 5;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        Config::instance().setFastModel("small");
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+        QTRY_COMPARE(ModelRouter::instance().toolCallFormat(server.generateUrl(), "small"), QString("native"));
+
+        // The main model calls tools natively, the tool model only through the prompt
+        ModelRouter::instance().setToolCallFormat(server.generateUrl(), "small", "prompt");
+
+        QSignalSpy toolSpy(client, &LLMClient::toolCallRequested);
+        client->sendPromptWithTools("where is the lookup table?", QJsonArray{QJsonObject{{"name", "lookup"}}});
+        QVERIFY(toolSpy.wait(5000));
+        QCOMPARE(server.requestedModels(), QStringList{"small"});
+        QVERIFY(!server.generationRequests().first().contains("messages"));
+
+        // The results go to the main model after the question that asked for them
+        QSignalSpy responseSpy(client, &LLMClient::responseReceived);
+        QJsonObject result{{"tool_name", "lookup"}, {"call_id", toolSpy.first()[2].toString()},
+                           {"result", QJsonObject{{"row", 7}}}};
+        client->sendToolResults("where is the lookup table?", QJsonArray{result});
+        QVERIFY(responseSpy.wait(5000));
+
+        QCOMPARE(server.requestedModels(), (QStringList{"small", "big"}));
+        QJsonArray messages = server.generationRequests().last()["messages"].toArray();
+        QStringList roles;
+        for (const QJsonValue &message : messages) {
+            roles.append(message.toObject()["role"].toString());
+        }
+        QVERIFY(roles.size() >= 3);
+        QCOMPARE(roles.mid(roles.size() - 3), (QStringList{"user", "assistant", "user"}));
+        QCOMPARE(messages[messages.size() - 3].toObject()["content"].toString(), QString("where is the lookup table?"));
+        QVERIFY(messages[messages.size() - 2].toObject()["content"].toString().contains("lookup"));
+        QVERIFY(messages.last().toObject()["content"].toString().contains("Tool: lookup"));
+        delete client;
+    }
+
+    void testUnknownFormatUsesMainModel() {
+        MockOllamaOptions options;
+        options.nativeTools = true;
+        options.toolCallName = "calculator";
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+
+        LLMClient *client = createClient(server);
+        QVERIFY(client);
+
+        // Configured after startup, so the fast model was never queried
+        Config::instance().setFastModel("small");
+        QSignalSpy toolSpy(client, &LLMClient::toolCallRequested);
+        client->sendPromptWithTools("what is 2 + 3?", calculatorTools());
+        QVERIFY(toolSpy.wait(5000));
+        QCOMPARE(server.requestedModels(), QStringList{"big"});
+
+        // The query started by that turn lets the next one route
+        QTRY_COMPARE(ModelRouter::instance().toolCallFormat(server.generateUrl(), "small"), QString("native"));
+        delete client;
+    }
+};
+
+QTEST_MAIN(TestModelRouter)
+#include "test_modelrouter.moc"
@@ -3,11 +3,41 @@
 #include <QTemporaryDir>
 #include <QFile>
 #include <QTextStream>
+#include <QSignalSpy>
 #include "../include/RAGEngine.h"
+#include "../include/MockOllamaServer.h"
 
 class TestRAGEngine : public QObject {
     Q_OBJECT
 
+private:
+    // Three short chunks, queued for embedding by the mock
+    bool startPolicies(RAGEngine &engine, MockOllamaServer &server, const QTemporaryDir &dir) {
+        engine.setApiUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+        engine.setChunkSize(60);
+        engine.setChunkOverlap(0);
+
+        QString path = dir.filePath("policies.txt");
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        file.write("Refunds are issued within 30 days of purchase. "
+                   "Shipping is free for orders over 50 euros. "
+                   "Support is available on weekdays from 9 to 5.");
+        file.close();
+
+        return engine.ingestDocument(path);
+    }
+
+    // Same, and embedded
+    bool ingestPolicies(RAGEngine &engine, MockOllamaServer &server, const QTemporaryDir &dir) {
+        if (!startPolicies(engine, server, dir)) {
+            return false;
+        }
+        return QTest::qWaitFor([&engine]() { return engine.getPendingEmbeddingCount() == 0; }, 5000);
+    }
+
 private slots:
     void initTestCase() {
         // Runs once before all tests
@@ -307,6 +337,434 @@ private slots:
         // Should emit error signal
         QVERIFY(spyError.count() > 0);
     }
+
+    void testDeadlineFallsBackToLexicalMatches() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingestPolicies(engine, server, dir));
+        QCOMPARE(engine.getChunkCount(), 3);
+
+        // The embedding server now answers after the deadline, before the late result is given up on
+        MockOllamaOptions options;
+        options.embeddingDelayMs = 300;
+        server.setOptions(options);
+        engine.setRetrievalDeadline(100);
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+        QSignalSpy lateSpy(&engine, &RAGEngine::lateRetrievalFinished);
+        int requestId = engine.requestContext("Is shipping free for large orders?", 1);
+        QVERIFY(readySpy.wait(2000));
+
+        // Answered by the fallback, not by the late vector result
+        QCOMPARE(degradedSpy.count(), 1);
+        QCOMPARE(readySpy.first()[0].toInt(), requestId);
+        QStringList contexts = readySpy.first()[1].toStringList();
+        QCOMPARE(contexts.size(), 1);
+        QVERIFY(contexts.first().startsWith("Shipping"));
+
+        // The late vector result is not delivered, but it is kept for the next ask
+        QVERIFY(lateSpy.wait(2000));
+        QCOMPARE(lateSpy.first()[0].toInt(), requestId);
+        QCOMPARE(lateSpy.first()[1].toBool(), true);
+        QCOMPARE(readySpy.count(), 1);
+
+        int requestsBefore = server.requestCount();
+        engine.requestContext("Is shipping free for large orders?", 1);
+        QVERIFY(readySpy.wait(2000));
+        QCOMPARE(server.requestCount(), requestsBefore);
+        QCOMPARE(degradedSpy.count(), 1);
+    }
+
+    void testLateQueryEmbeddingIsAbandoned() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingestPolicies(engine, server, dir));
+
+        // Hung server: the late call is cancelled after five deadlines, so nothing is cached
+        MockOllamaOptions options;
+        options.embeddingDelayMs = 1500;
+        server.setOptions(options);
+        engine.setRetrievalDeadline(100);
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+        QSignalSpy lateSpy(&engine, &RAGEngine::lateRetrievalFinished);
+        int requestId = engine.requestContext("Is shipping free for large orders?", 1);
+        QVERIFY(readySpy.wait(2000));
+        QVERIFY(lateSpy.wait(2000));
+        QCOMPARE(lateSpy.first()[0].toInt(), requestId);
+        QCOMPARE(lateSpy.first()[1].toBool(), false);
+        QCOMPARE(readySpy.count(), 1);
+
+        int requestsBefore = server.requestCount();
+        engine.requestContext("Is shipping free for large orders?", 1);
+        QVERIFY(readySpy.wait(2000));
+        QCOMPARE(server.requestCount(), requestsBefore + 1);
+        QCOMPARE(degradedSpy.count(), 2);
+    }
+
+    void testEmbeddingFailureFallsBack() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingestPolicies(engine, server, dir));
+
+        // Embedding server gone: answered from the lexical index, not with an error
+        server.close();
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        QSignalSpy failedSpy(&engine, &RAGEngine::contextFailed);
+        QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+        engine.requestContext("when are refunds issued", 3);
+        QVERIFY(readySpy.wait(5000));
+
+        QCOMPARE(failedSpy.count(), 0);
+        QCOMPARE(degradedSpy.count(), 1);
+        QStringList contexts = readySpy.first()[1].toStringList();
+        QCOMPARE(contexts.size(), 1);
+        QVERIFY(contexts.first().startsWith("Refunds"));
+
+        // Nothing in common with any chunk: no context rather than a wrong one
+        engine.requestContext("zebra xylophone", 3);
+        QVERIFY(readySpy.wait(5000));
+        QVERIFY(readySpy.last()[1].toStringList().isEmpty());
+    }
+
+    void testDimensionReductionReembeds() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingestPolicies(engine, server, dir));
+
+        // Only reduced vectors are kept, so a new width means new embeddings
+        QSignalSpy generatedSpy(&engine, &RAGEngine::embeddingGenerated);
+        engine.setDimensionReduction("truncate", 128);
+        QTRY_COMPARE(generatedSpy.count(), 3);
+        QCOMPARE(engine.getEmbeddingDimension(), 768);  // As the model returns them
+
+        // Same setting again: nothing to redo
+        int requests = server.requestCount();
+        engine.setDimensionReduction("truncate", 128);
+        QTest::qWait(100);
+        QCOMPARE(server.requestCount(), requests);
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+        engine.requestContext("Is shipping free for large orders?", 2);
+        QVERIFY(readySpy.wait(2000));
+        QCOMPARE(degradedSpy.count(), 0);
+        QCOMPARE(readySpy.first()[1].toStringList().size(), 2);
+    }
+
+    void testModelChangeReembeds() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingestPolicies(engine, server, dir));
+        QCOMPARE(engine.getEmbeddingDimension(), 768);
+
+        // The new model's vectors are narrower; none of the old ones may stay in the index
+        MockOllamaOptions options;
+        options.embeddingDimensions = 384;
+        server.setOptions(options);
+        QSignalSpy generatedSpy(&engine, &RAGEngine::embeddingGenerated);
+        engine.setEmbeddingModel("other-embed");
+        QTRY_COMPARE(generatedSpy.count(), 3);
+        QCOMPARE(engine.getEmbeddingDimension(), 384);
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+        engine.requestContext("Is shipping free for large orders?", 3);
+        QVERIFY(readySpy.wait(2000));
+        QCOMPARE(degradedSpy.count(), 0);
+        QCOMPARE(readySpy.first()[1].toStringList().size(), 3);
+    }
+
+    void testDirectoryIngestionReadsAhead() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+
+        RAGEngine engine;
+        engine.setApiUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+        QStringList expected;
+        for (int i = 0; i < 40; ++i) {
+            QString path = dir.filePath(QString("note%1.%2").arg(i, 2, 10, QChar('0')).arg(i % 2 ? "md" : "txt"));
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QString("Note %1: the read-ahead keeps files in order.").arg(i).toUtf8());
+            expected.append(path);
+        }
+
+        // Read concurrently, ingested in directory order
+        QSignalSpy ingestedSpy(&engine, &RAGEngine::documentIngested);
+        QVERIFY(engine.ingestDirectory(dir.path()));
+        QCOMPARE(engine.getDocumentCount(), 40);
+        QCOMPARE(ingestedSpy.count(), 40);
+        for (int i = 0; i < 40; ++i) {
+            QCOMPARE(ingestedSpy[i][0].toString(), expected[i]);
+        }
+
+        // Unchanged since: skipped without being read or chunked again
+        int chunksBefore = engine.getChunkCount();
+        QVERIFY(engine.ingestDirectory(dir.path()));
+        QCOMPARE(ingestedSpy.count(), 80);
+        QCOMPARE(engine.getChunkCount(), chunksBefore);
+    }
+
+    void testTokenChunking() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+
+        // Every word is in the vocabulary: each sentence is exactly 10 tokens
+        QString vocabPath = dir.filePath("vocab.txt");
+        QFile vocab(vocabPath);
+        QVERIFY(vocab.open(QIODevice::WriteOnly));
+        vocab.write("[UNK]\nthe\nquick\nbrown\nfox\njumps\nover\nlazy\ndog\n.\n");
+        vocab.close();
+
+        QString path = dir.filePath("fox.txt");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        for (int i = 0; i < 20; ++i) {
+            file.write("The quick brown fox jumps over the lazy dog. ");
+        }
+        file.close();
+
+        RAGEngine engine;
+        engine.setApiUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+        engine.setTokenizer(vocabPath);
+        QCOMPARE(engine.tokenizer(), vocabPath);
+        QCOMPARE(engine.countTokens("the lazy dog"), 3);
+
+        // 25 tokens fit two and a half sentences; chunks end on the sentence instead
+        engine.setChunkTokens(25);
+        engine.setChunkOverlap(0);
+        QString journalPath = dir.filePath("ingestion.jsonl");
+        QVERIFY(engine.setIngestionJournal(journalPath));
+        QVERIFY(engine.ingestDocument(path));
+        QCOMPARE(engine.getChunkCount(), 10);
+        QVERIFY(QTest::qWaitFor([&engine]() { return engine.getPendingEmbeddingCount() == 0; }, 5000));
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        engine.requestContext("lazy dog", 10);
+        QVERIFY(readySpy.wait(2000));
+        const QStringList contexts = readySpy.first()[1].toStringList();
+        QVERIFY(!contexts.isEmpty());
+        for (const QString &context : contexts) {
+            QCOMPARE(engine.countTokens(context), 20);
+            QVERIFY(context.startsWith("The quick"));
+            QVERIFY(context.endsWith("lazy dog."));
+        }
+
+        // Counts are journaled with the tokenizer they came from
+        QFile journal(journalPath);
+        QVERIFY(journal.open(QIODevice::ReadOnly));
+        QByteArray records = journal.readAll();
+        QVERIFY(records.contains("\"tokens\":[20,20,"));
+        QVERIFY(records.contains(vocabPath.toUtf8()));
+
+        // A one-sentence overlap (44 characters) carries the previous sentence into each chunk
+        engine.clearDocuments();
+        engine.setChunkOverlap(45);
+        QVERIFY(engine.ingestDocument(path));
+        QCOMPARE(engine.getChunkCount(), 19);
+    }
+
+    void testSplitWordStaysWithinBudget() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+
+        // "aaa" is one token alone, but inside a longer word only the first three letters are
+        QString vocabPath = dir.filePath("vocab.txt");
+        QFile vocab(vocabPath);
+        QVERIFY(vocab.open(QIODevice::WriteOnly));
+        vocab.write("[UNK]\naaa\n##a\nthe\n");
+        vocab.close();
+
+        // One 12-letter word (10 tokens) between short ones; the budget holds three pieces' worth
+        QString path = dir.filePath("blob.txt");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("the aaaaaaaaaaaa the");
+        file.close();
+
+        RAGEngine engine;
+        engine.setApiUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+        engine.setTokenizer(vocabPath);
+        QCOMPARE(engine.countTokens("aaaaaaaaa"), 7);
+        engine.setChunkTokens(3);
+        engine.setChunkOverlap(10);
+        QVERIFY(engine.ingestDocument(path));
+
+        // "the aaa", "aaa", "aaa", "aaa the": each piece apart from the others
+        QCOMPARE(engine.getChunkCount(), 4);
+        QVERIFY(QTest::qWaitFor([&engine]() { return engine.getPendingEmbeddingCount() == 0; }, 5000));
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        engine.requestContext("aaa", 4);
+        QVERIFY(readySpy.wait(2000));
+        const QStringList contexts = readySpy.first()[1].toStringList();
+        QCOMPARE(contexts.size(), 4);
+        for (const QString &context : contexts) {
+            QVERIFY2(engine.countTokens(context) <= 3, qPrintable(context));
+            QCOMPARE(context.count("aaa"), 1);
+        }
+    }
+
+    void testJournalResumesIngestion() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        QString journalPath = dir.filePath("journal/ingestion.jsonl");
+        QString url = QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort());
+
+        {
+            RAGEngine engine;
+            QVERIFY(engine.setIngestionJournal(journalPath));
+            QVERIFY(ingestPolicies(engine, server, dir));
+        }
+
+        // Everything was committed: restored without reading the file or calling the server
+        QVERIFY(QFile::remove(dir.filePath("policies.txt")));
+        int requestsBefore = server.requestCount();
+        {
+            RAGEngine engine;
+            engine.setApiUrl(url);
+            QSignalSpy resumedSpy(&engine, &RAGEngine::ingestionResumed);
+            QVERIFY(engine.setIngestionJournal(journalPath));
+            QCOMPARE(engine.getDocumentCount(), 1);
+            QCOMPARE(engine.getChunkCount(), 3);
+            QCOMPARE(engine.getPendingEmbeddingCount(), 0);
+            QCOMPARE(resumedSpy.count(), 1);
+            QCOMPARE(resumedSpy.first()[2].toInt(), 0);
+
+            QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+            QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+            engine.requestContext("Is shipping free for large orders?", 1);
+            QVERIFY(readySpy.wait(2000));
+            QCOMPARE(degradedSpy.count(), 0);
+            QCOMPARE(server.requestCount(), requestsBefore + 1);  // Just the query
+
+            // A different model's vectors can't be reused
+            engine.setEmbeddingModel("other-embed");
+        }
+
+        // Chunks are kept; only the embeddings are redone
+        {
+            RAGEngine engine;
+            engine.setApiUrl(url);
+            engine.setEmbeddingModel("other-embed");
+            QSignalSpy generatedSpy(&engine, &RAGEngine::embeddingGenerated);
+            QVERIFY(engine.setIngestionJournal(journalPath));
+            QCOMPARE(engine.getChunkCount(), 3);
+            QTRY_COMPARE(generatedSpy.count(), 3);
+
+            // Cleared documents stay cleared
+            engine.clearDocuments();
+        }
+        {
+            RAGEngine engine;
+            QVERIFY(engine.setIngestionJournal(journalPath));
+            QCOMPARE(engine.getChunkCount(), 0);
+        }
+    }
+
+    void testReingestingChangedDocumentReplacesChunks() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        QString journalPath = dir.filePath("ingestion.jsonl");
+        QString url = QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort());
+
+        {
+            RAGEngine engine;
+            QVERIFY(engine.setIngestionJournal(journalPath));
+            QVERIFY(ingestPolicies(engine, server, dir));
+            QCOMPARE(engine.getChunkCount(), 3);
+
+            // The file shrinks to one sentence: its three old chunks go, one new one comes
+            QFile file(dir.filePath("policies.txt"));
+            QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+            file.write("Returns are accepted within 14 days of delivery.");
+            file.close();
+            QVERIFY(engine.ingestDocument(file.fileName()));
+            QCOMPARE(engine.getDocumentCount(), 1);
+            QCOMPARE(engine.getChunkCount(), 1);
+            QTRY_COMPARE(engine.getPendingEmbeddingCount(), 0);
+
+            QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+            QSignalSpy degradedSpy(&engine, &RAGEngine::retrievalDegraded);
+            engine.requestContext("when are refunds issued", 3);
+            QVERIFY(readySpy.wait(2000));
+            QCOMPARE(degradedSpy.count(), 0);
+            QCOMPARE(readySpy.first()[1].toStringList(), QStringList{"Returns are accepted within 14 days of delivery."});
+        }
+
+        // The journal brings back only the current version
+        int requestsBefore = server.requestCount();
+        RAGEngine engine;
+        engine.setApiUrl(url);
+        QVERIFY(engine.setIngestionJournal(journalPath));
+        QCOMPARE(engine.getDocumentCount(), 1);
+        QCOMPARE(engine.getChunkCount(), 1);
+        QCOMPARE(engine.getPendingEmbeddingCount(), 0);
+        QCOMPARE(server.requestCount(), requestsBefore);
+
+        // Re-embedding compacts the removed chunks away
+        QSignalSpy generatedSpy(&engine, &RAGEngine::embeddingGenerated);
+        engine.setDimensionReduction("truncate", 128);
+        QTRY_COMPARE(generatedSpy.count(), 1);
+        QCOMPARE(engine.getChunkCount(), 1);
+
+        QSignalSpy readySpy(&engine, &RAGEngine::contextReady);
+        engine.requestContext("when are refunds issued", 3);
+        QVERIFY(readySpy.wait(2000));
+        QCOMPARE(readySpy.first()[1].toStringList().size(), 1);
+    }
+
+    void testJournalResumesInterruptedEmbedding() {
+        QTemporaryDir dir;
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        QString journalPath = dir.filePath("ingestion.jsonl");
+
+        // The process goes away while embeddings are still in flight
+        MockOllamaOptions slow;
+        slow.embeddingDelayMs = 2000;
+        server.setOptions(slow);
+        {
+            RAGEngine engine;
+            QVERIFY(engine.setIngestionJournal(journalPath));
+            QVERIFY(startPolicies(engine, server, dir));
+            QCOMPARE(engine.getChunkCount(), 3);
+            QVERIFY(engine.getPendingEmbeddingCount() > 0);
+        }
+
+        server.setOptions(MockOllamaOptions());
+        RAGEngine engine;
+        engine.setApiUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+        QSignalSpy generatedSpy(&engine, &RAGEngine::embeddingGenerated);
+        QVERIFY(engine.setIngestionJournal(journalPath));
+        QCOMPARE(engine.getChunkCount(), 3);
+        QTRY_COMPARE(engine.getPendingEmbeddingCount(), 0);
+        QCOMPARE(generatedSpy.count(), 3);
+
+        // Ingesting the unchanged file again adds nothing
+        QSignalSpy ingestedSpy(&engine, &RAGEngine::documentIngested);
+        QVERIFY(engine.ingestDocument(dir.filePath("policies.txt")));
+        QCOMPARE(ingestedSpy.count(), 1);
+        QCOMPARE(engine.getChunkCount(), 3);
+    }
 };
 
 QTEST_MAIN(TestRAGEngine)
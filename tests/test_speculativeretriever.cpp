@@ -0,0 +1,185 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include "../include/SpeculativeRetriever.h"
+#include "../include/RAGEngine.h"
+#include "../include/MockOllamaServer.h"
+
+class TestSpeculativeRetriever : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    // Engine with one small document embedded by the mock
+    bool ingest(RAGEngine &engine, MockOllamaServer &server) {
+        engine.setApiUrl(QString("http://127.0.0.1:%1/api/embeddings").arg(server.serverPort()));
+
+        QString path = m_dir.filePath("policy.txt");
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        file.write("Refunds are issued within 30 days of purchase.\n"
+                   "Shipping is free for orders over 50 euros.\n");
+        file.close();
+
+        if (!engine.ingestDocument(path)) {
+            return false;
+        }
+        return QTest::qWaitFor([&engine]() { return engine.getPendingEmbeddingCount() == 0; }, 5000);
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void testCloseMatch() {
+        QCOMPARE(SpeculativeRetriever::normalize("  What's the Refund   policy?"), QString("what s the refund policy"));
+
+        QVERIFY(SpeculativeRetriever::isCloseMatch("what is the refund policy", "What is the refund policy?"));
+        QVERIFY(SpeculativeRetriever::isCloseMatch("what is the refund policy", "what is the refund policy for"));
+        QVERIFY(!SpeculativeRetriever::isCloseMatch("what is the refund", "what is the refund policy for shoes"));
+        QVERIFY(!SpeculativeRetriever::isCloseMatch("refund policy", "shipping policy"));
+        QVERIFY(!SpeculativeRetriever::isCloseMatch("", "anything"));
+    }
+
+    void testFinishedSpeculationReused() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingest(engine, server));
+
+        SpeculativeRetriever retriever(&engine);
+        retriever.setDebounceInterval(10);
+        retriever.speculate("what is the refund policy", 3);
+        QTRY_VERIFY(retriever.hasSpeculation());
+        int requestsBeforeSend = server.requestCount();
+
+        // Delivered during retrieve() itself, without another embedding request
+        QSignalSpy readySpy(&retriever, &SpeculativeRetriever::contextReady);
+        retriever.retrieve("What is the refund policy?", 3);
+        QCOMPARE(readySpy.count(), 1);
+        QVERIFY(readySpy.first()[1].toBool());
+        QVERIFY(!readySpy.first()[0].toStringList().isEmpty());
+        QCOMPARE(server.requestCount(), requestsBeforeSend);
+        QCOMPARE(retriever.hits(), 1);
+        QVERIFY(!retriever.hasSpeculation());
+    }
+
+    void testPendingSpeculationJoined() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingest(engine, server));
+
+        MockOllamaOptions options;
+        options.embeddingDelayMs = 200;
+        server.setOptions(options);
+
+        SpeculativeRetriever retriever(&engine);
+        retriever.setDebounceInterval(10);
+        int requestsBefore = server.requestCount();
+        retriever.speculate("how much does shipping cost", 3);
+        QTRY_COMPARE(server.requestCount(), requestsBefore + 1);
+
+        // Sent while the speculation is still embedding: wait for it, don't start another
+        QSignalSpy readySpy(&retriever, &SpeculativeRetriever::contextReady);
+        retriever.retrieve("How much does shipping cost?", 3);
+        QVERIFY(readySpy.wait(5000));
+        QVERIFY(readySpy.first()[1].toBool());
+        QCOMPARE(server.requestCount(), requestsBefore + 1);
+    }
+
+    void testStaleSpeculationCancelled() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingest(engine, server));
+
+        MockOllamaOptions options;
+        options.embeddingDelayMs = 200;
+        server.setOptions(options);
+
+        SpeculativeRetriever retriever(&engine);
+        retriever.setDebounceInterval(10);
+        QSignalSpy engineReadySpy(&engine, &RAGEngine::contextReady);
+        int requestsBefore = server.requestCount();
+
+        retriever.speculate("how much does shipping cost", 3);
+        QTRY_COMPARE(server.requestCount(), requestsBefore + 1);
+        retriever.speculate("when are refunds issued", 3);
+        QTRY_VERIFY(retriever.hasSpeculation());
+
+        // Only the newer text was searched; the first embedding was aborted
+        QCOMPARE(retriever.speculatedQuery(), QString("when are refunds issued"));
+        QTest::qWait(300);
+        QCOMPARE(engineReadySpy.count(), 1);
+    }
+
+    void testMismatchRetrievesAgain() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingest(engine, server));
+
+        SpeculativeRetriever retriever(&engine);
+        retriever.setDebounceInterval(10);
+        retriever.speculate("how much does shipping cost", 3);
+        QTRY_VERIFY(retriever.hasSpeculation());
+        int requestsBeforeSend = server.requestCount();
+
+        QSignalSpy readySpy(&retriever, &SpeculativeRetriever::contextReady);
+        retriever.retrieve("when are refunds issued", 3);
+        QVERIFY(readySpy.wait(5000));
+        QVERIFY(!readySpy.first()[1].toBool());
+        QCOMPARE(server.requestCount(), requestsBeforeSend + 1);
+        QCOMPARE(retriever.misses(), 1);
+
+        // A different top K is a different retrieval too
+        retriever.speculate("how much does shipping cost", 3);
+        QTRY_VERIFY(retriever.hasSpeculation());
+        retriever.retrieve("how much does shipping cost", 5);
+        QVERIFY(readySpy.wait(5000));
+        QCOMPARE(retriever.misses(), 2);
+    }
+
+    void testInvalidateDropsSpeculation() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingest(engine, server));
+
+        SpeculativeRetriever retriever(&engine);
+        retriever.setDebounceInterval(10);
+        retriever.speculate("when are refunds issued", 3);
+        QTRY_VERIFY(retriever.hasSpeculation());
+
+        retriever.invalidate();
+        QVERIFY(!retriever.hasSpeculation());
+
+        QSignalSpy readySpy(&retriever, &SpeculativeRetriever::contextReady);
+        retriever.retrieve("when are refunds issued", 3);
+        QVERIFY(readySpy.wait(5000));
+        QVERIFY(!readySpy.first()[1].toBool());
+    }
+
+    void testShortTextNotSpeculated() {
+        MockOllamaServer server;
+        QVERIFY(server.listen());
+        RAGEngine engine;
+        QVERIFY(ingest(engine, server));
+
+        SpeculativeRetriever retriever(&engine);
+        retriever.setDebounceInterval(10);
+        int requestsBefore = server.requestCount();
+        retriever.speculate("hi", 3);
+        QTest::qWait(100);
+        QCOMPARE(server.requestCount(), requestsBefore);
+    }
+};
+
+QTEST_MAIN(TestSpeculativeRetriever)
+#include "test_speculativeretriever.moc"
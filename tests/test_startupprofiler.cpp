@@ -0,0 +1,139 @@
+#include <QtTest/QtTest>
+#include <QEvent>
+#include <QJsonArray>
+#include "../include/StartupProfiler.h"
+
+class TestStartupProfiler : public QObject {
+    Q_OBJECT
+
+private:
+    // Busy-wait so phase durations are measurably non-zero
+    void spin(int ms) {
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < ms) {
+        }
+    }
+
+    int findPhase(const QString &name) {
+        QList<StartupProfiler::Phase> phases = StartupProfiler::instance().phases();
+        for (int i = 0; i < phases.size(); ++i) {
+            if (phases[i].name == name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+private slots:
+    void initTestCase() {
+        // The profiler is a process-wide singleton; these tests run in order
+        StartupProfiler::instance().start();
+    }
+
+    void testNestedPhases() {
+        StartupProfiler &profiler = StartupProfiler::instance();
+
+        int outer = profiler.beginPhase("outer");
+        spin(2);
+        int inner = profiler.beginPhase("inner");
+        spin(5);
+        profiler.endPhase(inner);
+        profiler.endPhase(outer);
+
+        StartupProfiler::Phase outerPhase = profiler.phases().at(outer);
+        StartupProfiler::Phase innerPhase = profiler.phases().at(inner);
+
+        QCOMPARE(outerPhase.depth, 0);
+        QCOMPARE(innerPhase.depth, 1);
+        QVERIFY(innerPhase.startMs >= outerPhase.startMs);
+        QVERIFY(innerPhase.durationMs >= 5.0);
+        QVERIFY(outerPhase.durationMs >= innerPhase.durationMs);
+        QVERIFY(!outerPhase.deferred);
+    }
+
+    void testScopedPhase() {
+        {
+            StartupPhase phase("scoped");
+            spin(1);
+        }
+
+        int index = findPhase("scoped");
+        QVERIFY(index >= 0);
+        StartupProfiler::Phase phase = StartupProfiler::instance().phases().at(index);
+        QCOMPARE(phase.depth, 0);
+        QVERIFY(phase.durationMs >= 1.0);
+    }
+
+    void testInvalidEndIsIgnored() {
+        int count = StartupProfiler::instance().phases().size();
+        StartupProfiler::instance().endPhase(-1);
+        StartupProfiler::instance().endPhase(count + 10);
+        QCOMPARE(StartupProfiler::instance().phases().size(), count);
+    }
+
+    void testFinishOnFirstPaint() {
+        StartupProfiler &profiler = StartupProfiler::instance();
+        QVERIFY(!profiler.isFinished());
+
+        QObject window;
+        profiler.finishOnFirstPaint(&window);
+
+        // Interactive is only reached after the first paint
+        QEvent other(QEvent::Show);
+        QCoreApplication::sendEvent(&window, &other);
+        QCoreApplication::processEvents();
+        QVERIFY(!profiler.isFinished());
+
+        QEvent paint(QEvent::Paint);
+        QCoreApplication::sendEvent(&window, &paint);
+        QVERIFY(profiler.firstPaintMs() >= 0.0);
+        QTRY_VERIFY_WITH_TIMEOUT(profiler.isFinished(), 2000);
+
+        QVERIFY(profiler.timeToInteractiveMs() >= profiler.firstPaintMs());
+
+        QString report = profiler.report();
+        QVERIFY(report.contains("outer"));
+        QVERIFY(report.contains("First paint"));
+        QVERIFY(report.contains(QString("target %1 ms").arg(STARTUP_TARGET_MS)));
+    }
+
+    void testPhasesAfterFinishAreDeferred() {
+        StartupProfiler &profiler = StartupProfiler::instance();
+        QVERIFY(profiler.isFinished());
+        double interactiveMs = profiler.timeToInteractiveMs();
+
+        {
+            StartupPhase phase("late work");
+        }
+
+        int index = findPhase("late work");
+        QVERIFY(index >= 0);
+        QVERIFY(profiler.phases().at(index).deferred);
+
+        // A second finish does not move the milestone
+        profiler.finish("again");
+        QCOMPARE(profiler.timeToInteractiveMs(), interactiveMs);
+
+        // Deferred work is not part of the time-to-interactive table
+        QVERIFY(!profiler.report().contains("late work"));
+    }
+
+    void testJson() {
+        QJsonObject json = StartupProfiler::instance().toJson();
+
+        QCOMPARE(json["target_ms"].toInt(), STARTUP_TARGET_MS);
+        QCOMPARE(json["milestone"].toString(), QString("interactive"));
+        QVERIFY(json["interactive_ms"].toDouble() >= 0.0);
+
+        QJsonArray phases = json["phases"].toArray();
+        QCOMPARE(phases.size(), StartupProfiler::instance().phases().size());
+
+        QJsonObject last = phases.last().toObject();
+        QCOMPARE(last["name"].toString(), QString("late work"));
+        QVERIFY(last["deferred"].toBool());
+    }
+};
+
+QTEST_MAIN(TestStartupProfiler)
+#include "test_startupprofiler.moc"
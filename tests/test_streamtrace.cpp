@@ -0,0 +1,129 @@
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include "../include/StreamTrace.h"
+#include "../include/MockOllamaServer.h"
+#include "../include/LLMClient.h"
+#include "../include/Config.h"
+
+class TestStreamTrace : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+    QString m_tracePath;
+    QStringList m_recordedTokens;
+    QString m_recordedResponse;
+    QString m_apiUrl;
+
+    // Run one prompt through a fresh client; returns false on error/timeout
+    bool runPrompt(QStringList &tokens, QString &response, qint64 *ttftMs = nullptr) {
+        LLMClient client;
+        client.setApiUrl(m_apiUrl);
+        client.setMaxRetries(0);
+
+        QSignalSpy capabilitiesSpy(&client, &LLMClient::modelCapabilitiesDetected);
+        if (!capabilitiesSpy.wait(5000)) {
+            return false;
+        }
+
+        QElapsedTimer timer;
+        QObject::connect(&client, &LLMClient::tokenReceived, [&](const QString &token) {
+            if (tokens.isEmpty() && ttftMs) {
+                *ttftMs = timer.elapsed();
+            }
+            tokens.append(token);
+        });
+        QSignalSpy responseSpy(&client, &LLMClient::responseReceived);
+
+        timer.start();
+        client.sendPrompt("hello");
+        if (!responseSpy.wait(5000)) {
+            return false;
+        }
+        response = responseSpy.at(0).at(0).toString();
+        return true;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        Config::instance().resetToDefaults();
+        m_tracePath = m_dir.filePath("stream.trace.jsonl");
+    }
+
+    void cleanupTestCase() {
+        StreamTrace::instance().stop();
+    }
+
+    void testRecord() {
+        MockOllamaOptions options;
+        options.responseTokens = 30;
+        options.tokensPerChunk = 3;
+        options.firstTokenDelayMs = 150;
+        MockOllamaServer server(options);
+        QVERIFY(server.listen());
+        m_apiUrl = server.generateUrl();
+
+        QVERIFY(StreamTrace::instance().startRecording(m_tracePath));
+        QVERIFY(runPrompt(m_recordedTokens, m_recordedResponse));
+        StreamTrace::instance().stop();
+
+        QCOMPARE(m_recordedTokens.size(), 10);
+
+        // /api/show plus /api/generate
+        QList<StreamTraceExchange> exchanges;
+        QVERIFY(StreamTrace::loadTrace(m_tracePath, exchanges));
+        QCOMPARE(exchanges.size(), 2);
+        QCOMPARE(exchanges[0].path, QString("/api/show"));
+        QCOMPARE(exchanges[1].path, QString("/api/generate"));
+        QCOMPARE(exchanges[1].httpStatus, 200);
+        QVERIFY(!exchanges[1].chunks.isEmpty());
+        QVERIFY(exchanges[1].chunks.first().timeMs >= 100.0);
+    }
+
+    void testReplayFullSpeed() {
+        // The mock is gone; everything must come from the trace
+        QVERIFY(StreamTrace::instance().startReplay(m_tracePath, 0.0));
+
+        QStringList tokens;
+        QString response;
+        qint64 ttftMs = -1;
+        QVERIFY(runPrompt(tokens, response, &ttftMs));
+        QCOMPARE(tokens, m_recordedTokens);
+        QCOMPARE(response, m_recordedResponse);
+        QVERIFY(ttftMs < 100);
+        StreamTrace::instance().stop();
+    }
+
+    void testReplayRecordedTiming() {
+        QVERIFY(StreamTrace::instance().startReplay(m_tracePath, 1.0));
+
+        QStringList tokens;
+        QString response;
+        qint64 ttftMs = -1;
+        QVERIFY(runPrompt(tokens, response, &ttftMs));
+        QCOMPARE(tokens, m_recordedTokens);
+        QVERIFY(ttftMs >= 100);
+        StreamTrace::instance().stop();
+    }
+
+    void testUnrecordedRequestFails() {
+        QVERIFY(StreamTrace::instance().startReplay(m_tracePath, 0.0));
+
+        QNetworkAccessManager *manager = StreamTrace::instance().createNetworkManager(this);
+        QNetworkReply *reply = manager->get(QNetworkRequest(QUrl("http://127.0.0.1:1/api/tags")));
+        QSignalSpy finishedSpy(reply, &QNetworkReply::finished);
+        QVERIFY(finishedSpy.wait(5000));
+        QCOMPARE(reply->error(), QNetworkReply::ContentNotFoundError);
+
+        reply->deleteLater();
+        manager->deleteLater();
+        StreamTrace::instance().stop();
+    }
+};
+
+QTEST_MAIN(TestStreamTrace)
+#include "test_streamtrace.moc"
@@ -0,0 +1,170 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "../include/Tokenizer.h"
+
+class TestTokenizer : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    static QStringList vocabulary() {
+        return {"[PAD]", "[UNK]", "[CLS]", "[SEP]", "the", "quick", "brown", "fox", "un", "##aff", "##able",
+                "play", "##ing", "##the", "cafe", ".", ",", "!"};
+    }
+
+    // A tokenizer.json as HuggingFace writes it, trimmed to what Tokenizer reads
+    QString writeTokenizerJson(const QString &name, const QString &modelType, const QJsonObject &normalizer) {
+        QJsonObject vocab;
+        QStringList tokens = vocabulary();
+        for (int i = 0; i < tokens.size(); ++i) {
+            vocab[tokens[i]] = i;
+        }
+        QJsonObject model;
+        model["type"] = modelType;
+        model["unk_token"] = "[UNK]";
+        model["continuing_subword_prefix"] = "##";
+        model["max_input_chars_per_word"] = 20;
+        model["vocab"] = vocab;
+
+        QJsonObject root;
+        root["version"] = "1.0";
+        root["normalizer"] = normalizer;
+        root["pre_tokenizer"] = QJsonObject{{"type", "BertPreTokenizer"}};
+        root["model"] = model;
+
+        QString path = m_dir.filePath(name);
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return QString();
+        }
+        file.write(QJsonDocument(root).toJson());
+        return path;
+    }
+
+    static QJsonObject bertNormalizer(bool lowercase) {
+        QJsonObject normalizer;
+        normalizer["type"] = "BertNormalizer";
+        normalizer["clean_text"] = true;
+        normalizer["handle_chinese_chars"] = true;
+        normalizer["strip_accents"] = QJsonValue::Null;
+        normalizer["lowercase"] = lowercase;
+        return normalizer;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void testEstimate() {
+        Tokenizer tokenizer;
+        QVERIFY(!tokenizer.isExact());
+        QCOMPARE(tokenizer.name(), QString("estimate"));
+
+        // the(1) quick(2) brown(2) fox(1) .(1)
+        QCOMPARE(tokenizer.count("The quick brown fox."), 7);
+        QCOMPARE(tokenizer.count(""), 0);
+        QCOMPARE(tokenizer.count("   \n\t "), 0);
+
+        QVector<TokenSpan> words = tokenizer.words("The quick brown fox.");
+        QCOMPARE(words.size(), 5);
+        QCOMPARE(words[1].start, 4);
+        QCOMPARE(words[1].length, 5);
+        QCOMPARE(words[4].start, 19);
+        QCOMPARE(words[4].tokens, 1);
+    }
+
+    void testWordPiece() {
+        Tokenizer tokenizer;
+        QString error;
+        QVERIFY2(tokenizer.load(writeTokenizerJson("uncased.json", "WordPiece", bertNormalizer(true)), &error),
+                 qPrintable(error));
+        QVERIFY(tokenizer.isExact());
+        QVERIFY(tokenizer.name().endsWith("uncased.json"));
+
+        QCOMPARE(tokenizer.count("The quick brown fox."), 5);
+        QCOMPARE(tokenizer.count("Unaffable"), 3);    // un ##aff ##able
+        QCOMPARE(tokenizer.count("playing"), 2);      // play ##ing
+        QCOMPARE(tokenizer.count("fox,fox!"), 4);     // Punctuation splits words
+        QCOMPARE(tokenizer.count("xyz"), 1);          // [UNK]
+        QCOMPARE(tokenizer.count("playxyz"), 1);      // One unmatched piece makes the whole word [UNK]
+        QCOMPARE(tokenizer.count("Caf\xC3\xA9"), 1);               // Lowercased, accent stripped
+        QCOMPARE(tokenizer.count("\xE4\xB8\xAD\xE6\x96\x87"), 2);  // Each CJK ideograph is a word
+
+        // A zero-width space is dropped without splitting the word
+        QCOMPARE(tokenizer.count(QString("play") + QChar(0x200B) + "ing"), 2);
+
+        // Up to max_input_chars_per_word, then a single [UNK]
+        QCOMPARE(tokenizer.count("thethethethethethe"), 6);
+        QCOMPARE(tokenizer.count("thethethethethethethe"), 1);
+
+        tokenizer.clear();
+        QVERIFY(!tokenizer.isExact());
+        QCOMPARE(tokenizer.count("Unaffable"), 3);  // Estimated again: ceil(9 / 4)
+    }
+
+    void testCasedAndSequenceNormalizers() {
+        Tokenizer cased;
+        QVERIFY(cased.load(writeTokenizerJson("cased.json", "WordPiece", bertNormalizer(false))));
+        QCOMPARE(cased.count("unaffable"), 3);
+        QCOMPARE(cased.count("Unaffable"), 1);
+
+        QJsonObject sequence;
+        sequence["type"] = "Sequence";
+        sequence["normalizers"] = QJsonArray{QJsonObject{{"type", "NFD"}}, QJsonObject{{"type", "Lowercase"}},
+                                             QJsonObject{{"type", "StripAccents"}}};
+        Tokenizer uncased;
+        QVERIFY(uncased.load(writeTokenizerJson("sequence.json", "WordPiece", sequence)));
+        QCOMPARE(uncased.count("Unaffable Caf\xC3\xA9"), 4);
+    }
+
+    void testVocabTxt() {
+        QString path = m_dir.filePath("vocab.txt");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(vocabulary().join('\n').toUtf8() + "\n");
+        file.close();
+
+        Tokenizer tokenizer;
+        QVERIFY(tokenizer.load(path));
+        QVERIFY(tokenizer.isExact());
+        QCOMPARE(tokenizer.count("The UNAFFABLE fox"), 5);
+    }
+
+    void testRejectedFiles() {
+        Tokenizer tokenizer;
+        QString error;
+        QVERIFY(!tokenizer.load(writeTokenizerJson("bpe.json", "BPE", QJsonObject()), &error));
+        QVERIFY(error.contains("WordPiece"));
+        QVERIFY(!tokenizer.isExact());
+
+        // A failed load keeps the vocabulary already loaded
+        QVERIFY(tokenizer.load(writeTokenizerJson("good.json", "WordPiece", bertNormalizer(true))));
+        QVERIFY(!tokenizer.load(m_dir.filePath("missing.json"), &error));
+        QVERIFY(!error.isEmpty());
+        QVERIFY(tokenizer.isExact());
+        QVERIFY(tokenizer.name().endsWith("good.json"));
+
+        QString notJson = m_dir.filePath("broken.json");
+        QFile file(notJson);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("{\"model\": ");
+        file.close();
+        QVERIFY(!tokenizer.load(notJson, &error));
+        QVERIFY(error.contains("tokenizer.json"));
+    }
+
+    void testDefaultPath() {
+        QVERIFY(Tokenizer::defaultPath("nomic-embed-text:v1.5").endsWith("/.qtbot/tokenizers/nomic-embed-text.json"));
+        QVERIFY(Tokenizer::defaultPath("sentence-transformers/all-MiniLM-L6-v2")
+                    .endsWith("/.qtbot/tokenizers/sentence-transformers_all-MiniLM-L6-v2.json"));
+    }
+};
+
+QTEST_MAIN(TestTokenizer)
+#include "test_tokenizer.moc"
@@ -0,0 +1,188 @@
+#include <QtTest/QtTest>
+#include <cmath>
+#include <random>
+#include "../include/VectorIndex.h"
+
+class TestVectorIndex : public QObject {
+    Q_OBJECT
+
+private:
+    // Most of the variance sits in a few leading dimensions, as in real embeddings
+    static QVector<float> decayingVector(std::mt19937 &rng, int dimensions) {
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        QVector<float> v(dimensions);
+        for (int i = 0; i < dimensions; ++i) {
+            v[i] = dist(rng) * std::pow(0.85f, static_cast<float>(i));
+        }
+        return v;
+    }
+
+private slots:
+    void testCosineRanking() {
+        VectorIndex index;
+        QCOMPARE(index.add({1.0f, 0.0f, 0.0f}), 0);
+        QCOMPARE(index.add({10.0f, 10.0f, 0.0f}), 1);  // Length doesn't matter, direction does
+        QCOMPARE(index.add({0.0f, 0.0f, 3.0f}), 2);
+        QCOMPARE(index.add({0.0f, 0.0f, 0.0f}), 3);    // Stays zero instead of NaN
+        QCOMPARE(index.size(), 4);
+        QCOMPARE(index.dimensions(), 3);
+
+        QCOMPARE(index.search({2.0f, 1.0f, 0.0f}, 2), QVector<int>({1, 0}));
+        QCOMPARE(index.search({0.0f, 0.0f, 0.5f}, 1), QVector<int>({2}));
+        QCOMPARE(index.search({1.0f, 0.0f, 0.0f}, 10).size(), 4);
+
+        // The first vector fixes the width
+        QCOMPARE(index.add({1.0f, 2.0f}), -1);
+        QVERIFY(index.search({1.0f, 2.0f}, 1).isEmpty());
+        QCOMPARE(index.size(), 4);
+
+        index.clear();
+        QVERIFY(index.isEmpty());
+        QCOMPARE(index.add({1.0f, 2.0f}), 0);
+    }
+
+    void testDotKernel() {
+        QVector<float> a(101), b(101);
+        double expected = 0.0;
+        for (int i = 0; i < a.size(); ++i) {
+            a[i] = 0.01f * i;
+            b[i] = 1.0f - 0.02f * i;
+            expected += static_cast<double>(a[i]) * b[i];
+        }
+        QVERIFY(std::abs(VectorIndex::dot(a.constData(), b.constData(), a.size()) - expected) < 1e-3);
+        QCOMPARE(VectorIndex::dot(a.constData(), b.constData(), 0), 0.0f);
+    }
+
+    void testTruncation() {
+        VectorIndex index;
+        index.configure(VectorIndex::Truncate, 2);
+        index.add({3.0f, 4.0f, 100.0f, 0.0f});
+        index.add({0.0f, 1.0f, 0.0f, 100.0f});
+        QCOMPARE(index.inputDimensions(), 4);
+        QCOMPARE(index.dimensions(), 2);
+        QCOMPARE(index.memoryBytes(), qint64(2 * 2 * sizeof(float)));
+
+        // Only the leading dimensions are compared
+        QCOMPARE(index.search({1.0f, 1.5f, 0.0f, 50.0f}, 1), QVector<int>({0}));
+
+        // Not narrower than the input: kept whole
+        VectorIndex wide;
+        wide.configure(VectorIndex::Truncate, 8);
+        wide.add({1.0f, 2.0f, 3.0f});
+        QCOMPARE(wide.dimensions(), 3);
+    }
+
+    void testPcaProjection() {
+        const int dimensions = 64;
+        const int target = 16;
+        std::mt19937 rng(5);
+
+        VectorIndex full;
+        VectorIndex reduced;
+        reduced.configure(VectorIndex::PCA, target);
+
+        QVector<QVector<float>> corpus;
+        for (int i = 0; i < 400; ++i) {
+            corpus.append(decayingVector(rng, dimensions));
+            full.add(corpus.last());
+            reduced.add(corpus.last());
+        }
+
+        // Full width until trainingSize() vectors, or an explicit train()
+        QVERIFY(400 < VectorIndex::trainingSize());
+        QVERIFY(!reduced.isTrained());
+        QCOMPARE(reduced.dimensions(), dimensions);
+        reduced.train();
+        QVERIFY(reduced.isTrained());
+        QCOMPARE(reduced.dimensions(), target);
+        QVERIFY(reduced.memoryBytes() < full.memoryBytes());
+
+        // A corpus vector is still its own nearest neighbour, and later inserts are projected too
+        for (int i = 0; i < corpus.size(); i += 50) {
+            QCOMPARE(reduced.search(corpus[i], 1), QVector<int>({i}));
+        }
+        QVector<float> extra = decayingVector(rng, dimensions);
+        QCOMPARE(reduced.add(extra), corpus.size());
+        QCOMPARE(reduced.search(extra, 1), QVector<int>({corpus.size()}));
+
+        // Most of the exact top 10 survives a 4x reduction on data with this spectrum
+        std::normal_distribution<float> noise(0.0f, 0.1f);
+        int hits = 0;
+        for (int q = 0; q < 20; ++q) {
+            QVector<float> query = corpus[q * 17];
+            for (float &value : query) {
+                value += noise(rng);
+            }
+            QVector<int> exact = full.search(query, 10);
+            for (int position : reduced.search(query, 10)) {
+                hits += exact.contains(position) ? 1 : 0;
+            }
+        }
+        QVERIFY2(hits >= 160, qPrintable(QString("recall@10 %1").arg(hits / 200.0)));
+    }
+
+    void testSpill() {
+        const int dimensions = 32;
+        std::mt19937 rng(9);
+        VectorIndex index;
+        QVector<QVector<float>> corpus;
+        for (int i = 0; i < 100; ++i) {
+            corpus.append(decayingVector(rng, dimensions));
+            index.add(corpus.last());
+        }
+        QVector<int> before = index.search(corpus[42], 5);
+
+        // Same results from the mapped file; the heap copy is gone
+        QVERIFY(index.spill());
+        QCOMPARE(index.memoryBytes(), qint64(0));
+        QCOMPARE(index.mappedBytes(), qint64(100 * dimensions * sizeof(float)));
+        QCOMPARE(index.search(corpus[42], 5), before);
+
+        // Later vectors go to the heap and are searched after the mapped ones
+        for (int i = 0; i < 20; ++i) {
+            corpus.append(decayingVector(rng, dimensions));
+            index.add(corpus.last());
+        }
+        QCOMPARE(index.search(corpus[110], 1), QVector<int>({110}));
+        QCOMPARE(index.search(corpus[7], 1), QVector<int>({7}));
+
+        // A second spill appends them to the file
+        QVERIFY(index.spill());
+        QCOMPARE(index.mappedBytes(), qint64(120 * dimensions * sizeof(float)));
+        QCOMPARE(index.search(corpus[110], 1), QVector<int>({110}));
+
+        index.clear();
+        QCOMPARE(index.mappedBytes(), qint64(0));
+        QVERIFY(index.search(corpus[0], 1).isEmpty());
+    }
+
+    void testPcaTrainsFromSpilledVectors() {
+        const int dimensions = 64;
+        std::mt19937 rng(11);
+        VectorIndex index;
+        index.configure(VectorIndex::PCA, 16);
+        QVector<QVector<float>> corpus;
+        for (int i = 0; i < 300; ++i) {
+            corpus.append(decayingVector(rng, dimensions));
+            index.add(corpus.last());
+        }
+        QVERIFY(index.spill());
+
+        // Training reads the mapped rows and brings the projected ones back to the heap
+        index.train();
+        QVERIFY(index.isTrained());
+        QCOMPARE(index.mappedBytes(), qint64(0));
+        QCOMPARE(index.size(), corpus.size());
+        QCOMPARE(index.search(corpus[123], 1), QVector<int>({123}));
+    }
+
+    void testReductionNames() {
+        QCOMPARE(VectorIndex::reductionFromString("truncate"), VectorIndex::Truncate);
+        QCOMPARE(VectorIndex::reductionFromString(" PCA "), VectorIndex::PCA);
+        QCOMPARE(VectorIndex::reductionFromString("umap"), VectorIndex::NoReduction);
+        QCOMPARE(VectorIndex::reductionName(VectorIndex::PCA), QString("pca"));
+    }
+};
+
+QTEST_MAIN(TestVectorIndex)
+#include "test_vectorindex.moc"